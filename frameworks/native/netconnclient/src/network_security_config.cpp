@@ -15,16 +15,23 @@
 
 #include "network_security_config.h"
 
+#include <sys/file.h>
 #include <sys/stat.h>
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dlfcn.h>
-#include <regex>
+#include <mutex>
+#include <shared_mutex>
 #include <sstream>
+#include <unordered_map>
 #include <securec.h>
 
 #include "cJSON.h"
+#include "domain_label_trie.h"
 #include "openssl/evp.h"
 #include "openssl/ssl.h"
 #include "net_mgr_log_wrapper.h"
@@ -54,6 +61,10 @@ const std::vector<std::string> SUPPORTED_COMPONENTS({"Network Kit", "Request", "
                                                      "Media Kit", "ArkWeb"});
 
 const std::string REHASHD_CA_CERTS_DIR("/data/storage/el2/base/files/rehashed_ca_certs");
+const std::string CA_INDEX_FILE_NAME(".ca_index");
+const std::string CA_LOCK_FILE_NAME(".lock");
+const std::string CA_INDEX_VERSION("ca-index-v1");
+const std::string CA_INDEX_NOT_A_CERT("-");
 #ifdef WINDOWS_PLATFORM
 const char OS_PATH_SEPARATOR = '\\';
 #else
@@ -68,7 +79,227 @@ const std::string LIB_LOAD_PATH = "/system/lib/platformsdk/libnet_bundle_utils.z
 
 using GetNetBundleClass = INetBundle *(*)();
 
-NetworkSecurityConfig::NetworkSecurityConfig()
+constexpr int32_t NO_DOMAIN_CONFIG = -1;
+constexpr size_t MAX_HOST_CONFIG_MEMO_SIZE = 512;
+constexpr char DOMAIN_WILDCARD = '*';
+const std::string SUB_DOMAIN_WILDCARD_PREFIX("*.");
+
+// First domain-config naming the domain of a trie slot
+struct DomainConfigSlot {
+    int32_t config_ = INT32_MAX;
+};
+
+/* The trie folds case and drops a trailing dot, so it only holds names it keeps as they are */
+static bool IsTrieDomainName(const std::string &name)
+{
+    if (name.empty() || name.front() == '.' || name.back() == '.' || name.find("..") != std::string::npos ||
+        name.find(DOMAIN_WILDCARD) != std::string::npos) {
+        return false;
+    }
+    return std::none_of(name.begin(), name.end(), [](unsigned char c) { return std::isupper(c); });
+}
+
+struct NetworkSecurityConfig::DomainIndex {
+    std::shared_mutex mutex_;
+    // bumped whenever domainConfigs_ changes, the trie is rebuilt when it was built for an older generation
+    uint64_t configGeneration_ = 0;
+    uint64_t trieGeneration_ = 0;
+    std::unique_ptr<DomainLabelTrie<DomainConfigSlot>> trie_;
+    // domain-config index and name of the names the trie can not hold, matched as patterns in configuration order
+    std::vector<std::pair<int32_t, std::string>> wildcardDomains_;
+    std::unordered_map<std::string, int32_t> hostConfigMemo_;
+};
+
+/* What a rehashed dir was built from: the CA dir and every CA file in it, named by the hash of its subject */
+struct CAIndexEntry {
+    std::string hashName;
+    std::string fileName;
+    uint64_t ino = 0;
+    int64_t size = 0;
+    int64_t mtimeNs = 0;
+};
+
+struct CAIndex {
+    uint64_t dev = 0;
+    uint64_t ino = 0;
+    int64_t mtimeNs = 0;
+    std::vector<CAIndexEntry> entries;
+};
+
+static int64_t GetMtimeNs(const struct stat &st)
+{
+    constexpr int64_t NS_PER_SEC = 1000000000;
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * NS_PER_SEC + st.st_mtim.tv_nsec;
+}
+
+static std::string JoinPath(const std::string &dir, const std::string &name)
+{
+    return (!dir.empty() && dir.back() == OS_PATH_SEPARATOR) ? dir + name : dir + OS_PATH_SEPARATOR + name;
+}
+
+static bool ReadCAIndex(const std::string &rehashedCertpath, CAIndex &index)
+{
+    std::ifstream file(JoinPath(rehashedCertpath, CA_INDEX_FILE_NAME));
+    std::string version;
+    size_t count = 0;
+    if (!file.is_open() || !(file >> version >> index.dev >> index.ino >> index.mtimeNs >> count) ||
+        version != CA_INDEX_VERSION) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        CAIndexEntry entry;
+        // The file name comes last, after one space, it may contain spaces itself
+        if (!(file >> entry.hashName >> entry.ino >> entry.size >> entry.mtimeNs) || file.get() != ' ' ||
+            !std::getline(file, entry.fileName) || entry.fileName.empty()) {
+            return false;
+        }
+        index.entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+static bool WriteCAIndex(const std::string &rehashedCertpath, const CAIndex &index)
+{
+    auto indexFile = JoinPath(rehashedCertpath, CA_INDEX_FILE_NAME);
+    auto tmpFile = indexFile + "." + std::to_string(getpid());
+    {
+        std::ofstream file(tmpFile, std::ios::trunc);
+        file << CA_INDEX_VERSION << ' ' << index.dev << ' ' << index.ino << ' ' << index.mtimeNs << ' '
+             << index.entries.size() << '\n';
+        for (const auto &entry : index.entries) {
+            file << entry.hashName << ' ' << entry.ino << ' ' << entry.size << ' ' << entry.mtimeNs << ' '
+                 << entry.fileName << '\n';
+        }
+        if (!file.good()) {
+            file.close();
+            unlink(tmpFile.c_str());
+            return false;
+        }
+    }
+    // Other processes of the app read the index, they see the old one or the new one
+    if (rename(tmpFile.c_str(), indexFile.c_str()) != 0) {
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool IsCAIndexUpToDate(const std::string &caPath, const struct stat &caDirStat, const CAIndex &index)
+{
+    // Adding, removing or renaming a CA file changes the mtime of the dir, replacing the dir its inode
+    if (index.dev != static_cast<uint64_t>(caDirStat.st_dev) || index.ino != static_cast<uint64_t>(caDirStat.st_ino) ||
+        index.mtimeNs != GetMtimeNs(caDirStat)) {
+        return false;
+    }
+    // A CA file rewritten in place only shows on the file
+    for (const auto &entry : index.entries) {
+        struct stat st = {};
+        if (stat(JoinPath(caPath, entry.fileName).c_str(), &st) != 0 || entry.ino != static_cast<uint64_t>(st.st_ino) ||
+            entry.size != static_cast<int64_t>(st.st_size) || entry.mtimeNs != GetMtimeNs(st)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static X509 *ParseCert(const std::string &certData)
+{
+    BIO *bio = BIO_new_mem_buf(certData.c_str(), -1);
+    // LCOV_EXCL_START
+    if (bio == nullptr) {
+        NETMGR_LOG_E("Fail to call BIO_new_mem_buf");
+        return nullptr;
+    }
+
+    X509 *x509 = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr);
+    if (x509 == nullptr) {
+        NETMGR_LOG_E("Fail to call PEM_read_bio_X509.");
+    }
+    // LCOV_EXCL_STOP
+
+    BIO_free(bio);
+    return x509;
+}
+
+static bool WriteFileAtomically(const std::string &fileName, const std::string &content)
+{
+    auto tmpFile = fileName + "." + std::to_string(getpid());
+    {
+        std::ofstream file(tmpFile, std::ios::binary | std::ios::trunc);
+        file << content;
+        if (!file.good()) {
+            file.close();
+            unlink(tmpFile.c_str());
+            return false;
+        }
+    }
+    if (rename(tmpFile.c_str(), fileName.c_str()) != 0) {
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+/* Held while a rehashed dir is rebuilt, the processes of the app sharing the dir rebuild it one after another */
+class RehashedDirLock {
+public:
+    explicit RehashedDirLock(const std::string &rehashedCertpath)
+    {
+        fd_ = open(JoinPath(rehashedCertpath, CA_LOCK_FILE_NAME).c_str(), O_RDWR | O_CREAT | O_CLOEXEC,
+                   S_IRUSR | S_IWUSR);
+        if (fd_ < 0 || TEMP_FAILURE_RETRY(flock(fd_, LOCK_EX)) != 0) {
+            NETMGR_LOG_W("Rebuild [%{public}s] unlocked. [%{public}d]", rehashedCertpath.c_str(), errno);
+        }
+    }
+
+    ~RehashedDirLock()
+    {
+        // Closing the file drops the lock
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    RehashedDirLock(const RehashedDirLock &) = delete;
+    RehashedDirLock &operator=(const RehashedDirLock &) = delete;
+
+private:
+    int fd_ = -1;
+};
+
+/* A copy of a CA file is named by the subject hash and a suffix, as OpenSSL looks it up */
+static bool IsRehashedCertName(const std::string &name)
+{
+    constexpr size_t HASH_LEN = 8;
+    if (name.size() <= HASH_LEN + 1 || name[HASH_LEN] != '.') {
+        return false;
+    }
+    auto isHex = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+    auto isDigit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+    return std::all_of(name.begin(), name.begin() + HASH_LEN, isHex) &&
+           std::all_of(name.begin() + HASH_LEN + 1, name.end(), isDigit);
+}
+
+/* Remove the copies of CA files that left the CA dir, the index, the lock and temporary files are not copies */
+static void RemoveStaleRehashedFiles(const std::string &rehashedCertpath, const std::set<std::string> &hashNames)
+{
+    DIR *dir = opendir(rehashedCertpath.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (!IsRehashedCertName(name) || hashNames.count(name) != 0) {
+            continue;
+        }
+        if (unlinkat(dirfd(dir), entry->d_name, 0) == 0) {
+            NETMGR_LOG_D("Stale rehashed cert removed. [%{public}s]", entry->d_name);
+        }
+    }
+    closedir(dir);
+}
+
+NetworkSecurityConfig::NetworkSecurityConfig() : domainIndex_(std::make_unique<DomainIndex>())
 {
     if (GetConfig() != NETMANAGER_SUCCESS) {
         NETMGR_LOG_I("GetConfig failed");
@@ -150,23 +381,7 @@ X509 *NetworkSecurityConfig::ReadCertFile(const std::string &fileName)
 
     std::stringstream certStream;
     certStream << certFile.rdbuf();
-
-    const std::string &certData = certStream.str();
-    BIO *bio = BIO_new_mem_buf(certData.c_str(), -1);
-    // LCOV_EXCL_START
-    if (bio == nullptr) {
-        NETMGR_LOG_E("Fail to call BIO_new_mem_buf");
-        return nullptr;
-    }
-
-    X509 *x509 = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr);
-    if (x509 == nullptr) {
-        NETMGR_LOG_E("Fail to call PEM_read_bio_X509.");
-    }
-    // LCOV_EXCL_STOP
-
-    BIO_free(bio);
-    return x509;
+    return ParseCert(certStream.str());
 }
 
 std::string NetworkSecurityConfig::GetRehashedCADirName(const std::string &caPath)
@@ -244,9 +459,24 @@ std::string NetworkSecurityConfig::GetRehasedCAPath(const std::string &caPath)
 
 std::string NetworkSecurityConfig::ReHashCAPathForX509(const std::string &caPath)
 {
-    std::set<std::string> allFiles;
-    std::vector<std::string> caFiles;
+    // Taken first, a CA file added while the certs are rehashed makes the index outdated
+    struct stat caDirStat = {};
+    if (stat(caPath.c_str(), &caDirStat) != 0) {
+        NETMGR_LOG_E("open CA path[%{public}s] fail. [%{public}d]", caPath.c_str(), errno);
+        return "";
+    }
+
+    // LCOV_EXCL_START
+    auto rehashedCertpath = GetRehasedCAPath(caPath);
+    CAIndex index;
+    if (!rehashedCertpath.empty() && ReadCAIndex(rehashedCertpath, index) &&
+        IsCAIndexUpToDate(caPath, caDirStat, index)) {
+        NETMGR_LOG_D("Rehashed CA certs of [%{public}s] are up to date", caPath.c_str());
+        return index.entries.empty() ? "" : rehashedCertpath;
+    }
+    // LCOV_EXCL_STOP
 
+    std::vector<std::string> caFiles;
     GetCAFilesFromPath(caPath, caFiles);
     // LCOV_EXCL_START
     if (caFiles.empty()) {
@@ -254,20 +484,46 @@ std::string NetworkSecurityConfig::ReHashCAPathForX509(const std::string &caPath
         return "";
     }
 
-    auto rehashedCertpath = BuildRehasedCAPath(caPath);
+    rehashedCertpath = BuildRehasedCAPath(caPath);
     if (rehashedCertpath.empty()) {
         return rehashedCertpath;
     }
+    RehashedDirLock rehashLock(rehashedCertpath);
+    // Another process of the app may have rebuilt the dir while this one waited for the lock
+    CAIndex current;
+    if (ReadCAIndex(rehashedCertpath, current) && IsCAIndexUpToDate(caPath, caDirStat, current)) {
+        return current.entries.empty() ? "" : rehashedCertpath;
+    }
 
+    // Sorted, so that certs with the same subject get the same suffixes in every process
+    std::sort(caFiles.begin(), caFiles.end());
+    index = {static_cast<uint64_t>(caDirStat.st_dev), static_cast<uint64_t>(caDirStat.st_ino),
+             GetMtimeNs(caDirStat), {}};
+    std::set<std::string> allFiles;
     for (auto &caFile : caFiles) {
-        auto x509 = ReadCertFile(caFile);
+        struct stat caFileStat = {};
+        std::ifstream src(caFile, std::ios::binary);
+        if (stat(caFile.c_str(), &caFileStat) != 0 || !src.is_open()) {
+            NETMGR_LOG_E("fail to open cert file.");
+            continue;
+        }
+        std::stringstream certStream;
+        certStream << src.rdbuf();
+        const std::string certData = certStream.str();
+
+        CAIndexEntry entry = {CA_INDEX_NOT_A_CERT, caFile.substr(caFile.rfind(OS_PATH_SEPARATOR) + 1),
+                              static_cast<uint64_t>(caFileStat.st_ino), static_cast<int64_t>(caFileStat.st_size),
+                              GetMtimeNs(caFileStat)};
+        auto x509 = ParseCert(certData);
         if (x509 == nullptr) {
+            index.entries.push_back(std::move(entry));
             continue;
         }
 
         constexpr int X509_HASH_LEN = 16;
         char buf[X509_HASH_LEN] = {0};
         if (sprintf_s(buf, sizeof(buf), "%08lx", X509_subject_name_hash(x509)) < 0) {
+            X509_free(x509);
             return "";
         }
         X509_free(x509);
@@ -276,21 +532,21 @@ std::string NetworkSecurityConfig::ReHashCAPathForX509(const std::string &caPath
         std::string hashName(buf);
         AddSurfixToCACertFileName(rehashedCertpath, allFiles, hashName);
 
+        // Written again even if it exists, the CA file may have changed
         std::string rehashedCaFile = rehashedCertpath + OS_PATH_SEPARATOR + hashName;
-        if (access(rehashedCaFile.c_str(), F_OK) == 0) {
-            NETMGR_LOG_D("File [%{public}s] exists.", rehashedCaFile.c_str());
-            continue;
-        }
-
-        std::ifstream src(caFile);
-        std::ofstream dst(rehashedCaFile);
-        if (!src.is_open() || !dst.is_open()) {
-            NETMGR_LOG_E("fail to open cert file.");
+        if (!WriteFileAtomically(rehashedCaFile, certData)) {
+            NETMGR_LOG_E("fail to write cert file.");
+            allFiles.erase(hashName);
             continue;
         }
-        dst << src.rdbuf();
+        entry.hashName = hashName;
+        index.entries.push_back(std::move(entry));
         NETMGR_LOG_D("Rehased cert generated. [%{public}s]", rehashedCaFile.c_str());
     }
+    RemoveStaleRehashedFiles(rehashedCertpath, allFiles);
+    if (!WriteCAIndex(rehashedCertpath, index)) {
+        NETMGR_LOG_E("fail to write the index of [%{public}s]", rehashedCertpath.c_str());
+    }
     // LCOV_EXCL_STOP
 
     return rehashedCertpath;
@@ -299,12 +555,18 @@ std::string NetworkSecurityConfig::ReHashCAPathForX509(const std::string &caPath
 int32_t NetworkSecurityConfig::CreateRehashedCertFiles()
 {
     // LCOV_EXCL_START
+    // Domain configs often share the trust anchors of the base config
+    std::set<std::string> rehashedPaths;
     for (auto &cert : baseConfig_.trustAnchors_.certs_) {
-        ReHashCAPathForX509(cert);
+        if (rehashedPaths.insert(cert).second) {
+            ReHashCAPathForX509(cert);
+        }
     }
     for (auto &domainConfig : domainConfigs_) {
         for (auto &cert : domainConfig.trustAnchors_.certs_) {
-            ReHashCAPathForX509(cert);
+            if (rehashedPaths.insert(cert).second) {
+                ReHashCAPathForX509(cert);
+            }
         }
     }
     // LCOV_EXCL_STOP
@@ -348,6 +610,7 @@ int32_t NetworkSecurityConfig::GetConfig()
     if (ret != NETMANAGER_SUCCESS) {
         return ret;
     }
+    OnDomainConfigsChanged();
 
     ret = CreateRehashedCertFiles();
     if (ret != NETMANAGER_SUCCESS) {
@@ -602,29 +865,124 @@ int32_t NetworkSecurityConfig::ParseJsonConfig(const std::string &content)
 }
 // LCOV_EXCL_STOP
 
-bool NetworkSecurityConfig::IsPinOpenMode(const std::string &hostname)
+void NetworkSecurityConfig::OnDomainConfigsChanged()
 {
-    if (hostname.empty()) {
-        return false;
+    std::unique_lock<std::shared_mutex> lock(domainIndex_->mutex_);
+    ++domainIndex_->configGeneration_;
+    BuildDomainIndex();
+}
+
+void NetworkSecurityConfig::BuildDomainIndex()
+{
+    DomainIndex &index = *domainIndex_;
+    index.trie_ = std::make_unique<DomainLabelTrie<DomainConfigSlot>>();
+    index.wildcardDomains_.clear();
+    index.hostConfigMemo_.clear();
+    for (size_t i = 0; i < domainConfigs_.size(); ++i) {
+        int32_t configIndex = static_cast<int32_t>(i);
+        for (const auto &domain : domainConfigs_[i].domains_) {
+            const std::string &name = domain.domainName_;
+            // any other name can only equal a host name that takes the linear path
+            DomainConfigSlot *slot = IsTrieDomainName(name) ? index.trie_->Emplace(name, false) : nullptr;
+            if (slot != nullptr) {
+                slot->config_ = std::min(slot->config_, configIndex);
+            }
+            // without a wildcard UrlRegexParse is a plain comparison, the exact slot covers it
+            if (!domain.includeSubDomains_ || name.find(DOMAIN_WILDCARD) == std::string::npos ||
+                !CommonUtils::IsUrlRegexValid(name)) {
+                continue;
+            }
+            size_t prefixLen = SUB_DOMAIN_WILDCARD_PREFIX.size();
+            bool isSubDomainWildcard = name.size() == 1 || (name.size() > prefixLen &&
+                name.compare(0, prefixLen, SUB_DOMAIN_WILDCARD_PREFIX) == 0 &&
+                IsTrieDomainName(name.substr(prefixLen)));
+            slot = isSubDomainWildcard ? index.trie_->Emplace(name, true) : nullptr;
+            if (slot != nullptr) {
+                slot->config_ = std::min(slot->config_, configIndex);
+            } else {
+                index.wildcardDomains_.emplace_back(configIndex, name);
+            }
+        }
     }
+    index.trieGeneration_ = index.configGeneration_;
+}
 
-    PinSet *pPinSet = nullptr;
-    for (auto &domainConfig : domainConfigs_) {
-        for (const auto &domain : domainConfig.domains_) {
-            if (hostname == domain.domainName_) {
-                pPinSet = &domainConfig.pinSet_;
-                break;
-            // LCOV_EXCL_START
-            } else if (domain.includeSubDomains_ && CommonUtils::UrlRegexParse(hostname, domain.domainName_)) {
-                pPinSet = &domainConfig.pinSet_;
-                break;
+int32_t NetworkSecurityConfig::MatchDomainIndex(const std::string &hostname)
+{
+    int32_t best = INT32_MAX;
+    if (!IsTrieDomainName(hostname)) {
+        for (size_t i = 0; i < domainConfigs_.size() && best == INT32_MAX; ++i) {
+            for (const auto &domain : domainConfigs_[i].domains_) {
+                if (hostname == domain.domainName_ ||
+                    (domain.includeSubDomains_ && CommonUtils::UrlRegexParse(hostname, domain.domainName_))) {
+                    best = static_cast<int32_t>(i);
+                    break;
+                }
             }
-            // LCOV_EXCL_STOP
         }
-        if (pPinSet != nullptr) {
+        return best == INT32_MAX ? NO_DOMAIN_CONFIG : best;
+    }
+    domainIndex_->trie_->Match(hostname, [&best](const DomainConfigSlot &slot, bool) {
+        best = std::min(best, slot.config_);
+    });
+    for (const auto &[configIndex, name] : domainIndex_->wildcardDomains_) {
+        if (configIndex >= best) {
+            break;
+        }
+        if (CommonUtils::UrlRegexParse(hostname, name)) {
+            best = configIndex;
             break;
         }
     }
+    return best == INT32_MAX ? NO_DOMAIN_CONFIG : best;
+}
+
+/* The matched config is copied out while the index lock is held, the domain names are left out */
+static void CopyDomainConfig(const std::vector<DomainConfig> &domainConfigs, int32_t index, DomainConfig *domainConfig)
+{
+    if (domainConfig == nullptr || index == NO_DOMAIN_CONFIG) {
+        return;
+    }
+    const DomainConfig &matched = domainConfigs[index];
+    domainConfig->cleartextTrafficPermitted_ = matched.cleartextTrafficPermitted_;
+    domainConfig->trustAnchors_ = matched.trustAnchors_;
+    domainConfig->pinSet_ = matched.pinSet_;
+}
+
+int32_t NetworkSecurityConfig::FindDomainConfigIndex(const std::string &hostname, DomainConfig *domainConfig)
+{
+    DomainIndex &index = *domainIndex_;
+    {
+        std::shared_lock<std::shared_mutex> lock(index.mutex_);
+        auto it = index.hostConfigMemo_.find(hostname);
+        if (index.trie_ != nullptr && index.trieGeneration_ == index.configGeneration_ &&
+            it != index.hostConfigMemo_.end()) {
+            CopyDomainConfig(domainConfigs_, it->second, domainConfig);
+            return it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(index.mutex_);
+    if (index.trie_ == nullptr || index.trieGeneration_ != index.configGeneration_) {
+        BuildDomainIndex();
+    }
+    int32_t configIndex = MatchDomainIndex(hostname);
+    if (index.hostConfigMemo_.size() >= MAX_HOST_CONFIG_MEMO_SIZE) {
+        index.hostConfigMemo_.clear();
+    }
+    index.hostConfigMemo_[hostname] = configIndex;
+    CopyDomainConfig(domainConfigs_, configIndex, domainConfig);
+    return configIndex;
+}
+
+bool NetworkSecurityConfig::IsPinOpenMode(const std::string &hostname)
+{
+    if (hostname.empty()) {
+        return false;
+    }
+
+    DomainConfig domainConfig;
+    int32_t index = FindDomainConfigIndex(hostname, &domainConfig);
+    PinSet *pPinSet = index == NO_DOMAIN_CONFIG ? nullptr : &domainConfig.pinSet_;
 
     if (pPinSet == nullptr) {
         return false;
@@ -639,23 +997,9 @@ bool NetworkSecurityConfig::IsPinOpenModeVerifyRootCa(const std::string &hostnam
         return false;
     }
 
-    PinSet *pPinSet = nullptr;
-    for (auto &domainConfig : domainConfigs_) {
-        for (const auto &domain : domainConfig.domains_) {
-            if (hostname == domain.domainName_) {
-                pPinSet = &domainConfig.pinSet_;
-                break;
-            // LCOV_EXCL_START
-            } else if (domain.includeSubDomains_ && CommonUtils::UrlRegexParse(hostname, domain.domainName_)) {
-                pPinSet = &domainConfig.pinSet_;
-                break;
-            }
-            // LCOV_EXCL_STOP
-        }
-        if (pPinSet != nullptr) {
-            break;
-        }
-    }
+    DomainConfig domainConfig;
+    int32_t index = FindDomainConfigIndex(hostname, &domainConfig);
+    PinSet *pPinSet = index == NO_DOMAIN_CONFIG ? nullptr : &domainConfig.pinSet_;
 
     if (pPinSet == nullptr) {
         NETMGR_LOG_E("pinset not configured for this hostname.");
@@ -675,23 +1019,9 @@ int32_t NetworkSecurityConfig::GetPinSetForHostName(const std::string &hostname,
         return NETMANAGER_SUCCESS;
     }
 
-    PinSet *pPinSet = nullptr;
-    for (auto &domainConfig : domainConfigs_) {
-        for (const auto &domain : domainConfig.domains_) {
-            if (hostname == domain.domainName_) {
-                pPinSet = &domainConfig.pinSet_;
-                break;
-            // LCOV_EXCL_START
-            } else if (domain.includeSubDomains_ && CommonUtils::UrlRegexParse(hostname, domain.domainName_)) {
-                pPinSet = &domainConfig.pinSet_;
-                break;
-            }
-            // LCOV_EXCL_STOP
-        }
-        if (pPinSet != nullptr) {
-            break;
-        }
-    }
+    DomainConfig domainConfig;
+    int32_t index = FindDomainConfigIndex(hostname, &domainConfig);
+    PinSet *pPinSet = index == NO_DOMAIN_CONFIG ? nullptr : &domainConfig.pinSet_;
 
     if (pPinSet == nullptr) {
         NETMGR_LOG_D("No pinned pubkey configured.");
@@ -723,23 +1053,9 @@ int32_t NetworkSecurityConfig::GetTrustAnchorsForHostName(const std::string &hos
         return NETMANAGER_SUCCESS;
     }
 
-    TrustAnchors *pTrustAnchors = nullptr;
-    for (auto &domainConfig: domainConfigs_) {
-        // LCOV_EXCL_START
-        for (auto &domain: domainConfig.domains_) {
-            if (hostname == domain.domainName_) {
-                pTrustAnchors = &domainConfig.trustAnchors_;
-                break;
-            } else if (domain.includeSubDomains_ && CommonUtils::UrlRegexParse(hostname, domain.domainName_)) {
-                pTrustAnchors = &domainConfig.trustAnchors_;
-                break;
-            }
-        }
-        if (pTrustAnchors != nullptr) {
-            break;
-        }
-        // LCOV_EXCL_STOP
-    }
+    DomainConfig domainConfig;
+    int32_t index = FindDomainConfigIndex(hostname, &domainConfig);
+    TrustAnchors *pTrustAnchors = index == NO_DOMAIN_CONFIG ? nullptr : &domainConfig.trustAnchors_;
 
     if (pTrustAnchors == nullptr) {
         pTrustAnchors = &baseConfig_.trustAnchors_;
@@ -828,23 +1144,10 @@ int32_t NetworkSecurityConfig::IsCleartextPermitted(const std::string &hostname,
         return NETMANAGER_SUCCESS;
     }
 
-    const bool *pCtTrafficPermitted = nullptr;
-    for (const auto &domainConfig : domainConfigs_) {
-        for (const auto &domain : domainConfig.domains_) {
-            if (hostname == domain.domainName_) {
-                pCtTrafficPermitted = &domainConfig.cleartextTrafficPermitted_;
-                break;
-            // LCOV_EXCL_START
-            } else if (domain.includeSubDomains_ && CommonUtils::UrlRegexParse(hostname, domain.domainName_)) {
-                pCtTrafficPermitted = &domainConfig.cleartextTrafficPermitted_;
-                break;
-            }
-            // LCOV_EXCL_STOP
-        }
-        if (pCtTrafficPermitted != nullptr) {
-            break;
-        }
-    }
+    DomainConfig domainConfig;
+    int32_t index = FindDomainConfigIndex(hostname, &domainConfig);
+    const bool *pCtTrafficPermitted =
+        index == NO_DOMAIN_CONFIG ? nullptr : &domainConfig.cleartextTrafficPermitted_;
     cleartextPermitted = pCtTrafficPermitted == nullptr ? baseCleartextPermitted : *pCtTrafficPermitted;
     return NETMANAGER_SUCCESS;
 }
@@ -28,6 +28,7 @@ bool StatsInfoUnmarshallingVector(Parcel &parcel, std::vector<NetStatsInfo> &sta
 
 namespace NetsysNative {
 static constexpr uint32_t UIDS_LIST_MAX_SIZE = 1024;
+static constexpr uint32_t UID_LISTS_MAX_SIZE = 16384;
 static constexpr int32_t MAX_DNS_CONFIG_SIZE = 7;
 static constexpr int32_t MAX_INTERFACE_CONFIG_SIZE = 16;
 static constexpr int32_t MAX_INTERFACE_SIZE = 65535;
@@ -1710,6 +1711,40 @@ int32_t NetsysNativeServiceProxy::BandwidthRemoveAllowedList(uint32_t uid)
     return ret;
 }
 
+int32_t NetsysNativeServiceProxy::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                          const std::vector<uint32_t> &allowedUids,
+                                                          const std::vector<uint32_t> &removedUids)
+{
+    if (deniedUids.size() + allowedUids.size() + removedUids.size() > UID_LISTS_MAX_SIZE) {
+        NETNATIVE_LOGE("Uid lists size err");
+        return ERR_INVALID_DATA;
+    }
+    MessageParcel data;
+    if (!WriteInterfaceToken(data)) {
+        NETNATIVE_LOGE("WriteInterfaceToken failed");
+        return ERR_FLATTEN_OBJECT;
+    }
+    if (!data.WriteUInt32Vector(deniedUids) || !data.WriteUInt32Vector(allowedUids) ||
+        !data.WriteUInt32Vector(removedUids)) {
+        NETNATIVE_LOGE("WriteUInt32Vector failed");
+        return ERR_FLATTEN_OBJECT;
+    }
+
+    MessageParcel reply;
+    MessageOption option;
+    auto remote = Remote();
+    if (remote == nullptr) {
+        return IPC_PROXY_NULL_INVOKER_ERR;
+    }
+    int32_t error = remote->SendRequest(
+        static_cast<uint32_t>(NetsysInterfaceCode::NETSYS_BANDWIDTH_UPDATE_UID_LISTS), data, reply, option);
+    if (error != ERR_NONE) {
+        NETNATIVE_LOGE("proxy SendRequest failed");
+        return ERR_FLATTEN_OBJECT;
+    }
+    return reply.ReadInt32();
+}
+
 int32_t NetsysNativeServiceProxy::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     MessageParcel data;
@@ -16,6 +16,7 @@
 #ifndef NETMANAGER_BASE_NET_SECURITY_CONFIG_H
 #define NETMANAGER_BASE_NET_SECURITY_CONFIG_H
 
+#include <memory>
 #include <string>
 #include <set>
 #include <vector>
@@ -98,8 +99,14 @@ private:
     void ParseJsonCleartextPermitted(const cJSON* const root, bool &cleartextPermitted);
     void ParseJsonComponentCfg(const cJSON* const root, ComponentCfg &componentConfigs);
     void ParseJsonComponentCfg(const cJSON* const root, ComponentCfg &componentConfigs, const std::string &component);
+    void OnDomainConfigsChanged();
+    void BuildDomainIndex();
+    int32_t MatchDomainIndex(const std::string &hostname);
+    int32_t FindDomainConfigIndex(const std::string &hostname, DomainConfig *domainConfig = nullptr);
 
 private:
+    struct DomainIndex;
+
     NetworkSecurityConfig();
     ~NetworkSecurityConfig();
     BaseConfig baseConfig_;
@@ -108,6 +115,7 @@ private:
     bool trustUserCa_ = true;
     bool isUserDnsCache_ = true;
     bool hasBaseConfig_ = false;
+    std::unique_ptr<DomainIndex> domainIndex_;
     ComponentCfg componentConfig_ = {
         {"Network Kit", true},
         {"Request", true},
@@ -22,6 +22,9 @@ struct FwmarkCommand {
     enum CmdId {
         SELECT_NETWORK,
         PROTECT_FROM_VPN,
+        // Sent without a socket, apply to every socket the sending process creates afterwards
+        SELECT_PROCESS_NETWORK,
+        PROTECT_PROCESS_FROM_VPN,
     } cmdId;
     uint32_t netId;
 };
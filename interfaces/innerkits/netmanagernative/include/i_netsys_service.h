@@ -164,6 +164,9 @@ public:
     virtual int32_t BandwidthAddDeniedList(uint32_t uid) = 0;
     virtual int32_t BandwidthRemoveDeniedList(uint32_t uid) = 0;
     virtual int32_t BandwidthRemoveIfaceQuota(const std::string &ifName) = 0;
+    virtual int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                            const std::vector<uint32_t> &allowedUids,
+                                            const std::vector<uint32_t> &removedUids) = 0;
     virtual int32_t FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids) = 0;
     virtual int32_t FirewallSetUidsDeniedListChain(uint32_t chain, const std::vector<uint32_t> &uids) = 0;
     virtual int32_t FirewallEnableChain(uint32_t chain, bool enable) = 0;
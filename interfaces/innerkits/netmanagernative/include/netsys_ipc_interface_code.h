@@ -178,6 +178,7 @@ enum class NetsysInterfaceCode {
     NETSYS_NFQUEUE_QUEUE_SET_MAX_LEN,
     NETSYS_NFQUEUE_QUEUE_SET_FLAG,
     NETSYS_NFQUEUE_PKT_VERDICT_MARK,
+    NETSYS_BANDWIDTH_UPDATE_UID_LISTS,
 };
 
 enum class NotifyInterfaceCode {
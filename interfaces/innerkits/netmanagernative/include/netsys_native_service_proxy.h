@@ -101,6 +101,8 @@ public:
     int32_t FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids) override;
     int32_t FirewallSetUidsDeniedListChain(uint32_t chain, const std::vector<uint32_t> &uids) override;
     int32_t BandwidthRemoveIfaceQuota(const std::string &ifName) override;
+    int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                                    const std::vector<uint32_t> &removedUids) override;
     int32_t BandwidthRemoveDeniedList(uint32_t uid) override;
     int32_t BandwidthAddDeniedList(uint32_t uid) override;
     int32_t BandwidthAddAllowedList(uint32_t uid) override;
@@ -92,6 +92,7 @@ public:
     int StopPacLocalProxyServer();
     uint32_t SetProxyOff();
     uint32_t SetProxyAuto();
+    void ClearPacProxyCache();
 #endif
     void OnStart() override;
     void OnStop() override;
@@ -18,6 +18,7 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <functional>
 #include <map>
 #include <mutex>
 #include <string>
@@ -43,6 +44,8 @@ public:
     ~NetHttpProbe();
 
     int32_t SendProbe(ProbeType probeType, const std::string &httpUrl, const std::string &httpsUrl);
+    int32_t SendProbeAsync(ProbeType probeType, const std::string &httpUrl, const std::string &httpsUrl,
+        uint64_t probeGroup, const std::function<void()> &callback);
     NetHttpProbeResult GetHttpProbeResult() const;
     NetHttpProbeResult GetHttpsProbeResult() const;
     void UpdateGlobalHttpProxy(const HttpProxy &httpProxy);
@@ -70,6 +73,9 @@ private:
                       const bool useProxy);
     void SendHttpProbeRequest();
     void RecvHttpProbeResponse();
+    void ProcessProbeResponse(CURL *curl);
+    void OnAsyncProbeDone(CURL *curl, CURLcode code);
+    std::string GetResolveScope();
     int32_t LoadProxy(std::string &proxyHost, int32_t &proxyPort);
     bool SetUserInfo(CURL *curlHandler);
     bool SetProxyInfo(CURL *curlHandler, const std::string &proxyHost, int32_t proxyPort);
@@ -85,6 +91,8 @@ private:
 
     std::mutex proxyMtx_;
     bool isCurlInit_ = false;
+    bool useEventLoop_ = false;
+    std::function<void()> asyncProbeCallback_;
     std::atomic<bool> defaultUseGlobalHttpProxy_ = true;
     uint32_t netId_ = 0;
     NetBearType netBearType_ = BEARER_DEFAULT;
@@ -95,6 +103,8 @@ private:
     CURL *httpsCurl_ = nullptr;
     curl_slist *httpResolveList_ = nullptr;
     curl_slist *httpsResolveList_ = nullptr;
+    // Written on the probe loop thread, read by the detection round
+    mutable std::mutex resultMtx_;
     NetHttpProbeResult httpProbeResult_;
     NetHttpProbeResult httpsProbeResult_;
     std::string respHeader_;
@@ -109,6 +109,7 @@ private:
     void LoadGlobalHttpProxy();
     void ProcessDetection(NetHttpProbeResult& probeResult, NetDetectionStatus& result);
     NetHttpProbeResult SendProbe();
+    NetHttpProbeResult DoSendProbe();
     void SendPortalInfo(PortalDetectInfo& info);
     NetHttpProbeResult ProcessThreadDetectResult(std::shared_ptr<ProbeThread>& httpProbeThread,
         std::shared_ptr<ProbeThread>& httpsProbeThread, std::shared_ptr<ProbeThread>& backHttpThread,
@@ -151,6 +152,7 @@ private:
     PortalDetectInfo portalDetectInfo_;
     std::string xReqId_;
     int8_t xReqIdLen_ = -1;
+    uint64_t probeGroup_ = 0;
     std::shared_ptr<NetConnServiceIface> serviceIface_;
 };
 } // namespace NetManagerStandard
@@ -25,6 +25,9 @@
 #include <string>
 #include <thread>
 #include <vector>
+
+#include "net_pac_local_proxy_tunnel.h"
+
 namespace OHOS {
 namespace NetManagerStandard {
 
@@ -62,10 +65,9 @@ private:
     int TryConnectWithProxyList(const std::string &targetHost, int targetPort,
                                 const std::vector<ProxyConfig> &proxyList, bool isHttps,
                                 const std::string &requestHeader = "");
-    void HandleConnectRequest(int clientSocket, const std::string &requestHeader, const std::string &url);
-    void HandleHttpRequest(int clientSocket, const std::string &requestHeader, const std::string &url);
+    bool HandleConnectRequest(int clientSocket, const std::string &requestHeader, const std::string &url);
+    bool HandleHttpRequest(int clientSocket, const std::string &requestHeader, const std::string &url);
     void SendErrorResponse(int clientSocket, const char *response);
-    void ForwardData(int fromSocket, int toSocket);
     struct ClientTask {
         int clientSocket_;
         struct sockaddr_in clientAddr_;
@@ -76,7 +78,6 @@ private:
     std::string GetRequestMethod(const std::string &header);
     bool ParseConnectRequest(const std::string &header, std::string &host, int &port);
     bool ParseHttpRequest(const std::string &header, std::string &host, int &port);
-    void TunnelData(int client, int server);
     int ConnectToServer(const std::string &host, int port);
     int ConnectViaUpstreamProxy(const std::string &targetHost, int targetPort, const std::string &originalRequest,
                                 std::string proxyHost, int proxyPort);
@@ -96,6 +97,7 @@ private:
     std::queue<ClientTask> taskQueue_;
     std::mutex queueMutex_;
     std::condition_variable queueCondition_;
+    ProxyTunnelReactor tunnelReactor_;
 };
 } // namespace NetManagerStandard
 } // namespace OHOS
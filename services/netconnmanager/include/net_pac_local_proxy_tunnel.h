@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef NET_PAC_LOCAL_PROXY_TUNNEL_H
+#define NET_PAC_LOCAL_PROXY_TUNNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace OHOS {
+namespace NetManagerStandard {
+
+/**
+ * Moves the bytes of the local proxy tunnels from one epoll thread.
+ *
+ * Each direction of a tunnel owns a pipe, data is spliced from the source socket into the pipe and
+ * from the pipe into the destination socket without passing through user space. A direction stops
+ * reading while its pipe is full, so a slow peer only holds one pipe worth of data. A response only
+ * tunnel never reads the client, what the client sends after its request stays unread.
+ */
+class ProxyTunnelReactor {
+public:
+    explicit ProxyTunnelReactor(std::chrono::seconds idleTimeout);
+    ~ProxyTunnelReactor();
+    bool Start();
+    void Stop();
+    /* Takes ownership of both sockets, they are closed when the tunnel ends */
+    bool AddTunnel(int clientSocket, int serverSocket, bool isResponseOnly = false);
+    size_t GetTunnelCount() const;
+
+private:
+    struct Direction {
+        int readPipe = -1;
+        int writePipe = -1;
+        size_t pending = 0;
+        size_t capacity = 0;
+        bool isEof = false;
+        bool isShutdown = false;
+    };
+    struct Tunnel {
+        int sockets[2] = {-1, -1};
+        // direction 0 carries client to server, direction 1 server to client
+        Direction directions[2];
+        std::chrono::steady_clock::time_point lastActivity;
+    };
+    struct PendingTunnel {
+        int clientSocket = -1;
+        int serverSocket = -1;
+        bool isResponseOnly = false;
+    };
+    enum class PumpResult {
+        IDLE,
+        BUDGET_SPENT,
+        FAILED,
+    };
+    void ReactorLoop();
+    void RegisterPendingTunnels();
+    void OpenTunnel(const PendingTunnel &pending);
+    void ServeTunnel(uint64_t id);
+    PumpResult Pump(Tunnel &tunnel, int index);
+    void CloseTunnel(uint64_t id);
+    void CloseIdleTunnels();
+    void CloseAllTunnels();
+    void ClosePendingTunnels();
+    void Wakeup();
+
+    std::chrono::seconds idleTimeout_;
+    int epollFd_ = -1;
+    int wakeupFd_ = -1;
+    uint64_t nextTunnelId_ = 1;
+    std::atomic<bool> running_;
+    std::atomic<size_t> tunnelCount_;
+    std::thread reactorThread_;
+    std::unordered_map<uint64_t, Tunnel> tunnels_;
+    // Tunnels that used up their byte budget and continue on the next loop round
+    std::unordered_set<uint64_t> busyTunnels_;
+    std::mutex pendingMutex_;
+    std::vector<PendingTunnel> pendingTunnels_;
+    std::chrono::steady_clock::time_point lastIdleCheck_;
+};
+} // namespace NetManagerStandard
+} // namespace OHOS
+#endif // NET_PAC_LOCAL_PROXY_TUNNEL_H
@@ -15,8 +15,12 @@
 
 #ifndef JERRY_NET_PAC_MANAGER_H
 #define JERRY_NET_PAC_MANAGER_H
+#include <chrono>
+#include <list>
 #include <string>
 #include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 #include "mutex"
 namespace OHOS {
 namespace NetManagerStandard {
@@ -65,11 +69,34 @@ public:
 
     std::string ParseHost(const std::string &url);
 
+    /* Drops every cached lookup result, called when the network the script is evaluated against changes */
+    void ClearProxyCache();
+
 private:
+    struct ProxyCacheEntry {
+        std::string proxy;
+        std::chrono::steady_clock::time_point expireTime;
+    };
+
     void ReleasePACScript();
+    PAC_STATUS RunPACScript();
+    PAC_STATUS CallFindProxyForURL(const std::string &url, const std::string &host, std::string &proxy);
+    void AnalyzePACScript(const std::string &script);
+    std::string GetCacheKey(const std::string &url, const std::string &host);
+    bool GetCachedProxy(const std::string &key, std::string &proxy);
+    void SetCachedProxy(const std::string &key, const std::string &proxy);
 
     uint32_t pacScriptVal_;
+    // FindProxyForURL of the already evaluated script, kept alive between lookups
+    uint32_t pacFunctionVal_;
+    PAC_STATUS scriptStatus_;
     std::mutex pacMutex_;
+    // Results of the script are cached per scheme and host unless the script reads the url or the clock
+    bool cacheEnabled_;
+    bool cacheByUrl_;
+    std::shared_mutex cacheMutex_;
+    std::unordered_map<std::string, ProxyCacheEntry> proxyCache_;
+    std::list<std::string> cacheOrder_;
     std::string scriptFileUrl_;
     bool status_;
     bool engineInitialized_;
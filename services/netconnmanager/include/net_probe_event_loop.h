@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NET_PROBE_EVENT_LOOP_H
+#define NET_PROBE_EVENT_LOOP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <curl/curl.h>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace OHOS {
+namespace NetManagerStandard {
+/**
+ * Single curl-multi event loop shared by every network probe of the service.
+ *
+ * Probes hand fully configured easy handles to the loop instead of driving their own
+ * multi handle on a dedicated thread. The loop owns one thread, enforces per-probe
+ * deadlines and can abort all probes of a detection round once its verdict is known.
+ */
+class NetProbeEventLoop {
+public:
+    /**
+     * Called on the loop thread once the probe has left the multi handle.
+     * The callee owns the easy handle again and is responsible for cleaning it up.
+     */
+    using ProbeCallback = std::function<void(CURL *easy, CURLcode code)>;
+
+    static NetProbeEventLoop &GetInstance();
+
+    /**
+     * Allocate an id used to group the probes of one detection round
+     *
+     * @return New probe group id, never 0
+     */
+    uint64_t CreateProbeGroup();
+
+    /**
+     * Hand a configured easy handle over to the loop
+     *
+     * @param easy Easy handle with all transfer options set
+     * @param netId Network the probe runs on, selects the shared DNS and TLS session cache
+     * @param scope Resolve scope, probes pinning different addresses for the same host use different scopes
+     * @param groupId Probe group the handle belongs to, 0 if none
+     * @param deadlineMs Time budget of the probe in milliseconds
+     * @param callback Completion callback, invoked exactly once when NETMANAGER_SUCCESS is returned
+     * @return NETMANAGER_SUCCESS if the probe was queued
+     */
+    int32_t AddProbe(CURL *easy, uint32_t netId, const std::string &scope, uint64_t groupId, uint32_t deadlineMs,
+        const ProbeCallback &callback);
+
+    /**
+     * Abort every queued or running probe of the group, callbacks get CURLE_ABORTED_BY_CALLBACK
+     *
+     * A callback of the group already running is waited for, so the caller reads a settled round and any later
+     * completion is reported as aborted. Must not be called from a probe callback.
+     *
+     * @param groupId Probe group id
+     */
+    void CancelProbeGroup(uint64_t groupId);
+
+    /**
+     * Look up a cached probe host resolution of a network
+     *
+     * @param netId Network id
+     * @param domain Host name
+     * @param addrList Comma separated address list when found
+     * @return true if a fresh entry exists
+     */
+    bool GetCachedAddrInfo(uint32_t netId, const std::string &domain, std::string &addrList);
+
+    /**
+     * Remember a probe host resolution of a network for the following probes
+     *
+     * @param netId Network id
+     * @param domain Host name
+     * @param addrList Comma separated address list
+     */
+    void SetCachedAddrInfo(uint32_t netId, const std::string &domain, const std::string &addrList);
+
+    /**
+     * Drop the caches of a network when it is released
+     *
+     * @param netId Network id
+     */
+    void ReleaseNetwork(uint32_t netId);
+
+    /**
+     * Get the number of probes currently queued or running
+     */
+    uint32_t GetProbeCount() const;
+
+private:
+    struct ShareContext {
+        CURLSH *share = nullptr;
+        std::mutex locks[CURL_LOCK_DATA_LAST];
+        ~ShareContext();
+    };
+
+    struct ProbeTask {
+        CURL *easy = nullptr;
+        uint64_t groupId = 0;
+        uint64_t deadline = 0;
+        std::shared_ptr<ShareContext> shareContext;
+        ProbeCallback callback;
+    };
+
+    struct AddrCacheEntry {
+        std::string addrList;
+        uint64_t expireTime = 0;
+    };
+
+    NetProbeEventLoop() = default;
+    ~NetProbeEventLoop();
+    NetProbeEventLoop(const NetProbeEventLoop &) = delete;
+    NetProbeEventLoop &operator=(const NetProbeEventLoop &) = delete;
+
+    static void ShareLock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+    static void ShareUnlock(CURL *handle, curl_lock_data data, void *userptr);
+
+    std::shared_ptr<ShareContext> GetShareContext(uint32_t netId, const std::string &scope);
+    bool StartLoop();
+    void Run();
+    void ApplyPendingRequests();
+    void ProcessDoneMessages();
+    void ProcessDeadlines();
+    void FinishProbe(std::list<ProbeTask>::iterator it, CURLcode code);
+    bool HasWork();
+
+    std::once_flag startFlag_;
+    std::atomic<bool> isStarted_ = false;
+    std::thread loopThread_;
+    CURLM *multi_ = nullptr;
+    std::atomic<uint64_t> groupSeq_ = 0;
+    std::atomic<uint32_t> probeCount_ = 0;
+
+    std::mutex taskMutex_;
+    std::condition_variable taskCond_;
+    std::condition_variable dispatchCond_;
+    uint64_t dispatchingGroup_ = 0;
+    std::list<ProbeTask> pendingTasks_;
+    std::set<uint64_t> cancelledGroups_;
+    bool isCancelPending_ = false;
+    bool isStopping_ = false;
+    // Only touched from the loop thread.
+    std::list<ProbeTask> runningTasks_;
+
+    std::mutex cacheMutex_;
+    std::map<std::pair<uint32_t, std::string>, std::shared_ptr<ShareContext>> shareContexts_;
+    std::map<std::pair<uint32_t, std::string>, AddrCacheEntry> addrCache_;
+};
+} // namespace NetManagerStandard
+} // namespace OHOS
+#endif // NET_PROBE_EVENT_LOOP_H
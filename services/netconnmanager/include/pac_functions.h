@@ -24,6 +24,8 @@ public:
     PacFunctions() = default;
     ~PacFunctions() = default;
     static void RegisterPacFunctions(void);
+    /* Forgets the host resolutions memoized while one FindProxyForURL call runs */
+    static void ClearResolveCache(void);
 
 private:
     static jerry_value_t JsIsPlainHostname(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
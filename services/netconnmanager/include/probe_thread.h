@@ -20,7 +20,6 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <pthread.h>
 
 #include "refbase.h"
@@ -63,6 +62,11 @@ public:
      */
     void SetXReqId(const std::string& xReqId, int8_t xReqIdLen);
 
+    /**
+     * Set the probe group used to cancel the probe once the detection round is decided
+     */
+    void SetProbeGroup(uint64_t probeGroup);
+
     /*
      * send http probe
     */
@@ -104,9 +108,13 @@ public:
     uint64_t GetProbeDurationTime();
 
 private:
+    bool CheckProbeReady();
+    void SendHttpProbeAsync();
+    void OnProbeFinished();
+    void CountDownLatch(bool isConclusive);
+
     uint32_t netId_ = 0;
     std::unique_ptr<NetHttpProbe> httpProbe_;
-    std::thread thread_;
     ProbeType probeType_;
     std::shared_ptr<TinyCountDownLatch> latch_;
     std::shared_ptr<TinyCountDownLatch> latchAll_;
@@ -114,7 +122,9 @@ private:
     std::string httpProbeUrl_;
     std::string httpsProbeUrl_;
     std::string ipAddrList_;
-    uint64_t probeDuration_ = 0;
+    uint64_t probeStartTime_ = 0;
+    std::atomic<uint64_t> probeDuration_ = 0;
+    uint64_t probeGroup_ = 0;
 };
 } // namespace NetManagerStandard
 } // namespace OHOS
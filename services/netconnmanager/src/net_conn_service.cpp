@@ -1215,6 +1215,11 @@ int32_t NetConnService::UpdateNetLinkInfoAsync(uint32_t supplierId, const sptr<N
         return NET_CONN_ERR_SERVICE_UPDATE_NET_LINK_INFO_FAIL;
     }
     CallbackForSupplier(supplier, CALL_TYPE_UPDATE_LINK);
+#ifdef NETMANAGER_ENABLE_PAC_PROXY
+    if (supplier == defaultNetSupplier_) {
+        ClearPacProxyCache();
+    }
+#endif
     bool isFirstTimeDetect = supplier->IsInFirstTimeDetecting();
     HandlePreFindBestNetworkForDelay(supplierId, supplier, isFirstTimeDetect);
     if (!isDelayHandleFindBestNetwork_) {
@@ -2002,6 +2007,9 @@ void NetConnService::MakeDefaultNetWork(sptr<NetSupplier> &oldSupplier, sptr<Net
     }
 
     oldSupplier = newSupplier;
+#ifdef NETMANAGER_ENABLE_PAC_PROXY
+    ClearPacProxyCache();
+#endif
 }
 
 void NetConnService::HandleDetectionResult(uint32_t supplierId, NetDetectionStatus netState)
@@ -2986,6 +2994,14 @@ std::shared_ptr<NetPACManager> NetConnService::GetNetPacManager()
     return netPACManager_;
 }
 
+void NetConnService::ClearPacProxyCache()
+{
+    std::lock_guard<std::mutex> guard{netPacManagerMutex_};
+    if (netPACManager_) {
+        netPACManager_->ClearProxyCache();
+    }
+}
+
 uint32_t NetConnService::SetProxyOff()
 {
     StopPacLocalProxyServer();
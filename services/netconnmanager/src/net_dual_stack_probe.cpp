@@ -17,6 +17,7 @@
 #include "net_dns_resolve.h"
 #include "net_manager_constants.h"
 #include "net_mgr_log_wrapper.h"
+#include "net_probe_event_loop.h"
 #include "netmanager_base_common_utils.h"
 #include "tiny_count_down_latch.h"
 
@@ -140,6 +141,11 @@ DualStackProbeResultCode NetDualStackProbe::DoDualStackHttpProbe(
     std::shared_ptr<ProbeThread> httpsThreadV6 = std::make_shared<ProbeThread>(
             netId_, netBearType_, netLinkInfo_, latch, latchAll,
             ProbeType::PROBE_HTTPS, httpUrl_, httpsUrl_, ipv6AddrList);
+    uint64_t probeGroup = NetProbeEventLoop::GetInstance().CreateProbeGroup();
+    httpThreadV4->SetProbeGroup(probeGroup);
+    httpsThreadV4->SetProbeGroup(probeGroup);
+    httpThreadV6->SetProbeGroup(probeGroup);
+    httpsThreadV6->SetProbeGroup(probeGroup);
     httpThreadV4->Start();
     httpsThreadV4->Start();
     httpThreadV6->Start();
@@ -147,6 +153,7 @@ DualStackProbeResultCode NetDualStackProbe::DoDualStackHttpProbe(
     NETMGR_LOG_I("DualStackProbe time out:%{public}d", timeOutDuration);
     latch->Await(std::chrono::milliseconds(timeOutDuration));
     latchAll->Await(std::chrono::milliseconds(timeOutDuration));
+    NetProbeEventLoop::GetInstance().CancelProbeGroup(probeGroup);
     DualStackProbeResultCode result = ProcessProbeResult(httpThreadV4, httpsThreadV4,
         httpThreadV6, httpsThreadV6);
     return result;
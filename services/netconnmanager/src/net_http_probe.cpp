@@ -24,6 +24,7 @@
 #include "netsys_controller.h"
 #include "net_manager_constants.h"
 #include "net_mgr_log_wrapper.h"
+#include "net_probe_event_loop.h"
 #include "net_proxy_userinfo.h"
 #include "netmanager_base_common_utils.h"
 
@@ -56,6 +57,8 @@ constexpr int32_t DEFAULT_HTTP_PORT = 80;
 constexpr int32_t DEFAULT_HTTPS_PORT = 443;
 constexpr const char *ADDR_SEPARATOR = ",";
 constexpr const char *SYMBOL_COLON = ":";
+constexpr const char *RESOLVE_SCOPE_IPV4 = "ipv4";
+constexpr const char *RESOLVE_SCOPE_IPV6 = "ipv6";
 const std::string DEFAULT_USER_AGENT = std::string("User-Agent: Mozilla/5.0 (X11; Linux x86_64) ") +
     std::string("AppleWebKit/537.36 (KHTML, like Gecko) Chrome/60.0.3112.32 Safari/537.36");
 constexpr const char *CONNECTION_PROPERTY = "Connection: close";
@@ -162,13 +165,80 @@ int32_t NetHttpProbe::SendProbe(ProbeType probeType, const std::string &httpUrl,
     return NETMANAGER_SUCCESS;
 }
 
+int32_t NetHttpProbe::SendProbeAsync(ProbeType probeType, const std::string &httpUrl,
+    const std::string &httpsUrl, uint64_t probeGroup, const std::function<void()> &callback)
+{
+    NETMGR_LOG_I("Send net:[%{public}d] %{public}s async probe in", netId_,
+        ((IsHttpsDetect(probeType)) ? "https" : "http"));
+    ClearProbeResult();
+    if (!CheckCurlGlobalInitState()) {
+        return NETMANAGER_ERR_INTERNAL;
+    }
+    if (!IsHttpDetect(probeType) && !IsHttpsDetect(probeType)) {
+        NETMGR_LOG_E("Async probe supports a single http or https probe only");
+        return NETMANAGER_ERR_INVALID_PARAMETER;
+    }
+
+    useEventLoop_ = true;
+    if (!InitHttpCurl(probeType) || !SetCurlOptions(probeType, httpUrl, httpsUrl)) {
+        NETMGR_LOG_E("Set http/https async probe options failed");
+        CleanHttpCurl();
+        useEventLoop_ = false;
+        return NETMANAGER_ERR_INTERNAL;
+    }
+
+    asyncProbeCallback_ = callback;
+    CURL *curl = IsHttpDetect(probeType) ? httpCurl_ : httpsCurl_;
+    int32_t ret = NetProbeEventLoop::GetInstance().AddProbe(curl, netId_, GetResolveScope(), probeGroup,
+        CURL_OPERATE_TIME_OUT_MS, [this](CURL *easy, CURLcode code) { OnAsyncProbeDone(easy, code); });
+    if (ret != NETMANAGER_SUCCESS) {
+        NETMGR_LOG_E("Net:[%{public}d] add probe to event loop failed, ret:[%{public}d]", netId_, ret);
+        asyncProbeCallback_ = nullptr;
+        CleanHttpCurl();
+        useEventLoop_ = false;
+        return ret;
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+void NetHttpProbe::OnAsyncProbeDone(CURL *curl, CURLcode code)
+{
+    bool isCancelled = (code == CURLE_ABORTED_BY_CALLBACK);
+    if (isCancelled) {
+        NETMGR_LOG_I("Net[%{public}d] probe cancelled, result already decided", netId_);
+    } else {
+        ProcessProbeResponse(curl);
+    }
+    CleanHttpCurl();
+    useEventLoop_ = false;
+    if (!defaultUseGlobalHttpProxy_) {
+        defaultUseGlobalHttpProxy_ = true;
+    }
+    auto callback = std::move(asyncProbeCallback_);
+    asyncProbeCallback_ = nullptr;
+    /* the round that started a cancelled probe has already read its results, leave them untouched */
+    if (callback != nullptr && !isCancelled) {
+        callback();
+    }
+}
+
+std::string NetHttpProbe::GetResolveScope()
+{
+    if (ipAddrList_.empty()) {
+        return std::string();
+    }
+    return (ipAddrList_.find(SYMBOL_COLON) != std::string::npos) ? RESOLVE_SCOPE_IPV6 : RESOLVE_SCOPE_IPV4;
+}
+
 NetHttpProbeResult NetHttpProbe::GetHttpProbeResult() const
 {
+    std::lock_guard<std::mutex> locker(resultMtx_);
     return httpProbeResult_;
 }
 
 NetHttpProbeResult NetHttpProbe::GetHttpsProbeResult() const
 {
+    std::lock_guard<std::mutex> locker(resultMtx_);
     return httpsProbeResult_;
 }
 
@@ -228,6 +298,7 @@ void NetHttpProbe::CleanHttpCurl()
 
 void NetHttpProbe::ClearProbeResult()
 {
+    std::lock_guard<std::mutex> locker(resultMtx_);
     httpProbeResult_ = {};
     httpsProbeResult_ = {};
 }
@@ -261,6 +332,12 @@ std::string NetHttpProbe::GetAddrInfo(const std::string &domain)
         return std::string();
     }
 
+    std::string cachedAddress;
+    if (NetProbeEventLoop::GetInstance().GetCachedAddrInfo(netId_, domain, cachedAddress)) {
+        NETMGR_LOG_D("Get net[%{public}d] address info from probe cache", netId_);
+        return cachedAddress;
+    }
+
     struct addrinfo *result = nullptr;
     struct queryparam qparam = {};
     qparam.qp_netid = static_cast<int>(netId_);
@@ -305,15 +382,19 @@ std::string NetHttpProbe::GetAddrInfo(const std::string &domain)
         NETMGR_LOG_E("Get net[%{public}d] address info return nullptr result",  netId_);
         return std::string();
     }
+    NetProbeEventLoop::GetInstance().SetCachedAddrInfo(netId_, domain, ipAddress);
     return ipAddress;
 }
 
 bool NetHttpProbe::InitHttpCurl(ProbeType probeType)
 {
-    curlMulti_ = curl_multi_init();
-    if (curlMulti_ == nullptr) {
-        NETMGR_LOG_E("curl_multi_init() failed.");
-        return false;
+    /* async probes are driven by the shared event loop, which owns the multi handle */
+    if (!useEventLoop_) {
+        curlMulti_ = curl_multi_init();
+        if (curlMulti_ == nullptr) {
+            NETMGR_LOG_E("curl_multi_init() failed.");
+            return false;
+        }
     }
 
     if (IsHttpDetect(probeType)) {
@@ -419,6 +500,9 @@ bool NetHttpProbe::SetHttpOptions(ProbeType probeType, CURL *curl, const std::st
     NETPROBE_CURL_EASY_SET_OPTION(curl, CURLOPT_HTTPHEADER, list);
     NETPROBE_CURL_EASY_SET_OPTION(curl, CURLOPT_ERRORBUFFER, errBuffer);
 
+    if (useEventLoop_) {
+        return true;
+    }
     CURLMcode code = curl_multi_add_handle(curlMulti_, curl);
     if (code != CURLM_OK) {
         NETMGR_LOG_E("curl multi add handle failed, code:[%{public}d]", code);
@@ -763,30 +847,36 @@ void NetHttpProbe::RecvHttpProbeResponse()
             continue;
         }
 
-        int64_t responseCode = 0;
-        curl_easy_getinfo(curlMsg->easy_handle, CURLINFO_RESPONSE_CODE, &responseCode);
-        responseCode = CheckRespCode(static_cast<int32_t>(responseCode));
-        std::string redirectUrl;
-        char* url = nullptr;
-        curl_easy_getinfo(curlMsg->easy_handle, CURLINFO_REDIRECT_URL, &url);
-        if (url != nullptr) {
-            redirectUrl = url;
-        } else {
-            curl_easy_getinfo(curlMsg->easy_handle, CURLINFO_EFFECTIVE_URL, &url);
-            redirectUrl = url;
-        }
+        ProcessProbeResponse(curlMsg->easy_handle);
+    }
+}
 
-        if (curlMsg->easy_handle == httpCurl_) {
-            httpProbeResult_ = {responseCode, redirectUrl};
-            NETMGR_LOG_I("Recv net[%{public}d] http probe response, code:[%{public}d]", netId_,
-                         httpProbeResult_.GetCode());
-        } else if (curlMsg->easy_handle == httpsCurl_) {
-            httpsProbeResult_ = {responseCode, redirectUrl};
-            NETMGR_LOGD("Recv net[%{public}d] https probe response, code:[%{public}d]", netId_,
-                         httpsProbeResult_.GetCode());
-        } else {
-            NETMGR_LOG_E("Unknown curl handle.");
-        }
+void NetHttpProbe::ProcessProbeResponse(CURL *curl)
+{
+    int64_t responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    responseCode = CheckRespCode(static_cast<int32_t>(responseCode));
+    std::string redirectUrl;
+    char* url = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_REDIRECT_URL, &url);
+    if (url != nullptr) {
+        redirectUrl = url;
+    } else {
+        curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+        redirectUrl = url;
+    }
+
+    std::lock_guard<std::mutex> locker(resultMtx_);
+    if (curl == httpCurl_) {
+        httpProbeResult_ = {responseCode, redirectUrl};
+        NETMGR_LOG_I("Recv net[%{public}d] http probe response, code:[%{public}d]", netId_,
+                     httpProbeResult_.GetCode());
+    } else if (curl == httpsCurl_) {
+        httpsProbeResult_ = {responseCode, redirectUrl};
+        NETMGR_LOGD("Recv net[%{public}d] https probe response, code:[%{public}d]", netId_,
+                     httpsProbeResult_.GetCode());
+    } else {
+        NETMGR_LOG_E("Unknown curl handle.");
     }
 }
 
@@ -38,6 +38,7 @@
 #include "net_http_proxy_tracker.h"
 #include "net_mgr_log_wrapper.h"
 #include "net_manager_constants.h"
+#include "net_probe_event_loop.h"
 #include "tiny_count_down_latch.h"
 #include "cJSON.h"
 #include "net_conn_service_iface.h"
@@ -224,6 +225,15 @@ NetHttpProbeResult NetMonitor::SendProbe()
 {
     NETMGR_LOG_D("start net detection");
     std::lock_guard<std::mutex> monitorLocker(probeMtx_);
+    probeGroup_ = NetProbeEventLoop::GetInstance().CreateProbeGroup();
+    NetHttpProbeResult result = DoSendProbe();
+    /* the verdict is decided, abort the probes of this round that are still in flight */
+    NetProbeEventLoop::GetInstance().CancelProbeGroup(probeGroup_);
+    return result;
+}
+
+NetHttpProbeResult NetMonitor::DoSendProbe()
+{
     std::shared_ptr<TinyCountDownLatch> latch = std::make_shared<TinyCountDownLatch>(ONE_URL_DETECT_NUM);
     std::shared_ptr<TinyCountDownLatch> latchAll = std::make_shared<TinyCountDownLatch>(ALL_DETECT_THREAD_NUM);
     std::shared_ptr<ProbeThread> httpProxyThread = nullptr;
@@ -254,6 +264,8 @@ NetHttpProbeResult NetMonitor::SendProbe()
     portalDetectInfo_.httpBackupDetectTime = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::high_resolution_clock::now() - start).count();
     latchAll->Await(std::chrono::milliseconds(ALL_DETECTION_RESULT_WAIT_MS));
+    /* settle the round before reading it, a probe finishing after the wait must not change the verdict */
+    NetProbeEventLoop::GetInstance().CancelProbeGroup(probeGroup_);
     proxyResult = ProcessThreadDetectResult(httpProxyThread, httpsProxyThread, backHttpProxyThread,
         backHttpsProxyThread);
     NetHttpProbeResult noProxyResult = ProcessThreadDetectResult(httpNoProxyThread, httpsNoProxyThread,
@@ -327,6 +339,10 @@ void NetMonitor::StartProbe(std::shared_ptr<ProbeThread>& httpProbeThread,
     }
     httpProbeThread->SetXReqId(xReqId_, xReqIdLen_);
     backHttpThread->SetXReqId(xReqId_, xReqIdLen_);
+    httpProbeThread->SetProbeGroup(probeGroup_);
+    httpsProbeThread->SetProbeGroup(probeGroup_);
+    backHttpThread->SetProbeGroup(probeGroup_);
+    backHttpsThread->SetProbeGroup(probeGroup_);
     if (netBearType_ == BEARER_CELLULAR) {
         httpsProbeThread->Start();
         httpProbeThread->Start();
@@ -82,7 +82,8 @@ constexpr char SEMICOLON_CHAR = ';';
 } // namespace
 
 ProxyServer::ProxyServer(int port, int numThreads)
-    : port_(port), serverSocket_(-1), numThreads_(numThreads), running_(false)
+    : port_(port), serverSocket_(-1), numThreads_(numThreads), running_(false),
+      tunnelReactor_(std::chrono::seconds(TIME_OUT))
 {
     if (numThreads_ <= 0) {
         numThreads_ = static_cast<int>(std::thread::hardware_concurrency());
@@ -158,7 +159,7 @@ bool ProxyServer::Start()
         serverSocket_ = -1;
         return false;
     }
-    if (listen(serverSocket_, BACKLOG) < 0) {
+    if (listen(serverSocket_, BACKLOG) < 0 || !tunnelReactor_.Start()) {
         close(serverSocket_);
         serverSocket_ = -1;
         return false;
@@ -187,6 +188,7 @@ void ProxyServer::Stop()
         }
     }
     workers_.clear();
+    tunnelReactor_.Stop();
     {
         std::lock_guard<std::mutex> lock(queueMutex_);
         while (!taskQueue_.empty()) {
@@ -254,56 +256,6 @@ bool ProxyServer::ParseHttpRequest(const std::string &header, std::string &host,
     return true;
 }
 
-void ProxyServer::TunnelData(int client, int server)
-{
-    struct pollfd fds[2];
-    fds[0].fd = client;
-    fds[0].events = POLLIN;
-    fds[1].fd = server;
-    fds[1].events = POLLIN;
-    char buffer[BUFFER_SIZE];
-    auto lastActivity = std::chrono::steady_clock::now();
-    while (running_) {
-        int ret = poll(fds, 2, 100);
-        if (ret < 0) {
-            if (errno == EINTR)
-                continue;
-            NETMGR_LOG_E("socket poll fail");
-            break;
-        }
-        auto now = std::chrono::steady_clock::now();
-        if (ret == 0) {
-            if (now - lastActivity > std::chrono::seconds(TIME_OUT)) {
-                NETMGR_LOG_D("Connection idle timeout, closing");
-                break;
-            }
-            continue;
-        }
-        lastActivity = now;
-        if ((static_cast<unsigned short>(fds[0].revents) & (POLLHUP | POLLERR)) ||
-                (static_cast<unsigned short>(fds[1].revents) & (POLLHUP | POLLERR)))
-            break;
-        if ((static_cast<unsigned short>(fds[0].revents) & POLLIN) {
-            int n = recv(client, buffer, BUFFER_SIZE, 0);
-            if (n <= 0) {
-                break;
-            }
-            if (SendAll(server, buffer, n, 0) <= 0) {
-                break;
-            }
-        }
-        if (static_cast<unsigned short>(fds[1].revents) & POLLIN) {
-            int n = recv(server, buffer, BUFFER_SIZE, 0);
-            if (n <= 0) {
-                break;
-            }
-            if (SendAll(client, buffer, n, 0) <= 0) {
-                break;
-            }
-        }
-    }
-}
-
 std::string ProxyServer::ReceiveResponseHeader(int socket)
 {
     std::string header;
@@ -631,13 +583,13 @@ void ProxyServer::SendErrorResponse(int clientSocket, const char *response)
     SendAll(clientSocket, response, strlen(response), 0);
 }
 
-void ProxyServer::HandleConnectRequest(int clientSocket, const std::string &requestHeader, const std::string &url)
+bool ProxyServer::HandleConnectRequest(int clientSocket, const std::string &requestHeader, const std::string &url)
 {
     std::string host;
     int port;
     if (!ParseConnectRequest(requestHeader, host, port)) {
         SendErrorResponse(clientSocket, HTTP_1_1_400);
-        return;
+        return false;
     }
 
     std::vector<ProxyConfig> proxyList;
@@ -645,36 +597,25 @@ void ProxyServer::HandleConnectRequest(int clientSocket, const std::string &requ
     int serverSocket = TryConnectWithProxyList(host, port, proxyList, true);
     if (serverSocket < 0) {
         SendErrorResponse(clientSocket, HTTP_1_1_502);
-        return;
+        return false;
     }
     if (SendAll(clientSocket, HTTP_1_1_200_CONNECTED, strlen(HTTP_1_1_200_CONNECTED), 0) < 0) {
         NETMGR_LOG_E("send CONNECT Response fail");
         close(serverSocket);
-        return;
-    }
-    TunnelData(clientSocket, serverSocket);
-    close(serverSocket);
-}
-
-void ProxyServer::ForwardData(int fromSocket, int toSocket)
-{
-    char buffer[BUFFER_SIZE];
-    int bytesReceived;
-    while ((bytesReceived = recv(fromSocket, buffer, BUFFER_SIZE, 0)) > 0) {
-        if (SendAll(toSocket, buffer, bytesReceived, 0) < 0) {
-            break;
-        }
+        return false;
     }
+    tunnelReactor_.AddTunnel(clientSocket, serverSocket);
+    return true;
 }
 
-void ProxyServer::HandleHttpRequest(int clientSocket, const std::string &requestHeader, const std::string &url)
+bool ProxyServer::HandleHttpRequest(int clientSocket, const std::string &requestHeader, const std::string &url)
 {
     std::string host;
     int port;
     if (!ParseHttpRequest(requestHeader, host, port)) {
         NETMGR_LOG_E("Parse Http Header Fail");
         SendErrorResponse(clientSocket, HTTP_1_1_400);
-        return;
+        return false;
     }
     NETMGR_LOG_D("HTTP request - local port:%{private}d url:%{private}s host:%{private}s",
         port_, url.c_str(), host.c_str());
@@ -683,10 +624,11 @@ void ProxyServer::HandleHttpRequest(int clientSocket, const std::string &request
     int serverSocket = TryConnectWithProxyList(host, port, proxyList, false, requestHeader);
     if (serverSocket < 0) {
         SendErrorResponse(clientSocket, HTTP_1_1_502);
-        return;
+        return false;
     }
-    ForwardData(serverSocket, clientSocket);
-    close(serverSocket);
+    // Only the response is relayed, a further request on the connection must not reach this upstream
+    tunnelReactor_.AddTunnel(clientSocket, serverSocket, true);
+    return true;
 }
 
 void ProxyServer::HandleClient(int clientSocket)
@@ -698,12 +640,16 @@ void ProxyServer::HandleClient(int clientSocket)
     }
     std::string method = GetRequestMethod(requestHeader);
     std::string url = GetRequestUrl(requestHeader);
+    // Once the upstream is connected the tunnel reactor owns the client socket, the worker moves on
+    bool isTunneled = false;
     if (method == CONNECT_STR) {
-        HandleConnectRequest(clientSocket, requestHeader, url);
+        isTunneled = HandleConnectRequest(clientSocket, requestHeader, url);
     } else {
-        HandleHttpRequest(clientSocket, requestHeader, url);
+        isTunneled = HandleHttpRequest(clientSocket, requestHeader, url);
+    }
+    if (!isTunneled) {
+        close(clientSocket);
     }
-    close(clientSocket);
 }
 
 void ProxyServer::AddTask(const ClientTask &task)
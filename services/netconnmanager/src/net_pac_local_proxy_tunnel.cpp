@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "netmanager_base_log.h"
+#include "net_pac_local_proxy_tunnel.h"
+
+namespace OHOS {
+namespace NetManagerStandard {
+namespace {
+constexpr int MAX_EPOLL_EVENTS = 256;
+constexpr int IDLE_CHECK_INTERVAL_MS = 1000;
+constexpr size_t PUMP_BUDGET_BYTES = 1024 * 1024;
+constexpr uint64_t WAKEUP_KEY = 0;
+constexpr int CLIENT_INDEX = 0;
+constexpr int SERVER_INDEX = 1;
+constexpr int DIRECTION_NUM = 2;
+constexpr uint32_t TUNNEL_EVENTS = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+constexpr unsigned int SPLICE_FLAGS = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+bool SetNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, static_cast<unsigned int>(flags) | O_NONBLOCK) >= 0;
+}
+
+void ClosePipe(int &readPipe, int &writePipe)
+{
+    if (readPipe >= 0) {
+        close(readPipe);
+        readPipe = -1;
+    }
+    if (writePipe >= 0) {
+        close(writePipe);
+        writePipe = -1;
+    }
+}
+} // namespace
+
+ProxyTunnelReactor::ProxyTunnelReactor(std::chrono::seconds idleTimeout)
+    : idleTimeout_(idleTimeout), running_(false), tunnelCount_(0)
+{
+}
+
+ProxyTunnelReactor::~ProxyTunnelReactor()
+{
+    Stop();
+}
+
+bool ProxyTunnelReactor::Start()
+{
+    if (reactorThread_.joinable()) {
+        return false;
+    }
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeupFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKEUP_KEY;
+    if (epollFd_ < 0 || wakeupFd_ < 0 || epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeupFd_, &event) < 0) {
+        NETMGR_LOG_E("create tunnel reactor fail: %{public}d", errno);
+        if (epollFd_ >= 0) {
+            close(epollFd_);
+            epollFd_ = -1;
+        }
+        if (wakeupFd_ >= 0) {
+            close(wakeupFd_);
+            wakeupFd_ = -1;
+        }
+        return false;
+    }
+    lastIdleCheck_ = std::chrono::steady_clock::now();
+    running_ = true;
+    reactorThread_ = std::thread(&ProxyTunnelReactor::ReactorLoop, this);
+    return true;
+}
+
+// Also cleans up after a reactor loop that ended on an epoll error
+void ProxyTunnelReactor::Stop()
+{
+    if (!reactorThread_.joinable()) {
+        return;
+    }
+    running_ = false;
+    Wakeup();
+    // The loop closes its tunnels on the way out
+    reactorThread_.join();
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        ClosePendingTunnels();
+        close(wakeupFd_);
+        wakeupFd_ = -1;
+    }
+    close(epollFd_);
+    epollFd_ = -1;
+}
+
+bool ProxyTunnelReactor::AddTunnel(int clientSocket, int serverSocket, bool isResponseOnly)
+{
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    if (!running_ || wakeupFd_ < 0) {
+        close(clientSocket);
+        close(serverSocket);
+        return false;
+    }
+    pendingTunnels_.push_back({clientSocket, serverSocket, isResponseOnly});
+    Wakeup();
+    return true;
+}
+
+size_t ProxyTunnelReactor::GetTunnelCount() const
+{
+    return tunnelCount_;
+}
+
+void ProxyTunnelReactor::Wakeup()
+{
+    uint64_t one = 1;
+    if (write(wakeupFd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        NETMGR_LOG_E("wakeup tunnel reactor fail: %{public}d", errno);
+    }
+}
+
+void ProxyTunnelReactor::ReactorLoop()
+{
+    // A peer resetting mid splice raises SIGPIPE on this thread, the splice error already reports it
+    sigset_t sigSet;
+    sigemptyset(&sigSet);
+    sigaddset(&sigSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigSet, nullptr);
+
+    epoll_event events[MAX_EPOLL_EVENTS];
+    while (running_) {
+        int timeout = busyTunnels_.empty() ? IDLE_CHECK_INTERVAL_MS : 0;
+        int count = epoll_wait(epollFd_, events, MAX_EPOLL_EVENTS, timeout);
+        if (count < 0 && errno != EINTR) {
+            NETMGR_LOG_E("tunnel epoll_wait fail: %{public}d", errno);
+            // Nothing serves the tunnels any more, AddTunnel refuses new ones from now on
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            running_ = false;
+            ClosePendingTunnels();
+            break;
+        }
+        std::unordered_set<uint64_t> readyTunnels;
+        readyTunnels.swap(busyTunnels_);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == WAKEUP_KEY) {
+                uint64_t value = 0;
+                read(wakeupFd_, &value, sizeof(value));
+                RegisterPendingTunnels();
+                continue;
+            }
+            readyTunnels.insert(events[i].data.u64 >> 1);
+        }
+        for (uint64_t id : readyTunnels) {
+            ServeTunnel(id);
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastIdleCheck_ >= std::chrono::milliseconds(IDLE_CHECK_INTERVAL_MS)) {
+            lastIdleCheck_ = now;
+            CloseIdleTunnels();
+        }
+    }
+    CloseAllTunnels();
+}
+
+void ProxyTunnelReactor::RegisterPendingTunnels()
+{
+    std::vector<PendingTunnel> pendingTunnels;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingTunnels.swap(pendingTunnels_);
+    }
+    for (const auto &pending : pendingTunnels) {
+        OpenTunnel(pending);
+    }
+}
+
+// Called with pendingMutex_ held
+void ProxyTunnelReactor::ClosePendingTunnels()
+{
+    for (const auto &pending : pendingTunnels_) {
+        close(pending.clientSocket);
+        close(pending.serverSocket);
+    }
+    pendingTunnels_.clear();
+}
+
+void ProxyTunnelReactor::OpenTunnel(const PendingTunnel &pending)
+{
+    uint64_t id = nextTunnelId_++;
+    Tunnel &tunnel = tunnels_[id];
+    ++tunnelCount_;
+    tunnel.sockets[CLIENT_INDEX] = pending.clientSocket;
+    tunnel.sockets[SERVER_INDEX] = pending.serverSocket;
+    tunnel.lastActivity = std::chrono::steady_clock::now();
+    if (!SetNonBlocking(pending.clientSocket) || !SetNonBlocking(pending.serverSocket)) {
+        NETMGR_LOG_E("set tunnel socket O_NONBLOCK fail");
+        CloseTunnel(id);
+        return;
+    }
+    if (pending.isResponseOnly) {
+        // The upload direction counts as done, it neither reads the client nor shuts down the server
+        Direction &upload = tunnel.directions[CLIENT_INDEX];
+        upload.isEof = true;
+        upload.isShutdown = true;
+    }
+    for (auto &direction : tunnel.directions) {
+        if (direction.isShutdown) {
+            continue;
+        }
+        int pipeFds[2] = {-1, -1};
+        if (pipe2(pipeFds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            NETMGR_LOG_E("create tunnel pipe fail: %{public}d", errno);
+            CloseTunnel(id);
+            return;
+        }
+        direction.readPipe = pipeFds[0];
+        direction.writePipe = pipeFds[1];
+        int capacity = fcntl(direction.writePipe, F_GETPIPE_SZ);
+        direction.capacity = capacity > 0 ? static_cast<size_t>(capacity) : PIPE_BUF;
+    }
+    for (int index = 0; index < DIRECTION_NUM; ++index) {
+        epoll_event event = {};
+        event.events = TUNNEL_EVENTS;
+        event.data.u64 = (id << 1) | static_cast<uint64_t>(index);
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, tunnel.sockets[index], &event) < 0) {
+            NETMGR_LOG_E("add tunnel socket to epoll fail: %{public}d", errno);
+            CloseTunnel(id);
+            return;
+        }
+    }
+}
+
+void ProxyTunnelReactor::ServeTunnel(uint64_t id)
+{
+    auto iter = tunnels_.find(id);
+    if (iter == tunnels_.end()) {
+        return;
+    }
+    Tunnel &tunnel = iter->second;
+    bool isBusy = false;
+    for (int index = 0; index < DIRECTION_NUM; ++index) {
+        PumpResult result = Pump(tunnel, index);
+        if (result == PumpResult::FAILED) {
+            CloseTunnel(id);
+            return;
+        }
+        isBusy = isBusy || result == PumpResult::BUDGET_SPENT;
+    }
+    const Direction &upload = tunnel.directions[CLIENT_INDEX];
+    const Direction &download = tunnel.directions[SERVER_INDEX];
+    if (upload.isShutdown && download.isShutdown) {
+        CloseTunnel(id);
+        return;
+    }
+    if (isBusy) {
+        busyTunnels_.insert(id);
+    }
+}
+
+/*
+ * Edge triggered: keep moving bytes until the source runs dry, or the pipe is full and the
+ * destination pushes back. The destination becoming writable again raises the next edge.
+ */
+ProxyTunnelReactor::PumpResult ProxyTunnelReactor::Pump(Tunnel &tunnel, int index)
+{
+    Direction &direction = tunnel.directions[index];
+    int source = tunnel.sockets[index];
+    int destination = tunnel.sockets[DIRECTION_NUM - 1 - index];
+    size_t moved = 0;
+    bool progressed = true;
+    while (progressed) {
+        progressed = false;
+        if (!direction.isEof && direction.pending < direction.capacity) {
+            ssize_t len = splice(source, nullptr, direction.writePipe, nullptr,
+                                 direction.capacity - direction.pending, SPLICE_FLAGS);
+            if (len > 0) {
+                direction.pending += static_cast<size_t>(len);
+                progressed = true;
+            } else if (len == 0) {
+                direction.isEof = true;
+            } else if (errno != EAGAIN && errno != EINTR) {
+                return PumpResult::FAILED;
+            }
+        }
+        if (direction.pending > 0) {
+            ssize_t len = splice(direction.readPipe, nullptr, destination, nullptr, direction.pending, SPLICE_FLAGS);
+            if (len > 0) {
+                direction.pending -= static_cast<size_t>(len);
+                moved += static_cast<size_t>(len);
+                progressed = true;
+            } else if (len < 0 && errno != EAGAIN && errno != EINTR) {
+                return PumpResult::FAILED;
+            }
+        }
+        if (moved >= PUMP_BUDGET_BYTES) {
+            break;
+        }
+    }
+    if (moved > 0) {
+        tunnel.lastActivity = std::chrono::steady_clock::now();
+    }
+    if (direction.isEof && direction.pending == 0 && !direction.isShutdown) {
+        shutdown(destination, SHUT_WR);
+        direction.isShutdown = true;
+    }
+    return moved >= PUMP_BUDGET_BYTES ? PumpResult::BUDGET_SPENT : PumpResult::IDLE;
+}
+
+void ProxyTunnelReactor::CloseTunnel(uint64_t id)
+{
+    auto iter = tunnels_.find(id);
+    if (iter == tunnels_.end()) {
+        return;
+    }
+    Tunnel &tunnel = iter->second;
+    for (int &socket : tunnel.sockets) {
+        if (socket >= 0) {
+            close(socket);
+            socket = -1;
+        }
+    }
+    for (auto &direction : tunnel.directions) {
+        ClosePipe(direction.readPipe, direction.writePipe);
+    }
+    --tunnelCount_;
+    busyTunnels_.erase(id);
+    tunnels_.erase(iter);
+}
+
+void ProxyTunnelReactor::CloseIdleTunnels()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::vector<uint64_t> idleTunnels;
+    for (const auto &[id, tunnel] : tunnels_) {
+        if (now - tunnel.lastActivity > idleTimeout_) {
+            idleTunnels.push_back(id);
+        }
+    }
+    for (uint64_t id : idleTunnels) {
+        NETMGR_LOG_D("Tunnel idle timeout, closing");
+        CloseTunnel(id);
+    }
+}
+
+void ProxyTunnelReactor::CloseAllTunnels()
+{
+    while (!tunnels_.empty()) {
+        CloseTunnel(tunnels_.begin()->first);
+    }
+}
+} // namespace NetManagerStandard
+} // namespace OHOS
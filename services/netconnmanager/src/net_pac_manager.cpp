@@ -13,8 +13,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <string>
+#include <vector>
 #include <curl/curl.h>
 #include <jerryscript.h>
 
@@ -27,35 +30,113 @@ namespace NetManagerStandard {
 namespace {
 constexpr char NULL_CHAR = '\0';
 constexpr const char FIND_FUNC[] = "FindProxyForURL";
+constexpr const char FUNCTION_KEYWORD[] = "function";
 constexpr const char USER_AGENT[] = "libcurl-agent/1.0";
 const std::string TRUE = "true";
 const std::string FALSE = "false";
 const std::string EMPTY = "";
 constexpr int32_t HTTP_CODE_200 = 200;
+constexpr const char ARGUMENTS[] = "arguments";
+constexpr const char SCHEME_SEPARATOR[] = "://";
+constexpr char CACHE_KEY_SEPARATOR = ' ';
+constexpr size_t MAX_PROXY_CACHE_SIZE = 256;
+// bounds how long a decision based on dnsResolve or isInNet may outlive the DNS answer
+constexpr std::chrono::seconds PROXY_CACHE_TTL(60);
+// a script calling any of these gives a different answer over time and is never cached
+const std::vector<std::string> TIME_DEPENDENT_FUNCS = {"weekdayRange", "dateRange", "timeRange", "Date", "random"};
 } // namespace
 
 static std::string g_script;
 
-NetPACManager::NetPACManager() : pacScriptVal_(jerry_create_undefined()), status_(false), engineInitialized_(false)
+static void ReleaseValues(const std::vector<jerry_value_t> &values)
 {
+    for (auto value : values) {
+        jerry_release_value(value);
+    }
 }
 
-NetPACManager::~NetPACManager()
+static bool IsIdentifierChar(char ch)
 {
-    std::lock_guard<std::mutex> guard{pacMutex_};
-    if (jerry_value_is_undefined(pacScriptVal_) == false) {
-        jerry_release_value(pacScriptVal_);
-        pacScriptVal_ = jerry_create_undefined();
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '$';
+}
+
+static size_t CountWord(const std::string &script, const std::string &word)
+{
+    size_t count = 0;
+    for (size_t pos = script.find(word); pos != std::string::npos; pos = script.find(word, pos + word.size())) {
+        size_t end = pos + word.size();
+        bool startsWord = pos == 0 || !IsIdentifierChar(script[pos - 1]);
+        bool endsWord = end == script.size() || !IsIdentifierChar(script[end]);
+        if (startsWord && endsWord) {
+            ++count;
+        }
     }
-    if (engineInitialized_) {
-        jerry_cleanup();
-        engineInitialized_ = false;
+    return count;
+}
+
+static size_t SkipSpaces(const std::string &script, size_t pos)
+{
+    while (pos < script.size() && std::isspace(static_cast<unsigned char>(script[pos]))) {
+        ++pos;
     }
+    return pos;
+}
+
+/*
+ * Name of the first parameter of the "function FindProxyForURL(" declaration. Empty when the script names
+ * FindProxyForURL anywhere else too, e.g. in an assignment, a second declaration or a comment.
+ */
+static std::string GetUrlParamName(const std::string &script)
+{
+    if (CountWord(script, FIND_FUNC) != 1) {
+        return EMPTY;
+    }
+    size_t pos = script.find(FIND_FUNC);
+    size_t keywordEnd = pos;
+    while (keywordEnd > 0 && std::isspace(static_cast<unsigned char>(script[keywordEnd - 1]))) {
+        --keywordEnd;
+    }
+    size_t keywordLen = strlen(FUNCTION_KEYWORD);
+    bool isDeclaration = keywordEnd < pos && keywordEnd >= keywordLen &&
+        script.compare(keywordEnd - keywordLen, keywordLen, FUNCTION_KEYWORD) == 0 &&
+        (keywordEnd == keywordLen || !IsIdentifierChar(script[keywordEnd - keywordLen - 1]));
+    if (!isDeclaration) {
+        return EMPTY;
+    }
+    size_t begin = SkipSpaces(script, pos + strlen(FIND_FUNC));
+    if (begin == script.size() || script[begin] != '(') {
+        return EMPTY;
+    }
+    begin = SkipSpaces(script, begin + 1);
+    size_t end = begin;
+    while (end < script.size() && IsIdentifierChar(script[end])) {
+        ++end;
+    }
+    return script.substr(begin, end - begin);
+}
+
+NetPACManager::NetPACManager()
+    : pacScriptVal_(jerry_create_undefined()),
+      pacFunctionVal_(jerry_create_undefined()),
+      scriptStatus_(PAC_SCRIPT_FUNCTION_ERROR),
+      cacheEnabled_(false),
+      cacheByUrl_(false),
+      status_(false),
+      engineInitialized_(false)
+{
+}
+
+NetPACManager::~NetPACManager()
+{
+    std::lock_guard<std::mutex> guard{pacMutex_};
+    ReleasePACScript();
 }
 
 bool NetPACManager::InitPACScript(const std::string &script)
 {
     ReleasePACScript();
+    ClearProxyCache();
+    AnalyzePACScript(script);
     const char *pac_script = script.c_str();
     jerry_init(JERRY_INIT_EMPTY);
     engineInitialized_ = true;
@@ -69,10 +150,44 @@ bool NetPACManager::InitPACScript(const std::string &script)
         status_ = false;
         return false;
     }
+    scriptStatus_ = RunPACScript();
     status_ = true;
     return true;
 }
 
+PAC_STATUS NetPACManager::RunPACScript()
+{
+    jerry_value_t result = jerry_run(pacScriptVal_);
+    if (jerry_value_is_error(result)) {
+        jerry_value_t error_value = jerry_get_value_from_error(result, false);
+        ReleaseValues({error_value, result});
+        return PAC_SCRIPT_RUN_ERROR;
+    }
+    jerry_value_t global_object = jerry_get_global_object();
+    jerry_value_t func_name = jerry_create_string(reinterpret_cast<const jerry_char_t *>(FIND_FUNC));
+    jerry_value_t func = jerry_get_property(global_object, func_name);
+    ReleaseValues({func_name, global_object, result});
+    if (!jerry_value_is_function(func)) {
+        jerry_release_value(func);
+        return PAC_SCRIPT_FUNCTION_ERROR;
+    }
+    pacFunctionVal_ = func;
+    return PAC_OK;
+}
+
+void NetPACManager::AnalyzePACScript(const std::string &script)
+{
+    bool readsClock = false;
+    for (const auto &func : TIME_DEPENDENT_FUNCS) {
+        readsClock = readsClock || CountWord(script, func) > 0;
+    }
+    std::string urlParam = GetUrlParamName(script);
+    bool readsUrl = urlParam.empty() || CountWord(script, urlParam) > 1 || CountWord(script, ARGUMENTS) > 0;
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    cacheEnabled_ = !readsClock;
+    cacheByUrl_ = readsUrl;
+}
+
 bool NetPACManager::InitPACScriptWithURL(const std::string &scriptUrl)
 {
     std::lock_guard<std::mutex> guard{pacMutex_};
@@ -89,22 +204,75 @@ bool NetPACManager::InitPACScriptWithURL(const std::string &scriptUrl)
 
 void NetPACManager::ReleasePACScript()
 {
+    if (jerry_value_is_undefined(pacFunctionVal_) == false) {
+        jerry_release_value(pacFunctionVal_);
+        pacFunctionVal_ = jerry_create_undefined();
+    }
     if (jerry_value_is_undefined(pacScriptVal_) == false) {
         jerry_release_value(pacScriptVal_);
         pacScriptVal_ = jerry_create_undefined();
     }
+    scriptStatus_ = PAC_SCRIPT_FUNCTION_ERROR;
     if (engineInitialized_) {
         jerry_cleanup();
         engineInitialized_ = false;
     }
 }
 
+std::string NetPACManager::GetCacheKey(const std::string &url, const std::string &host)
+{
+    std::shared_lock<std::shared_mutex> lock(cacheMutex_);
+    if (!cacheEnabled_) {
+        return EMPTY;
+    }
+    if (cacheByUrl_) {
+        return url + CACHE_KEY_SEPARATOR + host;
+    }
+    size_t pos = url.find(SCHEME_SEPARATOR);
+    std::string scheme = pos == std::string::npos ? EMPTY : url.substr(0, pos);
+    std::transform(scheme.begin(), scheme.end(), scheme.begin(), ::tolower);
+    return scheme + CACHE_KEY_SEPARATOR + host;
+}
 
-static void ReleaseValues(const std::vector<jerry_value_t> &values)
+bool NetPACManager::GetCachedProxy(const std::string &key, std::string &proxy)
 {
-    for (auto value : values) {
-        jerry_release_value(value);
+    if (key.empty()) {
+        return false;
+    }
+    std::shared_lock<std::shared_mutex> lock(cacheMutex_);
+    auto it = proxyCache_.find(key);
+    if (it == proxyCache_.end() || it->second.expireTime <= std::chrono::steady_clock::now()) {
+        return false;
     }
+    proxy.append(it->second.proxy);
+    return true;
+}
+
+void NetPACManager::SetCachedProxy(const std::string &key, const std::string &proxy)
+{
+    if (key.empty()) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    auto expireTime = std::chrono::steady_clock::now() + PROXY_CACHE_TTL;
+    auto it = proxyCache_.find(key);
+    if (it != proxyCache_.end()) {
+        it->second = {proxy, expireTime};
+        return;
+    }
+    if (proxyCache_.size() >= MAX_PROXY_CACHE_SIZE) {
+        proxyCache_.erase(cacheOrder_.front());
+        cacheOrder_.pop_front();
+    }
+    proxyCache_.emplace(key, ProxyCacheEntry{proxy, expireTime});
+    cacheOrder_.push_back(key);
+}
+
+void NetPACManager::ClearProxyCache()
+{
+    std::unique_lock<std::shared_mutex> lock(cacheMutex_);
+    proxyCache_.clear();
+    cacheOrder_.clear();
 }
 
 PAC_STATUS NetPACManager::FindProxyForURL(const std::string &url, const std::string &hostStr, std::string &proxy)
@@ -112,28 +280,34 @@ PAC_STATUS NetPACManager::FindProxyForURL(const std::string &url, const std::str
     if (!status_ && !InitPACScriptWithURL(scriptFileUrl_)) {
         return PAC_SCRIPT_DOWNLOAD_ERROR;
     }
+    std::string host = hostStr.empty() ? ParseHost(url) : hostStr;
+    std::string key = GetCacheKey(url, host);
+    if (GetCachedProxy(key, proxy)) {
+        return PAC_OK;
+    }
     std::lock_guard<std::mutex> guard{pacMutex_};
     if (!engineInitialized_ || jerry_value_is_undefined(pacScriptVal_)) {
         return PAC_SCRIPT_FUNCTION_ERROR;
     }
-    std::string host = hostStr.empty() ? ParseHost(url) : hostStr;
-    jerry_value_t result = jerry_run(pacScriptVal_);
-    if (jerry_value_is_error(result)) {
-        jerry_value_t error_value = jerry_get_value_from_error(result, false);
-        jerry_release_value(result);
-        jerry_release_value(error_value);
-        return PAC_SCRIPT_RUN_ERROR;
+    if (scriptStatus_ != PAC_OK) {
+        return scriptStatus_;
     }
-    jerry_value_t global_object = jerry_get_global_object();
-    jerry_value_t func_name = jerry_create_string(reinterpret_cast<const jerry_char_t *>(FIND_FUNC));
-    jerry_value_t func = jerry_get_property(global_object, func_name);
-    if (!jerry_value_is_function(func)) {
-        ReleaseValues({func, func_name, global_object, result});
-        return PAC_SCRIPT_FUNCTION_ERROR;
+    std::string result;
+    PAC_STATUS status = CallFindProxyForURL(url, host, result);
+    if (status == PAC_OK) {
+        SetCachedProxy(key, result);
     }
+    proxy.append(result);
+    return status;
+}
+
+PAC_STATUS NetPACManager::CallFindProxyForURL(const std::string &url, const std::string &host, std::string &proxy)
+{
+    jerry_value_t global_object = jerry_get_global_object();
     jerry_value_t args[2] = {jerry_create_string(reinterpret_cast<const jerry_char_t *>(url.c_str())),
                              jerry_create_string(reinterpret_cast<const jerry_char_t *>(host.c_str()))};
-    jerry_value_t call_result = jerry_call_function(func, global_object, args, 2);
+    PacFunctions::ClearResolveCache();
+    jerry_value_t call_result = jerry_call_function(pacFunctionVal_, global_object, args, 2);
     PAC_STATUS status = PAC_OK;
     if (!jerry_value_is_error(call_result)) {
         if (jerry_value_is_string(call_result)) {
@@ -154,7 +328,7 @@ PAC_STATUS NetPACManager::FindProxyForURL(const std::string &url, const std::str
         jerry_release_value(error_value);
         status = PAC_SCRIPT_CALL_ERROR;
     }
-    ReleaseValues({call_result, args[0], args[1], func, func_name, global_object, result});
+    ReleaseValues({call_result, args[0], args[1], global_object});
     return status;
 }
 
@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "net_probe_event_loop.h"
+
+#include <chrono>
+#include <pthread.h>
+
+#include "net_manager_constants.h"
+#include "net_mgr_log_wrapper.h"
+
+namespace OHOS {
+namespace NetManagerStandard {
+namespace {
+constexpr int PERFORM_POLL_INTERVAL_MS = 50;
+constexpr uint64_t ADDR_CACHE_EXPIRE_MS = 10 * 1000;
+constexpr size_t MAX_ADDR_CACHE_SIZE = 64;
+constexpr size_t MAX_CANCELLED_GROUP_SIZE = 64;
+constexpr const char *PROBE_LOOP_THREAD_NAME = "netProbeLoop";
+
+uint64_t GetSteadyMilliSecond()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+} // namespace
+
+NetProbeEventLoop::ShareContext::~ShareContext()
+{
+    if (share != nullptr) {
+        CURLSHcode code = curl_share_cleanup(share);
+        if (code != CURLSHE_OK) {
+            NETMGR_LOG_E("curl_share_cleanup failed, code:[%{public}d]", code);
+        }
+        share = nullptr;
+    }
+}
+
+NetProbeEventLoop::~NetProbeEventLoop()
+{
+    {
+        std::lock_guard<std::mutex> locker(taskMutex_);
+        isStopping_ = true;
+    }
+    taskCond_.notify_all();
+    if (multi_ != nullptr) {
+        curl_multi_wakeup(multi_);
+    }
+    if (loopThread_.joinable()) {
+        loopThread_.join();
+    }
+    for (auto &task : runningTasks_) {
+        curl_multi_remove_handle(multi_, task.easy);
+    }
+    runningTasks_.clear();
+    if (multi_ != nullptr) {
+        curl_multi_cleanup(multi_);
+        multi_ = nullptr;
+    }
+}
+
+NetProbeEventLoop &NetProbeEventLoop::GetInstance()
+{
+    static NetProbeEventLoop instance;
+    return instance;
+}
+
+uint64_t NetProbeEventLoop::CreateProbeGroup()
+{
+    return ++groupSeq_;
+}
+
+void NetProbeEventLoop::ShareLock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+    auto context = static_cast<ShareContext *>(userptr);
+    if (context == nullptr || data < 0 || data >= CURL_LOCK_DATA_LAST) {
+        return;
+    }
+    context->locks[data].lock();
+}
+
+void NetProbeEventLoop::ShareUnlock(CURL *handle, curl_lock_data data, void *userptr)
+{
+    auto context = static_cast<ShareContext *>(userptr);
+    if (context == nullptr || data < 0 || data >= CURL_LOCK_DATA_LAST) {
+        return;
+    }
+    context->locks[data].unlock();
+}
+
+std::shared_ptr<NetProbeEventLoop::ShareContext> NetProbeEventLoop::GetShareContext(uint32_t netId,
+    const std::string &scope)
+{
+    std::lock_guard<std::mutex> locker(cacheMutex_);
+    auto key = std::make_pair(netId, scope);
+    auto iter = shareContexts_.find(key);
+    if (iter != shareContexts_.end()) {
+        return iter->second;
+    }
+    auto context = std::make_shared<ShareContext>();
+    context->share = curl_share_init();
+    if (context->share == nullptr) {
+        NETMGR_LOG_E("curl_share_init() failed.");
+        return nullptr;
+    }
+    curl_share_setopt(context->share, CURLSHOPT_LOCKFUNC, NetProbeEventLoop::ShareLock);
+    curl_share_setopt(context->share, CURLSHOPT_UNLOCKFUNC, NetProbeEventLoop::ShareUnlock);
+    curl_share_setopt(context->share, CURLSHOPT_USERDATA, context.get());
+    curl_share_setopt(context->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(context->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    shareContexts_[key] = context;
+    return context;
+}
+
+bool NetProbeEventLoop::StartLoop()
+{
+    std::call_once(startFlag_, [this]() {
+        if (curl_global_init(CURL_GLOBAL_ALL) != CURLE_OK) {
+            NETMGR_LOG_E("curl_global_init() failed");
+            return;
+        }
+        multi_ = curl_multi_init();
+        if (multi_ == nullptr) {
+            NETMGR_LOG_E("curl_multi_init() failed.");
+            return;
+        }
+        loopThread_ = std::thread([this]() { Run(); });
+        pthread_setname_np(loopThread_.native_handle(), PROBE_LOOP_THREAD_NAME);
+        isStarted_ = true;
+    });
+    return isStarted_;
+}
+
+int32_t NetProbeEventLoop::AddProbe(CURL *easy, uint32_t netId, const std::string &scope, uint64_t groupId,
+    uint32_t deadlineMs, const ProbeCallback &callback)
+{
+    if (easy == nullptr || callback == nullptr) {
+        NETMGR_LOG_E("Invalid probe handle or callback");
+        return NETMANAGER_ERR_INVALID_PARAMETER;
+    }
+    if (!StartLoop()) {
+        return NETMANAGER_ERR_INTERNAL;
+    }
+    ProbeTask task;
+    task.easy = easy;
+    task.groupId = groupId;
+    task.deadline = GetSteadyMilliSecond() + deadlineMs;
+    task.shareContext = GetShareContext(netId, scope);
+    task.callback = callback;
+    if (task.shareContext != nullptr) {
+        CURLcode code = curl_easy_setopt(easy, CURLOPT_SHARE, task.shareContext->share);
+        if (code != CURLE_OK) {
+            NETMGR_LOG_W("Net[%{public}u] set probe share failed, code:[%{public}d]", netId, code);
+            task.shareContext = nullptr;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> locker(taskMutex_);
+        if (groupId != 0 && cancelledGroups_.count(groupId) != 0) {
+            NETMGR_LOG_I("Probe group[%{public}llu] already decided", static_cast<unsigned long long>(groupId));
+            curl_easy_setopt(easy, CURLOPT_SHARE, nullptr);
+            return NETMANAGER_ERR_OPERATION_FAILED;
+        }
+        pendingTasks_.push_back(std::move(task));
+        probeCount_++;
+    }
+    taskCond_.notify_one();
+    curl_multi_wakeup(multi_);
+    return NETMANAGER_SUCCESS;
+}
+
+void NetProbeEventLoop::CancelProbeGroup(uint64_t groupId)
+{
+    if (groupId == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> locker(taskMutex_);
+    cancelledGroups_.insert(groupId);
+    while (cancelledGroups_.size() > MAX_CANCELLED_GROUP_SIZE) {
+        cancelledGroups_.erase(cancelledGroups_.begin());
+    }
+    isCancelPending_ = true;
+    taskCond_.notify_one();
+    if (isStarted_) {
+        curl_multi_wakeup(multi_);
+    }
+    dispatchCond_.wait(locker, [this, groupId]() { return dispatchingGroup_ != groupId; });
+}
+
+bool NetProbeEventLoop::GetCachedAddrInfo(uint32_t netId, const std::string &domain, std::string &addrList)
+{
+    std::lock_guard<std::mutex> locker(cacheMutex_);
+    auto iter = addrCache_.find(std::make_pair(netId, domain));
+    if (iter == addrCache_.end()) {
+        return false;
+    }
+    if (iter->second.expireTime <= GetSteadyMilliSecond()) {
+        addrCache_.erase(iter);
+        return false;
+    }
+    addrList = iter->second.addrList;
+    return true;
+}
+
+void NetProbeEventLoop::SetCachedAddrInfo(uint32_t netId, const std::string &domain, const std::string &addrList)
+{
+    if (domain.empty() || addrList.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> locker(cacheMutex_);
+    uint64_t now = GetSteadyMilliSecond();
+    if (addrCache_.size() >= MAX_ADDR_CACHE_SIZE) {
+        for (auto iter = addrCache_.begin(); iter != addrCache_.end();) {
+            iter = (iter->second.expireTime <= now) ? addrCache_.erase(iter) : std::next(iter);
+        }
+        if (addrCache_.size() >= MAX_ADDR_CACHE_SIZE) {
+            addrCache_.erase(addrCache_.begin());
+        }
+    }
+    addrCache_[std::make_pair(netId, domain)] = {addrList, now + ADDR_CACHE_EXPIRE_MS};
+}
+
+void NetProbeEventLoop::ReleaseNetwork(uint32_t netId)
+{
+    std::lock_guard<std::mutex> locker(cacheMutex_);
+    for (auto iter = shareContexts_.begin(); iter != shareContexts_.end();) {
+        iter = (iter->first.first == netId) ? shareContexts_.erase(iter) : std::next(iter);
+    }
+    for (auto iter = addrCache_.begin(); iter != addrCache_.end();) {
+        iter = (iter->first.first == netId) ? addrCache_.erase(iter) : std::next(iter);
+    }
+}
+
+uint32_t NetProbeEventLoop::GetProbeCount() const
+{
+    return probeCount_.load();
+}
+
+bool NetProbeEventLoop::HasWork()
+{
+    return !pendingTasks_.empty() || isCancelPending_ || !runningTasks_.empty();
+}
+
+void NetProbeEventLoop::Run()
+{
+    while (true) {
+        {
+            std::unique_lock<std::mutex> locker(taskMutex_);
+            taskCond_.wait(locker, [this]() { return HasWork() || isStopping_; });
+            if (isStopping_) {
+                break;
+            }
+        }
+        ApplyPendingRequests();
+        int running = 0;
+        CURLMcode result = curl_multi_perform(multi_, &running);
+        if (result != CURLM_OK) {
+            NETMGR_LOG_E("curl_multi_perform() error, error code:[%{public}d]", result);
+        }
+        ProcessDoneMessages();
+        ProcessDeadlines();
+        if (result == CURLM_OK && !runningTasks_.empty()) {
+            curl_multi_poll(multi_, nullptr, 0, PERFORM_POLL_INTERVAL_MS, nullptr);
+        }
+    }
+}
+
+void NetProbeEventLoop::ApplyPendingRequests()
+{
+    std::list<ProbeTask> newTasks;
+    std::set<uint64_t> cancelledGroups;
+    bool isCancelPending = false;
+    {
+        std::lock_guard<std::mutex> locker(taskMutex_);
+        newTasks.swap(pendingTasks_);
+        isCancelPending = isCancelPending_;
+        isCancelPending_ = false;
+        cancelledGroups = cancelledGroups_;
+    }
+    while (!newTasks.empty()) {
+        auto iter = newTasks.begin();
+        runningTasks_.splice(runningTasks_.end(), newTasks, iter);
+        if (iter->groupId != 0 && cancelledGroups.count(iter->groupId) != 0) {
+            FinishProbe(iter, CURLE_ABORTED_BY_CALLBACK);
+            continue;
+        }
+        CURLMcode code = curl_multi_add_handle(multi_, iter->easy);
+        if (code != CURLM_OK) {
+            NETMGR_LOG_E("curl multi add handle failed, code:[%{public}d]", code);
+            FinishProbe(iter, CURLE_FAILED_INIT);
+        }
+    }
+    if (!isCancelPending) {
+        return;
+    }
+    for (auto iter = runningTasks_.begin(); iter != runningTasks_.end();) {
+        auto current = iter++;
+        if (current->groupId != 0 && cancelledGroups.count(current->groupId) != 0) {
+            FinishProbe(current, CURLE_ABORTED_BY_CALLBACK);
+        }
+    }
+}
+
+void NetProbeEventLoop::ProcessDoneMessages()
+{
+    CURLMsg *curlMsg = nullptr;
+    int32_t msgQueue = 0;
+    while ((curlMsg = curl_multi_info_read(multi_, &msgQueue)) != nullptr) {
+        if (curlMsg->msg != CURLMSG_DONE || curlMsg->easy_handle == nullptr) {
+            continue;
+        }
+        CURL *easy = curlMsg->easy_handle;
+        CURLcode code = curlMsg->data.result;
+        for (auto iter = runningTasks_.begin(); iter != runningTasks_.end(); ++iter) {
+            if (iter->easy == easy) {
+                FinishProbe(iter, code);
+                break;
+            }
+        }
+    }
+}
+
+void NetProbeEventLoop::ProcessDeadlines()
+{
+    uint64_t now = GetSteadyMilliSecond();
+    for (auto iter = runningTasks_.begin(); iter != runningTasks_.end();) {
+        auto current = iter++;
+        if (current->deadline <= now) {
+            NETMGR_LOG_W("Probe exceeded its deadline, abort it");
+            FinishProbe(current, CURLE_OPERATION_TIMEDOUT);
+        }
+    }
+}
+
+void NetProbeEventLoop::FinishProbe(std::list<ProbeTask>::iterator it, CURLcode code)
+{
+    ProbeTask task = std::move(*it);
+    runningTasks_.erase(it);
+    curl_multi_remove_handle(multi_, task.easy);
+    if (task.shareContext != nullptr) {
+        curl_easy_setopt(task.easy, CURLOPT_SHARE, nullptr);
+    }
+    if (probeCount_ > 0) {
+        probeCount_--;
+    }
+    {
+        std::lock_guard<std::mutex> locker(taskMutex_);
+        /* a transfer that finished after its round was cancelled must not publish a result any more */
+        if (task.groupId != 0 && cancelledGroups_.count(task.groupId) != 0) {
+            code = CURLE_ABORTED_BY_CALLBACK;
+        }
+        dispatchingGroup_ = task.groupId;
+    }
+    task.callback(task.easy, code);
+    {
+        std::lock_guard<std::mutex> locker(taskMutex_);
+        dispatchingGroup_ = 0;
+    }
+    dispatchCond_.notify_all();
+}
+} // namespace NetManagerStandard
+} // namespace OHOS
@@ -62,15 +62,20 @@
 #include <cwchar>
 #include <cwctype>
 
-#include <thread>
- 
 #include <sys/ioctl.h>
  
 #include <ifaddrs.h>
+#include <netinet/icmp6.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
 #include <netinet/ip_icmp.h>
-#include "ffrt.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
-#define TRACE_ROUTE_DATA_SIZE 1024
+#define TRACE_ROUTE_DATA_SIZE 56
+#define TRACE_ROUTE_RECV_SIZE 1500
+#define TRACE_ROUTE_MAX_TTL 255
 #define TIME_BASE_MS 1000
 #define TIME_BASE_US 1000000
 #define PING_NUM 5
@@ -87,8 +92,13 @@ typedef struct IpInfo {
     std::string ip;
     int64_t delay[PING_NUM];
     std::string rtt;
+    long long sendTime[PING_NUM];
+    int32_t replyNum;
 } IpInfo;
 
+/* 同一进程内并发的traceroute使用不同的ICMP id，避免互相抢占回包 */
+static std::atomic<uint16_t> g_traceRouteSeq = 0;
+
 static long long Now(void)
 {
     struct timespec ts;
@@ -124,18 +134,6 @@ unsigned short TraceRouteCkSum(uint16_t *data, int len)
     return answer;
 }
 
-static int WaitResponse(int fd, int flag)
-{
-    struct pollfd pfd;
-    int32_t timeout = 1000;
-    pfd.fd = fd;
-    pfd.events = POLLIN;
-    if (poll(&pfd, 1, timeout) <= 0) {
-        return -1;
-    }
-    return 0;
-}
-
 void ComputeRtt(struct IpInfo &ipinfo)
 {
     // 初始化变量
@@ -184,180 +182,258 @@ std::string GetIPAddress(struct addrinfo *ai)
     return host;
 }
 
-void TimeOutHandle(struct IpInfo &ipinfo, struct addrinfo *ai, int count)
+void TimeOutHandle(struct IpInfo &ipinfo)
 {
-    if (ipinfo.ip == "") {
+    if (ipinfo.replyNum == 0) {
         ipinfo.ip = "*.*.*.*";
-        for (int i = 0; i < PING_NUM; i++) {
+    }
+    for (int i = 0; i < PING_NUM; i++) {
+        if (ipinfo.delay[i] < 0) {
             ipinfo.delay[i] = TIME_BASE_MS;
         }
-        return;
-    }
-    if (count >= PING_NUM) {
-        return;
     }
-    ipinfo.delay[count] = TIME_BASE_MS;
 }
 
-void ReSend(struct IpInfo &ipinfo, int i)
+/* 序号同时编码ttl和该ttl内的探测序号，回包据此定位到具体探测 */
+static inline uint16_t EncodeSequence(int32_t ttl, int32_t index)
+{
+    return static_cast<uint16_t>(ttl * PING_NUM + index);
+}
+
+static bool SendProbes(int sockfd, struct addrinfo *ai, uint16_t id, std::vector<struct IpInfo> &ipinfo)
 {
-    struct addrinfo info = {0};
-    struct addrinfo *ai = nullptr;
-    int family = AF_UNSPEC;
-    info.ai_family = family;
-    const char *dest = ipinfo.ip.c_str();
-    if (getaddrinfo(dest, nullptr, &info, &ai) < 0) {
-        return;
-    }
-    if (ai == nullptr) {
-        return;
-    }
-    int sockfd = socket(ai->ai_family, SOCK_DGRAM, (ai->ai_family == AF_INET) ? IPPROTO_ICMP : IPPROTO_ICMPV6);
-    if (sockfd < 0) {
-        return;
-    }
     unsigned char buffer[sizeof(struct icmphdr) + TRACE_ROUTE_DATA_SIZE] = {0};   /* icmp header and data */
     struct icmphdr *ih = reinterpret_cast<struct icmphdr*>(buffer);
     ih->type = (ai->ai_family == AF_INET) ? ICMP_ECHO_REQUEST : ICMPV6_ECHO_REQUEST;
     ih->code = 0;
-    ih->un.echo.id = getpid();
-    ih->un.echo.sequence = ipinfo.ttl;
-    ih->checksum = 0;
-    ih->checksum = TraceRouteCkSum(reinterpret_cast<uint16_t *>(ih), sizeof(*ih));
-    long long timeSend = Now();
-    if (sendto(sockfd, buffer, sizeof(buffer), 0, ai->ai_addr, sizeof(*(ai->ai_addr))) < 0) {
-        close(sockfd);
-        return;
+    ih->un.echo.id = htons(id);
+    bool isSent = false;
+    for (auto &info : ipinfo) {
+        int ttl = info.ttl;
+        if (setsockopt(sockfd, (ai->ai_family == AF_INET) ? SOL_IP : SOL_IPV6,
+            (ai->ai_family == AF_INET) ? IP_TTL : IPV6_UNICAST_HOPS, &ttl, sizeof(ttl)) < 0) {
+            continue;
+        }
+        for (int i = 0; i < PING_NUM; i++) {
+            ih->un.echo.sequence = htons(EncodeSequence(ttl, i));
+            ih->checksum = 0;
+            ih->checksum = TraceRouteCkSum(reinterpret_cast<uint16_t*>(buffer), sizeof(buffer));
+            info.sendTime[i] = Now();
+            if (sendto(sockfd, buffer, sizeof(buffer), 0, ai->ai_addr, ai->ai_addrlen) < 0) {
+                info.sendTime[i] = -1;
+                continue;
+            }
+            isSent = true;
+        }
     }
-    if (WaitResponse(sockfd, 0) < 0) {
-        TimeOutHandle(ipinfo, ai, i + 1); // 超时处理
-        close(sockfd);
-        return;
+    return isSent;
+}
+
+/*
+ * 解析ICMP回包，匹配本次探测的id并取出序号。
+ * Echo Reply直接携带序号；Time Exceeded和Destination Unreachable则从引用的原始报文中取出。
+ * IPv4原始套接字收到的报文带IP头，IPv6不带。
+ */
+static bool ParseIpv4Reply(const uint8_t *buf, size_t len, uint16_t id, uint16_t &seq, bool &isFinal)
+{
+    if (len < sizeof(struct iphdr)) {
+        return false;
     }
-    struct sockaddr_in srcAddr;
-    socklen_t addrLen = sizeof(srcAddr);
-    char recvBuffer[1024];
-    if (recvfrom(sockfd, recvBuffer, sizeof(recvBuffer), 0,
-        reinterpret_cast<struct sockaddr *>(&srcAddr), &addrLen) <= 0) {
-        close(sockfd);
-        return;
+    size_t ipLen = reinterpret_cast<const struct iphdr *>(buf)->ihl * 4;
+    if (len < ipLen + sizeof(struct icmphdr)) {
+        return false;
     }
-    long long timeRecv = Now() - timeSend;
-    ipinfo.delay[i] = timeRecv; // 记录rtt
-    close(sockfd);
-    return;
+    auto icmp = reinterpret_cast<const struct icmphdr *>(buf + ipLen);
+    if (icmp->type == ICMP_ECHOREPLY) {
+        if (ntohs(icmp->un.echo.id) != id) {
+            return false;
+        }
+        seq = ntohs(icmp->un.echo.sequence);
+        isFinal = true;
+        return true;
+    }
+    if (icmp->type != ICMP_TIME_EXCEEDED && icmp->type != ICMP_DEST_UNREACH) {
+        return false;
+    }
+    const uint8_t *inner = buf + ipLen + sizeof(struct icmphdr);
+    size_t innerLen = len - ipLen - sizeof(struct icmphdr);
+    if (innerLen < sizeof(struct iphdr)) {
+        return false;
+    }
+    auto innerIp = reinterpret_cast<const struct iphdr *>(inner);
+    size_t innerIpLen = innerIp->ihl * 4;
+    if (innerIp->protocol != IPPROTO_ICMP || innerLen < innerIpLen + sizeof(struct icmphdr)) {
+        return false;
+    }
+    auto innerIcmp = reinterpret_cast<const struct icmphdr *>(inner + innerIpLen);
+    if (innerIcmp->type != ICMP_ECHO_REQUEST || ntohs(innerIcmp->un.echo.id) != id) {
+        return false;
+    }
+    seq = ntohs(innerIcmp->un.echo.sequence);
+    isFinal = (icmp->type == ICMP_DEST_UNREACH);
+    return true;
 }
 
-void Send(struct IpInfo &ipinfo)
+static bool ParseIpv6Reply(const uint8_t *buf, size_t len, uint16_t id, uint16_t &seq, bool &isFinal)
 {
-    std::vector<ffrt::task_handle> tasks(PING_NUM - 1);  // 创建ffrt数组
-
-    // 循环创建ffrt
-    for (uint i = 0; i < PING_NUM - 1; ++i) {
-        auto task = ffrt::submit_h([ &, i ]() {
-            ReSend(ipinfo, i);
-        }, {}, {}, {ffrt::task_attr().name(("ReSend" + std::to_string(i)).c_str())});
-        tasks[i] = std::move(task);
+    if (len < sizeof(struct icmp6_hdr)) {
+        return false;
     }
-
-    // 等待所有ffrt完成
-    for (auto& task : tasks) {
-        ffrt::wait({task});  // 等待ffrt结束
+    auto icmp = reinterpret_cast<const struct icmp6_hdr *>(buf);
+    if (icmp->icmp6_type == ICMP6_ECHO_REPLY) {
+        if (ntohs(icmp->icmp6_id) != id) {
+            return false;
+        }
+        seq = ntohs(icmp->icmp6_seq);
+        isFinal = true;
+        return true;
+    }
+    if (icmp->icmp6_type != ICMP6_TIME_EXCEEDED && icmp->icmp6_type != ICMP6_DST_UNREACH) {
+        return false;
+    }
+    size_t offset = sizeof(struct icmp6_hdr);
+    if (len < offset + sizeof(struct ip6_hdr) + sizeof(struct icmp6_hdr)) {
+        return false;
     }
-    ComputeRtt(ipinfo);
-    return;
+    auto innerIp = reinterpret_cast<const struct ip6_hdr *>(buf + offset);
+    if (innerIp->ip6_nxt != IPPROTO_ICMPV6) {
+        return false;
+    }
+    auto innerIcmp = reinterpret_cast<const struct icmp6_hdr *>(buf + offset + sizeof(struct ip6_hdr));
+    if (innerIcmp->icmp6_type != ICMPV6_ECHO_REQUEST || ntohs(innerIcmp->icmp6_id) != id) {
+        return false;
+    }
+    seq = ntohs(innerIcmp->icmp6_seq);
+    isFinal = (icmp->icmp6_type == ICMP6_DST_UNREACH);
+    return true;
 }
 
-void CreateTasks(std::vector<struct IpInfo> &ipinfo)
+static bool IsTraceRouteDone(const std::vector<struct IpInfo> &ipinfo, int32_t finalTtl)
 {
-    std::vector<ffrt::task_handle> tasks(ipinfo.size());  // 创建ffrt数组
-    for (uint i = 0; i < ipinfo.size(); ++i) {
-        if (ipinfo[i].ip == "*.*.*.*") {
-            continue;
+    if (finalTtl <= 0) {
+        return false;
+    }
+    for (const auto &info : ipinfo) {
+        if (info.ttl > finalTtl) {
+            break;
+        }
+        for (int i = 0; i < PING_NUM; i++) {
+            if (info.sendTime[i] >= 0 && info.delay[i] < 0) {
+                return false;
+            }
         }
-        struct IpInfo &info = ipinfo[i];
-        auto task = ffrt::submit_h([ & ]() { Send(info); },
-            {}, {}, {ffrt::task_attr().name(("Send" + std::to_string(i)).c_str())});
-        tasks[i] = std::move(task);
     }
-    for (auto& task : tasks) {
-        ffrt::wait({task});  // 等待ffrt结束
+    return true;
+}
+
+static void RecordReply(std::vector<struct IpInfo> &ipinfo, uint16_t seq, bool isFinal,
+    const std::string &srcIp, long long timeRecv, int32_t &finalTtl)
+{
+    int32_t ttl = seq / PING_NUM;
+    int32_t index = seq % PING_NUM;
+    if (ttl < 1 || ttl > static_cast<int32_t>(ipinfo.size())) {
+        return;
+    }
+    struct IpInfo &info = ipinfo[ttl - 1];
+    if (info.sendTime[index] < 0 || info.delay[index] >= 0) {
+        return;
+    }
+    info.delay[index] = timeRecv - info.sendTime[index]; // 记录rtt
+    if (info.replyNum++ == 0) {
+        info.ip = srcIp; // 记录首个回包的源地址
+    }
+    if (isFinal && (finalTtl <= 0 || ttl < finalTtl)) {
+        finalTtl = ttl;
     }
 }
 
-void recv(struct IpInfo &info, std::vector<struct IpInfo> &ipinfo, int sockfd, long long timeSend, int family)
+static void RecvReplies(int sockfd, int family, uint16_t id, std::vector<struct IpInfo> &ipinfo,
+    int32_t &finalTtl)
 {
-    char recvBuffer[1024];
-    if (family == AF_INET) {
-        struct sockaddr_in srcAddr;
-        socklen_t addrLen = sizeof(srcAddr);
-        ssize_t received = recvfrom(sockfd, recvBuffer, sizeof(recvBuffer), 0,
-            reinterpret_cast<struct sockaddr*>(&srcAddr), &addrLen);
-        char srcIp[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &(srcAddr.sin_addr), srcIp, INET_ADDRSTRLEN);
-        info.ip = std::string(srcIp); // 记录IP地址
-    } else if (family == AF_INET6) {
-        struct sockaddr_in6 srcAddr;
-        socklen_t addrLen = sizeof(srcAddr);
-        ssize_t received = recvfrom(sockfd, recvBuffer, sizeof(recvBuffer), 0,
-            reinterpret_cast<struct sockaddr*>(&srcAddr), &addrLen);
-        char srcIp[INET6_ADDRSTRLEN];
-        inet_ntop(AF_INET6, &(srcAddr.sin6_addr), srcIp, INET6_ADDRSTRLEN);
-        info.ip = std::string(srcIp); // 记录IPV6地址
-    }
-    long long timeRecv = Now() - timeSend;
-    info.delay[0] = timeRecv;
-    ipinfo.push_back(info); // 将info对象添加到vector中
+    uint8_t recvBuffer[TRACE_ROUTE_RECV_SIZE];
+    long long deadline = Now() + TIME_BASE_MS;
+    while (!IsTraceRouteDone(ipinfo, finalTtl)) {
+        long long timeout = deadline - Now();
+        if (timeout <= 0) {
+            break;
+        }
+        struct pollfd pfd = {.fd = sockfd, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, static_cast<int>(timeout)) <= 0) {
+            continue;
+        }
+        // 一次唤醒尽量收完所有已到达的回包
+        while (true) {
+            struct sockaddr_storage srcAddr;
+            socklen_t addrLen = sizeof(srcAddr);
+            ssize_t received = recvfrom(sockfd, recvBuffer, sizeof(recvBuffer), MSG_DONTWAIT,
+                reinterpret_cast<struct sockaddr *>(&srcAddr), &addrLen);
+            if (received <= 0) {
+                break;
+            }
+            long long timeRecv = Now();
+            uint16_t seq = 0;
+            bool isFinal = false;
+            bool isMatched = (family == AF_INET) ?
+                ParseIpv4Reply(recvBuffer, static_cast<size_t>(received), id, seq, isFinal) :
+                ParseIpv6Reply(recvBuffer, static_cast<size_t>(received), id, seq, isFinal);
+            if (!isMatched) {
+                continue;
+            }
+            char srcIp[INET6_ADDRSTRLEN] = {0};
+            if (family == AF_INET) {
+                inet_ntop(AF_INET, &reinterpret_cast<struct sockaddr_in *>(&srcAddr)->sin_addr, srcIp, sizeof(srcIp));
+            } else {
+                inet_ntop(AF_INET6, &reinterpret_cast<struct sockaddr_in6 *>(&srcAddr)->sin6_addr, srcIp,
+                    sizeof(srcIp));
+            }
+            RecordReply(ipinfo, seq, isFinal, srcIp, timeRecv, finalTtl);
+        }
+    }
 }
 
+/*
+ * 所有ttl的探测(每跳PING_NUM个)一次性发出，回包按id和序号归位，
+ * 目的地址应答且更近的跳全部应答后即提前结束，整体最多等待TIME_BASE_MS。
+ */
 static int doTraceRoute(struct addrinfo *ai, int32_t maxJumpNumber, int32_t packetsType, std::string &traceRouteInfo)
 {
-    std::vector<struct IpInfo> ipinfo;
+    if (maxJumpNumber <= 0) {
+        return 0;
+    }
+    maxJumpNumber = std::min(maxJumpNumber, TRACE_ROUTE_MAX_TTL);
     int sockfd = socket(ai->ai_family, SOCK_RAW, (ai->ai_family == AF_INET) ? IPPROTO_ICMP : IPPROTO_ICMPV6);
     if (sockfd < 0) {
         return 0;
     }
-    int32_t count = 0;
+    std::vector<struct IpInfo> ipinfo(maxJumpNumber);
     for (int32_t ttl = 1; ttl <= maxJumpNumber; ttl++) {
-        struct IpInfo info; // 每次循环创建一个IpInfo对象
+        struct IpInfo &info = ipinfo[ttl - 1];
         info.ttl = ttl;
-        unsigned char buffer[sizeof(struct icmphdr) + TRACE_ROUTE_DATA_SIZE] = {0};   /* icmp header and data */
-        struct icmphdr *ih = reinterpret_cast<struct icmphdr*>(buffer);
-        ih->type = (ai->ai_family == AF_INET) ? ICMP_ECHO_REQUEST : ICMPV6_ECHO_REQUEST;
-        ih->code = 0;
-        ih->un.echo.id = getpid();
-        ih->un.echo.sequence = ttl;
-        setsockopt(sockfd, (ai->ai_family == AF_INET) ? SOL_IP : SOL_IPV6,
-            (ai->ai_family == AF_INET) ? IP_TTL : IPV6_UNICAST_HOPS, &ttl, sizeof(ttl));
-        ih->checksum = 0;
-        ih->checksum = TraceRouteCkSum(reinterpret_cast<uint16_t*>(buffer), sizeof(buffer));
-        long long timeSend = Now();
-        ssize_t sent = sendto(sockfd, buffer, sizeof(buffer), 0,
-            ai->ai_addr, ai->ai_addrlen);
-        if (sent < 0) {
-            continue;
+        info.replyNum = 0;
+        for (int i = 0; i < PING_NUM; i++) {
+            info.delay[i] = -1;
+            info.sendTime[i] = -1;
         }
-        int rc = WaitResponse(sockfd, 0);
-        if (rc < 0) {
+    }
+    uint16_t id = static_cast<uint16_t>(getpid() + g_traceRouteSeq++);
+    int32_t finalTtl = 0;
+    if (SendProbes(sockfd, ai, id, ipinfo)) {
+        RecvReplies(sockfd, ai->ai_family, id, ipinfo, finalTtl);
+    }
+    close(sockfd);
+
+    int32_t count = 0;
+    for (auto &info : ipinfo) {
+        if (info.replyNum == 0) {
             count++;
-            TimeOutHandle(info, ai, 0); // 超时处理
-            ComputeRtt(info);
-            ipinfo.push_back(info); // 将info对象添加到vector中
-            if (count >= PING_TIMEOUT_NUM) { // 3跳超时，直接break
-                break;
-            }
-            continue;
         }
-        recv(info, ipinfo, sockfd, timeSend, ai->ai_family);
-        if (info.ip == GetIPAddress(ai)) {
+        TimeOutHandle(info); // 超时处理
+        ComputeRtt(info);
+        traceRouteInfo += std::to_string(info.ttl) + " " + info.ip + " " + info.rtt;
+        if (info.ttl == finalTtl || count >= PING_TIMEOUT_NUM) { // 到达目的地址或3跳超时，直接break
             break;
         }
     }
-    CreateTasks(ipinfo);
-    close(sockfd);
-    for (uint i = 0; i < ipinfo.size(); ++i) {
-        traceRouteInfo += std::to_string(ipinfo[i].ttl) + " " + ipinfo[i].ip + " " + ipinfo[i].rtt;
-    }
     return 0;
 }
 
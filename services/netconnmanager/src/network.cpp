@@ -21,6 +21,7 @@
 #include "net_conn_service_iface.h"
 #include "net_manager_constants.h"
 #include "net_mgr_log_wrapper.h"
+#include "net_probe_event_loop.h"
 #include "net_stats_client.h"
 #include "netmanager_base_common_utils.h"
 #include "netsys_controller.h"
@@ -220,6 +221,7 @@ bool Network::ReleaseBasicNetwork()
     NetsysController::GetInstance().NetworkRemoveInterface(netId_, netLinkInfoBck.ifaceName_);
     NetsysController::GetInstance().NetworkDestroy(netId_);
     NetsysController::GetInstance().DestroyNetworkCache(netId_);
+    NetProbeEventLoop::GetInstance().ReleaseNetwork(netId_);
     std::unique_lock<std::shared_mutex> wlock(netLinkInfoMutex_);
     netLinkInfo_.Initialize();
     isPhyNetCreated_ = false;
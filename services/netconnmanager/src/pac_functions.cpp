@@ -14,6 +14,7 @@
  */
 
 #include <map>
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cctype>
 #include <cstddef>
@@ -25,6 +26,9 @@
 #include <netdb.h>
 #include <string>
 #include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <securec.h>
 
 #include "pac_functions.h"
 
@@ -71,8 +75,31 @@ constexpr const char *MONTH_NAMES[] = {"JAN", "FEB", "MAR", "APR", "MAY", "JUN",
 constexpr size_t MONTH_COUNT = std::size(MONTH_NAMES);
 constexpr const char *DAY_NAMES[] = {"SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT"};
 constexpr size_t DAY_COUNT = std::size(DAY_NAMES);
+constexpr int IPV4_BITS = 32;
+constexpr int IPV6_BITS = 128;
+constexpr int BITS_PER_BYTE = 8;
+constexpr size_t MAX_PARSED_CACHE_SIZE = 1024;
+constexpr char NET_MASK_SEPARATOR = '/';
 using Checker = std::function<bool(const jerry_length_t argsCnt, const jerry_value_t args[])>;
 using Handler = std::function<jerry_value_t(const jerry_value_t args[], struct tm *timeinfo)>;
+
+/* shExpMatch pattern split at '*', each segment may still contain '?' */
+struct ShExpPattern {
+    std::vector<std::string> segments;
+    bool hasStar = false;
+};
+
+struct ParsedNet {
+    bool valid = false;
+    bool isIpv6 = false;
+    uint8_t addr[sizeof(in6_addr)] = {0};
+    uint8_t mask[sizeof(in6_addr)] = {0};
+};
+
+/* The engine runs one script at a time, so these are only touched from one thread at a time */
+std::unordered_map<std::string, std::string> g_resolveMemo;
+std::unordered_map<std::string, ShExpPattern> g_patternCache;
+std::unordered_map<std::string, ParsedNet> g_netCache;
 } // namespace
 
 static const jerry_char_t *JERRY_CONCHAR(const char *str)
@@ -104,6 +131,53 @@ static jerry_value_t CreateJerryString(const char *str)
     return jerry_create_string(reinterpret_cast<const jerry_char_t *>(str));
 }
 
+static bool JerryStringToStd(jerry_value_t strVal, std::string &str)
+{
+    if (!jerry_value_is_string(strVal)) {
+        return false;
+    }
+    jerry_size_t strSize = jerry_get_string_size(strVal);
+    str.resize(strSize);
+    jerry_string_to_char_buffer(strVal, JERRY_CHAR(str.data()), strSize);
+    return true;
+}
+
+/* Resolves to the first IPv4 address, each host is looked up at most once per FindProxyForURL call */
+static bool ResolveHost(const std::string &host, std::string &ip)
+{
+    auto it = g_resolveMemo.find(host);
+    if (it == g_resolveMemo.end()) {
+        struct addrinfo hints;
+        explicit_bzero(&hints, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo *res = nullptr;
+        char ipStr[INET_ADDRSTRLEN] = {0};
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &res) == 0 && res != nullptr) {
+            inet_ntop(AF_INET, &(reinterpret_cast<sockaddr_in *>(res->ai_addr)->sin_addr), ipStr, INET_ADDRSTRLEN);
+        }
+        if (res != nullptr) {
+            freeaddrinfo(res);
+        }
+        it = g_resolveMemo.emplace(host, ipStr).first;
+    }
+    ip = it->second;
+    return !ip.empty();
+}
+
+template <typename T>
+static void TrimParsedCache(std::unordered_map<std::string, T> &cache)
+{
+    if (cache.size() >= MAX_PARSED_CACHE_SIZE) {
+        cache.clear();
+    }
+}
+
+void PacFunctions::ClearResolveCache(void)
+{
+    g_resolveMemo.clear();
+}
+
 jerry_value_t PacFunctions::JsIsPlainHostname(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
     const jerry_value_t args[], const jerry_length_t argsCnt)
 {
@@ -199,15 +273,9 @@ jerry_value_t PacFunctions::JsIsResolvable(const jerry_value_t funcObjVal, const
     if (argsCnt < ARG_COUNT_1 || !jerry_value_is_string(args[ARG_INDEX_0])) {
         return jerry_create_boolean(false);
     }
-    char *host = JerryStringToChar(args[ARG_INDEX_0]);
-    if (host) {
-        struct hostent *he = gethostbyname(host);
-        bool result = (he != nullptr);
-        free(host);
-        return jerry_create_boolean(result);
-    } else {
-        return jerry_create_boolean(false);
-    }
+    std::string host;
+    std::string ip;
+    return jerry_create_boolean(JerryStringToStd(args[ARG_INDEX_0], host) && ResolveHost(host, ip));
 }
 
 jerry_value_t PacFunctions::JsMyIpAddress(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
@@ -217,13 +285,11 @@ jerry_value_t PacFunctions::JsMyIpAddress(const jerry_value_t funcObjVal, const
     if (gethostname(hostname, sizeof(hostname)) != 0) {
         return CreateJerryString(DEFAULT_URL);
     }
-    struct hostent *he = gethostbyname(hostname);
-    if (!he || he->h_addr_list[0] == nullptr) {
+    std::string ip;
+    if (!ResolveHost(hostname, ip)) {
         return CreateJerryString(DEFAULT_URL);
     }
-    char ip[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, he->h_addr_list[0], ip, sizeof(ip));
-    return CreateJerryString(ip);
+    return CreateJerryString(ip.c_str());
 }
 
 jerry_value_t PacFunctions::JsMyIpAddressEx(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
@@ -275,31 +341,88 @@ jerry_value_t PacFunctions::JsMyIpAddressEx(const jerry_value_t funcObjVal, cons
     return CreateJerryString(ipList.c_str());
 }
 
+static bool MatchNet(const uint8_t *addr, size_t len, const ParsedNet &net)
+{
+    for (size_t i = 0; i < len; ++i) {
+        if ((addr[i] & net.mask[i]) != net.addr[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void FillPrefixMask(ParsedNet &net, int prefixLen)
+{
+    for (size_t i = 0; i < sizeof(net.mask); ++i) {
+        int bits = std::min(std::max(prefixLen - static_cast<int>(i) * BITS_PER_BYTE, 0), BITS_PER_BYTE);
+        net.mask[i] = bits == 0 ? 0 : static_cast<uint8_t>(0xff << (BITS_PER_BYTE - bits));
+        net.addr[i] &= net.mask[i];
+    }
+}
+
+/* isInNet(host, "10.0.0.0", "255.0.0.0"), the network and mask pair is parsed once */
+static const ParsedNet &ParseIpv4Net(const std::string &net, const std::string &mask)
+{
+    std::string key = net + NET_MASK_SEPARATOR + mask;
+    auto it = g_netCache.find(key);
+    if (it != g_netCache.end()) {
+        return it->second;
+    }
+    TrimParsedCache(g_netCache);
+    ParsedNet parsed;
+    struct in_addr netAddr;
+    struct in_addr maskAddr;
+    if (inet_pton(AF_INET, net.c_str(), &netAddr) == 1 && inet_pton(AF_INET, mask.c_str(), &maskAddr) == 1) {
+        parsed.valid = memcpy_s(parsed.mask, sizeof(parsed.mask), &maskAddr, sizeof(maskAddr)) == EOK &&
+            memcpy_s(parsed.addr, sizeof(parsed.addr), &netAddr, sizeof(netAddr)) == EOK;
+        for (size_t i = 0; i < sizeof(netAddr); ++i) {
+            parsed.addr[i] &= parsed.mask[i];
+        }
+    }
+    return g_netCache.emplace(std::move(key), parsed).first->second;
+}
+
+/* isInNetEx(host, "fd00::/8"), the CIDR string is parsed once */
+static const ParsedNet &ParseCidr(const std::string &cidr)
+{
+    auto it = g_netCache.find(cidr);
+    if (it != g_netCache.end()) {
+        return it->second;
+    }
+    TrimParsedCache(g_netCache);
+    ParsedNet parsed;
+    size_t slash = cidr.find(PATH_CHAR);
+    if (slash != std::string::npos) {
+        std::string addr = cidr.substr(0, slash);
+        int prefixLen = atoi(cidr.c_str() + slash + 1);
+        parsed.isIpv6 = addr.find(COLON_CHAR) != std::string::npos;
+        int maxBits = parsed.isIpv6 ? IPV6_BITS : IPV4_BITS;
+        parsed.valid = prefixLen >= 0 && prefixLen <= maxBits &&
+            inet_pton(parsed.isIpv6 ? AF_INET6 : AF_INET, addr.c_str(), parsed.addr) == 1;
+        FillPrefixMask(parsed, prefixLen);
+    }
+    return g_netCache.emplace(cidr, parsed).first->second;
+}
+
 jerry_value_t PacFunctions::JsIsInNet(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
     const jerry_value_t args[], const jerry_length_t argsCnt)
 {
     if (argsCnt < ARG_COUNT_3) {
         return jerry_create_boolean(false);
     }
-    char *ip = JerryStringToChar(args[ARG_INDEX_0]);
-    char *net = JerryStringToChar(args[ARG_INDEX_1]);
-    char *mask = JerryStringToChar(args[ARG_INDEX_2]);
-    if (ip && net && mask) {
-        struct in_addr ipAddr;
-        struct in_addr netAddr;
-        struct in_addr maskAddr;
-        bool result = false;
-        if (inet_pton(AF_INET, ip, &ipAddr) == 1 && inet_pton(AF_INET, net, &netAddr) == 1 &&
-            inet_pton(AF_INET, mask, &maskAddr) == 1) {
-            result = ((ipAddr.s_addr & maskAddr.s_addr) == (netAddr.s_addr & maskAddr.s_addr));
-        }
-        free(ip);
-        free(net);
-        free(mask);
-        return jerry_create_boolean(result);
-    } else {
+    std::string ip;
+    std::string net;
+    std::string mask;
+    if (!JerryStringToStd(args[ARG_INDEX_0], ip) || !JerryStringToStd(args[ARG_INDEX_1], net) ||
+        !JerryStringToStd(args[ARG_INDEX_2], mask)) {
+        return jerry_create_boolean(false);
+    }
+    const ParsedNet &parsed = ParseIpv4Net(net, mask);
+    struct in_addr ipAddr;
+    if (!parsed.valid || inet_pton(AF_INET, ip.c_str(), &ipAddr) != 1) {
         return jerry_create_boolean(false);
     }
+    return jerry_create_boolean(MatchNet(reinterpret_cast<const uint8_t *>(&ipAddr), sizeof(ipAddr), parsed));
 }
 
 jerry_value_t PacFunctions::JsSortIpAddressList(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
@@ -317,57 +440,70 @@ jerry_value_t PacFunctions::JsDnsResolve(const jerry_value_t funcObjVal, const j
     if (!jerry_value_is_string(args[ARG_INDEX_0])) {
         return jerry_create_error(JERRY_ERROR_TYPE, JERRY_CONCHAR(INVALID_ARGUMENT));
     }
-    jerry_size_t host_size = jerry_get_string_size(args[ARG_INDEX_0]);
-    if (host_size < 0) {
-        return jerry_create_boolean(false);
-    }
-    char *host = (char *)malloc(host_size + 1);
-    if (host == nullptr) {
-        return jerry_create_error(JERRY_ERROR_COMMON, JERRY_CONCHAR(MEMORY_ALLOCATION_FAILED));
-    }
-    jerry_string_to_char_buffer(args[ARG_INDEX_0], JERRY_CHAR(host), host_size);
-    host[host_size] = NULL_CHAR;
-    struct addrinfo hints;
-    explicit_bzero(&hints, sizeof(hints));
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    struct addrinfo *res = nullptr;
-    int status = getaddrinfo(host, nullptr, &hints, &res);
-    free(host);
-    if (status != 0 || res == nullptr) {
-        char empty[] = "";
-        return jerry_create_string_sz(JERRY_CHAR(empty), 0);
-    }
-    struct sockaddr_in *ipv4 = reinterpret_cast<sockaddr_in *>(res->ai_addr);
-    char ipStr[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &(ipv4->sin_addr), ipStr, INET_ADDRSTRLEN);
-    freeaddrinfo(res);
-    return jerry_create_string_sz(JERRY_CHAR(ipStr), strlen(ipStr));
+    std::string host;
+    std::string ip;
+    JerryStringToStd(args[ARG_INDEX_0], host);
+    ResolveHost(host, ip);
+    return jerry_create_string_sz(JERRY_CONCHAR(ip.c_str()), ip.size());
 }
 
-static int MatchPattern(const char *str, const char *pattern)
+static const ShExpPattern &CompilePattern(const std::string &pattern)
 {
-    if (pattern[0] == NULL_CHAR) {
-        return str[0] == NULL_CHAR;
-    }
-    if (*pattern == ASTERISK_CHAR) {
-        pattern++;
-        for (const char *s = str;; s++) {
-            if (MatchPattern(s, pattern)) {
-                return true;
-            }
-            if (*s == NULL_CHAR) {
-                return false;
-            }
+    auto it = g_patternCache.find(pattern);
+    if (it != g_patternCache.end()) {
+        return it->second;
+    }
+    TrimParsedCache(g_patternCache);
+    ShExpPattern compiled;
+    size_t start = 0;
+    for (size_t star = pattern.find(ASTERISK_CHAR); star != std::string::npos;
+         star = pattern.find(ASTERISK_CHAR, start)) {
+        compiled.segments.push_back(pattern.substr(start, star - start));
+        compiled.hasStar = true;
+        start = star + 1;
+    }
+    compiled.segments.push_back(pattern.substr(start));
+    return g_patternCache.emplace(pattern, std::move(compiled)).first->second;
+}
+
+static bool MatchSegmentAt(const std::string &str, size_t pos, const std::string &segment)
+{
+    for (size_t i = 0; i < segment.size(); ++i) {
+        if (segment[i] != QUESTION_CHAR && segment[i] != str[pos + i]) {
+            return false;
         }
     }
-    if (*str == NULL_CHAR) {
+    return true;
+}
+
+/*
+ * The first segment is anchored at the start and the last one at the end, every middle segment is taken at its
+ * leftmost match. A later segment never needs an earlier one to move, so no position is tried twice per segment.
+ */
+static bool MatchPattern(const std::string &str, const ShExpPattern &pattern)
+{
+    const std::string &first = pattern.segments.front();
+    if (!pattern.hasStar) {
+        return str.size() == first.size() && MatchSegmentAt(str, 0, first);
+    }
+    const std::string &last = pattern.segments.back();
+    if (first.size() + last.size() > str.size() || !MatchSegmentAt(str, 0, first) ||
+        !MatchSegmentAt(str, str.size() - last.size(), last)) {
         return false;
     }
-    if (*pattern == QUESTION_CHAR || *pattern == *str) {
-        return MatchPattern(str + 1, pattern + 1);
+    size_t pos = first.size();
+    size_t end = str.size() - last.size();
+    for (size_t i = 1; i + 1 < pattern.segments.size(); ++i) {
+        const std::string &segment = pattern.segments[i];
+        while (pos + segment.size() <= end && !MatchSegmentAt(str, pos, segment)) {
+            ++pos;
+        }
+        if (pos + segment.size() > end) {
+            return false;
+        }
+        pos += segment.size();
     }
-    return false;
+    return true;
 }
 
 jerry_value_t PacFunctions::JsDnsDomainLevels(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
@@ -408,32 +544,11 @@ jerry_value_t PacFunctions::JsShExpMatch(const jerry_value_t funcObjVal, const j
     if (!jerry_value_is_string(args[ARG_INDEX_0]) || !jerry_value_is_string(args[ARG_INDEX_1])) {
         return jerry_create_error(JERRY_ERROR_TYPE, JERRY_CONCHAR(INVALID_ARGUMENT));
     }
-    jerry_size_t str_size = jerry_get_string_size(args[ARG_INDEX_0]);
-    jerry_size_t pattern_size = jerry_get_string_size(args[ARG_INDEX_1]);
-    if (str_size < 0) {
-        return jerry_create_error(JERRY_ERROR_COMMON, JERRY_CONCHAR(INVALID_ARGUMENT));
-    }
-    char *str = (char *)malloc(str_size + 1);
-    if (str == nullptr) {
-        return jerry_create_error(JERRY_ERROR_COMMON, JERRY_CONCHAR(MEMORY_ALLOCATION_FAILED));
-    }
-    if (pattern_size < 0) {
-        free(str);
-        return jerry_create_error(JERRY_ERROR_COMMON, JERRY_CONCHAR(INVALID_ARGUMENT));
-    }
-    char *pattern = (char *)malloc(pattern_size + 1);
-    if (pattern == nullptr) {
-        free(str);
-        return jerry_create_error(JERRY_ERROR_COMMON, JERRY_CONCHAR(MEMORY_ALLOCATION_FAILED));
-    }
-    jerry_string_to_char_buffer(args[ARG_INDEX_0], JERRY_CHAR(str), str_size);
-    jerry_string_to_char_buffer(args[ARG_INDEX_1], JERRY_CHAR(pattern), pattern_size);
-    str[str_size] = NULL_CHAR;
-    pattern[pattern_size] = NULL_CHAR;
-    int result = MatchPattern(str, pattern);
-    free(str);
-    free(pattern);
-    return jerry_create_boolean(result);
+    std::string str;
+    std::string pattern;
+    JerryStringToStd(args[ARG_INDEX_0], str);
+    JerryStringToStd(args[ARG_INDEX_1], pattern);
+    return jerry_create_boolean(MatchPattern(str, CompilePattern(pattern)));
 }
 
 static int MonthAbbrToNumber(const char *abbr)
@@ -915,74 +1030,30 @@ jerry_value_t PacFunctions::JsWeekdayRange(const jerry_value_t funcObjVal, const
     return jerry_create_boolean(inRange);
 }
 
-static bool CheckIpv4InNet(const char *ip, const char *cidr, int prefixLen)
-{
-    const int ipv4Bits = 32;
-    struct in_addr ip4;
-    struct in_addr net4;
-    if (inet_pton(AF_INET, ip, &ip4) != 1 || inet_pton(AF_INET, cidr, &net4) != 1) {
-        return false;
-    }
-    if (prefixLen < 0 || prefixLen > ipv4Bits) {
-        return false;
-    }
-    uint32_t mask;
-    if (prefixLen == 0) {
-        mask = 0x00000000;
-    } else if (prefixLen == ipv4Bits) {
-        mask = 0xffffffff;
-    } else {
-        mask = ~((1U << (ipv4Bits - prefixLen)) - 1);
-    }
-    return (ip4.s_addr & htonl(mask)) == (net4.s_addr & htonl(mask));
-}
-
-static bool CheckIpv6InNet(const char *ip, const char *cidr, int prefixLen)
-{
-    struct in6_addr ipAddr;
-    struct in6_addr netAddr;
-    if (inet_pton(AF_INET6, ip, &ipAddr) != 1 || inet_pton(AF_INET6, cidr, &netAddr) != 1) {
-        return false;
-    }
-    int bytes = prefixLen / 8;
-    int bits = prefixLen % 8;
-    for (int i = 0; i < bytes; i++) {
-        if (ipAddr.s6_addr[i] != netAddr.s6_addr[i]) {
-            return false;
-        }
-    }
-    if (bits > 0) {
-        uint8_t mask = 0xff << (8 - bits);
-        return (ipAddr.s6_addr[bytes] & mask) == (netAddr.s6_addr[bytes] & mask);
-    }
-    return true;
-}
-
 jerry_value_t PacFunctions::JsIsInNetEx(const jerry_value_t funcObjVal, const jerry_value_t thisVal,
     const jerry_value_t args[], const jerry_length_t argsCnt)
 {
     if (argsCnt < ARG_COUNT_2) {
         return jerry_create_boolean(false);
     }
-    char *ip = JerryStringToChar(args[ARG_INDEX_0]);
-    char *cidr = JerryStringToChar(args[ARG_INDEX_1]);
-    if (!ip || !cidr) {
-        free(ip);
-        free(cidr);
+    std::string ip;
+    std::string cidr;
+    if (!JerryStringToStd(args[ARG_INDEX_0], ip) || !JerryStringToStd(args[ARG_INDEX_1], cidr)) {
         return jerry_create_boolean(false);
     }
-    char *slash = strchr(cidr, PATH_CHAR);
-    if (!slash) {
-        free(ip);
-        free(cidr);
+    const ParsedNet &parsed = ParseCidr(cidr);
+    if (!parsed.valid) {
         return jerry_create_boolean(false);
     }
-    *slash = NULL_CHAR;
-    int prefixLen = atoi(slash + 1);
-    bool isIpv4 = (strchr(ip, COLON_CHAR) == nullptr && strchr(cidr, COLON_CHAR) == nullptr);
-    bool result = isIpv4 ? CheckIpv4InNet(ip, cidr, prefixLen) : CheckIpv6InNet(ip, cidr, prefixLen);
-    free(ip);
-    free(cidr);
+    if (parsed.isIpv6 || ip.find(COLON_CHAR) != std::string::npos) {
+        struct in6_addr ipAddr;
+        bool result = parsed.isIpv6 && inet_pton(AF_INET6, ip.c_str(), &ipAddr) == 1 &&
+            MatchNet(ipAddr.s6_addr, sizeof(ipAddr.s6_addr), parsed);
+        return jerry_create_boolean(result);
+    }
+    struct in_addr ipAddr;
+    bool result = inet_pton(AF_INET, ip.c_str(), &ipAddr) == 1 &&
+        MatchNet(reinterpret_cast<const uint8_t *>(&ipAddr), sizeof(ipAddr), parsed);
     return jerry_create_boolean(result);
 }
 
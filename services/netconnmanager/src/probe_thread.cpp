@@ -31,6 +31,7 @@
 #include "probe_thread.h"
 #include "dns_config_client.h"
 #include "event_report.h"
+#include "ffrt.h"
 #include "fwmark_client.h"
 #include "netmanager_base_common_utils.h"
 #include "netsys_controller.h"
@@ -41,16 +42,6 @@
 namespace OHOS {
 namespace NetManagerStandard {
 
-static void NetProbeThread(const std::shared_ptr<ProbeThread> &probeThread)
-{
-    if (probeThread == nullptr) {
-        NETMGR_LOG_E("probeThread is nullptr");
-        return;
-    }
-    ProbeType type = probeThread->GetProbeType();
-    probeThread->SendHttpProbe(type);
-}
-
 ProbeThread::ProbeThread(uint32_t netId, NetBearType bearType, const NetLinkInfo &netLinkInfo,
     std::shared_ptr<TinyCountDownLatch> latch, std::shared_ptr<TinyCountDownLatch> latchAll,
     ProbeType probeType, std::string httpUrl, std::string httpsUrl, std::string ipAddrList)
@@ -60,58 +51,77 @@ ProbeThread::ProbeThread(uint32_t netId, NetBearType bearType, const NetLinkInfo
     httpProbe_ = std::make_unique<NetHttpProbe>(netId, bearType, netLinkInfo, probeType, ipAddrList);
 }
 
-ProbeThread::~ProbeThread()
-{
-    if (thread_.joinable()) {
-        thread_.join();
-    }
-}
+ProbeThread::~ProbeThread() {}
 
 void ProbeThread::Start()
 {
     NETMGR_LOG_D("Start net[%{public}d] monitor in", netId_);
     isDetecting_ = true;
-    std::shared_ptr<ProbeThread> probeThead = shared_from_this();
-    std::shared_ptr<ProbeThread> temp;
-    std::atomic_store_explicit(&temp, std::move(probeThead), std::memory_order_release);
-    thread_ = std::thread([thread = std::atomic_load_explicit(&temp, std::memory_order_acquire)] {
-        return NetProbeThread(thread);
-    });
-    std::string threadName = "netDetectThread";
-    pthread_setname_np(thread_.native_handle(), threadName.c_str());
-    thread_.detach();
+    /* Only the DNS and option setup runs on the ffrt pool, the transfer itself joins the shared probe loop */
+    std::shared_ptr<ProbeThread> probeThread = shared_from_this();
+    ffrt::submit([probeThread]() { probeThread->SendHttpProbeAsync(); }, {}, {},
+        ffrt::task_attr().name("netDetectProbe"));
 }
 
-void ProbeThread::SendHttpProbe(ProbeType probeType)
+bool ProbeThread::CheckProbeReady()
 {
     if (httpProbeUrl_.empty() || httpsProbeUrl_.empty()) {
         NETMGR_LOG_E("Net:[%{public}d] httpProbeUrl is empty", netId_);
-        isDetecting_ = false;
-        latch_->CountDown();
-        latchAll_->CountDown();
-        return;
+        return false;
     }
 
     if (httpProbe_ == nullptr) {
         NETMGR_LOG_E("Net:[%{public}d] httpProbe_ is nullptr", netId_);
-        isDetecting_ = false;
-        latch_->CountDown();
-        latchAll_->CountDown();
+        return false;
+    }
+    return true;
+}
+
+void ProbeThread::SendHttpProbeAsync()
+{
+    if (!CheckProbeReady()) {
+        CountDownLatch(false);
+        return;
+    }
+
+    probeStartTime_ = CommonUtils::GetCurrentMilliSecond();
+    /* the loop owns a reference until the probe completes, so the probe outlives an early verdict */
+    std::shared_ptr<ProbeThread> probeThread = shared_from_this();
+    int32_t ret = httpProbe_->SendProbeAsync(probeType_, httpProbeUrl_, httpsProbeUrl_, probeGroup_,
+        [probeThread]() { probeThread->OnProbeFinished(); });
+    if (ret != NETMANAGER_SUCCESS) {
+        NETMGR_LOG_E("Net:[%{public}d] send async probe failed.", netId_);
+        CountDownLatch(false);
+    }
+}
+
+void ProbeThread::OnProbeFinished()
+{
+    probeDuration_ = CommonUtils::GetCurrentMilliSecond() - probeStartTime_;
+    CountDownLatch(IsConclusiveResult());
+}
+
+void ProbeThread::SendHttpProbe(ProbeType probeType)
+{
+    if (!CheckProbeReady()) {
+        CountDownLatch(false);
         return;
     }
 
-    probeDuration_ = CommonUtils::GetCurrentMilliSecond();
+    probeStartTime_ = CommonUtils::GetCurrentMilliSecond();
     if (httpProbe_->SendProbe(probeType, httpProbeUrl_, httpsProbeUrl_) != NETMANAGER_SUCCESS) {
         NETMGR_LOG_E("Net:[%{public}d] send probe failed.", netId_);
-        isDetecting_ = false;
-        latch_->CountDown();
-        latchAll_->CountDown();
+        CountDownLatch(false);
         return;
     }
-    probeDuration_ = CommonUtils::GetCurrentMilliSecond() - probeDuration_;
+    probeDuration_ = CommonUtils::GetCurrentMilliSecond() - probeStartTime_;
+    CountDownLatch(IsConclusiveResult());
+}
 
-    if (IsConclusiveResult()) {
-        isDetecting_ = false;
+void ProbeThread::CountDownLatch(bool isConclusive)
+{
+    isDetecting_ = false;
+    if (isConclusive) {
         while (latch_->GetCount() > 0 && ipAddrList_.empty()) {
             latch_->CountDown();
         }
@@ -119,7 +129,6 @@ void ProbeThread::SendHttpProbe(ProbeType probeType)
             latchAll_->CountDown();
         }
     }
-    isDetecting_ = false;
     if (latch_->GetCount() > 0) {
         latch_->CountDown();
     }
@@ -157,6 +166,11 @@ void ProbeThread::SetXReqId(const std::string& xReqId, int8_t xReqIdLen)
     }
 }
 
+void ProbeThread::SetProbeGroup(uint64_t probeGroup)
+{
+    probeGroup_ = probeGroup;
+}
+
 void ProbeThread::ProbeWithoutGlobalHttpProxy()
 {
     httpProbe_->ProbeWithoutGlobalHttpProxy();
@@ -29,6 +29,8 @@ static const uint32_t VLAN_HEADER_LENGTH = 8;    // vlan header length
 static const uint32_t TRANSFER_HEADER_LENGTH = 20;
 static const uint32_t IPV4_HEADER_LENGTH = 20;
 static const uint32_t IPV6_HEADER_LENGTH = 40;
+static const uint32_t FIREWALL_SYSTEM_UID_MAX = 9999;
+static const uint32_t LOOPBACK_IFINDEX = 1;
 enum { IFNAME_SIZE = 32 };
 enum { DEFAULT_NETWORK_BEARER_MAP_KEY = 0 };
 
@@ -98,6 +100,14 @@ typedef __u32 sock_permission_key;
 typedef __u8 sock_permission_value;
 // internet permission end
 
+// process socket marks begin
+typedef __u32 process_sock_mark_key; // tgid of the process
+typedef struct {
+    __u32 uid;  // uid of the process when it registered, a reused pid of another uid is not marked
+    __u32 mark; // fwmark set on every inet socket the process creates
+} process_sock_mark_value;
+// process socket marks end
+
 typedef __u32 net_bear_id_key;
 typedef __u32 net_bear_type_map_value;
 
@@ -107,6 +117,75 @@ typedef __u8 net_interface_name_id;
 
 typedef __u32 app_uid_key;
 
+// uid firewall chains begin
+enum firewall_chain_bit {
+    FIREWALL_CHAIN_DOZABLE = 1 << 0,
+    FIREWALL_CHAIN_POWERSAVING = 1 << 1,
+    FIREWALL_CHAIN_UNDOZABLE = 1 << 2,
+    FIREWALL_CHAIN_ALLOWED_LIST_BOX = 1 << 3,
+};
+enum { FIREWALL_CHAIN_CONFIG_KEY = 0 };
+
+// The chains a uid is listed in, as firewall_chain_bit
+typedef __u32 firewall_uid_key;
+typedef __u8 firewall_uid_value;
+
+typedef __u32 firewall_chain_key;
+typedef struct {
+    __u32 enabledChains; // firewall_chain_bit of the enabled chains
+    __u32 maxUid;        // uids above it are outside the user namespace and never dropped
+} firewall_chain_value;
+// uid firewall chains end
+
 typedef __u8 traffic_notify_flag;
 typedef __u64 traffic_value;
+
+// bandwidth data saver and quotas begin
+enum bandwidth_uid_bit {
+    BANDWIDTH_UID_DENIED = 1 << 0,
+    BANDWIDTH_UID_ALLOWED = 1 << 1,
+};
+enum bandwidth_limit_type {
+    BANDWIDTH_LIMIT_QUOTA = 0, // drops the traffic of a costly iface beyond the limit
+    BANDWIDTH_LIMIT_ALERT = 1, // only reports the limit is reached
+};
+enum { BANDWIDTH_CONFIG_KEY = 0, BANDWIDTH_GLOBAL_IFINDEX = 0 };
+
+// The data saver lists a uid is in, as bandwidth_uid_bit
+typedef __u32 bandwidth_uid_key;
+typedef __u8 bandwidth_uid_value;
+
+typedef struct {
+    __u32 ifIndex; // BANDWIDTH_GLOBAL_IFINDEX counts every iface
+    __u32 type;    // bandwidth_limit_type
+} bandwidth_limit_key;
+typedef struct {
+    __u64 limitBytes;
+    __u64 usedBytes;
+    __u64 notified; // the limit reached event has been sent, 64 bit for the compare and swap
+} bandwidth_limit_value;
+
+// Payload of a limit reached event on net_stats_ringbuf_map
+typedef struct {
+    bandwidth_limit_key limit;
+    __u32 ifIndex; // iface of the packet that crossed the limit
+} bandwidth_limit_event;
+
+typedef __u32 bandwidth_config_key;
+typedef struct {
+    __u32 dataSaverEnabled;
+} bandwidth_config_value;
+// bandwidth data saver and quotas end
+
+// tethering counters begin
+// A forwarded direction: received on inIfIndex, sent out of outIfIndex
+typedef struct {
+    __u32 inIfIndex;
+    __u32 outIfIndex;
+} tether_stats_key;
+typedef struct {
+    __u64 packets;
+    __u64 bytes; // IP bytes, link headers are not counted
+} tether_stats_value;
+// tethering counters end
 #endif /* NETMANAGER_BASE_BPF_DEF_H */
@@ -33,8 +33,19 @@ enum ElfLoadError {
     ELF_LOAD_ERR_LOAD_PROGS_FAIL,
     ELF_LOAD_ERR_DELETE_MAP_FAIL,
     ELF_LOAD_ERR_UNLOAD_PROGS_FAIL,
+    ELF_LOAD_ERR_RECORD_HASH_FAIL,
 };
 
+/**
+ * Load a BPF object and pin its maps and programs under /sys/fs/bpf/netsys
+ *
+ * The content hash of the object is recorded next to the pinned objects. When it still matches on the next load,
+ * the pinned programs are attached again without being loaded and verified. Pinned maps are reused whenever their
+ * type, key and value size, max entries and flags match the object.
+ *
+ * @param elfPath Path of the object file
+ * @return ELF_LOAD_ERR_NONE or the step that failed
+ */
 ElfLoadError LoadElf(const std::string &elfPath);
 
 ElfLoadError UnloadElf(const std::string &elfPath);
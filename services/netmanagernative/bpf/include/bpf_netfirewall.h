@@ -27,6 +27,7 @@
 
 #include "bitmap_manager.h"
 #include "bpf_mapper.h"
+#include "bpf_ring_buffer_consumer.h"
 #include "i_netfirewall_callback.h"
 #include "netfirewall/netfirewall_def.h"
 #include "netfirewall_parcel.h"
@@ -38,7 +39,8 @@ namespace OHOS::NetManagerStandard {
 static constexpr const char *FIREWALL_BPF_PATH = "/system/etc/bpf/netsys.o";
 
 static constexpr const int CONNTRACK_GC_INTTERVAL_MS = 60000;
-static constexpr const int RING_BUFFER_POLL_TIME_OUT_MS = -1;
+static constexpr const char *FIREWALL_RING_BUFFER_NAME = "netFirewall";
+static constexpr const size_t FIREWALL_EVENT_QUEUE_CAPACITY = 1024;
 
 static constexpr const char *LOOP_BACK_IPV4 = "127.0.0.0";
 static constexpr const int LOOP_BACK_IPV4_PREFIXLEN = 8;
@@ -233,7 +235,8 @@ private:
 
     static void StartConntrackGcThread(void);
 
-    static void RingBufferListenThread(void);
+    // Handler of the event ring buffer, runs on the dispatch queue the consumer keeps for it
+    static void HandleEvents(const std::vector<RingBufferRecord> &batch);
 
     void StopConntrackGc();
 
@@ -297,7 +300,6 @@ private:
 
     static std::shared_ptr<NetsysBpfNetFirewall> instance_;
     static std::atomic<bool> isBpfLoaded_;
-    static std::atomic<bool> keepListen_;
     std::unique_ptr<std::thread> thread_;
     std::vector<sptr<NetsysNative::INetFirewallCallback>> callbacks_;
     std::mutex callbackMutex_;
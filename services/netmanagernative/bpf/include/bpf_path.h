@@ -37,5 +37,13 @@ static constexpr const char *IFINDEX_MAP_PATH = "/sys/fs/bpf/netsys/maps/ifindex
 static constexpr const char *NET_STATUS_MAP_PATH = "/sys/fs/bpf/netsys/maps/net_status_map";
 static constexpr const char *NET_WLAN1_MAP_PATH = "/sys/fs/bpf/netsys/maps/net_wlan1_map";
 static constexpr const char *IFINDEX_AND_NET_TYPE_MAP_PATH = "/sys/fs/bpf/netsys/maps/ifindex_and_net_type_map";
+static constexpr const char *FIREWALL_UID_MAP_PATH = "/sys/fs/bpf/netsys/maps/firewall_uid_map";
+static constexpr const char *FIREWALL_CHAIN_MAP_PATH = "/sys/fs/bpf/netsys/maps/firewall_chain_map";
+static constexpr const char *BANDWIDTH_UID_MAP_PATH = "/sys/fs/bpf/netsys/maps/bandwidth_uid_map";
+static constexpr const char *BANDWIDTH_LIMIT_MAP_PATH = "/sys/fs/bpf/netsys/maps/bandwidth_limit_map";
+static constexpr const char *BANDWIDTH_CONFIG_MAP_PATH = "/sys/fs/bpf/netsys/maps/bandwidth_config_map";
+static constexpr const char *TETHER_STATS_MAP_PATH = "/sys/fs/bpf/netsys/maps/tether_stats_map";
+static constexpr const char *PROCESS_SOCK_MARK_MAP_PATH = "/sys/fs/bpf/netsys/maps/process_sock_mark_map";
+static constexpr const char *TETHER_EGRESS_PROG_PATH = "/sys/fs/bpf/netsys/progs/schedcls_tether_egress";
 } // namespace OHOS::NetManagerStandard
 #endif /* NETMANAGER_BASE_BPF_PATH_H */
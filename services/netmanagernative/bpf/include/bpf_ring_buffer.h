@@ -36,6 +36,7 @@
 #include "bpf_def.h"
 #include "bpf_stats.h"
 #include "bpf_mapper.h"
+#include "bpf_ring_buffer_consumer.h"
 #include "securec.h"
 
 #include "i_netsys_traffic_callback.h"
@@ -49,6 +50,8 @@ enum RingBufferError {
 
 class NetsysBpfRingBuffer {
 public:
+    using BandwidthLimitHandler = std::function<void(const std::string &limitName, const std::string &iface)>;
+
     NetsysBpfRingBuffer() = default;
     ~NetsysBpfRingBuffer() = default;
 
@@ -58,20 +61,24 @@ public:
 
     static int HandleNetworkPolicyEventCallback(void *ctx, void *data, size_t data_sz);
     static int HandleNetStatsEventCallback(void *ctx, void *data, size_t dataSz);
-    static void ListenRingBufferThread(void);
+    // Batch handlers of the ring buffer consumer, both run on the dispatch queue of their ring
+    static void HandleNetworkPolicyEvents(const std::vector<RingBufferRecord> &batch);
+    static void HandleNetStatsEvents(const std::vector<RingBufferRecord> &batch);
     static void ListenNetworkAccessPolicyEvent();
-    static void ListenNetStatsRingBufferThread();
     static void ExistRingBufferPoll(void);
     static void ListenNetworkStatsEvent(void);
     static void ExistNetstatsRingBufferPoll();
     static int RegisterNetsysTrafficCallback(const sptr<NetsysNative::INetsysTrafficCallback> &callback);
     static int UnRegisterNetsysTrafficCallback(const sptr<NetsysNative::INetsysTrafficCallback> &callback);
+    // Receives the quota and alert crossings that netsys.c reports on the net stats ring buffer
+    static void SetBandwidthLimitHandler(const BandwidthLimitHandler &handler);
 
 private:
-    static bool existThread_;
-    static std::atomic_bool existNetStatsThread_;
+    static int HandleBandwidthLimitEvent(const bandwidth_limit_event &event);
+
     static std::vector<sptr<NetsysNative::INetsysTrafficCallback>> callbacks_;
     static std::mutex callbackMutex_;
+    static BandwidthLimitHandler bandwidthLimitHandler_;
 };
 } // namespace OHOS::NetManagerStandard
 #endif // BPF_RING_BUFFER_H
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BPF_RING_BUFFER_CONSUMER_H
+#define BPF_RING_BUFFER_CONSUMER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ffrt.h"
+
+struct ring_buffer;
+
+namespace OHOS::NetManagerStandard {
+using RingBufferRecord = std::vector<uint8_t>;
+
+struct RingBufferStats {
+    // Records read off the ring
+    uint64_t received = 0;
+    // Records thrown away because the handler queue was full
+    uint64_t dropped = 0;
+    uint64_t dispatched = 0;
+    uint64_t batches = 0;
+    // Records read but not handled yet
+    uint64_t pending = 0;
+    // How long the oldest record of the last batch, and of any batch, waited for its handler
+    uint64_t lastLagUs = 0;
+    uint64_t maxLagUs = 0;
+};
+
+/**
+ * Reads every netsys ring buffer from one libbpf ring_buffer manager on one task
+ *
+ * The rings share one epoll set and are drained together. Records are copied to a bounded queue per
+ * ring and handed to its handler in batches on a serial ffrt queue, so a slow handler (an IPC, say)
+ * holds up neither the other rings nor the kernel side. A full queue drops the newest records.
+ */
+class NetsysBpfRingBufferConsumer {
+public:
+    using BatchHandler = std::function<void(const std::vector<RingBufferRecord> &batch)>;
+
+    NetsysBpfRingBufferConsumer() = default;
+    ~NetsysBpfRingBufferConsumer();
+
+    static NetsysBpfRingBufferConsumer &GetInstance();
+
+    /**
+     * Read the ring buffer pinned at a path
+     *
+     * Adding a name again replaces its handler and enables it again.
+     *
+     * @param name Ring name, used in the stats and the dump
+     * @param path Path the ring buffer map is pinned at
+     * @param handler Handler for the records, runs on the serial queue of the ring
+     * @param queueCapacity Records that may wait for the handler before new ones are dropped
+     * @return NETMANAGER_SUCCESS or NETMANAGER_ERROR
+     */
+    int32_t AddRingBuffer(const std::string &name, const std::string &path, const BatchHandler &handler,
+                          size_t queueCapacity);
+
+    /**
+     * Stop reading a ring
+     *
+     * Records the ring gets from then on stay in it and are read once it is added again, unless it overflows.
+     *
+     * @param name Ring name given to AddRingBuffer
+     */
+    void RemoveRingBuffer(const std::string &name);
+
+    /**
+     * Start the consume task, does nothing when it runs already
+     *
+     * @return NETMANAGER_SUCCESS or NETMANAGER_ERROR
+     */
+    int32_t Start();
+
+    // Wake the consume task and let it exit, the rings stay added for the next Start
+    void Stop();
+
+    bool GetStats(const std::string &name, RingBufferStats &stats);
+
+    void GetDumpInfo(std::string &info);
+
+private:
+    struct RingBufferSource {
+        std::string name;
+        int32_t mapFd = -1;
+        size_t capacity = 0;
+        std::shared_ptr<ffrt::queue> dispatchQueue;
+        std::mutex mutex;
+        BatchHandler handler;
+        std::vector<RingBufferRecord> pending;
+        std::chrono::steady_clock::time_point oldestQueued;
+        bool dispatchScheduled = false;
+        uint64_t reportedDrops = 0;
+        RingBufferStats stats;
+    };
+
+    static int OnRecord(void *ctx, void *data, size_t size);
+    static void Dispatch(const std::shared_ptr<RingBufferSource> &source);
+
+    int32_t InitEpoll();
+    ring_buffer *NewRingBuffer(const std::vector<std::shared_ptr<RingBufferSource>> &sources);
+    std::shared_ptr<RingBufferSource> FindSource(const std::string &name);
+    void ConsumeLoop();
+    void Drain();
+
+    std::mutex mutex_;
+    ring_buffer *ringBuffer_ = nullptr;
+    std::vector<std::shared_ptr<RingBufferSource>> sources_;
+    int32_t epollFd_ = -1;
+    int32_t wakeFd_ = -1;
+    bool running_ = false;
+    bool loopExited_ = true;
+    ffrt::task_handle loopTask_;
+};
+} // namespace OHOS::NetManagerStandard
+#endif // BPF_RING_BUFFER_CONSUMER_H
@@ -13,9 +13,13 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cerrno>
+#include <cinttypes>
+#include <climits>
 #include <fcntl.h>
 #include <filesystem>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <linux/bpf.h>
@@ -56,8 +60,16 @@
 namespace OHOS::NetManagerStandard {
 static constexpr const char *BPF_DIR = "/sys/fs/bpf";
 static constexpr const char *CGROUP_DIR = "/sys/fs/cgroup";
+static constexpr const char *NETSYS_DIR = "/sys/fs/bpf/netsys";
 static constexpr const char *MAPS_DIR = "/sys/fs/bpf/netsys/maps";
 static constexpr const char *PROGS_DIR = "/sys/fs/bpf/netsys/progs";
+// bpffs holds no regular files, the hash of a loaded object is kept as the target of a symlink
+static constexpr const char *OBJECT_HASH_SUFFIX = "_hash";
+static constexpr const char *OBJECT_HASH_PREFIX = "fnv1a64:";
+static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+static constexpr size_t HASH_READ_BUFFER_SIZE = 4096;
+static constexpr uint32_t MAX_QUERY_PROG_CNT = 64;
 
 // There is no limit to the size of SECTION_NAMES.
 static const struct SectionName {
@@ -215,6 +227,58 @@ inline int32_t SysBpfObjAttach(bpf_attach_type type, const int progFd, const int
     return SysBpf(BPF_PROG_ATTACH, &attr, sizeof(attr));
 }
 
+inline int32_t SysBpfObjReplace(bpf_attach_type type, const int progFd, const int oldProgFd, const int cgFd)
+{
+    bpf_attr attr = {};
+
+    if (memset_s(&attr, sizeof(attr), 0, sizeof(attr)) != EOK) {
+        return NETMANAGER_ERROR;
+    }
+    attr.target_fd = cgFd;
+    attr.attach_bpf_fd = progFd;
+    attr.attach_type = type;
+    attr.attach_flags = BPF_F_ALLOW_MULTI | BPF_F_REPLACE;
+    attr.replace_bpf_fd = oldProgFd;
+
+    return SysBpf(BPF_PROG_ATTACH, &attr, sizeof(attr));
+}
+
+inline int32_t SysBpfObjGetInfo(const int fd, void *info, uint32_t infoLen)
+{
+    bpf_attr attr = {};
+
+    if (memset_s(&attr, sizeof(attr), 0, sizeof(attr)) != EOK) {
+        return NETMANAGER_ERROR;
+    }
+    attr.info.bpf_fd = static_cast<uint32_t>(fd);
+    attr.info.info_len = infoLen;
+    attr.info.info = PtrToU64(info);
+
+    return SysBpf(BPF_OBJ_GET_INFO_BY_FD, &attr, sizeof(attr));
+}
+
+inline bool IsProgAttached(bpf_attach_type type, const int progFd, const int cgFd)
+{
+    bpf_prog_info info = {};
+    if (SysBpfObjGetInfo(progFd, &info, sizeof(info)) < 0) {
+        return false;
+    }
+    uint32_t progIds[MAX_QUERY_PROG_CNT] = {0};
+    bpf_attr attr = {};
+    if (memset_s(&attr, sizeof(attr), 0, sizeof(attr)) != EOK) {
+        return false;
+    }
+    attr.query.target_fd = static_cast<uint32_t>(cgFd);
+    attr.query.attach_type = type;
+    attr.query.prog_ids = PtrToU64(progIds);
+    attr.query.prog_cnt = MAX_QUERY_PROG_CNT;
+    if (SysBpf(BPF_PROG_QUERY, &attr, sizeof(attr)) < 0) {
+        return false;
+    }
+    uint32_t progCnt = std::min(attr.query.prog_cnt, MAX_QUERY_PROG_CNT);
+    return std::find(progIds, progIds + progCnt, info.id) != progIds + progCnt;
+}
+
 inline bool MatchSecName(const std::string &name)
 {
     auto matchFunc = [name](const SectionName &sec) -> bool {
@@ -232,9 +296,36 @@ inline int32_t UnPin(const std::string &path)
     return unlink(path.c_str());
 }
 
+std::string HashFile(const std::string &path)
+{
+    std::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs.is_open()) {
+        return "";
+    }
+    uint64_t hash = FNV_OFFSET_BASIS;
+    char buffer[HASH_READ_BUFFER_SIZE];
+    while (ifs.read(buffer, sizeof(buffer)) || ifs.gcount() > 0) {
+        for (std::streamsize i = 0; i < ifs.gcount(); i++) {
+            hash = (hash ^ static_cast<uint8_t>(buffer[i])) * FNV_PRIME;
+        }
+    }
+    char hex[sizeof(uint64_t) * 2 + 1] = {0};
+    if (snprintf_s(hex, sizeof(hex), sizeof(hex) - 1, "%016" PRIx64, hash) < 0) {
+        return "";
+    }
+    return std::string(OBJECT_HASH_PREFIX) + hex;
+}
+
+std::string ReadLink(const std::string &path)
+{
+    char target[PATH_MAX] = {0};
+    ssize_t len = readlink(path.c_str(), target, sizeof(target) - 1);
+    return len > 0 ? std::string(target, static_cast<size_t>(len)) : "";
+}
+
 class ElfLoader {
 public:
-    explicit ElfLoader(std::string path) : path_(std::move(path)), kernVersion_(0) {}
+    explicit ElfLoader(std::string path) : path_(std::move(path)), kernVersion_(0), warmStart_(false) {}
 
     ElfLoadError Unload() const
     {
@@ -278,9 +369,11 @@ public:
             {5, "set license and version ok", setLicenseAndVersion_, "set license and version failed"},
             {6, "load elf map section ok", loadElfMapsSection_, "load elf map section failed"},
             {7, "set rlimit ok", setRlimit_, "set rlimit failed"},
-            {8, "create maps ok", createMaps_, "create maps failed"},
-            {9, "parse relocation ok", parseRelocation_, "parse relocation failed"},
-            {10, "load progs ok", loadProgs_, "load progs failed"},
+            {8, "check object hash ok", checkObjectHash_, "check object hash failed"},
+            {9, "create maps ok", createMaps_, "create maps failed"},
+            {10, "parse relocation ok", parseRelocation_, "parse relocation failed"},
+            {11, "load progs ok", loadProgs_, "load progs failed"},
+            {12, "record object hash ok", recordObjectHash_, "record object hash failed"},
         };
         for (const auto &fun : funList) {
             auto ret = fun.fun();
@@ -520,9 +613,51 @@ private:
         return fd;
     }
 
+    static bool IsMapCompatible(int32_t fd, const bpf_map_def &def)
+    {
+        bpf_map_info info = {};
+        if (SysBpfObjGetInfo(fd, &info, sizeof(info)) < 0) {
+            return false;
+        }
+        return info.type == def.type && info.key_size == def.key_size && info.value_size == def.value_size &&
+               info.max_entries == def.max_entries && info.map_flags == def.map_flags;
+    }
+
+    // A pinned map keeps its entries across restarts, so it is reused for as long as its layout still matches
+    static int32_t GetPinnedMap(const BpfMapData &map, const std::string &mapPinLocation)
+    {
+        if (access(mapPinLocation.c_str(), F_OK) != 0) {
+            return NETMANAGER_ERROR;
+        }
+        auto fd = SysBpfObjGet(mapPinLocation, 0);
+        if (fd >= 0 && IsMapCompatible(fd, map.def)) {
+            NETNATIVE_LOGI("map: %{public}s has already been pinned, reuse it", mapPinLocation.c_str());
+            return fd;
+        }
+        NETNATIVE_LOGW("map: %{public}s does not match its definition, create it again", mapPinLocation.c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        UnPin(mapPinLocation);
+        return NETMANAGER_ERROR;
+    }
+
     bool CreateMaps()
     {
         for (auto &map : maps_) {
+            std::string mapPinLocation = std::string(MAPS_DIR) + "/" + map.name;
+            auto pinnedFd = GetPinnedMap(map, mapPinLocation);
+            if (pinnedFd >= 0) {
+                map.fd = pinnedFd;
+                continue;
+            }
+            if (warmStart_) {
+                // The pinned programs use the map that is gone, they have to be loaded again
+                NETNATIVE_LOGW("map: %{public}s is recreated, warm start is off", map.name.c_str());
+                warmStart_ = false;
+                UnPin(GetObjectHashLocation());
+            }
+
             auto fd = BpfCreateMapNode(map);
             if (fd < 0) {
                 NETNATIVE_LOGE("Failed create map (%{public}s): %{public}d", map.name.c_str(), fd);
@@ -530,14 +665,9 @@ private:
             }
 
             map.fd = fd;
-            std::string mapPinLocation = std::string(MAPS_DIR) + "/" + map.name;
-            if (access(mapPinLocation.c_str(), F_OK) == 0) {
-                NETNATIVE_LOGI("map: %{public}s has already been pinned", mapPinLocation.c_str());
-            } else {
-                if (SysBpfObjPin(fd, mapPinLocation) < 0) {
-                    NETNATIVE_LOGE("Failed to pin map: %{public}s, errno = %{public}d", mapPinLocation.c_str(), errno);
-                    return false;
-                }
+            if (SysBpfObjPin(fd, mapPinLocation) < 0) {
+                NETNATIVE_LOGE("Failed to pin map: %{public}s, errno = %{public}d", mapPinLocation.c_str(), errno);
+                return false;
             }
         }
         return true;
@@ -649,7 +779,8 @@ private:
         return static_cast<bpf_prog_type>(NETMANAGER_ERROR);
     }
 
-    static bool DoAttach(int32_t progFd, const std::string &progName)
+    // Cgroup attachments outlive netsys, so a program found attached is left alone and an old one is replaced in place
+    static bool DoAttach(int32_t progFd, const std::string &progName, int32_t oldProgFd)
     {
         if (progName.size() < 1) {
             NETNATIVE_LOGE("progName is null");
@@ -665,7 +796,14 @@ private:
                     return false;
                 }
 
-                if (SysBpfObjAttach(prog.attachType, progFd, cgroupFd) < NETSYS_SUCCESS) {
+                if (IsProgAttached(prog.attachType, progFd, cgroupFd)) {
+                    close(cgroupFd);
+                    return true;
+                }
+                int32_t ret = (oldProgFd >= 0 && IsProgAttached(prog.attachType, oldProgFd, cgroupFd)) ?
+                    SysBpfObjReplace(prog.attachType, progFd, oldProgFd, cgroupFd) :
+                    SysBpfObjAttach(prog.attachType, progFd, cgroupFd);
+                if (ret < NETSYS_SUCCESS) {
                     NETNATIVE_LOGE("attach %{public}s failed: errno = %{public}d", progName.c_str(), errno);
                     close(cgroupFd);
                     return false;
@@ -734,22 +872,31 @@ private:
             return false;
         }
 
+        // The program pinned by an older object is swapped out once the new one is attached in its place
         std::string progPinLocation = std::string(PROGS_DIR) + "/" + progName;
-        if (access(progPinLocation.c_str(), F_OK) == 0) {
-            NETNATIVE_LOGI("prog: %{public}s has already been pinned", progPinLocation.c_str());
-        } else {
-            if (SysBpfObjPin(progFd, progPinLocation) < NETSYS_SUCCESS) {
-                NETNATIVE_LOGE("Failed to pin prog: %{public}s, errno = %{public}d", progPinLocation.c_str(), errno);
-                close(progFd);
-                return false;
+        int32_t oldProgFd = access(progPinLocation.c_str(), F_OK) == 0 ? SysBpfObjGet(progPinLocation, 0) : -1;
+        bool ret = AttachProg(progFd, progName, progType, oldProgFd);
+        if (oldProgFd >= 0) {
+            close(oldProgFd);
+            if (ret) {
+                NETNATIVE_LOGI("prog: %{public}s has already been pinned, replace it", progPinLocation.c_str());
+                UnPin(progPinLocation);
             }
         }
+        if (ret && SysBpfObjPin(progFd, progPinLocation) < NETSYS_SUCCESS) {
+            NETNATIVE_LOGE("Failed to pin prog: %{public}s, errno = %{public}d", progPinLocation.c_str(), errno);
+            ret = false;
+        }
+        close(progFd);
+        return ret;
+    }
 
+    static bool AttachProg(int32_t progFd, const std::string &progName, bpf_prog_type progType, int32_t oldProgFd)
+    {
         /* attach socket filter */
         if (progType == BPF_PROG_TYPE_SOCKET_FILTER) {
             if (g_sockFd < 0) {
                 NETNATIVE_LOGE("create socket failed, %{public}d, err: %{public}d", g_sockFd, errno);
-                close(progFd);
                 /* return true to ignore this prog */
                 return true;
             }
@@ -758,13 +905,83 @@ private:
                 close(g_sockFd);
                 g_sockFd = -1;
             }
-            close(progFd);
             return true;
-        } else {
-            auto ret = DoAttach(progFd, progName);
+        }
+        return DoAttach(progFd, progName, oldProgFd);
+    }
+
+    // The object did not change since its programs were pinned, they only need to be attached again
+    bool ReattachProgs()
+    {
+        // A socket left by an earlier load in this process carries these very programs already
+        if (g_sockFd < 0) {
+            g_sockFd = socket(PF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+        }
+        return std::all_of(elfIo_.sections.begin(), elfIo_.sections.end(), [](const auto &section) -> bool {
+            if (!MatchSecName(section->get_name())) {
+                return true;
+            }
+            std::string progName = section->get_name();
+            std::replace(progName.begin(), progName.end(), '/', '_');
+            std::string progPinLocation = std::string(PROGS_DIR) + "/" + progName;
+            int32_t progFd = SysBpfObjGet(progPinLocation, 0);
+            if (progFd < NETSYS_SUCCESS) {
+                NETNATIVE_LOGE("Failed to get prog: %{public}s, errno = %{public}d", progPinLocation.c_str(), errno);
+                return false;
+            }
+            bool ret = AttachProg(progFd, progName, ConvertEventToProgType(section->get_name()), -1);
             close(progFd);
             return ret;
+        });
+    }
+
+    std::string GetObjectHashLocation() const
+    {
+        // bpffs takes no '.' in names, netsys.o is recorded as netsys_o_hash
+        std::string name = std::filesystem::path(path_).filename().string();
+        std::replace(name.begin(), name.end(), '.', '_');
+        return std::string(NETSYS_DIR) + "/" + name + OBJECT_HASH_SUFFIX;
+    }
+
+    bool AreProgsPinned()
+    {
+        return std::all_of(elfIo_.sections.begin(), elfIo_.sections.end(), [](const auto &section) -> bool {
+            if (!MatchSecName(section->get_name())) {
+                return true;
+            }
+            std::string progName = section->get_name();
+            std::replace(progName.begin(), progName.end(), '/', '_');
+            return access((std::string(PROGS_DIR) + "/" + progName).c_str(), F_OK) == 0;
+        });
+    }
+
+    // Never fails, an object that cannot be matched is loaded cold
+    bool CheckObjectHash()
+    {
+        objectHash_ = HashFile(path_);
+        std::string hashLocation = GetObjectHashLocation();
+        warmStart_ = !objectHash_.empty() && ReadLink(hashLocation) == objectHash_ && AreProgsPinned();
+        if (!warmStart_) {
+            // Recorded again once the cold load is through, a load that dies half way is not taken for a good one
+            UnPin(hashLocation);
         }
+        NETNATIVE_LOGI("object %{public}s hash %{public}s, %{public}s start", path_.c_str(), objectHash_.c_str(),
+                       warmStart_ ? "warm" : "cold");
+        return true;
+    }
+
+    bool RecordObjectHash()
+    {
+        if (warmStart_ || objectHash_.empty()) {
+            return true;
+        }
+        std::string hashLocation = GetObjectHashLocation();
+        UnPin(hashLocation);
+        if (symlink(objectHash_.c_str(), hashLocation.c_str()) < 0) {
+            NETNATIVE_LOGE("Failed to record hash: %{public}s, errno = %{public}d", hashLocation.c_str(), errno);
+            return false;
+        }
+        return true;
     }
 
     bool ParseRelocation()
@@ -801,6 +1018,7 @@ private:
             close(g_sockFd);
             g_sockFd = -1;
         }
+        UnPin(GetObjectHashLocation());
         return std::all_of(elfIo_.sections.begin(), elfIo_.sections.end(), [this](const auto &section) -> bool {
             if (!MatchSecName(section->get_name())) {
                 return true;
@@ -838,6 +1056,8 @@ private:
     std::string license_;
     int32_t kernVersion_;
     std::vector<BpfMapData> maps_;
+    std::string objectHash_;
+    bool warmStart_;
 
     std::function<ElfLoadError()> isPathValid_ = [this]() -> ElfLoadError {
         if (!IsPathValid()) {
@@ -888,6 +1108,11 @@ private:
         return ELF_LOAD_ERR_NONE;
     };
 
+    std::function<ElfLoadError()> checkObjectHash_ = [this]() -> ElfLoadError {
+        CheckObjectHash();
+        return ELF_LOAD_ERR_NONE;
+    };
+
     std::function<ElfLoadError()> createMaps_ = [this]() -> ElfLoadError {
         if (!CreateMaps()) {
             return ELF_LOAD_ERR_CREATE_MAP_FAIL;
@@ -896,19 +1121,26 @@ private:
     };
 
     std::function<ElfLoadError()> parseRelocation_ = [this]() -> ElfLoadError {
-        if (!ParseRelocation()) {
+        if (!warmStart_ && !ParseRelocation()) {
             return ELF_LOAD_ERR_PARSE_RELOCATION_FAIL;
         }
         return ELF_LOAD_ERR_NONE;
     };
 
     std::function<ElfLoadError()> loadProgs_ = [this]() -> ElfLoadError {
-        if (!LoadProgs()) {
+        if (!(warmStart_ ? ReattachProgs() : LoadProgs())) {
             return ELF_LOAD_ERR_LOAD_PROGS_FAIL;
         }
         return ELF_LOAD_ERR_NONE;
     };
 
+    std::function<ElfLoadError()> recordObjectHash_ = [this]() -> ElfLoadError {
+        if (!RecordObjectHash()) {
+            return ELF_LOAD_ERR_RECORD_HASH_FAIL;
+        }
+        return ELF_LOAD_ERR_NONE;
+    };
+
     std::function<ElfLoadError()> deleteMaps_ = [this]() -> ElfLoadError {
         if (!DeleteMaps()) {
             return ELF_LOAD_ERR_DELETE_MAP_FAIL;
@@ -41,7 +41,6 @@ using namespace OHOS::NetsysNative;
 namespace OHOS {
 namespace NetManagerStandard {
 std::shared_ptr<NetsysBpfNetFirewall> NetsysBpfNetFirewall::instance_ = nullptr;
-std::atomic<bool> NetsysBpfNetFirewall::keepListen_{false};
 std::atomic<bool> NetsysBpfNetFirewall::keepGc_{false};
 std::atomic<bool> NetsysBpfNetFirewall::isBpfLoaded_{false};
 std::unique_ptr<BpfMapper<CtKey, CtVaule>> NetsysBpfNetFirewall::ctRdMap_ = nullptr;
@@ -95,39 +94,11 @@ void NetsysBpfNetFirewall::ConntrackGcTask()
     }
 }
 
-void NetsysBpfNetFirewall::RingBufferListenThread(void)
+void NetsysBpfNetFirewall::HandleEvents(const std::vector<RingBufferRecord> &batch)
 {
-    if (keepListen_) {
-        NETNATIVE_LOG_D("under listening");
-        return;
-    }
-
-    int mapFd = NetsysBpfRingBuffer::GetRingbufFd(MAP_PATH(EVENT_MAP), 0);
-    if (mapFd < 0) {
-        NETNATIVE_LOGE("failed to get ring buffer fd: errno=%{public}d", errno);
-        return;
-    }
-    ring_buffer *rb = ring_buffer__new(mapFd, NetsysBpfNetFirewall::HandleEvent, NULL, NULL);
-    if (!rb) {
-        NETNATIVE_LOGE("failed to create ring buffer: errno=%{public}d", errno);
-        return;
-    }
-
-    keepListen_ = true;
-    while (keepListen_) {
-        if (ffrt::this_task::get_id() != 0) {
-            ffrt::sync_io(mapFd);
-        }
-        int err = ring_buffer__poll(rb, RING_BUFFER_POLL_TIME_OUT_MS);
-        if (err < 0) {
-            NETNATIVE_LOGE("Error polling ring buffer: errno=%{public}d", errno);
-            keepListen_ = false;
-            break;
-        }
+    for (const auto &record : batch) {
+        HandleEvent(nullptr, const_cast<uint8_t *>(record.data()), record.size());
     }
-
-    NETNATIVE_LOGE("Could not get bpf event ring buffer map");
-    ring_buffer__free(rb);
 }
 
 int32_t NetsysBpfNetFirewall::StartListener()
@@ -139,14 +110,18 @@ int32_t NetsysBpfNetFirewall::StartListener()
     ctRdMap_ = std::make_unique<BpfMapper<CtKey, CtVaule>>(MAP_PATH(CT_MAP), BPF_F_RDONLY);
     ctWrMap_ = std::make_unique<BpfMapper<CtKey, CtVaule>>(MAP_PATH(CT_MAP), BPF_F_WRONLY);
 
-    ffrt::submit(RingBufferListenThread, {}, {}, ffrt::task_attr().name("RingBufferListen"));
+    auto &consumer = NetsysBpfRingBufferConsumer::GetInstance();
+    if (consumer.AddRingBuffer(FIREWALL_RING_BUFFER_NAME, MAP_PATH(EVENT_MAP), HandleEvents,
+                               FIREWALL_EVENT_QUEUE_CAPACITY) == NETMANAGER_SUCCESS) {
+        consumer.Start();
+    }
     ffrt::submit(StartConntrackGcThread, { &ctRdMap_ }, { &ctWrMap_ });
     return 0;
 }
 
 int32_t NetsysBpfNetFirewall::StopListener()
 {
-    keepListen_ = false;
+    NetsysBpfRingBufferConsumer::GetInstance().RemoveRingBuffer(FIREWALL_RING_BUFFER_NAME);
     StopConntrackGc();
     return 0;
 }
@@ -14,20 +14,26 @@
  */
 
 #include "bpf_ring_buffer.h"
+
+#include <net/if.h>
+#include <set>
+
+#include "bpf_ring_buffer_consumer.h"
 #include "net_policy_client.h"
-#include "libbpf.h"
-#include "ffrt.h"
-#include "ffrt_inner.h"
 
 namespace OHOS::NetManagerStandard {
 namespace {
-    const int RING_BUFFER_POLL_TIME_OUT_MS = -1;
     const uint32_t TRAFFIC_CALLBACK_MAX_NUM = 20;
+    constexpr const char *GLOBAL_ALERT_NAME = "globalAlert";
+    constexpr const char *IFACE_ALERT_SUFFIX = "Alert";
+    constexpr const char *POLICY_RING_BUFFER_NAME = "netPolicy";
+    constexpr const char *NET_STATS_RING_BUFFER_NAME = "netStats";
+    constexpr size_t POLICY_EVENT_QUEUE_CAPACITY = 256;
+    constexpr size_t NET_STATS_EVENT_QUEUE_CAPACITY = 64;
 }
-bool NetsysBpfRingBuffer::existThread_ = true;
-std::atomic_bool NetsysBpfRingBuffer::existNetStatsThread_ = true;
 std::vector<sptr<NetsysNative::INetsysTrafficCallback>> NetsysBpfRingBuffer::callbacks_ = {};
 std::mutex NetsysBpfRingBuffer::callbackMutex_;
+NetsysBpfRingBuffer::BandwidthLimitHandler NetsysBpfRingBuffer::bandwidthLimitHandler_ = nullptr;
 
 uint64_t NetsysBpfRingBuffer::BpfMapPathNameToU64(const std::string &pathName)
 {
@@ -104,102 +110,119 @@ int NetsysBpfRingBuffer::UnRegisterNetsysTrafficCallback(const sptr<NetsysNative
     return -1;
 }
 
+void NetsysBpfRingBuffer::SetBandwidthLimitHandler(const BandwidthLimitHandler &handler)
+{
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    bandwidthLimitHandler_ = handler;
+}
+
+int NetsysBpfRingBuffer::HandleBandwidthLimitEvent(const bandwidth_limit_event &event)
+{
+    char ifName[IF_NAMESIZE] = {0};
+    if (if_indextoname(event.ifIndex, ifName) == nullptr) {
+        NETNATIVE_LOGW("Bandwidth limit reached on removed iface %{public}u", event.ifIndex);
+        return RING_BUFFER_ERR_NONE;
+    }
+    // Same names the quota2 rules used to report: iface for a quota, globalAlert and <iface>Alert for alerts
+    std::string iface = ifName;
+    std::string limitName;
+    if (event.limit.type == BANDWIDTH_LIMIT_QUOTA) {
+        limitName = iface;
+    } else if (event.limit.ifIndex == BANDWIDTH_GLOBAL_IFINDEX) {
+        limitName = GLOBAL_ALERT_NAME;
+    } else {
+        limitName = iface + IFACE_ALERT_SUFFIX;
+    }
+
+    BandwidthLimitHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        handler = bandwidthLimitHandler_;
+    }
+    NETNATIVE_LOGI("Bandwidth limit %{public}s reached on %{public}s", limitName.c_str(), iface.c_str());
+    if (handler != nullptr) {
+        handler(limitName, iface);
+    }
+    return RING_BUFFER_ERR_NONE;
+}
+
 int NetsysBpfRingBuffer::HandleNetStatsEventCallback(void *ctx, void *data, size_t dataSz)
 {
-    NETNATIVE_LOGI("HandleNetStatsEventCallback enter");
+    NETNATIVE_LOG_D("HandleNetStatsEventCallback enter");
     if (data == nullptr || dataSz == 0) {
         NETNATIVE_LOGE("data error");
         return RING_BUFFER_ERR_INTERNAL;
     }
+    if (dataSz == sizeof(bandwidth_limit_event)) {
+        return HandleBandwidthLimitEvent(*reinterpret_cast<bandwidth_limit_event *>(data));
+    }
     int8_t *value = reinterpret_cast<int8_t *>(data);
 
     std::lock_guard<std::mutex> lock(callbackMutex_);
     for (const auto &callback : callbacks_) {
         if (callback != nullptr && callback->AsObject() != nullptr && callback->AsObject().GetRefPtr() != nullptr) {
-            NETNATIVE_LOGI("HandleNetStatsEventCallback start. value:%{public}d", *value);
+            NETNATIVE_LOG_D("HandleNetStatsEventCallback start. value:%{public}d", *value);
             callback->OnExceedTrafficLimits(*value);
         }
     }
     return RING_BUFFER_ERR_NONE;
 }
 
-void NetsysBpfRingBuffer::ListenNetStatsRingBufferThread()
+void NetsysBpfRingBuffer::HandleNetworkPolicyEvents(const std::vector<RingBufferRecord> &batch)
 {
-    NETNATIVE_LOGI("(netstats)ListenNetStatsRingBufferThread start");
-    auto ringbufFd = GetRingbufFd(NET_STATS_RING_BUFFER_MAP_PATH, 0);
-    if (ringbufFd > 0) {
-        /* Set up ring buffer polling */
-        auto rb = ring_buffer__new(ringbufFd, HandleNetStatsEventCallback, NULL, NULL);
-        if (!rb) {
-            NETNATIVE_LOGE("(netstats)Bpf ring buffer new fail");
-            return;
+    // A denied app usually retries at once, one diag per uid is enough for a batch
+    std::set<int32_t> notifiedUids;
+    for (const auto &record : batch) {
+        if (record.size() < sizeof(int32_t)) {
+            continue;
         }
-
-        /* Process events */
-        while (existNetStatsThread_) {
-            ffrt::sync_io(ringbufFd);
-            int res = ring_buffer__poll(rb, RING_BUFFER_POLL_TIME_OUT_MS);
-            if (res < 0 && errno != EINTR) {
-                NETNATIVE_LOGE("(netstats)Bpf ring buffer poll fail, res: %{public}d, errno: %{public}d", res, errno);
-                break;
-            }
+        int32_t uid = *reinterpret_cast<const int32_t *>(record.data());
+        if (notifiedUids.insert(uid).second) {
+            HandleNetworkPolicyEventCallback(nullptr, &uid, sizeof(uid));
         }
-
-        ring_buffer__free(rb);
     }
-
-    NETNATIVE_LOGE("(netstats)Could not get bpf ring buffer map");
-    return;
 }
 
-void NetsysBpfRingBuffer::ListenRingBufferThread(void)
+void NetsysBpfRingBuffer::HandleNetStatsEvents(const std::vector<RingBufferRecord> &batch)
 {
-    auto ringbufFd = GetRingbufFd(RING_BUFFER_MAP_PATH, 0);
-    if (ringbufFd > 0) {
-        struct ring_buffer *rb = NULL;
-        int err = 0;
-        /* Set up ring buffer polling */
-        rb = ring_buffer__new(ringbufFd, HandleNetworkPolicyEventCallback, NULL, NULL);
-        if (!rb) {
-            err = -1;
-            NETNATIVE_LOGE("Bpf ring buffer new fail");
-            return;
-        }
-
-        /* Process events */
-        while (existThread_) {
-            ffrt::sync_io(ringbufFd);
-            err = ring_buffer__poll(rb, RING_BUFFER_POLL_TIME_OUT_MS);
-            if (err < 0) {
-                NETNATIVE_LOGE("Bpf ring buffer poll fail, err: %{public}d, errno: %{public}d", err, errno);
-                break;
+    const RingBufferRecord *lastTrafficFlag = nullptr;
+    for (const auto &record : batch) {
+        // Every packet past a traffic limit reports it, the callbacks only need the first of a run
+        if (record.size() == sizeof(int8_t)) {
+            if (lastTrafficFlag != nullptr && *lastTrafficFlag == record) {
+                continue;
             }
+            lastTrafficFlag = &record;
         }
-
-        ring_buffer__free(rb);
+        HandleNetStatsEventCallback(nullptr, const_cast<uint8_t *>(record.data()), record.size());
     }
-
-    NETNATIVE_LOGE("Could not get bpf ring buffer map");
-    return;
 }
 
 void NetsysBpfRingBuffer::ListenNetworkAccessPolicyEvent(void)
 {
-    ffrt::submit(ListenRingBufferThread, {}, {}, ffrt::task_attr().name("ListenRingBufferThread"));
+    auto &consumer = NetsysBpfRingBufferConsumer::GetInstance();
+    if (consumer.AddRingBuffer(POLICY_RING_BUFFER_NAME, RING_BUFFER_MAP_PATH, HandleNetworkPolicyEvents,
+                               POLICY_EVENT_QUEUE_CAPACITY) == NETMANAGER_SUCCESS) {
+        consumer.Start();
+    }
 }
 
 void NetsysBpfRingBuffer::ExistRingBufferPoll(void)
 {
-    existThread_ = false;
+    NetsysBpfRingBufferConsumer::GetInstance().RemoveRingBuffer(POLICY_RING_BUFFER_NAME);
 }
 
 void NetsysBpfRingBuffer::ListenNetworkStatsEvent(void)
 {
-    ffrt::submit(ListenNetStatsRingBufferThread, {}, {}, ffrt::task_attr().name("ListenNetStatsRingBufferThread"));
+    auto &consumer = NetsysBpfRingBufferConsumer::GetInstance();
+    if (consumer.AddRingBuffer(NET_STATS_RING_BUFFER_NAME, NET_STATS_RING_BUFFER_MAP_PATH, HandleNetStatsEvents,
+                               NET_STATS_EVENT_QUEUE_CAPACITY) == NETMANAGER_SUCCESS) {
+        consumer.Start();
+    }
 }
 
 void NetsysBpfRingBuffer::ExistNetstatsRingBufferPoll()
 {
-    existNetStatsThread_ = false;
+    NetsysBpfRingBufferConsumer::GetInstance().RemoveRingBuffer(NET_STATS_RING_BUFFER_NAME);
 }
 }
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bpf_ring_buffer_consumer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <iterator>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "bpf_ring_buffer.h"
+#include "ffrt.h"
+#include "ffrt_inner.h"
+#include "libbpf.h"
+#include "net_manager_constants.h"
+#include "netnative_log_wrapper.h"
+
+namespace OHOS::NetManagerStandard {
+namespace {
+constexpr int32_t EPOLL_MAX_EVENTS = 2;
+constexpr int32_t EPOLL_WAIT_INFINITE = -1;
+}
+
+NetsysBpfRingBufferConsumer::~NetsysBpfRingBufferConsumer()
+{
+    Stop();
+    // The loop uses the manager until it returns, it is freed only after that
+    if (loopTask_ != nullptr) {
+        ffrt::wait({loopTask_});
+    }
+    for (const auto &source : sources_) {
+        // Waits for a running batch, a source must not outlive the queue it is dispatched on
+        source->dispatchQueue = nullptr;
+    }
+    if (ringBuffer_ != nullptr) {
+        ring_buffer__free(ringBuffer_);
+    }
+    for (const auto &source : sources_) {
+        close(source->mapFd);
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+}
+
+NetsysBpfRingBufferConsumer &NetsysBpfRingBufferConsumer::GetInstance()
+{
+    static NetsysBpfRingBufferConsumer instance;
+    return instance;
+}
+
+int32_t NetsysBpfRingBufferConsumer::InitEpoll()
+{
+    if (epollFd_ >= 0) {
+        return NETMANAGER_SUCCESS;
+    }
+    int32_t epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        NETNATIVE_LOGE("RingBufferConsumer: epoll_create1 failed, errno=%{public}d", errno);
+        return NETMANAGER_ERROR;
+    }
+    int32_t wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    if (wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0) {
+        NETNATIVE_LOGE("RingBufferConsumer: add wake fd failed, errno=%{public}d", errno);
+        close(epollFd);
+        if (wakeFd >= 0) {
+            close(wakeFd);
+        }
+        return NETMANAGER_ERROR;
+    }
+    epollFd_ = epollFd;
+    wakeFd_ = wakeFd;
+    return NETMANAGER_SUCCESS;
+}
+
+std::shared_ptr<NetsysBpfRingBufferConsumer::RingBufferSource> NetsysBpfRingBufferConsumer::FindSource(
+    const std::string &name)
+{
+    for (const auto &source : sources_) {
+        if (source->name == name) {
+            return source;
+        }
+    }
+    return nullptr;
+}
+
+int32_t NetsysBpfRingBufferConsumer::AddRingBuffer(const std::string &name, const std::string &path,
+                                                   const BatchHandler &handler, size_t queueCapacity)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto existing = FindSource(name);
+    if (existing != nullptr) {
+        std::lock_guard<std::mutex> sourceGuard(existing->mutex);
+        existing->handler = handler;
+        existing->capacity = queueCapacity;
+        return NETMANAGER_SUCCESS;
+    }
+    if (InitEpoll() != NETMANAGER_SUCCESS) {
+        return NETMANAGER_ERROR;
+    }
+    int32_t mapFd = NetsysBpfRingBuffer::GetRingbufFd(path, 0);
+    if (mapFd < 0) {
+        NETNATIVE_LOGE("RingBufferConsumer: get %{public}s failed, errno=%{public}d", path.c_str(), errno);
+        return NETMANAGER_ERROR;
+    }
+    auto source = std::make_shared<RingBufferSource>();
+    source->name = name;
+    source->mapFd = mapFd;
+    source->capacity = queueCapacity;
+    source->handler = handler;
+    source->dispatchQueue = std::make_shared<ffrt::queue>(("RingBuffer_" + name).c_str());
+
+    // The first ring creates the manager, its epoll fd then joins ours and reports every ring added after
+    int32_t ret = 0;
+    if (ringBuffer_ == nullptr) {
+        ringBuffer_ = NewRingBuffer({source});
+        ret = ringBuffer_ == nullptr ? -1 : 0;
+    } else {
+        ret = ring_buffer__add(ringBuffer_, mapFd, OnRecord, source.get());
+    }
+    if (ret != 0) {
+        NETNATIVE_LOGE("RingBufferConsumer: add %{public}s failed, errno=%{public}d", name.c_str(), errno);
+        close(mapFd);
+        return NETMANAGER_ERROR;
+    }
+    sources_.emplace_back(source);
+    NETNATIVE_LOGI("RingBufferConsumer: %{public}s added, queue capacity %{public}zu", name.c_str(), queueCapacity);
+    return NETMANAGER_SUCCESS;
+}
+
+ring_buffer *NetsysBpfRingBufferConsumer::NewRingBuffer(
+    const std::vector<std::shared_ptr<RingBufferSource>> &sources)
+{
+    if (sources.empty()) {
+        return nullptr;
+    }
+    ring_buffer *ringBuffer = ring_buffer__new(sources.front()->mapFd, OnRecord, sources.front().get(), nullptr);
+    if (ringBuffer == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = 1; i < sources.size(); i++) {
+        if (ring_buffer__add(ringBuffer, sources[i]->mapFd, OnRecord, sources[i].get()) != 0) {
+            ring_buffer__free(ringBuffer);
+            return nullptr;
+        }
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = ring_buffer__epoll_fd(ringBuffer);
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, event.data.fd, &event) != 0) {
+        ring_buffer__free(ringBuffer);
+        return nullptr;
+    }
+    return ringBuffer;
+}
+
+void NetsysBpfRingBufferConsumer::RemoveRingBuffer(const std::string &name)
+{
+    std::shared_ptr<ffrt::queue> dispatchQueue;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto source = FindSource(name);
+        if (source == nullptr) {
+            return;
+        }
+        // libbpf cannot take a ring out of its manager, so the manager is built again from the other rings
+        std::vector<std::shared_ptr<RingBufferSource>> remaining;
+        std::copy_if(sources_.begin(), sources_.end(), std::back_inserter(remaining),
+                     [&source](const auto &other) { return other != source; });
+        ring_buffer *ringBuffer = NewRingBuffer(remaining);
+        if (!remaining.empty() && ringBuffer == nullptr) {
+            // The old manager keeps the ring, which must then outlive it, its records are discarded
+            NETNATIVE_LOGE("RingBufferConsumer: remove %{public}s failed, errno=%{public}d", name.c_str(), errno);
+            std::lock_guard<std::mutex> sourceGuard(source->mutex);
+            source->handler = nullptr;
+            source->pending.clear();
+            return;
+        }
+        // Consumed under mutex_ only, so the loop never sees the manager being swapped
+        (void)epoll_ctl(epollFd_, EPOLL_CTL_DEL, ring_buffer__epoll_fd(ringBuffer_), nullptr);
+        ring_buffer__free(ringBuffer_);
+        ringBuffer_ = ringBuffer;
+        sources_.swap(remaining);
+        close(source->mapFd);
+        std::lock_guard<std::mutex> sourceGuard(source->mutex);
+        source->handler = nullptr;
+        source->pending.clear();
+        dispatchQueue.swap(source->dispatchQueue);
+    }
+    // Waits for a running batch of the ring, which must not hold any lock it takes
+    dispatchQueue = nullptr;
+    NETNATIVE_LOGI("RingBufferConsumer: %{public}s removed", name.c_str());
+}
+
+int32_t NetsysBpfRingBufferConsumer::Start()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (ringBuffer_ == nullptr) {
+        NETNATIVE_LOGE("RingBufferConsumer: no ring buffer added");
+        return NETMANAGER_ERROR;
+    }
+    running_ = true;
+    // A loop that is still winding down after Stop sees running_ again and carries on
+    if (!loopExited_) {
+        return NETMANAGER_SUCCESS;
+    }
+    loopExited_ = false;
+    loopTask_ = ffrt::submit_h([this]() { ConsumeLoop(); }, {}, {}, ffrt::task_attr().name("RingBufferConsumer"));
+    return NETMANAGER_SUCCESS;
+}
+
+void NetsysBpfRingBufferConsumer::Stop()
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    running_ = false;
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        (void)write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void NetsysBpfRingBufferConsumer::ConsumeLoop()
+{
+    NETNATIVE_LOGI("RingBufferConsumer: consume loop start");
+    epoll_event events[EPOLL_MAX_EVENTS];
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!running_) {
+                loopExited_ = true;
+                break;
+            }
+        }
+        if (ffrt::this_task::get_id() != 0) {
+            ffrt::sync_io(epollFd_);
+        }
+        int32_t count = epoll_wait(epollFd_, events, EPOLL_MAX_EVENTS, EPOLL_WAIT_INFINITE);
+        if (count < 0 && errno != EINTR) {
+            NETNATIVE_LOGE("RingBufferConsumer: epoll_wait failed, errno=%{public}d", errno);
+            std::lock_guard<std::mutex> guard(mutex_);
+            running_ = false;
+            continue;
+        }
+        for (int32_t i = 0; i < count; i++) {
+            if (events[i].data.fd == wakeFd_) {
+                uint64_t value = 0;
+                (void)read(wakeFd_, &value, sizeof(value));
+            }
+        }
+        Drain();
+    }
+    NETNATIVE_LOGI("RingBufferConsumer: consume loop exit");
+}
+
+void NetsysBpfRingBufferConsumer::Drain()
+{
+    std::vector<std::shared_ptr<RingBufferSource>> sources;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        // The last ring was removed
+        if (ringBuffer_ == nullptr) {
+            return;
+        }
+        // Reads whatever every ring holds, OnRecord only queues, so this does not wait on any handler
+        int32_t consumed = ring_buffer__consume(ringBuffer_);
+        if (consumed < 0) {
+            NETNATIVE_LOGE("RingBufferConsumer: consume failed, ret=%{public}d", consumed);
+        }
+        sources = sources_;
+    }
+    // Whatever a ring got in this drain goes to its handler as one batch
+    for (const auto &source : sources) {
+        std::lock_guard<std::mutex> guard(source->mutex);
+        if (source->pending.empty() || source->dispatchScheduled || source->dispatchQueue == nullptr) {
+            continue;
+        }
+        source->dispatchScheduled = true;
+        std::weak_ptr<RingBufferSource> weakSource = source;
+        source->dispatchQueue->submit([weakSource]() {
+            auto source = weakSource.lock();
+            if (source != nullptr) {
+                Dispatch(source);
+            }
+        });
+    }
+}
+
+int NetsysBpfRingBufferConsumer::OnRecord(void *ctx, void *data, size_t size)
+{
+    auto source = static_cast<RingBufferSource *>(ctx);
+    if (source == nullptr || data == nullptr) {
+        return RING_BUFFER_ERR_NONE;
+    }
+    std::lock_guard<std::mutex> guard(source->mutex);
+    if (source->handler == nullptr) {
+        return RING_BUFFER_ERR_NONE;
+    }
+    source->stats.received++;
+    if (source->pending.size() >= source->capacity) {
+        source->stats.dropped++;
+        return RING_BUFFER_ERR_NONE;
+    }
+    if (source->pending.empty()) {
+        source->oldestQueued = std::chrono::steady_clock::now();
+    }
+    auto bytes = static_cast<const uint8_t *>(data);
+    source->pending.emplace_back(bytes, bytes + size);
+    // A non zero return would stop the drain of every ring
+    return RING_BUFFER_ERR_NONE;
+}
+
+void NetsysBpfRingBufferConsumer::Dispatch(const std::shared_ptr<RingBufferSource> &source)
+{
+    std::vector<RingBufferRecord> batch;
+    BatchHandler handler;
+    uint64_t newDrops = 0;
+    {
+        std::lock_guard<std::mutex> guard(source->mutex);
+        source->dispatchScheduled = false;
+        batch.swap(source->pending);
+        handler = source->handler;
+        if (batch.empty() || handler == nullptr) {
+            return;
+        }
+        auto lag = std::chrono::steady_clock::now() - source->oldestQueued;
+        source->stats.lastLagUs =
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(lag).count());
+        source->stats.maxLagUs = std::max(source->stats.maxLagUs, source->stats.lastLagUs);
+        newDrops = source->stats.dropped - source->reportedDrops;
+        source->reportedDrops = source->stats.dropped;
+    }
+    if (newDrops != 0) {
+        NETNATIVE_LOGW("RingBufferConsumer: %{public}s dropped %{public}" PRIu64 " records, queue full",
+                       source->name.c_str(), newDrops);
+    }
+    handler(batch);
+    std::lock_guard<std::mutex> guard(source->mutex);
+    source->stats.dispatched += batch.size();
+    source->stats.batches++;
+}
+
+bool NetsysBpfRingBufferConsumer::GetStats(const std::string &name, RingBufferStats &stats)
+{
+    std::shared_ptr<RingBufferSource> source;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        source = FindSource(name);
+    }
+    if (source == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(source->mutex);
+    stats = source->stats;
+    stats.pending = source->pending.size();
+    return true;
+}
+
+void NetsysBpfRingBufferConsumer::GetDumpInfo(std::string &info)
+{
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (const auto &source : sources_) {
+            names.emplace_back(source->name);
+        }
+    }
+    for (const auto &name : names) {
+        RingBufferStats stats;
+        if (!GetStats(name, stats)) {
+            continue;
+        }
+        info.append("\tRing buffer " + name + ": received " + std::to_string(stats.received) + ", dropped " +
+                    std::to_string(stats.dropped) + ", dispatched " + std::to_string(stats.dispatched) + " in " +
+                    std::to_string(stats.batches) + " batches, pending " + std::to_string(stats.pending) +
+                    ", lag " + std::to_string(stats.lastLagUs) + "us, max lag " + std::to_string(stats.maxLagUs) +
+                    "us\n");
+    }
+}
+} // namespace OHOS::NetManagerStandard
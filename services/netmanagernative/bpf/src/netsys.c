@@ -10,11 +10,15 @@
 #include <linux/if_packet.h>
 #include <linux/if.h>
 #include <linux/if_ether.h>
+#include <linux/in.h>
+#include <linux/in6.h>
+#include <linux/pkt_cls.h>
 #include <linux/string.h>
 #include <string.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#include <bpf/bpf_endian.h>
 #include "bpf_helpers.h"
 #include "bpf_def.h"
 
@@ -34,6 +38,9 @@ static const int32_t OH_SOCK_PERMISSION_MAP_SIZE = 200;
 static const int32_t BROKER_SOCK_PERMISSION_MAP_SIZE = 1;
 static const int32_t UID_ACCESS_POLICY_ARRAY_SIZE = 1000;
 static const int32_t NET_NS_MAP_SIZE = 2000;
+static const int32_t FIREWALL_UID_MAP_SIZE = 5000;
+static const int32_t BANDWIDTH_UID_MAP_SIZE = 5000;
+static const int32_t PROCESS_SOCK_MARK_MAP_SIZE = 200;
 #else
 static const int32_t APP_STATS_MAP_SIZE = 5000;
 static const int32_t APP_STATS_MAP_SIZE_MIN = 5000;
@@ -44,8 +51,13 @@ static const int32_t OH_SOCK_PERMISSION_MAP_SIZE = 1000;
 static const int32_t BROKER_SOCK_PERMISSION_MAP_SIZE = 1000;
 static const int32_t UID_ACCESS_POLICY_ARRAY_SIZE = 65535;
 static const int32_t NET_NS_MAP_SIZE = 5000;
+static const int32_t FIREWALL_UID_MAP_SIZE = 65535;
+static const int32_t BANDWIDTH_UID_MAP_SIZE = 65535;
+static const int32_t PROCESS_SOCK_MARK_MAP_SIZE = 2000;
 #endif
 static const int32_t TRAFFIC_INCREASE_MAP_SIZE = 9;
+static const int32_t BANDWIDTH_LIMIT_MAP_SIZE = 64;
+static const int32_t TETHER_STATS_MAP_SIZE = 64;
 static const uint32_t TRAFFIC_NOTIFY_TYPE = 3;
 
 // network stats begin
@@ -179,7 +191,7 @@ static inline __u8 socket_ringbuf_net_stats_event_submit(__u8 flag)
     return 0;
 }
 
-static inline __u32 get_data_len(struct __sk_buff *skb)
+static inline __attribute__((always_inline)) __u32 get_data_len(struct __sk_buff *skb)
 {
     __u32 length = skb->len;
     __u32 packages = skb->gso_segs;
@@ -551,6 +563,261 @@ static __u32 rgm_stats_tx_count(struct __sk_buff *skb, __u64 sock_uid)
     return 0;
 }
 
+// uid firewall chains begin
+static const __u32 FIREWALL_IPV4_PROTOCOL_OFFSET = 9;
+static const __u32 FIREWALL_IPV6_NEXTHDR_OFFSET = 6;
+static const __u32 FIREWALL_TCP_FLAGS_OFFSET = 13;
+static const __u8 FIREWALL_TCP_FLAG_RST = 0x04;
+static const __u8 FIREWALL_ICMPV6_NEIGHBOUR_SOLICITATION = 135;
+static const __u8 FIREWALL_ICMPV6_NEIGHBOUR_ADVERTISEMENT = 136;
+
+bpf_map_def SEC("maps") firewall_uid_map = {
+    .type = BPF_MAP_TYPE_HASH,
+    .key_size = sizeof(firewall_uid_key),
+    .value_size = sizeof(firewall_uid_value),
+    .max_entries = FIREWALL_UID_MAP_SIZE,
+    .map_flags = BPF_F_NO_PREALLOC,
+    .inner_map_idx = 0,
+    .numa_node = 0,
+};
+
+bpf_map_def SEC("maps") firewall_chain_map = {
+    .type = BPF_MAP_TYPE_ARRAY,
+    .key_size = sizeof(firewall_chain_key),
+    .value_size = sizeof(firewall_chain_value),
+    .max_entries = 1,
+    .map_flags = 0,
+    .inner_map_idx = 0,
+    .numa_node = 0,
+};
+
+// Packets every chain lets through whatever the uid: TCP resets, and IPv6 neighbour discovery
+static inline __u8 is_firewall_exempt_packet(struct __sk_buff *skb)
+{
+    __u8 protocol = 0;
+    __u32 l4_offset = 0;
+    if (skb->protocol == bpf_htons(ETH_P_IP)) {
+        __u8 version_ihl = 0;
+        if (bpf_skb_load_bytes(skb, 0, &version_ihl, sizeof(version_ihl)) < 0 ||
+            bpf_skb_load_bytes(skb, FIREWALL_IPV4_PROTOCOL_OFFSET, &protocol, sizeof(protocol)) < 0) {
+            return 0;
+        }
+        l4_offset = (version_ihl & 0x0F) << 2;
+    } else if (skb->protocol == bpf_htons(ETH_P_IPV6)) {
+        if (bpf_skb_load_bytes(skb, FIREWALL_IPV6_NEXTHDR_OFFSET, &protocol, sizeof(protocol)) < 0) {
+            return 0;
+        }
+        l4_offset = IPV6_HEADER_LENGTH;
+        if (protocol == IPPROTO_ICMPV6) {
+            __u8 icmp_type = 0;
+            if (bpf_skb_load_bytes(skb, l4_offset, &icmp_type, sizeof(icmp_type)) < 0) {
+                return 0;
+            }
+            return icmp_type == FIREWALL_ICMPV6_NEIGHBOUR_SOLICITATION ||
+                icmp_type == FIREWALL_ICMPV6_NEIGHBOUR_ADVERTISEMENT;
+        }
+    } else {
+        return 0;
+    }
+    if (protocol != IPPROTO_TCP) {
+        return 0;
+    }
+    __u8 tcp_flags = 0;
+    if (bpf_skb_load_bytes(skb, l4_offset + FIREWALL_TCP_FLAGS_OFFSET, &tcp_flags, sizeof(tcp_flags)) < 0) {
+        return 0;
+    }
+    return (tcp_flags & FIREWALL_TCP_FLAG_RST) != 0;
+}
+
+// Returns 0 when an enabled chain drops the packet: an allowed list chain the uid is not in,
+// or the denied list chain the uid is in. One lookup per map whatever the number of uids.
+static inline __u8 check_firewall_uid_chains(struct __sk_buff *skb, __u32 uid)
+{
+    firewall_chain_key chain_key = FIREWALL_CHAIN_CONFIG_KEY;
+    firewall_chain_value *chain = bpf_map_lookup_elem(&firewall_chain_map, &chain_key);
+    if (chain == NULL || chain->enabledChains == 0) {
+        return 1;
+    }
+    firewall_uid_value uid_chains = 0;
+    firewall_uid_value *uid_value = bpf_map_lookup_elem(&firewall_uid_map, &uid);
+    if (uid_value != NULL) {
+        uid_chains = *uid_value;
+    }
+    // The allowed box only exempts from the allowed list chains, as the jump to it came from them alone
+    __u32 allowed_list_chains = chain->enabledChains & (FIREWALL_CHAIN_DOZABLE | FIREWALL_CHAIN_POWERSAVING);
+    __u8 is_denied = (allowed_list_chains & ~uid_chains) != 0 && (uid_chains & FIREWALL_CHAIN_ALLOWED_LIST_BOX) == 0 &&
+        uid > FIREWALL_SYSTEM_UID_MAX && uid <= chain->maxUid;
+    if ((chain->enabledChains & FIREWALL_CHAIN_UNDOZABLE) && (uid_chains & FIREWALL_CHAIN_UNDOZABLE)) {
+        is_denied = 1;
+    }
+    if (!is_denied || skb->ifindex == LOOPBACK_IFINDEX || is_firewall_exempt_packet(skb)) {
+        return 1;
+    }
+    return 0;
+}
+// uid firewall chains end
+
+// bandwidth data saver and quotas begin
+bpf_map_def SEC("maps") bandwidth_uid_map = {
+    .type = BPF_MAP_TYPE_HASH,
+    .key_size = sizeof(bandwidth_uid_key),
+    .value_size = sizeof(bandwidth_uid_value),
+    .max_entries = BANDWIDTH_UID_MAP_SIZE,
+    .map_flags = BPF_F_NO_PREALLOC,
+    .inner_map_idx = 0,
+    .numa_node = 0,
+};
+
+// An iface with a quota entry is costly, the data saver lists only apply to it
+bpf_map_def SEC("maps") bandwidth_limit_map = {
+    .type = BPF_MAP_TYPE_HASH,
+    .key_size = sizeof(bandwidth_limit_key),
+    .value_size = sizeof(bandwidth_limit_value),
+    .max_entries = BANDWIDTH_LIMIT_MAP_SIZE,
+    .map_flags = 0,
+    .inner_map_idx = 0,
+    .numa_node = 0,
+};
+
+bpf_map_def SEC("maps") bandwidth_config_map = {
+    .type = BPF_MAP_TYPE_ARRAY,
+    .key_size = sizeof(bandwidth_config_key),
+    .value_size = sizeof(bandwidth_config_value),
+    .max_entries = 1,
+    .map_flags = 0,
+    .inner_map_idx = 0,
+    .numa_node = 0,
+};
+
+// Returns 1 once the limit is exceeded. The packet crossing it sends the event, only once per limit.
+static inline __u8 account_bandwidth_limit(struct __sk_buff *skb, bandwidth_limit_key *key,
+                                           bandwidth_limit_value *value)
+{
+    __sync_fetch_and_add(&value->usedBytes, skb->len);
+    if (value->usedBytes <= value->limitBytes) {
+        return 0;
+    }
+    // Packets crossing the limit together on several cpus race here, only the one that flips the flag sends
+    if (__sync_val_compare_and_swap(&value->notified, 0, 1) == 0) {
+        bandwidth_limit_event *e = bpf_ringbuf_reserve(&net_stats_ringbuf_map, sizeof(*e), 0);
+        if (e != NULL) {
+            e->limit = *key;
+            e->ifIndex = skb->ifindex;
+            bpf_ringbuf_submit(e, 0);
+        }
+    }
+    return 1;
+}
+
+static inline void account_bandwidth_alerts(struct __sk_buff *skb)
+{
+    bandwidth_limit_key key = {.ifIndex = BANDWIDTH_GLOBAL_IFINDEX, .type = BANDWIDTH_LIMIT_ALERT};
+    bandwidth_limit_value *value = bpf_map_lookup_elem(&bandwidth_limit_map, &key);
+    if (value != NULL) {
+        account_bandwidth_limit(skb, &key, value);
+    }
+    key.ifIndex = skb->ifindex;
+    value = bpf_map_lookup_elem(&bandwidth_limit_map, &key);
+    if (value != NULL) {
+        account_bandwidth_limit(skb, &key, value);
+    }
+}
+
+static inline __u8 is_data_saver_denied(__u32 uid)
+{
+    bandwidth_uid_value uid_lists = 0;
+    bandwidth_uid_value *uid_value = bpf_map_lookup_elem(&bandwidth_uid_map, &uid);
+    if (uid_value != NULL) {
+        uid_lists = *uid_value;
+    }
+    if (uid_lists & BANDWIDTH_UID_DENIED) {
+        return 1;
+    }
+    if ((uid_lists & BANDWIDTH_UID_ALLOWED) || uid <= FIREWALL_SYSTEM_UID_MAX) {
+        return 0;
+    }
+    bandwidth_config_key config_key = BANDWIDTH_CONFIG_KEY;
+    bandwidth_config_value *config = bpf_map_lookup_elem(&bandwidth_config_map, &config_key);
+    return config != NULL && config->dataSaverEnabled != 0;
+}
+
+// Returns 0 when the packet is dropped: the quota of its costly iface is used up, or on egress,
+// the uid is in the denied list, or data saver is on and the uid is in neither list.
+// Forced inline like get_data_len, as the loader does not relocate calls out of the program section.
+static inline __attribute__((always_inline)) __u8 check_bandwidth(struct __sk_buff *skb, __u32 uid, __u8 is_egress)
+{
+    account_bandwidth_alerts(skb);
+    bandwidth_limit_key key = {.ifIndex = skb->ifindex, .type = BANDWIDTH_LIMIT_QUOTA};
+    bandwidth_limit_value *quota = bpf_map_lookup_elem(&bandwidth_limit_map, &key);
+    if (quota == NULL) {
+        return 1;
+    }
+    if (is_egress && is_data_saver_denied(uid)) {
+        return 0;
+    }
+    return account_bandwidth_limit(skb, &key, quota) == 0;
+}
+// bandwidth data saver and quotas end
+
+// tethering counters begin
+static const __u32 TETHER_IPV4_TOTAL_LENGTH_OFFSET = 2;
+static const __u32 TETHER_IPV6_PAYLOAD_LENGTH_OFFSET = 4;
+
+// Only the directions netsys added an entry for when sharing started are counted
+bpf_map_def SEC("maps") tether_stats_map = {
+    .type = BPF_MAP_TYPE_HASH,
+    .key_size = sizeof(tether_stats_key),
+    .value_size = sizeof(tether_stats_value),
+    .max_entries = TETHER_STATS_MAP_SIZE,
+    .map_flags = 0,
+    .inner_map_idx = 0,
+    .numa_node = 0,
+};
+
+// The IP packet length, as the iptables counters of the forward chain see it, whatever the link header
+static inline __u32 get_tether_ip_len(struct __sk_buff *skb)
+{
+    __u16 len = 0;
+    if (skb->protocol == bpf_htons(ETH_P_IP)) {
+        if (bpf_skb_load_bytes_relative(skb, TETHER_IPV4_TOTAL_LENGTH_OFFSET, &len, sizeof(len),
+                                        BPF_HDR_START_NET) < 0) {
+            return 0;
+        }
+        return bpf_ntohs(len);
+    }
+    if (skb->protocol == bpf_htons(ETH_P_IPV6)) {
+        if (bpf_skb_load_bytes_relative(skb, TETHER_IPV6_PAYLOAD_LENGTH_OFFSET, &len, sizeof(len),
+                                        BPF_HDR_START_NET) < 0) {
+            return 0;
+        }
+        return bpf_ntohs(len) + IPV6_HEADER_LENGTH;
+    }
+    return 0;
+}
+
+// Attached to the tc egress hook of the sharing ifaces. A forwarded packet still carries the iface
+// it was received on, so one lookup finds its direction. Never changes the verdict.
+SEC("schedcls/tether/egress")
+int schedcls_tether_egress(struct __sk_buff *skb)
+{
+    if (skb->ingress_ifindex == 0 || skb->ingress_ifindex == skb->ifindex) {
+        return TC_ACT_UNSPEC;
+    }
+    tether_stats_key key = {.inIfIndex = skb->ingress_ifindex, .outIfIndex = skb->ifindex};
+    tether_stats_value *value = bpf_map_lookup_elem(&tether_stats_map, &key);
+    if (value == NULL) {
+        return TC_ACT_UNSPEC;
+    }
+    __u32 len = get_tether_ip_len(skb);
+    if (len == 0) {
+        return TC_ACT_UNSPEC;
+    }
+    __sync_fetch_and_add(&value->packets, 1);
+    __sync_fetch_and_add(&value->bytes, len);
+    return TC_ACT_UNSPEC;
+}
+// tethering counters end
+
 SEC("cgroup_skb/uid/ingress")
 int bpf_cgroup_skb_uid_ingress(struct __sk_buff *skb)
 {
@@ -591,6 +858,10 @@ int bpf_cgroup_skb_uid_ingress(struct __sk_buff *skb)
             return 0;
         }
     }
+    // Only the packets the policy lets through count against the quotas and alerts
+    if (check_bandwidth(skb, (__u32)sock_uid, 0) == 0) {
+        return 0;
+    }
     app_uid_stats_value *value = bpf_map_lookup_elem(&app_uid_stats_map, &sock_uid);
     if (value == NULL) {
         app_uid_stats_value newValue = {};
@@ -651,6 +922,9 @@ int bpf_cgroup_skb_uid_egress(struct __sk_buff *skb)
 #endif
 
     uint64_t sock_uid = bpf_get_socket_uid(skb);
+    if (check_firewall_uid_chains(skb, (__u32)sock_uid) == 0) {
+        return 0;
+    }
     sock_netns_key key_sock_netns1 = sock_uid;
     sock_netns_value *value_sock_netns1 = bpf_map_lookup_elem(&sock_netns_map, &key_sock_netns1);
     sock_netns_key key_sock_netns2 = SOCK_COOKIE_ID_NULL;
@@ -671,6 +945,9 @@ int bpf_cgroup_skb_uid_egress(struct __sk_buff *skb)
             return 0;
         }
     }
+    if (check_bandwidth(skb, (__u32)sock_uid, 1) == 0) {
+        return 0;
+    }
 
     app_uid_stats_value *value = bpf_map_lookup_elem(&app_uid_stats_map, &sock_uid);
     if (value == NULL) {
@@ -728,10 +1005,28 @@ bpf_map_def SEC("maps") broker_sock_permission_map = {
     .max_entries = BROKER_SOCK_PERMISSION_MAP_SIZE,
 };
 
+bpf_map_def SEC("maps") process_sock_mark_map = {
+    .type = BPF_MAP_TYPE_HASH,
+    .key_size = sizeof(process_sock_mark_key),
+    .value_size = sizeof(process_sock_mark_value),
+    .max_entries = PROCESS_SOCK_MARK_MAP_SIZE,
+};
+
+// The netId and VPN protection a process asked netsys for once, instead of one fwmarkd round trip per socket
+static inline void set_process_sock_mark(struct bpf_sock *sk, __u32 uid)
+{
+    process_sock_mark_key key = (__u32)(bpf_get_current_pid_tgid() >> 32);
+    process_sock_mark_value *value = bpf_map_lookup_elem(&process_sock_mark_map, &key);
+    if (value != NULL && value->uid == uid) {
+        sk->mark = value->mark;
+    }
+}
+
 SEC("cgroup_sock/inet_create_socket")
 int inet_create_socket(struct bpf_sock *sk)
 {
     __u64 uid_gid = bpf_get_current_uid_gid();
+    set_process_sock_mark(sk, (__u32)(uid_gid & 0x00000000FFFFFFFF));
     sock_netns_key key_sock_netns1 = uid_gid & 0x00000000FFFFFFFF;
     sock_netns_value value_sock_netns1 = bpf_get_netns_cookie(sk);
     bpf_map_update_elem(&sock_netns_map, &key_sock_netns1, &value_sock_netns1, BPF_NOEXIST);
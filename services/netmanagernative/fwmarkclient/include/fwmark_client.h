@@ -44,9 +44,27 @@ public:
      */
     int32_t ProtectFromVpn(int32_t socketFd);
 
+    /**
+     * Binds every inet socket this process creates from now on to the network designated by {@code netId}.
+     *
+     * The socket marks are then set in the kernel when the socket is created, without a call to netsys.
+     *
+     * @param netId The network, 0 to bind no network
+     * @return NETMANAGER_SUCCESS if netsys marks the sockets of this process
+     */
+    int32_t SelectProcessNetwork(uint32_t netId);
+
+    /**
+     * Protects every inet socket this process creates from now on to the network bypass VPN.
+     *
+     * @return NETMANAGER_SUCCESS if netsys marks the sockets of this process
+     */
+    int32_t ProtectProcessFromVpn();
+
 private:
-    // Sends |data| to the fwmark network, along with |fd| as ancillary data using cmsg(3).
-    int32_t Send(FwmarkCommand *data, int32_t fd);
+    // Sends |data| to the fwmark network, along with |fd| as ancillary data using cmsg(3) for a socket command.
+    // The result netsys answers with is stored in |reply| when it is given.
+    int32_t Send(FwmarkCommand *data, int32_t fd, int32_t *reply = nullptr);
     int32_t HandleError(int32_t ret, int32_t errorCode, int32_t sock);
 };
 #ifdef __cplusplus
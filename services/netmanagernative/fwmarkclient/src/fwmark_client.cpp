@@ -33,6 +33,8 @@ static constexpr const int32_t ERROR_CODE_SOCKETFD_INVALID = -1;
 static constexpr const int32_t ERROR_CODE_CONNECT_FAILED = -2;
 static constexpr const int32_t ERROR_CODE_SENDMSG_FAILED = -3;
 static constexpr const int32_t ERROR_CODE_READ_FAILED = -4;
+static constexpr const int32_t ERROR_CODE_REPLY_FAILED = -5;
+static constexpr const int32_t NO_SOCKET_FD = -1;
 
 FwmarkClient::FwmarkClient() {}
 
@@ -53,7 +55,23 @@ int32_t FwmarkClient::ProtectFromVpn(int32_t socketFd)
     return Send(&command, socketFd);
 }
 
-int32_t FwmarkClient::Send(FwmarkCommand *data, int32_t fd)
+int32_t FwmarkClient::SelectProcessNetwork(uint32_t netId)
+{
+    FwmarkCommand command = {FwmarkCommand::SELECT_PROCESS_NETWORK, netId};
+    int32_t reply = NETMANAGER_ERROR;
+    int32_t ret = Send(&command, NO_SOCKET_FD, &reply);
+    return ret == NETMANAGER_SUCCESS ? reply : ret;
+}
+
+int32_t FwmarkClient::ProtectProcessFromVpn()
+{
+    FwmarkCommand command = {FwmarkCommand::PROTECT_PROCESS_FROM_VPN, 0};
+    int32_t reply = NETMANAGER_ERROR;
+    int32_t ret = Send(&command, NO_SOCKET_FD, &reply);
+    return ret == NETMANAGER_SUCCESS ? reply : ret;
+}
+
+int32_t FwmarkClient::Send(FwmarkCommand *data, int32_t fd, int32_t *reply)
 {
     auto socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (socketFd == -1) {
@@ -76,13 +94,15 @@ int32_t FwmarkClient::Send(FwmarkCommand *data, int32_t fd)
     } cmsgu;
 
     (void)memset_s(cmsgu.cmsg, sizeof(cmsgu.cmsg), 0, sizeof(cmsgu.cmsg));
-    message.msg_control = cmsgu.cmsg;
-    message.msg_controllen = sizeof(cmsgu.cmsg);
-    cmsghdr *const cmsgh = CMSG_FIRSTHDR(&message);
-    cmsgh->cmsg_len = CMSG_LEN(sizeof(fd));
-    cmsgh->cmsg_level = SOL_SOCKET;
-    cmsgh->cmsg_type = SCM_RIGHTS;
-    (void)memcpy_s(CMSG_DATA(cmsgh), CMSG_ALIGN(sizeof(fd)), &fd, sizeof(fd));
+    if (data->cmdId == FwmarkCommand::SELECT_NETWORK || data->cmdId == FwmarkCommand::PROTECT_FROM_VPN) {
+        message.msg_control = cmsgu.cmsg;
+        message.msg_controllen = sizeof(cmsgu.cmsg);
+        cmsghdr *const cmsgh = CMSG_FIRSTHDR(&message);
+        cmsgh->cmsg_len = CMSG_LEN(sizeof(fd));
+        cmsgh->cmsg_level = SOL_SOCKET;
+        cmsgh->cmsg_type = SCM_RIGHTS;
+        (void)memcpy_s(CMSG_DATA(cmsgh), CMSG_ALIGN(sizeof(fd)), &fd, sizeof(fd));
+    }
     int32_t ret = sendmsg(socketFd, &message, 0);
     if (ret < 0) {
         return HandleError(ret, ERROR_CODE_SENDMSG_FAILED, socketFd);
@@ -92,6 +112,12 @@ int32_t FwmarkClient::Send(FwmarkCommand *data, int32_t fd)
     if (ret < 0) {
         return HandleError(ret, ERROR_CODE_READ_FAILED, socketFd);
     }
+    if (reply != nullptr) {
+        if (ret != static_cast<int32_t>(sizeof(error))) {
+            return HandleError(ret, ERROR_CODE_REPLY_FAILED, socketFd);
+        }
+        *reply = error;
+    }
 
     close(socketFd);
     return NETMANAGER_SUCCESS;
@@ -112,6 +138,9 @@ int32_t FwmarkClient::HandleError(int32_t ret, int32_t errorCode, int32_t sock)
         case ERROR_CODE_READ_FAILED:
             NETNATIVE_LOGE("read failed, ret:%{public}d, errno: %{public}d", ret, errno);
             break;
+        case ERROR_CODE_REPLY_FAILED:
+            NETNATIVE_LOGE("reply incomplete, ret:%{public}d", ret);
+            break;
         default:
             break;
     }
@@ -22,6 +22,7 @@
 #include <sys/un.h>
 #include <unistd.h>
 
+#include "fwmark.h"
 #include "fwmark_client.h"
 #include "net_manager_constants.h"
 #include "netnative_log_wrapper.h"
@@ -30,6 +31,9 @@ namespace {
 SocketDispatchType defaultSocketDispatchType;
 std::atomic_int g_netIdForApp(0);
 std::atomic_bool g_protectFromVpn(false);
+// netsys marks the sockets of this process in the kernel, fwmarkd is only asked when a mark is missing
+std::atomic_bool g_netIdMarkedByKernel(false);
+std::atomic_bool g_vpnProtectedByKernel(false);
 std::atomic<const SocketDispatchType*> g_dispatch(&defaultSocketDispatchType);
 std::atomic_bool g_hookFlag(false);
 std::once_flag g_onceFlag;
@@ -37,6 +41,19 @@ const SocketDispatchType* GetDispatch()
 {
     return g_dispatch.load(std::memory_order_relaxed);
 }
+
+OHOS::nmd::Fwmark GetKernelMark(int fd)
+{
+    OHOS::nmd::Fwmark fwmark;
+    if (!g_netIdMarkedByKernel && !g_vpnProtectedByKernel) {
+        return fwmark;
+    }
+    socklen_t len = sizeof(fwmark.intValue);
+    if (getsockopt(fd, SOL_SOCKET, SO_MARK, &fwmark.intValue, &len) != 0) {
+        fwmark.intValue = 0;
+    }
+    return fwmark;
+}
 } // namespace
 
 int HookSocket(int (*fn)(int, int, int), int domain, int type, int protocol)
@@ -50,14 +67,20 @@ int HookSocket(int (*fn)(int, int, int), int domain, int type, int protocol)
         return fd;
     }
 
-    if (g_protectFromVpn && (domain == AF_INET || domain == AF_INET6)) {
+    if (domain != AF_INET && domain != AF_INET6) {
+        return fd;
+    }
+    // A process that netsys lost track of, a forked child say, falls back to fwmarkd
+    OHOS::nmd::Fwmark kernelMark = GetKernelMark(fd);
+    if (g_protectFromVpn && !(g_vpnProtectedByKernel && kernelMark.protectedFromVpn)) {
         NETNATIVE_LOGI("HookSocket ProtectFromVpn %{public}d", fd);
         if (OHOS::nmd::FwmarkClient().ProtectFromVpn(fd) != OHOS::NetManagerStandard::NETMANAGER_SUCCESS) {
             NETNATIVE_LOGE("ProtectFromVpn fd:%{public}d failed", fd);
         }
     }
 
-    if (g_netIdForApp > 0 && (domain == AF_INET || domain == AF_INET6)) {
+    int netId = g_netIdForApp;
+    if (netId > 0 && !(g_netIdMarkedByKernel && kernelMark.explicitlySelected && kernelMark.netId == netId)) {
         if (OHOS::nmd::FwmarkClient().BindSocket(fd, g_netIdForApp) != OHOS::NetManagerStandard::NETMANAGER_SUCCESS) {
             NETNATIVE_LOGE("BindSocket [%{public}d] to netid [%{public}d] failed",
                 fd, g_netIdForApp.load(std::memory_order_relaxed));
@@ -104,6 +127,8 @@ bool ohos_socket_hook_set_hook_flag(bool flag)
 void SetNetForApp(int netId)
 {
     g_netIdForApp = netId;
+    g_netIdMarkedByKernel = OHOS::nmd::FwmarkClient().SelectProcessNetwork(static_cast<uint32_t>(netId)) ==
+        OHOS::NetManagerStandard::NETMANAGER_SUCCESS;
 }
 
 int GetNetForApp()
@@ -114,4 +139,6 @@ int GetNetForApp()
 void SetProtectFromVpn()
 {
     g_protectFromVpn = true;
+    g_vpnProtectedByKernel = OHOS::nmd::FwmarkClient().ProtectProcessFromVpn() ==
+        OHOS::NetManagerStandard::NETMANAGER_SUCCESS;
 }
\ No newline at end of file
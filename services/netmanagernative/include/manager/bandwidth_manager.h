@@ -101,6 +101,29 @@ public:
      */
     int32_t RemoveAllowedList(uint32_t uid);
 
+    /**
+     * Move a set of uids between the denied and allowed lists, writing only the uids that changed
+     *
+     * All or nothing: if one write fails, the uids written before it are set back and both lists stay as they were.
+     *
+     * @param deniedUids Uids that end up only in the denied list
+     * @param allowedUids Uids that end up only in the allowed list
+     * @param removedUids Uids that end up in neither list
+     *
+     * @return NETMANAGER_SUCCESS suceess or NETMANAGER_ERROR failed
+     */
+    int32_t UpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                           const std::vector<uint32_t> &removedUids);
+
+    /**
+     * Apply the quota and alert of an iface that was added after they were set, or unbind them from a removed
+     * iface until it comes back
+     *
+     * @param ifName Iface name
+     * @param added Whether the iface was added or removed
+     */
+    void OnInterfaceChanged(const std::string &ifName, bool added);
+
 private:
     std::string FetchChainName(NetManagerStandard::ChainType chain);
     int32_t InitChain();
@@ -117,6 +140,18 @@ private:
     int32_t SetCostlyAlert(Operate operate, const std::string &iface, int64_t bytes);
     inline void CheckChainInitialization();
     int32_t SetIfaceQuotaDetail(const std::string &ifName, int64_t bytes);
+    int32_t WriteBandwidthLimit(uint32_t ifIndex, uint32_t type, int64_t bytes);
+    int32_t DeleteBandwidthLimit(uint32_t ifIndex, uint32_t type);
+    int32_t BindIfaceLimit(std::map<std::string, uint32_t> &ifaceIndex, const std::string &ifName, uint32_t ifIndex,
+                           uint32_t type, int64_t bytes);
+    int32_t UnbindIfaceLimit(std::map<std::string, uint32_t> &ifaceIndex, const std::string &ifName, uint32_t type);
+    void RebindIfaceLimit(const std::map<std::string, int64_t> &ifaceBytes, std::map<std::string, uint32_t> &ifaceIndex,
+                          const std::string &ifName, uint32_t ifIndex, uint32_t type);
+    int32_t WriteDataSaverConfig(bool enable);
+    int32_t WriteUidListBits(uint32_t uid);
+    int32_t ResetBandwidthMaps();
+    void UpdateListUid(uint32_t uid, bool isAdd, std::unordered_set<uint32_t> &listUids,
+                       std::unordered_set<uint32_t> &changedUids);
 
 private:
     std::atomic<bool> chainInitFlag_ = false;
@@ -125,7 +160,9 @@ private:
     std::mutex bandwidthMutex_;
     std::mutex ifaceAlertMutex_;
     std::map<std::string, int64_t> ifaceAlertBytes_;
+    std::map<std::string, uint32_t> ifaceAlertIndex_;
     std::map<std::string, int64_t> ifaceQuotaBytes_;
+    std::map<std::string, uint32_t> ifaceQuotaIndex_;
     std::unordered_set<uint32_t> deniedListUids_;
     std::unordered_set<uint32_t> allowedListUids_;
 };
@@ -19,6 +19,7 @@
 #include <iostream>
 #include <map>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "iptables_type.h"
@@ -95,6 +96,12 @@ private:
     std::string ReadMaxUidConfig();
     int32_t IsFirewallChian(NetManagerStandard::ChainType chain);
     inline void CheckChainInitialization();
+    static uint8_t FetchChainBit(NetManagerStandard::ChainType chain);
+    // Writes the chain bit of the changed uids only, the bpf program matches a packet with one map lookup
+    int32_t UpdateUidChainBit(uint8_t chainBit, const std::vector<uint32_t> &setUids,
+                              const std::vector<uint32_t> &clearUids);
+    int32_t WriteEnabledChains();
+    int32_t ResetUidChainMaps();
 
 private:
     bool chainInitFlag_;
@@ -102,6 +109,9 @@ private:
     std::mutex firewallMutex_;
     NetManagerStandard::FirewallType firewallType_;
     std::map<NetManagerStandard::ChainType, FirewallChainStatus> firewallChainStatus_;
+    uint32_t enabledChains_;
+    // Mirror of firewall_uid_map, so an update needs no map read
+    std::unordered_map<uint32_t, uint8_t> uidChainBits_;
 };
 } // namespace nmd
 } // namespace OHOS
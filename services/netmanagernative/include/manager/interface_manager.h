@@ -28,6 +28,7 @@ namespace OHOS {
 namespace nmd {
 static const uint32_t INTERFACE_ERR_MAX_LEN = 256;
 constexpr int32_t MAC_ADDRESS_INT_LEN = 6;
+struct InventoryInterface;
 
 class InterfaceManager {
 public:
@@ -83,7 +84,7 @@ public:
                           int socketType);
 
     /**
-     * Get the network interface names
+     * Get the network interface names, from the interface inventory once the netlink listener started it
      *
      * @return Network interface names
      */
@@ -137,6 +138,9 @@ public:
     static int32_t AddVlanIp(const std::string &ifName, uint32_t vlanId, const std::string &ip, uint32_t mask);
 
 private:
+    // Fill in what the ioctls of GetIfaceConfig would answer, iface is nullptr if there is no such link
+    static void FillIfaceConfig(const InventoryInterface *iface, const std::string &ifName,
+                                InterfaceConfigurationParcel &ifaceConfig);
     static int ModifyAddress(uint32_t action, const char *interfaceName, const char *addr, int prefixLen);
     static int32_t AssembleArp(const std::string &ipAddr, const std::string &macAddr,
                                const std::string &ifName, arpreq &req);
@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 
+#include "mptcp_pm_client.h"
+
 namespace OHOS {
 namespace nmd {
 
@@ -42,9 +44,29 @@ public:
     void OnInterfaceAddressUpdated(const std::string &addr, const std::string &ifName);
     void OnInterfaceAddressRemoved(const std::string &addr, const std::string &ifName);
 
+    /**
+     * Queue an address change of a monitored interface, to be applied with the others by FlushAddressChanges
+     *
+     * @param addr Address
+     * @param ifName Interface of the address
+     * @param added Whether the address is added or removed
+     * @return Returns true if the caller has to schedule FlushAddressChanges, false if one is scheduled already
+     *         or the change is of no interest
+     */
+    bool QueueAddressChange(const std::string &addr, const std::string &ifName, bool added);
+
+    // Apply the queued address changes with one request batch to the kernel
+    void FlushAddressChanges();
+
     bool IsMonitoredInterface(const std::string &ifName);
 
 private:
+    struct AddressChange {
+        std::string addr;
+        std::string ifName;
+        bool added = false;
+    };
+
     int32_t AddEndpoint(const std::string &ipAddr, const std::string &ifName);
     int32_t DeleteEndpoint(const std::string &ipAddr, const std::string &ifName);
 
@@ -54,15 +76,18 @@ private:
     std::map<std::string, std::vector<std::string>> ifaceToIpAddrs_;
     int32_t currentSubflows_ = 0;
     int32_t currentAddAddrAccepted_ = 0;
+    // Endpoint ids in use in the kernel, by netsys or anyone else, as of the last sync
+    std::set<int32_t> kernelEndpointIds_;
+    bool endpointsSynced_ = false;
+    MptcpPmClient pmClient_;
+    std::mutex pendingMutex_;
+    std::vector<AddressChange> pendingChanges_;
 
-    int32_t ExecuteMptcpCommand(const std::string &command);
-    int32_t ExecuteMptcpCommand(const std::string &command, std::string &result);
-    std::string BuildEndpointAddCommand(const std::string &ipAddr, const std::string &ifName);
-    std::string BuildEndpointDeleteCommand(int32_t endpointId);
-    std::string BuildLimitsSetCommand(int32_t subflows, int32_t addAddrAccepted);
-    std::string BuildEndpointShowCommand();
-    int32_t GetEndpointId(const std::string &ipAddr, const std::string &ifName);
-    int32_t GetResultId(std::string &result, const std::string &ipAddr, const std::string &ifName);
+    bool IsWantedAddressChange(const AddressChange &change);
+    void ApplyAddressChanges(const std::vector<AddressChange> &changes);
+    int32_t ApplyEndpointChanges(const std::vector<AddressChange> &changes, bool retry = true);
+    int32_t SyncEndpoints();
+    int32_t AllocateEndpointId();
     void UpdateMptcpLimits();
 };
 
@@ -21,7 +21,6 @@
 #include <set>
 #include <string>
 #include <vector>
-#include <regex>
 #include <map>
 #include <shared_mutex>
 #include "iptables_wrapper.h"
@@ -30,6 +29,13 @@
 
 namespace OHOS {
 namespace nmd {
+// Bytes forwarded from inIface to outIface since the forward was added
+struct TetherTrafficCounter {
+    std::string inIface;
+    std::string outIface;
+    int64_t bytes = 0;
+};
+
 class SharingManager {
 public:
     SharingManager();
@@ -117,6 +123,14 @@ private:
     std::mutex interfaceForwardsMutex_;
     std::set<std::string> forwardingRequests_;
     std::set<std::string> interfaceForwards_;
+    struct TetherCounterPair {
+        std::string fromIface;
+        std::string toIface;
+        uint32_t fromIndex = 0;
+        uint32_t toIndex = 0;
+    };
+    // Counted forwards, in the order they were added
+    std::vector<TetherCounterPair> tetherCounterPairs_;
     std::map<std::string, uint8_t> forbidIpsMap_;
     std::map<std::string, bool> enableV6Map_;
     std::shared_ptr<IptablesWrapper> iptablesWrapper_ = nullptr;
@@ -139,11 +153,15 @@ private:
     void SetForwardRules(bool set, const std::string &cmds, std::string &cmdSet);
     void CombineRestoreRules(const std::string &cmds, std::string &cmdSet);
     int32_t QueryCellularSharingTraffic(NetworkSharingTraffic &traffic,
-        const std::string &result, std::string &ifaceName);
+        const std::vector<TetherTrafficCounter> &counters, std::string &ifaceName);
     void QueryDpaCellularSharingTraffic(const std::vector<DpaWifiTrafficReport> &onSharingTraffic,
         NetworkSharingTraffic &traffic, std::string &ifaceName);
-    void GetTraffic(std::smatch &matches, std::string &ifaceName, NetworkSharingTraffic &traffic,
+    void GetTraffic(const TetherTrafficCounter &counter, std::string &ifaceName, NetworkSharingTraffic &traffic,
         bool &isFindTx, bool &isFindRx);
+    void AddTetherCounters(const std::string &fromIface, const std::string &toIface);
+    void RemoveTetherCounters(const std::string &fromIface, const std::string &toIface);
+    void ReleaseTetherCounters(const TetherCounterPair &removed);
+    std::vector<TetherTrafficCounter> ReadTetherCounters();
     int32_t EnableShareUnreachableRoute(RouteManager::TableType tableType);
     int32_t DisableShareUnreachableRoute(RouteManager::TableType tableType);
     void ClearForbidIpRules();
@@ -16,6 +16,8 @@
 #ifndef INCLUDE_TRAFFIC_MANAGER_H
 #define INCLUDE_TRAFFIC_MANAGER_H
 
+#include <cstdint>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -47,6 +49,14 @@ public:
     static long GetAllRxTraffic();
     static long GetAllTxTraffic();
     static void TrafficManagerLog();
+
+private:
+    /**
+     * Counters of every interface from one RTM_GETLINK dump, calls within a short window from the same network
+     * namespace share the dump
+     */
+    static std::shared_ptr<const std::vector<TrafficStatsParcel>> GetTrafficSnapshot();
+    static int32_t DumpInterfaceTraffic(std::vector<TrafficStatsParcel> &stats);
 };
 } // namespace nmd
 } // namespace OHOS
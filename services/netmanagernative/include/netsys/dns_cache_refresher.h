@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETSYS_DNS_CACHE_REFRESHER_H
+#define NETSYS_DNS_CACHE_REFRESHER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dns_config_client.h"
+
+namespace OHOS::nmd {
+constexpr uint16_t DNS_SERVER_PORT = 53;
+constexpr uint16_t DNS_TYPE_A = 1;
+constexpr uint16_t DNS_TYPE_AAAA = 28;
+
+/**
+ * Resolves a cached host again for serve-stale and prefetch.
+ *
+ * Clients query the upstream servers themselves and only hand their answers to the cache,
+ * so nobody would refresh an entry that no client is waiting for. This is a minimal stub
+ * resolver: plain A and AAAA queries over UDP to the nameservers of the network, with the
+ * socket marked by netId so the queries leave through that network.
+ */
+class DnsCacheRefresher {
+public:
+    explicit DnsCacheRefresher(uint16_t serverPort = DNS_SERVER_PORT);
+
+    // Tries the servers in order and returns the records of the first one with an answer
+    int32_t Resolve(uint16_t netId, const std::vector<std::string> &servers, const std::string &hostName,
+                    bool isIpv6Enable, uint32_t timeoutMs, std::vector<AddrInfoWithTtl> &records) const;
+
+    static bool BuildQuery(const std::string &hostName, uint16_t queryId, uint16_t queryType,
+                           std::vector<uint8_t> &packet);
+
+    /*
+     * Appends the records of a NOERROR answer to the queryType question for hostName. The question has to be
+     * echoed back, and only records owned by hostName or by a name its CNAME chain leads to are taken.
+     */
+    static bool ParseAnswer(const uint8_t *packet, size_t len, uint16_t queryId, const std::string &hostName,
+                            uint16_t queryType, std::vector<AddrInfoWithTtl> &records);
+
+private:
+    int32_t QueryServer(uint16_t netId, const std::string &server, const std::string &hostName, bool isIpv6Enable,
+                        uint32_t timeoutMs, std::vector<AddrInfoWithTtl> &records) const;
+
+    uint16_t serverPort_;
+};
+} // namespace OHOS::nmd
+#endif // NETSYS_DNS_CACHE_REFRESHER_H
@@ -129,6 +129,15 @@ public:
      */
     int32_t SetFirewallCurrentUserId(int32_t userId);
 
+    /**
+     * Set the outbound default action of a user, as the kernel domain intercept applies it
+     *
+     * @param userId user id
+     * @param outDefault outbound default action
+     * @return 0 if success or -1 if an error occurred
+     */
+    int32_t SetFirewallDefaultAction(int32_t userId, FirewallRuleAction outDefault);
+
     /**
      * Set firewall rules to native
      *
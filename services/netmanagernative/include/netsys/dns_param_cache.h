@@ -18,16 +18,18 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 
 #include "ffrt.h"
 #include "rwlock.h"
+#include "dns_cache_refresher.h"
 #include "dns_resolv_config.h"
 #include "netnative_log_wrapper.h"
 #include "uid_range.h"
 #ifdef FEATURE_NET_FIREWALL_ENABLE
 #include "netfirewall_parcel.h"
 #include "i_netfirewall_callback.h"
-#include "suffix_match_trie.h"
+#include "domain_label_trie.h"
 #include <unordered_map>
 #endif
 
@@ -58,6 +60,9 @@ public:
 
     std::vector<AddrInfo> GetDnsCache(uint16_t netId, const std::string &hostName);
 
+    // Serve-stale and prefetch for the caches of every network, off unless enabled by parameter
+    void SetCacheRefreshPolicy(const DnsCacheRefreshPolicy &policy);
+
     int32_t GetResolverConfig(uint16_t netId, std::vector<std::string> &servers, std::vector<std::string> &domains,
                               uint16_t &baseTimeoutMsec, uint8_t &retryCount);
 
@@ -95,6 +100,9 @@ public:
 
     int32_t ClearFirewallRules(NetFirewallRuleType type);
 
+    // The outbound default action of a user, a deny rule only loses to an allow rule when it is RULE_ALLOW
+    void SetFirewallDefaultAction(int32_t userId, FirewallRuleAction outDefault);
+
     void SetCallingUid(uint32_t callingUid)
     {
         callingUid_ = callingUid;
@@ -138,6 +146,12 @@ private:
 
     std::map<uint16_t, DnsResolvConfig> serverConfigMap_;
 
+    DnsCacheRefreshPolicy refreshPolicy_;
+
+    std::shared_ptr<DnsCacheRefresher> refresher_;
+
+    void RefreshDnsCache(uint16_t netId, const std::string &hostName);
+
     static std::vector<std::string> SelectNameservers(const std::vector<std::string> &servers);
 
     std::vector<std::string> RemoveDuplicateNameservers(const std::vector<std::string> &servers);
@@ -154,10 +168,52 @@ private:
 
     int32_t SetFirewallDnsRules(const std::vector<sptr<NetFirewallDnsRule>> &ruleList);
 
-    FirewallRuleAction GetFirewallRuleAction(int32_t appUid, const std::vector<sptr<NetFirewallDomainRule>> &rules);
+    // Like the entries of the kernel pass and deny maps, a name can have both
+    struct DomainRuleMatch {
+        bool allow = false;
+        bool deny = false;
+    };
+
+    // The domain rules of one name, keyed by (userId << 32 | appUid), appUid 0 stands for all apps
+    using DomainRuleActions = std::unordered_map<uint64_t, DomainRuleMatch>;
+    using DomainRuleTrie = DomainLabelTrie<DomainRuleActions>;
+
+    static uint64_t MakeDomainRuleKey(int32_t userId, int32_t appUid);
+
+    /**
+     * The name a rule domain covers in the kernel, and the names below it
+     *
+     * As in NetsysBpfNetFirewall::GetDomainHashKey, every '*' is dropped and isWildcard does not matter.
+     *
+     * @return false if the kernel key of the domain can match no query
+     */
+    static bool GetKernelDomainName(const std::string &domain, std::string &name);
+
+    static std::shared_ptr<const DomainRuleTrie> BuildDomainRuleTrie(
+        const std::vector<sptr<NetFirewallDomainRule>> &ruleList);
+
+    void SetFirewallDomainRules(std::shared_ptr<const DomainRuleTrie> trie);
+
+    /**
+     * What the kernel domain intercept does with a query of hostName from appUid
+     *
+     * @return RULE_DENY if the query is dropped, RULE_ALLOW if a rule covers hostName but the query passes,
+     *         RULE_INVALID if no rule covers hostName
+     */
+    FirewallRuleAction GetFirewallRuleAction(int32_t appUid, const std::string &hostName);
 
     std::vector<sptr<NetFirewallDnsRule>> firewallDnsRules_;
 
+    std::vector<sptr<NetFirewallDomainRule>> firewallDomainRules_;
+
+    // Swapped as a whole when the domain rules change, lookups keep the snapshot they started with
+    ffrt::mutex domainRuleMutex_;
+
+    std::shared_ptr<const DomainRuleTrie> domainRuleTrie_;
+
+    // Outbound default actions by userId under domainRuleMutex_, a user without one allows
+    std::unordered_map<int32_t, FirewallRuleAction> firewallOutDefault_;
+
     std::unordered_map<int32_t, std::vector<sptr<NetFirewallDnsRule>>> netFirewallDnsRuleMap_;
 
     uint32_t callingUid_ = 0;
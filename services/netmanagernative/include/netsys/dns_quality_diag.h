@@ -23,6 +23,7 @@
 #include "dns_resolv_config.h"
 #include "netnative_log_wrapper.h"
 #include "dns_quality_event_handler.h"
+#include "dns_server_quality.h"
 #include "i_net_dns_result_callback.h"
 #include "netsys_net_dns_result_data.h"
 #include "dns_config_client.h"
@@ -64,6 +65,12 @@ public:
 
     int32_t HandleEvent(const AppExecFwk::InnerEvent::Pointer &event);
 
+    // for the resolver, reads the streaming statistics without going through the report callbacks
+    int32_t GetServerQuality(uint32_t netId, const std::string &server, DnsServerQualityInfo &info);
+
+    // for dns_manager, drops the statistics of a destroyed network so a reused netId starts afresh
+    void RemoveNetwork(uint32_t netId);
+
 private:
     DnsQualityDiag();
 
@@ -94,6 +101,8 @@ private:
     std::shared_mutex dnsQueryReportMutex_;
     std::list<NetsysNative::NetDnsQueryResultReport> dnsQueryReport_;
 
+    DnsServerQuality serverQuality_;
+
     int32_t InitHandler();
     int32_t query_default_host();
     int32_t handle_dns_loop();
@@ -110,6 +119,8 @@ private:
         AddrInfo* addrinfo, NetsysNative::NetDnsQueryResultReport &report);
     int32_t handle_dns_abnormal(std::shared_ptr<DnsAbnormalInfo> abnormalInfo);
     void ParseDnsSever(uint32_t size, DnsServerInfo* serverInfo, NetsysNative::NetDnsResultReport &report);
+    void AddServerQualityReport(uint32_t netId, const DnsProcessInfoExt &processInfo);
+    void AddFamilyQualityReport(uint32_t netId, const FamilyQueryInfoExt &familyInfo, uint32_t latencyMs);
 };
 } // namespace OHOS::nmd
 #endif // NETSYS_DNS_QUALITY_DIAG_H
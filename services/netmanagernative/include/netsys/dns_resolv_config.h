@@ -24,6 +24,7 @@
 
 #include "delayed_queue.h"
 #include "dns_config_client.h"
+#include "ffrt.h"
 #include "lru_cache.h"
 
 namespace OHOS::nmd {
@@ -32,6 +33,28 @@ static constexpr size_t MAX_NODATA_CACHE_SIZE = 100;
 static constexpr size_t MAX_IPV6_UID_BLACK_LIST_SIZE = 32;
 static constexpr uint64_t MILLIS_PER_SEC = 1000ULL;
 static constexpr uint64_t NANOS_PER_MILLI = 1000000ULL;
+static constexpr size_t MAX_CACHE_STATE_SIZE = 200;
+// RFC 8767 recommends serving stale answers for one to three days at most
+static constexpr uint32_t MAX_DNS_STALE_LIMIT_SEC = 3 * 24 * 60 * 60;
+// A host needs this many hits in one ttl before it is worth resolving ahead of expiry
+static constexpr uint32_t DNS_PREFETCH_MIN_HITS = 3;
+// Prefetch in the last tenth of the ttl, but never closer than 5s to expiry
+static constexpr uint32_t DNS_PREFETCH_WINDOW_DIVISOR = 10;
+static constexpr uint64_t DNS_PREFETCH_MIN_WINDOW_MS = 5000;
+
+struct DnsCacheRefreshPolicy {
+    // Answer from expired records for up to staleLimitSec while they are refreshed
+    bool serveStale = false;
+    uint32_t staleLimitSec = 0;
+    // Refresh popular hosts shortly before their records expire
+    bool prefetch = false;
+};
+
+enum class DnsCacheState {
+    MISS,
+    FRESH,
+    STALE,
+};
 
 class DnsResolvConfig {
 public:
@@ -53,6 +76,17 @@ public:
 
     void SetCacheDelayed(const std::string &hostName);
 
+    // Serve-stale and prefetch, both off by default. Times are in milliseconds from GetNowMs().
+    void SetCacheRefreshPolicy(const DnsCacheRefreshPolicy &policy);
+    DnsCacheRefreshPolicy GetCacheRefreshPolicy();
+    // Counts a hit on the cached records of hostName; needRefresh is set once per ttl for the caller to resolve
+    DnsCacheState CheckCacheState(const std::string &hostName, uint64_t nowMs, bool &needRefresh);
+    // Replaces the records of hostName with a refresh result and starts a new ttl
+    void UpdateCache(const std::string &hostName, const std::vector<AddrInfoWithTtl> &infos, uint64_t nowMs);
+    // A refresh failed, the next hit may try again
+    void FinishRefresh(const std::string &hostName);
+    void ClearCacheState();
+
     bool IsIpv6Enable();
 
     void EnableIpv6(bool enable = true);
@@ -81,10 +115,24 @@ public:
 private:
     uint64_t HashHostName(const std::string &hostName) const;
 
+    struct CacheEntryState {
+        uint64_t filledMs = 0;
+        uint64_t expireMs = 0;
+        uint32_t hitCount = 0;
+        uint32_t generation = 0;
+        bool isRefreshing = false;
+    };
+
+    uint32_t MarkCacheFilled(const std::string &hostName, uint32_t ttl, uint64_t nowMs, bool isRefresh);
+    bool IsCurrentFill(const std::string &hostName, uint32_t generation);
+    void ForgetCacheState(const std::string &hostName);
+    void PruneCacheState(uint64_t nowMs);
+    void ScheduleCacheExpiry(const std::string &hostName, uint32_t generation);
+
 private:
     class DelayedTaskWrapper {
     public:
-        DelayedTaskWrapper(std::string hostName, NetManagerStandard::LRUCache<AddrInfoWithTtl> &cache);
+        DelayedTaskWrapper(std::string hostName, DnsResolvConfig &config, uint32_t generation, uint32_t staleTime);
 
         void Execute() const;
 
@@ -97,7 +145,19 @@ private:
 
         uint32_t remainTime_ = 0;
 
+        DnsResolvConfig &config_;
+
         NetManagerStandard::LRUCache<AddrInfoWithTtl> &cache_;
+
+        // The fill this task expires, a newer fill of the same host schedules its own task
+        uint32_t generation_;
+
+        // Seconds the expired records are kept for serve-stale, waited once after the ttl
+        uint32_t staleTime_;
+
+        mutable bool isStaleWait_ = false;
+
+        mutable bool isSuperseded_ = false;
     };
 
     uint16_t netId_;
@@ -109,6 +169,11 @@ private:
     std::vector<std::string> nameServers_;
     std::vector<std::string> searchDomains_;
     NetManagerStandard::LRUCache<AddrInfoWithTtl> cache_;
+    // Guards refreshPolicy_ and cacheState_, also used from the delayed queue thread
+    ffrt::mutex cacheStateMutex_;
+    DnsCacheRefreshPolicy refreshPolicy_;
+    // Expiry and hit counters of the hosts filled while serve-stale or prefetch is on
+    std::map<std::string, CacheEntryState> cacheState_;
     NetManagerStandard::DelayedQueue<DelayedTaskWrapper, NetManagerStandard::DEFAULT_CAPABILITY, DEFAULT_DELAYED_COUNT>
         delayedQueue_;
     bool isIpv6Enable_;
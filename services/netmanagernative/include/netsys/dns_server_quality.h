@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETSYS_DNS_SERVER_QUALITY_H
+#define NETSYS_DNS_SERVER_QUALITY_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace OHOS::nmd {
+// Latencies above this are counted as this value
+constexpr uint32_t DNS_LATENCY_MAX_MS = 60000;
+// Rcodes 0 to 15 have their own counter, every other return code shares the last one
+constexpr size_t DNS_RCODE_COUNTER_NUM = 17;
+
+/**
+ * Latency distribution in fixed memory with a bounded relative error.
+ *
+ * Bucket boundaries grow geometrically, so every quantile is within 2% of a latency
+ * that was actually recorded, whatever the spread of the samples.
+ */
+class DnsLatencySketch {
+public:
+    static constexpr double RELATIVE_ACCURACY = 0.02;
+    // Bucket 0 holds the zero latencies, the rest cover (0, DNS_LATENCY_MAX_MS]
+    static constexpr size_t BUCKET_NUM = 280;
+
+    void Add(uint32_t latencyMs);
+    uint32_t GetQuantile(double quantile) const;
+    uint64_t GetCount() const;
+    void Clear();
+
+private:
+    std::array<uint32_t, BUCKET_NUM> buckets_ = {};
+    uint64_t count_ = 0;
+};
+
+struct DnsServerQualityInfo {
+    uint64_t queryCount = 0;
+    uint64_t failCount = 0;
+    std::array<uint64_t, DNS_RCODE_COUNTER_NUM> rcodeCount = {};
+    uint32_t latencyP50Ms = 0;
+    uint32_t latencyP90Ms = 0;
+    uint32_t latencyP99Ms = 0;
+    double ewmaLatencyMs = 0;
+    double ewmaSuccessRate = 0;
+    // 1 for a server that always answers at once, falls with failures and with latency
+    double healthScore = 0;
+};
+
+/**
+ * Streaming quality statistics of every (netId, server) the resolver talked to.
+ *
+ * Each report costs a map lookup and a few counter updates, and the memory is bounded by
+ * MAX_SERVER_NUM sketches, so nothing is buffered and nothing is dropped. The resolver can
+ * read the statistics in process to rank the servers of a network.
+ */
+class DnsServerQuality {
+public:
+    static constexpr size_t MAX_SERVER_NUM = 32;
+
+    void AddReport(uint32_t netId, const std::string &server, uint32_t latencyMs, int32_t retCode);
+    bool GetServerQuality(uint32_t netId, const std::string &server, DnsServerQualityInfo &info) const;
+    void RemoveNetwork(uint32_t netId);
+    void Clear();
+
+private:
+    struct ServerStats {
+        DnsLatencySketch latency;
+        DnsServerQualityInfo info;
+        uint64_t lastUpdate = 0;
+    };
+
+    ServerStats &GetServerStats(uint32_t netId, const std::string &server);
+
+    mutable std::mutex mutex_;
+    std::map<std::pair<uint32_t, std::string>, ServerStats> servers_;
+    uint64_t updateSeq_ = 0;
+};
+} // namespace OHOS::nmd
+#endif // NETSYS_DNS_SERVER_QUALITY_H
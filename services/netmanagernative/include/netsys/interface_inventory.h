@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_INTERFACE_INVENTORY_H
+#define INCLUDE_INTERFACE_INVENTORY_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <linux/netlink.h>
+
+#include "netlink_msg.h"
+
+namespace OHOS {
+namespace nmd {
+struct InventoryAddress {
+    std::string addr;
+    uint8_t prefixLen = 0;
+    uint32_t flags = 0; // IFA_F_*
+    std::string label;
+};
+
+struct InventoryInterface {
+    std::string name;
+    int32_t index = 0;
+    uint32_t flags = 0; // IFF_*
+    int32_t mtu = 0;
+    std::string hwAddr; // "00:00:00:00:00:00" if the link has no hardware address
+    std::vector<InventoryAddress> ipv4Addrs;
+    std::vector<InventoryAddress> ipv6Addrs;
+};
+
+/**
+ * The links of the network namespace and their addresses, as the kernel reports them over rtnetlink
+ *
+ * Start seeds the table with a link and an address dump, Update then applies the RTM_NEWLINK, RTM_DELLINK,
+ * RTM_NEWADDR and RTM_DELADDR events of the netlink listener. Every change publishes a new table, readers
+ * take the current one without a lock and keep it as long as they need.
+ */
+class InterfaceInventory {
+public:
+    using Table = std::map<int32_t, InventoryInterface>; // by ifindex
+
+    // The inventory the netlink listener of netsys keeps current
+    static InterfaceInventory &GetInstance();
+
+    InterfaceInventory() = default;
+    ~InterfaceInventory() = default;
+    InterfaceInventory(const InterfaceInventory &) = delete;
+    InterfaceInventory &operator=(const InterfaceInventory &) = delete;
+
+    /**
+     * Dump the links and addresses of the network namespace of the calling thread, replacing the table
+     *
+     * Events received before Start are dropped, so the caller subscribes to them first.
+     *
+     * @return Returns 0 on success, otherwise the negative errno, then there is no table
+     */
+    int32_t Start();
+
+    // Drop the table, to be called when the events stop coming
+    void Stop();
+
+    /**
+     * Query the link and addresses of one interface and replace its entry, the link is dropped if it is gone
+     *
+     * The events of a change reach the table only once the listener has read them, so whoever changes a link
+     * calls this after the change to read it back from the table at once. Nothing is done if not started.
+     *
+     * @return Returns 0 on success, otherwise the negative errno, then the entry waits for the events
+     */
+    int32_t Refresh(const std::string &ifName);
+
+    /**
+     * Apply the link and address events in a buffer received from an RTMGRP_LINK / RTMGRP_IPV*_IFADDR socket
+     *
+     * Other messages are ignored, so is everything before Start.
+     */
+    void Update(const char *buffer, int32_t size);
+
+    // The current table, nullptr if not started
+    std::shared_ptr<const Table> GetSnapshot() const;
+
+    static const InventoryInterface *Find(const Table &table, const std::string &ifName);
+
+    // The address SIOCGIFADDR answers: the first primary IPv4 address labelled with the name of the link
+    static const InventoryAddress *GetPrimaryIpv4Addr(const InventoryInterface &iface);
+
+private:
+    static int32_t Query(int32_t sock, uint32_t &seq, NetlinkMsg msg, Table &table);
+    static int32_t Query(int32_t sock, uint32_t &seq, std::vector<NetlinkMsg> &msgs, Table &table);
+    static int32_t OpenSocket();
+    static void Apply(const nlmsghdr *hdr, Table &table);
+    static void ApplyLink(const nlmsghdr *hdr, Table &table);
+    static void ApplyAddress(const nlmsghdr *hdr, Table &table);
+
+    std::mutex mutex_; // Serializes writers
+    std::shared_ptr<const Table> table_;
+};
+} // namespace nmd
+} // namespace OHOS
+#endif // INCLUDE_INTERFACE_INVENTORY_H
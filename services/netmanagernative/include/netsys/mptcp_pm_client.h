@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_MPTCP_PM_CLIENT_H
+#define INCLUDE_MPTCP_PM_CLIENT_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "netlink_msg.h"
+
+namespace OHOS {
+namespace nmd {
+struct MptcpPmEndpoint {
+    uint8_t id = 0;
+    std::string ipAddr;
+    int32_t ifIndex = 0;
+    uint32_t flags = 0;
+};
+
+struct MptcpPmRequest {
+    enum Op {
+        ADD_ENDPOINT,
+        DELETE_ENDPOINT,
+    } op = ADD_ENDPOINT;
+    MptcpPmEndpoint endpoint;
+    int32_t error = 0; // 0 or the negative errno the kernel answered the request with
+};
+
+/**
+ * Client of the kernel "mptcp_pm" generic netlink family, the in-kernel MPTCP path manager
+ *
+ * One netlink socket is kept open, in the network namespace of the thread that calls Init first.
+ */
+class MptcpPmClient {
+public:
+    MptcpPmClient();
+    ~MptcpPmClient();
+    MptcpPmClient(const MptcpPmClient &) = delete;
+    MptcpPmClient &operator=(const MptcpPmClient &) = delete;
+
+    /**
+     * Open the netlink socket and resolve the id of the family, does nothing once it succeeded
+     *
+     * @return Returns 0 on success, otherwise the negative errno, -ENOENT if the kernel has no MPTCP
+     */
+    int32_t Init();
+
+    /**
+     * Add and delete endpoints, all requests are sent to the kernel in one message
+     *
+     * @param requests Requests, the error of each one is filled in
+     * @return Returns 0 if the kernel answered every request, whatever the answer, otherwise the negative errno
+     */
+    int32_t ApplyBatch(std::vector<MptcpPmRequest> &requests);
+
+    /**
+     * Dump the endpoints of the kernel
+     *
+     * @param endpoints Endpoints
+     * @return Returns 0 on success, otherwise the negative errno
+     */
+    int32_t GetEndpoints(std::vector<MptcpPmEndpoint> &endpoints);
+
+    /**
+     * Set how many subflows a connection creates and how many ADD_ADDR it accepts
+     *
+     * @return Returns 0 on success, otherwise the negative errno
+     */
+    int32_t SetLimits(uint32_t subflows, uint32_t addAddrAccepted);
+
+    /**
+     * Get the limits set by SetLimits
+     *
+     * @return Returns 0 on success, otherwise the negative errno
+     */
+    int32_t GetLimits(uint32_t &subflows, uint32_t &addAddrAccepted);
+
+private:
+    using ReplyHandler = std::function<void(const nlmsghdr *reply)>;
+
+    NetlinkMsg MakeRequest(uint16_t familyId, uint8_t cmd, uint16_t flags = 0);
+    bool AddEndpointAttr(NetlinkMsg &msg, const MptcpPmEndpoint &endpoint, bool withAddress);
+    int32_t ResolveFamily();
+    int32_t Transact(NetlinkMsg &msg, const ReplyHandler &handler = nullptr);
+
+    int32_t socket_ = -1;
+    uint16_t familyId_ = 0;
+    uint32_t seq_ = 0;
+};
+} // namespace nmd
+} // namespace OHOS
+#endif // INCLUDE_MPTCP_PM_CLIENT_H
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETSYSNATIVE_NET_DIAG_NETLINK_COLLECTOR_H
+#define NETSYSNATIVE_NET_DIAG_NETLINK_COLLECTOR_H
+
+#include <functional>
+#include <linux/netlink.h>
+#include <list>
+#include <map>
+#include <string>
+
+#include "netsys_net_diag_data.h"
+
+namespace OHOS {
+namespace nmd {
+/**
+ * Collects the netstat/ifconfig style diagnostics straight from the kernel.
+ *
+ * Sockets come from NETLINK_SOCK_DIAG dumps, routes and interfaces from RTM_GETROUTE,
+ * RTM_GETLINK and RTM_GETADDR dumps, and the results are written into the same parcels
+ * the command output parsers fill.
+ */
+class NetDiagNetlinkCollector final {
+public:
+    NetDiagNetlinkCollector() = default;
+    ~NetDiagNetlinkCollector() = default;
+
+    /**
+     * Get the IPv4 main routing table, the rows netstat -re prints
+     *
+     * @param routeTables Route entries
+     * @return NETMANAGER_SUCCESS if the dump succeeded
+     */
+    int32_t GetRouteTable(std::list<NetsysNative::NetDiagRouteTable> &routeTables);
+
+    /**
+     * Get the sockets of a protocol, the rows netstat prints for it
+     *
+     * @param socketType Protocol to collect, PROTOCOL_TYPE_ALL for every protocol
+     * @param socketsInfo Socket entries
+     * @return NETMANAGER_SUCCESS if the dumps succeeded
+     */
+    int32_t GetSocketsInfo(NetsysNative::NetDiagProtocolType socketType, NetsysNative::NetDiagSocketsInfo &socketsInfo);
+
+    /**
+     * Get the configuration of one or all interfaces, the blocks ifconfig prints
+     *
+     * @param configs Interface configurations
+     * @param ifaceName Interface name, empty for all interfaces
+     * @return NETMANAGER_SUCCESS if the dumps succeeded
+     */
+    int32_t GetInterfaceConfig(std::list<NetsysNative::NetDiagIfaceConfig> &configs, const std::string &ifaceName);
+
+    using DumpCallback = std::function<void(const nlmsghdr *)>;
+
+    /**
+     * Send a netlink dump request and hand every reply message to the callback
+     *
+     * @param protocol Netlink protocol, NETLINK_ROUTE or NETLINK_SOCK_DIAG
+     * @param request Dump request, its sequence number is overwritten
+     * @param callback Called once per message until NLMSG_DONE
+     * @return NETMANAGER_SUCCESS if the dump completed
+     */
+    static int32_t Dump(int32_t protocol, nlmsghdr *request, const DumpCallback &callback);
+
+private:
+    int32_t DumpInetSockets(uint8_t family, uint8_t protocol, bool withProgram,
+                            NetsysNative::NetDiagSocketsInfo &socketsInfo);
+    int32_t DumpUnixSockets(NetsysNative::NetDiagSocketsInfo &socketsInfo);
+    void LoadSocketPrograms();
+    std::string GetUserName(uint32_t uid);
+
+    bool isProgramLoaded_ = false;
+    // socket inode to "pid/name", what netstat -p shows
+    std::map<uint32_t, std::string> socketPrograms_;
+    std::map<uint32_t, std::string> userNames_;
+};
+} // namespace nmd
+} // namespace OHOS
+#endif // NETSYSNATIVE_NET_DIAG_NETLINK_COLLECTOR_H
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETSYSNATIVE_NET_DIAG_PING_ENGINE_H
+#define NETSYSNATIVE_NET_DIAG_PING_ENGINE_H
+
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+
+#include "netsys_net_diag_data.h"
+
+namespace OHOS {
+namespace nmd {
+/**
+ * In-process ICMP/ICMPv6 echo engine backing NetDiagWrapper::PingHost.
+ *
+ * Echo requests go out on an unprivileged datagram ICMP socket, or on a raw socket when the
+ * ping group range does not cover the caller. Sending and receiving share one poll loop so a
+ * slow reply never delays the next request. Round trip times are measured on the monotonic
+ * clock, from just before the request is sent to the moment the reply is read.
+ */
+class NetDiagPingEngine final {
+public:
+    explicit NetDiagPingEngine(const NetsysNative::NetDiagPingOption &pingOption);
+    ~NetDiagPingEngine();
+
+    /**
+     * Run the ping session until count, duration or reply timeout is reached
+     *
+     * @param pingResult Result filled the same way the ping output parser fills it
+     * @return NETMANAGER_SUCCESS if the session ran, NETMANAGER_ERR_INTERNAL if no ICMP socket could be opened
+     */
+    int32_t Run(NetsysNative::NetDiagPingResult &pingResult);
+
+private:
+    bool ResolveDestination();
+    bool OpenSocket();
+    bool ApplySocketOptions();
+    bool SendEcho(uint16_t seq);
+    void ReceiveReplies(NetsysNative::NetDiagPingResult &pingResult);
+    bool ParseReply(const uint8_t *data, size_t len, uint16_t &seq, uint16_t &icmpLen, uint16_t &ttl);
+    void CloseSocket();
+
+    NetsysNative::NetDiagPingOption option_;
+    int32_t family_ = AF_INET;
+    int32_t sockFd_ = -1;
+    bool isRawSocket_ = false;
+    uint16_t ident_ = 0;
+    sockaddr_storage destAddr_ = {};
+    socklen_t destAddrLen_ = 0;
+    std::string destIp_;
+    // Requests still waiting for a reply, sequence to send time in nanoseconds since the epoch
+    std::map<uint16_t, int64_t> pendingEchos_;
+};
+} // namespace nmd
+} // namespace OHOS
+#endif // NETSYSNATIVE_NET_DIAG_PING_ENGINE_H
@@ -49,6 +49,8 @@ public:
     int32_t ExecuteCommandForResult(const std::string &command, std::string &result);
 
 private:
+    void RunPing(const NetDiagPingOption &pingOption, const sptr<INetDiagCallback> &callback);
+    void NotifyPingResult(const NetDiagPingResult &pingResult, const sptr<INetDiagCallback> &callback);
     int32_t GeneratePingCommand(const NetDiagPingOption &pingOption, std::string &command);
     bool IsBlankLine(const std::string &line);
     void ExtractPingResult(const std::string &result, const sptr<INetDiagCallback> &callback);
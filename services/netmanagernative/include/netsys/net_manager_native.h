@@ -132,6 +132,9 @@ public:
     int32_t BandwidthRemoveDeniedList(uint32_t uid);
     int32_t BandwidthAddAllowedList(uint32_t uid);
     int32_t BandwidthRemoveAllowedList(uint32_t uid);
+    int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                                    const std::vector<uint32_t> &removedUids);
+    void BandwidthOnInterfaceChanged(const std::string &ifName, bool added);
 
     int32_t FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids);
     int32_t FirewallSetUidsDeniedListChain(uint32_t chain, const std::vector<uint32_t> &uids);
@@ -154,6 +157,7 @@ public:
     int32_t SetIpv6AutoConf(const std::string &interfaceName, const uint32_t on);
 #ifdef FEATURE_NET_FIREWALL_ENABLE
     int32_t SetFirewallCurrentUserId(int32_t userId);
+    int32_t SetFirewallDefaultAction(int32_t userId, FirewallRuleAction outDefault);
     int32_t SetFirewallRules(NetFirewallRuleType type, const std::vector<sptr<NetFirewallBaseRule>> &ruleList,
                              bool isFinish);
     int32_t ClearFirewallRules(NetFirewallRuleType type);
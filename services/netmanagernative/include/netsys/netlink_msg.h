@@ -22,6 +22,7 @@
 #include <cstring>
 #include <iostream>
 #include <linux/fib_rules.h>
+#include <linux/genetlink.h>
 #include <linux/inet_diag.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
@@ -168,6 +169,23 @@ public:
      */
     void AddLink(uint16_t action, const struct ifinfomsg& ifm);
 
+    /**
+     * Add tcmsg message to nlmsghdr
+     *
+     * @param action Action name
+     * @param tcm Added tcmsg of a qdisc or a filter
+     */
+    void AddTrafficControl(uint16_t action, const struct tcmsg& tcm);
+
+    /**
+     * Add generic netlink header to nlmsghdr
+     *
+     * @param familyId Id of the generic netlink family, it is the message type
+     * @param cmd Command of the family
+     * @param version Version of the family interface
+     */
+    void AddGenl(uint16_t familyId, uint8_t cmd, uint8_t version);
+
     /**
      * Begin adding nested attribute to nlmsghdr
      *
@@ -163,6 +163,19 @@ static ssize_t SendMsgToKernel(struct nlmsghdr *msg, int32_t &kernelSocket);
  * @return Returns number of bytes sent if successful, otherwise returns -1
  */
 int32_t SendNetlinkMsgsToKernel(std::vector<NetlinkMsg> &msgs);
+
+/**
+ * Send netlink messages to kernel at once and receive until each one got its ack, its dump end or an error
+ *
+ * @param sock Netlink socket to send on and to receive from
+ * @param seq Sequence number last used on the socket, advanced by one for each message
+ * @param msgs Vector of netlink message to send, their sequence numbers are set here
+ * @param errors Error of each message from its ack, 0 if the kernel accepted it
+ * @param handler Called with each reply that is neither an ack nor a dump end, may be nullptr
+ * @return Returns 0 if every message got its answer, otherwise the negative errno of send or receive
+ */
+int32_t SendNetlinkMsgsAndWaitAcks(int32_t sock, uint32_t &seq, std::vector<NetlinkMsg> &msgs,
+    std::vector<int32_t> &errors, const std::function<void(const nlmsghdr *reply)> &handler = nullptr);
 } // namespace nmd
 } // namespace OHOS
 #endif // !INCLUDE_NETLINK_SOCKET_H
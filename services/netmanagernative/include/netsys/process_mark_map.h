@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_PROCESS_MARK_MAP_H
+#define INCLUDE_PROCESS_MARK_MAP_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sys/types.h>
+#include <thread>
+
+#include "fwmark_command.h"
+
+namespace OHOS {
+namespace nmd {
+/**
+ * Keeps process_sock_mark_map, from which the cgroup sock_create program marks the sockets of a process
+ *
+ * An entry lives as long as its process: netsys holds a pidfd of every registered process and drops the
+ * entry once the pidfd reports the exit, so a reused pid does not inherit the marks.
+ */
+class ProcessMarkMap {
+public:
+    static ProcessMarkMap &GetInstance();
+
+    /**
+     * Apply SELECT_PROCESS_NETWORK or PROTECT_PROCESS_FROM_VPN to a process
+     *
+     * @param pid Process that sent the command
+     * @param uid Uid of the process
+     * @param command The command
+     * @return NETMANAGER_SUCCESS when the kernel marks the sockets of the process from now on
+     */
+    int32_t Apply(pid_t pid, uid_t uid, const FwmarkCommand &command);
+
+    // Forget a process, its sockets are not marked any more
+    void Remove(pid_t pid);
+
+private:
+    struct ProcessMark {
+        int32_t pidFd = -1;
+        uid_t uid = 0;
+        uint16_t netId = 0;
+        bool protectedFromVpn = false;
+    };
+
+    ProcessMarkMap();
+    ~ProcessMarkMap();
+
+    static uint32_t ToFwmark(const ProcessMark &mark);
+    bool StartWatch();
+    bool WriteMark(pid_t pid, const ProcessMark &mark);
+    void RemoveLocked(pid_t pid);
+    void WatchLoop();
+
+    std::mutex mutex_;
+    std::map<pid_t, ProcessMark> processes_;
+    int32_t epollFd_ = -1;
+    int32_t wakeFd_ = -1;
+    std::thread watchThread_;
+};
+} // namespace nmd
+} // namespace OHOS
+#endif // INCLUDE_PROCESS_MARK_MAP_H
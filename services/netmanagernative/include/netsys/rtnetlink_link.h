@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_RTNETLINK_LINK_H
+#define INCLUDE_RTNETLINK_LINK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+
+namespace OHOS {
+namespace nmd {
+// The attributes of an RTM_NEWLINK message that netsys reads
+struct RtnetlinkLink {
+    int32_t index = 0;
+    uint8_t family = 0;  // AF_UNSPEC for the link itself, AF_BRIDGE for a bridge port
+    uint16_t type = 0;   // ARPHRD_*
+    uint32_t flags = 0;  // IFF_*
+    std::string name;
+    int32_t mtu = 0;
+    uint32_t txQueueLen = 0;
+    std::vector<uint8_t> hwAddr;   // empty if the link has no hardware address
+    rtnl_link_stats64 stats = {};  // counters the kernel did not send stay 0
+};
+
+/**
+ * Parse an RTM_NEWLINK or RTM_DELLINK message
+ *
+ * @param hdr Message of a link dump, a link query or a link event
+ * @param link Filled from the ifinfomsg header and the attributes
+ * @return Returns false if the message is no link message or too short for its header
+ */
+bool ParseRtnetlinkLink(const nlmsghdr *hdr, RtnetlinkLink &link);
+
+/**
+ * Format a hardware address as "00:00:00:00:00:00", missing bytes are 0
+ */
+std::string HwAddrToString(const std::vector<uint8_t> &hwAddr);
+} // namespace nmd
+} // namespace OHOS
+#endif // INCLUDE_RTNETLINK_LINK_H
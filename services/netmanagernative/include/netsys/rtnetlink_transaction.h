@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_RTNETLINK_TRANSACTION_H
+#define INCLUDE_RTNETLINK_TRANSACTION_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "netlink_msg.h"
+
+namespace OHOS {
+namespace nmd {
+/**
+ * Link, address, neighbor and route configuration applied to the kernel as a whole
+ *
+ * The Add and Set methods only queue requests, Commit sends them: one sendmsg creates the links, one more
+ * sends the requests on links, and every request is checked against the ack of the kernel. If any of them
+ * fails, what the others created is deleted again. The netlink socket lives as long as the object.
+ */
+class RtnetlinkTransaction {
+public:
+    RtnetlinkTransaction();
+    ~RtnetlinkTransaction();
+    RtnetlinkTransaction(const RtnetlinkTransaction &) = delete;
+    RtnetlinkTransaction &operator=(const RtnetlinkTransaction &) = delete;
+
+    // Create a veth pair, deleting either end deletes both
+    RtnetlinkTransaction &AddVethPair(const std::string &ifName, const std::string &peerName);
+
+    RtnetlinkTransaction &AddDummyLink(const std::string &ifName);
+
+    // Create a vlan link on a link that exists before the commit
+    RtnetlinkTransaction &AddVlanLink(const std::string &ifName, const std::string &parentName, uint16_t vlanId);
+
+    // Not undone on failure, the links created by the transaction go away with their flags
+    RtnetlinkTransaction &SetLinkUp(const std::string &ifName, bool up);
+
+    // Not undone on failure
+    RtnetlinkTransaction &DeleteLink(const std::string &ifName);
+
+    RtnetlinkTransaction &AddAddress(const std::string &ifName, const std::string &addr, uint8_t prefixLen);
+
+    // Add a permanent neighbor entry, mac is like "02:00:00:00:00:01"
+    RtnetlinkTransaction &AddNeighbor(const std::string &ifName, const std::string &addr, const std::string &mac);
+
+    // Add a unicast route, without nextHop the destination is on the link
+    RtnetlinkTransaction &AddRoute(const std::string &ifName, const std::string &destination, uint8_t prefixLen,
+                                   const std::string &nextHop, uint32_t table);
+
+    /**
+     * Apply the queued requests, the queue is empty afterwards
+     *
+     * @return Returns 0 if the kernel applied every request, otherwise the negative errno of the first one
+     *         that failed, -EINVAL if a request was malformed, then nothing is sent
+     */
+    int32_t Commit();
+
+private:
+    using MsgBuilder = std::function<bool(NetlinkMsg &msg)>;
+
+    struct Request {
+        std::string desc;
+        bool createsLink = false;
+        uint16_t flags = 0;
+        MsgBuilder build;
+        // Builds the request removing what this one created, nullptr if there is nothing to remove
+        MsgBuilder buildUndo;
+    };
+
+    RtnetlinkTransaction &AddLinkRequest(const std::string &ifName, const std::string &kind,
+                                         const MsgBuilder &buildInfo, const std::string &parentName = "");
+    int32_t Apply(const std::vector<const Request *> &requests, std::vector<const Request *> &done);
+    void Rollback(const std::vector<const Request *> &done);
+
+    std::vector<Request> requests_;
+    bool malformed_ = false;
+    int32_t socket_ = -1;
+    uint32_t seq_ = 0;
+};
+} // namespace nmd
+} // namespace OHOS
+#endif // INCLUDE_RTNETLINK_TRANSACTION_H
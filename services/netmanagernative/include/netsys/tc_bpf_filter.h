@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_TC_BPF_FILTER_H
+#define INCLUDE_TC_BPF_FILTER_H
+
+#include <cstdint>
+#include <string>
+
+namespace OHOS {
+namespace nmd {
+/**
+ * Attach a pinned sched_cls program to the egress hook of an iface
+ *
+ * A clsact qdisc is added to the iface when it has none. The program runs in direct action mode
+ * and replaces the one attached before at the same priority.
+ *
+ * @param ifIndex Iface index
+ * @param progPath Path the program is pinned at
+ * @param prio Filter priority, owned by the caller
+ * @return NETMANAGER_SUCCESS or NETMANAGER_ERROR
+ */
+int32_t AttachTcEgressBpf(uint32_t ifIndex, const std::string &progPath, uint16_t prio);
+
+/**
+ * Detach the egress filter of a priority, the clsact qdisc is kept for the other filters
+ *
+ * @param ifIndex Iface index
+ * @param prio Filter priority given to AttachTcEgressBpf
+ * @return NETMANAGER_SUCCESS, also when nothing is attached, or NETMANAGER_ERROR
+ */
+int32_t DetachTcEgressBpf(uint32_t ifIndex, uint16_t prio);
+} // namespace nmd
+} // namespace OHOS
+#endif // INCLUDE_TC_BPF_FILTER_H
@@ -55,6 +55,8 @@ private:
     ssize_t ReceiveMessage(bool isRepair, uid_t &uid);
     int32_t socket_;
     int32_t format_;
+    // Only the rtnetlink socket carries the link and address events of the interface inventory
+    bool isRouteSocket_ = false;
     std::unique_ptr<WrapperListener> listener_;
     char buffer_[NetlinkDefine::BUFFER_SIZE] __attribute__((aligned(4))) = {0};
     EventCallback callback_;
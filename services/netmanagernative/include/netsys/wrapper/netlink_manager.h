@@ -16,8 +16,10 @@
 #ifndef NETLINK_MANAGER_H
 #define NETLINK_MANAGER_H
 
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include "i_notify_callback.h"
@@ -38,8 +40,13 @@ public:
     int32_t StopListener();
     int32_t RegisterNetlinkCallback(sptr<NetsysNative::INotifyCallback> callback);
     int32_t UnregisterNetlinkCallback(sptr<NetsysNative::INotifyCallback> callback);
+    // Reports a quota or alert crossing that did not come through a netlink socket
+    void NotifyBandwidthReachedLimit(const std::string &limitName, const std::string &iface);
+    // Lets netsys itself follow added and removed ifaces, to be set before StartListener
+    void SetInterfaceEventHandler(std::function<void(const std::string &ifName, bool added)> handler);
 
 private:
+    std::function<void(const std::string &ifName, bool added)> interfaceEventHandler_;
     std::shared_ptr<std::vector<sptr<NetsysNative::INotifyCallback>>> callbacks_;
     std::mutex linkCallbackMutex_;
 };
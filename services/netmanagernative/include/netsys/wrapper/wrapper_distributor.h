@@ -19,12 +19,15 @@
 #include "data_receiver.h"
 #include "i_notify_callback.h"
 #include "netsys_event_message.h"
+#include <functional>
 #include <mutex>
 
 namespace OHOS {
 namespace nmd {
 class WrapperDistributor {
 public:
+    using InterfaceEventHandler = std::function<void(const std::string &ifName, bool added)>;
+
     WrapperDistributor(int32_t socket, const int32_t format, std::mutex& externMutex);
     ~WrapperDistributor() = default;
 
@@ -32,6 +35,8 @@ public:
     int32_t Stop();
     int32_t
         RegisterNetlinkCallbacks(std::shared_ptr<std::vector<sptr<NetsysNative::INotifyCallback>>> netlinkCallbacks);
+    // Called on the listener thread for an added or removed iface, before the registered callbacks
+    void SetInterfaceEventHandler(const InterfaceEventHandler &handler);
 
 #ifdef FEATURE_NET_FIREWALL_ENABLE
     int32_t GetSocketFd()
@@ -65,6 +70,7 @@ private:
     std::unique_ptr<DataReceiver> receiver_;
     std::shared_ptr<std::vector<sptr<NetsysNative::INotifyCallback>>> netlinkCallbacks_;
     std::mutex& netlinkCallbacksMutex_;
+    InterfaceEventHandler interfaceEventHandler_;
 #ifdef FEATURE_NET_FIREWALL_ENABLE
     int32_t socketFd_ = -1;
 #endif
@@ -132,6 +132,8 @@ public:
     int32_t BandwidthRemoveAllowedList(uint32_t uid) override;
     int32_t BandwidthAddDeniedList(uint32_t uid) override;
     int32_t BandwidthRemoveDeniedList(uint32_t uid) override;
+    int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                                    const std::vector<uint32_t> &removedUids) override;
     int32_t ShareDnsSet(uint16_t netId) override;
     int32_t StartDnsProxyListen() override;
     int32_t StopDnsProxyListen() override;
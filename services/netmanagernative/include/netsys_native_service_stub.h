@@ -132,6 +132,7 @@ private:
     int32_t CmdBandwidthRemoveDeniedList(MessageParcel &data, MessageParcel &reply);
     int32_t CmdBandwidthAddAllowedList(MessageParcel &data, MessageParcel &reply);
     int32_t CmdBandwidthRemoveAllowedList(MessageParcel &data, MessageParcel &reply);
+    int32_t CmdBandwidthUpdateUidLists(MessageParcel &data, MessageParcel &reply);
     int32_t CmdFirewallSetUidsAllowedListChain(MessageParcel &data, MessageParcel &reply);
     int32_t CmdFirewallSetUidsDeniedListChain(MessageParcel &data, MessageParcel &reply);
     int32_t CmdFirewallEnableChain(MessageParcel &data, MessageParcel &reply);
@@ -15,8 +15,13 @@
 
 #include "bandwidth_manager.h"
 
+#include <cerrno>
 #include <cinttypes>
+#include <net/if.h>
 
+#include "bpf_def.h"
+#include "bpf_mapper.h"
+#include "bpf_path.h"
 #include "iptables_wrapper.h"
 #include "net_manager_constants.h"
 #include "netmanager_base_common_utils.h"
@@ -25,7 +30,6 @@
 namespace OHOS {
 namespace nmd {
 using namespace NetManagerStandard;
-static constexpr const char *CHAIN_NAME_COSTLY_PTR = "ohbw_costly_";
 BandwidthManager::BandwidthManager() : chainInitFlag_(false), dataSaverEnable_(false) {}
 
 BandwidthManager::~BandwidthManager()
@@ -38,6 +42,7 @@ inline void BandwidthManager::CheckChainInitialization()
     if (chainInitFlag_ == false) {
         InitChain();
         InitDefaultRules();
+        ResetBandwidthMaps();
     }
 }
 
@@ -242,153 +247,233 @@ int32_t BandwidthManager::IptablesDeleteChain(const std::string &chainName)
     return hasError ? NETMANAGER_ERROR : NETMANAGER_SUCCESS;
 }
 
-int32_t BandwidthManager::SetGlobalAlert(Operate operate, int64_t bytes)
+int32_t BandwidthManager::WriteBandwidthLimit(uint32_t ifIndex, uint32_t type, int64_t bytes)
 {
-    NETNATIVE_LOG_D("BandwidthManager SetGlobalAlert: operate=%{public}d, bytes=%{public}" PRId64, operate, bytes);
-    bool hasError = false;
-    std::string command;
-    std::string chainName = FetchChainName(ChainType::CHAIN_OHBW_GLOBAL_ALERT);
-    if (operate == OP_SET) {
-        globalAlertBytes_ = bytes;
-        command = "-t filter -A " + chainName + " -m quota2 --quota " + std::to_string(bytes) + " --name globalAlert";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-    } else {
-        if (bytes == globalAlertBytes_) {
-            command =
-                "-t filter -D " + chainName + " -m quota --quota " + std::to_string(bytes) + " --name globalAlert";
-            hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(
-                IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-            globalAlertBytes_ = 0;
-        } else {
-            NETNATIVE_LOGE("not match bytes, cannot remove global alert");
+    if (bytes < 0) {
+        NETNATIVE_LOGE("WriteBandwidthLimit: invalid bytes %{public}" PRId64, bytes);
+        return NETMANAGER_ERROR;
+    }
+    BpfMapper<bandwidth_limit_key, bandwidth_limit_value> limitMap(BANDWIDTH_LIMIT_MAP_PATH, BPF_ANY);
+    if (!limitMap.IsValid()) {
+        NETNATIVE_LOGE("WriteBandwidthLimit: bandwidth_limit_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    // A new limit starts counting from zero, as a replaced quota2 rule did
+    bandwidth_limit_key key = {ifIndex, type};
+    bandwidth_limit_value value = {};
+    value.limitBytes = static_cast<uint64_t>(bytes);
+    if (limitMap.Write(key, value, BPF_ANY) != 0) {
+        NETNATIVE_LOGE("WriteBandwidthLimit: write %{public}u/%{public}u failed, errno=%{public}d", ifIndex, type,
+                       errno);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+int32_t BandwidthManager::DeleteBandwidthLimit(uint32_t ifIndex, uint32_t type)
+{
+    BpfMapper<bandwidth_limit_key, bandwidth_limit_value> limitMap(BANDWIDTH_LIMIT_MAP_PATH, BPF_ANY);
+    if (!limitMap.IsValid()) {
+        NETNATIVE_LOGE("DeleteBandwidthLimit: bandwidth_limit_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    bandwidth_limit_key key = {ifIndex, type};
+    if (limitMap.Delete(key) != 0 && errno != ENOENT) {
+        NETNATIVE_LOGE("DeleteBandwidthLimit: delete %{public}u/%{public}u failed, errno=%{public}d", ifIndex, type,
+                       errno);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+int32_t BandwidthManager::WriteDataSaverConfig(bool enable)
+{
+    BpfMapper<bandwidth_config_key, bandwidth_config_value> configMap(BANDWIDTH_CONFIG_MAP_PATH, BPF_ANY);
+    if (!configMap.IsValid()) {
+        NETNATIVE_LOGE("WriteDataSaverConfig: bandwidth_config_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    bandwidth_config_value value = {};
+    value.dataSaverEnabled = enable ? 1 : 0;
+    if (configMap.Write(BANDWIDTH_CONFIG_KEY, value, BPF_ANY) != 0) {
+        NETNATIVE_LOGE("WriteDataSaverConfig: write failed, errno=%{public}d", errno);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+int32_t BandwidthManager::WriteUidListBits(uint32_t uid)
+{
+    BpfMapper<bandwidth_uid_key, bandwidth_uid_value> uidMap(BANDWIDTH_UID_MAP_PATH, BPF_ANY);
+    if (!uidMap.IsValid()) {
+        NETNATIVE_LOGE("WriteUidListBits: bandwidth_uid_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    uint8_t bits = (deniedListUids_.count(uid) > 0 ? BANDWIDTH_UID_DENIED : 0) |
+                   (allowedListUids_.count(uid) > 0 ? BANDWIDTH_UID_ALLOWED : 0);
+    if (bits != 0) {
+        if (uidMap.Write(uid, bits, BPF_ANY) != 0) {
+            NETNATIVE_LOGE("WriteUidListBits: write uid %{public}u failed, errno=%{public}d", uid, errno);
             return NETMANAGER_ERROR;
         }
+        return NETMANAGER_SUCCESS;
     }
+    if (uidMap.Delete(uid) != 0 && errno != ENOENT) {
+        NETNATIVE_LOGE("WriteUidListBits: delete uid %{public}u failed, errno=%{public}d", uid, errno);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
 
+int32_t BandwidthManager::ResetBandwidthMaps()
+{
+    // The maps stay pinned across a netsys restart, drop what the previous instance left
+    dataSaverEnable_ = false;
+    deniedListUids_.clear();
+    allowedListUids_.clear();
+    ifaceQuotaBytes_.clear();
+    ifaceQuotaIndex_.clear();
+    {
+        std::lock_guard<std::mutex> guard(ifaceAlertMutex_);
+        globalAlertBytes_ = 0;
+        ifaceAlertBytes_.clear();
+        ifaceAlertIndex_.clear();
+    }
+    BpfMapper<bandwidth_uid_key, bandwidth_uid_value> uidMap(BANDWIDTH_UID_MAP_PATH, BPF_ANY);
+    BpfMapper<bandwidth_limit_key, bandwidth_limit_value> limitMap(BANDWIDTH_LIMIT_MAP_PATH, BPF_ANY);
+    if (!uidMap.IsValid() || !limitMap.IsValid()) {
+        NETNATIVE_LOGE("ResetBandwidthMaps: bandwidth maps are not available");
+        return NETMANAGER_ERROR;
+    }
+    bool hasError = (WriteDataSaverConfig(false) == NETMANAGER_ERROR);
+    hasError = (uidMap.Clear(uidMap.GetAllKeys()) != 0) || hasError;
+    hasError = (limitMap.Clear(limitMap.GetAllKeys()) != 0) || hasError;
     return hasError ? NETMANAGER_ERROR : NETMANAGER_SUCCESS;
 }
 
+int32_t BandwidthManager::SetGlobalAlert(Operate operate, int64_t bytes)
+{
+    NETNATIVE_LOG_D("BandwidthManager SetGlobalAlert: operate=%{public}d, bytes=%{public}" PRId64, operate, bytes);
+    std::lock_guard<std::mutex> guard(ifaceAlertMutex_);
+    if (operate == OP_SET) {
+        globalAlertBytes_ = bytes;
+        return WriteBandwidthLimit(BANDWIDTH_GLOBAL_IFINDEX, BANDWIDTH_LIMIT_ALERT, bytes);
+    }
+    if (bytes != globalAlertBytes_) {
+        NETNATIVE_LOGE("not match bytes, cannot remove global alert");
+        return NETMANAGER_ERROR;
+    }
+    globalAlertBytes_ = 0;
+    return DeleteBandwidthLimit(BANDWIDTH_GLOBAL_IFINDEX, BANDWIDTH_LIMIT_ALERT);
+}
+
 int32_t BandwidthManager::SetCostlyAlert(Operate operate, const std::string &iface, int64_t bytes)
 {
     NETNATIVE_LOG_D("BandwidthManager SetCostlyAlert: operate=%{public}d, iface=%{public}s, bytes=%{public}" PRId64,
                     operate, iface.c_str(), bytes);
     std::lock_guard<std::mutex> guard(ifaceAlertMutex_);
-    bool hasError = false;
-    std::string command;
-    std::string chainName = std::string(CHAIN_NAME_COSTLY_PTR) + iface + "alert";
     if (operate == OP_SET) {
         ifaceAlertBytes_[iface] = bytes;
-        command =
-            "-t filter -A " + chainName + " -m quota2 --quota " + std::to_string(bytes) + " --name " + iface + "Alert";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-    } else {
-        if (bytes == ifaceAlertBytes_[iface]) {
-            command = "-t filter -D " + chainName + " -m quota2 --quota " + std::to_string(bytes) + " --name " + iface +
-                      "Alert";
-            hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(
-                IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-            ifaceAlertBytes_[iface] = 0;
-        } else {
-            NETNATIVE_LOGE("not match bytes, cannot remove global alert");
-            return NETMANAGER_ERROR;
+        uint32_t ifIndex = if_nametoindex(iface.c_str());
+        if (ifIndex == 0) {
+            NETNATIVE_LOGW("SetCostlyAlert: iface %{public}s does not exist yet, applied when it is added",
+                           iface.c_str());
+            return NETMANAGER_SUCCESS;
         }
+        return BindIfaceLimit(ifaceAlertIndex_, iface, ifIndex, BANDWIDTH_LIMIT_ALERT, bytes);
     }
-
-    return hasError ? NETMANAGER_ERROR : NETMANAGER_SUCCESS;
+    auto iter = ifaceAlertBytes_.find(iface);
+    if (iter == ifaceAlertBytes_.end() || bytes != iter->second) {
+        NETNATIVE_LOGE("not match bytes, cannot remove global alert");
+        return NETMANAGER_ERROR;
+    }
+    ifaceAlertBytes_.erase(iter);
+    return UnbindIfaceLimit(ifaceAlertIndex_, iface, BANDWIDTH_LIMIT_ALERT);
 }
 
 int32_t BandwidthManager::EnableDataSaver(bool enable)
 {
     NETNATIVE_LOG_D("BandwidthManager EnableDataSaver: enable=%{public}d", enable);
-    bool hasError = false;
     std::unique_lock<std::mutex> lock(bandwidthMutex_);
     CheckChainInitialization();
 
-    std::string command;
-    std::string chainName = FetchChainName(ChainType::CHAIN_OHBW_DATA_SAVER);
-    if (enable == true && dataSaverEnable_ == false) {
-        dataSaverEnable_ = true;
-        command = "-t filter -R " + chainName + " 1 -j REJECT";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-        command = "-t filter -I " + chainName + " -m owner --uid-owner 0-9999 -j RETURN";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-    } else if (enable == false && dataSaverEnable_ == true) {
-        dataSaverEnable_ = false;
-        command = "-t filter -D " + chainName + " -m owner --uid-owner 0-9999 -j RETURN";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-        command = "-t filter -R " + chainName + " 1 -j RETURN";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-    } else {
+    if (enable == dataSaverEnable_) {
         NETNATIVE_LOGE("DataSaver is already %{public}s, do not repeat", enable == true ? "true" : "false");
         return NETMANAGER_ERROR;
     }
-
-    return hasError ? NETMANAGER_ERROR : NETMANAGER_SUCCESS;
+    dataSaverEnable_ = enable;
+    return WriteDataSaverConfig(enable);
 }
 
 int32_t BandwidthManager::SetIfaceQuotaDetail(const std::string &ifName, int64_t bytes)
 {
-    std::string command;
-    std::string chainName = std::string(CHAIN_NAME_COSTLY_PTR) + ifName;
-    std::string fChainName;
-    std::string strMaxBytes = std::to_string(bytes);
-    bool hasError = false;
-
-    if (ifaceQuotaBytes_.count(ifName) > 0) {
-        // -R ohbw_costly_iface 1 -m quota2 ! --quota 12345 --name iface -j REJECT
-        command = "-t filter -D " + chainName + " -m quota2 ! --quota " + std::to_string(ifaceQuotaBytes_[ifName]) +
-                  " --name " + ifName + " --jump REJECT";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-        command = "-t filter -A " + chainName + " -m quota2 ! --quota " + strMaxBytes + " --name " + ifName +
-                  " --jump REJECT";
-        hasError = hasError || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) ==
-                                NETMANAGER_ERROR);
-        NETNATIVE_LOG_D("hasError %d", hasError);
-        ifaceQuotaBytes_[ifName] = bytes;
+    ifaceQuotaBytes_[ifName] = bytes;
+    // A quota entry is also what makes the iface costly for the data saver and the lists
+    uint32_t ifIndex = if_nametoindex(ifName.c_str());
+    if (ifIndex == 0) {
+        NETNATIVE_LOGW("SetIfaceQuota: iface %{public}s does not exist yet, applied when it is added", ifName.c_str());
         return NETMANAGER_SUCCESS;
     }
-    hasError = hasError || (IptablesNewChain(chainName) == NETMANAGER_ERROR);
-    ifaceQuotaBytes_[ifName] = bytes;
+    return BindIfaceLimit(ifaceQuotaIndex_, ifName, ifIndex, BANDWIDTH_LIMIT_QUOTA, bytes);
+}
 
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_OUTPUT);
-    std::string cChainName = FetchChainName(ChainType::CHAIN_OHBW_DENIED_LIST_BOX);
-    command = "-t filter -A " + fChainName + " -o " + ifName + " -j " + cChainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
+int32_t BandwidthManager::BindIfaceLimit(std::map<std::string, uint32_t> &ifaceIndex, const std::string &ifName,
+                                         uint32_t ifIndex, uint32_t type, int64_t bytes)
+{
+    // The limit map is keyed by ifindex, a recreated iface leaves the entry of its old index behind
+    auto iter = ifaceIndex.find(ifName);
+    if (iter != ifaceIndex.end() && iter->second != ifIndex) {
+        DeleteBandwidthLimit(iter->second, type);
+    }
+    ifaceIndex[ifName] = ifIndex;
+    return WriteBandwidthLimit(ifIndex, type, bytes);
+}
 
-    // -I ohbw_INPUT -i iface -j ohbw_costly_iface
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_INPUT);
-    command = "-t filter -I " + fChainName + " -i " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    // -I ohbw_OUTPUT -o iface -j ohbw_costly_iface
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_OUTPUT);
-    command = "-t filter -I " + fChainName + " -o " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    // -A ohbw_FORWARD -i iface -j ohbw_costly_iface
-    // -A ohbw_FORWARD -o iface -j ohbw_costly_iface
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_FORWARD);
-    command = "-t filter -A " + fChainName + " -i " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    command = "-t filter -A " + fChainName + " -o " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    // -A ohbw_costly_iface -m quota2 ! --quota 12345 --name iface -j REJECT
-    command =
-        "-t filter -A " + chainName + " -m quota2 ! --quota " + strMaxBytes + " --name " + ifName + " --jump REJECT";
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
+int32_t BandwidthManager::UnbindIfaceLimit(std::map<std::string, uint32_t> &ifaceIndex, const std::string &ifName,
+                                           uint32_t type)
+{
+    auto iter = ifaceIndex.find(ifName);
+    if (iter == ifaceIndex.end()) {
+        return NETMANAGER_SUCCESS;
+    }
+    uint32_t ifIndex = iter->second;
+    ifaceIndex.erase(iter);
+    return DeleteBandwidthLimit(ifIndex, type);
+}
 
-    return hasError ? NETMANAGER_ERROR : NETMANAGER_SUCCESS;
+void BandwidthManager::RebindIfaceLimit(const std::map<std::string, int64_t> &ifaceBytes,
+                                        std::map<std::string, uint32_t> &ifaceIndex, const std::string &ifName,
+                                        uint32_t ifIndex, uint32_t type)
+{
+    auto limit = ifaceBytes.find(ifName);
+    if (limit == ifaceBytes.end()) {
+        return;
+    }
+    if (ifIndex == 0) {
+        UnbindIfaceLimit(ifaceIndex, ifName, type);
+        return;
+    }
+    // Rewriting the entry of the same index would restart the count of a limit already applied
+    auto bound = ifaceIndex.find(ifName);
+    if (bound != ifaceIndex.end() && bound->second == ifIndex) {
+        return;
+    }
+    NETNATIVE_LOGI("Apply limit %{public}u of iface %{public}s at index %{public}u", type, ifName.c_str(), ifIndex);
+    BindIfaceLimit(ifaceIndex, ifName, ifIndex, type, limit->second);
+}
+
+void BandwidthManager::OnInterfaceChanged(const std::string &ifName, bool added)
+{
+    uint32_t ifIndex = added ? if_nametoindex(ifName.c_str()) : 0;
+    if (added && ifIndex == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(bandwidthMutex_);
+        RebindIfaceLimit(ifaceQuotaBytes_, ifaceQuotaIndex_, ifName, ifIndex, BANDWIDTH_LIMIT_QUOTA);
+    }
+    std::lock_guard<std::mutex> guard(ifaceAlertMutex_);
+    RebindIfaceLimit(ifaceAlertBytes_, ifaceAlertIndex_, ifName, ifIndex, BANDWIDTH_LIMIT_ALERT);
 }
 
 int32_t BandwidthManager::SetIfaceQuota(const std::string &ifName, int64_t bytes)
@@ -411,51 +496,14 @@ int32_t BandwidthManager::RemoveIfaceQuota(const std::string &ifName)
         return NETMANAGER_ERROR;
     }
     NETNATIVE_LOG_D("BandwidthManager RemoveIfaceQuota: ifName=%{public}s", ifName.c_str());
-    bool hasError = false;
     std::unique_lock<std::mutex> lock(bandwidthMutex_);
     CheckChainInitialization();
 
-    std::string command;
-    std::string chainName = std::string(CHAIN_NAME_COSTLY_PTR) + ifName;
-    std::string fChainName;
-
-    if (ifaceQuotaBytes_.count(ifName) == 0) {
+    if (ifaceQuotaBytes_.erase(ifName) == 0) {
         NETNATIVE_LOGE("RemoveIfaceQuota iface %s not exist, can not remove", ifName.c_str());
         return NETMANAGER_ERROR;
-    } else {
-        ifaceQuotaBytes_.erase(ifName);
     }
-
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_OUTPUT);
-    std::string cChainName = FetchChainName(ChainType::CHAIN_OHBW_DENIED_LIST_BOX);
-    command = "-t filter -D " + fChainName + " -o " + ifName + " -j " + cChainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-
-    // -D ohbw_INPUT -i iface -j ohbw_costly_iface
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_INPUT);
-    command = "-t filter -D " + fChainName + " -i " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    // -D ohbw_OUTPUT -o iface -j ohbw_costly_iface
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_OUTPUT);
-    command = "-t filter -D " + fChainName + " -o " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    // -D ohbw_FORWARD -i iface -j ohbw_costly_iface
-    // -D ohbw_FORWARD -o iface -j ohbw_costly_iface
-    fChainName = FetchChainName(ChainType::CHAIN_OHBW_FORWARD);
-    command = "-t filter -D " + fChainName + " -i " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    command = "-t filter -D " + fChainName + " -o " + ifName + " --jump " + chainName;
-    hasError = hasError ||
-               (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command) == NETMANAGER_ERROR);
-    // -F ohbw_costly_iface
-    // -X ohbw_costly_iface
-    hasError = hasError || (IptablesDeleteChain(chainName) == NETMANAGER_ERROR);
-
-    return hasError ? NETMANAGER_ERROR : NETMANAGER_SUCCESS;
+    return UnbindIfaceLimit(ifaceQuotaIndex_, ifName, BANDWIDTH_LIMIT_QUOTA);
 }
 
 int32_t BandwidthManager::AddDeniedList(uint32_t uid)
@@ -468,13 +516,7 @@ int32_t BandwidthManager::AddDeniedList(uint32_t uid)
     if (!inserted) {
         return NETMANAGER_ERROR;
     }
-
-    std::string strUid = std::to_string(uid);
-    std::string command;
-    std::string chainName = FetchChainName(ChainType::CHAIN_OHBW_DENIED_LIST_BOX);
-    command = "-t filter -I " + chainName + " -m owner --uid-owner " + strUid + " -j REJECT";
-
-    return IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command);
+    return WriteUidListBits(uid);
 }
 
 int32_t BandwidthManager::RemoveDeniedList(uint32_t uid)
@@ -486,13 +528,7 @@ int32_t BandwidthManager::RemoveDeniedList(uint32_t uid)
     if (deniedListUids_.erase(uid) == 0) {
         return NETMANAGER_ERROR;
     }
-
-    std::string strUid = std::to_string(uid);
-    std::string command;
-    std::string chainName = FetchChainName(ChainType::CHAIN_OHBW_DENIED_LIST_BOX);
-    command = "-t filter -D " + chainName + " -m owner --uid-owner " + strUid + " -j REJECT";
-
-    return IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command);
+    return WriteUidListBits(uid);
 }
 
 int32_t BandwidthManager::AddAllowedList(uint32_t uid)
@@ -505,13 +541,7 @@ int32_t BandwidthManager::AddAllowedList(uint32_t uid)
     if (!inserted) {
         return NETMANAGER_ERROR;
     }
-
-    std::string strUid = std::to_string(uid);
-    std::string command;
-    std::string chainName = FetchChainName(ChainType::CHAIN_OHBW_ALLOWED_LIST_BOX);
-    command = "-t filter -I " + chainName + " -m owner --uid-owner " + strUid + " -j RETURN";
-
-    return IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command);
+    return WriteUidListBits(uid);
 }
 
 int32_t BandwidthManager::RemoveAllowedList(uint32_t uid)
@@ -523,14 +553,68 @@ int32_t BandwidthManager::RemoveAllowedList(uint32_t uid)
     if (allowedListUids_.erase(uid) == 0) {
         return NETMANAGER_ERROR;
     }
+    return WriteUidListBits(uid);
+}
 
-    std::string strUid = std::to_string(uid);
+void BandwidthManager::UpdateListUid(uint32_t uid, bool isAdd, std::unordered_set<uint32_t> &listUids,
+                                     std::unordered_set<uint32_t> &changedUids)
+{
+    bool changed = isAdd ? listUids.insert(uid).second : listUids.erase(uid) != 0;
+    if (changed) {
+        changedUids.insert(uid);
+    }
+}
 
-    std::string command;
-    std::string chainName = FetchChainName(ChainType::CHAIN_OHBW_ALLOWED_LIST_BOX);
-    command = "-t filter -D " + chainName + " -m owner --uid-owner " + strUid + " -j RETURN";
+int32_t BandwidthManager::UpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                         const std::vector<uint32_t> &allowedUids,
+                                         const std::vector<uint32_t> &removedUids)
+{
+    NETNATIVE_LOG_D("BandwidthManager UpdateUidLists: denied=%{public}zu allowed=%{public}zu removed=%{public}zu",
+                    deniedUids.size(), allowedUids.size(), removedUids.size());
+    std::unique_lock<std::mutex> lock(bandwidthMutex_);
+    CheckChainInitialization();
 
-    return IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4, command);
+    std::unordered_set<uint32_t> deniedListUids = deniedListUids_;
+    std::unordered_set<uint32_t> allowedListUids = allowedListUids_;
+    std::unordered_set<uint32_t> changedUids;
+    for (uint32_t uid : removedUids) {
+        UpdateListUid(uid, false, deniedListUids, changedUids);
+        UpdateListUid(uid, false, allowedListUids, changedUids);
+    }
+    for (uint32_t uid : deniedUids) {
+        UpdateListUid(uid, false, allowedListUids, changedUids);
+        UpdateListUid(uid, true, deniedListUids, changedUids);
+    }
+    for (uint32_t uid : allowedUids) {
+        UpdateListUid(uid, false, deniedListUids, changedUids);
+        UpdateListUid(uid, true, allowedListUids, changedUids);
+    }
+    if (changedUids.empty()) {
+        return NETMANAGER_SUCCESS;
+    }
+
+    // Every changed uid is one map write, once one fails the uids written before get their previous lists back
+    deniedListUids_.swap(deniedListUids);
+    allowedListUids_.swap(allowedListUids);
+    std::vector<uint32_t> writtenUids;
+    writtenUids.reserve(changedUids.size());
+    for (uint32_t uid : changedUids) {
+        if (WriteUidListBits(uid) == NETMANAGER_SUCCESS) {
+            writtenUids.push_back(uid);
+            continue;
+        }
+        NETNATIVE_LOGE("UpdateUidLists write uid %{public}u failed, rolling back %{public}zu uids", uid,
+                       writtenUids.size());
+        deniedListUids_.swap(deniedListUids);
+        allowedListUids_.swap(allowedListUids);
+        for (uint32_t writtenUid : writtenUids) {
+            if (WriteUidListBits(writtenUid) != NETMANAGER_SUCCESS) {
+                NETNATIVE_LOGE("UpdateUidLists roll back uid %{public}u failed", writtenUid);
+            }
+        }
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
 }
 } // namespace nmd
 } // namespace OHOS
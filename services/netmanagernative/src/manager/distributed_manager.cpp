@@ -32,15 +32,12 @@
 #include "net_manager_constants.h"
 #include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
+#include "rtnetlink_transaction.h"
 #include "securec.h"
 
 namespace OHOS {
 namespace NetManagerStandard {
 
-namespace {
-constexpr const char *IP_CMD_PATH = "/system/bin/ip";
-} // namespace
-
 void DistributedManager::SetServerNicInfo(const std::string &iif, const std::string &devIface)
 {
     serverIif_ = iif;
@@ -70,38 +67,6 @@ int32_t DistributedManager::ConfigVirnicAndVeth(const std::string &virNicAddr, c
         return NETMANAGER_ERROR;
     }
     
-    // Step1: ip link add virnic type veth peer name virnic1
-    std::string out;
-    std::string createVirnic = std::string(IP_CMD_PATH) + " link add " + virnicName +
-        " type veth peer name " + virnicVethName;
-    NETNATIVE_LOGI("setup virnic and veth : %{public}s", createVirnic.c_str());
-    if (CommonUtils::ForkExec(createVirnic.c_str(), &out) != NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("setup virnic and veth failed, output %{public}s", out.c_str());
-        return NETMANAGER_ERROR;
-    }
- 
-    // Step2-1: ip link set virnic up
-    std::string virnicUp = std::string(IP_CMD_PATH) + " link set " + virnicName + " up";
-    NETNATIVE_LOGI("set virnic up: %{public}s", virnicUp.c_str());
-    if (CommonUtils::ForkExec(virnicUp.c_str(), &out) != NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("set virnic up, output: %{public}s.", out.c_str());
-        return NETMANAGER_ERROR;
-    }
-    // Step2-2: ip link set virnic-veth up
-    std::string virnicVethUp = std::string(IP_CMD_PATH) + " link set " + virnicVethName + " up";
-    NETNATIVE_LOGI("set virnicVeth up: %{public}s", virnicVethUp.c_str());
-    if (CommonUtils::ForkExec(virnicVethUp.c_str(), &out) != NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("set virnicVeth up failed, output: %{public}s.", out.c_str());
-        return NETMANAGER_ERROR;
-    }
- 
-    // Step3-1: ip addr add xx.xx.xx.xx/24 dev virnic
-    std::string cfgVirnic = std::string(IP_CMD_PATH) + " addr add " + virNicAddr + "/24 dev " + virnicName;
-    NETNATIVE_LOGI("add virnic ip: %{public}s", CommonUtils::AnonymousIpInStr(cfgVirnic).c_str());
-    if (CommonUtils::ForkExec(cfgVirnic.c_str(), &out) != NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("add virnic ip failed, output %{public}s.", out.c_str());
-        return NETMANAGER_ERROR;
-    }
     std::string maskAddr = CommonUtils::GetMaskByLength(DEFAULT_GATEWAY_MASK_MAX_LENGTH);
     std::string virNicVethAddr = CommonUtils::GetGatewayAddr(virNicAddr, maskAddr);
     if (virNicVethAddr.empty()) {
@@ -109,14 +74,19 @@ int32_t DistributedManager::ConfigVirnicAndVeth(const std::string &virNicAddr, c
         return NETMANAGER_ERROR;
     }
 
-    // Step3-1: ip addr add xx.xx.xx.1/24 dev virnic
-    std::string cfgVirnicVeth = std::string(IP_CMD_PATH) + " addr add " + virNicVethAddr + "/24 dev " + virnicVethName;
-    NETNATIVE_LOGI("add virNic-veth ip: %{public}s", CommonUtils::AnonymousIpInStr(cfgVirnicVeth).c_str());
-    if (CommonUtils::ForkExec(cfgVirnicVeth.c_str(), &out) != NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("add virNic-veth ip failed, output %{public}s.", out.c_str());
+    // The veth pair, its links up and the address of either end go to the kernel as one configuration
+    NETNATIVE_LOGI("setup virnic %{public}s and veth %{public}s", virnicName.c_str(), virnicVethName.c_str());
+    nmd::RtnetlinkTransaction transaction;
+    int32_t ret = transaction.AddVethPair(virnicName, virnicVethName)
+                      .SetLinkUp(virnicName, true)
+                      .SetLinkUp(virnicVethName, true)
+                      .AddAddress(virnicName, virNicAddr, DEFAULT_GATEWAY_MASK_MAX_LENGTH)
+                      .AddAddress(virnicVethName, virNicVethAddr, DEFAULT_GATEWAY_MASK_MAX_LENGTH)
+                      .Commit();
+    if (ret != 0) {
+        NETNATIVE_LOGE("setup virnic and veth failed, ret %{public}d", ret);
         return NETMANAGER_ERROR;
     }
- 
     return NETMANAGER_SUCCESS;
 }
  
@@ -128,11 +98,10 @@ void DistributedManager::DisableVirnic(const std::string &virnicName)
         return;
     }
     // LCOV_EXCL_STOP
-    std::string out;
-    std::string delVirnic = std::string(IP_CMD_PATH) + " link del " + virnicName;
-    NETNATIVE_LOGI("del virnic: %{public}s", delVirnic.c_str());
-    if (CommonUtils::ForkExec(delVirnic.c_str(), &out) != NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("DisableVirnic del Virnic failed, output %{public}s", out.c_str());
+    NETNATIVE_LOGI("del virnic: %{public}s", virnicName.c_str());
+    int32_t ret = nmd::RtnetlinkTransaction().DeleteLink(virnicName).Commit();
+    if (ret != 0) {
+        NETNATIVE_LOGE("DisableVirnic del Virnic failed, ret %{public}d", ret);
     }
 }
 } // namespace NetManagerStandard
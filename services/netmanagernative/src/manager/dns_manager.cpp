@@ -131,6 +131,7 @@ int32_t DnsManager::CreateNetworkCache(uint16_t netId, bool isVpnNet)
 
 int32_t DnsManager::DestroyNetworkCache(uint16_t netId, bool isVpnNet)
 {
+    DnsQualityDiag::GetInstance().RemoveNetwork(netId);
     return DnsParamCache::GetInstance().DestroyNetworkCache(netId, isVpnNet);
 }
 
@@ -274,6 +275,12 @@ int32_t DnsManager::SetFirewallCurrentUserId(int32_t userId)
     return DnsParamCache::GetInstance().SetFirewallCurrentUserId(userId);
 }
 
+int32_t DnsManager::SetFirewallDefaultAction(int32_t userId, FirewallRuleAction outDefault)
+{
+    DnsParamCache::GetInstance().SetFirewallDefaultAction(userId, outDefault);
+    return 0;
+}
+
 int32_t DnsManager::SetFirewallRules(NetFirewallRuleType type, const std::vector<sptr<NetFirewallBaseRule>> &ruleList,
                                      bool isFinish)
 {
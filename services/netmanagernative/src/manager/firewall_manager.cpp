@@ -15,11 +15,19 @@
 
 #include "firewall_manager.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
+#include <iterator>
 #include <sstream>
+#include <unordered_set>
 
+#include "bpf_def.h"
+#include "bpf_mapper.h"
+#include "bpf_path.h"
 #include "iptables_wrapper.h"
 #include "net_manager_constants.h"
+#include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
 
 namespace OHOS {
@@ -27,35 +35,20 @@ namespace nmd {
 using namespace NetManagerStandard;
 namespace {
 static constexpr const char *CONFIG_FILE_PATH = "/proc/self/uid_map";
-bool SetFireWallCommand(const std::string &chainName, std::string command)
-{
-    bool ret = false;
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
 
-    command = "-t filter -A " + chainName + " -i lo -j RETURN";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-    command = "-t filter -A " + chainName + " -o lo -j RETURN";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-    command = "-t filter -A " + chainName + " -p tcp --tcp-flags RST RST -j RETURN";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-    // provisional release ns/na pkg
-    command = "-t filter -A " + chainName + " -p icmpv6 --icmpv6-type 135 -j RETURN";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV6, command) == NETMANAGER_ERROR);
-    command = "-t filter -A " + chainName + " -p icmpv6 --icmpv6-type 136 -j RETURN";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV6, command) == NETMANAGER_ERROR);
-    return ret;
+std::vector<uint32_t> FetchRemovedUids(const std::vector<uint32_t> &oldUids, const std::vector<uint32_t> &newUids)
+{
+    std::unordered_set<uint32_t> newUidSet(newUids.begin(), newUids.end());
+    std::vector<uint32_t> removedUids;
+    std::copy_if(oldUids.begin(), oldUids.end(), std::back_inserter(removedUids),
+                 [&newUidSet](uint32_t uid) { return newUidSet.count(uid) == 0; });
+    return removedUids;
 }
 } // namespace
 
-static constexpr uint32_t SYSTEM_UID_RANGE = 9999;
 static constexpr uint32_t DEFAULT_MAX_UID_RANGE = UINT_MAX;
-FirewallManager::FirewallManager() : chainInitFlag_(false), firewallType_(FirewallType::TYPE_ALLOWED_LIST)
+FirewallManager::FirewallManager()
+    : chainInitFlag_(false), firewallType_(FirewallType::TYPE_ALLOWED_LIST), enabledChains_(0)
 {
     strMaxUid_ = ReadMaxUidConfig();
     FirewallChainStatus status = {};
@@ -77,6 +70,7 @@ inline void FirewallManager::CheckChainInitialization()
     if (chainInitFlag_ == false) {
         InitChain();
         InitDefaultRules();
+        ResetUidChainMaps();
     }
 }
 
@@ -252,6 +246,13 @@ int32_t FirewallManager::ClearAllRules()
     command = "-t filter -F " + chainName;
     ret = ret ||
           (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
+
+    std::unique_lock<std::mutex> lock(firewallMutex_);
+    ret = (ResetUidChainMaps() == NETMANAGER_ERROR) || ret;
+    for (auto &[chain, status] : firewallChainStatus_) {
+        status.enable = false;
+        status.uids.clear();
+    }
     return ret == false ? NETMANAGER_SUCCESS : NETMANAGER_ERROR;
 }
 
@@ -284,6 +285,99 @@ int32_t FirewallManager::IptablesSetRule(const std::string &chainName, const std
     return IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command);
 }
 
+uint8_t FirewallManager::FetchChainBit(ChainType chain)
+{
+    switch (chain) {
+        case ChainType::CHAIN_OHFW_DOZABLE:
+            return FIREWALL_CHAIN_DOZABLE;
+        case ChainType::CHAIN_OHFW_POWERSAVING:
+            return FIREWALL_CHAIN_POWERSAVING;
+        case ChainType::CHAIN_OHFW_UNDOZABLE:
+            return FIREWALL_CHAIN_UNDOZABLE;
+        case ChainType::CHAIN_OHFW_ALLOWED_LIST_BOX:
+            return FIREWALL_CHAIN_ALLOWED_LIST_BOX;
+        default:
+            return 0;
+    }
+}
+
+int32_t FirewallManager::UpdateUidChainBit(uint8_t chainBit, const std::vector<uint32_t> &setUids,
+                                           const std::vector<uint32_t> &clearUids)
+{
+    if (setUids.empty() && clearUids.empty()) {
+        return NETMANAGER_SUCCESS;
+    }
+    BpfMapper<firewall_uid_key, firewall_uid_value> uidMap(FIREWALL_UID_MAP_PATH, BPF_ANY);
+    if (!uidMap.IsValid()) {
+        NETNATIVE_LOGE("UpdateUidChainBit: firewall_uid_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    bool ret = false;
+    auto update = [this, &uidMap, &ret](uint32_t uid, uint8_t bits) {
+        if (bits != 0) {
+            if (uidMap.Write(uid, bits, BPF_ANY) != 0) {
+                NETNATIVE_LOGE("UpdateUidChainBit: write uid %{public}u failed, errno=%{public}d", uid, errno);
+                ret = true;
+                return;
+            }
+            uidChainBits_[uid] = bits;
+            return;
+        }
+        if (uidMap.Delete(uid) != 0 && errno != ENOENT) {
+            NETNATIVE_LOGE("UpdateUidChainBit: delete uid %{public}u failed, errno=%{public}d", uid, errno);
+            ret = true;
+            return;
+        }
+        uidChainBits_.erase(uid);
+    };
+    for (uint32_t uid : clearUids) {
+        auto iter = uidChainBits_.find(uid);
+        if (iter != uidChainBits_.end() && (iter->second & chainBit) != 0) {
+            update(uid, iter->second & ~chainBit);
+        }
+    }
+    for (uint32_t uid : setUids) {
+        auto iter = uidChainBits_.find(uid);
+        uint8_t bits = iter == uidChainBits_.end() ? 0 : iter->second;
+        if ((bits & chainBit) == 0) {
+            update(uid, bits | chainBit);
+        }
+    }
+    return ret == false ? NETMANAGER_SUCCESS : NETMANAGER_ERROR;
+}
+
+int32_t FirewallManager::WriteEnabledChains()
+{
+    BpfMapper<firewall_chain_key, firewall_chain_value> chainMap(FIREWALL_CHAIN_MAP_PATH, BPF_ANY);
+    if (!chainMap.IsValid()) {
+        NETNATIVE_LOGE("WriteEnabledChains: firewall_chain_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    firewall_chain_value value = {};
+    value.enabledChains = enabledChains_;
+    value.maxUid = CommonUtils::StrToUint(strMaxUid_, DEFAULT_MAX_UID_RANGE);
+    if (chainMap.Write(FIREWALL_CHAIN_CONFIG_KEY, value, BPF_ANY) != 0) {
+        NETNATIVE_LOGE("WriteEnabledChains: write failed, errno=%{public}d", errno);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+int32_t FirewallManager::ResetUidChainMaps()
+{
+    // The maps stay pinned across a netsys restart, drop what the previous instance left
+    enabledChains_ = 0;
+    uidChainBits_.clear();
+    BpfMapper<firewall_uid_key, firewall_uid_value> uidMap(FIREWALL_UID_MAP_PATH, BPF_ANY);
+    if (!uidMap.IsValid()) {
+        NETNATIVE_LOGE("ResetUidChainMaps: firewall_uid_map is not available");
+        return NETMANAGER_ERROR;
+    }
+    bool ret = (WriteEnabledChains() == NETMANAGER_ERROR);
+    ret = (uidMap.Clear(uidMap.GetAllKeys()) != 0) || ret;
+    return ret == false ? NETMANAGER_SUCCESS : NETMANAGER_ERROR;
+}
+
 int32_t FirewallManager::SetUidsAllowedListChain(ChainType chain, const std::vector<uint32_t> &uids)
 {
     NETNATIVE_LOG_D("FirewallManager SetUidsAllowedListChain: chain=%{public}d", chain);
@@ -291,46 +385,16 @@ int32_t FirewallManager::SetUidsAllowedListChain(ChainType chain, const std::vec
         return NETMANAGER_ERROR;
     }
 
-    bool ret = false;
     std::unique_lock<std::mutex> lock(firewallMutex_);
     CheckChainInitialization();
 
-    std::string command;
-    const auto &chainName = FetchChainName(chain);
-
-    command = "-t filter -F " + chainName;
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-
-    std::string  allowedListChainName = FetchChainName(ChainType::CHAIN_OHFW_ALLOWED_LIST_BOX);
-    command = "-t filter -A " + chainName + " -j " + allowedListChainName;
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-    std::for_each(uids.begin(), uids.end(), [&command, &chainName, &ret](uint32_t uid) {
-        std::string strUid = std::to_string(uid);
-        command = "-t filter -A " + chainName + " -m owner --uid-owner " + strUid + " -j RETURN";
-        ret = ret || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) ==
-                      NETMANAGER_ERROR);
-    });
-
-    command =
-        "-t filter -A " + chainName + " -m owner --uid-owner 0-" + std::to_string(SYSTEM_UID_RANGE) + " -j RETURN";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-    command = "-t filter -A " + chainName + " -m owner ! --uid-owner 0-" + strMaxUid_ + " -j RETURN";
-
-    ret = SetFireWallCommand(chainName, command);
-
-    command = "-t filter -A " + chainName + " -j DROP";
-    ret = ret ||
-          (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) == NETMANAGER_ERROR);
-    if (ret == false) {
-        FirewallChainStatus status = firewallChainStatus_[chain];
-        status.uids = uids;
-        firewallChainStatus_[chain] = status;
+    // System uids and uids outside the uid namespace are let through by the bpf program itself
+    std::vector<uint32_t> clearUids = FetchRemovedUids(firewallChainStatus_[chain].uids, uids);
+    int32_t ret = UpdateUidChainBit(FetchChainBit(chain), uids, clearUids);
+    if (ret == NETMANAGER_SUCCESS) {
+        firewallChainStatus_[chain].uids = uids;
     }
-
-    return ret == false ? NETMANAGER_SUCCESS : NETMANAGER_ERROR;
+    return ret;
 }
 
 int32_t FirewallManager::SetUidsDeniedListChain(ChainType chain, const std::vector<uint32_t> &uids)
@@ -341,30 +405,14 @@ int32_t FirewallManager::SetUidsDeniedListChain(ChainType chain, const std::vect
     }
 
     std::unique_lock<std::mutex> lock(firewallMutex_);
-    bool ret = false;
     CheckChainInitialization();
 
-    std::string command;
-    const auto &chainName = FetchChainName(chain);
-
-    command = "-t filter -F " + chainName;
-
-    ret = SetFireWallCommand(chainName, command);
-
-    std::for_each(uids.begin(), uids.end(), [&command, &chainName, &ret](uint32_t uid) {
-        std::string strUid = std::to_string(uid);
-        command = "-t filter -A " + chainName + " -m owner --uid-owner " + strUid + " -j DROP";
-        ret = ret || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) ==
-                      NETMANAGER_ERROR);
-    });
-
-    if (ret == false) {
-        FirewallChainStatus status = firewallChainStatus_[chain];
-        status.uids = uids;
-        firewallChainStatus_[chain] = status;
+    std::vector<uint32_t> clearUids = FetchRemovedUids(firewallChainStatus_[chain].uids, uids);
+    int32_t ret = UpdateUidChainBit(FetchChainBit(chain), uids, clearUids);
+    if (ret == NETMANAGER_SUCCESS) {
+        firewallChainStatus_[chain].uids = uids;
     }
-
-    return ret == false ? NETMANAGER_SUCCESS : NETMANAGER_ERROR;
+    return ret;
 }
 
 int32_t FirewallManager::EnableChain(ChainType chain, bool enable)
@@ -378,26 +426,16 @@ int32_t FirewallManager::EnableChain(ChainType chain, bool enable)
     std::unique_lock<std::mutex> lock(firewallMutex_);
     CheckChainInitialization();
 
-    std::string chainName;
-    std::string fChainName;
-    chainName = FetchChainName(chain);
-    std::string command;
-
+    uint8_t chainBit = FetchChainBit(chain);
+    uint32_t oldEnabledChains = enabledChains_;
     if (enable == true && firewallChainStatus_[chain].enable == false) {
-        fChainName = FetchChainName(ChainType::CHAIN_OHFW_OUTPUT);
-        command = "-t filter -A " + fChainName + " -j " + chainName;
-        ret = ret || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) ==
-                      NETMANAGER_ERROR);
+        enabledChains_ |= chainBit;
+        ret = ret || (WriteEnabledChains() == NETMANAGER_ERROR);
     } else if (enable == false) {
         // if disable, do it anyway
-        fChainName = FetchChainName(ChainType::CHAIN_OHFW_OUTPUT);
-        command = "-t filter -D " + fChainName + " -j " + chainName;
-        ret = ret || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) ==
-                      NETMANAGER_ERROR);
-        
-        command = "-t filter -F " + chainName;
-        ret = ret || (IptablesWrapper::GetInstance()->RunCommand(IPTYPE_IPV4V6, command) ==
-                      NETMANAGER_ERROR);
+        enabledChains_ &= ~static_cast<uint32_t>(chainBit);
+        ret = ret || (WriteEnabledChains() == NETMANAGER_ERROR);
+        ret = (UpdateUidChainBit(chainBit, {}, firewallChainStatus_[chain].uids) == NETMANAGER_ERROR) || ret;
         firewallChainStatus_[chain].uids.clear();
     } else {
         NETNATIVE_LOGI("FirewallManager::EnableChain chain was %{public}s, do not repeat",
@@ -408,6 +446,8 @@ int32_t FirewallManager::EnableChain(ChainType chain, bool enable)
     if (ret == false) {
         firewallType_ = FetchChainType(chain);
         firewallChainStatus_[chain].enable = enable;
+    } else if (enable == true) {
+        enabledChains_ = oldEnabledChains;
     }
 
     return ret == false ? NETMANAGER_SUCCESS : NETMANAGER_ERROR;
@@ -429,30 +469,19 @@ int32_t FirewallManager::SetUidRule(ChainType chain, uint32_t uid, FirewallRule
     std::unique_lock<std::mutex> lock(firewallMutex_);
     CheckChainInitialization();
 
-    std::string op;
-    std::string target;
-    std::string chainName = FetchChainName(chain);
-    FirewallType firewallType = FetchChainType(chain);
-    if (firewallType == FirewallType::TYPE_DENIDE_LIST) {
-        target = "DROP";
-        op = (firewallRule == FirewallRule::RULE_DENY) ? "-A" : "-D";
-    } else {
-        if (chain != ChainType::CHAIN_OHFW_ALLOWED_LIST_BOX) {
-            target = "RETURN";
-        } else {
-            target = "ACCEPT";
-        }
-        op = (firewallRule == FirewallRule::RULE_ALLOW) ? "-I" : "-D";
-    }
+    // A denied list chain holds the denied uids, the others hold the allowed ones
+    bool isListed = (FetchChainType(chain) == FirewallType::TYPE_DENIDE_LIST) ?
+        (firewallRule == FirewallRule::RULE_DENY) : (firewallRule == FirewallRule::RULE_ALLOW);
+    uint8_t chainBit = FetchChainBit(chain);
 
     FirewallChainStatus status = firewallChainStatus_[chain];
     std::vector<uint32_t>::iterator iter = std::find(status.uids.begin(), status.uids.end(), uid);
-    if (op != "-D" && iter == status.uids.end()) {
+    if (isListed && iter == status.uids.end()) {
         status.uids.push_back(uid);
-        ret = ret || (IptablesSetRule(chainName, op, target, uid) == NETMANAGER_ERROR);
-    } else if (op == "-D" && iter != status.uids.end()) {
+        ret = ret || (UpdateUidChainBit(chainBit, {uid}, {}) == NETMANAGER_ERROR);
+    } else if (!isListed && iter != status.uids.end()) {
         status.uids.erase(iter);
-        ret = ret || (IptablesSetRule(chainName, op, target, uid) == NETMANAGER_ERROR);
+        ret = ret || (UpdateUidChainBit(chainBit, {}, {uid}) == NETMANAGER_ERROR);
     } else {
         NETNATIVE_LOGE("FirewallManager::SetUidRule error");
         return NETMANAGER_ERROR;
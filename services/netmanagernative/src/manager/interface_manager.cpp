@@ -31,6 +31,7 @@
 #include <unistd.h>
 #include <regex>
 
+#include "interface_inventory.h"
 #include "netlink_manager.h"
 #include "netlink_socket.h"
 #include "netlink_socket_diag.h"
@@ -89,6 +90,10 @@ int InterfaceManager::GetMtu(const char *interfaceName)
         NETNATIVE_LOGE("GetMtu isIfaceName fail %{public}d", errno);
         return -1;
     }
+    if (auto table = InterfaceInventory::GetInstance().GetSnapshot(); table != nullptr) {
+        auto iface = InterfaceInventory::Find(*table, interfaceName);
+        return iface != nullptr ? iface->mtu : -1;
+    }
     std::string mtuPath = std::string(SYS_NET_PATH).append(interfaceName).append(MTU_PATH);
     std::string realPath;
     if (!CheckFilePath(mtuPath, realPath)) {
@@ -152,12 +157,20 @@ int InterfaceManager::SetMtu(const char *interfaceName, const char *mtuValue)
     }
 
     close(sockfd);
+    // GetMtu reads the inventory, it must not answer with the old value until the event arrives
+    InterfaceInventory::GetInstance().Refresh(interfaceName);
     return 0;
 }
 
 std::vector<std::string> InterfaceManager::GetInterfaceNames()
 {
     std::vector<std::string> ifaceNames;
+    if (auto table = InterfaceInventory::GetInstance().GetSnapshot(); table != nullptr) {
+        for (const auto &[index, iface] : *table) {
+            ifaceNames.push_back(iface.name);
+        }
+        return ifaceNames;
+    }
     DIR *dir(nullptr);
     struct dirent *de(nullptr);
 
@@ -250,7 +263,11 @@ int InterfaceManager::ModifyAddress(uint32_t action, const char *interfaceName,
     NETNATIVE_LOGI("ModifyAddress:%{public}u %{public}s %{public}s %{public}d", action, interfaceName,
                    ToAnonymousIp(addr).c_str(), prefixLen);
 
-    return SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    int ret = SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    if (ret == 0) {
+        InterfaceInventory::GetInstance().Refresh(interfaceName);
+    }
+    return ret;
 }
 
 int InterfaceManager::AddAddress(const char *interfaceName, const char *addr, int prefixLen)
@@ -298,10 +315,12 @@ std::string HwAddrToStr(char *hwaddr)
 {
     char buf[64] = {'\0'};
     if (hwaddr != nullptr) {
+        // Octets above 0x7f must not be sign extended where char is signed
+        auto mac = reinterpret_cast<const uint8_t *>(hwaddr);
         errno_t result =
-            sprintf_s(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x", hwaddr[0], hwaddr[ARRAY_OFFSET_1_INDEX],
-                      hwaddr[ARRAY_OFFSET_2_INDEX], hwaddr[ARRAY_OFFSET_3_INDEX], hwaddr[ARRAY_OFFSET_4_INDEX],
-                      hwaddr[ARRAY_OFFSET_5_INDEX]);
+            sprintf_s(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[ARRAY_OFFSET_1_INDEX],
+                      mac[ARRAY_OFFSET_2_INDEX], mac[ARRAY_OFFSET_3_INDEX], mac[ARRAY_OFFSET_4_INDEX],
+                      mac[ARRAY_OFFSET_5_INDEX]);
         if (result != 0) {
             NETNATIVE_LOGE("[hwAddrToStr]: result %{public}d", result);
         }
@@ -329,11 +348,30 @@ void UpdateIfaceConfigFlags(unsigned flags, nmd::InterfaceConfigurationParcel &i
     }
 }
 
+void InterfaceManager::FillIfaceConfig(const InventoryInterface *iface, const std::string &ifName,
+                                       nmd::InterfaceConfigurationParcel &ifaceConfig)
+{
+    ifaceConfig.ifName = ifName;
+    if (iface == nullptr) {
+        return;
+    }
+    if (auto addr = InterfaceInventory::GetPrimaryIpv4Addr(*iface); addr != nullptr) {
+        ifaceConfig.ipv4Addr = addr->addr;
+        ifaceConfig.prefixLength = addr->prefixLen;
+    }
+    UpdateIfaceConfigFlags(iface->flags, ifaceConfig);
+    ifaceConfig.hwAddr = iface->hwAddr;
+}
+
 InterfaceConfigurationParcel InterfaceManager::GetIfaceConfig(const std::string &ifName)
 {
     NETNATIVE_LOG_D("GetIfaceConfig in. ifName %{public}s", ifName.c_str());
     struct in_addr addr = {};
     nmd::InterfaceConfigurationParcel ifaceConfig;
+    if (auto table = InterfaceInventory::GetInstance().GetSnapshot(); table != nullptr) {
+        FillIfaceConfig(InterfaceInventory::Find(*table, ifName), ifName, ifaceConfig);
+        return ifaceConfig;
+    }
 
     int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
     // LCOV_EXCL_START
@@ -421,6 +459,7 @@ int InterfaceManager::SetIfaceConfig(const nmd::InterfaceConfigurationParcel &if
     } while (errno == ETIMEDOUT && retry < IOCTL_RETRY_TIME);
     NETNATIVE_LOGI("set ifr flags=[%{public}d] strerror=[%{public}s] retry=[%{public}u]", ifr.ifr_flags,
                    strerror(errno), retry);
+    InterfaceInventory::GetInstance().Refresh(ifaceConfig.ifName);
     return 1;
 }
 
@@ -458,6 +497,7 @@ int InterfaceManager::SetIpAddress(const std::string &ifaceName, const std::stri
         return -1;
     }
     close(inetSocket);
+    InterfaceInventory::GetInstance().Refresh(ifaceName);
     return 0;
 }
 
@@ -491,6 +531,7 @@ int InterfaceManager::SetIffUp(const std::string &ifaceName)
         return -1;
     }
     close(inetSocket);
+    InterfaceInventory::GetInstance().Refresh(ifaceName);
     return 0;
 }
 
@@ -784,7 +825,11 @@ int32_t InterfaceManager::CreateVlan(const std::string &ifName, uint32_t vlanId)
     nlmsg.AddNestedEnd(info_data);
     nlmsg.AddNestedEnd(linkinfo);
 
-    return SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    int32_t ret = SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    if (ret == 0) {
+        InterfaceInventory::GetInstance().Refresh(name);
+    }
+    return ret;
 }
 
 int32_t InterfaceManager::DestroyVlan(const std::string &ifName, uint32_t vlanId)
@@ -805,7 +850,11 @@ int32_t InterfaceManager::DestroyVlan(const std::string &ifName, uint32_t vlanId
     ifm.ifi_change = 0;
 
     nlmsg.AddLink(RTM_DELLINK, ifm);
-    return SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    int32_t ret = SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    if (ret == 0) {
+        InterfaceInventory::GetInstance().Refresh(name);
+    }
+    return ret;
 }
 
 int32_t InterfaceManager::AddVlanIp(const std::string &ifName, uint32_t vlanId,
@@ -856,7 +905,11 @@ int32_t InterfaceManager::AddVlanIp(const std::string &ifName, uint32_t vlanId,
     nlmsg.AddAttr(IFA_LOCAL, const_cast<char*>(addrbuf), addrLen);
     nlmsg.AddAttr(IFA_ADDRESS, const_cast<char*>(addrbuf), addrLen);
 
-    return SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    int32_t ret = SendNetlinkMsgToKernel(nlmsg.GetNetLinkMessage());
+    if (ret == 0) {
+        InterfaceInventory::GetInstance().Refresh(name);
+    }
+    return ret;
 }
 } // namespace nmd
 } // namespace OHOS
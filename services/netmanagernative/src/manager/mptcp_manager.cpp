@@ -16,11 +16,9 @@
 #include "mptcp_manager.h"
 
 #include <algorithm>
-#include <cctype>
 #include <cerrno>
-#include <climits>
-#include <cstdlib>
-#include <sstream>
+#include <linux/mptcp.h>
+#include <net/if.h>
 #include "net_manager_constants.h"
 #include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
@@ -29,29 +27,16 @@ namespace OHOS {
 namespace nmd {
 
 namespace {
-constexpr const char *IP_CMD_PATH = "/system/bin/ip";
-constexpr const char *MPTCP_ENDPOINT_ADD = "mptcp endpoint add";
-constexpr const char *MPTCP_ENDPOINT_DELETE = "mptcp endpoint delete id";
-constexpr const char *MPTCP_ENDPOINT_SHOW = "mptcp endpoint show";
-constexpr const char *MPTCP_LIMITS_SET = "mptcp limits set";
-constexpr const char *MPTCP_SUBFLOW_FLAG = "subflow";
-constexpr const char *MPTCP_DEV_FLAG = "dev";
-constexpr const char *MPTCP_SUBFLOWS_PARAM = "subflows";
-constexpr const char *MPTCP_ADD_ADDR_ACCEPTED_PARAM = "add_addr_accepted";
-
-constexpr const char *OPTION_SPACE = " ";
-
 const std::set<std::string> MONITORED_INTERFACES = {"wlan0", "rmnet0", "rmnet1"};
 
 constexpr int32_t MPTCP_MAX_SUBFLOWS = 7;
 constexpr int32_t MPTCP_MAX_ADD_ADDR_ACCEPTED = 7;
 constexpr int32_t MPTCP_DISABLED = 0;
 constexpr int32_t INVALID_ENDPOINT_ID = -1;
-constexpr int32_t STRTOL_BASE = 10;
-constexpr size_t ID_KEYWORD_LEN = 2;
+constexpr int32_t MIN_ENDPOINT_ID = 1;
+constexpr int32_t MAX_ENDPOINT_ID = 255;
 constexpr int32_t MIN_ACTIVE_INTERFACE_COUNT = 1;
 const std::string ENDPOINT_KEY_SEPARATOR = "_";
-const std::string ID_KEYWORD = "id";
 }
 
 MptcpManager::MptcpManager() {}
@@ -71,31 +56,15 @@ int32_t MptcpManager::AddEndpoint(const std::string &ipAddr, const std::string &
         return NetManagerStandard::NETMANAGER_ERR_INVALID_PARAMETER;
     }
 
-    std::string command = BuildEndpointAddCommand(ipAddr, ifName);
-    if (command.empty()) {
-        NETNATIVE_LOGE("AddEndpoint: build command failed");
-        return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
-    }
-
-    int32_t ret = ExecuteMptcpCommand(command);
+    int32_t ret = ApplyEndpointChanges({{ipAddr, ifName, true}});
     if (ret != NetManagerStandard::NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("AddEndpoint: execute command failed, ret=%{public}d", ret);
+        NETNATIVE_LOGE("AddEndpoint: failed, ret=%{public}d", ret);
         return ret;
     }
 
-    int32_t endpointId = GetEndpointId(ipAddr, ifName);
-    if (endpointId < 0) {
-        NETNATIVE_LOGW("AddEndpoint: failed to get endpoint id for ip=%{public}s",
-                       NetManagerStandard::CommonUtils::ToAnonymousIp(ipAddr).c_str());
-    }
-
     std::string key = ipAddr + ENDPOINT_KEY_SEPARATOR + ifName;
-    MptcpEndpointInfo info;
-    info.ipAddr = ipAddr;
-    info.ifName = ifName;
-    info.endpointId = endpointId;
-    endpoints_[key] = info;
-
+    auto it = endpoints_.find(key);
+    int32_t endpointId = it != endpoints_.end() ? it->second.endpointId : INVALID_ENDPOINT_ID;
     NETNATIVE_LOGI("AddEndpoint: success, ip=%{public}s, ifName=%{public}s, id=%{public}d",
                    NetManagerStandard::CommonUtils::ToAnonymousIp(ipAddr).c_str(), ifName.c_str(), endpointId);
     return NetManagerStandard::NETMANAGER_SUCCESS;
@@ -117,29 +86,12 @@ int32_t MptcpManager::DeleteEndpoint(const std::string &ipAddr, const std::strin
     }
 
     int32_t endpointId = it->second.endpointId;
-    if (endpointId < 0) {
-        endpointId = GetEndpointId(ipAddr, ifName);
-        if (endpointId < 0) {
-            NETNATIVE_LOGE("DeleteEndpoint: failed to get endpoint id");
-            endpoints_.erase(it);
-            return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
-        }
-    }
-
-    std::string command = BuildEndpointDeleteCommand(endpointId);
-    if (command.empty()) {
-        NETNATIVE_LOGE("DeleteEndpoint: build command failed");
-        return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
-    }
-
-    int32_t ret = ExecuteMptcpCommand(command);
+    int32_t ret = ApplyEndpointChanges({{ipAddr, ifName, false}});
     if (ret != NetManagerStandard::NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("DeleteEndpoint: execute command failed, ret=%{public}d", ret);
+        NETNATIVE_LOGE("DeleteEndpoint: failed, ret=%{public}d", ret);
         return ret;
     }
 
-    endpoints_.erase(it);
-
     NETNATIVE_LOGI("DeleteEndpoint: success, ip=%{public}s, ifName=%{public}s, id=%{public}d",
                    NetManagerStandard::CommonUtils::ToAnonymousIp(ipAddr).c_str(), ifName.c_str(), endpointId);
     return NetManagerStandard::NETMANAGER_SUCCESS;
@@ -153,18 +105,12 @@ int32_t MptcpManager::SetLimits(int32_t subflows, int32_t addAddrAccepted)
         return NetManagerStandard::NETMANAGER_ERR_INVALID_PARAMETER;
     }
 
-    std::string command = BuildLimitsSetCommand(subflows, addAddrAccepted);
-    if (command.empty()) {
-        NETNATIVE_LOGE("SetLimits: build command failed");
+    int32_t ret = pmClient_.SetLimits(static_cast<uint32_t>(subflows), static_cast<uint32_t>(addAddrAccepted));
+    if (ret != 0) {
+        NETNATIVE_LOGE("SetLimits: set limits failed, ret=%{public}d", ret);
         return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
     }
 
-    int32_t ret = ExecuteMptcpCommand(command);
-    if (ret != NetManagerStandard::NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("SetLimits: execute command failed, ret=%{public}d", ret);
-        return ret;
-    }
-
     currentSubflows_ = subflows;
     currentAddAddrAccepted_ = addAddrAccepted;
 
@@ -175,65 +121,41 @@ int32_t MptcpManager::SetLimits(int32_t subflows, int32_t addAddrAccepted)
 
 void MptcpManager::OnInterfaceAddressUpdated(const std::string &addr, const std::string &ifName)
 {
-    NETNATIVE_LOGI("OnInterfaceAddressUpdated: addr=%{public}s, ifName=%{public}s",
-                   NetManagerStandard::CommonUtils::ToAnonymousIp(addr).c_str(), ifName.c_str());
-
-    if (!IsMonitoredInterface(ifName)) {
-        NETNATIVE_LOG_D("OnInterfaceAddressUpdated: interface %{public}s is not monitored", ifName.c_str());
-        return;
-    }
-
-    if (addr.empty()) {
-        NETNATIVE_LOGE("OnInterfaceAddressUpdated: addr is empty");
-        return;
+    if (IsWantedAddressChange({addr, ifName, true})) {
+        ApplyAddressChanges({{addr, ifName, true}});
     }
+}
 
-    if (!NetManagerStandard::CommonUtils::IsValidIPV4(addr) &&
-        !NetManagerStandard::CommonUtils::IsValidIPV6(addr)) {
-        NETNATIVE_LOGE("OnInterfaceAddressUpdated: invalid ip address format");
-        return;
+void MptcpManager::OnInterfaceAddressRemoved(const std::string &addr, const std::string &ifName)
+{
+    if (IsWantedAddressChange({addr, ifName, false})) {
+        ApplyAddressChanges({{addr, ifName, false}});
     }
+}
 
-    std::lock_guard<std::mutex> lock(mptcpMutex_);
-    auto it = ifaceToIpAddrs_.find(ifName);
-    if (it == ifaceToIpAddrs_.end()) {
-        ifaceToIpAddrs_[ifName] = std::vector<std::string>();
-    }
-    
-    auto &ipAddrs = ifaceToIpAddrs_[ifName];
-    if (std::find(ipAddrs.begin(), ipAddrs.end(), addr) == ipAddrs.end()) {
-        ipAddrs.push_back(addr);
+bool MptcpManager::QueueAddressChange(const std::string &addr, const std::string &ifName, bool added)
+{
+    AddressChange change = {addr, ifName, added};
+    if (!IsWantedAddressChange(change)) {
+        return false;
     }
-
-    AddEndpoint(addr, ifName);
-    UpdateMptcpLimits();
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    pendingChanges_.push_back(change);
+    return pendingChanges_.size() == 1;
 }
 
-void MptcpManager::OnInterfaceAddressRemoved(const std::string &addr, const std::string &ifName)
+void MptcpManager::FlushAddressChanges()
 {
-    NETNATIVE_LOGI("OnInterfaceAddressRemoved: addr=%{public}s, ifName=%{public}s",
-                   NetManagerStandard::CommonUtils::ToAnonymousIp(addr).c_str(), ifName.c_str());
-
-    if (!IsMonitoredInterface(ifName)) {
-        NETNATIVE_LOG_D("OnInterfaceAddressRemoved: interface %{public}s is not monitored", ifName.c_str());
-        return;
+    std::vector<AddressChange> changes;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        changes.swap(pendingChanges_);
     }
-
-    std::lock_guard<std::mutex> lock(mptcpMutex_);
-    auto it = ifaceToIpAddrs_.find(ifName);
-    if (it != ifaceToIpAddrs_.end()) {
-        auto &ipAddrs = it->second;
-        auto addrIt = std::find(ipAddrs.begin(), ipAddrs.end(), addr);
-        if (addrIt != ipAddrs.end()) {
-            ipAddrs.erase(addrIt);
-            DeleteEndpoint(addr, ifName);
-            
-            if (ipAddrs.empty()) {
-                ifaceToIpAddrs_.erase(it);
-            }
-        }
+    if (changes.empty()) {
+        return;
     }
-    UpdateMptcpLimits();
+    NETNATIVE_LOG_D("FlushAddressChanges: %{public}zu changes", changes.size());
+    ApplyAddressChanges(changes);
 }
 
 bool MptcpManager::IsMonitoredInterface(const std::string &ifName)
@@ -241,131 +163,215 @@ bool MptcpManager::IsMonitoredInterface(const std::string &ifName)
     return MONITORED_INTERFACES.find(ifName) != MONITORED_INTERFACES.end();
 }
 
-int32_t MptcpManager::ExecuteMptcpCommand(const std::string &command)
+bool MptcpManager::IsWantedAddressChange(const AddressChange &change)
 {
-    std::string result;
-    return ExecuteMptcpCommand(command, result);
-}
+    NETNATIVE_LOGI("%{public}s: addr=%{public}s, ifName=%{public}s",
+                   change.added ? "OnInterfaceAddressUpdated" : "OnInterfaceAddressRemoved",
+                   NetManagerStandard::CommonUtils::ToAnonymousIp(change.addr).c_str(), change.ifName.c_str());
 
-int32_t MptcpManager::ExecuteMptcpCommand(const std::string &command, std::string &result)
-{
-    if (command.empty()) {
-        NETNATIVE_LOGE("ExecuteMptcpCommand: command is empty");
-        return NetManagerStandard::NETMANAGER_ERR_INVALID_PARAMETER;
+    if (!IsMonitoredInterface(change.ifName)) {
+        NETNATIVE_LOG_D("AddressChange: interface %{public}s is not monitored", change.ifName.c_str());
+        return false;
     }
-
-    int32_t ret = NetManagerStandard::CommonUtils::ForkExec(command, &result);
-    if (ret != NetManagerStandard::NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("ExecuteMptcpCommand: execute failed, ret=%{public}d, result=%{public}s",
-            ret, result.c_str());
-        return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+    if (!change.added) {
+        return true;
     }
 
-    return NetManagerStandard::NETMANAGER_SUCCESS;
-}
+    if (change.addr.empty()) {
+        NETNATIVE_LOGE("OnInterfaceAddressUpdated: addr is empty");
+        return false;
+    }
 
-std::string MptcpManager::BuildEndpointAddCommand(const std::string &ipAddr, const std::string &ifName)
-{
-    std::string command = std::string(IP_CMD_PATH) + OPTION_SPACE + MPTCP_ENDPOINT_ADD + OPTION_SPACE;
-    command += ipAddr + OPTION_SPACE;
-    command += std::string(MPTCP_DEV_FLAG) + OPTION_SPACE + ifName + OPTION_SPACE + MPTCP_SUBFLOW_FLAG;
-    return command;
+    if (!NetManagerStandard::CommonUtils::IsValidIPV4(change.addr) &&
+        !NetManagerStandard::CommonUtils::IsValidIPV6(change.addr)) {
+        NETNATIVE_LOGE("OnInterfaceAddressUpdated: invalid ip address format");
+        return false;
+    }
+    return true;
 }
 
-std::string MptcpManager::BuildEndpointDeleteCommand(int32_t endpointId)
+void MptcpManager::ApplyAddressChanges(const std::vector<AddressChange> &changes)
 {
-    if (endpointId < 0) {
-        return "";
+    std::lock_guard<std::mutex> lock(mptcpMutex_);
+    std::vector<AddressChange> endpointChanges;
+    for (const auto &change : changes) {
+        if (change.added) {
+            auto &ipAddrs = ifaceToIpAddrs_[change.ifName];
+            if (std::find(ipAddrs.begin(), ipAddrs.end(), change.addr) == ipAddrs.end()) {
+                ipAddrs.push_back(change.addr);
+            }
+            endpointChanges.push_back(change);
+            continue;
+        }
+        auto it = ifaceToIpAddrs_.find(change.ifName);
+        if (it == ifaceToIpAddrs_.end()) {
+            continue;
+        }
+        auto &ipAddrs = it->second;
+        auto addrIt = std::find(ipAddrs.begin(), ipAddrs.end(), change.addr);
+        if (addrIt != ipAddrs.end()) {
+            ipAddrs.erase(addrIt);
+            endpointChanges.push_back(change);
+            if (ipAddrs.empty()) {
+                ifaceToIpAddrs_.erase(it);
+            }
+        }
     }
-    std::string command = std::string(IP_CMD_PATH) + OPTION_SPACE + MPTCP_ENDPOINT_DELETE + OPTION_SPACE;
-    command += std::to_string(endpointId);
-    return command;
-}
 
-std::string MptcpManager::BuildLimitsSetCommand(int32_t subflows, int32_t addAddrAccepted)
-{
-    std::string command = std::string(IP_CMD_PATH) + OPTION_SPACE + MPTCP_LIMITS_SET + OPTION_SPACE;
-    command += std::string(MPTCP_SUBFLOWS_PARAM) + OPTION_SPACE + std::to_string(subflows) + OPTION_SPACE;
-    command += std::string(MPTCP_ADD_ADDR_ACCEPTED_PARAM) + OPTION_SPACE + std::to_string(addAddrAccepted);
-    return command;
+    if (!endpointChanges.empty()) {
+        int32_t ret = ApplyEndpointChanges(endpointChanges);
+        if (ret != NetManagerStandard::NETMANAGER_SUCCESS) {
+            NETNATIVE_LOGE("ApplyAddressChanges: apply endpoints failed, ret=%{public}d", ret);
+        }
+    }
+    UpdateMptcpLimits();
 }
 
-std::string MptcpManager::BuildEndpointShowCommand()
+// Sends the endpoint adds and deletes to the kernel in one batch, the table follows what the kernel answered
+int32_t MptcpManager::ApplyEndpointChanges(const std::vector<AddressChange> &changes, bool retry)
 {
-    return std::string(IP_CMD_PATH) + OPTION_SPACE + MPTCP_ENDPOINT_SHOW;
-}
+    if (!endpointsSynced_ && SyncEndpoints() != NetManagerStandard::NETMANAGER_SUCCESS) {
+        return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+    }
 
-// LCOV_EXCL_START
-int32_t MptcpManager::GetResultId(std::string &result, const std::string &ipAddr, const std::string &ifName)
-{
-    std::istringstream iss(result);
-    std::string line;
-    while (std::getline(iss, line)) {
-        std::istringstream lineStream(line);
-        std::string token;
-        bool ipMatched = false;
-        bool ifNameMatched = false;
-        while (lineStream >> token) {
-            if (token == ipAddr) {
-                ipMatched = true;
-            }
-            if (token == ifName) {
-                ifNameMatched = true;
-            }
-        }
-        if (!ipMatched || !ifNameMatched) {
+    // Only the last change of an address in the batch counts
+    std::map<std::string, size_t> lastChange;
+    for (size_t i = 0; i < changes.size(); i++) {
+        lastChange[changes[i].addr + ENDPOINT_KEY_SEPARATOR + changes[i].ifName] = i;
+    }
+    int32_t ret = NetManagerStandard::NETMANAGER_SUCCESS;
+    std::vector<MptcpPmRequest> requests;
+    std::vector<const AddressChange *> requestChanges;
+    for (size_t i = 0; i < changes.size(); i++) {
+        const AddressChange &change = changes[i];
+        std::string key = change.addr + ENDPOINT_KEY_SEPARATOR + change.ifName;
+        auto it = endpoints_.find(key);
+        if (lastChange[key] != i || change.added == (it != endpoints_.end())) {
             continue;
         }
-
-        size_t idPos = line.find(ID_KEYWORD);
-        if (idPos == std::string::npos) {
+        MptcpPmRequest request;
+        if (change.added) {
+            request.op = MptcpPmRequest::ADD_ENDPOINT;
+            request.endpoint.ipAddr = change.addr;
+            request.endpoint.ifIndex = static_cast<int32_t>(if_nametoindex(change.ifName.c_str()));
+            request.endpoint.flags = MPTCP_PM_ADDR_FLAG_SUBFLOW;
+            int32_t id = AllocateEndpointId();
+            if (request.endpoint.ifIndex == 0 || id == INVALID_ENDPOINT_ID) {
+                NETNATIVE_LOGE("ApplyEndpointChanges: no ifindex or endpoint id for %{public}s",
+                               change.ifName.c_str());
+                ret = NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+                continue;
+            }
+            request.endpoint.id = static_cast<uint8_t>(id);
+        } else if (it->second.endpointId == INVALID_ENDPOINT_ID) {
+            endpoints_.erase(it);
             continue;
+        } else {
+            request.op = MptcpPmRequest::DELETE_ENDPOINT;
+            request.endpoint.id = static_cast<uint8_t>(it->second.endpointId);
         }
+        kernelEndpointIds_.insert(request.endpoint.id);
+        requests.push_back(request);
+        requestChanges.push_back(&change);
+    }
+    if (requests.empty()) {
+        return ret;
+    }
 
-        size_t idStart = idPos + ID_KEYWORD_LEN;
-        while (idStart < line.length() && std::isspace(line[idStart])) {
-            idStart++;
+    int32_t err = pmClient_.ApplyBatch(requests);
+    if (err != 0) {
+        NETNATIVE_LOGE("ApplyEndpointChanges: send %{public}zu requests failed, ret=%{public}d", requests.size(), err);
+        endpointsSynced_ = false;
+        return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+    }
+    std::vector<AddressChange> conflicts;
+    for (size_t i = 0; i < requests.size(); i++) {
+        const AddressChange &change = *requestChanges[i];
+        int32_t id = requests[i].endpoint.id;
+        std::string key = change.addr + ENDPOINT_KEY_SEPARATOR + change.ifName;
+        if (!change.added) {
+            // An endpoint the kernel no longer has is gone all the same
+            if (requests[i].error != 0 && requests[i].error != -EINVAL && requests[i].error != -ENOENT) {
+                NETNATIVE_LOGE("ApplyEndpointChanges: delete id %{public}d failed, ret=%{public}d", id,
+                               requests[i].error);
+                ret = NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+                continue;
+            }
+            endpoints_.erase(key);
+            kernelEndpointIds_.erase(id);
+        } else if (requests[i].error == 0) {
+            endpoints_[key] = {change.addr, change.ifName, id};
+        } else {
+            kernelEndpointIds_.erase(id);
+            if (requests[i].error == -EEXIST || requests[i].error == -EBUSY) {
+                conflicts.push_back(change);
+                continue;
+            }
+            NETNATIVE_LOGE("ApplyEndpointChanges: add id %{public}d failed, ret=%{public}d", id, requests[i].error);
+            ret = NetManagerStandard::NETMANAGER_ERR_INTERNAL;
         }
-        if (idStart >= line.length()) {
-            continue;
+    }
+    if (!conflicts.empty()) {
+        // The endpoints of the kernel were changed by someone else, start again from what it has now
+        endpointsSynced_ = false;
+        int32_t retried = retry ? ApplyEndpointChanges(conflicts, false) : NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+        if (retried != NetManagerStandard::NETMANAGER_SUCCESS) {
+            ret = retried;
         }
+    }
+    return ret;
+}
 
-        size_t idEnd = idStart;
-        while (idEnd < line.length() && std::isdigit(line[idEnd])) {
-            idEnd++;
+int32_t MptcpManager::SyncEndpoints()
+{
+    std::vector<MptcpPmEndpoint> kernelEndpoints;
+    int32_t ret = pmClient_.GetEndpoints(kernelEndpoints);
+    if (ret != 0) {
+        NETNATIVE_LOGE("SyncEndpoints: get endpoints failed, ret=%{public}d", ret);
+        return NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+    }
+    kernelEndpointIds_.clear();
+    std::map<std::string, int32_t> kernelIds;
+    for (const auto &endpoint : kernelEndpoints) {
+        kernelEndpointIds_.insert(endpoint.id);
+        char ifName[IF_NAMESIZE] = {0};
+        if (endpoint.ifIndex > 0 && if_indextoname(static_cast<uint32_t>(endpoint.ifIndex), ifName) != nullptr) {
+            kernelIds[endpoint.ipAddr + ENDPOINT_KEY_SEPARATOR + ifName] = endpoint.id;
         }
-        if (idEnd == idStart) {
+    }
+    // Endpoints the kernel lost are forgotten, those it has of a monitored address already are adopted
+    for (auto it = endpoints_.begin(); it != endpoints_.end();) {
+        auto found = kernelIds.find(it->first);
+        if (found == kernelIds.end()) {
+            it = endpoints_.erase(it);
             continue;
         }
-
-        std::string idStr = line.substr(idStart, idEnd - idStart);
-        int32_t id = NetManagerStandard::CommonUtils::StrToInt(idStr, INVALID_ENDPOINT_ID);
-        NETNATIVE_LOG_D("GetEndpointId: found id=%{public}d for ip=%{public}s, ifName=%{public}s",
-                        id, NetManagerStandard::CommonUtils::ToAnonymousIp(ipAddr).c_str(), ifName.c_str());
-        return id;
+        it->second.endpointId = found->second;
+        ++it;
     }
-    return INVALID_ENDPOINT_ID;
+    for (const auto &[ifName, ipAddrs] : ifaceToIpAddrs_) {
+        for (const auto &ipAddr : ipAddrs) {
+            std::string key = ipAddr + ENDPOINT_KEY_SEPARATOR + ifName;
+            auto found = kernelIds.find(key);
+            if (found != kernelIds.end() && endpoints_.find(key) == endpoints_.end()) {
+                endpoints_[key] = {ipAddr, ifName, found->second};
+            }
+        }
+    }
+    endpointsSynced_ = true;
+    NETNATIVE_LOG_D("SyncEndpoints: %{public}zu endpoints in the kernel", kernelEndpoints.size());
+    return NetManagerStandard::NETMANAGER_SUCCESS;
 }
 
-int32_t MptcpManager::GetEndpointId(const std::string &ipAddr, const std::string &ifName)
+int32_t MptcpManager::AllocateEndpointId()
 {
-    std::string command = BuildEndpointShowCommand();
-    std::string result;
-    int32_t ret = ExecuteMptcpCommand(command, result);
-    if (ret != NetManagerStandard::NETMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("GetEndpointId: execute show command failed");
-        return INVALID_ENDPOINT_ID;
-    }
-
-    int32_t resultId = GetResultId(result, ipAddr, ifName);
-    if (resultId != INVALID_ENDPOINT_ID) {
-        return resultId;
+    for (int32_t id = MIN_ENDPOINT_ID; id <= MAX_ENDPOINT_ID; id++) {
+        if (kernelEndpointIds_.find(id) == kernelEndpointIds_.end()) {
+            return id;
+        }
     }
-    NETNATIVE_LOGW("GetEndpointId: endpoint not found for ip=%{public}s, ifName=%{public}s",
-                   NetManagerStandard::CommonUtils::ToAnonymousIp(ipAddr).c_str(), ifName.c_str());
     return INVALID_ENDPOINT_ID;
 }
-// LCOV_EXCL_STOP
 
 void MptcpManager::UpdateMptcpLimits()
 {
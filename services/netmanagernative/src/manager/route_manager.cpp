@@ -36,6 +36,7 @@
 #include "netlink_msg.h"
 #include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
+#include "rtnetlink_transaction.h"
 #include "securec.h"
 #include "distributed_manager.h"
 #ifdef SUPPORT_SYSVPN
@@ -100,7 +101,6 @@ const std::string RULEOIF_NULL = "";
 const std::string RULEIP_NULL = "";
 const std::string LOCAL_MANGLE_INPUT = "routectrl_mangle_INPUT";
 constexpr const char *NETSYS_ROUTE_INIT_DIR_PATH = "/data/service/el1/public/netmanager/route";
-constexpr const char *IP_CMD_PATH = "/system/bin/ip";
 
 struct FibRuleUidRange {
     __u32 start;
@@ -708,12 +708,11 @@ int32_t RouteManager::EnableDistributedClientNet(const std::string &virNicAddr,
     }
     table += ROUTE_TABLE_OFFSET_FROM_INDEX;
 
-    std::string out;
-    std::string createVirnicRoute = std::string(IP_CMD_PATH) + " route add default via " + virNicVethAddr +
-        " dev " + virNicName + " table " + std::to_string(table) + " proto static";
-    NETNATIVE_LOGI("create Virnic Route: %{public}s", CommonUtils::AnonymousIpInStr(createVirnicRoute).c_str());
-    if (CommonUtils::ForkExec(createVirnicRoute.c_str(), &out) != ROUTEMANAGER_SUCCESS) {
-        NETNATIVE_LOGE("create Virnic Route failed, output %{public}s", out.c_str());
+    NETNATIVE_LOGI("create Virnic Route via %{public}s, table %{public}u", ToAnonymousIp(virNicVethAddr).c_str(),
+                   table);
+    ret = nmd::RtnetlinkTransaction().AddRoute(virNicName, "0.0.0.0", 0, virNicVethAddr, table).Commit();
+    if (ret != 0) {
+        NETNATIVE_LOGE("create Virnic Route failed, ret %{public}d", ret);
         return ROUTEMANAGER_ERROR;
     }
     NETNATIVE_LOGI("EnableDistributedClientNet add route success.");
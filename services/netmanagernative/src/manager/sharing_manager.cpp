@@ -15,17 +15,20 @@
 
 #include "sharing_manager.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <fcntl.h>
 #include <ifaddrs.h>
-#include <regex>
 #include <unistd.h>
-#include <charconv>
 #include <net/if.h>
 
+#include "bpf_def.h"
+#include "bpf_mapper.h"
+#include "bpf_path.h"
 #include "net_manager_constants.h"
 #include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
+#include "tc_bpf_filter.h"
 
 namespace OHOS {
 namespace nmd {
@@ -36,10 +39,7 @@ constexpr const char *IPV6_FORWARDING_PROC_FILE = "/proc/sys/net/ipv6/conf/all/f
 constexpr const char *IPTABLES_TMP_BAK = "/data/service/el1/public/netmanager/ipfwd.bak";
 constexpr const char *IPV6_PROC_PATH = "/proc/sys/net/ipv6/conf/";
 constexpr const char *IP6TABLES_TMP_BAK = "/data/service/el1/public/netmanager/ip6fwd.bak";
-constexpr const int MAX_MATCH_SIZE = 4;
-constexpr const int TWO_LIST_CORRECT_DATA = 2;
-constexpr const int NEXT_LIST_CORRECT_DATA = 1;
-constexpr uint32_t NET_TRAFFIC_RESULT_INDEX_OFFSET = 2;
+constexpr uint16_t TETHER_FILTER_PRIO = 1;
 const std::string CELLULAR_IFACE_NAME = "rmnet";
 const std::string WLAN_IFACE_NAME = "wlan";
 const std::string P2P_IFACE_NAME = "p2p-p2p0";
@@ -396,6 +396,7 @@ int32_t SharingManager::IpfwdAddInterfaceForward(const std::string &fromIface, c
         EnableShareUnreachableRoute(RouteManager::UNREACHABLE_NETWORK);
     }
     AddSharingSecurityRules(fromIface, toIface);
+    AddTetherCounters(fromIface, toIface);
     std::lock_guard<std::mutex> guard(interfaceForwardsMutex_);
     interfaceForwards_.insert(fromIface + toIface);
     return 0;
@@ -432,6 +433,7 @@ int32_t SharingManager::IpfwdRemoveInterfaceForward(const std::string &fromIface
     }
     CombineRestoreRules(CMD_COMMIT, fwdCmdSet);
     iptablesWrapper_->RunRestoreCommands(IPTYPE_IPV4V6, fwdCmdSet);
+    RemoveTetherCounters(fromIface, toIface);
     {
         std::lock_guard<std::mutex> guard(onDpaSharingTrafficMutex_);
         onDpaSharingTraffic_.clear();
@@ -453,47 +455,21 @@ int32_t SharingManager::IpfwdRemoveInterfaceForward(const std::string &fromIface
 int32_t SharingManager::GetNetworkSharingTraffic(const std::string &downIface, const std::string &upIface,
                                                  NetworkSharingTraffic &traffic)
 {
-    const std::string cmds = "-t filter -L tetherctrl_counters -nvx";
-    std::string result = iptablesWrapper_->RunCommandForRes(IPTYPE_IPV4V6, cmds);
-    const std::string num = "(\\d+)";
-    const std::string iface = "([^\\s]+)";
-    const std::string dst = "(0.0.0.0/0|::/0)";
-    const std::string counters = "\\s*" + num + "\\s+" + num + " RETURN     all(  --  |      )" + iface + "\\s+" +
-                                 iface + "\\s+" + dst + "\\s+" + dst;
-    static const std::regex IP_RE(counters);
-
     bool isFindTx = false;
     bool isFindRx = false;
-    const std::vector<std::string> lines = CommonUtils::Split(result, "\n");
-    std::size_t size1 = lines.size();
-    for (auto line : lines) {
-        std::smatch matches;
-        std::regex_search(line, matches, IP_RE);
-        if (matches.size() < MAX_MATCH_SIZE) {
-            continue;
+    for (const auto &counter : ReadTetherCounters()) {
+        if (counter.inIface == downIface && counter.outIface == upIface) {
+            isFindTx = true;
+            traffic.send = counter.bytes;
+            traffic.all += counter.bytes;
+        } else if (counter.inIface == upIface && counter.outIface == downIface) {
+            isFindRx = true;
+            traffic.receive = counter.bytes;
+            traffic.all += counter.bytes;
         }
-        for (uint32_t i = 0; i < matches.size() - 1; i++) {
-            std::string tempMatch = matches[i];
-            NETNATIVE_LOG_D("GetNetworkSharingTraffic matche[%{public}s]", tempMatch.c_str());
-            if (matches[i] == downIface && matches[i + NEXT_LIST_CORRECT_DATA] == upIface &&
-                (i >= TWO_LIST_CORRECT_DATA)) {
-                int64_t send =
-                    static_cast<int64_t>(strtoul(matches[i - TWO_LIST_CORRECT_DATA].str().c_str(), nullptr, 0));
-                isFindTx = true;
-                traffic.send = send;
-                traffic.all += send;
-            } else if (matches[i] == upIface && matches[i + NEXT_LIST_CORRECT_DATA] == downIface &&
-                       (i >= NET_TRAFFIC_RESULT_INDEX_OFFSET)) {
-                int64_t receive =
-                    static_cast<int64_t>(strtoul(matches[i - TWO_LIST_CORRECT_DATA].str().c_str(), nullptr, 0));
-                isFindRx = true;
-                traffic.receive = receive;
-                traffic.all += receive;
-            }
-            if (isFindTx && isFindRx) {
-                NETNATIVE_LOG_D("GetNetworkSharingTraffic success total");
-                return NETMANAGER_SUCCESS;
-            }
+        if (isFindTx && isFindRx) {
+            NETNATIVE_LOG_D("GetNetworkSharingTraffic success total");
+            return NETMANAGER_SUCCESS;
         }
     }
     NETNATIVE_LOGE("GetNetworkSharingTraffic failed");
@@ -502,21 +478,18 @@ int32_t SharingManager::GetNetworkSharingTraffic(const std::string &downIface, c
 
 int32_t SharingManager::GetNetworkCellularSharingTraffic(NetworkSharingTraffic &traffic, std::string &ifaceName)
 {
-    const std::string cmds = "-t filter -L tetherctrl_counters -nvx";
-    for (IpType ipType : {IPTYPE_IPV4, IPTYPE_IPV6}) {
-        NetworkSharingTraffic traffic0;
-        std::string ifaceName0 = "";
-        std::string result = iptablesWrapper_->RunCommandForRes(ipType, cmds);
-        int32_t ret = QueryCellularSharingTraffic(traffic0, result, ifaceName0);
-        if (ret != NETMANAGER_SUCCESS) {
-            NETNATIVE_LOGI("ipv4 GetNetworkSharingTraffic failed");
-            return NETMANAGER_ERROR;
-        }
-        traffic.receive += traffic0.receive;
-        traffic.send += traffic0.send;
-        traffic.all += traffic0.all;
-        ifaceName = ifaceName0;
-    }
+    // The counters cover IPv4 and IPv6 together
+    NetworkSharingTraffic traffic0;
+    std::string ifaceName0 = "";
+    int32_t ret = QueryCellularSharingTraffic(traffic0, ReadTetherCounters(), ifaceName0);
+    if (ret != NETMANAGER_SUCCESS) {
+        NETNATIVE_LOGI("GetNetworkCellularSharingTraffic failed");
+        return NETMANAGER_ERROR;
+    }
+    traffic.receive += traffic0.receive;
+    traffic.send += traffic0.send;
+    traffic.all += traffic0.all;
+    ifaceName = ifaceName0;
     // LCOV_EXCL_START
     NetworkSharingTraffic traffic1;
     std::string ifaceName1 = ifaceName;
@@ -583,25 +556,12 @@ void SharingManager::QueryDpaCellularSharingTraffic(const std::vector<DpaWifiTra
 }
 
 int32_t SharingManager::QueryCellularSharingTraffic(NetworkSharingTraffic &traffic,
-    const std::string &result, std::string &ifaceName)
+    const std::vector<TetherTrafficCounter> &counters, std::string &ifaceName)
 {
-    const std::string num = "(\\d+)";
-    const std::string iface = "([^\\s]+)";
-    const std::string dst = "(0.0.0.0/0|::/0)";
-    const std::string counters = "\\s*" + num + "\\s+" + num + " RETURN     all(  --  |      )" + iface + "\\s+" +
-                                 iface + "\\s+" + dst + "\\s+" + dst;
-    static const std::regex IP_RE(counters);
-
     bool isFindTx = false;
     bool isFindRx = false;
-    const std::vector<std::string> lines = CommonUtils::Split(result, "\n");
-    for (auto line : lines) {
-        std::smatch matches;
-        std::regex_search(line, matches, IP_RE);
-        if (matches.size() < MAX_MATCH_SIZE) {
-            continue;
-        }
-        GetTraffic(matches, ifaceName, traffic, isFindTx, isFindRx);
+    for (const auto &counter : counters) {
+        GetTraffic(counter, ifaceName, traffic, isFindTx, isFindRx);
         if (isFindTx && isFindRx) {
             NETNATIVE_LOG_D("GetNetworkSharingTraffic success total");
             return NETMANAGER_SUCCESS;
@@ -611,64 +571,144 @@ int32_t SharingManager::QueryCellularSharingTraffic(NetworkSharingTraffic &traff
     return NETMANAGER_ERROR;
 }
 
-static bool ConvertStrToLong(const std::string &str, int64_t &value)
+void SharingManager::GetTraffic(const TetherTrafficCounter &counter, std::string &ifaceName,
+    NetworkSharingTraffic &traffic, bool &isFindTx, bool &isFindRx)
+{
+    const std::string &inIface = counter.inIface;
+    const std::string &outIface = counter.outIface;
+    NETNATIVE_LOG_D("GetNetworkCellularSharingTraffic %{public}s to %{public}s", inIface.c_str(), outIface.c_str());
+    if (inIface.find(CELLULAR_IFACE_NAME) != std::string::npos
+        && outIface.find(WLAN_IFACE_NAME) != std::string::npos) {
+        isFindTx = true;
+        traffic.send = counter.bytes;
+        traffic.all += counter.bytes;
+        ifaceName = inIface;
+    } else if (inIface.find(WLAN_IFACE_NAME) != std::string::npos
+        && outIface.find(CELLULAR_IFACE_NAME) != std::string::npos) {
+        isFindRx = true;
+        traffic.receive = counter.bytes;
+        traffic.all += counter.bytes;
+    } else if (inIface.find(WLAN_IFACE_NAME) != std::string::npos
+        && outIface.find(WLAN_IFACE_NAME) != std::string::npos && ifaceName == "") {
+        isFindTx = true;
+        traffic.send = counter.bytes;
+        traffic.all += counter.bytes;
+        ifaceName = inIface;
+    } else if (inIface.find(WLAN_IFACE_NAME) != std::string::npos
+        && outIface.find(WLAN_IFACE_NAME) != std::string::npos
+        && ifaceName.find(WLAN_IFACE_NAME) != std::string::npos) {
+        isFindRx = true;
+        traffic.receive = counter.bytes;
+        traffic.all += counter.bytes;
+    }
+}
+
+void SharingManager::AddTetherCounters(const std::string &fromIface, const std::string &toIface)
+{
+    uint32_t fromIndex = if_nametoindex(fromIface.c_str());
+    uint32_t toIndex = if_nametoindex(toIface.c_str());
+    if (fromIndex == 0 || toIndex == 0) {
+        NETNATIVE_LOGE("AddTetherCounters: no index for %{public}s or %{public}s", fromIface.c_str(),
+                       toIface.c_str());
+        return;
+    }
+    BpfMapper<tether_stats_key, tether_stats_value> statsMap(TETHER_STATS_MAP_PATH, BPF_ANY);
+    if (!statsMap.IsValid()) {
+        NETNATIVE_LOGE("AddTetherCounters: tether_stats_map is not available");
+        return;
+    }
+    // Counting starts again with the forward, as it did with the counter rules added along with it
+    tether_stats_value value = {};
+    if (statsMap.Write({toIndex, fromIndex}, value, BPF_ANY) != 0 ||
+        statsMap.Write({fromIndex, toIndex}, value, BPF_ANY) != 0) {
+        NETNATIVE_LOGE("AddTetherCounters: write %{public}u/%{public}u failed, errno=%{public}d", fromIndex, toIndex,
+                       errno);
+        return;
+    }
+    std::lock_guard<std::mutex> guard(interfaceForwardsMutex_);
+    // Attaching again replaces the filter, so a shared iface keeps a single one
+    for (uint32_t ifIndex : {fromIndex, toIndex}) {
+        if (AttachTcEgressBpf(ifIndex, TETHER_EGRESS_PROG_PATH, TETHER_FILTER_PRIO) !=
+            NetManagerStandard::NETMANAGER_SUCCESS) {
+            NETNATIVE_LOGE("AddTetherCounters: attach to %{public}u failed, %{public}s to %{public}s is not counted",
+                           ifIndex, fromIface.c_str(), toIface.c_str());
+            // A pair missing the filter of one side would report only half of its traffic
+            tetherCounterPairs_.erase(std::remove_if(tetherCounterPairs_.begin(), tetherCounterPairs_.end(),
+                [&](const auto &pair) { return pair.fromIface == fromIface && pair.toIface == toIface; }),
+                tetherCounterPairs_.end());
+            ReleaseTetherCounters({fromIface, toIface, fromIndex, toIndex});
+            return;
+        }
+    }
+    for (auto &pair : tetherCounterPairs_) {
+        if (pair.fromIface == fromIface && pair.toIface == toIface) {
+            pair.fromIndex = fromIndex;
+            pair.toIndex = toIndex;
+            return;
+        }
+    }
+    tetherCounterPairs_.push_back({fromIface, toIface, fromIndex, toIndex});
+}
+
+void SharingManager::RemoveTetherCounters(const std::string &fromIface, const std::string &toIface)
 {
-    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
-    return ec == std::errc{} && ptr == str.data() + str.size();
+    std::lock_guard<std::mutex> guard(interfaceForwardsMutex_);
+    auto it = std::find_if(tetherCounterPairs_.begin(), tetherCounterPairs_.end(), [&](const auto &pair) {
+        return pair.fromIface == fromIface && pair.toIface == toIface;
+    });
+    if (it == tetherCounterPairs_.end()) {
+        return;
+    }
+    TetherCounterPair removed = *it;
+    tetherCounterPairs_.erase(it);
+    ReleaseTetherCounters(removed);
 }
 
-void SharingManager::GetTraffic(std::smatch &matches, std::string &ifaceName, NetworkSharingTraffic &traffic,
-    bool &isFindTx, bool &isFindRx)
+// Detaches the filters no remaining pair needs and deletes the counters of the pair, called with
+// interfaceForwardsMutex_ held once the pair is out of tetherCounterPairs_
+void SharingManager::ReleaseTetherCounters(const TetherCounterPair &removed)
 {
-    if (matches.empty()) {
+    for (uint32_t ifIndex : {removed.fromIndex, removed.toIndex}) {
+        bool inUse = std::any_of(tetherCounterPairs_.begin(), tetherCounterPairs_.end(), [ifIndex](const auto &pair) {
+            return pair.fromIndex == ifIndex || pair.toIndex == ifIndex;
+        });
+        if (!inUse) {
+            DetachTcEgressBpf(ifIndex, TETHER_FILTER_PRIO);
+        }
+    }
+    BpfMapper<tether_stats_key, tether_stats_value> statsMap(TETHER_STATS_MAP_PATH, BPF_ANY);
+    if (!statsMap.IsValid()) {
         return;
     }
-    for (uint32_t i = 0; i < matches.size() - 1; i++) {
-        std::string matchTemp = matches[i];
-        NETNATIVE_LOG_D("GetNetworkCellularSharingTraffic matche[%{public}s]", matchTemp.c_str());
-        std::string matchNext = matches[i + NEXT_LIST_CORRECT_DATA];
-        if (matchTemp.find(CELLULAR_IFACE_NAME) != std::string::npos
-            && matchNext.find(WLAN_IFACE_NAME) != std::string::npos && ((i - TWO_LIST_CORRECT_DATA) >= 0)) {
-            int64_t send = 0;
-            if (!ConvertStrToLong(matches[i - TWO_LIST_CORRECT_DATA].str(), send)) {
-                return;
-            }
-            isFindTx = true;
-            traffic.send = send;
-            traffic.all += send;
-            ifaceName = matchTemp;
-        } else if (matchTemp.find(WLAN_IFACE_NAME) != std::string::npos
-            && matchNext.find(CELLULAR_IFACE_NAME) != std::string::npos && ((i - TWO_LIST_CORRECT_DATA) >= 0)) {
-            int64_t receive = 0;
-            if (!ConvertStrToLong(matches[i - TWO_LIST_CORRECT_DATA].str(), receive)) {
-                return;
-            }
-            isFindRx = true;
-            traffic.receive = receive;
-            traffic.all += receive;
-        } else if (matchTemp.find(WLAN_IFACE_NAME) != std::string::npos
-            && matchNext.find(WLAN_IFACE_NAME) != std::string::npos && ((i - TWO_LIST_CORRECT_DATA) >= 0)
-            && ifaceName == "") {
-            int64_t send = 0;
-            if (!ConvertStrToLong(matches[i - TWO_LIST_CORRECT_DATA].str(), send)) {
-                return;
-            }
-            isFindTx = true;
-            traffic.send = send;
-            traffic.all += send;
-            ifaceName = matchTemp;
-        } else if (matchTemp.find(WLAN_IFACE_NAME) != std::string::npos
-            && matchNext.find(WLAN_IFACE_NAME) != std::string::npos && ((i - TWO_LIST_CORRECT_DATA) >= 0)
-            && ifaceName.find(WLAN_IFACE_NAME) != std::string::npos) {
-            int64_t receive = 0;
-            if (!ConvertStrToLong(matches[i - TWO_LIST_CORRECT_DATA].str(), receive)) {
-                return;
-            }
-            isFindRx = true;
-            traffic.receive = receive;
-            traffic.all += receive;
+    for (const tether_stats_key &key : {tether_stats_key {removed.toIndex, removed.fromIndex},
+                                        tether_stats_key {removed.fromIndex, removed.toIndex}}) {
+        if (statsMap.Delete(key) != 0 && errno != ENOENT) {
+            NETNATIVE_LOGE("ReleaseTetherCounters: delete %{public}u/%{public}u failed, errno=%{public}d",
+                           key.inIfIndex, key.outIfIndex, errno);
+        }
+    }
+}
+
+// Both directions of every forward, the upstream one first as in the counters chain they replace
+std::vector<TetherTrafficCounter> SharingManager::ReadTetherCounters()
+{
+    std::vector<TetherTrafficCounter> counters;
+    BpfMapper<tether_stats_key, tether_stats_value> statsMap(TETHER_STATS_MAP_PATH, BPF_F_RDONLY);
+    if (!statsMap.IsValid()) {
+        NETNATIVE_LOGE("ReadTetherCounters: tether_stats_map is not available");
+        return counters;
+    }
+    std::lock_guard<std::mutex> guard(interfaceForwardsMutex_);
+    for (const auto &pair : tetherCounterPairs_) {
+        tether_stats_value value = {};
+        if (statsMap.Read({pair.toIndex, pair.fromIndex}, value) == 0) {
+            counters.push_back({pair.toIface, pair.fromIface, static_cast<int64_t>(value.bytes)});
+        }
+        if (statsMap.Read({pair.fromIndex, pair.toIndex}, value) == 0) {
+            counters.push_back({pair.fromIface, pair.toIface, static_cast<int64_t>(value.bytes)});
         }
     }
+    return counters;
 }
 
 void SharingManager::CheckInited()
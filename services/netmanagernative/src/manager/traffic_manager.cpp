@@ -15,101 +15,96 @@
 
 #include "traffic_manager.h"
 
-#include <algorithm>
-#include <dirent.h>
-#include <fcntl.h>
-#include <net/if.h>
+#include <chrono>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <mutex>
 #include <sys/socket.h>
-#include <sys/types.h>
-#include <sys/un.h>
-#include <unistd.h>
+#include <sys/stat.h>
 
-#include "net_manager_native.h"
+#include "net_diag_netlink_collector.h"
+#include "net_manager_constants.h"
 #include "netnative_log_wrapper.h"
-#include "securec.h"
+#include "rtnetlink_link.h"
 
 namespace OHOS {
 namespace nmd {
+using namespace NetManagerStandard;
 namespace {
-constexpr const char *INTERFACE_LIST_DIR = "/sys/class/net/";
-constexpr const char *STATISTICS = "statistics";
-constexpr const char *RX_BYTES = "rx_bytes";
-constexpr const char *TX_BYTES = "tx_bytes";
-constexpr const char *RX_PACKETS = "rx_packets";
-constexpr const char *TX_PACKETS = "tx_packets";
-} // namespace
-
-std::vector<std::string> GetInterfaceList()
+constexpr const char *LOOPBACK_IFACE = "lo";
+// Back-to-back queries within this window are answered from the same dump
+constexpr std::chrono::milliseconds SNAPSHOT_TTL(100);
+constexpr const char *THREAD_NETNS_PATH = "/proc/thread-self/ns/net";
+
+struct LinkDumpRequest {
+    nlmsghdr nlh_;
+    ifinfomsg ifi_;
+};
+
+std::mutex g_snapshotMutex;
+std::shared_ptr<const std::vector<TrafficStatsParcel>> g_snapshot;
+std::chrono::steady_clock::time_point g_snapshotTime;
+// A dump lists the links of the network namespace of the calling thread, the snapshot only answers that one
+ino_t g_snapshotNetns = 0;
+
+ino_t GetThreadNetns()
 {
-    DIR *dir(nullptr);
-    struct dirent *ptr(nullptr);
-    std::vector<std::string> ifList;
-
-    dir = opendir(INTERFACE_LIST_DIR);
-    if (dir == nullptr) {
-        NETNATIVE_LOGE("GetInterfaceList open %{private}s failed", INTERFACE_LIST_DIR);
-        return ifList;
-    }
-
-    ptr = readdir(dir);
-    while (ptr != nullptr) {
-        if (strcmp(ptr->d_name, ".") != 0 && strcmp(ptr->d_name, "..") != 0) {
-            ifList.push_back(ptr->d_name);
-        }
-        ptr = readdir(dir);
-    }
-    closedir(dir);
-
-    return ifList;
+    struct stat st = {};
+    return stat(THREAD_NETNS_PATH, &st) == 0 ? st.st_ino : 0;
 }
 
-long GetInterfaceTrafficByType(const std::string &path, const std::string &type)
+void ParseLinkMessage(const nlmsghdr *nlh, std::vector<TrafficStatsParcel> &stats)
 {
-    if (path.empty()) {
-        return -1;
+    RtnetlinkLink link;
+    if (nlh->nlmsg_type != RTM_NEWLINK || !ParseRtnetlinkLink(nlh, link) || link.name.empty()) {
+        return;
     }
+    TrafficStatsParcel parcel = {link.name, static_cast<unsigned int>(link.index), 0, 0, 0, 0};
+    parcel.rxBytes = static_cast<long>(link.stats.rx_bytes);
+    parcel.rxPackets = static_cast<long>(link.stats.rx_packets);
+    parcel.txBytes = static_cast<long>(link.stats.tx_bytes);
+    parcel.txPackets = static_cast<long>(link.stats.tx_packets);
+    stats.push_back(parcel);
+}
+} // namespace
 
-    std::string trafficPath = path + type;
-
-    char tmpPath[PATH_MAX] = {0};
-    if (!realpath(trafficPath.c_str(), tmpPath)) {
-        NETNATIVE_LOGE("file name is illegal");
-        return -1;
-    }
+int32_t TrafficManager::DumpInterfaceTraffic(std::vector<TrafficStatsParcel> &stats)
+{
+    LinkDumpRequest request = {};
+    request.nlh_.nlmsg_len = sizeof(request);
+    request.nlh_.nlmsg_type = RTM_GETLINK;
+    request.nlh_.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.ifi_.ifi_family = AF_UNSPEC;
+    return NetDiagNetlinkCollector::Dump(NETLINK_ROUTE, &request.nlh_,
+                                         [&stats](const nlmsghdr *nlh) { ParseLinkMessage(nlh, stats); });
+}
 
-    int fd = open(tmpPath, 0, 0666);
-    if (fd == -1) {
-        NETNATIVE_LOGE("GetInterfaceTrafficByType open %{private}s failed", INTERFACE_LIST_DIR);
-        return -1;
+std::shared_ptr<const std::vector<TrafficStatsParcel>> TrafficManager::GetTrafficSnapshot()
+{
+    std::lock_guard<std::mutex> lock(g_snapshotMutex);
+    auto now = std::chrono::steady_clock::now();
+    ino_t netns = GetThreadNetns();
+    if (g_snapshot != nullptr && now - g_snapshotTime < SNAPSHOT_TTL && netns == g_snapshotNetns) {
+        return g_snapshot;
     }
-
-    char buf[100] = {0};
-    int nread = read(fd, buf, sizeof(long));
-    if (nread == -1) {
-        NETNATIVE_LOGE("GetInterfaceTrafficByType read %{private}s failed", INTERFACE_LIST_DIR);
-        close(fd);
-        return -1;
+    auto stats = std::make_shared<std::vector<TrafficStatsParcel>>();
+    if (DumpInterfaceTraffic(*stats) != NETMANAGER_SUCCESS) {
+        NETNATIVE_LOGE("Dump interface traffic failed");
+        // A failed dump is not cached, the next query tries again
+        return std::make_shared<const std::vector<TrafficStatsParcel>>();
     }
-    close(fd);
-
-    return atol(buf);
+    g_snapshot = stats;
+    g_snapshotTime = now;
+    g_snapshotNetns = netns;
+    return g_snapshot;
 }
 
 long TrafficManager::GetAllRxTraffic()
 {
-    std::vector<std::string> ifNameList = GetInterfaceList();
-    if (ifNameList.empty()) {
-        return 0;
-    }
-
     long allRxBytes = 0;
-    for (auto iter = ifNameList.begin(); iter != ifNameList.end(); iter++) {
-        if (*iter != "lo") {
-            std::string baseTrafficPath = INTERFACE_LIST_DIR + (*iter) + "/" + STATISTICS + "/";
-            long rxBytes = GetInterfaceTrafficByType(baseTrafficPath, RX_BYTES);
-            if (rxBytes >= 0) {
-                allRxBytes += rxBytes;
-            }
+    for (const auto &stats : *GetTrafficSnapshot()) {
+        if (stats.iface != LOOPBACK_IFACE) {
+            allRxBytes += stats.rxBytes;
         }
     }
     return allRxBytes;
@@ -117,19 +112,10 @@ long TrafficManager::GetAllRxTraffic()
 
 long TrafficManager::GetAllTxTraffic()
 {
-    std::vector<std::string> ifNameList = GetInterfaceList();
-    if (ifNameList.empty()) {
-        return 0;
-    }
-
     long allTxBytes = 0;
-    for (auto iter = ifNameList.begin(); iter != ifNameList.end(); iter++) {
-        if (*iter != "lo") {
-            std::string baseTrafficPath = INTERFACE_LIST_DIR + (*iter) + "/" + STATISTICS + "/";
-            long txBytes = GetInterfaceTrafficByType(baseTrafficPath, TX_BYTES);
-            if (txBytes >= 0) {
-                allTxBytes = allTxBytes + txBytes;
-            }
+    for (const auto &stats : *GetTrafficSnapshot()) {
+        if (stats.iface != LOOPBACK_IFACE) {
+            allTxBytes += stats.txBytes;
         }
     }
     return allTxBytes;
@@ -138,27 +124,10 @@ long TrafficManager::GetAllTxTraffic()
 TrafficStatsParcel TrafficManager::GetInterfaceTraffic(const std::string &ifName)
 {
     nmd::TrafficStatsParcel interfaceTrafficBytes = {"", 0, 0, 0, 0, 0};
-    std::vector<std::string> ifNameList = GetInterfaceList();
-    if (ifNameList.empty()) {
-        return interfaceTrafficBytes;
-    }
-    for (auto iter = ifNameList.begin(); iter != ifNameList.end(); iter++) {
-        if (ifName != *iter) {
-            continue;
+    for (const auto &stats : *GetTrafficSnapshot()) {
+        if (stats.iface == ifName) {
+            return stats;
         }
-        std::string baseTrafficPath = INTERFACE_LIST_DIR + (*iter) + "/" + STATISTICS + "/";
-        long infRxBytes = GetInterfaceTrafficByType(baseTrafficPath, RX_BYTES);
-        long infRxPackets = GetInterfaceTrafficByType(baseTrafficPath, RX_PACKETS);
-        long infTxBytes = GetInterfaceTrafficByType(baseTrafficPath, TX_BYTES);
-        long infTxPackets = GetInterfaceTrafficByType(baseTrafficPath, TX_PACKETS);
-
-        interfaceTrafficBytes.iface = ifName;
-        interfaceTrafficBytes.ifIndex = if_nametoindex(ifName.c_str());
-
-        interfaceTrafficBytes.rxBytes = infRxBytes == -1 ? 0 : infRxBytes;
-        interfaceTrafficBytes.rxPackets = infRxPackets == -1 ? 0 : infRxPackets;
-        interfaceTrafficBytes.txBytes = infTxBytes == -1 ? 0 : infTxBytes;
-        interfaceTrafficBytes.txPackets = infTxPackets == -1 ? 0 : infTxPackets;
     }
     return interfaceTrafficBytes;
 }
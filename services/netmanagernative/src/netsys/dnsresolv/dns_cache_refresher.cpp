@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dns_cache_refresher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+#include "fwmark.h"
+#include "netnative_log_wrapper.h"
+
+namespace OHOS::nmd {
+namespace {
+constexpr size_t DNS_HEADER_LEN = 12;
+constexpr size_t DNS_RR_FIXED_LEN = 10;
+constexpr size_t DNS_QUESTION_FIXED_LEN = 4;
+constexpr size_t MAX_DNS_NAME_LEN = 253;
+constexpr size_t MAX_DNS_LABEL_LEN = 63;
+constexpr size_t MAX_DNS_UDP_LEN = 512;
+constexpr uint16_t DNS_CLASS_IN = 1;
+constexpr uint16_t DNS_TYPE_CNAME = 5;
+constexpr uint16_t DNS_FLAG_RD = 0x0100;
+constexpr uint16_t DNS_FLAG_QR = 0x8000;
+constexpr uint16_t DNS_FLAG_TC = 0x0200;
+constexpr uint16_t DNS_RCODE_MASK = 0x000f;
+constexpr uint8_t DNS_COMPRESSION_MASK = 0xc0;
+constexpr size_t IPV4_ADDR_LEN = 4;
+constexpr size_t IPV6_ADDR_LEN = 16;
+constexpr int BYTE_BITS = 8;
+constexpr int SHORT_BITS = 16;
+
+uint16_t ReadU16(const uint8_t *data)
+{
+    return static_cast<uint16_t>((data[0] << BYTE_BITS) | data[1]);
+}
+
+uint32_t ReadU32(const uint8_t *data)
+{
+    return (static_cast<uint32_t>(ReadU16(data)) << SHORT_BITS) | ReadU16(data + sizeof(uint16_t));
+}
+
+void AppendU16(std::vector<uint8_t> &packet, uint16_t value)
+{
+    packet.push_back(static_cast<uint8_t>(value >> BYTE_BITS));
+    packet.push_back(static_cast<uint8_t>(value));
+}
+
+// Moves offset past the name at offset, a compression pointer ends the name
+bool SkipName(const uint8_t *packet, size_t len, size_t &offset)
+{
+    while (offset < len) {
+        uint8_t labelLen = packet[offset];
+        if ((labelLen & DNS_COMPRESSION_MASK) == DNS_COMPRESSION_MASK) {
+            offset += sizeof(uint16_t);
+            return offset <= len;
+        }
+        if (labelLen > MAX_DNS_LABEL_LEN) {
+            return false;
+        }
+        offset += labelLen + 1;
+        if (labelLen == 0) {
+            return offset <= len;
+        }
+    }
+    return false;
+}
+
+// Reads the name at offset in lower case and moves offset past it, compression pointers have to point backwards
+bool ReadName(const uint8_t *packet, size_t len, size_t &offset, std::string &name)
+{
+    name.clear();
+    size_t pos = offset;
+    if (!SkipName(packet, len, offset)) {
+        return false;
+    }
+    while (pos < len) {
+        uint8_t labelLen = packet[pos];
+        if ((labelLen & DNS_COMPRESSION_MASK) == DNS_COMPRESSION_MASK) {
+            if (pos + 1 >= len) {
+                return false;
+            }
+            size_t target = ((labelLen & ~DNS_COMPRESSION_MASK) << BYTE_BITS) | packet[pos + 1];
+            if (target >= pos) {
+                return false;
+            }
+            pos = target;
+            continue;
+        }
+        if (labelLen > MAX_DNS_LABEL_LEN || pos + 1 + labelLen > len) {
+            return false;
+        }
+        if (labelLen == 0) {
+            return true;
+        }
+        if (!name.empty()) {
+            name += '.';
+        }
+        for (size_t i = pos + 1; i <= pos + labelLen; ++i) {
+            name += static_cast<char>(tolower(packet[i]));
+        }
+        if (name.size() > MAX_DNS_NAME_LEN) {
+            return false;
+        }
+        pos += labelLen + 1;
+    }
+    return false;
+}
+
+// Names compare case-insensitively and without the root label
+std::string NormalizeName(const std::string &hostName)
+{
+    std::string name = hostName;
+    if (!name.empty() && name.back() == '.') {
+        name.pop_back();
+    }
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return tolower(c); });
+    return name;
+}
+
+// The client side keeps both a stream and a datagram entry for every address, like getaddrinfo without hints
+void AppendAddress(int32_t family, const uint8_t *addr, uint32_t ttl, std::vector<AddrInfoWithTtl> &records)
+{
+    AddrInfoWithTtl record = {};
+    record.ttl = ttl;
+    record.addrInfo.aiFamily = static_cast<uint32_t>(family);
+    if (family == AF_INET) {
+        record.addrInfo.aiAddrLen = sizeof(sockaddr_in);
+        record.addrInfo.aiAddr.sin.sin_family = AF_INET;
+        memcpy_s(&record.addrInfo.aiAddr.sin.sin_addr, sizeof(in_addr), addr, IPV4_ADDR_LEN);
+    } else {
+        record.addrInfo.aiAddrLen = sizeof(sockaddr_in6);
+        record.addrInfo.aiAddr.sin6.sin6_family = AF_INET6;
+        memcpy_s(&record.addrInfo.aiAddr.sin6.sin6_addr, sizeof(in6_addr), addr, IPV6_ADDR_LEN);
+    }
+    record.addrInfo.aiSockType = SOCK_STREAM;
+    record.addrInfo.aiProtocol = IPPROTO_TCP;
+    records.push_back(record);
+    record.addrInfo.aiSockType = SOCK_DGRAM;
+    record.addrInfo.aiProtocol = IPPROTO_UDP;
+    records.push_back(record);
+}
+
+bool ParseServerAddr(const std::string &server, uint16_t port, AlignedSockAddr &addr, socklen_t &addrLen)
+{
+    addr = {};
+    if (inet_pton(AF_INET, server.c_str(), &addr.sin.sin_addr) == 1) {
+        addr.sin.sin_family = AF_INET;
+        addr.sin.sin_port = htons(port);
+        addrLen = sizeof(sockaddr_in);
+        return true;
+    }
+    if (inet_pton(AF_INET6, server.c_str(), &addr.sin6.sin6_addr) == 1) {
+        addr.sin6.sin6_family = AF_INET6;
+        addr.sin6.sin6_port = htons(port);
+        addrLen = sizeof(sockaddr_in6);
+        return true;
+    }
+    return false;
+}
+
+uint16_t NewQueryId()
+{
+    thread_local std::mt19937 engine(std::random_device {}());
+    return static_cast<uint16_t>(engine());
+}
+} // namespace
+
+DnsCacheRefresher::DnsCacheRefresher(uint16_t serverPort) : serverPort_(serverPort) {}
+
+bool DnsCacheRefresher::BuildQuery(const std::string &hostName, uint16_t queryId, uint16_t queryType,
+                                   std::vector<uint8_t> &packet)
+{
+    std::string name = hostName;
+    if (!name.empty() && name.back() == '.') {
+        name.pop_back();
+    }
+    if (name.empty() || name.size() > MAX_DNS_NAME_LEN) {
+        return false;
+    }
+    packet.clear();
+    AppendU16(packet, queryId);
+    AppendU16(packet, DNS_FLAG_RD);
+    AppendU16(packet, 1);
+    AppendU16(packet, 0);
+    AppendU16(packet, 0);
+    AppendU16(packet, 0);
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t end = name.find('.', start);
+        end = end == std::string::npos ? name.size() : end;
+        size_t labelLen = end - start;
+        if (labelLen == 0 || labelLen > MAX_DNS_LABEL_LEN) {
+            return false;
+        }
+        packet.push_back(static_cast<uint8_t>(labelLen));
+        packet.insert(packet.end(), name.begin() + start, name.begin() + end);
+        start = end + 1;
+    }
+    packet.push_back(0);
+    AppendU16(packet, queryType);
+    AppendU16(packet, DNS_CLASS_IN);
+    return true;
+}
+
+bool DnsCacheRefresher::ParseAnswer(const uint8_t *packet, size_t len, uint16_t queryId,
+                                    const std::string &hostName, uint16_t queryType,
+                                    std::vector<AddrInfoWithTtl> &records)
+{
+    if (packet == nullptr || len < DNS_HEADER_LEN || ReadU16(packet) != queryId) {
+        return false;
+    }
+    uint16_t flags = ReadU16(packet + sizeof(uint16_t));
+    if ((flags & DNS_FLAG_QR) == 0 || (flags & DNS_FLAG_TC) != 0 || (flags & DNS_RCODE_MASK) != 0) {
+        return false;
+    }
+    uint16_t questionCount = ReadU16(packet + 4);
+    uint16_t answerCount = ReadU16(packet + 6);
+    size_t offset = DNS_HEADER_LEN;
+    // A forged or misrouted answer with the right id still has to echo the question that was asked
+    std::string name;
+    if (questionCount != 1 || !ReadName(packet, len, offset, name) || offset + DNS_QUESTION_FIXED_LEN > len) {
+        return false;
+    }
+    std::string owner = NormalizeName(hostName);
+    if (name != owner || ReadU16(packet + offset) != queryType ||
+        ReadU16(packet + offset + sizeof(uint16_t)) != DNS_CLASS_IN) {
+        return false;
+    }
+    offset += DNS_QUESTION_FIXED_LEN;
+    std::vector<AddrInfoWithTtl> answers;
+    for (uint16_t i = 0; i < answerCount; ++i) {
+        if (!ReadName(packet, len, offset, name) || offset + DNS_RR_FIXED_LEN > len) {
+            return false;
+        }
+        uint16_t type = ReadU16(packet + offset);
+        uint16_t rrClass = ReadU16(packet + offset + 2);
+        uint32_t ttl = ReadU32(packet + offset + 4);
+        uint16_t dataLen = ReadU16(packet + offset + 8);
+        offset += DNS_RR_FIXED_LEN;
+        if (offset + dataLen > len) {
+            return false;
+        }
+        size_t dataOffset = offset;
+        offset += dataLen;
+        // Records for names off the CNAME chain would poison the cache entry of hostName
+        if (rrClass != DNS_CLASS_IN || name != owner) {
+            continue;
+        }
+        if (type == DNS_TYPE_CNAME) {
+            if (!ReadName(packet, offset, dataOffset, owner) || dataOffset != offset) {
+                return false;
+            }
+        } else if (type == queryType && type == DNS_TYPE_A && dataLen == IPV4_ADDR_LEN) {
+            AppendAddress(AF_INET, packet + dataOffset, ttl, answers);
+        } else if (type == queryType && type == DNS_TYPE_AAAA && dataLen == IPV6_ADDR_LEN) {
+            AppendAddress(AF_INET6, packet + dataOffset, ttl, answers);
+        }
+    }
+    records.insert(records.end(), answers.begin(), answers.end());
+    return true;
+}
+
+int32_t DnsCacheRefresher::Resolve(uint16_t netId, const std::vector<std::string> &servers,
+                                   const std::string &hostName, bool isIpv6Enable, uint32_t timeoutMs,
+                                   std::vector<AddrInfoWithTtl> &records) const
+{
+    int32_t ret = -ENOENT;
+    for (const auto &server : servers) {
+        records.clear();
+        ret = QueryServer(netId, server, hostName, isIpv6Enable, timeoutMs, records);
+        if (ret == 0 && !records.empty()) {
+            return 0;
+        }
+    }
+    // An empty answer is a failed refresh too, the cache keeps what it has until the stale limit
+    return ret == 0 ? -ENODATA : ret;
+}
+
+int32_t DnsCacheRefresher::QueryServer(uint16_t netId, const std::string &server, const std::string &hostName,
+                                       bool isIpv6Enable, uint32_t timeoutMs,
+                                       std::vector<AddrInfoWithTtl> &records) const
+{
+    AlignedSockAddr serverAddr;
+    socklen_t serverAddrLen = 0;
+    if (!ParseServerAddr(server, serverPort_, serverAddr, serverAddrLen)) {
+        return -EINVAL;
+    }
+    std::vector<uint16_t> types = {DNS_TYPE_A};
+    if (isIpv6Enable) {
+        types.push_back(DNS_TYPE_AAAA);
+    }
+    // The id and type of every query still waiting for its answer
+    std::vector<std::pair<uint16_t, uint16_t>> pendingQueries;
+    std::vector<std::vector<uint8_t>> queries(types.size());
+    for (size_t i = 0; i < types.size(); ++i) {
+        uint16_t queryId = NewQueryId();
+        while (std::any_of(pendingQueries.begin(), pendingQueries.end(),
+                           [queryId](const auto &query) { return query.first == queryId; })) {
+            ++queryId;
+        }
+        pendingQueries.emplace_back(queryId, types[i]);
+        if (!BuildQuery(hostName, queryId, types[i], queries[i])) {
+            return -EINVAL;
+        }
+    }
+
+    int32_t sock = socket(serverAddr.sa.sa_family, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (sock < 0) {
+        NETNATIVE_LOGE("DnsCacheRefresher socket failed: %{public}d", errno);
+        return -errno;
+    }
+    Fwmark mark;
+    mark.netId = netId;
+    mark.explicitlySelected = true;
+    mark.protectedFromVpn = true;
+    mark.permission = NetworkPermission::PERMISSION_SYSTEM;
+    if (netId != 0 && setsockopt(sock, SOL_SOCKET, SO_MARK, &mark.intValue, sizeof(mark.intValue)) < 0) {
+        int32_t err = errno;
+        NETNATIVE_LOGE("DnsCacheRefresher set mark failed: %{public}d", err);
+        close(sock);
+        return -err;
+    }
+    // connect() makes the kernel drop datagrams from anyone but the server
+    if (connect(sock, &serverAddr.sa, serverAddrLen) < 0) {
+        int32_t err = errno;
+        close(sock);
+        return -err;
+    }
+    for (const auto &query : queries) {
+        if (send(sock, query.data(), query.size(), 0) < 0) {
+            int32_t err = errno;
+            close(sock);
+            return -err;
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    uint8_t answer[MAX_DNS_UDP_LEN];
+    while (!pendingQueries.empty()) {
+        auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+            std::chrono::steady_clock::now()).count();
+        pollfd fds = {sock, POLLIN, 0};
+        if (remain <= 0 || poll(&fds, 1, static_cast<int>(remain)) <= 0) {
+            break;
+        }
+        ssize_t len = recv(sock, answer, sizeof(answer), 0);
+        if (len < 0 && errno != EINTR) {
+            // Typically ECONNREFUSED, nothing listens on the server port
+            break;
+        }
+        if (len < static_cast<ssize_t>(DNS_HEADER_LEN)) {
+            continue;
+        }
+        uint16_t answerId = ReadU16(answer);
+        for (auto it = pendingQueries.begin(); it != pendingQueries.end(); ++it) {
+            // An answer that does not match the question is dropped and the query keeps waiting
+            if (it->first == answerId &&
+                ParseAnswer(answer, static_cast<size_t>(len), answerId, hostName, it->second, records)) {
+                pendingQueries.erase(it);
+                break;
+            }
+        }
+    }
+    close(sock);
+    // Keep a partial answer, the missing family is simply absent until the next refresh
+    return pendingQueries.size() < types.size() ? 0 : -ETIMEDOUT;
+}
+} // namespace OHOS::nmd
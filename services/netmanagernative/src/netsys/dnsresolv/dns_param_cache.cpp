@@ -16,6 +16,7 @@
 #include "netmanager_base_common_utils.h"
 #include "dns_param_cache.h"
 #include "netnative_log_wrapper.h"
+#include "parameters.h"
 
 #ifdef FEATURE_NET_FIREWALL_ENABLE
 #include "bpf_netfirewall.h"
@@ -34,9 +35,17 @@ void GetVectorData(const std::vector<std::string> &data, std::string &result)
 }
 constexpr int RES_TIMEOUT = 4000;    // min. milliseconds between retries
 constexpr int RES_DEFAULT_RETRY = 2; // Default
+// Seconds an expired record may still be answered, 0 turns serve-stale off
+const std::string DNS_SERVE_STALE_LIMIT = "persist.sys.netsysnative_dns_serve_stale_limit";
+const std::string DNS_PREFETCH_ENABLE = "persist.sys.netsysnative_dns_prefetch_enable";
 } // namespace
 
-DnsParamCache::DnsParamCache() : defaultNetId_(0) {}
+DnsParamCache::DnsParamCache() : defaultNetId_(0), refresher_(std::make_shared<DnsCacheRefresher>())
+{
+    refreshPolicy_.staleLimitSec = StrToUint(OHOS::system::GetParameter(DNS_SERVE_STALE_LIMIT, "0"));
+    refreshPolicy_.serveStale = refreshPolicy_.staleLimitSec > 0;
+    refreshPolicy_.prefetch = OHOS::system::GetBoolParameter(DNS_PREFETCH_ENABLE, false);
+}
 
 DnsParamCache &DnsParamCache::GetInstance()
 {
@@ -76,12 +85,14 @@ int32_t DnsParamCache::CreateCacheForNet(uint16_t netId, bool isVpnNet)
         return -EEXIST;
     }
     serverConfigMap_[netId].SetNetId(netId);
+    serverConfigMap_[netId].SetCacheRefreshPolicy(refreshPolicy_);
     if (isVpnNet) {
         NETNATIVE_LOGI("DnsParamCache::CreateCacheForNet clear all dns cache when vpn net create");
         for (auto iterator = serverConfigMap_.begin(); iterator != serverConfigMap_.end(); iterator++) {
             iterator->second.GetCache().Clear();
             iterator->second.ClearNodataCache();
             iterator->second.ClearIpv6UidBlackList();
+            iterator->second.ClearCacheState();
         }
     }
     return 0;
@@ -105,6 +116,7 @@ int32_t DnsParamCache::DestroyNetworkCache(uint16_t netId, bool isVpnNet)
             it->second.GetCache().Clear();
             it->second.ClearNodataCache();
             it->second.ClearIpv6UidBlackList();
+            it->second.ClearCacheState();
         }
     }
     return 0;
@@ -138,6 +150,7 @@ int32_t DnsParamCache::SetResolverConfig(uint16_t netId, uint16_t baseTimeoutMse
         it->second.GetCache().Clear();
         it->second.ClearNodataCache();
         it->second.ClearIpv6UidBlackList();
+        it->second.ClearCacheState();
     }
 
     it->second.SetNetId(netId);
@@ -391,6 +404,26 @@ std::vector<AddrInfo> DnsParamCache::GetDnsCache(uint16_t netId, const std::stri
     }
 
     auto infos = it->second.GetCache().Get(hostName);
+#ifdef FEATURE_NET_FIREWALL_ENABLE
+    // The cache is shared by all apps of the network, an app denied this name has to query and hit the
+    // kernel domain intercept instead of being answered here
+    if (!infos.empty() && GetFirewallRuleAction(callingUid_, hostName) == FirewallRuleAction::RULE_DENY) {
+        DNS_CONFIG_PRINT("GetDnsCache hit netfirewall deny rule");
+        return {};
+    }
+#endif
+    if (!infos.empty()) {
+        bool needRefresh = false;
+        DnsCacheState state = it->second.CheckCacheState(hostName, it->second.GetNowMs(), needRefresh);
+        if (state == DnsCacheState::MISS) {
+            it->second.GetCache().Delete(hostName);
+            return {};
+        }
+        if (needRefresh) {
+            ffrt::submit([this, netId, hostName]() { RefreshDnsCache(netId, hostName); }, {}, {},
+                ffrt::task_attr().name("DnsCacheRefresh"));
+        }
+    }
     std::vector<AddrInfo> addrInfo;
     for (auto info : infos) {
         addrInfo.push_back(info.addrInfo);
@@ -398,6 +431,53 @@ std::vector<AddrInfo> DnsParamCache::GetDnsCache(uint16_t netId, const std::stri
     return addrInfo;
 }
 
+void DnsParamCache::SetCacheRefreshPolicy(const DnsCacheRefreshPolicy &policy)
+{
+    NETNATIVE_LOGI("SetCacheRefreshPolicy serveStale:%{public}d limit:%{public}u prefetch:%{public}d",
+                   policy.serveStale, policy.staleLimitSec, policy.prefetch);
+    std::lock_guard<ffrt::mutex> guard(cacheMutex_);
+    refreshPolicy_ = policy;
+    for (auto &serverConfig : serverConfigMap_) {
+        serverConfig.second.SetCacheRefreshPolicy(policy);
+    }
+}
+
+void DnsParamCache::RefreshDnsCache(uint16_t netId, const std::string &hostName)
+{
+    std::vector<std::string> servers;
+    uint32_t timeoutMs = 0;
+    bool isIpv6Enable = false;
+    {
+        std::lock_guard<ffrt::mutex> guard(cacheMutex_);
+        auto it = serverConfigMap_.find(netId);
+        if (it == serverConfigMap_.end()) {
+            return;
+        }
+        servers = it->second.GetServers();
+        timeoutMs = it->second.GetTimeoutMsec() > 0 ? it->second.GetTimeoutMsec() : DEFAULT_TIMEOUT;
+        isIpv6Enable = it->second.IsIpv6Enable();
+    }
+    // Resolve without the lock, the clients keep being answered from the cache meanwhile
+    std::vector<AddrInfoWithTtl> records;
+    int32_t ret = refresher_->Resolve(netId, servers, hostName, isIpv6Enable, timeoutMs, records);
+
+    std::lock_guard<ffrt::mutex> guard(cacheMutex_);
+    auto it = serverConfigMap_.find(netId);
+    if (it == serverConfigMap_.end()) {
+        return;
+    }
+    // Drop the answer if the cache was flushed or moved to other servers while resolving
+    if (ret != 0 || it->second.GetServers() != servers || it->second.GetCache().Get(hostName).empty()) {
+        NETNATIVE_LOG_D("RefreshDnsCache netid:%{public}u not refreshed, ret:%{public}d", netId, ret);
+        it->second.FinishRefresh(hostName);
+        return;
+    }
+    for (auto &record : records) {
+        record.ttl = record.ttl > DEFAULT_DELAYED_COUNT ? record.ttl : DEFAULT_DELAYED_COUNT;
+    }
+    it->second.UpdateCache(hostName, records, it->second.GetNowMs());
+}
+
 void DnsParamCache::SetCacheDelayed(uint16_t netId, const std::string &hostName)
 {
     if (netId == 0) {
@@ -499,12 +579,29 @@ bool DnsParamCache::GetDnsServersByAppUid(int32_t appUid, std::vector<std::strin
 int32_t DnsParamCache::SetFirewallRules(NetFirewallRuleType type,
                                         const std::vector<sptr<NetFirewallBaseRule>> &ruleList, bool isFinish)
 {
-    std::lock_guard<ffrt::mutex> guard(cacheMutex_);
     NETNATIVE_LOGI("SetFirewallRules: size=%{public}zu isFinish=%{public}" PRId32, ruleList.size(), isFinish);
     if (ruleList.empty()) {
         NETNATIVE_LOGE("SetFirewallRules: rules is empty");
         return -1;
     }
+    if (type == NetFirewallRuleType::RULE_DOMAIN) {
+        std::vector<sptr<NetFirewallDomainRule>> domainRules;
+        {
+            std::lock_guard<ffrt::mutex> guard(cacheMutex_);
+            for (const auto &rule : ruleList) {
+                firewallDomainRules_.emplace_back(firewall_rule_cast<NetFirewallDomainRule>(rule));
+            }
+            ClearAllDnsCache();
+            if (!isFinish) {
+                return 0;
+            }
+            domainRules.swap(firewallDomainRules_);
+        }
+        // Compiling a large rule set must not hold up cache lookups, they keep the previous trie meanwhile
+        SetFirewallDomainRules(BuildDomainRuleTrie(domainRules));
+        return 0;
+    }
+    std::lock_guard<ffrt::mutex> guard(cacheMutex_);
     int32_t ret = 0;
     switch (type) {
         case NetFirewallRuleType::RULE_DNS: {
@@ -517,10 +614,6 @@ int32_t DnsParamCache::SetFirewallRules(NetFirewallRuleType type,
             }
             break;
         }
-        case NetFirewallRuleType::RULE_DOMAIN: {
-            ClearAllDnsCache();
-            break;
-        }
         default:
             break;
     }
@@ -544,20 +637,104 @@ int32_t DnsParamCache::SetFirewallDnsRules(const std::vector<sptr<NetFirewallDns
     return 0;
 }
 
-FirewallRuleAction DnsParamCache::GetFirewallRuleAction(int32_t appUid,
-                                                        const std::vector<sptr<NetFirewallDomainRule>> &rules)
+uint64_t DnsParamCache::MakeDomainRuleKey(int32_t userId, int32_t appUid)
 {
-    int32_t userId = GetUserId(appUid);
-    for (const auto &rule : rules) {
-        if (rule->userId != userId) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(userId)) << 32) | static_cast<uint32_t>(appUid);
+}
+
+bool DnsParamCache::GetKernelDomainName(const std::string &domain, std::string &name)
+{
+    name = domain;
+    name.erase(std::remove(name.begin(), name.end(), '*'), name.end());
+    // The key is built from the reversed name split at the dots, which drops only the label after a leading dot
+    if (!name.empty() && name.front() == '.') {
+        name.erase(0, 1);
+    }
+    // An empty label stays in the key as a zero length byte, no query name has one
+    return !name.empty() && name.front() != '.' && name.back() != '.' && name.find("..") == std::string::npos;
+}
+
+std::shared_ptr<const DnsParamCache::DomainRuleTrie> DnsParamCache::BuildDomainRuleTrie(
+    const std::vector<sptr<NetFirewallDomainRule>> &ruleList)
+{
+    auto trie = std::make_shared<DomainRuleTrie>();
+    for (const auto &rule : ruleList) {
+        if (rule == nullptr || (rule->ruleAction != FirewallRuleAction::RULE_ALLOW &&
+                                rule->ruleAction != FirewallRuleAction::RULE_DENY)) {
             continue;
         }
-        if ((rule->appUid && appUid == rule->appUid) || !rule->appUid) {
-            return rule->ruleAction;
+        uint64_t key = MakeDomainRuleKey(rule->userId, rule->appUid);
+        for (const auto &param : rule->domains) {
+            std::string name;
+            if (!GetKernelDomainName(param.domain, name)) {
+                continue;
+            }
+            // The kernel maps are LPM tries, a rule covers the name and every name below it
+            for (bool isWildcard : {false, true}) {
+                DomainRuleActions *actions = trie->Emplace(name, isWildcard);
+                if (actions == nullptr) {
+                    break;
+                }
+                DomainRuleMatch &match = (*actions)[key];
+                match.allow = match.allow || rule->ruleAction == FirewallRuleAction::RULE_ALLOW;
+                match.deny = match.deny || rule->ruleAction == FirewallRuleAction::RULE_DENY;
+            }
         }
     }
+    NETNATIVE_LOGI("BuildDomainRuleTrie: rules=%{public}zu domains=%{public}zu", ruleList.size(), trie->Size());
+    if (trie->Empty()) {
+        return nullptr;
+    }
+    return trie;
+}
+
+void DnsParamCache::SetFirewallDomainRules(std::shared_ptr<const DomainRuleTrie> trie)
+{
+    std::lock_guard<ffrt::mutex> guard(domainRuleMutex_);
+    domainRuleTrie_ = std::move(trie);
+}
+
+void DnsParamCache::SetFirewallDefaultAction(int32_t userId, FirewallRuleAction outDefault)
+{
+    {
+        std::lock_guard<ffrt::mutex> guard(domainRuleMutex_);
+        firewallOutDefault_[userId] = outDefault;
+    }
+    std::lock_guard<ffrt::mutex> guard(cacheMutex_);
+    ClearAllDnsCache();
+}
 
-    return FirewallRuleAction::RULE_INVALID;
+FirewallRuleAction DnsParamCache::GetFirewallRuleAction(int32_t appUid, const std::string &hostName)
+{
+    int32_t userId = GetUserId(appUid);
+    std::shared_ptr<const DomainRuleTrie> trie;
+    bool defaultAllow = true;
+    {
+        std::lock_guard<ffrt::mutex> guard(domainRuleMutex_);
+        trie = domainRuleTrie_;
+        auto it = firewallOutDefault_.find(userId);
+        defaultAllow = it == firewallOutDefault_.end() || it->second == FirewallRuleAction::RULE_ALLOW;
+    }
+    if (trie == nullptr) {
+        return FirewallRuleAction::RULE_INVALID;
+    }
+    uint64_t appKey = MakeDomainRuleKey(userId, appUid);
+    uint64_t userKey = MakeDomainRuleKey(userId, 0);
+    DomainRuleMatch matched;
+    trie->Match(hostName, [&matched, appKey, userKey](const DomainRuleActions &actions, bool) {
+        for (uint64_t key : {appKey, userKey}) {
+            auto it = actions.find(key);
+            if (it != actions.end()) {
+                matched.allow = matched.allow || it->second.allow;
+                matched.deny = matched.deny || it->second.deny;
+            }
+        }
+    });
+    // As parse_dns_query: with a deny default a deny rule wins, with an allow default an allow rule wins
+    if (matched.deny && (!defaultAllow || !matched.allow)) {
+        return FirewallRuleAction::RULE_DENY;
+    }
+    return (matched.allow || matched.deny) ? FirewallRuleAction::RULE_ALLOW : FirewallRuleAction::RULE_INVALID;
 }
 
 int32_t DnsParamCache::ClearFirewallRules(NetFirewallRuleType type)
@@ -569,12 +746,20 @@ int32_t DnsParamCache::ClearFirewallRules(NetFirewallRuleType type)
             netFirewallDnsRuleMap_.clear();
             break;
         case NetFirewallRuleType::RULE_DOMAIN: {
+            firewallDomainRules_.clear();
+            SetFirewallDomainRules(nullptr);
             OHOS::NetManagerStandard::NetsysBpfNetFirewall::GetInstance()->ClearDomainCache();
             break;
         }
         case NetFirewallRuleType::RULE_ALL: {
             firewallDnsRules_.clear();
             netFirewallDnsRuleMap_.clear();
+            firewallDomainRules_.clear();
+            SetFirewallDomainRules(nullptr);
+            {
+                std::lock_guard<ffrt::mutex> ruleGuard(domainRuleMutex_);
+                firewallOutDefault_.clear();
+            }
             OHOS::NetManagerStandard::NetsysBpfNetFirewall::GetInstance()->ClearDomainCache();
             break;
         }
@@ -599,6 +784,7 @@ void DnsParamCache::ClearAllDnsCache()
         it->second.GetCache().Clear();
         it->second.ClearNodataCache();
         it->second.ClearIpv6UidBlackList();
+        it->second.ClearCacheState();
     }
 }
 #endif
@@ -719,6 +905,7 @@ int32_t DnsParamCache::FlushDnsCache(uint16_t netId)
     it->second.GetCache().Clear();
     it->second.ClearNodataCache();
     it->second.ClearIpv6UidBlackList();
+    it->second.ClearCacheState();
     return 0;
 }
 
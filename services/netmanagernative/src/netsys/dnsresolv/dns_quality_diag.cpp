@@ -35,6 +35,7 @@ const char NEW_LINE_STR = '\n';
 const uint32_t TIME_DELAY = 500;
 constexpr const uint32_t DNS_ABNORMAL_REPORT_INTERVAL = 2;
 constexpr int32_t DNS_FAIL_REASON_FIREWALL = -1202;
+constexpr uint16_t DNS_QUERY_TYPE_AAAA = 28;
 
 DnsQualityDiag::DnsQualityDiag()
     : defaultNetId_(0),
@@ -261,8 +262,32 @@ int32_t DnsQualityDiag::ParseDnsQueryReportAddr(uint8_t size,
     return 0;
 }
 
+void DnsQualityDiag::AddServerQualityReport(uint32_t netId, const DnsProcessInfoExt &processInfo)
+{
+    if (processInfo.isFromCache) {
+        return;
+    }
+    // The resolver times the first answer only, and returns to the app once the other family is answered too
+    bool isIpv6First = processInfo.firstReturnType == DNS_QUERY_TYPE_AAAA;
+    const FamilyQueryInfoExt &first = isIpv6First ? processInfo.ipv6QueryInfo : processInfo.ipv4QueryInfo;
+    const FamilyQueryInfoExt &last = isIpv6First ? processInfo.ipv4QueryInfo : processInfo.ipv6QueryInfo;
+    AddFamilyQualityReport(netId, first, processInfo.firstQueryEndDuration);
+    AddFamilyQualityReport(netId, last, processInfo.firstQueryEndDuration + processInfo.firstQueryEnd2AppDuration);
+}
+
+void DnsQualityDiag::AddFamilyQualityReport(uint32_t netId, const FamilyQueryInfoExt &familyInfo, uint32_t latencyMs)
+{
+    size_t len = strnlen(familyInfo.serverAddr, sizeof(familyInfo.serverAddr));
+    if (len == 0) {
+        return;
+    }
+    serverQuality_.AddReport(netId, std::string(familyInfo.serverAddr, len), latencyMs, familyInfo.retCode);
+}
+
 int32_t DnsQualityDiag::ReportDnsQueryResult(PostDnsQueryParam queryParam, AddrInfo* addrinfo, uint8_t addrSize)
 {
+    // Aggregated before the report cap, the statistics see every query
+    AddServerQualityReport(queryParam.netId, queryParam.processInfo);
     std::shared_lock<std::shared_mutex> lock(dnsQueryReportMutex_);
     bool reportSizeReachLimit = (dnsQueryReport_.size() >= MAX_RESULT_SIZE);
     lock.unlock();
@@ -379,6 +404,16 @@ int32_t DnsQualityDiag::UnregisterResultListener(const sptr<INetDnsResultCallbac
     return 0;
 }
 
+int32_t DnsQualityDiag::GetServerQuality(uint32_t netId, const std::string &server, DnsServerQualityInfo &info)
+{
+    return serverQuality_.GetServerQuality(netId, server, info) ? 0 : -1;
+}
+
+void DnsQualityDiag::RemoveNetwork(uint32_t netId)
+{
+    serverQuality_.RemoveNetwork(netId);
+}
+
 int32_t DnsQualityDiag::SetLoopDelay(int32_t delay)
 {
     if (delay < 0) {
@@ -455,8 +490,8 @@ int32_t DnsQualityDiag::send_dns_report()
     }
 
     if (report_.size() > 0) {
-        std::list<NetsysNative::NetDnsResultReport> reportSend(report_);
-        report_.clear();
+        std::list<NetsysNative::NetDnsResultReport> reportSend;
+        reportSend.swap(report_);
         locker.unlock();
         for (auto cb: cbs) {
             cb->OnDnsResultReport(reportSend.size(), reportSend);
@@ -464,8 +499,9 @@ int32_t DnsQualityDiag::send_dns_report()
     }
 
     std::unique_lock<std::shared_mutex> lock(dnsQueryReportMutex_);
-    std::list<NetsysNative::NetDnsQueryResultReport> reportSend(dnsQueryReport_);
-    dnsQueryReport_.clear();
+    std::list<NetsysNative::NetDnsQueryResultReport> reportSend;
+    reportSend.swap(dnsQueryReport_);
+    lock.unlock();
 
     if (reportSend.size() > 0) {
         for (auto cb: cbs) {
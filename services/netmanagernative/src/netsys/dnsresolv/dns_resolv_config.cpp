@@ -15,29 +15,60 @@
 
 #include "dns_resolv_config.h"
 
+#include <algorithm>
+
 #include "netnative_log_wrapper.h"
 
 namespace OHOS::nmd {
-DnsResolvConfig::DelayedTaskWrapper::DelayedTaskWrapper(std::string hostName,
-                                                        NetManagerStandard::LRUCache<AddrInfoWithTtl> &cache)
-    : hostName_(std::move(hostName)), cache_(cache)
+namespace {
+// Halve the hit counter of a host at each new ttl
+constexpr uint32_t HIT_COUNT_DECAY = 2;
+
+uint32_t GetMinTtl(const std::vector<AddrInfoWithTtl> &infos)
+{
+    uint32_t minTtl = infos.empty() ? 0 : infos[0].ttl;
+    for (const auto &info : infos) {
+        minTtl = std::min(minTtl, info.ttl);
+    }
+    return minTtl;
+}
+} // namespace
+
+DnsResolvConfig::DelayedTaskWrapper::DelayedTaskWrapper(std::string hostName, DnsResolvConfig &config,
+                                                        uint32_t generation, uint32_t staleTime)
+    : hostName_(std::move(hostName)), config_(config), cache_(config.cache_), generation_(generation),
+      staleTime_(staleTime)
 {
 }
 
 void DnsResolvConfig::DelayedTaskWrapper::Execute() const
 {
+    if (!config_.IsCurrentFill(hostName_, generation_)) {
+        isSuperseded_ = true;
+        return;
+    }
+    if (staleTime_ > 0 && !isStaleWait_) {
+        isStaleWait_ = true;
+        return;
+    }
+
     std::vector<AddrInfoWithTtl> infos = cache_.Get(hostName_);
     cache_.Delete(hostName_);
     if (infos.size() == 0) {
         return;
     }
 
+    bool isKept = false;
     for (auto info : infos) {
         if (info.ttl > remainTime_) {
             info.ttl -= remainTime_;
             cache_.Put(hostName_, info);
+            isKept = true;
         }
     }
+    if (!isKept) {
+        config_.ForgetCacheState(hostName_);
+    }
 }
 
 uint64_t DnsResolvConfig::GetNowMs()
@@ -50,6 +81,15 @@ uint64_t DnsResolvConfig::GetNowMs()
 
 uint32_t DnsResolvConfig::DelayedTaskWrapper::GetUpdateTime()
 {
+    if (isSuperseded_) {
+        return 0;
+    }
+    if (isStaleWait_ && staleTime_ > 0) {
+        // remainTime_ still holds the ttl the records are aged by once the stale window is over
+        uint32_t staleTime = staleTime_;
+        staleTime_ = 0;
+        return staleTime;
+    }
     std::vector<AddrInfoWithTtl> infos = cache_.Get(hostName_);
     if (infos.size() == 0) {
         return 0;
@@ -164,7 +204,21 @@ NetManagerStandard::LRUCache<AddrInfoWithTtl> &DnsResolvConfig::GetCache()
 
 void DnsResolvConfig::SetCacheDelayed(const std::string &hostName)
 {
-    auto wrapper = std::make_shared<DelayedTaskWrapper>(hostName, cache_);
+    uint32_t ttl = GetMinTtl(cache_.Get(hostName));
+    if (ttl == 0) {
+        return;
+    }
+    ScheduleCacheExpiry(hostName, MarkCacheFilled(hostName, ttl, GetNowMs(), false));
+}
+
+void DnsResolvConfig::ScheduleCacheExpiry(const std::string &hostName, uint32_t generation)
+{
+    uint32_t staleTime = 0;
+    {
+        std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+        staleTime = refreshPolicy_.serveStale ? refreshPolicy_.staleLimitSec : 0;
+    }
+    auto wrapper = std::make_shared<DelayedTaskWrapper>(hostName, *this, generation, staleTime);
     uint32_t time = wrapper->GetUpdateTime();
     if (time == 0) {
         return;
@@ -172,6 +226,139 @@ void DnsResolvConfig::SetCacheDelayed(const std::string &hostName)
     delayedQueue_.Put(wrapper, time);
 }
 
+void DnsResolvConfig::SetCacheRefreshPolicy(const DnsCacheRefreshPolicy &policy)
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    refreshPolicy_ = policy;
+    refreshPolicy_.staleLimitSec = std::min(policy.staleLimitSec, MAX_DNS_STALE_LIMIT_SEC);
+    if (!refreshPolicy_.serveStale && !refreshPolicy_.prefetch) {
+        cacheState_.clear();
+    }
+}
+
+DnsCacheRefreshPolicy DnsResolvConfig::GetCacheRefreshPolicy()
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    return refreshPolicy_;
+}
+
+uint32_t DnsResolvConfig::MarkCacheFilled(const std::string &hostName, uint32_t ttl, uint64_t nowMs, bool isRefresh)
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    if (!refreshPolicy_.serveStale && !refreshPolicy_.prefetch) {
+        return 0;
+    }
+    if (cacheState_.find(hostName) == cacheState_.end() && cacheState_.size() >= MAX_CACHE_STATE_SIZE) {
+        PruneCacheState(nowMs);
+    }
+    CacheEntryState &state = cacheState_[hostName];
+    if (state.expireMs <= nowMs) {
+        // Popularity carries over to the next ttl, but fades if the host is not asked for again
+        state.hitCount /= HIT_COUNT_DECAY;
+    }
+    state.filledMs = nowMs;
+    state.expireMs = nowMs + static_cast<uint64_t>(ttl) * MILLIS_PER_SEC;
+    state.isRefreshing = false;
+    if (isRefresh) {
+        // The old records are gone, so are the expiry tasks scheduled for them
+        ++state.generation;
+    }
+    return state.generation;
+}
+
+DnsCacheState DnsResolvConfig::CheckCacheState(const std::string &hostName, uint64_t nowMs, bool &needRefresh)
+{
+    needRefresh = false;
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    auto it = cacheState_.find(hostName);
+    // Records filled while both are off expire through the delayed queue only, as before
+    if (it == cacheState_.end() || (!refreshPolicy_.serveStale && !refreshPolicy_.prefetch)) {
+        return DnsCacheState::FRESH;
+    }
+    CacheEntryState &state = it->second;
+    if (nowMs < state.expireMs) {
+        ++state.hitCount;
+        if (refreshPolicy_.prefetch && !state.isRefreshing && state.hitCount >= DNS_PREFETCH_MIN_HITS) {
+            uint64_t window = std::max((state.expireMs - state.filledMs) / DNS_PREFETCH_WINDOW_DIVISOR,
+                                       DNS_PREFETCH_MIN_WINDOW_MS);
+            if (state.expireMs - nowMs <= window) {
+                state.isRefreshing = true;
+                needRefresh = true;
+            }
+        }
+        return DnsCacheState::FRESH;
+    }
+    uint64_t staleLimitMs = refreshPolicy_.serveStale ? refreshPolicy_.staleLimitSec * MILLIS_PER_SEC : 0;
+    if (nowMs >= state.expireMs + staleLimitMs) {
+        cacheState_.erase(it);
+        return DnsCacheState::MISS;
+    }
+    ++state.hitCount;
+    if (!state.isRefreshing) {
+        state.isRefreshing = true;
+        needRefresh = true;
+    }
+    return DnsCacheState::STALE;
+}
+
+void DnsResolvConfig::UpdateCache(const std::string &hostName, const std::vector<AddrInfoWithTtl> &infos,
+                                  uint64_t nowMs)
+{
+    uint32_t ttl = GetMinTtl(infos);
+    if (ttl == 0) {
+        FinishRefresh(hostName);
+        return;
+    }
+    cache_.Delete(hostName);
+    for (const auto &info : infos) {
+        cache_.Put(hostName, info);
+    }
+    ScheduleCacheExpiry(hostName, MarkCacheFilled(hostName, ttl, nowMs, true));
+}
+
+void DnsResolvConfig::FinishRefresh(const std::string &hostName)
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    auto it = cacheState_.find(hostName);
+    if (it != cacheState_.end()) {
+        it->second.isRefreshing = false;
+    }
+}
+
+bool DnsResolvConfig::IsCurrentFill(const std::string &hostName, uint32_t generation)
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    auto it = cacheState_.find(hostName);
+    return it == cacheState_.end() || it->second.generation == generation;
+}
+
+void DnsResolvConfig::ForgetCacheState(const std::string &hostName)
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    cacheState_.erase(hostName);
+}
+
+void DnsResolvConfig::ClearCacheState()
+{
+    std::lock_guard<ffrt::mutex> guard(cacheStateMutex_);
+    cacheState_.clear();
+}
+
+void DnsResolvConfig::PruneCacheState(uint64_t nowMs)
+{
+    uint64_t staleLimitMs = refreshPolicy_.serveStale ? refreshPolicy_.staleLimitSec * MILLIS_PER_SEC : 0;
+    for (auto it = cacheState_.begin(); it != cacheState_.end();) {
+        it = nowMs >= it->second.expireMs + staleLimitMs ? cacheState_.erase(it) : std::next(it);
+    }
+    if (cacheState_.size() < MAX_CACHE_STATE_SIZE) {
+        return;
+    }
+    auto oldest = std::min_element(cacheState_.begin(), cacheState_.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.second.filledMs < rhs.second.filledMs;
+    });
+    cacheState_.erase(oldest);
+}
+
 void DnsResolvConfig::SetUserDefinedServerFlag(bool flag)
 {
     isUserDefinedDnsServer_ = flag;
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dns_server_quality.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace OHOS::nmd {
+namespace {
+// gamma = (1 + a) / (1 - a), bucket i > 0 covers (gamma^(i - 2), gamma^(i - 1)] milliseconds
+const double SKETCH_GAMMA = (1 + DnsLatencySketch::RELATIVE_ACCURACY) / (1 - DnsLatencySketch::RELATIVE_ACCURACY);
+const double SKETCH_LOG_GAMMA = std::log(SKETCH_GAMMA);
+constexpr double EWMA_WEIGHT = 0.1;
+// A server answering in this time scores half of one answering at once
+constexpr double HEALTH_LATENCY_REF_MS = 100.0;
+
+size_t LatencyToBucket(uint32_t latencyMs)
+{
+    if (latencyMs == 0) {
+        return 0;
+    }
+    double index = std::ceil(std::log(static_cast<double>(std::min(latencyMs, DNS_LATENCY_MAX_MS))) /
+        SKETCH_LOG_GAMMA);
+    return std::min(static_cast<size_t>(index) + 1, DnsLatencySketch::BUCKET_NUM - 1);
+}
+
+uint32_t BucketToLatency(size_t bucket)
+{
+    if (bucket == 0) {
+        return 0;
+    }
+    // The point with the same relative distance to both bucket boundaries
+    double latency = 2 * std::pow(SKETCH_GAMMA, static_cast<double>(bucket - 1)) / (SKETCH_GAMMA + 1);
+    return static_cast<uint32_t>(std::lround(latency));
+}
+} // namespace
+
+void DnsLatencySketch::Add(uint32_t latencyMs)
+{
+    ++buckets_[LatencyToBucket(latencyMs)];
+    ++count_;
+}
+
+uint32_t DnsLatencySketch::GetQuantile(double quantile) const
+{
+    if (count_ == 0) {
+        return 0;
+    }
+    quantile = std::clamp(quantile, 0.0, 1.0);
+    auto rank = static_cast<uint64_t>(quantile * static_cast<double>(count_ - 1));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_NUM; ++i) {
+        seen += buckets_[i];
+        if (seen > rank) {
+            return BucketToLatency(i);
+        }
+    }
+    return BucketToLatency(BUCKET_NUM - 1);
+}
+
+uint64_t DnsLatencySketch::GetCount() const
+{
+    return count_;
+}
+
+void DnsLatencySketch::Clear()
+{
+    buckets_.fill(0);
+    count_ = 0;
+}
+
+DnsServerQuality::ServerStats &DnsServerQuality::GetServerStats(uint32_t netId, const std::string &server)
+{
+    auto key = std::make_pair(netId, server);
+    auto iter = servers_.find(key);
+    if (iter != servers_.end()) {
+        return iter->second;
+    }
+    if (servers_.size() >= MAX_SERVER_NUM) {
+        // Make room by forgetting the server that reported longest ago
+        auto oldest = std::min_element(servers_.begin(), servers_.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.second.lastUpdate < rhs.second.lastUpdate;
+        });
+        servers_.erase(oldest);
+    }
+    return servers_[key];
+}
+
+void DnsServerQuality::AddReport(uint32_t netId, const std::string &server, uint32_t latencyMs, int32_t retCode)
+{
+    if (server.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ServerStats &stats = GetServerStats(netId, server);
+    DnsServerQualityInfo &info = stats.info;
+    bool isSuccess = retCode == 0;
+    size_t rcodeIndex = retCode >= 0 && static_cast<size_t>(retCode) < DNS_RCODE_COUNTER_NUM - 1 ?
+        static_cast<size_t>(retCode) : DNS_RCODE_COUNTER_NUM - 1;
+    ++info.rcodeCount[rcodeIndex];
+    if (!isSuccess) {
+        ++info.failCount;
+    }
+    double success = isSuccess ? 1.0 : 0.0;
+    if (info.queryCount == 0) {
+        info.ewmaSuccessRate = success;
+    } else {
+        info.ewmaSuccessRate += EWMA_WEIGHT * (success - info.ewmaSuccessRate);
+    }
+    ++info.queryCount;
+    // A failed query says nothing about how fast the server answers, only how often
+    if (isSuccess) {
+        if (stats.latency.GetCount() == 0) {
+            info.ewmaLatencyMs = latencyMs;
+        } else {
+            info.ewmaLatencyMs += EWMA_WEIGHT * (static_cast<double>(latencyMs) - info.ewmaLatencyMs);
+        }
+        stats.latency.Add(latencyMs);
+    }
+    stats.lastUpdate = ++updateSeq_;
+}
+
+bool DnsServerQuality::GetServerQuality(uint32_t netId, const std::string &server,
+                                        DnsServerQualityInfo &info) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = servers_.find(std::make_pair(netId, server));
+    if (iter == servers_.end()) {
+        return false;
+    }
+    const ServerStats &stats = iter->second;
+    info = stats.info;
+    info.latencyP50Ms = stats.latency.GetQuantile(0.5);
+    info.latencyP90Ms = stats.latency.GetQuantile(0.9);
+    info.latencyP99Ms = stats.latency.GetQuantile(0.99);
+    info.healthScore = info.ewmaSuccessRate * HEALTH_LATENCY_REF_MS / (HEALTH_LATENCY_REF_MS + info.ewmaLatencyMs);
+    return true;
+}
+
+void DnsServerQuality::RemoveNetwork(uint32_t netId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto iter = servers_.begin(); iter != servers_.end();) {
+        iter = iter->first.first == netId ? servers_.erase(iter) : std::next(iter);
+    }
+}
+
+void DnsServerQuality::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    servers_.clear();
+    updateSeq_ = 0;
+}
+} // namespace OHOS::nmd
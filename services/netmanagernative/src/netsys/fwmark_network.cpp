@@ -31,6 +31,7 @@
 #include "selinux/selinux.h"
 #endif
 #include "fwmark_epoller.h"
+#include "process_mark_map.h"
 #include "securec.h"
 
 namespace OHOS {
@@ -132,6 +133,30 @@ int32_t SetMark(int32_t *socketFd, FwmarkCommand *command)
     return ret;
 }
 
+bool IsProcessCommand(const FwmarkCommand &command)
+{
+    return command.cmdId == FwmarkCommand::SELECT_PROCESS_NETWORK ||
+           command.cmdId == FwmarkCommand::PROTECT_PROCESS_FROM_VPN;
+}
+
+// A process command carries no socket, it marks the sockets its sender creates from now on
+void RunProcessCommand(int32_t clientSockfd, const FwmarkCommand &command)
+{
+    ucred cred = {};
+    socklen_t credLen = sizeof(cred);
+    int32_t ret = getsockopt(clientSockfd, SOL_SOCKET, SO_PEERCRED, &cred, &credLen);
+    if (ret != 0) {
+        CloseSocket(&clientSockfd, ret, ERROR_CODE_GETSOCKOPT_FAILED);
+        return;
+    }
+    int32_t result = ProcessMarkMap::GetInstance().Apply(cred.pid, cred.uid, command);
+    if ((ret = write(clientSockfd, &result, sizeof(result))) < 0) {
+        CloseSocket(&clientSockfd, ret, ERROR_CODE_WRITE_FAILED);
+        return;
+    }
+    CloseSocket(&clientSockfd, ret, NO_ERROR_CODE);
+}
+
 void RunForClientFd(int32_t clientSockfd)
 {
     FwmarkCommand fwmCmd{};
@@ -160,6 +185,13 @@ void RunForClientFd(int32_t clientSockfd)
             return;
         }
     }
+    if (IsProcessCommand(fwmCmd)) {
+        if (socketFd >= 0) {
+            close(socketFd);
+        }
+        RunProcessCommand(clientSockfd, fwmCmd);
+        return;
+    }
     if (socketFd < 0) {
         CloseSocket(&clientSockfd, ret, ERROR_CODE_SOCKETFD_INVALID);
         return;
@@ -199,6 +231,8 @@ void StartListener()
 
 FwmarkNetwork::FwmarkNetwork()
 {
+    // Drops the process marks a previous netsys left pinned before any process registers again
+    ProcessMarkMap::GetInstance();
     ListenerClient();
 }
 
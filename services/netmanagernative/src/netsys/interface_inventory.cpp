@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "interface_inventory.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <linux/if_addr.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "netlink_msg.h"
+#include "netlink_socket.h"
+#include "netnative_log_wrapper.h"
+#include "rtnetlink_link.h"
+
+namespace OHOS {
+namespace nmd {
+namespace {
+constexpr int32_t RECV_TIMEOUT_SEC = 3;
+constexpr uint32_t DUMP_ATTEMPTS = 3;
+
+template <typename Func> void ForEachAttr(const rtattr *attr, int32_t len, Func func)
+{
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        func(attr);
+    }
+}
+
+std::string AttrToStr(const rtattr *attr)
+{
+    auto data = reinterpret_cast<const char *>(RTA_DATA(attr));
+    return std::string(data, strnlen(data, RTA_PAYLOAD(attr)));
+}
+
+NetlinkMsg MakeLinkRequest(uint16_t flags, int32_t ifIndex)
+{
+    NetlinkMsg msg(flags, NETLINK_MAX_LEN, 0);
+    ifinfomsg info = {.ifi_family = AF_UNSPEC, .ifi_index = ifIndex};
+    msg.AddLink(RTM_GETLINK, info);
+    return msg;
+}
+
+NetlinkMsg MakeAddressDump()
+{
+    NetlinkMsg msg(NLM_F_DUMP, NETLINK_MAX_LEN, 0);
+    msg.AddAddress(RTM_GETADDR, ifaddrmsg {});
+    return msg;
+}
+} // namespace
+
+InterfaceInventory &InterfaceInventory::GetInstance()
+{
+    static InterfaceInventory instance;
+    return instance;
+}
+
+int32_t InterfaceInventory::OpenSocket()
+{
+    int32_t sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (sock < 0) {
+        NETNATIVE_LOGE("InterfaceInventory: socket failed, errno: %{public}d", errno);
+        return -errno;
+    }
+    timeval timeout = {.tv_sec = RECV_TIMEOUT_SEC};
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return sock;
+}
+
+int32_t InterfaceInventory::Start()
+{
+    int32_t sock = OpenSocket();
+    if (sock < 0) {
+        return sock;
+    }
+
+    // Held through the dump, so that the events of changes the dump misses wait for the table
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto table = std::make_shared<Table>();
+    uint32_t seq = 0;
+    int32_t ret = -EAGAIN;
+    // A dump the kernel flags as interrupted by a change may be inconsistent, it is done again
+    for (uint32_t attempt = 0; attempt < DUMP_ATTEMPTS && ret == -EAGAIN; attempt++) {
+        table->clear();
+        // Two dumps on one socket are sent one after the other, the kernel runs a single dump at a time
+        ret = Query(sock, seq, MakeLinkRequest(NLM_F_DUMP, 0), *table);
+        if (ret == 0) {
+            ret = Query(sock, seq, MakeAddressDump(), *table);
+        }
+    }
+    close(sock);
+    if (ret != 0) {
+        NETNATIVE_LOGE("InterfaceInventory: dump failed: %{public}d", ret);
+        std::atomic_store(&table_, std::shared_ptr<const Table>());
+        return ret;
+    }
+    NETNATIVE_LOGI("InterfaceInventory: started with %{public}zu links", table->size());
+    std::atomic_store(&table_, std::shared_ptr<const Table>(std::move(table)));
+    return 0;
+}
+
+void InterfaceInventory::Stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::atomic_store(&table_, std::shared_ptr<const Table>());
+}
+
+int32_t InterfaceInventory::Refresh(const std::string &ifName)
+{
+    if (GetSnapshot() == nullptr) {
+        return 0;
+    }
+    auto ifIndex = static_cast<int32_t>(if_nametoindex(ifName.c_str()));
+    int32_t sock = OpenSocket();
+    if (sock < 0) {
+        return sock;
+    }
+    // Held through the queries like in Start, the events that follow apply on top of what they return
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto current = std::atomic_load(&table_);
+    if (current == nullptr) {
+        close(sock);
+        return 0;
+    }
+    Table link;
+    uint32_t seq = 0;
+    int32_t ret = (ifIndex == 0) ? -ENODEV : -EAGAIN;
+    for (uint32_t attempt = 0; attempt < DUMP_ATTEMPTS && ret == -EAGAIN; attempt++) {
+        link.clear();
+        std::vector<NetlinkMsg> msgs;
+        msgs.push_back(MakeLinkRequest(0, ifIndex));
+        // The addresses of the other links find no entry in link and are skipped
+        msgs.push_back(MakeAddressDump());
+        ret = Query(sock, seq, msgs, link);
+    }
+    close(sock);
+    if (ret != 0 && ret != -ENODEV) {
+        NETNATIVE_LOGE("InterfaceInventory: refresh %{public}s failed: %{public}d", ifName.c_str(), ret);
+        return ret;
+    }
+    auto table = std::make_shared<Table>(*current);
+    // The name may have moved to another index when the link was recreated
+    for (auto it = table->begin(); it != table->end();) {
+        it = (it->second.name == ifName) ? table->erase(it) : std::next(it);
+    }
+    if (ret == 0) {
+        table->erase(ifIndex);
+        table->insert(link.begin(), link.end());
+    }
+    std::atomic_store(&table_, std::shared_ptr<const Table>(std::move(table)));
+    return 0;
+}
+
+void InterfaceInventory::Update(const char *buffer, int32_t size)
+{
+    if (buffer == nullptr || size <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto current = std::atomic_load(&table_);
+    if (current == nullptr) {
+        return;
+    }
+    std::shared_ptr<Table> table;
+    auto hdr = reinterpret_cast<const nlmsghdr *>(buffer);
+    for (int32_t left = size; NLMSG_OK(hdr, left); hdr = NLMSG_NEXT(hdr, left)) {
+        uint16_t type = hdr->nlmsg_type;
+        if (type != RTM_NEWLINK && type != RTM_DELLINK && type != RTM_NEWADDR && type != RTM_DELADDR) {
+            continue;
+        }
+        if (table == nullptr) {
+            table = std::make_shared<Table>(*current);
+        }
+        Apply(hdr, *table);
+    }
+    if (table != nullptr) {
+        std::atomic_store(&table_, std::shared_ptr<const Table>(std::move(table)));
+    }
+}
+
+std::shared_ptr<const InterfaceInventory::Table> InterfaceInventory::GetSnapshot() const
+{
+    return std::atomic_load(&table_);
+}
+
+const InventoryInterface *InterfaceInventory::Find(const Table &table, const std::string &ifName)
+{
+    for (const auto &[index, iface] : table) {
+        if (iface.name == ifName) {
+            return &iface;
+        }
+    }
+    return nullptr;
+}
+
+const InventoryAddress *InterfaceInventory::GetPrimaryIpv4Addr(const InventoryInterface &iface)
+{
+    for (const auto &addr : iface.ipv4Addrs) {
+        if ((addr.flags & IFA_F_SECONDARY) == 0 && (addr.label.empty() || addr.label == iface.name)) {
+            return &addr;
+        }
+    }
+    return nullptr;
+}
+
+int32_t InterfaceInventory::Query(int32_t sock, uint32_t &seq, NetlinkMsg msg, Table &table)
+{
+    std::vector<NetlinkMsg> msgs;
+    msgs.push_back(std::move(msg));
+    return Query(sock, seq, msgs, table);
+}
+
+// Applies the replies to the requests, -EAGAIN if the kernel flagged a dump as interrupted by a change
+int32_t InterfaceInventory::Query(int32_t sock, uint32_t &seq, std::vector<NetlinkMsg> &msgs, Table &table)
+{
+    bool interrupted = false;
+    std::vector<int32_t> errors;
+    int32_t ret = SendNetlinkMsgsAndWaitAcks(sock, seq, msgs, errors, [&interrupted, &table](const nlmsghdr *reply) {
+        interrupted = interrupted || (reply->nlmsg_flags & NLM_F_DUMP_INTR) != 0;
+        Apply(reply, table);
+    });
+    if (ret != 0) {
+        return ret;
+    }
+    for (int32_t error : errors) {
+        if (error != 0) {
+            return error;
+        }
+    }
+    return interrupted ? -EAGAIN : 0;
+}
+
+void InterfaceInventory::Apply(const nlmsghdr *hdr, Table &table)
+{
+    switch (hdr->nlmsg_type) {
+        case RTM_NEWLINK:
+        case RTM_DELLINK:
+            ApplyLink(hdr, table);
+            break;
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+            ApplyAddress(hdr, table);
+            break;
+        default:
+            break;
+    }
+}
+
+void InterfaceInventory::ApplyLink(const nlmsghdr *hdr, Table &table)
+{
+    RtnetlinkLink link;
+    // Bridge port events are AF_BRIDGE, the RTM_DELLINK of a port leaving its bridge leaves the link alone
+    if (!ParseRtnetlinkLink(hdr, link) || link.family != AF_UNSPEC) {
+        return;
+    }
+    if (hdr->nlmsg_type == RTM_DELLINK) {
+        table.erase(link.index);
+        return;
+    }
+    InventoryInterface &iface = table[link.index];
+    iface.index = link.index;
+    iface.flags = link.flags;
+    iface.name = link.name;
+    iface.mtu = link.mtu;
+    iface.hwAddr = HwAddrToString(link.hwAddr);
+}
+
+void InterfaceInventory::ApplyAddress(const nlmsghdr *hdr, Table &table)
+{
+    auto ifa = reinterpret_cast<const ifaddrmsg *>(NLMSG_DATA(hdr));
+    if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*ifa)) || (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)) {
+        return;
+    }
+    auto it = table.find(static_cast<int32_t>(ifa->ifa_index));
+    if (it == table.end()) {
+        return;
+    }
+    InventoryAddress addr = {.prefixLen = ifa->ifa_prefixlen, .flags = ifa->ifa_flags};
+    const rtattr *local = nullptr;
+    const rtattr *address = nullptr;
+    ForEachAttr(IFA_RTA(ifa), static_cast<int32_t>(IFA_PAYLOAD(hdr)), [&](const rtattr *attr) {
+        switch (attr->rta_type) {
+            case IFA_LOCAL:
+                local = attr;
+                break;
+            case IFA_ADDRESS:
+                address = attr;
+                break;
+            case IFA_LABEL:
+                addr.label = AttrToStr(attr);
+                break;
+            case IFA_FLAGS:
+                if (RTA_PAYLOAD(attr) >= sizeof(uint32_t)) {
+                    addr.flags = *reinterpret_cast<const uint32_t *>(RTA_DATA(attr));
+                }
+                break;
+            default:
+                break;
+        }
+    });
+    // On a point-to-point link IFA_ADDRESS is the peer, the own address is IFA_LOCAL
+    const rtattr *own = (local != nullptr) ? local : address;
+    size_t addrLen = (ifa->ifa_family == AF_INET) ? sizeof(in_addr) : sizeof(in6_addr);
+    char str[INET6_ADDRSTRLEN] = {0};
+    if (own == nullptr || RTA_PAYLOAD(own) < addrLen ||
+        inet_ntop(ifa->ifa_family, RTA_DATA(own), str, sizeof(str)) == nullptr) {
+        return;
+    }
+    addr.addr = str;
+
+    auto &addrs = (ifa->ifa_family == AF_INET) ? it->second.ipv4Addrs : it->second.ipv6Addrs;
+    auto found = std::find_if(addrs.begin(), addrs.end(), [&addr](const InventoryAddress &known) {
+        return known.addr == addr.addr && known.prefixLen == addr.prefixLen;
+    });
+    // The kernel announces an IPv6 address once duplicate address detection lets it be used, a dump shows it
+    // before already: until then it is left out
+    bool tentative = ifa->ifa_family == AF_INET6 && (addr.flags & IFA_F_TENTATIVE) != 0 &&
+        (addr.flags & IFA_F_OPTIMISTIC) == 0;
+    if (hdr->nlmsg_type == RTM_DELADDR || tentative) {
+        if (found != addrs.end()) {
+            addrs.erase(found);
+        }
+    } else if (found != addrs.end()) {
+        *found = addr;
+    } else {
+        addrs.push_back(addr);
+    }
+}
+} // namespace nmd
+} // namespace OHOS
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mptcp_pm_client.h"
+
+#include <cerrno>
+#include <linux/mptcp.h>
+#include <sys/time.h>
+
+#include "netlink_socket.h"
+#include "netnative_log_wrapper.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace nmd {
+namespace {
+constexpr uint8_t GENL_CTRL_VERSION = 1;
+constexpr int32_t RECV_TIMEOUT_SEC = 3;
+
+// Attributes of a generic netlink message, after its genlmsghdr
+template <typename Func> void ForEachAttr(const void *data, int32_t len, Func func)
+{
+    auto attr = reinterpret_cast<const rtattr *>(data);
+    for (; RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        func(static_cast<uint16_t>(attr->rta_type & NLA_TYPE_MASK), attr);
+    }
+}
+
+template <typename Func> void ForEachGenlAttr(const nlmsghdr *reply, Func func)
+{
+    int32_t len = static_cast<int32_t>(reply->nlmsg_len) - static_cast<int32_t>(NLMSG_LENGTH(GENL_HDRLEN));
+    if (len <= 0) {
+        return;
+    }
+    ForEachAttr(reinterpret_cast<const char *>(NLMSG_DATA(reply)) + GENL_HDRLEN, len, func);
+}
+
+template <typename T> T GetAttr(const rtattr *attr)
+{
+    T value = 0;
+    if (RTA_PAYLOAD(attr) >= sizeof(T)) {
+        (void)memcpy_s(&value, sizeof(value), RTA_DATA(attr), sizeof(T));
+    }
+    return value;
+}
+
+MptcpPmEndpoint ParseEndpoint(const rtattr *nested)
+{
+    MptcpPmEndpoint endpoint;
+    ForEachAttr(RTA_DATA(nested), static_cast<int32_t>(RTA_PAYLOAD(nested)), [&endpoint](uint16_t type,
+        const rtattr *attr) {
+        char addr[INET6_ADDRSTRLEN] = {0};
+        switch (type) {
+            case MPTCP_PM_ADDR_ATTR_ID:
+                endpoint.id = GetAttr<uint8_t>(attr);
+                break;
+            case MPTCP_PM_ADDR_ATTR_ADDR4:
+            case MPTCP_PM_ADDR_ATTR_ADDR6:
+                if (inet_ntop(type == MPTCP_PM_ADDR_ATTR_ADDR4 ? AF_INET : AF_INET6, RTA_DATA(attr), addr,
+                    sizeof(addr)) != nullptr) {
+                    endpoint.ipAddr = addr;
+                }
+                break;
+            case MPTCP_PM_ADDR_ATTR_IF_IDX:
+                endpoint.ifIndex = GetAttr<int32_t>(attr);
+                break;
+            case MPTCP_PM_ADDR_ATTR_FLAGS:
+                endpoint.flags = GetAttr<uint32_t>(attr);
+                break;
+            default:
+                break;
+        }
+    });
+    return endpoint;
+}
+} // namespace
+
+MptcpPmClient::MptcpPmClient() {}
+
+MptcpPmClient::~MptcpPmClient()
+{
+    if (socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+int32_t MptcpPmClient::Init()
+{
+    if (familyId_ != 0) {
+        return 0;
+    }
+    if (socket_ < 0) {
+        socket_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+        if (socket_ < 0) {
+            NETNATIVE_LOGE("MptcpPmClient: create socket failed, errno: %{public}d", errno);
+            return -errno;
+        }
+        timeval timeout = {.tv_sec = RECV_TIMEOUT_SEC, .tv_usec = 0};
+        int32_t on = 1;
+        (void)setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        // An ack without the request in it, a batch of acks fits the receive buffer
+        (void)setsockopt(socket_, SOL_NETLINK, NETLINK_CAP_ACK, &on, sizeof(on));
+    }
+    return ResolveFamily();
+}
+
+int32_t MptcpPmClient::ResolveFamily()
+{
+    NetlinkMsg msg = MakeRequest(GENL_ID_CTRL, CTRL_CMD_GETFAMILY);
+    char name[] = MPTCP_PM_NAME;
+    msg.AddAttr(CTRL_ATTR_FAMILY_NAME, name, sizeof(name));
+    uint16_t familyId = 0;
+    int32_t ret = Transact(msg, [&familyId](const nlmsghdr *reply) {
+        ForEachGenlAttr(reply, [&familyId](uint16_t type, const rtattr *attr) {
+            if (type == CTRL_ATTR_FAMILY_ID) {
+                familyId = GetAttr<uint16_t>(attr);
+            }
+        });
+    });
+    if (ret == 0 && familyId == 0) {
+        ret = -ENOENT;
+    }
+    if (ret != 0) {
+        NETNATIVE_LOGE("MptcpPmClient: resolve %{public}s failed, ret: %{public}d", MPTCP_PM_NAME, ret);
+        return ret;
+    }
+    familyId_ = familyId;
+    return 0;
+}
+
+NetlinkMsg MptcpPmClient::MakeRequest(uint16_t familyId, uint8_t cmd, uint16_t flags)
+{
+    NetlinkMsg msg(flags, NETLINK_MAX_LEN, 0);
+    msg.AddGenl(familyId, cmd, familyId == GENL_ID_CTRL ? GENL_CTRL_VERSION : MPTCP_PM_VER);
+    return msg;
+}
+
+bool MptcpPmClient::AddEndpointAttr(NetlinkMsg &msg, const MptcpPmEndpoint &endpoint, bool withAddress)
+{
+    nlattr *nested = msg.AddNestedStart(MPTCP_PM_ATTR_ADDR | NLA_F_NESTED);
+    if (nested == nullptr) {
+        return false;
+    }
+    uint8_t id = endpoint.id;
+    if (msg.AddAttr(MPTCP_PM_ADDR_ATTR_ID, &id, sizeof(id)) != 0) {
+        return false;
+    }
+    if (withAddress) {
+        in6_addr addr = {};
+        uint16_t family = inet_pton(AF_INET, endpoint.ipAddr.c_str(), &addr) == 1 ? AF_INET : AF_INET6;
+        if (family == AF_INET6 && inet_pton(AF_INET6, endpoint.ipAddr.c_str(), &addr) != 1) {
+            return false;
+        }
+        int32_t ifIndex = endpoint.ifIndex;
+        if (msg.AddAttr16(MPTCP_PM_ADDR_ATTR_FAMILY, family) != 0 ||
+            msg.AddAttr(family == AF_INET ? MPTCP_PM_ADDR_ATTR_ADDR4 : MPTCP_PM_ADDR_ATTR_ADDR6, &addr,
+                        family == AF_INET ? sizeof(in_addr) : sizeof(in6_addr)) != 0 ||
+            msg.AddAttr(MPTCP_PM_ADDR_ATTR_IF_IDX, &ifIndex, sizeof(ifIndex)) != 0 ||
+            msg.AddAttr32(MPTCP_PM_ADDR_ATTR_FLAGS, endpoint.flags) != 0) {
+            return false;
+        }
+    }
+    msg.AddNestedEnd(nested);
+    return true;
+}
+
+int32_t MptcpPmClient::ApplyBatch(std::vector<MptcpPmRequest> &requests)
+{
+    if (requests.empty()) {
+        return 0;
+    }
+    int32_t ret = Init();
+    if (ret != 0) {
+        return ret;
+    }
+    std::vector<NetlinkMsg> msgs;
+    msgs.reserve(requests.size());
+    for (auto &request : requests) {
+        bool add = request.op == MptcpPmRequest::ADD_ENDPOINT;
+        msgs.push_back(MakeRequest(familyId_, add ? MPTCP_PM_CMD_ADD_ADDR : MPTCP_PM_CMD_DEL_ADDR));
+        if (!AddEndpointAttr(msgs.back(), request.endpoint, add)) {
+            NETNATIVE_LOGE("MptcpPmClient: build request of endpoint %{public}u failed", request.endpoint.id);
+            return -EINVAL;
+        }
+    }
+    std::vector<int32_t> errors;
+    ret = SendNetlinkMsgsAndWaitAcks(socket_, seq_, msgs, errors);
+    if (ret != 0) {
+        return ret;
+    }
+    for (size_t i = 0; i < requests.size(); i++) {
+        requests[i].error = errors[i];
+    }
+    return 0;
+}
+
+int32_t MptcpPmClient::GetEndpoints(std::vector<MptcpPmEndpoint> &endpoints)
+{
+    int32_t ret = Init();
+    if (ret != 0) {
+        return ret;
+    }
+    NetlinkMsg msg = MakeRequest(familyId_, MPTCP_PM_CMD_GET_ADDR, NLM_F_DUMP);
+    std::vector<MptcpPmEndpoint> dumped;
+    ret = Transact(msg, [&dumped](const nlmsghdr *reply) {
+        ForEachGenlAttr(reply, [&dumped](uint16_t type, const rtattr *attr) {
+            if (type == MPTCP_PM_ATTR_ADDR) {
+                dumped.push_back(ParseEndpoint(attr));
+            }
+        });
+    });
+    if (ret != 0) {
+        NETNATIVE_LOGE("MptcpPmClient: dump endpoints failed, ret: %{public}d", ret);
+        return ret;
+    }
+    endpoints.swap(dumped);
+    return 0;
+}
+
+int32_t MptcpPmClient::SetLimits(uint32_t subflows, uint32_t addAddrAccepted)
+{
+    int32_t ret = Init();
+    if (ret != 0) {
+        return ret;
+    }
+    NetlinkMsg msg = MakeRequest(familyId_, MPTCP_PM_CMD_SET_LIMITS);
+    if (msg.AddAttr32(MPTCP_PM_ATTR_RCV_ADD_ADDRS, addAddrAccepted) != 0 ||
+        msg.AddAttr32(MPTCP_PM_ATTR_SUBFLOWS, subflows) != 0) {
+        return -EINVAL;
+    }
+    return Transact(msg);
+}
+
+int32_t MptcpPmClient::GetLimits(uint32_t &subflows, uint32_t &addAddrAccepted)
+{
+    int32_t ret = Init();
+    if (ret != 0) {
+        return ret;
+    }
+    NetlinkMsg msg = MakeRequest(familyId_, MPTCP_PM_CMD_GET_LIMITS);
+    return Transact(msg, [&subflows, &addAddrAccepted](const nlmsghdr *reply) {
+        ForEachGenlAttr(reply, [&subflows, &addAddrAccepted](uint16_t type, const rtattr *attr) {
+            if (type == MPTCP_PM_ATTR_SUBFLOWS) {
+                subflows = GetAttr<uint32_t>(attr);
+            } else if (type == MPTCP_PM_ATTR_RCV_ADD_ADDRS) {
+                addAddrAccepted = GetAttr<uint32_t>(attr);
+            }
+        });
+    });
+}
+
+int32_t MptcpPmClient::Transact(NetlinkMsg &msg, const ReplyHandler &handler)
+{
+    std::vector<NetlinkMsg> msgs;
+    msgs.push_back(std::move(msg));
+    std::vector<int32_t> errors;
+    int32_t ret = SendNetlinkMsgsAndWaitAcks(socket_, seq_, msgs, errors, handler);
+    return ret != 0 ? ret : errors.front();
+}
+} // namespace nmd
+} // namespace OHOS
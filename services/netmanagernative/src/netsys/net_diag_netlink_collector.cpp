@@ -0,0 +1,597 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "net_diag_netlink_collector.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <linux/inet_diag.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/unix_diag.h>
+#include <net/if.h>
+#include <net/if_arp.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pwd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "net_manager_constants.h"
+#include "netnative_log_wrapper.h"
+#include "rtnetlink_link.h"
+
+namespace OHOS {
+namespace nmd {
+using namespace NetManagerStandard;
+using namespace NetsysNative;
+
+namespace {
+constexpr size_t DUMP_BUFFER_SIZE = 32768;
+constexpr int32_t DUMP_RECV_TIMEOUT_SEC = 3;
+constexpr uint32_t SOCK_DIAG_STATES_ALL = 0xffffffff;
+constexpr uint8_t IPV4_MAX_PREFIX_LEN = 32;
+constexpr size_t MAC_ADDR_LEN = 6;
+constexpr size_t USER_NAME_BUFFER_SIZE = 1024;
+constexpr int32_t PROGRAM_NAME_MAX_LEN = 16;
+
+constexpr const char *PROTOCOL_UNIX = "unix";
+constexpr const char *ROUTE_DEFAULT = "default";
+constexpr const char *ROUTE_ANY = "*";
+constexpr const char *PORT_ANY = "*";
+constexpr const char *PROGRAM_UNKNOWN = "-";
+constexpr const char *SOCKET_LINK_PREFIX = "socket:[";
+constexpr const char *PROC_PATH = "/proc";
+constexpr const char *UNIX_FLAG_ACCEPT = "ACC";
+constexpr const char *LINK_ENCAP_UNSPEC = "UNSPEC";
+
+// Same order as the TCP_* states, what netstat prints for each of them
+const char *const TCP_STATE_NAMES[] = {
+    "",          "ESTABLISHED", "SYN_SENT", "SYN_RECV",  "FIN_WAIT1", "FIN_WAIT2",
+    "TIME_WAIT", "CLOSE",       "CLOSE_WAIT", "LAST_ACK", "LISTEN",   "CLOSING",
+};
+
+struct RouteDumpRequest {
+    nlmsghdr nlh_;
+    rtmsg rtm_;
+};
+
+struct LinkDumpRequest {
+    nlmsghdr nlh_;
+    ifinfomsg ifi_;
+};
+
+struct AddrDumpRequest {
+    nlmsghdr nlh_;
+    ifaddrmsg ifa_;
+};
+
+struct InetDiagDumpRequest {
+    nlmsghdr nlh_;
+    inet_diag_req_v2 req_;
+};
+
+struct UnixDiagDumpRequest {
+    nlmsghdr nlh_;
+    unix_diag_req req_;
+};
+
+template <typename T> void FillDumpHeader(T &request, uint16_t type)
+{
+    request.nlh_.nlmsg_len = sizeof(T);
+    request.nlh_.nlmsg_type = type;
+    request.nlh_.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+}
+
+std::string AddrToString(int32_t family, const void *addr)
+{
+    char buf[INET6_ADDRSTRLEN] = {0};
+    if (inet_ntop(family, addr, buf, sizeof(buf)) == nullptr) {
+        return "";
+    }
+    return buf;
+}
+
+std::string PrefixToMask(uint8_t prefixLen)
+{
+    in_addr mask = {};
+    mask.s_addr = prefixLen == 0 ? 0 : htonl(~0U << (IPV4_MAX_PREFIX_LEN - std::min(prefixLen, IPV4_MAX_PREFIX_LEN)));
+    return AddrToString(AF_INET, &mask);
+}
+
+std::string IfIndexToName(uint32_t ifIndex)
+{
+    char name[IF_NAMESIZE] = {0};
+    if (if_indextoname(ifIndex, name) == nullptr) {
+        return "";
+    }
+    return name;
+}
+
+std::string SockAddrToString(uint8_t family, const __be32 *addr, __be16 port)
+{
+    std::string address = AddrToString(family, addr);
+    uint16_t hostPort = ntohs(port);
+    return address + ":" + (hostPort == 0 ? std::string(PORT_ANY) : std::to_string(hostPort));
+}
+
+std::string InetStateName(uint8_t protocol, uint8_t state)
+{
+    if (protocol == IPPROTO_TCP) {
+        return state < sizeof(TCP_STATE_NAMES) / sizeof(TCP_STATE_NAMES[0]) ? TCP_STATE_NAMES[state] : "";
+    }
+    // Datagram sockets only show whether they are connected
+    return state == TCP_ESTABLISHED ? TCP_STATE_NAMES[TCP_ESTABLISHED] : "";
+}
+
+std::string InetProtocolName(uint8_t family, uint8_t protocol)
+{
+    std::string name;
+    switch (protocol) {
+        case IPPROTO_TCP:
+            name = "tcp";
+            break;
+        case IPPROTO_UDP:
+            name = "udp";
+            break;
+        default:
+            name = "raw";
+            break;
+    }
+    return family == AF_INET6 ? name + "6" : name;
+}
+
+std::string UnixTypeName(uint8_t type)
+{
+    switch (type) {
+        case SOCK_STREAM:
+            return "STREAM";
+        case SOCK_DGRAM:
+            return "DGRAM";
+        case SOCK_SEQPACKET:
+            return "SEQPACKET";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+std::string UnixStateName(uint8_t state)
+{
+    switch (state) {
+        case TCP_LISTEN:
+            return "LISTENING";
+        case TCP_ESTABLISHED:
+            return "CONNECTED";
+        case TCP_SYN_SENT:
+            return "CONNECTING";
+        default:
+            return "";
+    }
+}
+
+std::string LinkEncapName(uint16_t type)
+{
+    switch (type) {
+        case ARPHRD_ETHER:
+            return "Ethernet";
+        case ARPHRD_LOOPBACK:
+            return "Local Loopback";
+        case ARPHRD_PPP:
+            return "Point-to-Point Protocol";
+        case ARPHRD_TUNNEL:
+            return "IPIP Tunnel";
+        case ARPHRD_SIT:
+            return "IPv6-in-IPv4";
+        default:
+            return LINK_ENCAP_UNSPEC;
+    }
+}
+
+std::string Ipv6ScopeName(uint8_t scope)
+{
+    switch (scope) {
+        case RT_SCOPE_UNIVERSE:
+            return "Global";
+        case RT_SCOPE_SITE:
+            return "Site";
+        case RT_SCOPE_LINK:
+            return "Link";
+        case RT_SCOPE_HOST:
+            return "Host";
+        default:
+            return "Unknown";
+    }
+}
+
+bool IsNumber(const char *name)
+{
+    if (name == nullptr || *name == '\0') {
+        return false;
+    }
+    for (; *name != '\0'; ++name) {
+        if (*name < '0' || *name > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int32_t NetDiagNetlinkCollector::Dump(int32_t protocol, nlmsghdr *request, const DumpCallback &callback)
+{
+    int32_t sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, protocol);
+    if (sock < 0) {
+        NETNATIVE_LOGE("Create netlink socket failed, protocol:%{public}d errno:%{public}d", protocol, errno);
+        return NETMANAGER_ERR_INTERNAL;
+    }
+    timeval timeout = {.tv_sec = DUMP_RECV_TIMEOUT_SEC, .tv_usec = 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    request->nlmsg_seq = 1;
+    if (send(sock, request, request->nlmsg_len, 0) != static_cast<ssize_t>(request->nlmsg_len)) {
+        NETNATIVE_LOGE("Send dump request failed, protocol:%{public}d errno:%{public}d", protocol, errno);
+        close(sock);
+        return NETMANAGER_ERR_INTERNAL;
+    }
+
+    std::vector<uint8_t> buffer(DUMP_BUFFER_SIZE);
+    int32_t ret = NETMANAGER_ERR_INTERNAL;
+    bool isDone = false;
+    while (!isDone) {
+        ssize_t len = recv(sock, buffer.data(), buffer.size(), 0);
+        if (len <= 0) {
+            NETNATIVE_LOGE("Receive dump failed, protocol:%{public}d errno:%{public}d", protocol, errno);
+            break;
+        }
+        auto nlh = reinterpret_cast<nlmsghdr *>(buffer.data());
+        for (; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_seq != request->nlmsg_seq) {
+                continue;
+            }
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                ret = NETMANAGER_SUCCESS;
+                isDone = true;
+                break;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                auto err = reinterpret_cast<nlmsgerr *>(NLMSG_DATA(nlh));
+                NETNATIVE_LOGE("Dump rejected, protocol:%{public}d error:%{public}d", protocol, err->error);
+                isDone = true;
+                break;
+            }
+            callback(nlh);
+        }
+    }
+    close(sock);
+    return ret;
+}
+
+int32_t NetDiagNetlinkCollector::GetRouteTable(std::list<NetDiagRouteTable> &routeTables)
+{
+    RouteDumpRequest request = {};
+    FillDumpHeader(request, RTM_GETROUTE);
+    request.rtm_.rtm_family = AF_INET;
+    return Dump(NETLINK_ROUTE, &request.nlh_, [&routeTables](const nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != RTM_NEWROUTE || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(rtmsg))) {
+            return;
+        }
+        auto rtm = reinterpret_cast<const rtmsg *>(NLMSG_DATA(nlh));
+        bool isReject = rtm->rtm_type == RTN_UNREACHABLE || rtm->rtm_type == RTN_PROHIBIT ||
+            rtm->rtm_type == RTN_BLACKHOLE;
+        if ((rtm->rtm_type != RTN_UNICAST && !isReject) || (rtm->rtm_flags & RTM_F_CLONED)) {
+            return;
+        }
+        uint32_t table = rtm->rtm_table;
+        in_addr dst = {};
+        in_addr gateway = {};
+        uint32_t ifIndex = 0;
+        uint32_t metric = 0;
+        int32_t attrLen = static_cast<int32_t>(RTM_PAYLOAD(nlh));
+        for (auto rta = RTM_RTA(rtm); RTA_OK(rta, attrLen); rta = RTA_NEXT(rta, attrLen)) {
+            if (rta->rta_type == RTA_TABLE && RTA_PAYLOAD(rta) >= sizeof(uint32_t)) {
+                table = *reinterpret_cast<uint32_t *>(RTA_DATA(rta));
+            } else if (rta->rta_type == RTA_DST && RTA_PAYLOAD(rta) >= sizeof(in_addr)) {
+                dst = *reinterpret_cast<in_addr *>(RTA_DATA(rta));
+            } else if (rta->rta_type == RTA_GATEWAY && RTA_PAYLOAD(rta) >= sizeof(in_addr)) {
+                gateway = *reinterpret_cast<in_addr *>(RTA_DATA(rta));
+            } else if (rta->rta_type == RTA_OIF && RTA_PAYLOAD(rta) >= sizeof(uint32_t)) {
+                ifIndex = *reinterpret_cast<uint32_t *>(RTA_DATA(rta));
+            } else if (rta->rta_type == RTA_PRIORITY && RTA_PAYLOAD(rta) >= sizeof(uint32_t)) {
+                metric = *reinterpret_cast<uint32_t *>(RTA_DATA(rta));
+            }
+        }
+        // netstat -r reads /proc/net/route, which only lists the main table
+        if (table != RT_TABLE_MAIN) {
+            return;
+        }
+        NetDiagRouteTable routeTable;
+        routeTable.destination_ = rtm->rtm_dst_len == 0 ? ROUTE_DEFAULT : AddrToString(AF_INET, &dst);
+        routeTable.gateway_ = gateway.s_addr == 0 ? ROUTE_ANY : AddrToString(AF_INET, &gateway);
+        routeTable.mask_ = PrefixToMask(rtm->rtm_dst_len);
+        routeTable.flags_ = isReject ? "!" : "U";
+        if (gateway.s_addr != 0) {
+            routeTable.flags_ += "G";
+        }
+        if (rtm->rtm_dst_len == IPV4_MAX_PREFIX_LEN) {
+            routeTable.flags_ += "H";
+        }
+        routeTable.metric_ = metric;
+        routeTable.iface_ = ifIndex == 0 ? ROUTE_ANY : IfIndexToName(ifIndex);
+        routeTables.push_back(routeTable);
+    });
+}
+
+int32_t NetDiagNetlinkCollector::GetSocketsInfo(NetDiagProtocolType socketType, NetDiagSocketsInfo &socketsInfo)
+{
+    // The per-protocol queries stand for netstat -p, the all sockets query for plain netstat -a
+    bool withProgram = socketType != PROTOCOL_TYPE_ALL;
+    std::vector<uint8_t> protocols;
+    switch (socketType) {
+        case PROTOCOL_TYPE_ALL:
+            protocols = {IPPROTO_TCP, IPPROTO_UDP, IPPROTO_RAW};
+            break;
+        case PROTOCOL_TYPE_TCP:
+            protocols = {IPPROTO_TCP};
+            break;
+        case PROTOCOL_TYPE_UDP:
+            protocols = {IPPROTO_UDP};
+            break;
+        case PROTOCOL_TYPE_RAW:
+            protocols = {IPPROTO_RAW};
+            break;
+        case PROTOCOL_TYPE_UNIX:
+            break;
+        default:
+            NETNATIVE_LOGE("Unknown protocol type: %{public}d", socketType);
+            return NETMANAGER_ERR_INTERNAL;
+    }
+    for (uint8_t protocol : protocols) {
+        for (uint8_t family : {AF_INET, AF_INET6}) {
+            int32_t ret = DumpInetSockets(family, protocol, withProgram, socketsInfo);
+            // raw_diag is an optional module, a kernel without it still lists every other protocol
+            if (ret != NETMANAGER_SUCCESS && !(socketType == PROTOCOL_TYPE_ALL && protocol == IPPROTO_RAW)) {
+                return ret;
+            }
+        }
+    }
+    if (socketType == PROTOCOL_TYPE_ALL || socketType == PROTOCOL_TYPE_UNIX) {
+        return DumpUnixSockets(socketsInfo);
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+int32_t NetDiagNetlinkCollector::DumpInetSockets(uint8_t family, uint8_t protocol, bool withProgram,
+                                                 NetDiagSocketsInfo &socketsInfo)
+{
+    if (withProgram) {
+        LoadSocketPrograms();
+    }
+    InetDiagDumpRequest request = {};
+    FillDumpHeader(request, SOCK_DIAG_BY_FAMILY);
+    request.req_.sdiag_family = family;
+    request.req_.sdiag_protocol = protocol;
+    request.req_.idiag_states = SOCK_DIAG_STATES_ALL;
+    if (protocol == IPPROTO_RAW) {
+        // raw_diag reads the raw protocol to match from the pad byte, IPPROTO_RAW matches them all
+        request.req_.pad = IPPROTO_RAW;
+    }
+    return Dump(NETLINK_SOCK_DIAG, &request.nlh_, [this, family, protocol, withProgram, &socketsInfo](
+        const nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(inet_diag_msg))) {
+            return;
+        }
+        auto msg = reinterpret_cast<const inet_diag_msg *>(NLMSG_DATA(nlh));
+        NeyDiagNetProtoSocketInfo socketInfo;
+        socketInfo.protocol_ = InetProtocolName(family, protocol);
+        socketInfo.recvQueue_ = static_cast<uint16_t>(msg->idiag_rqueue);
+        socketInfo.sendQueue_ = static_cast<uint16_t>(msg->idiag_wqueue);
+        socketInfo.localAddr_ = SockAddrToString(family, msg->id.idiag_src, msg->id.idiag_sport);
+        socketInfo.foreignAddr_ = SockAddrToString(family, msg->id.idiag_dst, msg->id.idiag_dport);
+        socketInfo.state_ = InetStateName(protocol, msg->idiag_state);
+        socketInfo.user_ = GetUserName(msg->idiag_uid);
+        socketInfo.inode_ = msg->idiag_inode;
+        if (withProgram) {
+            auto iter = socketPrograms_.find(msg->idiag_inode);
+            socketInfo.programName_ = iter == socketPrograms_.end() ? PROGRAM_UNKNOWN : iter->second;
+        }
+        socketsInfo.netProtoSocketsInfo_.push_back(socketInfo);
+    });
+}
+
+int32_t NetDiagNetlinkCollector::DumpUnixSockets(NetDiagSocketsInfo &socketsInfo)
+{
+    UnixDiagDumpRequest request = {};
+    FillDumpHeader(request, SOCK_DIAG_BY_FAMILY);
+    request.req_.sdiag_family = AF_UNIX;
+    request.req_.udiag_states = SOCK_DIAG_STATES_ALL;
+    request.req_.udiag_show = UDIAG_SHOW_NAME;
+    return Dump(NETLINK_SOCK_DIAG, &request.nlh_, [&socketsInfo](const nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(unix_diag_msg))) {
+            return;
+        }
+        auto msg = reinterpret_cast<const unix_diag_msg *>(NLMSG_DATA(nlh));
+        NetDiagUnixSocketInfo socketInfo;
+        socketInfo.protocol_ = PROTOCOL_UNIX;
+        socketInfo.flags_ = msg->udiag_state == TCP_LISTEN ? UNIX_FLAG_ACCEPT : "";
+        socketInfo.type_ = UnixTypeName(msg->udiag_type);
+        socketInfo.state_ = UnixStateName(msg->udiag_state);
+        socketInfo.inode_ = msg->udiag_ino;
+        int32_t attrLen = static_cast<int32_t>(nlh->nlmsg_len - NLMSG_LENGTH(sizeof(unix_diag_msg)));
+        auto rta = reinterpret_cast<const rtattr *>(msg + 1);
+        for (; RTA_OK(rta, attrLen); rta = RTA_NEXT(rta, attrLen)) {
+            if (rta->rta_type != UNIX_DIAG_NAME || RTA_PAYLOAD(rta) == 0) {
+                continue;
+            }
+            std::string path(reinterpret_cast<const char *>(RTA_DATA(rta)), RTA_PAYLOAD(rta));
+            // Abstract names start with a NUL byte, netstat shows it as '@'
+            if (path[0] == '\0') {
+                path[0] = '@';
+            }
+            socketInfo.path_ = path.c_str();
+        }
+        socketsInfo.unixSocketsInfo_.push_back(socketInfo);
+    });
+}
+
+void NetDiagNetlinkCollector::LoadSocketPrograms()
+{
+    if (isProgramLoaded_) {
+        return;
+    }
+    isProgramLoaded_ = true;
+    DIR *procDir = opendir(PROC_PATH);
+    if (procDir == nullptr) {
+        return;
+    }
+    const size_t prefixLen = strlen(SOCKET_LINK_PREFIX);
+    for (dirent *procEntry = readdir(procDir); procEntry != nullptr; procEntry = readdir(procDir)) {
+        if (!IsNumber(procEntry->d_name)) {
+            continue;
+        }
+        std::string pidPath = std::string(PROC_PATH) + "/" + procEntry->d_name;
+        DIR *fdDir = opendir((pidPath + "/fd").c_str());
+        if (fdDir == nullptr) {
+            continue;
+        }
+        std::string program;
+        for (dirent *fdEntry = readdir(fdDir); fdEntry != nullptr; fdEntry = readdir(fdDir)) {
+            char link[PATH_MAX] = {0};
+            std::string fdPath = pidPath + "/fd/" + fdEntry->d_name;
+            ssize_t len = readlink(fdPath.c_str(), link, sizeof(link) - 1);
+            if (len <= static_cast<ssize_t>(prefixLen) || strncmp(link, SOCKET_LINK_PREFIX, prefixLen) != 0) {
+                continue;
+            }
+            if (program.empty()) {
+                std::ifstream commFile(pidPath + "/comm");
+                std::string comm;
+                std::getline(commFile, comm);
+                program = std::string(procEntry->d_name) + "/" + comm.substr(0, PROGRAM_NAME_MAX_LEN);
+            }
+            uint32_t inode = static_cast<uint32_t>(strtoul(link + prefixLen, nullptr, 0));
+            socketPrograms_.emplace(inode, program);
+        }
+        closedir(fdDir);
+    }
+    closedir(procDir);
+}
+
+std::string NetDiagNetlinkCollector::GetUserName(uint32_t uid)
+{
+    auto iter = userNames_.find(uid);
+    if (iter != userNames_.end()) {
+        return iter->second;
+    }
+    passwd pwd = {};
+    passwd *result = nullptr;
+    char buf[USER_NAME_BUFFER_SIZE] = {0};
+    std::string name;
+    if (getpwuid_r(uid, &pwd, buf, sizeof(buf), &result) == 0 && result != nullptr && result->pw_name != nullptr) {
+        name = result->pw_name;
+    } else {
+        name = std::to_string(uid);
+    }
+    userNames_.emplace(uid, name);
+    return name;
+}
+
+int32_t NetDiagNetlinkCollector::GetInterfaceConfig(std::list<NetDiagIfaceConfig> &configs,
+                                                    const std::string &ifaceName)
+{
+    std::vector<NetDiagIfaceConfig> links;
+    std::map<int32_t, size_t> linkPositions;
+    LinkDumpRequest linkRequest = {};
+    FillDumpHeader(linkRequest, RTM_GETLINK);
+    linkRequest.ifi_.ifi_family = AF_UNSPEC;
+    int32_t ret = Dump(NETLINK_ROUTE, &linkRequest.nlh_, [&links, &linkPositions, &ifaceName](const nlmsghdr *nlh) {
+        RtnetlinkLink link;
+        if (nlh->nlmsg_type != RTM_NEWLINK || !ParseRtnetlinkLink(nlh, link) || link.name.empty() ||
+            (!ifaceName.empty() && link.name != ifaceName)) {
+            return;
+        }
+        NetDiagIfaceConfig config;
+        config.ifaceName_ = link.name;
+        config.linkEncap_ = LinkEncapName(link.type);
+        config.isUp_ = (link.flags & IFF_UP) != 0;
+        if (link.type == ARPHRD_ETHER && link.hwAddr.size() == MAC_ADDR_LEN) {
+            config.macAddr_ = HwAddrToString(link.hwAddr);
+        }
+        config.mtu_ = static_cast<uint32_t>(link.mtu);
+        config.txQueueLen_ = link.txQueueLen;
+        config.rxBytes_ = static_cast<uint32_t>(link.stats.rx_bytes);
+        config.txBytes_ = static_cast<uint32_t>(link.stats.tx_bytes);
+        linkPositions[link.index] = links.size();
+        links.push_back(config);
+    });
+    if (ret != NETMANAGER_SUCCESS) {
+        return ret;
+    }
+
+    AddrDumpRequest addrRequest = {};
+    FillDumpHeader(addrRequest, RTM_GETADDR);
+    addrRequest.ifa_.ifa_family = AF_UNSPEC;
+    ret = Dump(NETLINK_ROUTE, &addrRequest.nlh_, [&links, &linkPositions](const nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != RTM_NEWADDR || nlh->nlmsg_len < NLMSG_LENGTH(sizeof(ifaddrmsg))) {
+            return;
+        }
+        auto ifa = reinterpret_cast<const ifaddrmsg *>(NLMSG_DATA(nlh));
+        auto iter = linkPositions.find(static_cast<int32_t>(ifa->ifa_index));
+        if (iter == linkPositions.end()) {
+            return;
+        }
+        NetDiagIfaceConfig &config = links[iter->second];
+        const void *address = nullptr;
+        const void *local = nullptr;
+        const void *broadcast = nullptr;
+        int32_t attrLen = static_cast<int32_t>(IFA_PAYLOAD(nlh));
+        for (auto rta = IFA_RTA(ifa); RTA_OK(rta, attrLen); rta = RTA_NEXT(rta, attrLen)) {
+            if (rta->rta_type == IFA_ADDRESS) {
+                address = RTA_DATA(rta);
+            } else if (rta->rta_type == IFA_LOCAL) {
+                local = RTA_DATA(rta);
+            } else if (rta->rta_type == IFA_BROADCAST) {
+                broadcast = RTA_DATA(rta);
+            }
+        }
+        if (ifa->ifa_family == AF_INET6 && address != nullptr) {
+            config.ipv6Addrs_.emplace_back(AddrToString(AF_INET6, address) + "/" + std::to_string(ifa->ifa_prefixlen),
+                                           Ipv6ScopeName(ifa->ifa_scope));
+            return;
+        }
+        // ifconfig only shows the primary IPv4 address, the local one on point to point links
+        if (ifa->ifa_family != AF_INET || !config.ipv4Addr_.empty() || (ifa->ifa_flags & IFA_F_SECONDARY)) {
+            return;
+        }
+        const void *ipv4 = local != nullptr ? local : address;
+        if (ipv4 == nullptr) {
+            return;
+        }
+        config.ipv4Addr_ = AddrToString(AF_INET, ipv4);
+        config.ipv4Bcast_ = broadcast != nullptr ? AddrToString(AF_INET, broadcast) : "";
+        config.ipv4Mask_ = PrefixToMask(ifa->ifa_prefixlen);
+    });
+    if (ret != NETMANAGER_SUCCESS) {
+        return ret;
+    }
+    configs.insert(configs.end(), links.begin(), links.end());
+    return NETMANAGER_SUCCESS;
+}
+} // namespace nmd
+} // namespace OHOS
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "net_diag_ping_engine.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <ctime>
+#include <netdb.h>
+#include <netinet/icmp6.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+#include "net_manager_constants.h"
+#include "netnative_log_wrapper.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace nmd {
+using namespace NetManagerStandard;
+using namespace NetsysNative;
+
+namespace {
+constexpr int64_t MS_PER_SEC = 1000;
+constexpr int64_t NS_PER_MS = 1000000;
+constexpr int64_t NS_PER_SEC = 1000000000;
+constexpr uint32_t DEFAULT_INTERVAL_MS = 1000;
+constexpr uint32_t FLOOD_INTERVAL_MS = 10;
+constexpr uint16_t DEFAULT_DATA_SIZE = 56;
+constexpr uint16_t DEFAULT_TIMEOUT_SEC = 3;
+constexpr uint16_t MAX_DURATION_SEC = 30;
+constexpr uint16_t ICMP_HEADER_LEN = 8;
+constexpr uint16_t IPV4_HEADER_LEN = 20;
+constexpr uint16_t IPV6_HEADER_LEN = 40;
+constexpr uint32_t IPV4_MAX_HEADER_LEN = 60;
+constexpr uint32_t CONTROL_BUFFER_SIZE = 256;
+constexpr uint32_t IPV4_IHL_UNIT = 4;
+constexpr uint32_t CHECKSUM_FOLD_SHIFT = 16;
+constexpr uint32_t CHECKSUM_LOW_MASK = 0xFFFF;
+constexpr uint32_t PAYLOAD_PATTERN_MASK = 0xFF;
+
+std::atomic<uint16_t> g_pingIdentSeq = 0;
+
+int64_t NowNs()
+{
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+int64_t NowMs()
+{
+    return NowNs() / NS_PER_MS;
+}
+
+uint16_t IcmpChecksum(const uint8_t *data, size_t len)
+{
+    uint32_t sum = 0;
+    size_t i = 0;
+    for (; i + 1 < len; i += sizeof(uint16_t)) {
+        uint16_t word = 0;
+        (void)memcpy_s(&word, sizeof(word), data + i, sizeof(word));
+        sum += word;
+    }
+    if (i < len) {
+        uint16_t word = 0;
+        (void)memcpy_s(&word, sizeof(word), data + i, 1);
+        sum += word;
+    }
+    sum = (sum >> CHECKSUM_FOLD_SHIFT) + (sum & CHECKSUM_LOW_MASK);
+    sum += (sum >> CHECKSUM_FOLD_SHIFT);
+    return static_cast<uint16_t>(~sum);
+}
+
+std::string SockAddrToString(const sockaddr_storage &addr)
+{
+    char ip[INET6_ADDRSTRLEN] = {0};
+    if (addr.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(&addr)->sin_addr, ip, sizeof(ip));
+    } else if (addr.ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6 *>(&addr)->sin6_addr, ip, sizeof(ip));
+    }
+    return ip;
+}
+} // namespace
+
+NetDiagPingEngine::NetDiagPingEngine(const NetDiagPingOption &pingOption) : option_(pingOption)
+{
+    family_ = (option_.forceType_ == FORCE_TYPE_IPV6) ? AF_INET6 : AF_INET;
+    if (option_.dataSize_ == 0) {
+        option_.dataSize_ = DEFAULT_DATA_SIZE;
+    }
+}
+
+NetDiagPingEngine::~NetDiagPingEngine()
+{
+    CloseSocket();
+}
+
+int32_t NetDiagPingEngine::Run(NetDiagPingResult &pingResult)
+{
+    if (!ResolveDestination()) {
+        // Same result the ping output parser produces for "Name does not resolve"
+        return NETMANAGER_SUCCESS;
+    }
+    if (!OpenSocket()) {
+        return NETMANAGER_ERR_INTERNAL;
+    }
+    if (!ApplySocketOptions()) {
+        CloseSocket();
+        return NETMANAGER_SUCCESS;
+    }
+    pingResult.host_ = option_.destination_;
+    pingResult.ipAddr_ = destIp_;
+    pingResult.dateSize_ = option_.dataSize_;
+    pingResult.payloadSize_ =
+        option_.dataSize_ + ICMP_HEADER_LEN + ((family_ == AF_INET) ? IPV4_HEADER_LEN : IPV6_HEADER_LEN);
+
+    int64_t interval = option_.interval_ ? option_.interval_ : DEFAULT_INTERVAL_MS;
+    if (option_.flood_) {
+        interval = FLOOD_INTERVAL_MS;
+    }
+    int64_t timeout = (option_.timeOut_ ? option_.timeOut_ : DEFAULT_TIMEOUT_SEC) * MS_PER_SEC;
+    int64_t duration = (option_.duration_ != 0 && option_.duration_ < MAX_DURATION_SEC) ? option_.duration_
+                                                                                          : MAX_DURATION_SEC;
+    int64_t now = NowMs();
+    int64_t deadline = now + duration * MS_PER_SEC;
+    int64_t nextSend = now;
+    int64_t lastSend = now;
+    uint16_t seq = 0;
+    while ((now = NowMs()) < deadline) {
+        bool isSending = (option_.count_ == 0) || (pingResult.transCount_ < option_.count_);
+        if (isSending && now >= nextSend) {
+            SendEcho(++seq);
+            pingResult.transCount_++;
+            lastSend = now;
+            nextSend = std::max(nextSend + interval, now);
+            continue;
+        }
+        int64_t wakeup = deadline;
+        if (isSending) {
+            wakeup = std::min(wakeup, nextSend);
+        } else {
+            if (pendingEchos_.empty() || now >= lastSend + timeout) {
+                break;
+            }
+            wakeup = std::min(wakeup, lastSend + timeout);
+        }
+        struct pollfd pfd = {.fd = sockFd_, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, static_cast<int>(wakeup - now)) > 0) {
+            ReceiveReplies(pingResult);
+        }
+    }
+    CloseSocket();
+    return NETMANAGER_SUCCESS;
+}
+
+bool NetDiagPingEngine::ResolveDestination()
+{
+    struct addrinfo hints = {};
+    hints.ai_family = family_;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo *result = nullptr;
+    if (getaddrinfo(option_.destination_.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+        NETNATIVE_LOGE("Ping destination does not resolve");
+        return false;
+    }
+    if (memcpy_s(&destAddr_, sizeof(destAddr_), result->ai_addr, result->ai_addrlen) != EOK) {
+        freeaddrinfo(result);
+        return false;
+    }
+    destAddrLen_ = result->ai_addrlen;
+    freeaddrinfo(result);
+    destIp_ = SockAddrToString(destAddr_);
+    return true;
+}
+
+bool NetDiagPingEngine::OpenSocket()
+{
+    int32_t protocol = (family_ == AF_INET) ? IPPROTO_ICMP : IPPROTO_ICMPV6;
+    sockFd_ = socket(family_, SOCK_DGRAM | SOCK_CLOEXEC, protocol);
+    if (sockFd_ >= 0) {
+        isRawSocket_ = false;
+        return true;
+    }
+    NETNATIVE_LOGI("Datagram ICMP socket unavailable, errno:%{public}d, try raw socket", errno);
+    sockFd_ = socket(family_, SOCK_RAW | SOCK_CLOEXEC, protocol);
+    if (sockFd_ < 0) {
+        NETNATIVE_LOGE("Raw ICMP socket unavailable, errno:%{public}d", errno);
+        return false;
+    }
+    isRawSocket_ = true;
+    // Raw sockets see every echo reply of the host, the identifier tells ours apart
+    ident_ = static_cast<uint16_t>(getpid() + g_pingIdentSeq++);
+    return true;
+}
+
+bool NetDiagPingEngine::ApplySocketOptions()
+{
+    int32_t on = 1;
+    if (family_ == AF_INET) {
+        setsockopt(sockFd_, IPPROTO_IP, IP_RECVTTL, &on, sizeof(on));
+    } else {
+        setsockopt(sockFd_, IPPROTO_IPV6, IPV6_RECVHOPLIMIT, &on, sizeof(on));
+    }
+    if (isRawSocket_ && family_ == AF_INET6) {
+        struct icmp6_filter filter;
+        ICMP6_FILTER_SETBLOCKALL(&filter);
+        ICMP6_FILTER_SETPASS(ICMP6_ECHO_REPLY, &filter);
+        setsockopt(sockFd_, IPPROTO_ICMPV6, ICMP6_FILTER, &filter, sizeof(filter));
+    }
+    if (option_.ttl_) {
+        int32_t ttl = option_.ttl_;
+        if (setsockopt(sockFd_, (family_ == AF_INET) ? IPPROTO_IP : IPPROTO_IPV6,
+                       (family_ == AF_INET) ? IP_TTL : IPV6_UNICAST_HOPS, &ttl, sizeof(ttl)) < 0) {
+            NETNATIVE_LOGE("Set ping ttl failed, errno:%{public}d", errno);
+            return false;
+        }
+    }
+    if (option_.mark_) {
+        uint32_t mark = option_.mark_;
+        if (setsockopt(sockFd_, SOL_SOCKET, SO_MARK, &mark, sizeof(mark)) < 0) {
+            NETNATIVE_LOGE("Set ping mark failed, errno:%{public}d", errno);
+            return false;
+        }
+    }
+    if (option_.source_.empty()) {
+        return true;
+    }
+    // Like ping -I, the source is either a local address or an interface name
+    sockaddr_storage source = {};
+    socklen_t sourceLen = 0;
+    if (family_ == AF_INET) {
+        auto addr = reinterpret_cast<sockaddr_in *>(&source);
+        addr->sin_family = AF_INET;
+        sourceLen = sizeof(sockaddr_in);
+        if (inet_pton(AF_INET, option_.source_.c_str(), &addr->sin_addr) != 1) {
+            sourceLen = 0;
+        }
+    } else {
+        auto addr = reinterpret_cast<sockaddr_in6 *>(&source);
+        addr->sin6_family = AF_INET6;
+        sourceLen = sizeof(sockaddr_in6);
+        if (inet_pton(AF_INET6, option_.source_.c_str(), &addr->sin6_addr) != 1) {
+            sourceLen = 0;
+        }
+    }
+    int32_t ret = (sourceLen != 0) ?
+        bind(sockFd_, reinterpret_cast<sockaddr *>(&source), sourceLen) :
+        setsockopt(sockFd_, SOL_SOCKET, SO_BINDTODEVICE, option_.source_.c_str(), option_.source_.size());
+    if (ret < 0) {
+        NETNATIVE_LOGE("Bind ping source failed, errno:%{public}d", errno);
+        return false;
+    }
+    return true;
+}
+
+bool NetDiagPingEngine::SendEcho(uint16_t seq)
+{
+    std::vector<uint8_t> packet(ICMP_HEADER_LEN + option_.dataSize_);
+    for (size_t i = ICMP_HEADER_LEN; i < packet.size(); i++) {
+        packet[i] = static_cast<uint8_t>(i & PAYLOAD_PATTERN_MASK);
+    }
+    // icmphdr and icmp6_hdr share the type/code/checksum/id/sequence layout
+    auto header = reinterpret_cast<struct icmphdr *>(packet.data());
+    header->type = (family_ == AF_INET) ? ICMP_ECHO : ICMP6_ECHO_REQUEST;
+    header->code = 0;
+    header->un.echo.id = htons(ident_);
+    header->un.echo.sequence = htons(seq);
+    header->checksum = 0;
+    if (family_ == AF_INET) {
+        header->checksum = IcmpChecksum(packet.data(), packet.size());
+    }
+    // The kernel stamps only the reply, so both ends of the RTT are taken from the same userspace clock
+    pendingEchos_[seq] = NowNs();
+    if (sendto(sockFd_, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr *>(&destAddr_), destAddrLen_) <
+        0) {
+        NETNATIVE_LOGE("Send echo request failed, errno:%{public}d", errno);
+        pendingEchos_.erase(seq);
+        return false;
+    }
+    return true;
+}
+
+void NetDiagPingEngine::ReceiveReplies(NetDiagPingResult &pingResult)
+{
+    std::vector<uint8_t> buffer(IPV4_MAX_HEADER_LEN + ICMP_HEADER_LEN + option_.dataSize_);
+    char control[CONTROL_BUFFER_SIZE];
+    while (true) {
+        sockaddr_storage from = {};
+        struct iovec iov = {.iov_base = buffer.data(), .iov_len = buffer.size()};
+        struct msghdr msg = {};
+        msg.msg_name = &from;
+        msg.msg_namelen = sizeof(from);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t len = recvmsg(sockFd_, &msg, MSG_DONTWAIT);
+        if (len <= 0) {
+            return;
+        }
+        int64_t recvTime = NowNs();
+        int32_t hopLimit = 0;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if ((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TTL) ||
+                (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_HOPLIMIT)) {
+                (void)memcpy_s(&hopLimit, sizeof(hopLimit), CMSG_DATA(cmsg), sizeof(hopLimit));
+            }
+        }
+        uint16_t seq = 0;
+        uint16_t icmpLen = 0;
+        uint16_t ttl = static_cast<uint16_t>(hopLimit);
+        if (!ParseReply(buffer.data(), static_cast<size_t>(len), seq, icmpLen, ttl)) {
+            continue;
+        }
+        auto it = pendingEchos_.find(seq);
+        if (it == pendingEchos_.end()) {
+            continue;
+        }
+        PingIcmpResponseInfo icmpRespInfo;
+        icmpRespInfo.bytes_ = icmpLen;
+        icmpRespInfo.from_ = SockAddrToString(from);
+        icmpRespInfo.icmpSeq_ = seq;
+        icmpRespInfo.ttl_ = ttl;
+        icmpRespInfo.costTime_ = static_cast<uint32_t>(std::max<int64_t>(recvTime - it->second, 0) / NS_PER_MS);
+        pendingEchos_.erase(it);
+        pingResult.icmpRespList_.push_back(icmpRespInfo);
+        pingResult.recvCount_++;
+    }
+}
+
+bool NetDiagPingEngine::ParseReply(const uint8_t *data, size_t len, uint16_t &seq, uint16_t &icmpLen, uint16_t &ttl)
+{
+    // Only raw IPv4 sockets hand out the IP header
+    if (isRawSocket_ && family_ == AF_INET) {
+        if (len < sizeof(struct iphdr)) {
+            return false;
+        }
+        auto ipHeader = reinterpret_cast<const struct iphdr *>(data);
+        size_t ipLen = ipHeader->ihl * IPV4_IHL_UNIT;
+        if (len < ipLen) {
+            return false;
+        }
+        ttl = ipHeader->ttl;
+        data += ipLen;
+        len -= ipLen;
+    }
+    if (len < ICMP_HEADER_LEN) {
+        return false;
+    }
+    auto header = reinterpret_cast<const struct icmphdr *>(data);
+    uint8_t replyType = (family_ == AF_INET) ? ICMP_ECHOREPLY : ICMP6_ECHO_REPLY;
+    if (header->type != replyType) {
+        return false;
+    }
+    // The kernel already demultiplexes datagram ICMP sockets by identifier
+    if (isRawSocket_ && ntohs(header->un.echo.id) != ident_) {
+        return false;
+    }
+    seq = ntohs(header->un.echo.sequence);
+    icmpLen = static_cast<uint16_t>(len);
+    return true;
+}
+
+void NetDiagPingEngine::CloseSocket()
+{
+    if (sockFd_ >= 0) {
+        close(sockFd_);
+        sockFd_ = -1;
+    }
+}
+} // namespace nmd
+} // namespace OHOS
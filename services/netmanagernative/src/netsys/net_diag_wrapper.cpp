@@ -14,6 +14,8 @@
  */
 
 #include "net_diag_wrapper.h"
+#include "net_diag_netlink_collector.h"
+#include "net_diag_ping_engine.h"
 #include "net_manager_constants.h"
 #include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
@@ -90,36 +92,58 @@ __attribute__((no_sanitize("cfi"))) NetDiagWrapper::~NetDiagWrapper() {}
 
 int32_t NetDiagWrapper::PingHost(const NetDiagPingOption &pingOption, const sptr<INetDiagCallback> &callback)
 {
-    NETNATIVE_LOGI("Generate ping command: ");
-    std::string command;
-    int32_t ret = GeneratePingCommand(pingOption, command);
-    if (ret != NETMANAGER_SUCCESS) {
-        return ret;
+    if (pingOption.destination_.empty()) {
+        NETNATIVE_LOGE("Ping destination is empty.");
+        return NETMANAGER_ERR_INVALID_PARAMETER;
     }
 
     auto wrapper = shared_from_this();
-    std::thread pingThread([wrapper, command, callback]() {
+    std::thread pingThread([wrapper, pingOption, callback]() {
         if (wrapper == nullptr) {
             NETNATIVE_LOGE("wrapper is nullptr");
             return;
         }
-        std::string result;
-        if (wrapper->ExecuteCommandForResult(command, result) != NETMANAGER_SUCCESS) {
-            return;
-        }
-        if (result.empty()) {
-            NETNATIVE_LOGE("Ping result is empty");
-            return;
-        }
-        wrapper->ExtractPingResult(result, callback);
+        wrapper->RunPing(pingOption, callback);
     });
     pthread_setname_np(pingThread.native_handle(), PING_THREAD_NAME);
     pingThread.detach();
     return NETMANAGER_SUCCESS;
 }
 
+void NetDiagWrapper::RunPing(const NetDiagPingOption &pingOption, const sptr<INetDiagCallback> &callback)
+{
+    NetDiagPingResult pingResult;
+    NetDiagPingEngine engine(pingOption);
+    if (engine.Run(pingResult) == NETMANAGER_SUCCESS) {
+        NotifyPingResult(pingResult, callback);
+        return;
+    }
+
+    NETNATIVE_LOGW("Ping engine unavailable, fall back to ping command");
+    std::string command;
+    if (GeneratePingCommand(pingOption, command) != NETMANAGER_SUCCESS) {
+        return;
+    }
+    std::string result;
+    if (ExecuteCommandForResult(command, result) != NETMANAGER_SUCCESS) {
+        return;
+    }
+    if (result.empty()) {
+        NETNATIVE_LOGE("Ping result is empty");
+        return;
+    }
+    ExtractPingResult(result, callback);
+}
+
 int32_t NetDiagWrapper::GetRouteTable(std::list<NetDiagRouteTable> &routeTables)
 {
+    NetDiagNetlinkCollector collector;
+    std::list<NetDiagRouteTable> dumpedRoutes;
+    if (collector.GetRouteTable(dumpedRoutes) == NETMANAGER_SUCCESS) {
+        routeTables.splice(routeTables.end(), dumpedRoutes);
+        return NETMANAGER_SUCCESS;
+    }
+    NETNATIVE_LOGW("Route dump failed, fall back to netstat");
     std::string command = std::string(NETSTAT_CMD_PATH) + OPTION_SPACE + NETSTAT_OPTION_ROUTE_TABLE;
     std::string result;
     int32_t ret = ExecuteCommandForResult(command, result);
@@ -142,6 +166,15 @@ int32_t NetDiagWrapper::GetRouteTable(std::list<NetDiagRouteTable> &routeTables)
 
 int32_t NetDiagWrapper::GetSocketsInfo(NetDiagProtocolType socketType, NetDiagSocketsInfo &socketsInfo)
 {
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo dumpedSockets;
+    if (collector.GetSocketsInfo(socketType, dumpedSockets) == NETMANAGER_SUCCESS) {
+        socketsInfo.unixSocketsInfo_.splice(socketsInfo.unixSocketsInfo_.end(), dumpedSockets.unixSocketsInfo_);
+        socketsInfo.netProtoSocketsInfo_.splice(socketsInfo.netProtoSocketsInfo_.end(),
+                                                dumpedSockets.netProtoSocketsInfo_);
+        return NETMANAGER_SUCCESS;
+    }
+    NETNATIVE_LOGW("Socket dump failed, fall back to netstat");
     std::string command = std::string(NETSTAT_CMD_PATH) + OPTION_SPACE;
     switch (socketType) {
         case PROTOCOL_TYPE_ALL:
@@ -190,6 +223,13 @@ int32_t NetDiagWrapper::GetSocketsInfo(NetDiagProtocolType socketType, NetDiagSo
 
 int32_t NetDiagWrapper::GetInterfaceConfig(std::list<NetDiagIfaceConfig> &configs, const std::string &ifaceName)
 {
+    NetDiagNetlinkCollector collector;
+    std::list<NetDiagIfaceConfig> dumpedConfigs;
+    if (collector.GetInterfaceConfig(dumpedConfigs, ifaceName) == NETMANAGER_SUCCESS) {
+        configs.splice(configs.end(), dumpedConfigs);
+        return NETMANAGER_SUCCESS;
+    }
+    NETNATIVE_LOGW("Link dump failed, fall back to ifconfig");
     std::string command = std::string(IFCONFIG_CMD_PATH) + OPTION_SPACE;
     command = command + (ifaceName.empty() ? IFCONFIG_OPTION_ALL_IFACE : ifaceName);
     std::string result;
@@ -390,7 +430,15 @@ void NetDiagWrapper::ExtractPingResult(const std::string &result, const sptr<INe
             break;
         }
     }
+    NotifyPingResult(pingResult, callback);
+}
 
+void NetDiagWrapper::NotifyPingResult(const NetDiagPingResult &pingResult, const sptr<INetDiagCallback> &callback)
+{
+    if (callback == nullptr) {
+        NETNATIVE_LOGE("PingHost callback is nullptr");
+        return;
+    }
     int32_t ret = callback->OnNotifyPingResult(pingResult);
     if (ret != NETMANAGER_SUCCESS) {
         NETNATIVE_LOGE("Notify ping result failed.");
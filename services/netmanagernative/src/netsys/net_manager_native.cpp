@@ -180,10 +180,10 @@ int32_t NetManagerNative::AddInterfaceAddress(std::string ifName, std::string ad
         auto mptcpManager = mptcpManager_;
         std::string addr = addrString;
         std::string iface = ifName;
-        if (mptcpFfrtQueue_ != nullptr && mptcpManager != nullptr) {
-            mptcpFfrtQueue_->submit([mptcpManager, addr, iface]() {
-                mptcpManager->OnInterfaceAddressUpdated(addr, iface);
-            });
+        if (mptcpFfrtQueue_ != nullptr && mptcpManager != nullptr &&
+            mptcpManager->QueueAddressChange(addr, iface, true)) {
+            // Changes queued until the flush runs go to the kernel with it in one batch
+            mptcpFfrtQueue_->submit([mptcpManager]() { mptcpManager->FlushAddressChanges(); });
         }
         return interfaceManager_->AddAddress(ifName.c_str(), addrString.c_str(), prefixLength);
     }
@@ -195,10 +195,10 @@ int32_t NetManagerNative::DelInterfaceAddress(std::string ifName, std::string ad
     auto mptcpManager = mptcpManager_;
     std::string addr = addrString;
     std::string iface = ifName;
-    if (mptcpFfrtQueue_ != nullptr && mptcpManager != nullptr) {
-        mptcpFfrtQueue_->submit([mptcpManager, addr, iface]() {
-            mptcpManager->OnInterfaceAddressRemoved(addr, iface);
-        });
+    if (mptcpFfrtQueue_ != nullptr && mptcpManager != nullptr &&
+        mptcpManager->QueueAddressChange(addr, iface, false)) {
+        // Changes queued until the flush runs go to the kernel with it in one batch
+        mptcpFfrtQueue_->submit([mptcpManager]() { mptcpManager->FlushAddressChanges(); });
     }
     return interfaceManager_->DelAddress(ifName.c_str(), addrString.c_str(), prefixLength);
 }
@@ -546,6 +546,18 @@ int32_t NetManagerNative::BandwidthRemoveAllowedList(uint32_t uid)
     return bandwidthManager_->RemoveAllowedList(uid);
 }
 
+int32_t NetManagerNative::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                  const std::vector<uint32_t> &allowedUids,
+                                                  const std::vector<uint32_t> &removedUids)
+{
+    return bandwidthManager_->UpdateUidLists(deniedUids, allowedUids, removedUids);
+}
+
+void NetManagerNative::BandwidthOnInterfaceChanged(const std::string &ifName, bool added)
+{
+    bandwidthManager_->OnInterfaceChanged(ifName, added);
+}
+
 int32_t NetManagerNative::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     auto chainType = static_cast<NetManagerStandard::ChainType>(chain);
@@ -594,6 +606,12 @@ int32_t NetManagerNative::SetFirewallCurrentUserId(int32_t userId)
     return dnsManager_->SetFirewallCurrentUserId(userId);
 }
 
+int32_t NetManagerNative::SetFirewallDefaultAction(int32_t userId, FirewallRuleAction outDefault)
+{
+    NETNATIVE_LOG_D("NetManagerNative, SetFirewallDefaultAction");
+    return dnsManager_->SetFirewallDefaultAction(userId, outDefault);
+}
+
 int32_t NetManagerNative::SetFirewallRules(NetFirewallRuleType type,
                                            const std::vector<sptr<NetFirewallBaseRule>> &ruleList, bool isFinish)
 {
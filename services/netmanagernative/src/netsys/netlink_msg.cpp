@@ -201,6 +201,31 @@ void NetlinkMsg::AddLink(uint16_t action, const struct ifinfomsg& msg)
     netlinkMessage_->nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(sizeof(struct ifinfomsg)));
 }
 
+void NetlinkMsg::AddTrafficControl(uint16_t action, const struct tcmsg& msg)
+{
+    netlinkMessage_->nlmsg_type = action;
+    size_t remainSize = maxBufLen_ > (NLMSG_ALIGN(netlinkMessage_->nlmsg_len) + RTA_LENGTH(0)) ?
+        (maxBufLen_ - (NLMSG_ALIGN(netlinkMessage_->nlmsg_len) + RTA_LENGTH(0))) : 0;
+    int32_t result = memcpy_s(NLMSG_DATA(netlinkMessage_), remainSize, &msg, sizeof(struct tcmsg));
+    if (result != 0) {
+        NETNATIVE_LOGE("[AddTrafficControl]: string copy failed result %{public}d", result);
+        return;
+    }
+    netlinkMessage_->nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(sizeof(struct tcmsg)));
+}
+
+void NetlinkMsg::AddGenl(uint16_t familyId, uint8_t cmd, uint8_t version)
+{
+    netlinkMessage_->nlmsg_type = familyId;
+    struct genlmsghdr genl = {.cmd = cmd, .version = version, .reserved = 0};
+    int32_t result = memcpy_s(NLMSG_DATA(netlinkMessage_), maxBufLen_, &genl, sizeof(struct genlmsghdr));
+    if (result != 0) {
+        NETNATIVE_LOGE("[AddGenl]: string copy failed result %{public}d", result);
+        return;
+    }
+    netlinkMessage_->nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(GENL_HDRLEN));
+}
+
 struct nlattr *NetlinkMsg::AddNestedStart(int type)
 {
     if (NLMSG_ALIGN(netlinkMessage_->nlmsg_len) + RTA_ALIGN(sizeof(struct nlattr)) > nmd::NETLINK_MAX_LEN) {
@@ -46,6 +46,8 @@ constexpr const uint32_t FAMILY_V4 = 1;
 constexpr const uint32_t FAMILY_V6 = 2;
 constexpr const char* ANCO_IFNAME = "anco";
 constexpr const char* RMNET_IFNAME = "rmnet";
+constexpr size_t ACK_RECV_BUFFER_SIZE = 32768;
+constexpr int32_t REQUEST_PENDING = 1;
 
 static ssize_t SendMsgToKernel(struct nlmsghdr *msg, int32_t &kernelSocket)
 {
@@ -155,6 +157,63 @@ int32_t SendNetlinkMsgsToKernel(std::vector<NetlinkMsg> &msgs)
     return msgState;
 }
 
+int32_t SendNetlinkMsgsAndWaitAcks(int32_t sock, uint32_t &seq, std::vector<NetlinkMsg> &msgs,
+    std::vector<int32_t> &errors, const std::function<void(const nlmsghdr *reply)> &handler)
+{
+    uint32_t firstSeq = seq + 1;
+    std::vector<iovec> iov;
+    iov.reserve(msgs.size());
+    for (auto &msg : msgs) {
+        nlmsghdr *hdr = msg.GetNetLinkMessage();
+        hdr->nlmsg_seq = ++seq;
+        iov.push_back({.iov_base = hdr, .iov_len = hdr->nlmsg_len});
+    }
+    sockaddr_nl kernel = {};
+    kernel.nl_family = AF_NETLINK;
+    msghdr message = {};
+    message.msg_name = &kernel;
+    message.msg_namelen = sizeof(kernel);
+    message.msg_iov = iov.data();
+    message.msg_iovlen = iov.size();
+    if (sendmsg(sock, &message, 0) < 0) {
+        NETNATIVE_LOGE("[SendNetlinkMsgsAndWaitAcks] sendmsg failed, errno: %{public}d", errno);
+        return -errno;
+    }
+
+    errors.assign(msgs.size(), REQUEST_PENDING);
+    size_t pending = msgs.size();
+    std::vector<char> buf(ACK_RECV_BUFFER_SIZE);
+    while (pending > 0) {
+        ssize_t len = recv(sock, buf.data(), buf.size(), 0);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            NETNATIVE_LOGE("[SendNetlinkMsgsAndWaitAcks] recv failed, errno: %{public}d", errno);
+            return len < 0 ? -errno : -EIO;
+        }
+        auto hdr = reinterpret_cast<nlmsghdr *>(buf.data());
+        for (int32_t left = static_cast<int32_t>(len); NLMSG_OK(hdr, left); hdr = NLMSG_NEXT(hdr, left)) {
+            size_t index = hdr->nlmsg_seq - firstSeq;
+            // Answers to an earlier batch that timed out are dropped
+            if (hdr->nlmsg_seq < firstSeq || index >= msgs.size() || errors[index] != REQUEST_PENDING) {
+                continue;
+            }
+            if (hdr->nlmsg_type == NLMSG_ERROR || hdr->nlmsg_type == NLMSG_DONE) {
+                int32_t error = 0;
+                if (hdr->nlmsg_len >= NLMSG_LENGTH(sizeof(error))) {
+                    (void)memcpy_s(&error, sizeof(error), NLMSG_DATA(hdr), sizeof(error));
+                }
+                errors[index] = error;
+                pending--;
+            } else if (handler != nullptr) {
+                handler(hdr);
+            }
+        }
+    }
+    return 0;
+}
+
 #ifdef SUPPORT_SYSVPN
 static void AddAttribute(struct nlmsghdr *msghdr, int type, const void *data, size_t len)
 {
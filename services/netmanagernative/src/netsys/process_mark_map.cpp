@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "process_mark_map.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "bpf_def.h"
+#include "bpf_mapper.h"
+#include "bpf_path.h"
+#include "fwmark.h"
+#include "net_manager_constants.h"
+#include "netnative_log_wrapper.h"
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+
+namespace OHOS {
+namespace nmd {
+using namespace NetManagerStandard;
+namespace {
+constexpr uint16_t NETID_UNSET = 0;
+constexpr int32_t MAX_WATCH_EVENTS = 16;
+// The wake eventfd is told apart from the pidfds by a pid no process has
+constexpr uint64_t WAKE_EVENT_DATA = 0;
+
+int32_t PidFdOpen(pid_t pid)
+{
+    return static_cast<int32_t>(syscall(__NR_pidfd_open, pid, 0));
+}
+
+bool HasExited(int32_t pidFd)
+{
+    pollfd fd = {.fd = pidFd, .events = POLLIN, .revents = 0};
+    return poll(&fd, 1, 0) > 0;
+}
+} // namespace
+
+ProcessMarkMap &ProcessMarkMap::GetInstance()
+{
+    static ProcessMarkMap instance;
+    return instance;
+}
+
+ProcessMarkMap::ProcessMarkMap()
+{
+    // The map stays pinned across a netsys restart, the processes in it are not watched any more
+    BpfMapper<process_sock_mark_key, process_sock_mark_value> map(PROCESS_SOCK_MARK_MAP_PATH, BPF_ANY);
+    if (map.IsValid() && map.Clear(map.GetAllKeys()) != 0) {
+        NETNATIVE_LOGE("ProcessMarkMap: clear map failed, errno: %{public}d", errno);
+    }
+    if (!StartWatch()) {
+        NETNATIVE_LOGE("ProcessMarkMap: start watch failed, errno: %{public}d", errno);
+    }
+}
+
+ProcessMarkMap::~ProcessMarkMap()
+{
+    if (watchThread_.joinable()) {
+        uint64_t wake = 1;
+        if (write(wakeFd_, &wake, sizeof(wake)) == sizeof(wake)) {
+            watchThread_.join();
+        } else {
+            watchThread_.detach();
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &[pid, mark] : processes_) {
+        close(mark.pidFd);
+    }
+    processes_.clear();
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+}
+
+bool ProcessMarkMap::StartWatch()
+{
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        return false;
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = WAKE_EVENT_DATA;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev) != 0) {
+        return false;
+    }
+    watchThread_ = std::thread([this]() { WatchLoop(); });
+    pthread_setname_np(watchThread_.native_handle(), "FwmarkPidWatch");
+    return true;
+}
+
+int32_t ProcessMarkMap::Apply(pid_t pid, uid_t uid, const FwmarkCommand &command)
+{
+    if (pid <= 0 ||
+        (command.cmdId != FwmarkCommand::SELECT_PROCESS_NETWORK &&
+         command.cmdId != FwmarkCommand::PROTECT_PROCESS_FROM_VPN)) {
+        return NETMANAGER_ERROR;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!watchThread_.joinable()) {
+        return NETMANAGER_ERROR;
+    }
+    auto it = processes_.find(pid);
+    if (it != processes_.end() && (it->second.uid != uid || HasExited(it->second.pidFd))) {
+        // The pid was reused before the exit of its last owner was handled
+        RemoveLocked(pid);
+        it = processes_.end();
+    }
+    if (it == processes_.end()) {
+        ProcessMark mark;
+        mark.uid = uid;
+        mark.pidFd = PidFdOpen(pid);
+        if (mark.pidFd < 0) {
+            NETNATIVE_LOGE("ProcessMarkMap: pidfd_open %{public}d failed, errno: %{public}d", pid, errno);
+            return NETMANAGER_ERROR;
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = static_cast<uint64_t>(pid);
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, mark.pidFd, &ev) != 0) {
+            NETNATIVE_LOGE("ProcessMarkMap: watch %{public}d failed, errno: %{public}d", pid, errno);
+            close(mark.pidFd);
+            return NETMANAGER_ERROR;
+        }
+        it = processes_.emplace(pid, mark).first;
+    }
+
+    ProcessMark mark = it->second;
+    if (command.cmdId == FwmarkCommand::SELECT_PROCESS_NETWORK) {
+        mark.netId = static_cast<uint16_t>(command.netId);
+    } else {
+        mark.protectedFromVpn = true;
+    }
+    if (ToFwmark(mark) == 0) {
+        RemoveLocked(pid);
+        return NETMANAGER_SUCCESS;
+    }
+    if (!WriteMark(pid, mark)) {
+        RemoveLocked(pid);
+        return NETMANAGER_ERROR;
+    }
+    it->second = mark;
+    NETNATIVE_LOG_D("ProcessMarkMap: pid %{public}d netId %{public}u protect %{public}d", pid, mark.netId,
+                    mark.protectedFromVpn);
+    return NETMANAGER_SUCCESS;
+}
+
+void ProcessMarkMap::Remove(pid_t pid)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    RemoveLocked(pid);
+}
+
+// Same bits as SetMark gives the sockets sent to fwmarkd one at a time
+uint32_t ProcessMarkMap::ToFwmark(const ProcessMark &mark)
+{
+    Fwmark fwmark;
+    if (mark.netId != NETID_UNSET) {
+        fwmark.netId = mark.netId;
+        fwmark.explicitlySelected = true;
+        fwmark.protectedFromVpn = true;
+    } else {
+        fwmark.protectedFromVpn = mark.protectedFromVpn;
+    }
+    return fwmark.intValue;
+}
+
+bool ProcessMarkMap::WriteMark(pid_t pid, const ProcessMark &mark)
+{
+    BpfMapper<process_sock_mark_key, process_sock_mark_value> map(PROCESS_SOCK_MARK_MAP_PATH, BPF_ANY);
+    if (!map.IsValid()) {
+        return false;
+    }
+    process_sock_mark_value value = {.uid = static_cast<__u32>(mark.uid), .mark = ToFwmark(mark)};
+    if (map.Write(static_cast<process_sock_mark_key>(pid), value, BPF_ANY) != 0) {
+        NETNATIVE_LOGE("ProcessMarkMap: write %{public}d failed, errno: %{public}d", pid, errno);
+        return false;
+    }
+    return true;
+}
+
+void ProcessMarkMap::RemoveLocked(pid_t pid)
+{
+    auto it = processes_.find(pid);
+    if (it == processes_.end()) {
+        return;
+    }
+    BpfMapper<process_sock_mark_key, process_sock_mark_value> map(PROCESS_SOCK_MARK_MAP_PATH, BPF_ANY);
+    if (map.IsValid() && map.Delete(static_cast<process_sock_mark_key>(pid)) != 0 && errno != ENOENT) {
+        NETNATIVE_LOGE("ProcessMarkMap: delete %{public}d failed, errno: %{public}d", pid, errno);
+    }
+    // Closing the pidfd takes it out of the epoll set as well
+    close(it->second.pidFd);
+    processes_.erase(it);
+}
+
+void ProcessMarkMap::WatchLoop()
+{
+    epoll_event events[MAX_WATCH_EVENTS] = {};
+    while (true) {
+        int32_t num = epoll_wait(epollFd_, events, MAX_WATCH_EVENTS, -1);
+        if (num < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num < 0) {
+            NETNATIVE_LOGE("ProcessMarkMap: epoll_wait failed, errno: %{public}d", errno);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int32_t i = 0; i < num; i++) {
+            if (events[i].data.u64 == WAKE_EVENT_DATA) {
+                return;
+            }
+            auto pid = static_cast<pid_t>(events[i].data.u64);
+            auto it = processes_.find(pid);
+            // A pid registered again after this event was read has a fresh pidfd that has not fired
+            if (it != processes_.end() && HasExited(it->second.pidFd)) {
+                RemoveLocked(pid);
+            }
+        }
+    }
+}
+} // namespace nmd
+} // namespace OHOS
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rtnetlink_link.h"
+
+#include <algorithm>
+#include <cstring>
+#include <linux/rtnetlink.h>
+
+#include "securec.h"
+
+namespace OHOS {
+namespace nmd {
+namespace {
+constexpr size_t MAC_LEN = 6;
+constexpr size_t MAC_STR_LEN = 18;
+} // namespace
+
+bool ParseRtnetlinkLink(const nlmsghdr *hdr, RtnetlinkLink &link)
+{
+    if (hdr == nullptr || (hdr->nlmsg_type != RTM_NEWLINK && hdr->nlmsg_type != RTM_DELLINK) ||
+        hdr->nlmsg_len < NLMSG_LENGTH(sizeof(ifinfomsg))) {
+        return false;
+    }
+    auto info = reinterpret_cast<const ifinfomsg *>(NLMSG_DATA(hdr));
+    link.index = info->ifi_index;
+    link.family = info->ifi_family;
+    link.type = info->ifi_type;
+    link.flags = info->ifi_flags;
+    int32_t len = static_cast<int32_t>(IFLA_PAYLOAD(hdr));
+    for (auto attr = IFLA_RTA(info); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+        auto data = reinterpret_cast<const char *>(RTA_DATA(attr));
+        size_t payload = RTA_PAYLOAD(attr);
+        switch (attr->rta_type) {
+            case IFLA_IFNAME:
+                link.name.assign(data, strnlen(data, payload));
+                break;
+            case IFLA_MTU:
+                if (payload >= sizeof(link.mtu)) {
+                    (void)memcpy_s(&link.mtu, sizeof(link.mtu), data, sizeof(link.mtu));
+                }
+                break;
+            case IFLA_TXQLEN:
+                if (payload >= sizeof(link.txQueueLen)) {
+                    (void)memcpy_s(&link.txQueueLen, sizeof(link.txQueueLen), data, sizeof(link.txQueueLen));
+                }
+                break;
+            case IFLA_ADDRESS:
+                link.hwAddr.assign(data, data + payload);
+                break;
+            case IFLA_STATS64:
+                // The struct grows with the uapi headers, a kernel older than them sends a shorter one
+                (void)memcpy_s(&link.stats, sizeof(link.stats), data, std::min(payload, sizeof(link.stats)));
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+std::string HwAddrToString(const std::vector<uint8_t> &hwAddr)
+{
+    uint8_t mac[MAC_LEN] = {0};
+    if (!hwAddr.empty()) {
+        (void)memcpy_s(mac, sizeof(mac), hwAddr.data(), std::min(hwAddr.size(), sizeof(mac)));
+    }
+    char buf[MAC_STR_LEN] = {0};
+    if (snprintf_s(buf, sizeof(buf), sizeof(buf) - 1, "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2],
+                   mac[3], mac[4], mac[5]) < 0) {
+        return {};
+    }
+    return buf;
+}
+} // namespace nmd
+} // namespace OHOS
@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2026 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rtnetlink_transaction.h"
+
+#include <cerrno>
+#include <linux/neighbour.h>
+#include <linux/veth.h>
+#include <net/if.h>
+#include <sys/time.h>
+
+#include "netlink_socket.h"
+#include "netnative_log_wrapper.h"
+#include "securec.h"
+
+namespace OHOS {
+namespace nmd {
+namespace {
+constexpr const char *VETH_KIND = "veth";
+constexpr const char *DUMMY_KIND = "dummy";
+constexpr const char *VLAN_KIND = "vlan";
+constexpr int32_t RECV_TIMEOUT_SEC = 3;
+constexpr uint8_t BITS_PER_BYTE = 8;
+constexpr size_t MAC_ADDR_LEN = 6;
+constexpr int32_t HEX_BASE = 16;
+
+struct IpAddr {
+    uint8_t family = AF_UNSPEC;
+    uint8_t data[sizeof(in6_addr)] = {0};
+    size_t len = 0;
+};
+
+bool ParseIpAddr(const std::string &str, IpAddr &addr)
+{
+    if (inet_pton(AF_INET, str.c_str(), addr.data) == 1) {
+        addr.family = AF_INET;
+        addr.len = sizeof(in_addr);
+        return true;
+    }
+    if (inet_pton(AF_INET6, str.c_str(), addr.data) == 1) {
+        addr.family = AF_INET6;
+        addr.len = sizeof(in6_addr);
+        return true;
+    }
+    return false;
+}
+
+bool ParseMac(const std::string &str, uint8_t (&mac)[MAC_ADDR_LEN])
+{
+    const char *pos = str.c_str();
+    for (size_t i = 0; i < MAC_ADDR_LEN; i++) {
+        char *end = nullptr;
+        unsigned long byte = strtoul(pos, &end, HEX_BASE);
+        char expected = (i + 1 < MAC_ADDR_LEN) ? ':' : '\0';
+        if (end == pos || end - pos > 2 || *end != expected || byte > UINT8_MAX) {
+            return false;
+        }
+        mac[i] = static_cast<uint8_t>(byte);
+        pos = end + 1;
+    }
+    return true;
+}
+
+bool IsValidIfName(const std::string &ifName)
+{
+    return !ifName.empty() && ifName.length() < IFNAMSIZ;
+}
+
+bool AddIfName(NetlinkMsg &msg, const std::string &ifName)
+{
+    return msg.AddAttr(IFLA_IFNAME, const_cast<char *>(ifName.c_str()), ifName.length() + 1) == 0;
+}
+
+bool AddIpAddr(NetlinkMsg &msg, uint16_t type, const IpAddr &addr)
+{
+    return msg.AddAttr(type, const_cast<uint8_t *>(addr.data), addr.len) == 0;
+}
+
+// Raw bytes inside a nested attribute, like the ifinfomsg of a veth peer
+bool AddPayload(NetlinkMsg &msg, const void *data, size_t len)
+{
+    nlmsghdr *hdr = msg.GetNetLinkMessage();
+    size_t offset = NLMSG_ALIGN(hdr->nlmsg_len);
+    if (offset + NLMSG_ALIGN(len) > NETLINK_MAX_LEN ||
+        memcpy_s(reinterpret_cast<char *>(hdr) + offset, NETLINK_MAX_LEN - offset, data, len) != 0) {
+        return false;
+    }
+    hdr->nlmsg_len = static_cast<uint32_t>(offset + NLMSG_ALIGN(len));
+    return true;
+}
+} // namespace
+
+RtnetlinkTransaction::RtnetlinkTransaction() {}
+
+RtnetlinkTransaction::~RtnetlinkTransaction()
+{
+    if (socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddVethPair(const std::string &ifName, const std::string &peerName)
+{
+    if (!IsValidIfName(peerName)) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid veth peer name");
+        malformed_ = true;
+        return *this;
+    }
+    return AddLinkRequest(ifName, VETH_KIND, [peerName](NetlinkMsg &msg) {
+        nlattr *peer = msg.AddNestedStart(VETH_INFO_PEER);
+        ifinfomsg ifm = {};
+        ifm.ifi_family = AF_UNSPEC;
+        bool ret = peer != nullptr && AddPayload(msg, &ifm, sizeof(ifm)) && AddIfName(msg, peerName);
+        msg.AddNestedEnd(peer);
+        return ret;
+    });
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddDummyLink(const std::string &ifName)
+{
+    return AddLinkRequest(ifName, DUMMY_KIND, nullptr);
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddVlanLink(const std::string &ifName, const std::string &parentName,
+                                                        uint16_t vlanId)
+{
+    if (!IsValidIfName(parentName)) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid vlan parent name");
+        malformed_ = true;
+        return *this;
+    }
+    return AddLinkRequest(
+        ifName, VLAN_KIND, [vlanId](NetlinkMsg &msg) { return msg.AddAttr16(IFLA_VLAN_ID, vlanId) == 0; },
+        parentName);
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddLinkRequest(const std::string &ifName, const std::string &kind,
+                                                           const MsgBuilder &buildInfo, const std::string &parentName)
+{
+    if (!IsValidIfName(ifName)) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid link name");
+        malformed_ = true;
+        return *this;
+    }
+    Request request;
+    request.desc = "add " + kind + " " + ifName;
+    request.createsLink = true;
+    request.flags = NLM_F_CREATE | NLM_F_EXCL;
+    request.build = [ifName, kind, buildInfo, parentName](NetlinkMsg &msg) {
+        ifinfomsg ifm = {};
+        ifm.ifi_family = AF_UNSPEC;
+        msg.AddLink(RTM_NEWLINK, ifm);
+        if (!parentName.empty()) {
+            uint32_t parent = if_nametoindex(parentName.c_str());
+            if (parent == 0 || msg.AddAttr32(IFLA_LINK, parent) != 0) {
+                return false;
+            }
+        }
+        nlattr *linkInfo = AddIfName(msg, ifName) ? msg.AddNestedStart(IFLA_LINKINFO) : nullptr;
+        if (linkInfo == nullptr ||
+            msg.AddAttr(IFLA_INFO_KIND, const_cast<char *>(kind.c_str()), kind.length() + 1) != 0) {
+            return false;
+        }
+        bool ret = true;
+        if (buildInfo != nullptr) {
+            nlattr *infoData = msg.AddNestedStart(IFLA_INFO_DATA);
+            ret = infoData != nullptr && buildInfo(msg);
+            msg.AddNestedEnd(infoData);
+        }
+        msg.AddNestedEnd(linkInfo);
+        return ret;
+    };
+    request.buildUndo = [ifName](NetlinkMsg &msg) {
+        ifinfomsg ifm = {};
+        ifm.ifi_family = AF_UNSPEC;
+        msg.AddLink(RTM_DELLINK, ifm);
+        return AddIfName(msg, ifName);
+    };
+    requests_.push_back(std::move(request));
+    return *this;
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::SetLinkUp(const std::string &ifName, bool up)
+{
+    Request request;
+    request.desc = "set " + ifName + (up ? " up" : " down");
+    request.build = [ifName, up](NetlinkMsg &msg) {
+        uint32_t index = if_nametoindex(ifName.c_str());
+        ifinfomsg ifm = {};
+        ifm.ifi_family = AF_UNSPEC;
+        ifm.ifi_index = static_cast<int32_t>(index);
+        ifm.ifi_flags = up ? IFF_UP : 0;
+        ifm.ifi_change = IFF_UP;
+        msg.AddLink(RTM_NEWLINK, ifm);
+        return index != 0;
+    };
+    requests_.push_back(std::move(request));
+    return *this;
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::DeleteLink(const std::string &ifName)
+{
+    if (!IsValidIfName(ifName)) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid link name");
+        malformed_ = true;
+        return *this;
+    }
+    Request request;
+    request.desc = "delete " + ifName;
+    request.build = [ifName](NetlinkMsg &msg) {
+        ifinfomsg ifm = {};
+        ifm.ifi_family = AF_UNSPEC;
+        msg.AddLink(RTM_DELLINK, ifm);
+        return AddIfName(msg, ifName);
+    };
+    requests_.push_back(std::move(request));
+    return *this;
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddAddress(const std::string &ifName, const std::string &addr,
+                                                       uint8_t prefixLen)
+{
+    IpAddr ip;
+    if (!ParseIpAddr(addr, ip) || prefixLen > ip.len * BITS_PER_BYTE) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid address for %{public}s", ifName.c_str());
+        malformed_ = true;
+        return *this;
+    }
+    auto builder = [ifName, ip, prefixLen](uint16_t action) {
+        return [ifName, ip, prefixLen, action](NetlinkMsg &msg) {
+            ifaddrmsg ifa = {};
+            ifa.ifa_family = ip.family;
+            ifa.ifa_prefixlen = prefixLen;
+            ifa.ifa_index = if_nametoindex(ifName.c_str());
+            msg.AddAddress(action, ifa);
+            return ifa.ifa_index != 0 && AddIpAddr(msg, IFA_LOCAL, ip) && AddIpAddr(msg, IFA_ADDRESS, ip);
+        };
+    };
+    Request request;
+    request.desc = "add address to " + ifName;
+    request.flags = NLM_F_CREATE | NLM_F_EXCL;
+    request.build = builder(RTM_NEWADDR);
+    request.buildUndo = builder(RTM_DELADDR);
+    requests_.push_back(std::move(request));
+    return *this;
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddNeighbor(const std::string &ifName, const std::string &addr,
+                                                        const std::string &mac)
+{
+    IpAddr ip;
+    uint8_t lladdr[MAC_ADDR_LEN] = {0};
+    if (!ParseIpAddr(addr, ip) || !ParseMac(mac, lladdr)) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid neighbor for %{public}s", ifName.c_str());
+        malformed_ = true;
+        return *this;
+    }
+    std::vector<uint8_t> macBytes(lladdr, lladdr + MAC_ADDR_LEN);
+    auto builder = [ifName, ip, macBytes](uint16_t action) {
+        return [ifName, ip, macBytes, action](NetlinkMsg &msg) {
+            ndmsg ndm = {};
+            ndm.ndm_family = ip.family;
+            ndm.ndm_ifindex = static_cast<int32_t>(if_nametoindex(ifName.c_str()));
+            ndm.ndm_state = NUD_PERMANENT;
+            msg.AddNeighbor(action, ndm);
+            if (ndm.ndm_ifindex == 0 || !AddIpAddr(msg, NDA_DST, ip)) {
+                return false;
+            }
+            return action == RTM_DELNEIGH ||
+                msg.AddAttr(NDA_LLADDR, const_cast<uint8_t *>(macBytes.data()), macBytes.size()) == 0;
+        };
+    };
+    Request request;
+    request.desc = "add neighbor to " + ifName;
+    request.flags = NLM_F_CREATE | NLM_F_EXCL;
+    request.build = builder(RTM_NEWNEIGH);
+    request.buildUndo = builder(RTM_DELNEIGH);
+    requests_.push_back(std::move(request));
+    return *this;
+}
+
+RtnetlinkTransaction &RtnetlinkTransaction::AddRoute(const std::string &ifName, const std::string &destination,
+                                                     uint8_t prefixLen, const std::string &nextHop, uint32_t table)
+{
+    IpAddr dst;
+    IpAddr gw;
+    if (!ParseIpAddr(destination, dst) || prefixLen > dst.len * BITS_PER_BYTE ||
+        (!nextHop.empty() && (!ParseIpAddr(nextHop, gw) || gw.family != dst.family))) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: invalid route for %{public}s", ifName.c_str());
+        malformed_ = true;
+        return *this;
+    }
+    auto builder = [ifName, dst, prefixLen, gw, table](uint16_t action) {
+        return [ifName, dst, prefixLen, gw, table, action](NetlinkMsg &msg) {
+            uint32_t index = if_nametoindex(ifName.c_str());
+            rtmsg rtm = {};
+            rtm.rtm_family = dst.family;
+            rtm.rtm_dst_len = prefixLen;
+            rtm.rtm_table = RT_TABLE_UNSPEC;
+            rtm.rtm_protocol = RTPROT_STATIC;
+            rtm.rtm_scope = gw.len > 0 ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK;
+            rtm.rtm_type = RTN_UNICAST;
+            msg.AddRoute(action, rtm);
+            if (index == 0 || msg.AddAttr32(RTA_TABLE, table) != 0 || msg.AddAttr32(RTA_OIF, index) != 0) {
+                return false;
+            }
+            return (prefixLen == 0 || AddIpAddr(msg, RTA_DST, dst)) &&
+                (gw.len == 0 || AddIpAddr(msg, RTA_GATEWAY, gw));
+        };
+    };
+    Request request;
+    request.desc = "add route to " + ifName;
+    request.flags = NLM_F_CREATE | NLM_F_EXCL;
+    request.build = builder(RTM_NEWROUTE);
+    request.buildUndo = builder(RTM_DELROUTE);
+    requests_.push_back(std::move(request));
+    return *this;
+}
+
+int32_t RtnetlinkTransaction::Commit()
+{
+    std::vector<Request> requests;
+    requests.swap(requests_);
+    bool malformed = malformed_;
+    malformed_ = false;
+    if (malformed) {
+        return -EINVAL;
+    }
+    if (requests.empty()) {
+        return 0;
+    }
+    if (socket_ < 0) {
+        socket_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (socket_ < 0) {
+            NETNATIVE_LOGE("RtnetlinkTransaction: create socket failed, errno: %{public}d", errno);
+            return -errno;
+        }
+        timeval timeout = {.tv_sec = RECV_TIMEOUT_SEC, .tv_usec = 0};
+        int32_t on = 1;
+        (void)setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        (void)setsockopt(socket_, SOL_NETLINK, NETLINK_CAP_ACK, &on, sizeof(on));
+    }
+
+    // The other requests find their links by index, which the kernel only gives when the link is created
+    std::vector<const Request *> links;
+    std::vector<const Request *> others;
+    for (const auto &request : requests) {
+        (request.createsLink ? links : others).push_back(&request);
+    }
+    std::vector<const Request *> done;
+    int32_t ret = Apply(links, done);
+    if (ret == 0) {
+        ret = Apply(others, done);
+    }
+    if (ret != 0) {
+        Rollback(done);
+    }
+    return ret;
+}
+
+int32_t RtnetlinkTransaction::Apply(const std::vector<const Request *> &requests,
+                                    std::vector<const Request *> &done)
+{
+    if (requests.empty()) {
+        return 0;
+    }
+    std::vector<NetlinkMsg> msgs;
+    msgs.reserve(requests.size());
+    for (const Request *request : requests) {
+        NetlinkMsg msg(request->flags, NETLINK_MAX_LEN, 0);
+        if (!request->build(msg)) {
+            NETNATIVE_LOGE("RtnetlinkTransaction: %{public}s, link not found", request->desc.c_str());
+            return -ENODEV;
+        }
+        msgs.push_back(std::move(msg));
+    }
+    std::vector<int32_t> errors;
+    int32_t ret = SendNetlinkMsgsAndWaitAcks(socket_, seq_, msgs, errors);
+    if (ret != 0) {
+        return ret;
+    }
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (errors[i] == 0) {
+            done.push_back(requests[i]);
+            continue;
+        }
+        NETNATIVE_LOGE("RtnetlinkTransaction: %{public}s failed, error: %{public}d", requests[i]->desc.c_str(),
+                       errors[i]);
+        if (ret == 0) {
+            ret = errors[i];
+        }
+    }
+    return ret;
+}
+
+// Removes what the applied requests created, the latest first so addresses go before their links
+void RtnetlinkTransaction::Rollback(const std::vector<const Request *> &done)
+{
+    std::vector<NetlinkMsg> msgs;
+    for (auto it = done.rbegin(); it != done.rend(); ++it) {
+        if ((*it)->buildUndo == nullptr) {
+            continue;
+        }
+        NetlinkMsg msg(0, NETLINK_MAX_LEN, 0);
+        if ((*it)->buildUndo(msg)) {
+            msgs.push_back(std::move(msg));
+        }
+    }
+    if (msgs.empty()) {
+        return;
+    }
+    std::vector<int32_t> errors;
+    if (SendNetlinkMsgsAndWaitAcks(socket_, seq_, msgs, errors) != 0) {
+        NETNATIVE_LOGE("RtnetlinkTransaction: rollback failed");
+        return;
+    }
+    for (int32_t error : errors) {
+        if (error != 0) {
+            NETNATIVE_LOGW("RtnetlinkTransaction: rollback request failed, error: %{public}d", error);
+        }
+    }
+}
+} // namespace nmd
+} // namespace OHOS
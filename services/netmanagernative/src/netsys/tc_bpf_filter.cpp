@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tc_bpf_filter.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/pkt_cls.h>
+#include <linux/pkt_sched.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "net_manager_constants.h"
+#include "netlink_msg.h"
+#include "netlink_socket.h"
+#include "netnative_log_wrapper.h"
+
+namespace OHOS {
+namespace nmd {
+using namespace NetManagerStandard;
+
+namespace {
+constexpr const char *CLSACT_QDISC_KIND = "clsact";
+constexpr const char *BPF_FILTER_KIND = "bpf";
+constexpr uint32_t BPF_FILTER_HANDLE = 1;
+constexpr uint32_t TC_PRIO_SHIFT = 16;
+constexpr int32_t ACK_RECV_TIMEOUT_SEC = 1;
+
+int32_t GetPinnedProgFd(const std::string &progPath)
+{
+    bpf_attr attr = {};
+    attr.pathname = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(progPath.c_str()));
+    return static_cast<int32_t>(syscall(__NR_bpf, BPF_OBJ_GET, &attr, sizeof(attr)));
+}
+
+tcmsg MakeTcMsg(uint32_t ifIndex, uint32_t handle, uint32_t parent, uint32_t info)
+{
+    tcmsg tcm = {};
+    tcm.tcm_family = AF_UNSPEC;
+    tcm.tcm_ifindex = static_cast<int32_t>(ifIndex);
+    tcm.tcm_handle = handle;
+    tcm.tcm_parent = parent;
+    tcm.tcm_info = info;
+    return tcm;
+}
+
+uint32_t MakeFilterInfo(uint16_t prio)
+{
+    return TC_H_MAKE(static_cast<uint32_t>(prio) << TC_PRIO_SHIFT, htons(ETH_P_ALL));
+}
+
+// Returns 0 once the kernel acks the request, or the negative errno it rejects it with
+int32_t SendTcRequest(NetlinkMsg &msg)
+{
+    int32_t sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (sock < 0) {
+        return -errno;
+    }
+    timeval timeout = {.tv_sec = ACK_RECV_TIMEOUT_SEC, .tv_usec = 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::vector<NetlinkMsg> msgs;
+    msgs.push_back(std::move(msg));
+    std::vector<int32_t> errors;
+    uint32_t seq = 0;
+    int32_t ret = SendNetlinkMsgsAndWaitAcks(sock, seq, msgs, errors);
+    close(sock);
+    return ret != 0 ? ret : errors.front();
+}
+
+int32_t AddClsactQdisc(uint32_t ifIndex)
+{
+    NetlinkMsg msg(NLM_F_CREATE | NLM_F_EXCL, NETLINK_MAX_LEN, 0);
+    msg.AddTrafficControl(RTM_NEWQDISC, MakeTcMsg(ifIndex, TC_H_MAKE(TC_H_CLSACT, 0), TC_H_CLSACT, 0));
+    msg.AddAttr(TCA_KIND, const_cast<char *>(CLSACT_QDISC_KIND), strlen(CLSACT_QDISC_KIND) + 1);
+    int32_t ret = SendTcRequest(msg);
+    return ret == -EEXIST ? 0 : ret;
+}
+} // namespace
+
+int32_t AttachTcEgressBpf(uint32_t ifIndex, const std::string &progPath, uint16_t prio)
+{
+    int32_t ret = AddClsactQdisc(ifIndex);
+    if (ret != 0) {
+        NETNATIVE_LOGE("AttachTcEgressBpf: add clsact to %{public}u failed, error=%{public}d", ifIndex, ret);
+        return NETMANAGER_ERROR;
+    }
+    int32_t progFd = GetPinnedProgFd(progPath);
+    if (progFd < 0) {
+        NETNATIVE_LOGE("AttachTcEgressBpf: get %{public}s failed, errno=%{public}d", progPath.c_str(), errno);
+        return NETMANAGER_ERROR;
+    }
+    std::string progName = progPath.substr(progPath.find_last_of('/') + 1);
+    uint32_t fd = static_cast<uint32_t>(progFd);
+    uint32_t flags = TCA_BPF_FLAG_ACT_DIRECT;
+    NetlinkMsg msg(NLM_F_CREATE | NLM_F_REPLACE, NETLINK_MAX_LEN, 0);
+    msg.AddTrafficControl(RTM_NEWTFILTER, MakeTcMsg(ifIndex, BPF_FILTER_HANDLE,
+                                                    TC_H_MAKE(TC_H_CLSACT, TC_H_MIN_EGRESS), MakeFilterInfo(prio)));
+    msg.AddAttr(TCA_KIND, const_cast<char *>(BPF_FILTER_KIND), strlen(BPF_FILTER_KIND) + 1);
+    nlattr *options = msg.AddNestedStart(TCA_OPTIONS);
+    msg.AddAttr(TCA_BPF_FD, &fd, sizeof(fd));
+    msg.AddAttr(TCA_BPF_NAME, progName.data(), progName.size() + 1);
+    msg.AddAttr(TCA_BPF_FLAGS, &flags, sizeof(flags));
+    msg.AddNestedEnd(options);
+    ret = SendTcRequest(msg);
+    close(progFd);
+    if (ret != 0) {
+        NETNATIVE_LOGE("AttachTcEgressBpf: attach %{public}s to %{public}u failed, error=%{public}d",
+                       progName.c_str(), ifIndex, ret);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
+
+int32_t DetachTcEgressBpf(uint32_t ifIndex, uint16_t prio)
+{
+    NetlinkMsg msg(0, NETLINK_MAX_LEN, 0);
+    msg.AddTrafficControl(RTM_DELTFILTER,
+                          MakeTcMsg(ifIndex, 0, TC_H_MAKE(TC_H_CLSACT, TC_H_MIN_EGRESS), MakeFilterInfo(prio)));
+    int32_t ret = SendTcRequest(msg);
+    // Gone with the iface, or with its clsact qdisc
+    if (ret != 0 && ret != -ENOENT && ret != -ENODEV && ret != -EINVAL) {
+        NETNATIVE_LOGE("DetachTcEgressBpf: detach from %{public}u failed, error=%{public}d", ifIndex, ret);
+        return NETMANAGER_ERROR;
+    }
+    return NETMANAGER_SUCCESS;
+}
+} // namespace nmd
+} // namespace OHOS
@@ -15,10 +15,12 @@
 
 #include "data_receiver.h"
 
+#include <linux/netlink.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "interface_inventory.h"
 #include "netlink_define.h"
 #include "netnative_log_wrapper.h"
 #include "wrapper_decoder.h"
@@ -28,6 +30,9 @@ namespace nmd {
 using namespace NetlinkDefine;
 DataReceiver::DataReceiver(int32_t socketFd, int32_t format) : socket_(socketFd), format_(format)
 {
+    int32_t protocol = -1;
+    socklen_t len = sizeof(protocol);
+    isRouteSocket_ = getsockopt(socketFd, SOL_SOCKET, SO_PROTOCOL, &protocol, &len) == 0 && protocol == NETLINK_ROUTE;
     listener_ = std::make_unique<WrapperListener>(socketFd, [this](int32_t socket) { this->StartReceive(socket); });
 }
 
@@ -54,8 +59,15 @@ void DataReceiver::StartReceive(int32_t socket)
     bool isRepair = format_ == NETLINK_FORMAT_BINARY_UNICAST;
     ssize_t recvTimes = TEMP_FAILURE_RETRY(ReceiveMessage(isRepair, uid));
     if (recvTimes < 0) {
+        // Events were lost, the interface inventory cannot follow them and dumps again
+        if (errno == ENOBUFS && isRouteSocket_ && InterfaceInventory::GetInstance().GetSnapshot() != nullptr) {
+            InterfaceInventory::GetInstance().Start();
+        }
         return;
     }
+    if (isRouteSocket_) {
+        InterfaceInventory::GetInstance().Update(buffer_, static_cast<int32_t>(recvTimes));
+    }
 
     bool isSuccess = false;
     std::shared_ptr<NetsysEventMessage> message = std::make_shared<NetsysEventMessage>();
@@ -22,7 +22,9 @@
 #include <mutex>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <utility>
 
+#include "interface_inventory.h"
 #include "netlink_define.h"
 #include "netnative_log_wrapper.h"
 #include "wrapper_distributor.h"
@@ -174,16 +176,22 @@ int32_t NetlinkManager::StartListener()
             continue;
         }
         it.second->RegisterNetlinkCallbacks(callbacks_);
+        it.second->SetInterfaceEventHandler(interfaceEventHandler_);
         if (it.second->Start() != 0) {
             NETNATIVE_LOGE("Start netlink listener failed");
             return NetlinkResult::ERROR;
         }
     }
+    // The rtnetlink socket is subscribed since the constructor, no event after the dump is missed
+    if (distributorMap_.count(NETLINK_ROUTE) != 0 && InterfaceInventory::GetInstance().Start() != 0) {
+        NETNATIVE_LOGW("Interface inventory not started, interfaces are read from the kernel on every query");
+    }
     return NetlinkResult::OK;
 }
 
 int32_t NetlinkManager::StopListener()
 {
+    InterfaceInventory::GetInstance().Stop();
     for (auto &it : distributorMap_) {
         if (it.second == nullptr) {
             continue;
@@ -243,5 +251,22 @@ int32_t NetlinkManager::UnregisterNetlinkCallback(sptr<NetsysNative::INotifyCall
     NETNATIVE_LOGI("callback has not registered current callback number is %{public}zu", callbacks_->size());
     return NetlinkResult::ERR_INVALID_PARAM;
 }
+
+void NetlinkManager::NotifyBandwidthReachedLimit(const std::string &limitName, const std::string &iface)
+{
+    NETNATIVE_LOG_D("NotifyBandwidthReachedLimit: %{public}s, %{public}s", limitName.c_str(), iface.c_str());
+    std::lock_guard<std::mutex> lock(linkCallbackMutex_);
+    for (const auto &callback : *callbacks_) {
+        if (callback != nullptr) {
+            callback->OnBandwidthReachedLimit(limitName, iface);
+        }
+    }
+}
+
+void NetlinkManager::SetInterfaceEventHandler(std::function<void(const std::string &ifName, bool added)> handler)
+{
+    std::lock_guard<std::mutex> lock(linkCallbackMutex_);
+    interfaceEventHandler_ = std::move(handler);
+}
 } // namespace nmd
 } // namespace OHOS
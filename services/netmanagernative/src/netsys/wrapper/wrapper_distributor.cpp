@@ -62,6 +62,12 @@ int32_t WrapperDistributor::RegisterNetlinkCallbacks(
     return NetlinkResult::OK;
 }
 
+void WrapperDistributor::SetInterfaceEventHandler(const InterfaceEventHandler &handler)
+{
+    std::lock_guard<std::mutex> lock(netlinkCallbacksMutex_);
+    interfaceEventHandler_ = handler;
+}
+
 void WrapperDistributor::HandleDecodeSuccess(const std::shared_ptr<NetsysEventMessage> &message)
 {
     if (message == nullptr) {
@@ -210,6 +216,9 @@ void WrapperDistributor::NotifyInterfaceAdd(const std::string &ifName)
 {
     NETNATIVE_LOG_D("interface added: %{public}s", ifName.c_str());
     std::lock_guard<std::mutex> lock(netlinkCallbacksMutex_);
+    if (interfaceEventHandler_ != nullptr) {
+        interfaceEventHandler_(ifName, true);
+    }
     if (netlinkCallbacks_ == nullptr) {
         NETNATIVE_LOGE("netlinkCallbacks_ is nullptr");
         return;
@@ -225,6 +234,9 @@ void WrapperDistributor::NotifyInterfaceRemove(const std::string &ifName)
 {
     NETNATIVE_LOG_D("interface removed: %{public}s", ifName.c_str());
     std::lock_guard<std::mutex> lock(netlinkCallbacksMutex_);
+    if (interfaceEventHandler_ != nullptr) {
+        interfaceEventHandler_(ifName, false);
+    }
     if (netlinkCallbacks_ == nullptr) {
         NETNATIVE_LOGE("netlinkCallbacks_ is nullptr");
         return;
@@ -115,6 +115,7 @@ void NetsysNativeService::OnStop()
     NetsysBpfRingBuffer::ExistRingBufferPoll();
 #endif
     NetsysBpfRingBuffer::ExistNetstatsRingBufferPoll();
+    NetsysBpfRingBufferConsumer::GetInstance().Stop();
 }
 
 int32_t NetsysNativeService::Dump(int32_t fd, const std::vector<std::u16string> &args)
@@ -129,6 +130,7 @@ int32_t NetsysNativeService::Dump(int32_t fd, const std::vector<std::u16string>
 void NetsysNativeService::GetDumpMessage(std::string &message)
 {
     netsysService_->GetDumpInfo(message);
+    NetsysBpfRingBufferConsumer::GetInstance().GetDumpInfo(message);
 }
 
 void ExitHandler(int32_t signum)
@@ -154,6 +156,10 @@ bool NetsysNativeService::Init()
         NETNATIVE_LOGE("manager_ is nullptr!");
         return false;
     }
+    // Quotas and alerts set before their iface exists are written to the ifindex keyed map once it is added
+    manager_->SetInterfaceEventHandler([service = netsysService_.get()](const std::string &ifName, bool added) {
+        service->BandwidthOnInterfaceChanged(ifName, added);
+    });
     bpfStats_ = std::make_unique<OHOS::NetManagerStandard::NetsysBpfStats>();
     dhcpController_ = std::make_unique<OHOS::nmd::DhcpController>();
     fwmarkNetwork_ = std::make_unique<OHOS::nmd::FwmarkNetwork>();
@@ -177,6 +183,10 @@ bool NetsysNativeService::Init()
 #ifdef ENABLE_NETSYS_ACCESS_POLICY_DIAG_LISTEN
     NetsysBpfRingBuffer::ListenNetworkAccessPolicyEvent();
 #endif
+    NetsysBpfRingBuffer::SetBandwidthLimitHandler(
+        [manager = manager_.get()](const std::string &limitName, const std::string &iface) {
+            manager->NotifyBandwidthReachedLimit(limitName, iface);
+        });
     NetsysBpfRingBuffer::ListenNetworkStatsEvent();
     AddSystemAbilityListener(COMM_NET_CONN_MANAGER_SYS_ABILITY_ID);
     return true;
@@ -628,6 +638,14 @@ int32_t NetsysNativeService::BandwidthRemoveAllowedList(uint32_t uid)
     return netsysService_->BandwidthRemoveAllowedList(uid);
 }
 
+int32_t NetsysNativeService::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                     const std::vector<uint32_t> &allowedUids,
+                                                     const std::vector<uint32_t> &removedUids)
+{
+    NETNATIVE_LOG_D("BandwidthUpdateUidLists");
+    return netsysService_->BandwidthUpdateUidLists(deniedUids, allowedUids, removedUids);
+}
+
 int32_t NetsysNativeService::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     NETNATIVE_LOG_D("FirewallSetUidsAllowedListChain");
@@ -1137,7 +1155,11 @@ int32_t NetsysNativeService::SetFirewallDefaultAction(int32_t userId, FirewallRu
 {
     NETNATIVE_LOGI("NetsysNativeService::SetFirewallDefaultAction");
     int32_t ret = bpfNetFirewall_->SetFirewallDefaultAction(userId, inDefault, outDefault);
-    return ret;
+    if (ret != NETSYS_SUCCESS) {
+        return ret;
+    }
+    // The DNS cache answers in place of the kernel domain intercept, which the default action is part of
+    return netsysService_->SetFirewallDefaultAction(userId, outDefault);
 }
 
 int32_t NetsysNativeService::SetFirewallCurrentUserId(int32_t userId)
@@ -1154,8 +1176,11 @@ int32_t NetsysNativeService::ClearFirewallRules(NetFirewallRuleType type)
     int32_t ret = NETSYS_SUCCESS;
     switch (type) {
         case NetFirewallRuleType::RULE_IP:
+            ret = bpfNetFirewall_->ClearFirewallRules(type);
+            break;
         case NetFirewallRuleType::RULE_DOMAIN:
             ret = bpfNetFirewall_->ClearFirewallRules(type);
+            ret += netsysService_->ClearFirewallRules(type);
             break;
         case NetFirewallRuleType::RULE_DNS:
             ret = netsysService_->ClearFirewallRules(type);
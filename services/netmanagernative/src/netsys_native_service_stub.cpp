@@ -38,6 +38,8 @@ constexpr int32_t MAX_FLAG_NUM = 64;
 constexpr int32_t MAX_DNS_CONFIG_SIZE = 7;
 constexpr int32_t NETMANAGER_ERR_PERMISSION_DENIED = 201;
 constexpr uint32_t UIDS_LIST_MAX_SIZE = 1024;
+// Bulk uid list updates carry every installed app in one request
+constexpr uint32_t UID_LISTS_MAX_SIZE = 16384;
 constexpr uint32_t MAX_UID_ARRAY_SIZE = 1024;
 constexpr uint32_t MAX_CONFIG_LIST_SIZE = 1024;
 constexpr uint32_t MAX_ROUTE_TABLE_SIZE = 128;
@@ -189,6 +191,8 @@ void NetsysNativeServiceStub::InitBandwidthOpToInterfaceMap()
         &NetsysNativeServiceStub::CmdBandwidthAddAllowedList;
     opToInterfaceMap_[static_cast<uint32_t>(NetsysInterfaceCode::NETSYS_BANDWIDTH_REMOVE_ALLOWED_LIST)] =
         &NetsysNativeServiceStub::CmdBandwidthRemoveAllowedList;
+    opToInterfaceMap_[static_cast<uint32_t>(NetsysInterfaceCode::NETSYS_BANDWIDTH_UPDATE_UID_LISTS)] =
+        &NetsysNativeServiceStub::CmdBandwidthUpdateUidLists;
     opToInterfaceMap_[static_cast<uint32_t>(NetsysInterfaceCode::NETSYS_SET_INTERNET_PERMISSION)] =
         &NetsysNativeServiceStub::CmdSetInternetPermission;
     opToInterfaceMap_[static_cast<uint32_t>(NetsysInterfaceCode::NETSYS_SET_NETWORK_ACCESS_POLICY)] =
@@ -1466,6 +1470,26 @@ int32_t NetsysNativeServiceStub::CmdBandwidthRemoveAllowedList(MessageParcel &da
     return result;
 }
 
+int32_t NetsysNativeServiceStub::CmdBandwidthUpdateUidLists(MessageParcel &data, MessageParcel &reply)
+{
+    NETNATIVE_LOG_D("Begin to dispatch cmd CmdBandwidthUpdateUidLists");
+    std::vector<uint32_t> deniedUids;
+    std::vector<uint32_t> allowedUids;
+    std::vector<uint32_t> removedUids;
+    if (!data.ReadUInt32Vector(&deniedUids) || !data.ReadUInt32Vector(&allowedUids) ||
+        !data.ReadUInt32Vector(&removedUids)) {
+        NETNATIVE_LOGE("Read uid lists failed");
+        return ERR_FLATTEN_OBJECT;
+    }
+    if (deniedUids.size() + allowedUids.size() + removedUids.size() > UID_LISTS_MAX_SIZE) {
+        NETNATIVE_LOGE("Uid lists size err");
+        return ERR_INVALID_DATA;
+    }
+    int32_t result = BandwidthUpdateUidLists(deniedUids, allowedUids, removedUids);
+    reply.WriteInt32(result);
+    return result;
+}
+
 int32_t NetsysNativeServiceStub::CmdFirewallSetUidsAllowedListChain(MessageParcel &data, MessageParcel &reply)
 {
     NETNATIVE_LOG_D("Begin to dispatch cmd CmdFirewallSetUidsAllowedListChain");
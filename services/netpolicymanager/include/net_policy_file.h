@@ -27,6 +27,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 #include "cJSON.h"
@@ -40,13 +41,6 @@
 
 namespace OHOS {
 namespace NetManagerStandard {
-enum NetUidPolicyOpType {
-    NET_POLICY_UID_OP_TYPE_DO_NOTHING = 0,
-    NET_POLICY_UID_OP_TYPE_ADD = 1,
-    NET_POLICY_UID_OP_TYPE_DELETE = 2,
-    NET_POLICY_UID_OP_TYPE_UPDATE = 3,
-};
-
 class NetPolicyFile : public std::enable_shared_from_this<NetPolicyFile> {
     DECLARE_DELAYED_SINGLETON(NetPolicyFile);
 
@@ -144,6 +138,10 @@ private:
     bool ReadFile(const std::string &filePath);
     bool ReadFile();
     bool WriteFile();
+    void ReplayJournal();
+    void AppendJournal(uint32_t uid, uint32_t policy);
+    bool ScheduleFlush();
+    void FlushDirty();
 
     void AddUidPolicy(cJSON *root);
     void AddBackgroundPolicy(cJSON *root);
@@ -156,8 +154,9 @@ private:
     void ParseFirewallRule(const cJSON* const root, NetPolicy &netPolicy);
 
     bool UpdateQuotaPolicyExist(const NetQuotaPolicy &quotaPolicy);
-    uint32_t ArbitrationWritePolicyToFile(uint32_t uid, uint32_t policy);
-    void WritePolicyByUid(uint32_t netUidPolicyOpType, uint32_t uid, uint32_t policy);
+    bool UpdateUidPolicy(uint32_t uid, uint32_t policy);
+    void RebuildUidPolicyIndex();
+    void ClearPolicies();
 
     inline void ToQuotaPolicy(const NetPolicyQuota& netPolicyQuota, NetQuotaPolicy &quotaPolicy)
     {
@@ -174,6 +173,14 @@ private:
 
     std::shared_ptr<NetPolicyFileEventHandler> GetHandler();
     ffrt::mutex netFirewallRulesMutex_;
+    // Guards netPolicy_ against the flush serializing it on the file queue, taken before netFirewallRulesMutex_
+    ffrt::mutex netPolicyMutex_;
+    // Position of each uid in netPolicy_.uidPolicies
+    std::unordered_map<uint32_t, size_t> uidPolicyIndex_;
+    bool snapshotDirty_ = false;
+    bool flushScheduled_ = false;
+    uint32_t journalEntries_ = 0;
+    std::string journalLines_;
 public:
     NetPolicy netPolicy_;
 };
@@ -16,6 +16,7 @@
 #ifndef NET_POLICY_FILE_EVENT_HANDLER_H
 #define NET_POLICY_FILE_EVENT_HANDLER_H
 
+#include <functional>
 #include <iostream>
 #include <dirent.h>
 
@@ -26,6 +27,7 @@
 
 struct PolicyFileEvent {
     std::string json;
+    std::string journal;
 };
 
 namespace OHOS {
@@ -35,20 +37,26 @@ public:
     static constexpr uint32_t MSG_POLICY_FILE_WRITE = 2;
     static constexpr uint32_t MSG_POLICY_FILE_DELETE = 3;
     static constexpr uint32_t MSG_POLICY_FILE_COMMIT = 4;
+    static constexpr uint32_t MSG_POLICY_FILE_JOURNAL = 5;
 
     explicit NetPolicyFileEventHandler(const char *queueName);
     virtual ~NetPolicyFileEventHandler() = default;
     void SendWriteEvent(AppExecFwk::InnerEvent::Pointer &event);
+    void PostTask(const std::function<void()> &task, uint32_t delayTime);
 
 private:
     bool Write();
     bool DeleteBak();
+    bool AppendJournal(const std::string &journal);
+    bool WriteFileAtomic(const char *tmpName, const char *fileName, const std::string &content);
 
     void SendEvent(const AppExecFwk::InnerEvent::Pointer &event, uint32_t delayTime = 0);
     void ProcessEvent(uint32_t eventId, std::shared_ptr<PolicyFileEvent> eventData);
     std::atomic<int64_t> timeStamp_ = 0;
     std::atomic<bool> commitWait_ = false;
     std::string fileContent_;
+    // Journal entries sent after fileContent_, they stay in the journal when fileContent_ is committed
+    std::string pendingJournal_;
     ffrt::queue netPolicyFileEventQueue_;
 };
 } // namespace NetManagerStandard
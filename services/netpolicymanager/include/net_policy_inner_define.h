@@ -42,7 +42,11 @@ constexpr int16_t LIMIT_CALLBACK_NUM = 200;
 constexpr const char *POLICY_FILE_NAME = "/data/service/el1/public/netmanager/net_policy.json";
 constexpr const char *POLICY_FILE_BAK_NAME = "/data/service/el1/public/netmanager/net_policy.bak";
 constexpr const char *POLICY_FILE_BAK_PATH = "/data/service/el1/public/netmanager/";
+constexpr const char *POLICY_FILE_TMP_NAME = "/data/service/el1/public/netmanager/net_policy.json.tmp";
+constexpr const char *POLICY_JOURNAL_NAME = "/data/service/el1/public/netmanager/net_policy.journal";
+constexpr const char *POLICY_JOURNAL_TMP_NAME = "/data/service/el1/public/netmanager/net_policy.journal.tmp";
 constexpr const char *CONFIG_HOS_VERSION = "hosVersion";
+constexpr const char *CONFIG_JOURNAL_GENERATION = "journalGeneration";
 constexpr const char *CONFIG_UID_POLICY = "uidPolicy";
 constexpr const char *CONFIG_UID = "uid";
 constexpr const char *CONFIG_POLICY = "policy";
@@ -117,6 +121,8 @@ struct NetFirewallRuleList {
 
 struct NetPolicy {
     std::string hosVersion;
+    // Bumped by every policy file write, journal entries made before the write carry an older one
+    uint64_t journalGeneration = 0;
     std::vector<UidPolicy> uidPolicies;
     std::string backgroundPolicyStatus;
     std::vector<NetPolicyQuota> netQuotaPolicies;
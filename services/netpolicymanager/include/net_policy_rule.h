@@ -18,6 +18,7 @@
 
 #include <map>
 #include <shared_mutex>
+#include <unordered_set>
 
 #include "net_policy_base.h"
 #include "netmanager_base_common_utils.h"
@@ -44,6 +45,18 @@ struct UidPolicyRule {
     uint32_t netsys_ = 7;
 };
 
+// Netsys operations collected over all uids, sent to netsys with one call per kind
+struct NetsysCtrlBatch {
+    std::vector<uint32_t> deniedUids;
+    std::vector<uint32_t> allowedUids;
+    std::vector<uint32_t> removedUids;
+    std::vector<uint32_t> powerSaveAllowedUids;
+    std::vector<uint32_t> powerSaveDeniedUids;
+    std::vector<std::pair<uint32_t, uint32_t>> changedRules;
+    // The netsys control of a uid is recorded once netsys took all its operations
+    std::vector<std::pair<uint32_t, uint32_t>> changedNetsys;
+};
+
 class NetPolicyRule : public NetPolicyBase {
 public:
     NetPolicyRule();
@@ -181,6 +194,14 @@ public:
 private:
     void NetsysCtrl(uint32_t uid, uint32_t netsysCtrl);
     void TransConditionToRuleAndNetsys(uint32_t uid, UidPolicyRule &policyRule);
+    void TransConditionToRuleAndNetsys(uint32_t uid, UidPolicyRule &policyRule, NetsysCtrlBatch &batch);
+    uint32_t TransConditionToRule(uint32_t uid, const UidPolicyRule &policyRule, uint32_t &netsys);
+    UidPolicyRule &UpdateUidPolicyRule(uint32_t uid, uint32_t policy);
+    void CollectNetsysCtrl(uint32_t uid, uint32_t netsysCtrl, NetsysCtrlBatch &batch);
+    void ApplyNetsysCtrlBatch(const NetsysCtrlBatch &batch);
+    void ApplyBandwidthUidLists(const NetsysCtrlBatch &batch, std::unordered_set<uint32_t> &failedUids);
+    void ApplyPowerSaveUids(const std::vector<uint32_t> &uids, uint32_t firewallRule,
+                            std::unordered_set<uint32_t> &failedUids);
     uint32_t MoveToConditionBit(uint32_t value);
     uint32_t MoveToRuleBit(uint32_t value);
     uint32_t ChangePolicyToPolicyTransitionCondition(uint32_t policy);
@@ -38,7 +38,10 @@ public:
     int32_t BandwidthRemoveDeniedList(uint32_t uid);
     int32_t BandwidthAddAllowedList(uint32_t uid);
     int32_t BandwidthRemoveAllowedList(uint32_t uid);
+    int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                                    const std::vector<uint32_t> &removedUids);
     int32_t PowerSaveUpdataAllowedList(uint32_t uid, uint32_t firewallRule);
+    int32_t PowerSaveUpdataAllowedList(const std::vector<uint32_t> &uids, uint32_t firewallRule);
     int32_t FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids);
     int32_t FirewallSetUidsDeniedListChain(uint32_t chain, const std::vector<uint32_t> &uids);
     int32_t FirewallSetUidRule(uint32_t chain, const std::vector<uint32_t> &uids, uint32_t firewallRule);
@@ -31,6 +31,9 @@ namespace NetManagerStandard {
 namespace {
 constexpr uint32_t MAX_TIME_MS_DELTA = 5000;
 constexpr uint32_t SEND_TIME_MS_INTERVAL = 2000;
+constexpr mode_t POLICY_FILE_MODE = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP;
+// Every handler shares the same temp and journal files
+ffrt::mutex g_policyFileMutex;
 
 int64_t GetNowMilliSeconds()
 {
@@ -38,6 +41,39 @@ int64_t GetNowMilliSeconds()
     auto epoch = nowSys.time_since_epoch();
     return std::chrono::duration_cast<std::chrono::milliseconds>(epoch).count();
 }
+
+bool WriteAll(int fd, const std::string &content)
+{
+    size_t offset = 0;
+    while (offset < content.size()) {
+        ssize_t ret = write(fd, content.data() + offset, content.size() - offset);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            NETMGR_LOG_E("write failed, errno[%{public}d]", errno);
+            return false;
+        }
+        offset += static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+bool SyncPolicyDir()
+{
+    int fd = open(POLICY_FILE_BAK_PATH, O_RDONLY);
+    if (fd == -1) {
+        NETMGR_LOG_E("open the file path failed.");
+        return false;
+    }
+    if (fsync(fd) != 0) {
+        NETMGR_LOG_E("fsync the file path failed.");
+        close(fd);
+        return false;
+    }
+    close(fd);
+    return true;
+}
 } // namespace
 
 NetPolicyFileEventHandler::NetPolicyFileEventHandler(const char *queueName) : netPolicyFileEventQueue_(queueName) {}
@@ -47,6 +83,12 @@ void NetPolicyFileEventHandler::SendWriteEvent(AppExecFwk::InnerEvent::Pointer &
     SendEvent(event);
 }
 
+void NetPolicyFileEventHandler::PostTask(const std::function<void()> &task, uint32_t delayTime)
+{
+    netPolicyFileEventQueue_.submit(task,
+                                    ffrt::task_attr().delay(static_cast<uint64_t>(delayTime)).name("FfrtPostTask"));
+}
+
 void NetPolicyFileEventHandler::SendEvent(const AppExecFwk::InnerEvent::Pointer &event, uint32_t delayTime)
 {
     auto eventId = event->GetInnerEventId();
@@ -57,8 +99,14 @@ void NetPolicyFileEventHandler::SendEvent(const AppExecFwk::InnerEvent::Pointer
 
 void NetPolicyFileEventHandler::ProcessEvent(uint32_t eventId, std::shared_ptr<PolicyFileEvent> eventData)
 {
+    if (eventId == MSG_POLICY_FILE_JOURNAL) {
+        AppendJournal(eventData->journal);
+        return;
+    }
+
     if (eventId == MSG_POLICY_FILE_WRITE) {
         fileContent_ = eventData->json;
+        pendingJournal_.clear();
         if (commitWait_) {
             return;
         }
@@ -77,7 +125,9 @@ void NetPolicyFileEventHandler::ProcessEvent(uint32_t eventId, std::shared_ptr<P
         if (commitWait_) {
             SendEvent(AppExecFwk::InnerEvent::Get(MSG_POLICY_FILE_COMMIT, std::make_shared<PolicyFileEvent>()),
                       MAX_TIME_MS_DELTA);
+            return;
         }
+        // Write() keeps no .bak, this only clears the one an older version left once a new file is committed
         SendEvent(AppExecFwk::InnerEvent::Get(MSG_POLICY_FILE_DELETE, std::make_shared<PolicyFileEvent>()),
                   SEND_TIME_MS_INTERVAL);
         return;
@@ -91,29 +141,54 @@ void NetPolicyFileEventHandler::ProcessEvent(uint32_t eventId, std::shared_ptr<P
 bool NetPolicyFileEventHandler::Write()
 {
     NETMGR_LOG_D("write file to disk.");
-    struct stat buffer;
+    std::lock_guard<ffrt::mutex> lock(g_policyFileMutex);
     CommonUtils::RemoveDeleteControlFromPath(POLICY_FILE_BAK_PATH);
-    if (stat(POLICY_FILE_NAME, &buffer) == 0) {
-        std::ifstream oldFile(POLICY_FILE_NAME, std::ios::binary);
-        std::ofstream newFile(POLICY_FILE_BAK_NAME, std::ios::binary);
-        if (!oldFile.is_open() && !newFile.is_open()) {
-            NETMGR_LOG_E("File backup failed.");
-            return false;
-        }
-        newFile << oldFile.rdbuf();
-        oldFile.close();
-        newFile.close();
-    }
-    std::fstream file(POLICY_FILE_NAME, std::fstream::out | std::fstream::trunc);
-    if (!file.is_open()) {
-        NETMGR_LOG_E("open file error.");
+    if (!WriteFileAtomic(POLICY_FILE_TMP_NAME, POLICY_FILE_NAME, fileContent_)) {
         return false;
     }
-    file << fileContent_;
-    file.close();
+    // The new file holds every journal entry sent before it, so the journal is compacted to the later ones
+    if (!pendingJournal_.empty()) {
+        return WriteFileAtomic(POLICY_JOURNAL_TMP_NAME, POLICY_JOURNAL_NAME, pendingJournal_);
+    }
+    if (remove(POLICY_JOURNAL_NAME) != 0 && errno != ENOENT) {
+        NETMGR_LOG_E("remove journal error, errno[%{public}d]", errno);
+    }
     return true;
 }
 
+bool NetPolicyFileEventHandler::WriteFileAtomic(const char *tmpName, const char *fileName,
+                                                const std::string &content)
+{
+    int fd = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, POLICY_FILE_MODE);
+    if (fd < 0) {
+        NETMGR_LOG_E("open file error, errno[%{public}d]", errno);
+        return false;
+    }
+    bool ret = WriteAll(fd, content) && fsync(fd) == 0;
+    close(fd);
+    if (!ret || rename(tmpName, fileName) != 0) {
+        NETMGR_LOG_E("replace file error, errno[%{public}d]", errno);
+        unlink(tmpName);
+        return false;
+    }
+    return SyncPolicyDir();
+}
+
+bool NetPolicyFileEventHandler::AppendJournal(const std::string &journal)
+{
+    pendingJournal_ += journal;
+    std::lock_guard<ffrt::mutex> lock(g_policyFileMutex);
+    CommonUtils::RemoveDeleteControlFromPath(POLICY_FILE_BAK_PATH);
+    int fd = open(POLICY_JOURNAL_NAME, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, POLICY_FILE_MODE);
+    if (fd < 0) {
+        NETMGR_LOG_E("open journal error, errno[%{public}d]", errno);
+        return false;
+    }
+    bool ret = WriteAll(fd, journal) && fdatasync(fd) == 0;
+    close(fd);
+    return ret;
+}
+
 bool NetPolicyFileEventHandler::DeleteBak()
 {
     struct stat buffer;
@@ -123,17 +198,7 @@ bool NetPolicyFileEventHandler::DeleteBak()
             NETMGR_LOG_E("remove file error.");
             return false;
         }
-        int fd = open(POLICY_FILE_BAK_PATH, O_RDONLY);
-        if (fd == -1) {
-            NETMGR_LOG_E("open the file path failed.");
-            return false;
-        }
-        if (fsync(fd) != 0) {
-            NETMGR_LOG_E("fsync the file path failed.");
-            close(fd);
-            return false;
-        }
-        close(fd);
+        return SyncPolicyDir();
     }
     return true;
 }
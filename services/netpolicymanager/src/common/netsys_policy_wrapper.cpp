@@ -84,6 +84,18 @@ int32_t NetsysPolicyWrapper::BandwidthRemoveAllowedList(uint32_t uid)
     return netsysReturnValue;
 }
 
+int32_t NetsysPolicyWrapper::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                     const std::vector<uint32_t> &allowedUids,
+                                                     const std::vector<uint32_t> &removedUids)
+{
+    auto netsysReturnValue = NetsysController::GetInstance().BandwidthUpdateUidLists(deniedUids, allowedUids,
+                                                                                     removedUids);
+    NETMGR_LOG_D("NetsysPolicyWrapper:UpdateUidLists denied[%{public}zu] allowed[%{public}zu] removed[%{public}zu] "
+                 "netsys return[%{public}d]", deniedUids.size(), allowedUids.size(), removedUids.size(),
+                 netsysReturnValue);
+    return netsysReturnValue;
+}
+
 int32_t NetsysPolicyWrapper::PowerSaveUpdataAllowedList(uint32_t uid, uint32_t firewallRule)
 {
     std::vector<uint32_t> uids{ uid };
@@ -94,6 +106,15 @@ int32_t NetsysPolicyWrapper::PowerSaveUpdataAllowedList(uint32_t uid, uint32_t f
     return netsysReturnValue;
 }
 
+int32_t NetsysPolicyWrapper::PowerSaveUpdataAllowedList(const std::vector<uint32_t> &uids, uint32_t firewallRule)
+{
+    uint32_t chain = ChainType::CHAIN_OHFW_ALLOWED_LIST_BOX;
+    auto netsysReturnValue = NetsysController::GetInstance().FirewallSetUidRule(chain, uids, firewallRule);
+    NETMGR_LOG_D("NetsysPolicyWrapper:PowerSaveUpdataAllowedList uids size[%{public}zu] netsys return[%{public}d]",
+                 uids.size(), netsysReturnValue);
+    return netsysReturnValue;
+}
+
 int32_t NetsysPolicyWrapper::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     auto netsysReturnValue = NetsysController::GetInstance().FirewallSetUidsAllowedListChain(chain, uids);
@@ -15,8 +15,10 @@
 
 #include "net_policy_file.h"
 
+#include <algorithm>
 #include <fcntl.h>
 #include <string>
+#include <utility>
 
 #include "net_manager_center.h"
 #include "net_mgr_log_wrapper.h"
@@ -43,6 +45,12 @@ bool CheckFilePath(const std::string &fileName, std::string &realPath)
 }
 } // namespace
 constexpr const char *NET_POLICY_WORK_THREAD = "NET_POLICY_FILE_WORK_THREAD";
+// Changes made within this window (in microseconds) are serialized and handed to the file queue together
+constexpr uint32_t FLUSH_DELAY_US = 200 * 1000;
+// The journal is folded into a full policy file once it holds this many uid edits
+constexpr uint32_t MAX_JOURNAL_ENTRIES = 512;
+constexpr char JOURNAL_FIELD_SEPARATOR = ' ';
+constexpr char JOURNAL_LINE_END = '\n';
 
 NetPolicyFile::NetPolicyFile()
 {
@@ -81,23 +89,127 @@ bool NetPolicyFile::ReadFile(const std::string &fileName)
 
 bool NetPolicyFile::ReadFile()
 {
-    return ReadFile(POLICY_FILE_NAME) || ReadFile(POLICY_FILE_BAK_NAME);
+    std::lock_guard<ffrt::mutex> lock(netPolicyMutex_);
+    // The file is replaced atomically now, but an older version that crashed while it truncated and rewrote the
+    // file left only its .bak copy intact. The handler deletes that copy after the first commit of this version.
+    bool ret = ReadFile(POLICY_FILE_NAME) || ReadFile(POLICY_FILE_BAK_NAME);
+    RebuildUidPolicyIndex();
+    ReplayJournal();
+    return ret;
+}
+
+void NetPolicyFile::ReplayJournal()
+{
+    std::ifstream file(POLICY_JOURNAL_NAME);
+    if (!file.is_open()) {
+        return;
+    }
+    std::string line;
+    journalEntries_ = 0;
+    uint32_t staleEntries = 0;
+    uint64_t lastGeneration = netPolicy_.journalGeneration;
+    while (std::getline(file, line)) {
+        // An unterminated last line was cut by a crash while it was written
+        if (file.eof()) {
+            break;
+        }
+        std::istringstream entry(line);
+        uint64_t generation = 0;
+        uint32_t uid = 0;
+        uint32_t policy = 0;
+        if (!(entry >> generation >> uid >> policy)) {
+            NETMGR_LOG_E("invalid journal entry");
+            continue;
+        }
+        // Left by a crash between the policy file write and the journal rewrite, the file already holds it
+        if (generation < netPolicy_.journalGeneration) {
+            ++staleEntries;
+            continue;
+        }
+        lastGeneration = std::max(lastGeneration, generation);
+        UpdateUidPolicy(uid, policy);
+        ++journalEntries_;
+    }
+    // Entries that outlived an uncommitted policy file write are newer than the file, the next write goes past them
+    netPolicy_.journalGeneration = lastGeneration;
+    NETMGR_LOG_I("replayed %{public}u uid policy journal entries, dropped %{public}u stale ones", journalEntries_,
+                 staleEntries);
 }
 
 bool NetPolicyFile::WriteFile()
 {
-    auto data = std::make_shared<PolicyFileEvent>();
-    Obj2Json(netPolicy_, data->json);
-    auto event = AppExecFwk::InnerEvent::Get(NetPolicyFileEventHandler::MSG_POLICY_FILE_WRITE, data);
+    std::lock_guard<ffrt::mutex> lock(netPolicyMutex_);
+    snapshotDirty_ = true;
+    return ScheduleFlush();
+}
+
+void NetPolicyFile::AppendJournal(uint32_t uid, uint32_t policy)
+{
+    if (++journalEntries_ >= MAX_JOURNAL_ENTRIES) {
+        snapshotDirty_ = true;
+    } else {
+        journalLines_ += std::to_string(netPolicy_.journalGeneration) + JOURNAL_FIELD_SEPARATOR +
+            std::to_string(uid) + JOURNAL_FIELD_SEPARATOR + std::to_string(policy) + JOURNAL_LINE_END;
+    }
+    ScheduleFlush();
+}
+
+bool NetPolicyFile::ScheduleFlush()
+{
+    if (flushScheduled_) {
+        return true;
+    }
     auto handler = GetHandler();
     if (!handler) {
         NETMGR_LOG_E("NetPolicyFileEventHandler not existed");
         return false;
     }
-    handler->SendWriteEvent(event);
+    std::weak_ptr<NetPolicyFile> weakFile = weak_from_this();
+    if (weakFile.expired()) {
+        NETMGR_LOG_E("NetPolicyFile is not owned by a shared_ptr");
+        return false;
+    }
+    flushScheduled_ = true;
+    handler->PostTask([weakFile]() {
+        auto file = weakFile.lock();
+        if (file != nullptr) {
+            file->FlushDirty();
+        }
+    }, FLUSH_DELAY_US);
     return true;
 }
 
+void NetPolicyFile::FlushDirty()
+{
+    std::lock_guard<ffrt::mutex> lock(netPolicyMutex_);
+    flushScheduled_ = false;
+    auto handler = GetHandler();
+    if (!handler) {
+        NETMGR_LOG_E("NetPolicyFileEventHandler not existed");
+        return;
+    }
+    auto data = std::make_shared<PolicyFileEvent>();
+    uint32_t eventId = NetPolicyFileEventHandler::MSG_POLICY_FILE_JOURNAL;
+    if (snapshotDirty_) {
+        ++netPolicy_.journalGeneration;
+        if (!Obj2Json(netPolicy_, data->json)) {
+            NETMGR_LOG_E("serialize policy failed, retry later");
+            ScheduleFlush();
+            return;
+        }
+        snapshotDirty_ = false;
+        journalEntries_ = 0;
+        journalLines_.clear();
+        eventId = NetPolicyFileEventHandler::MSG_POLICY_FILE_WRITE;
+    } else if (!journalLines_.empty()) {
+        data->journal.swap(journalLines_);
+    } else {
+        return;
+    }
+    auto event = AppExecFwk::InnerEvent::Get(eventId, data);
+    handler->SendWriteEvent(event);
+}
+
 const std::vector<UidPolicy> &NetPolicyFile::ReadUidPolicies()
 {
     return netPolicy_.uidPolicies;
@@ -230,6 +342,9 @@ bool NetPolicyFile::Json2Obj(const std::string &content, NetPolicy &netPolicy)
         netPolicy.hosVersion = cJSON_GetStringValue(hosVersion);
         NETMGR_LOG_E("hosVersion: %{public}s", netPolicy.hosVersion.c_str());
     }
+    // Written before the journal, a file without one predates it
+    const char *journalGeneration = cJSON_GetStringValue(cJSON_GetObjectItem(root, CONFIG_JOURNAL_GENERATION));
+    netPolicy.journalGeneration = journalGeneration == nullptr ? 0 : CommonUtils::StrToUint64(journalGeneration);
 
     // parse uid policy from file
     ParseUidPolicy(root, netPolicy);
@@ -258,6 +373,8 @@ bool NetPolicyFile::Obj2Json(const NetPolicy &netPolicy, std::string &content)
         netPolicy_.hosVersion = HOS_VERSION;
     }
     cJSON_AddItemToObject(root, CONFIG_HOS_VERSION, cJSON_CreateString(netPolicy_.hosVersion.c_str()));
+    cJSON_AddItemToObject(root, CONFIG_JOURNAL_GENERATION,
+                          cJSON_CreateString(std::to_string(netPolicy_.journalGeneration).c_str()));
     AddUidPolicy(root);
     AddBackgroundPolicy(root);
     AddQuotaPolicy(root);
@@ -356,70 +473,53 @@ void NetPolicyFile::AddFirewallRule(cJSON *root)
     cJSON_AddItemToObject(root, CONFIG_FIREWALL_RULE, firewallRuleObj);
 }
 
-uint32_t NetPolicyFile::ArbitrationWritePolicyToFile(uint32_t uid, uint32_t policy)
+bool NetPolicyFile::UpdateUidPolicy(uint32_t uid, uint32_t policy)
 {
-    uint32_t size = netPolicy_.uidPolicies.size();
-    bool haveUidAndPolicy = false;
-    uint32_t oldPolicy = NET_POLICY_NONE;
-    for (uint32_t i = 0; i < size; i++) {
-        auto uidTemp = CommonUtils::StrToUint(netPolicy_.uidPolicies[i].uid.c_str());
-        if (uid == uidTemp) {
-            haveUidAndPolicy = true;
-            oldPolicy = uidTemp;
+    auto iter = uidPolicyIndex_.find(uid);
+    if (iter == uidPolicyIndex_.end()) {
+        if (policy == NET_POLICY_NONE) {
+            return false;
         }
-    }
-
-    if (haveUidAndPolicy) {
-        if (oldPolicy != policy && policy == NET_POLICY_NONE) {
-            return NET_POLICY_UID_OP_TYPE_DELETE;
-        }
-
-        if (oldPolicy != policy && policy != NET_POLICY_NONE) {
-            return NET_POLICY_UID_OP_TYPE_UPDATE;
+        uidPolicyIndex_[uid] = netPolicy_.uidPolicies.size();
+        netPolicy_.uidPolicies.push_back({std::to_string(uid), std::to_string(policy)});
+        return true;
+    }
+    size_t index = iter->second;
+    if (policy != NET_POLICY_NONE) {
+        std::string policyStr = std::to_string(policy);
+        if (netPolicy_.uidPolicies[index].policy == policyStr) {
+            return false;
         }
-
-        return NET_POLICY_UID_OP_TYPE_DO_NOTHING;
+        netPolicy_.uidPolicies[index].policy = std::move(policyStr);
+        return true;
     }
-
-    if (policy == NET_POLICY_NONE) {
-        return NET_POLICY_UID_OP_TYPE_DO_NOTHING;
+    // Move the last entry into the hole so removing a uid does not shift the whole list
+    uidPolicyIndex_.erase(iter);
+    size_t last = netPolicy_.uidPolicies.size() - 1;
+    if (index != last) {
+        netPolicy_.uidPolicies[index] = std::move(netPolicy_.uidPolicies[last]);
+        uidPolicyIndex_[CommonUtils::StrToUint(netPolicy_.uidPolicies[index].uid)] = index;
     }
-    return NET_POLICY_UID_OP_TYPE_ADD;
+    netPolicy_.uidPolicies.pop_back();
+    return true;
 }
 
-void NetPolicyFile::WritePolicyByUid(uint32_t uid, uint32_t policy)
+void NetPolicyFile::RebuildUidPolicyIndex()
 {
-    uint32_t netUidPolicyOpType = ArbitrationWritePolicyToFile(uid, policy);
-    WritePolicyByUid(netUidPolicyOpType, uid, policy);
+    uidPolicyIndex_.clear();
+    for (size_t i = 0; i < netPolicy_.uidPolicies.size(); ++i) {
+        uidPolicyIndex_.emplace(CommonUtils::StrToUint(netPolicy_.uidPolicies[i].uid), i);
+    }
 }
 
-void NetPolicyFile::WritePolicyByUid(uint32_t netUidPolicyOpType, uint32_t uid, uint32_t policy)
+void NetPolicyFile::WritePolicyByUid(uint32_t uid, uint32_t policy)
 {
-    NETMGR_LOG_D("Write File start, model:[%{public}u]", netUidPolicyOpType);
-    if (netUidPolicyOpType == NetUidPolicyOpType::NET_POLICY_UID_OP_TYPE_UPDATE) {
-        for (auto &uidPolicy : netPolicy_.uidPolicies) {
-            if (uidPolicy.uid == std::to_string(uid)) {
-                uidPolicy.policy = std::to_string(policy);
-                break;
-            }
-        }
-    } else if (netUidPolicyOpType == NetUidPolicyOpType::NET_POLICY_UID_OP_TYPE_DELETE) {
-        for (auto iter = netPolicy_.uidPolicies.begin(); iter != netPolicy_.uidPolicies.end(); ++iter) {
-            if (iter->uid == std::to_string(uid)) {
-                netPolicy_.uidPolicies.erase(iter);
-                break;
-            }
-        }
-    } else if (netUidPolicyOpType == NetUidPolicyOpType::NET_POLICY_UID_OP_TYPE_ADD) {
-        UidPolicy uidPolicy;
-        uidPolicy.uid = std::to_string(uid);
-        uidPolicy.policy = std::to_string(static_cast<uint32_t>(policy));
-        netPolicy_.uidPolicies.push_back(uidPolicy);
-    } else {
+    std::lock_guard<ffrt::mutex> lock(netPolicyMutex_);
+    if (!UpdateUidPolicy(uid, policy)) {
         NETMGR_LOG_D("Need to do nothing!");
+        return;
     }
-
-    WriteFile();
+    AppendJournal(uid, policy);
 }
 
 bool NetPolicyFile::UpdateQuotaPolicyExist(const NetQuotaPolicy &quotaPolicy)
@@ -450,6 +550,7 @@ bool NetPolicyFile::UpdateQuotaPolicyExist(const NetQuotaPolicy &quotaPolicy)
 
 bool NetPolicyFile::WriteQuotaPolicies(const std::vector<NetQuotaPolicy> &quotaPolicies)
 {
+    std::unique_lock<ffrt::mutex> lock(netPolicyMutex_);
     netPolicy_.netQuotaPolicies.clear();
     uint32_t vSize = quotaPolicies.size();
     NetPolicyQuota quotaPolicy;
@@ -470,6 +571,7 @@ bool NetPolicyFile::WriteQuotaPolicies(const std::vector<NetQuotaPolicy> &quotaP
         quotaPolicy.warningBytes = std::to_string(quotaPolicies[i].quotapolicy.warningBytes);
         netPolicy_.netQuotaPolicies.push_back(quotaPolicy);
     }
+    lock.unlock();
 
     return WriteFile();
 }
@@ -506,7 +608,7 @@ void NetPolicyFile::WriteFirewallRules(uint32_t chainType, const std::set<uint32
     WriteFile();
 }
 
-int32_t NetPolicyFile::ResetPolicies()
+void NetPolicyFile::ClearPolicies()
 {
     std::unique_lock<ffrt::mutex> lock(netFirewallRulesMutex_);
     netPolicy_.uidPolicies.clear();
@@ -514,6 +616,16 @@ int32_t NetPolicyFile::ResetPolicies()
     netPolicy_.netQuotaPolicies.clear();
     netPolicy_.netFirewallRules.clear();
     lock.unlock();
+    uidPolicyIndex_.clear();
+    journalLines_.clear();
+    journalEntries_ = 0;
+}
+
+int32_t NetPolicyFile::ResetPolicies()
+{
+    std::unique_lock<ffrt::mutex> lock(netPolicyMutex_);
+    ClearPolicies();
+    lock.unlock();
     WriteFile();
 
     return NETMANAGER_SUCCESS;
@@ -521,11 +633,13 @@ int32_t NetPolicyFile::ResetPolicies()
 
 void NetPolicyFile::WriteBackgroundPolicy(bool backgroundPolicy)
 {
+    std::unique_lock<ffrt::mutex> lock(netPolicyMutex_);
     if (backgroundPolicy) {
         netPolicy_.backgroundPolicyStatus = BACKGROUND_POLICY_ALLOW;
     } else {
         netPolicy_.backgroundPolicyStatus = BACKGROUND_POLICY_REJECT;
     }
+    lock.unlock();
 
     WriteFile();
 }
@@ -545,13 +659,15 @@ std::shared_ptr<NetPolicyFileEventHandler> NetPolicyFile::GetHandler()
 
 bool NetPolicyFile::InitPolicy()
 {
-    ResetPolicies();
+    std::unique_lock<ffrt::mutex> lock(netPolicyMutex_);
+    ClearPolicies();
+    lock.unlock();
     return ReadFile();
 }
 
 void NetPolicyFile::RemoveInexistentUid(uint32_t uid)
 {
-    WritePolicyByUid(NetUidPolicyOpType::NET_POLICY_UID_OP_TYPE_DELETE, uid, 0);
+    WritePolicyByUid(uid, NET_POLICY_NONE);
 }
 } // namespace NetManagerStandard
 } // namespace OHOS
@@ -15,33 +15,58 @@
 
 #include "net_policy_rule.h"
 
+#include <algorithm>
+
 #include "net_mgr_log_wrapper.h"
 #include "iptables_type.h"
 
 namespace OHOS {
 namespace NetManagerStandard {
+namespace {
+// The uids netsys takes in one request, it rejects a larger BandwidthUpdateUidLists as a whole
+constexpr size_t NETSYS_UIDS_PER_REQUEST = 16384;
+
+std::vector<uint32_t> TakeUids(const std::vector<uint32_t> &uids, size_t &pos, size_t &room)
+{
+    size_t count = std::min(room, uids.size() - pos);
+    std::vector<uint32_t> chunk(uids.begin() + pos, uids.begin() + pos + count);
+    pos += count;
+    room -= count;
+    return chunk;
+}
+} // namespace
+
 NetPolicyRule::NetPolicyRule() = default;
 
 void NetPolicyRule::Init()
 {
     // Init uid、policy and background allow status from file,and save uid、policy into uidPolicyRules_.
     NETMGR_LOG_I("Start init uid and policy.");
-    const auto &uidsPolicies = GetFileInst()->ReadUidPolicies();
+    // Copied, writing the policies back may reorder the list kept by the file
+    const auto uidsPolicies = GetFileInst()->ReadUidPolicies();
     backgroundAllow_ = GetFileInst()->ReadBackgroundPolicy();
+    std::unique_lock<std::shared_mutex> lock(uidPolicyRuleMutex_);
+    NetsysCtrlBatch batch;
     for (const auto &i : uidsPolicies) {
         auto uid = CommonUtils::StrToUint(i.uid.c_str());
         auto policy = CommonUtils::StrToUint(i.policy.c_str());
-        TransPolicyToRule(uid, policy);
+        if (!IsValidNetPolicy(policy)) {
+            continue;
+        }
+        TransConditionToRuleAndNetsys(uid, UpdateUidPolicyRule(uid, policy), batch);
     }
+    ApplyNetsysCtrlBatch(batch);
 }
 
 void NetPolicyRule::TransPolicyToRule()
 {
     // When system status is changed,traverse uidPolicyRules_ to calculate the rule and netsys.
     std::shared_lock<std::shared_mutex> lock(uidPolicyRuleMutex_);
+    NetsysCtrlBatch batch;
     for (auto &[uid, policy] : uidPolicyRules_) {
-        TransConditionToRuleAndNetsys(uid, policy);
+        TransConditionToRuleAndNetsys(uid, policy, batch);
     }
+    ApplyNetsysCtrlBatch(batch);
 }
 
 void NetPolicyRule::TransPolicyToRule(uint32_t uid)
@@ -63,22 +88,24 @@ int32_t NetPolicyRule::TransPolicyToRule(uint32_t uid, uint32_t policy)
         return POLICY_ERR_INVALID_POLICY;
     }
     std::unique_lock<std::shared_mutex> lock(uidPolicyRuleMutex_);
-    auto policyRule = uidPolicyRules_.find(uid);
-    if (policyRule == uidPolicyRules_.end()) {
+    TransConditionToRuleAndNetsys(uid, UpdateUidPolicyRule(uid, policy));
+    NETMGR_LOG_D("End TransPolicyToRule");
+    return NETMANAGER_SUCCESS;
+}
+
+UidPolicyRule &NetPolicyRule::UpdateUidPolicyRule(uint32_t uid, uint32_t policy)
+{
+    auto [policyRule, inserted] = uidPolicyRules_.try_emplace(uid);
+    if (inserted) {
         NETMGR_LOG_D("Don't find this uid, need to add uid:[%{public}u] policy[%{public}u].", uid, policy);
-        uidPolicyRules_[uid] = {.policy_ = policy};
+        policyRule->second.policy_ = policy;
+        GetCbInst()->NotifyNetUidPolicyChange(uid, policy);
+    } else if (policyRule->second.policy_ != policy) {
+        NETMGR_LOG_D("Update policy's value.uid:[%{public}u] policy[%{public}u]", uid, policy);
+        policyRule->second.policy_ = policy;
         GetCbInst()->NotifyNetUidPolicyChange(uid, policy);
-    } else {
-        if (policyRule->second.policy_ != policy) {
-            NETMGR_LOG_D("Update policy's value.uid:[%{public}u] policy[%{public}u]", uid, policy);
-            policyRule->second.policy_ = policy;
-            GetCbInst()->NotifyNetUidPolicyChange(uid, policy);
-        }
     }
-
-    TransConditionToRuleAndNetsys(uid, uidPolicyRules_[uid]);
-    NETMGR_LOG_D("End TransPolicyToRule");
-    return NETMANAGER_SUCCESS;
+    return policyRule->second;
 }
 
 uint32_t NetPolicyRule::BuildTransCondition(uint32_t uid, uint32_t policy)
@@ -111,15 +138,22 @@ uint32_t NetPolicyRule::BuildTransCondition(uint32_t uid, uint32_t policy)
     return policyCondition;
 }
 
-void NetPolicyRule::TransConditionToRuleAndNetsys(uint32_t uid, UidPolicyRule& policyRule)
+uint32_t NetPolicyRule::TransConditionToRule(uint32_t uid, const UidPolicyRule &policyRule, uint32_t &netsys)
 {
-    NetmanagerHiTrace::NetmanagerStartSyncTrace("TransPolicyToRule start");
     auto policyCondition = BuildTransCondition(uid, policyRule.policy_);
     uint32_t conditionValue = GetMatchTransCondition(policyCondition);
     auto rule = MoveToRuleBit(conditionValue & POLICY_TRANS_RULE_MASK);
     NETMGR_LOG_D("NetPolicyRule->uid:[%{public}u] policy:[%{public}u] rule:[%{public}u] policyCondition[%{public}u]",
                  uid, policyRule.policy_, rule, policyCondition);
-    auto netsys = conditionValue & POLICY_TRANS_NET_CTRL_MASK;
+    netsys = conditionValue & POLICY_TRANS_NET_CTRL_MASK;
+    return rule;
+}
+
+void NetPolicyRule::TransConditionToRuleAndNetsys(uint32_t uid, UidPolicyRule& policyRule)
+{
+    NetmanagerHiTrace::NetmanagerStartSyncTrace("TransPolicyToRule start");
+    uint32_t netsys = 0;
+    auto rule = TransConditionToRule(uid, policyRule, netsys);
 
     if (policyRule.netsys_ != netsys) {
         NetsysCtrl(uid, netsys);
@@ -139,6 +173,109 @@ void NetPolicyRule::TransConditionToRuleAndNetsys(uint32_t uid, UidPolicyRule& p
     NetmanagerHiTrace::NetmanagerFinishSyncTrace("TransPolicyToRule end");
 }
 
+void NetPolicyRule::TransConditionToRuleAndNetsys(uint32_t uid, UidPolicyRule &policyRule, NetsysCtrlBatch &batch)
+{
+    uint32_t netsys = 0;
+    auto rule = TransConditionToRule(uid, policyRule, netsys);
+    if (policyRule.netsys_ != netsys) {
+        CollectNetsysCtrl(uid, netsys, batch);
+        batch.changedNetsys.emplace_back(uid, netsys);
+    }
+
+    GetFileInst()->WritePolicyByUid(uid, policyRule.policy_);
+
+    if (policyRule.rule_ != rule) {
+        policyRule.rule_ = rule;
+        batch.changedRules.emplace_back(uid, rule);
+    }
+}
+
+void NetPolicyRule::CollectNetsysCtrl(uint32_t uid, uint32_t netsysCtrl, NetsysCtrlBatch &batch)
+{
+    switch (netsysCtrl) {
+        case POLICY_TRANS_CTRL_NONE:
+            if (IsPowerSave()) {
+                batch.powerSaveDeniedUids.push_back(uid);
+            }
+            break;
+        case POLICY_TRANS_CTRL_REMOVE_ALL:
+            batch.removedUids.push_back(uid);
+            break;
+        case POLICY_TRANS_CTRL_ADD_DENIEDLIST:
+            batch.deniedUids.push_back(uid);
+            break;
+        case POLICY_TRANS_CTRL_ADD_ALLOWEDLIST:
+            batch.allowedUids.push_back(uid);
+            if (IsPowerSave()) {
+                batch.powerSaveAllowedUids.push_back(uid);
+            }
+            break;
+        default:
+            NETMGR_LOG_E("Error netsysCtrl value, need to check");
+            break;
+    }
+}
+
+void NetPolicyRule::ApplyNetsysCtrlBatch(const NetsysCtrlBatch &batch)
+{
+    NetmanagerHiTrace::NetmanagerStartSyncTrace("ApplyNetsysCtrlBatch start");
+    std::unordered_set<uint32_t> failedUids;
+    ApplyBandwidthUidLists(batch, failedUids);
+    ApplyPowerSaveUids(batch.powerSaveDeniedUids, FirewallRule::RULE_DENY, failedUids);
+    ApplyPowerSaveUids(batch.powerSaveAllowedUids, FirewallRule::RULE_ALLOW, failedUids);
+    // A uid netsys did not take keeps its old netsys control, the next pass sends it again
+    for (const auto &[uid, netsys] : batch.changedNetsys) {
+        auto policyRule = uidPolicyRules_.find(uid);
+        if (policyRule != uidPolicyRules_.end() && failedUids.count(uid) == 0) {
+            policyRule->second.netsys_ = netsys;
+        }
+    }
+    NETMGR_LOG_I("ApplyNetsysCtrlBatch denied[%{public}zu] allowed[%{public}zu] removed[%{public}zu] "
+                 "rules[%{public}zu] failed[%{public}zu]", batch.deniedUids.size(), batch.allowedUids.size(),
+                 batch.removedUids.size(), batch.changedRules.size(), failedUids.size());
+    for (const auto &[uid, rule] : batch.changedRules) {
+        GetCbInst()->NotifyNetUidRuleChange(uid, rule);
+    }
+    NetmanagerHiTrace::NetmanagerFinishSyncTrace("ApplyNetsysCtrlBatch end");
+}
+
+void NetPolicyRule::ApplyBandwidthUidLists(const NetsysCtrlBatch &batch, std::unordered_set<uint32_t> &failedUids)
+{
+    size_t denied = 0;
+    size_t allowed = 0;
+    size_t removed = 0;
+    while (denied < batch.deniedUids.size() || allowed < batch.allowedUids.size() ||
+           removed < batch.removedUids.size()) {
+        size_t room = NETSYS_UIDS_PER_REQUEST;
+        auto deniedUids = TakeUids(batch.deniedUids, denied, room);
+        auto allowedUids = TakeUids(batch.allowedUids, allowed, room);
+        auto removedUids = TakeUids(batch.removedUids, removed, room);
+        if (GetNetsysInst()->BandwidthUpdateUidLists(deniedUids, allowedUids, removedUids) == NETMANAGER_SUCCESS) {
+            continue;
+        }
+        NETMGR_LOG_E("BandwidthUpdateUidLists failed, %{public}zu uids are sent again on the next pass",
+                     deniedUids.size() + allowedUids.size() + removedUids.size());
+        failedUids.insert(deniedUids.begin(), deniedUids.end());
+        failedUids.insert(allowedUids.begin(), allowedUids.end());
+        failedUids.insert(removedUids.begin(), removedUids.end());
+    }
+}
+
+void NetPolicyRule::ApplyPowerSaveUids(const std::vector<uint32_t> &uids, uint32_t firewallRule,
+                                       std::unordered_set<uint32_t> &failedUids)
+{
+    size_t pos = 0;
+    while (pos < uids.size()) {
+        size_t room = NETSYS_UIDS_PER_REQUEST;
+        auto chunk = TakeUids(uids, pos, room);
+        if (GetNetsysInst()->PowerSaveUpdataAllowedList(chunk, firewallRule) != NETMANAGER_SUCCESS) {
+            NETMGR_LOG_E("PowerSaveUpdataAllowedList failed, %{public}zu uids are sent again on the next pass",
+                         chunk.size());
+            failedUids.insert(chunk.begin(), chunk.end());
+        }
+    }
+}
+
 uint32_t NetPolicyRule::GetMatchTransCondition(uint32_t policyCondition)
 {
     for (const auto &i : POLICY_TRANS_MAP) {
@@ -648,6 +648,17 @@ public:
      */
     int32_t BandwidthRemoveAllowedList(uint32_t uid) override;
 
+    /**
+     * Move a set of uids between the bandwidth denied and allowed lists in one transaction.
+     *
+     * @param deniedUids uids that end up only in the denied list
+     * @param allowedUids uids that end up only in the allowed list
+     * @param removedUids uids that end up in neither list
+     * @return Return the return value of the netsys interface call.
+     */
+    int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                                    const std::vector<uint32_t> &removedUids) override;
+
     /**
      * Set firewall rules.
      *
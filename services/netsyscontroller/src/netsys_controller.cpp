@@ -1063,6 +1063,21 @@ int32_t NetsysController::BandwidthRemoveAllowedList(uint32_t uid)
     return netsysService_->BandwidthRemoveAllowedList(uid);
 }
 
+int32_t NetsysController::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                  const std::vector<uint32_t> &allowedUids,
+                                                  const std::vector<uint32_t> &removedUids)
+{
+    NETMGR_LOG_D("NetsysController::BandwidthUpdateUidLists: denied=%{public}zu allowed=%{public}zu "
+                 "removed=%{public}zu", deniedUids.size(), allowedUids.size(), removedUids.size());
+    // LCOV_EXCL_START This will never happen.
+    if (netsysService_ == nullptr) {
+        NETMGR_LOG_E("netsysService_ is null");
+        return NETSYS_NETSYSSERVICE_NULL;
+    }
+    // LCOV_EXCL_STOP
+    return netsysService_->BandwidthUpdateUidLists(deniedUids, allowedUids, removedUids);
+}
+
 int32_t NetsysController::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     NETMGR_LOG_I("NetsysController::FirewallSetUidsAllowedListChain: chain=%{public}d", chain);
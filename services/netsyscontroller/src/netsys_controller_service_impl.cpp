@@ -664,6 +664,13 @@ int32_t NetsysControllerServiceImpl::BandwidthRemoveAllowedList(uint32_t uid)
     return netsysClient_->BandwidthRemoveAllowedList(uid);
 }
 
+int32_t NetsysControllerServiceImpl::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                             const std::vector<uint32_t> &allowedUids,
+                                                             const std::vector<uint32_t> &removedUids)
+{
+    return netsysClient_->BandwidthUpdateUidLists(deniedUids, allowedUids, removedUids);
+}
+
 int32_t NetsysControllerServiceImpl::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     NETMGR_LOG_D("FirewallSetUidsAllowedListChain: chain=%{public}d", chain);
@@ -1458,6 +1458,18 @@ int32_t NetsysNativeClient::BandwidthRemoveAllowedList(uint32_t uid)
     return proxy->BandwidthRemoveAllowedList(uid);
 }
 
+int32_t NetsysNativeClient::BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids,
+                                                    const std::vector<uint32_t> &allowedUids,
+                                                    const std::vector<uint32_t> &removedUids)
+{
+    auto proxy = GetProxy();
+    if (proxy == nullptr) {
+        NETMGR_LOG_E("proxy is nullptr");
+        return NETMANAGER_ERR_GET_PROXY_FAIL;
+    }
+    return proxy->BandwidthUpdateUidLists(deniedUids, allowedUids, removedUids);
+}
+
 int32_t NetsysNativeClient::FirewallSetUidsAllowedListChain(uint32_t chain, const std::vector<uint32_t> &uids)
 {
     auto proxy = GetProxy();
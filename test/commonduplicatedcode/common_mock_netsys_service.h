@@ -105,6 +105,8 @@ public:
     MOCK_METHOD(int32_t, BandwidthAddDeniedList, (uint32_t uid), (override));
     MOCK_METHOD(int32_t, BandwidthRemoveDeniedList, (uint32_t uid), (override));
     MOCK_METHOD(int32_t, BandwidthRemoveIfaceQuota, (const std::string &ifName), (override));
+    MOCK_METHOD(int32_t, BandwidthUpdateUidLists, (const std::vector<uint32_t> &deniedUids,
+        const std::vector<uint32_t> &allowedUids, const std::vector<uint32_t> &removedUids), (override));
     MOCK_METHOD(int32_t, FirewallSetUidsAllowedListChain,
         (uint32_t chain, const std::vector<uint32_t> &uids), (override));
     MOCK_METHOD(int32_t, FirewallSetUidsDeniedListChain,
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common_netns_test_util.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <sched.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace OHOS {
+namespace NetManagerStandard {
+namespace NetnsTestUtil {
+namespace {
+constexpr const char *NETNS_RUN_DIR = "/var/run/netns/";
+constexpr const char *NETSYS_PROCESS_NAME = "netsysnative";
+constexpr int32_t MS_PER_SECOND = 1000;
+constexpr int32_t US_PER_MS = 1000;
+
+bool EnterNetns(const std::string &netns)
+{
+    int fd = open(GetNetnsPath(netns).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    int ret = setns(fd, CLONE_NEWNET);
+    close(fd);
+    return ret == 0;
+}
+
+bool RemountSys()
+{
+    return unshare(CLONE_NEWNS) == 0 && mount(nullptr, "/", nullptr, MS_REC | MS_SLAVE, nullptr) == 0 &&
+        umount2("/sys", MNT_DETACH) == 0 && mount("sysfs", "/sys", "sysfs", 0, nullptr) == 0;
+}
+} // namespace
+
+bool RunCmd(const std::string &cmd)
+{
+    std::string quietCmd = cmd + " >/dev/null 2>&1";
+    return system(quietCmd.c_str()) == 0;
+}
+
+bool IsNetsysRunning()
+{
+    DIR *dir = opendir("/proc");
+    if (dir == nullptr) {
+        return false;
+    }
+    bool isRunning = false;
+    for (dirent *entry = readdir(dir); entry != nullptr && !isRunning; entry = readdir(dir)) {
+        std::ifstream comm(std::string("/proc/") + entry->d_name + "/comm");
+        std::string name;
+        isRunning = std::getline(comm, name) && name == NETSYS_PROCESS_NAME;
+    }
+    closedir(dir);
+    return isRunning;
+}
+
+std::string GetNetnsPath(const std::string &netns)
+{
+    return NETNS_RUN_DIR + netns;
+}
+
+bool AddNetns(const std::string &netns)
+{
+    DelNetns(netns);
+    return RunCmd("ip netns add " + netns) && RunCmd("ip -n " + netns + " link set lo up");
+}
+
+void DelNetns(const std::string &netns)
+{
+    RunCmd("ip netns del " + netns);
+}
+
+bool RunInNetns(const std::string &netns, const std::function<void()> &task, bool remountSys)
+{
+    bool isRun = false;
+    std::thread worker([&netns, &task, remountSys, &isRun]() {
+        if (!EnterNetns(netns) || (remountSys && !RemountSys())) {
+            return;
+        }
+        isRun = true;
+        task();
+    });
+    worker.join();
+    return isRun;
+}
+
+bool RunInNewNetns(const std::function<void()> &task)
+{
+    bool isRun = false;
+    std::thread worker([&task, &isRun]() {
+        // Needs CAP_SYS_ADMIN
+        if (unshare(CLONE_NEWNET) != 0) {
+            return;
+        }
+        isRun = true;
+        task();
+    });
+    worker.join();
+    return isRun;
+}
+
+int32_t OpenNetnsUdpSocket(const std::string &netns, const std::string &ip, uint16_t port, int32_t recvTimeoutMs)
+{
+    int32_t sock = -1;
+    RunInNetns(netns, [&sock, &ip, port, recvTimeoutMs]() {
+        sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+        timeval timeout = {recvTimeoutMs / MS_PER_SECOND, (recvTimeoutMs % MS_PER_SECOND) * US_PER_MS};
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            close(sock);
+            sock = -1;
+        }
+    });
+    return sock;
+}
+
+bool SetUpVethPeerNetns(const VethPeerConfig &config)
+{
+    std::string peerCmd = "ip -n " + config.netns + " ";
+    return AddNetns(config.netns) &&
+        RunCmd("ip link add " + config.localIface + " type veth peer name " + config.peerIface) &&
+        RunCmd("ip link set " + config.peerIface + " netns " + config.netns) &&
+        RunCmd("ip addr add " + config.localAddr + " dev " + config.localIface) &&
+        RunCmd("ip link set " + config.localIface + " up") &&
+        RunCmd(peerCmd + "addr add " + config.peerAddr + " dev " + config.peerIface) &&
+        RunCmd(peerCmd + "link set " + config.peerIface + " up");
+}
+
+void TearDownVethPeerNetns(const VethPeerConfig &config)
+{
+    RunCmd("ip link del " + config.localIface);
+    DelNetns(config.netns);
+}
+} // namespace NetnsTestUtil
+} // namespace NetManagerStandard
+} // namespace OHOS
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMMON_NETNS_TEST_UTIL_H
+#define COMMON_NETNS_TEST_UTIL_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace OHOS {
+namespace NetManagerStandard {
+namespace NetnsTestUtil {
+/* A veth pair with one end left in the calling namespace and the other one moved into a named namespace */
+struct VethPeerConfig {
+    std::string netns;
+    std::string localIface;
+    std::string peerIface;
+    // addresses with their prefix length, e.g. "198.18.1.1/24"
+    std::string localAddr;
+    std::string peerAddr;
+};
+
+// Runs the command through the shell with its output dropped, true if it exited with 0
+bool RunCmd(const std::string &cmd);
+
+// True if netsysnative runs, a test must not reset the pinned maps it works on
+bool IsNetsysRunning();
+
+std::string GetNetnsPath(const std::string &netns);
+
+// Adds the named namespace with its loopback up, a namespace left behind by an earlier run is replaced
+bool AddNetns(const std::string &netns);
+
+void DelNetns(const std::string &netns);
+
+/*
+ * Runs the task from a thread moved into the named namespace, the calling thread keeps its own. With remountSys
+ * the thread also gets its own sysfs mount the way ip netns exec does, so /sys/class/net lists the interfaces of
+ * the namespace. Returns false without running the task if the thread could not enter the namespace.
+ */
+bool RunInNetns(const std::string &netns, const std::function<void()> &task, bool remountSys = false);
+
+// Runs the task from a thread in a network namespace of its own, false if it could not be created
+bool RunInNewNetns(const std::function<void()> &task);
+
+// A UDP socket bound to ip:port in the named namespace, opened from a thread moved there, -1 on failure
+int32_t OpenNetnsUdpSocket(const std::string &netns, const std::string &ip, uint16_t port, int32_t recvTimeoutMs);
+
+bool SetUpVethPeerNetns(const VethPeerConfig &config);
+
+void TearDownVethPeerNetns(const VethPeerConfig &config);
+} // namespace NetnsTestUtil
+} // namespace NetManagerStandard
+} // namespace OHOS
+
+#endif // COMMON_NETNS_TEST_UTIL_H
@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <dirent.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifdef GTEST_API_
+#define private public
+#endif
+#include "net_manager_constants.h"
+#include "net_probe_event_loop.h"
+#include "tiny_count_down_latch.h"
+
+namespace OHOS {
+namespace NetManagerStandard {
+namespace {
+using namespace testing::ext;
+constexpr uint32_t TEST_NETID = 998;
+constexpr uint32_t TEST_OTHER_NETID = 997;
+constexpr int32_t HTTP_SUCCESS_CODE = 204;
+constexpr uint32_t PROBE_DEADLINE_MS = 10 * 1000;
+constexpr uint32_t SHORT_DEADLINE_MS = 300;
+constexpr int32_t PARALLEL_PROBE_NUM = 16;
+constexpr int32_t WAIT_RESULT_MS = 5 * 1000;
+constexpr int32_t STALL_SERVER_HOLD_MS = 8 * 1000;
+constexpr int32_t CERT_VALID_SECONDS = 3600;
+constexpr const char *RESPONSE_204 = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+int32_t GetThreadCount()
+{
+    int32_t count = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return -1;
+    }
+    while (readdir(dir) != nullptr) {
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+/* Loopback stand-in for the detection server: answers 204 or holds the connection without a reply */
+class ProbeStandInServer {
+public:
+    ProbeStandInServer(bool useTls, bool stall) : useTls_(useTls), stall_(stall) {}
+
+    ~ProbeStandInServer()
+    {
+        isRunning_ = false;
+        if (listenFd_ >= 0) {
+            shutdown(listenFd_, SHUT_RDWR);
+            close(listenFd_);
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (sslCtx_ != nullptr) {
+            SSL_CTX_free(sslCtx_);
+        }
+    }
+
+    bool Start()
+    {
+        if (useTls_ && !InitTls()) {
+            return false;
+        }
+        listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd_ < 0) {
+            return false;
+        }
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listenFd_, reinterpret_cast<sockaddr *>(&addr), len) != 0 || listen(listenFd_, SOMAXCONN) != 0 ||
+            getsockname(listenFd_, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        isRunning_ = true;
+        thread_ = std::thread([this]() { Serve(); });
+        return true;
+    }
+
+    std::string GetUrl() const
+    {
+        return std::string(useTls_ ? "https" : "http") + "://127.0.0.1:" + std::to_string(port_) + "/generate_204";
+    }
+
+    int32_t GetResumedHandshakes() const
+    {
+        return resumed_.load();
+    }
+
+private:
+    bool InitTls()
+    {
+        sslCtx_ = SSL_CTX_new(TLS_server_method());
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        X509 *cert = X509_new();
+        if (sslCtx_ == nullptr || key == nullptr || cert == nullptr) {
+            EVP_PKEY_free(key);
+            X509_free(cert);
+            return false;
+        }
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), CERT_VALID_SECONDS);
+        X509_set_pubkey(cert, key);
+        X509_NAME *name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("127.0.0.1"),
+            -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+        bool ret = SSL_CTX_use_certificate(sslCtx_, cert) == 1 && SSL_CTX_use_PrivateKey(sslCtx_, key) == 1;
+        SSL_CTX_set_session_cache_mode(sslCtx_, SSL_SESS_CACHE_SERVER);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        return ret;
+    }
+
+    void Serve()
+    {
+        std::vector<std::thread> workers;
+        while (isRunning_) {
+            int32_t fd = accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                break;
+            }
+            if (stall_) {
+                workers.emplace_back([this, fd]() { HandleConnection(fd); });
+            } else {
+                HandleConnection(fd);
+            }
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    void HandleConnection(int32_t fd)
+    {
+        SSL *ssl = nullptr;
+        if (useTls_) {
+            ssl = SSL_new(sslCtx_);
+            SSL_set_fd(ssl, fd);
+            if (SSL_accept(ssl) != 1) {
+                SSL_free(ssl);
+                close(fd);
+                return;
+            }
+            if (SSL_session_reused(ssl)) {
+                resumed_++;
+            }
+        }
+        char buffer[1024] = {0};
+        int32_t len = useTls_ ? SSL_read(ssl, buffer, sizeof(buffer)) : recv(fd, buffer, sizeof(buffer), 0);
+        if (len > 0 && stall_) {
+            for (int32_t waited = 0; waited < STALL_SERVER_HOLD_MS && isRunning_; waited += SHORT_DEADLINE_MS) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(SHORT_DEADLINE_MS));
+            }
+        } else if (len > 0 && useTls_) {
+            SSL_write(ssl, RESPONSE_204, strlen(RESPONSE_204));
+        } else if (len > 0) {
+            send(fd, RESPONSE_204, strlen(RESPONSE_204), 0);
+        }
+        if (ssl != nullptr) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+        close(fd);
+    }
+
+    bool useTls_ = false;
+    bool stall_ = false;
+    int32_t listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> isRunning_ = false;
+    std::atomic<int32_t> resumed_ = 0;
+    SSL_CTX *sslCtx_ = nullptr;
+    std::thread thread_;
+};
+
+size_t DiscardCallback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    return size * nitems;
+}
+
+CURL *CreateProbeHandle(const std::string &url)
+{
+    CURL *curl = curl_easy_init();
+    if (curl == nullptr) {
+        return nullptr;
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, DiscardCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, DiscardCallback);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(PROBE_DEADLINE_MS));
+    return curl;
+}
+
+struct ProbeOutcome {
+    std::atomic<int32_t> doneCount = 0;
+    std::atomic<int32_t> successCount = 0;
+    std::atomic<int32_t> abortedCount = 0;
+    std::atomic<int32_t> timeoutCount = 0;
+};
+
+int32_t AddTestProbe(const std::string &url, uint32_t netId, uint64_t groupId, uint32_t deadlineMs,
+    const std::shared_ptr<ProbeOutcome> &outcome, const std::shared_ptr<TinyCountDownLatch> &latch)
+{
+    CURL *curl = CreateProbeHandle(url);
+    int32_t ret = NetProbeEventLoop::GetInstance().AddProbe(curl, netId, "", groupId, deadlineMs,
+        [outcome, latch](CURL *easy, CURLcode code) {
+            long respCode = 0;
+            curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &respCode);
+            if (code == CURLE_OK && respCode == HTTP_SUCCESS_CODE) {
+                outcome->successCount++;
+            } else if (code == CURLE_ABORTED_BY_CALLBACK) {
+                outcome->abortedCount++;
+            } else if (code == CURLE_OPERATION_TIMEDOUT) {
+                outcome->timeoutCount++;
+            }
+            curl_easy_cleanup(easy);
+            outcome->doneCount++;
+            latch->CountDown();
+        });
+    if (ret != NETMANAGER_SUCCESS) {
+        curl_easy_cleanup(curl);
+    }
+    return ret;
+}
+} // namespace
+
+class NetProbeEventLoopTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void NetProbeEventLoopTest::SetUpTestCase()
+{
+    curl_global_init(CURL_GLOBAL_ALL);
+}
+
+void NetProbeEventLoopTest::TearDownTestCase()
+{
+    NetProbeEventLoop::GetInstance().ReleaseNetwork(TEST_NETID);
+    NetProbeEventLoop::GetInstance().ReleaseNetwork(TEST_OTHER_NETID);
+}
+
+void NetProbeEventLoopTest::SetUp() {}
+
+void NetProbeEventLoopTest::TearDown() {}
+
+HWTEST_F(NetProbeEventLoopTest, AddProbeTest001, TestSize.Level1)
+{
+    auto &loop = NetProbeEventLoop::GetInstance();
+    EXPECT_EQ(loop.AddProbe(nullptr, TEST_NETID, "", 0, PROBE_DEADLINE_MS, [](CURL *, CURLcode) {}),
+        NETMANAGER_ERR_INVALID_PARAMETER);
+    CURL *curl = curl_easy_init();
+    EXPECT_EQ(loop.AddProbe(curl, TEST_NETID, "", 0, PROBE_DEADLINE_MS, nullptr), NETMANAGER_ERR_INVALID_PARAMETER);
+    curl_easy_cleanup(curl);
+    EXPECT_NE(loop.CreateProbeGroup(), 0);
+}
+
+HWTEST_F(NetProbeEventLoopTest, ParallelProbeThreadCountTest001, TestSize.Level1)
+{
+    ProbeStandInServer httpServer(false, false);
+    ProbeStandInServer httpsServer(true, false);
+    ASSERT_TRUE(httpServer.Start());
+    ASSERT_TRUE(httpsServer.Start());
+
+    auto &loop = NetProbeEventLoop::GetInstance();
+    auto warmup = std::make_shared<ProbeOutcome>();
+    auto warmupLatch = std::make_shared<TinyCountDownLatch>(1);
+    ASSERT_EQ(AddTestProbe(httpServer.GetUrl(), TEST_NETID, 0, PROBE_DEADLINE_MS, warmup, warmupLatch),
+        NETMANAGER_SUCCESS);
+    warmupLatch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+
+    int32_t threadsBefore = GetThreadCount();
+    auto outcome = std::make_shared<ProbeOutcome>();
+    auto latch = std::make_shared<TinyCountDownLatch>(PARALLEL_PROBE_NUM);
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < PARALLEL_PROBE_NUM; i++) {
+        const std::string url = (i % 2 == 0) ? httpServer.GetUrl() : httpsServer.GetUrl();
+        ASSERT_EQ(AddTestProbe(url, TEST_NETID, 0, PROBE_DEADLINE_MS, outcome, latch), NETMANAGER_SUCCESS);
+    }
+    int32_t threadsDuring = GetThreadCount();
+    latch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+    auto costMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(outcome->successCount.load(), PARALLEL_PROBE_NUM);
+    EXPECT_EQ(loop.GetProbeCount(), 0);
+    /* the answering stand-in servers serve on their accept thread, so any new thread would come from the probes */
+    EXPECT_EQ(threadsDuring, threadsBefore);
+    std::cout << "probes:" << PARALLEL_PROBE_NUM << " threads before:" << threadsBefore << " during:" <<
+        threadsDuring << " verdict ms:" << costMs.count() << std::endl;
+}
+
+HWTEST_F(NetProbeEventLoopTest, TlsSessionReuseTest001, TestSize.Level1)
+{
+    ProbeStandInServer httpsServer(true, false);
+    ASSERT_TRUE(httpsServer.Start());
+    for (int32_t i = 0; i < 3; i++) {
+        auto outcome = std::make_shared<ProbeOutcome>();
+        auto latch = std::make_shared<TinyCountDownLatch>(1);
+        ASSERT_EQ(AddTestProbe(httpsServer.GetUrl(), TEST_OTHER_NETID, 0, PROBE_DEADLINE_MS, outcome, latch),
+            NETMANAGER_SUCCESS);
+        latch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+        EXPECT_EQ(outcome->successCount.load(), 1);
+    }
+    EXPECT_GT(httpsServer.GetResumedHandshakes(), 0);
+}
+
+HWTEST_F(NetProbeEventLoopTest, CancelProbeGroupTest001, TestSize.Level1)
+{
+    ProbeStandInServer httpsServer(true, false);
+    ProbeStandInServer stallServer(false, true);
+    ASSERT_TRUE(httpsServer.Start());
+    ASSERT_TRUE(stallServer.Start());
+
+    auto &loop = NetProbeEventLoop::GetInstance();
+    uint64_t group = loop.CreateProbeGroup();
+    auto outcome = std::make_shared<ProbeOutcome>();
+    auto verdictLatch = std::make_shared<TinyCountDownLatch>(1);
+    auto allLatch = std::make_shared<TinyCountDownLatch>(2);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(AddTestProbe(stallServer.GetUrl(), TEST_NETID, group, PROBE_DEADLINE_MS, outcome, allLatch),
+        NETMANAGER_SUCCESS);
+    CURL *curl = CreateProbeHandle(httpsServer.GetUrl());
+    ASSERT_EQ(loop.AddProbe(curl, TEST_NETID, "", group, PROBE_DEADLINE_MS,
+        [outcome, verdictLatch, allLatch](CURL *easy, CURLcode code) {
+            if (code == CURLE_OK) {
+                outcome->successCount++;
+            }
+            curl_easy_cleanup(easy);
+            verdictLatch->CountDown();
+            allLatch->CountDown();
+        }), NETMANAGER_SUCCESS);
+
+    verdictLatch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+    auto verdictMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    loop.CancelProbeGroup(group);
+    allLatch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+    auto drainMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    EXPECT_EQ(outcome->successCount.load(), 1);
+    EXPECT_EQ(outcome->abortedCount.load(), 1);
+    EXPECT_LT(drainMs.count(), STALL_SERVER_HOLD_MS);
+    std::cout << "time to verdict ms:" << verdictMs.count() << " losers drained ms:" << drainMs.count() << std::endl;
+
+    CURL *late = curl_easy_init();
+    EXPECT_EQ(loop.AddProbe(late, TEST_NETID, "", group, PROBE_DEADLINE_MS, [](CURL *, CURLcode) {}),
+        NETMANAGER_ERR_OPERATION_FAILED);
+    curl_easy_cleanup(late);
+}
+
+HWTEST_F(NetProbeEventLoopTest, CancelProbeGroupTest002, TestSize.Level1)
+{
+    ProbeStandInServer httpsServer(true, false);
+    ASSERT_TRUE(httpsServer.Start());
+
+    auto &loop = NetProbeEventLoop::GetInstance();
+    uint64_t group = loop.CreateProbeGroup();
+    auto enteredLatch = std::make_shared<TinyCountDownLatch>(1);
+    auto isPublished = std::make_shared<std::atomic<bool>>(false);
+    CURL *curl = CreateProbeHandle(httpsServer.GetUrl());
+    ASSERT_EQ(loop.AddProbe(curl, TEST_NETID, "", group, PROBE_DEADLINE_MS,
+        [enteredLatch, isPublished](CURL *easy, CURLcode code) {
+            enteredLatch->CountDown();
+            std::this_thread::sleep_for(std::chrono::milliseconds(SHORT_DEADLINE_MS));
+            *isPublished = (code == CURLE_OK);
+            curl_easy_cleanup(easy);
+        }), NETMANAGER_SUCCESS);
+
+    enteredLatch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+    loop.CancelProbeGroup(group);
+    EXPECT_TRUE(isPublished->load());
+}
+
+HWTEST_F(NetProbeEventLoopTest, ProbeDeadlineTest001, TestSize.Level1)
+{
+    ProbeStandInServer stallServer(false, true);
+    ASSERT_TRUE(stallServer.Start());
+    auto outcome = std::make_shared<ProbeOutcome>();
+    auto latch = std::make_shared<TinyCountDownLatch>(1);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(AddTestProbe(stallServer.GetUrl(), TEST_NETID, 0, SHORT_DEADLINE_MS, outcome, latch),
+        NETMANAGER_SUCCESS);
+    latch->Await(std::chrono::milliseconds(WAIT_RESULT_MS));
+    auto costMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    EXPECT_EQ(outcome->timeoutCount.load(), 1);
+    EXPECT_LT(costMs.count(), WAIT_RESULT_MS);
+}
+
+HWTEST_F(NetProbeEventLoopTest, AddrCacheTest001, TestSize.Level1)
+{
+    auto &loop = NetProbeEventLoop::GetInstance();
+    std::string addrList;
+    EXPECT_FALSE(loop.GetCachedAddrInfo(TEST_NETID, "probe.example.com", addrList));
+    loop.SetCachedAddrInfo(TEST_NETID, "probe.example.com", "192.0.2.1,2001:db8::1");
+    EXPECT_TRUE(loop.GetCachedAddrInfo(TEST_NETID, "probe.example.com", addrList));
+    EXPECT_EQ(addrList, "192.0.2.1,2001:db8::1");
+    EXPECT_FALSE(loop.GetCachedAddrInfo(TEST_OTHER_NETID, "probe.example.com", addrList));
+    loop.ReleaseNetwork(TEST_NETID);
+    EXPECT_FALSE(loop.GetCachedAddrInfo(TEST_NETID, "probe.example.com", addrList));
+}
+} // namespace NetManagerStandard
+} // namespace OHOS
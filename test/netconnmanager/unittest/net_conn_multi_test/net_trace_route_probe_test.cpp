@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "net_trace_route_probe.h"
+
+namespace OHOS {
+namespace NetManagerStandard {
+namespace {
+using namespace testing::ext;
+constexpr int32_t MAX_JUMP_NUMBER = 30;
+constexpr int32_t PACKETS_TYPE_ICMP = 0;
+constexpr int64_t BURST_TRACE_LIMIT_MS = 2500;
+constexpr int32_t LINK_SETTLE_MS = 1000;
+constexpr const char *CLIENT_NETNS_PATH = "/var/run/netns/trcli";
+constexpr const char *DEST_IPV4 = "10.201.3.2";
+constexpr const char *DEST_IPV6 = "fd00:201:3::2";
+
+/*
+ * trcli --veth-- trr1 --veth-- trr2 --veth-- trdst
+ * trr1 and trr2 forward between their links and answer expiring probes with Time Exceeded.
+ */
+const std::vector<std::string> TOPOLOGY_SETUP_CMDS = {
+    "ip netns add trcli", "ip netns add trr1", "ip netns add trr2", "ip netns add trdst",
+    "ip link add c0 netns trcli type veth peer name r1a netns trr1",
+    "ip link add r1b netns trr1 type veth peer name r2a netns trr2",
+    "ip link add r2b netns trr2 type veth peer name d0 netns trdst",
+    "ip -n trcli addr add 10.201.1.1/24 dev c0",
+    "ip -n trcli -6 addr add fd00:201:1::1/64 dev c0 nodad",
+    "ip -n trr1 addr add 10.201.1.2/24 dev r1a",
+    "ip -n trr1 -6 addr add fd00:201:1::2/64 dev r1a nodad",
+    "ip -n trr1 addr add 10.201.2.1/24 dev r1b",
+    "ip -n trr1 -6 addr add fd00:201:2::1/64 dev r1b nodad",
+    "ip -n trr2 addr add 10.201.2.2/24 dev r2a",
+    "ip -n trr2 -6 addr add fd00:201:2::2/64 dev r2a nodad",
+    "ip -n trr2 addr add 10.201.3.1/24 dev r2b",
+    "ip -n trr2 -6 addr add fd00:201:3::1/64 dev r2b nodad",
+    "ip -n trdst addr add 10.201.3.2/24 dev d0",
+    "ip -n trdst -6 addr add fd00:201:3::2/64 dev d0 nodad",
+    "ip -n trcli link set c0 up", "ip -n trr1 link set r1a up", "ip -n trr1 link set r1b up",
+    "ip -n trr2 link set r2a up", "ip -n trr2 link set r2b up", "ip -n trdst link set d0 up",
+    "ip -n trcli route add default via 10.201.1.2",
+    "ip -n trcli -6 route add default via fd00:201:1::2",
+    "ip -n trr1 route add default via 10.201.2.2",
+    "ip -n trr1 -6 route add default via fd00:201:2::2",
+    "ip -n trr2 route add default via 10.201.2.1",
+    "ip -n trr2 -6 route add default via fd00:201:2::1",
+    "ip -n trdst route add default via 10.201.3.1",
+    "ip -n trdst -6 route add default via fd00:201:3::1",
+    "ip netns exec trr1 sysctl -qw net.ipv4.ip_forward=1 net.ipv6.conf.all.forwarding=1",
+    "ip netns exec trr2 sysctl -qw net.ipv4.ip_forward=1 net.ipv6.conf.all.forwarding=1",
+    "ip netns exec trr1 sysctl -qw net.ipv4.icmp_ratelimit=0 net.ipv6.icmp.ratelimit=0",
+    "ip netns exec trr2 sysctl -qw net.ipv4.icmp_ratelimit=0 net.ipv6.icmp.ratelimit=0",
+};
+
+const std::vector<std::string> TOPOLOGY_CLEANUP_CMDS = {
+    "ip netns del trcli", "ip netns del trr1", "ip netns del trr2", "ip netns del trdst",
+};
+
+bool RunCmds(const std::vector<std::string> &cmds)
+{
+    for (const auto &cmd : cmds) {
+        std::string quietCmd = cmd + " >/dev/null 2>&1";
+        if (system(quietCmd.c_str()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Run the trace from a thread moved into the client namespace, the test thread keeps its own namespace */
+std::string TraceInClientNetns(const std::string &destination, int64_t &elapsedMs)
+{
+    std::string traceRouteInfo;
+    std::thread worker([&]() {
+        int fd = open(CLIENT_NETNS_PATH, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        int ret = setns(fd, CLONE_NEWNET);
+        close(fd);
+        if (ret != 0) {
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        QueryTraceRouteProbeResult(destination, MAX_JUMP_NUMBER, PACKETS_TYPE_ICMP, traceRouteInfo);
+        elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    });
+    worker.join();
+    return traceRouteInfo;
+}
+
+/* traceRouteInfo is a sequence of "ttl ip max;min;avg;std " records */
+std::vector<std::pair<int32_t, std::string>> ParseHops(const std::string &traceRouteInfo)
+{
+    std::vector<std::pair<int32_t, std::string>> hops;
+    std::istringstream stream(traceRouteInfo);
+    int32_t ttl = 0;
+    std::string ip;
+    std::string rtt;
+    while (stream >> ttl >> ip >> rtt) {
+        hops.emplace_back(ttl, ip);
+    }
+    return hops;
+}
+} // namespace
+
+class NetTraceRouteProbeTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+
+    static inline bool isTopologyReady_ = false;
+};
+
+void NetTraceRouteProbeTest::SetUpTestCase()
+{
+    if (getuid() != 0) {
+        GTEST_SKIP() << "needs root";
+    }
+    RunCmds(TOPOLOGY_CLEANUP_CMDS);
+    isTopologyReady_ = RunCmds(TOPOLOGY_SETUP_CMDS);
+    if (!isTopologyReady_) {
+        RunCmds(TOPOLOGY_CLEANUP_CMDS);
+        return;
+    }
+    // IPv6 on a fresh veth only starts forwarding once addrconf has seen the carrier come up
+    std::this_thread::sleep_for(std::chrono::milliseconds(LINK_SETTLE_MS));
+    // Resolve the neighbours along the chain, a burst reaching a router with an unresolved next hop
+    // is mostly dropped from the neighbour queue
+    int64_t elapsedMs = 0;
+    TraceInClientNetns(DEST_IPV4, elapsedMs);
+    TraceInClientNetns(DEST_IPV6, elapsedMs);
+}
+
+void NetTraceRouteProbeTest::TearDownTestCase()
+{
+    if (isTopologyReady_) {
+        RunCmds(TOPOLOGY_CLEANUP_CMDS);
+    }
+}
+
+void NetTraceRouteProbeTest::SetUp() {}
+
+void NetTraceRouteProbeTest::TearDown() {}
+
+HWTEST_F(NetTraceRouteProbeTest, TraceRouteIpv4Test001, TestSize.Level1)
+{
+    if (!isTopologyReady_) {
+        GTEST_SKIP() << "needs root and the trace route namespaces";
+    }
+    int64_t elapsedMs = 0;
+    auto hops = ParseHops(TraceInClientNetns(DEST_IPV4, elapsedMs));
+    ASSERT_EQ(hops.size(), 3U);
+    EXPECT_EQ(hops[0], std::make_pair(1, std::string("10.201.1.2")));
+    EXPECT_EQ(hops[1], std::make_pair(2, std::string("10.201.2.2")));
+    EXPECT_EQ(hops[2], std::make_pair(3, std::string(DEST_IPV4)));
+    EXPECT_LT(elapsedMs, BURST_TRACE_LIMIT_MS);
+}
+
+HWTEST_F(NetTraceRouteProbeTest, TraceRouteIpv6Test001, TestSize.Level1)
+{
+    if (!isTopologyReady_) {
+        GTEST_SKIP() << "needs root and the trace route namespaces";
+    }
+    int64_t elapsedMs = 0;
+    auto hops = ParseHops(TraceInClientNetns(DEST_IPV6, elapsedMs));
+    ASSERT_EQ(hops.size(), 3U);
+    EXPECT_EQ(hops[0], std::make_pair(1, std::string("fd00:201:1::2")));
+    EXPECT_EQ(hops[1], std::make_pair(2, std::string("fd00:201:2::2")));
+    EXPECT_EQ(hops[2], std::make_pair(3, std::string(DEST_IPV6)));
+}
+
+HWTEST_F(NetTraceRouteProbeTest, TraceRouteSilentTargetTest001, TestSize.Level1)
+{
+    if (!isTopologyReady_) {
+        GTEST_SKIP() << "needs root and the trace route namespaces";
+    }
+    ASSERT_TRUE(RunCmds({"ip netns exec trdst sysctl -qw net.ipv4.icmp_echo_ignore_all=1"}));
+    int64_t elapsedMs = 0;
+    auto hops = ParseHops(TraceInClientNetns(DEST_IPV4, elapsedMs));
+    RunCmds({"ip netns exec trdst sysctl -qw net.ipv4.icmp_echo_ignore_all=0"});
+    // two routers answer, the silent hops stop the trace after three timeouts
+    ASSERT_EQ(hops.size(), 5U);
+    EXPECT_EQ(hops[0].second, "10.201.1.2");
+    EXPECT_EQ(hops[1].second, "10.201.2.2");
+    EXPECT_EQ(hops[2].second, "*.*.*.*");
+    EXPECT_EQ(hops[4].first, 5);
+    // one wait window for the whole path instead of one per silent hop
+    EXPECT_LT(elapsedMs, BURST_TRACE_LIMIT_MS);
+}
+
+HWTEST_F(NetTraceRouteProbeTest, TraceRouteConcurrentTest001, TestSize.Level1)
+{
+    if (!isTopologyReady_) {
+        GTEST_SKIP() << "needs root and the trace route namespaces";
+    }
+    std::string traceV4;
+    std::string traceV4Again;
+    int64_t elapsedMs = 0;
+    int64_t elapsedAgainMs = 0;
+    std::thread first([&]() { traceV4 = TraceInClientNetns(DEST_IPV4, elapsedMs); });
+    std::thread second([&]() { traceV4Again = TraceInClientNetns(DEST_IPV4, elapsedAgainMs); });
+    first.join();
+    second.join();
+    // replies are matched on the ICMP id, concurrent traces do not steal each other's answers
+    auto hops = ParseHops(traceV4);
+    auto hopsAgain = ParseHops(traceV4Again);
+    ASSERT_EQ(hops.size(), 3U);
+    ASSERT_EQ(hopsAgain.size(), 3U);
+    EXPECT_EQ(hops[2].second, DEST_IPV4);
+    EXPECT_EQ(hopsAgain[2].second, DEST_IPV4);
+}
+
+HWTEST_F(NetTraceRouteProbeTest, TraceRouteInvalidJumpTest001, TestSize.Level1)
+{
+    std::string traceRouteInfo;
+    EXPECT_EQ(QueryTraceRouteProbeResult("127.0.0.1", 0, PACKETS_TYPE_ICMP, traceRouteInfo), 0);
+    EXPECT_TRUE(traceRouteInfo.empty());
+}
+} // namespace NetManagerStandard
+} // namespace OHOS
@@ -13,8 +13,18 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <sys/stat.h>
 #include <gtest/gtest.h>
 #include "cJSON.h"
+#include "openssl/evp.h"
+#include "openssl/pem.h"
+#include "openssl/x509.h"
 
 #ifdef GTEST_API_
 #define private public
@@ -25,6 +35,7 @@
 #include "net_mgr_log_wrapper.h"
 #include "net_manager_constants.h"
 #include "network_security_config.h"
+#include "netmanager_base_common_utils.h"
 
 namespace OHOS {
 namespace NetManagerStandard {
@@ -47,6 +58,91 @@ namespace {
                     ]})");
     
     const std::string TEST_CLEARTEXT_TRAFFIC_PERMITTED(R"([{"cleartextTrafficPermitted": false}])");
+
+    const std::vector<std::string> TEST_DOMAIN_NAMES = {"example.com", "a.example.com", "b.a.example.com",
+        "*.example.com", "*.a.example.com", "*", "api*.example.com", "*.example.*", "*a*", "ex ample.com",
+        "*.", "**.example.com", "example.org", "*.org", "a.example.org", ".example.com", "*..example.com"};
+    const std::vector<std::string> TEST_HOST_NAMES = {"example.com", "a.example.com", "b.a.example.com",
+        "c.b.a.example.com", "api.example.com", "api1.example.com", "api.a.example.com", "example.org",
+        "a.example.org", "x.org", "org", ".example.com", "..example.com", "example.com.", "ex ample.com",
+        "*.example.com", "*", "apiexample.com", "example.net", "a"};
+    constexpr int32_t DIFF_ROUNDS = 200;
+    constexpr int32_t DIFF_MAX_CONFIGS = 12;
+    constexpr int32_t DIFF_MAX_DOMAINS = 4;
+    constexpr int32_t BENCH_CONFIG_NUM = 500;
+    constexpr int32_t BENCH_LOOKUPS = 20000;
+    constexpr int32_t BENCH_CA_CERT_NUM = 500;
+    const std::string BENCH_CA_PATH("/data/storage/el2/base/files/bench_ca_certs");
+
+    /* The domain matching as it was before the trie: the regex built from the name, first config wins */
+    bool ReferenceUrlRegexParse(const std::string &str, const std::string &patternStr)
+    {
+        if (patternStr.empty()) {
+            return false;
+        }
+        if (patternStr == "*") {
+            return true;
+        }
+        if (!std::regex_match(patternStr, std::regex("^[a-zA-Z0-9\\-_\\.*]+$"))) {
+            return patternStr == str;
+        }
+        return std::regex_match(str, std::regex(CommonUtils::ReplaceCharacters(patternStr)));
+    }
+
+    int32_t ReferenceFindDomainConfig(const std::vector<DomainConfig> &configs, const std::string &hostname)
+    {
+        for (size_t i = 0; i < configs.size(); ++i) {
+            for (const auto &domain : configs[i].domains_) {
+                if (hostname == domain.domainName_ ||
+                    (domain.includeSubDomains_ && ReferenceUrlRegexParse(hostname, domain.domainName_))) {
+                    return static_cast<int32_t>(i);
+                }
+            }
+        }
+        return -1;
+    }
+
+    /* A self-signed CA cert in PEM, the subject is CN=<commonName> */
+    std::string MakeCACertPem(EVP_PKEY *key, const std::string &commonName)
+    {
+        std::string pem;
+        X509 *x509 = X509_new();
+        X509_NAME *name = X509_NAME_new();
+        if (x509 != nullptr && name != nullptr &&
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                reinterpret_cast<const unsigned char *>(commonName.c_str()), -1, -1, 0) == 1 &&
+            X509_set_version(x509, 2) == 1 && X509_set_subject_name(x509, name) == 1 &&
+            X509_set_issuer_name(x509, name) == 1 && X509_gmtime_adj(X509_getm_notBefore(x509), 0) != nullptr &&
+            X509_gmtime_adj(X509_getm_notAfter(x509), 3600) != nullptr && X509_set_pubkey(x509, key) == 1 &&
+            X509_sign(x509, key, EVP_sha256()) > 0) {
+            BIO *bio = BIO_new(BIO_s_mem());
+            char *data = nullptr;
+            if (bio != nullptr && PEM_write_bio_X509(bio, x509) == 1) {
+                long len = BIO_get_mem_data(bio, &data);
+                pem.assign(data, len);
+            }
+            BIO_free(bio);
+        }
+        X509_NAME_free(name);
+        X509_free(x509);
+        return pem;
+    }
+
+    bool WriteTestFile(const std::string &fileName, const std::string &content)
+    {
+        std::ofstream file(fileName, std::ios::trunc);
+        file << content;
+        return file.good();
+    }
+
+    size_t CountRehashedCerts(const std::string &rehashedCertpath)
+    {
+        size_t count = 0;
+        for (const auto &entry : std::filesystem::directory_iterator(rehashedCertpath)) {
+            count += entry.path().filename().string()[0] != '.' ? 1 : 0;
+        }
+        return count;
+    }
 } // namespace
 
 std::shared_ptr<NetworkSecurityConfig> g_networkSecurityConfig;
@@ -699,5 +795,214 @@ HWTEST_F(NetworkSecurityConfigTest, ParseJsonComponentCfg003, TestSize.Level1)
     NetworkSecurityConfig::GetInstance().ParseJsonComponentCfg(root, componentCfg);
     EXPECT_FALSE(componentCfg["ArkWeb"]);
 }
+
+/**
+ * @tc.name: FindDomainConfigIndexDiffTest001
+ * @tc.desc: Test NetworkSecurityConfig::FindDomainConfigIndex against the linear regex matching
+ * @tc.type: FUNC
+ */
+HWTEST_F(NetworkSecurityConfigTest, FindDomainConfigIndexDiffTest001, TestSize.Level1)
+{
+    std::mt19937 rng(0);
+    for (int32_t round = 0; round < DIFF_ROUNDS; ++round) {
+        NetworkSecurityConfig networksecurityconfig;
+        networksecurityconfig.domainConfigs_.clear();
+        int32_t configNum = static_cast<int32_t>(rng() % DIFF_MAX_CONFIGS) + 1;
+        for (int32_t i = 0; i < configNum; ++i) {
+            DomainConfig config;
+            int32_t domainNum = static_cast<int32_t>(rng() % DIFF_MAX_DOMAINS) + 1;
+            for (int32_t j = 0; j < domainNum; ++j) {
+                Domain domain;
+                domain.domainName_ = TEST_DOMAIN_NAMES[rng() % TEST_DOMAIN_NAMES.size()];
+                domain.includeSubDomains_ = rng() % 2 == 0;
+                config.domains_.push_back(domain);
+            }
+            networksecurityconfig.domainConfigs_.push_back(config);
+        }
+        for (const auto &hostname : TEST_HOST_NAMES) {
+            int32_t expected = ReferenceFindDomainConfig(networksecurityconfig.domainConfigs_, hostname);
+            EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex(hostname), expected) << hostname;
+            EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex(hostname), expected) << hostname;
+        }
+    }
+}
+
+/**
+ * @tc.name: FindDomainConfigIndexTest001
+ * @tc.desc: Test NetworkSecurityConfig::FindDomainConfigIndex after the configs change
+ * @tc.type: FUNC
+ */
+HWTEST_F(NetworkSecurityConfigTest, FindDomainConfigIndexTest001, TestSize.Level1)
+{
+    NetworkSecurityConfig networksecurityconfig;
+    networksecurityconfig.domainConfigs_.clear();
+    EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex("a.example.com"), -1);
+    DomainConfig config;
+    Domain domain;
+    domain.domainName_ = "*.example.com";
+    domain.includeSubDomains_ = true;
+    config.domains_.push_back(domain);
+    config.cleartextTrafficPermitted_ = false;
+    networksecurityconfig.domainConfigs_.push_back(config);
+    networksecurityconfig.OnDomainConfigsChanged();
+    DomainConfig found;
+    EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex("a.example.com", &found), 0);
+    EXPECT_FALSE(found.cleartextTrafficPermitted_);
+    EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex("example.com"), -1);
+}
+
+/**
+ * @tc.name: HandshakeLookupBenchmarkTest001
+ * @tc.desc: Compare the per handshake lookups with the linear regex matching on a large config
+ * @tc.type: PERF
+ */
+HWTEST_F(NetworkSecurityConfigTest, HandshakeLookupBenchmarkTest001, TestSize.Level1)
+{
+    NetworkSecurityConfig networksecurityconfig;
+    networksecurityconfig.domainConfigs_.clear();
+    std::vector<std::string> hostnames;
+    for (int32_t i = 0; i < BENCH_CONFIG_NUM; ++i) {
+        DomainConfig config;
+        Domain exact;
+        exact.domainName_ = "svc" + std::to_string(i) + ".example.com";
+        exact.includeSubDomains_ = false;
+        Domain wildcard;
+        wildcard.domainName_ = "*.svc" + std::to_string(i) + ".corp.example.com";
+        wildcard.includeSubDomains_ = true;
+        config.domains_.push_back(exact);
+        config.domains_.push_back(wildcard);
+        networksecurityconfig.domainConfigs_.push_back(config);
+        hostnames.push_back("api.svc" + std::to_string(i) + ".corp.example.com");
+    }
+    hostnames.push_back("unknown.example.net");
+
+    constexpr int32_t referenceLookups = 20;
+    int32_t matched = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < referenceLookups; ++i) {
+        const auto &hostname = hostnames[hostnames.size() - 1 - i % hostnames.size()];
+        matched += ReferenceFindDomainConfig(networksecurityconfig.domainConfigs_, hostname) >= 0 ? 1 : 0;
+    }
+    EXPECT_GT(matched, 0);
+    double referenceUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex(hostnames.front()), 0);
+    start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+        matched += networksecurityconfig.MatchDomainIndex(hostnames[i % hostnames.size()]) >= 0 ? 1 : 0;
+    }
+    double trieUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+        std::string pins;
+        networksecurityconfig.GetPinSetForHostName(hostnames[i % hostnames.size()], pins);
+    }
+    double memoUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(networksecurityconfig.FindDomainConfigIndex(hostnames.back()), -1);
+    std::cout << "linear regex " << referenceUs / referenceLookups << " us, trie " << trieUs / BENCH_LOOKUPS
+              << " us, memo " << memoUs / BENCH_LOOKUPS << " us per lookup" << std::endl;
+}
+
+/**
+ * @tc.name: ReHashCAPathBenchmarkTest001
+ * @tc.desc: Compare rehashing a trust store of many CA certs with reusing it through the index, then change it
+ * @tc.type: PERF
+ */
+HWTEST_F(NetworkSecurityConfigTest, ReHashCAPathBenchmarkTest001, TestSize.Level1)
+{
+    std::error_code ec;
+    std::filesystem::remove_all(BENCH_CA_PATH, ec);
+    if (!std::filesystem::create_directories(BENCH_CA_PATH, ec)) {
+        return;
+    }
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    ASSERT_NE(key, nullptr);
+    for (int32_t i = 0; i < BENCH_CA_CERT_NUM; ++i) {
+        auto pem = MakeCACertPem(key, "Bench CA " + std::to_string(i));
+        ASSERT_FALSE(pem.empty());
+        ASSERT_TRUE(WriteTestFile(BENCH_CA_PATH + "/ca" + std::to_string(i) + ".pem", pem));
+    }
+    NetworkSecurityConfig networksecurityconfig;
+    auto stalePath = networksecurityconfig.GetRehasedCAPath(BENCH_CA_PATH);
+    if (!stalePath.empty()) {
+        std::filesystem::remove_all(stalePath, ec);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto rehashedCertpath = networksecurityconfig.ReHashCAPathForX509(BENCH_CA_PATH);
+    double coldUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_NE(rehashedCertpath, "");
+    EXPECT_EQ(CountRehashedCerts(rehashedCertpath), static_cast<size_t>(BENCH_CA_CERT_NUM));
+
+    struct stat before = {};
+    stat(rehashedCertpath.c_str(), &before);
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(networksecurityconfig.ReHashCAPathForX509(BENCH_CA_PATH), rehashedCertpath);
+    double warmUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    struct stat after = {};
+    stat(rehashedCertpath.c_str(), &after);
+    EXPECT_EQ(before.st_mtim.tv_sec, after.st_mtim.tv_sec);
+    EXPECT_EQ(before.st_mtim.tv_nsec, after.st_mtim.tv_nsec);
+    EXPECT_LT(warmUs, coldUs);
+    std::cout << BENCH_CA_CERT_NUM << " CA certs, rehash " << coldUs / 1000 << " ms, indexed " << warmUs / 1000
+              << " ms" << std::endl;
+
+    // A cert rewritten in place replaces its copy, a removed one takes its copy along
+    auto replaced = MakeCACertPem(key, "Bench CA replaced");
+    ASSERT_TRUE(WriteTestFile(BENCH_CA_PATH + "/ca0.pem", replaced));
+    std::filesystem::remove(BENCH_CA_PATH + "/ca1.pem", ec);
+    EXPECT_EQ(networksecurityconfig.ReHashCAPathForX509(BENCH_CA_PATH), rehashedCertpath);
+    EXPECT_EQ(CountRehashedCerts(rehashedCertpath), static_cast<size_t>(BENCH_CA_CERT_NUM - 1));
+    bool found = false;
+    for (const auto &entry : std::filesystem::directory_iterator(rehashedCertpath)) {
+        std::ifstream file(entry.path());
+        std::stringstream content;
+        content << file.rdbuf();
+        found = found || content.str() == replaced;
+    }
+    EXPECT_TRUE(found);
+    EVP_PKEY_free(key);
+    std::filesystem::remove_all(BENCH_CA_PATH, ec);
+    std::filesystem::remove_all(rehashedCertpath, ec);
+}
+
+/**
+ * @tc.name: ReHashCAPathTempFileTest001
+ * @tc.desc: Test a rebuild of the rehashed dir only removes stale copies, not the temporary files of other processes
+ * @tc.type: FUNC
+ */
+HWTEST_F(NetworkSecurityConfigTest, ReHashCAPathTempFileTest001, TestSize.Level1)
+{
+    std::error_code ec;
+    std::filesystem::remove_all(BENCH_CA_PATH, ec);
+    if (!std::filesystem::create_directories(BENCH_CA_PATH, ec)) {
+        GTEST_SKIP() << "cannot create " << BENCH_CA_PATH;
+    }
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    ASSERT_NE(key, nullptr);
+    ASSERT_TRUE(WriteTestFile(BENCH_CA_PATH + "/ca0.pem", MakeCACertPem(key, "Temp CA 0")));
+    NetworkSecurityConfig networksecurityconfig;
+    auto rehashedCertpath = networksecurityconfig.ReHashCAPathForX509(BENCH_CA_PATH);
+    ASSERT_NE(rehashedCertpath, "");
+    EXPECT_TRUE(std::filesystem::exists(rehashedCertpath + "/.lock"));
+
+    // What another process of the app leaves in the dir while it is still writing
+    const std::vector<std::string> inFlight = {"0a1b2c3d.0.4242", ".ca_index.4242"};
+    for (const auto &name : inFlight) {
+        ASSERT_TRUE(WriteTestFile(rehashedCertpath + "/" + name, "in flight"));
+    }
+    ASSERT_TRUE(WriteTestFile(rehashedCertpath + "/0a1b2c3d.3", "stale"));
+    ASSERT_TRUE(WriteTestFile(BENCH_CA_PATH + "/ca1.pem", MakeCACertPem(key, "Temp CA 1")));
+    EXPECT_EQ(networksecurityconfig.ReHashCAPathForX509(BENCH_CA_PATH), rehashedCertpath);
+    for (const auto &name : inFlight) {
+        EXPECT_TRUE(std::filesystem::exists(rehashedCertpath + "/" + name)) << name;
+    }
+    EXPECT_FALSE(std::filesystem::exists(rehashedCertpath + "/0a1b2c3d.3"));
+    EVP_PKEY_free(key);
+    std::filesystem::remove_all(BENCH_CA_PATH, ec);
+    std::filesystem::remove_all(rehashedCertpath, ec);
+}
 }
 }
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "net_pac_manager.h"
+
+using namespace OHOS::NetManagerStandard;
+
+namespace {
+constexpr int32_t BENCH_RULE_NUM = 200;
+constexpr int32_t BENCH_LOOKUPS = 200;
+constexpr int32_t PATHOLOGICAL_STAR_NUM = 30;
+constexpr size_t PATHOLOGICAL_STR_LEN = 5000;
+constexpr int64_t PATHOLOGICAL_LIMIT_MS = 100;
+
+std::string Evaluate(const std::string &expression, const std::string &host = "www.example.com")
+{
+    auto manager = std::make_shared<NetPACManager>();
+    std::string script = "function FindProxyForURL(url, host) {\n    return " + expression + ";\n}";
+    EXPECT_TRUE(manager->InitPACScript(script));
+    std::string proxy;
+    manager->FindProxyForURL("http://" + host + "/", host, proxy);
+    return proxy;
+}
+
+/* 200 rules mixing the builtins the way large PAC files do, none of them matches the benchmark host */
+std::string BuildRuleScript()
+{
+    std::string script = "function FindProxyForURL(url, host) {\n";
+    for (int32_t i = 0; i < BENCH_RULE_NUM; ++i) {
+        std::string index = std::to_string(i);
+        switch (i % 4) {
+            case 0:
+                script += "    if (isInNet(dnsResolve(host), \"10." + std::to_string(i % 256) +
+                    ".0.0\", \"255.255.0.0\")) return \"PROXY p" + index + ":8080\";\n";
+                break;
+            case 1:
+                script += "    if (shExpMatch(host, \"*.site" + index + ".*.example.com\")) return \"PROXY p" +
+                    index + ":8080\";\n";
+                break;
+            case 2:
+                script += "    if (isInNetEx(dnsResolve(host), \"172." + std::to_string(i % 256) +
+                    ".0.0/16\")) return \"PROXY p" + index + ":8080\";\n";
+                break;
+            default:
+                script += "    if (dnsDomainIs(host, \".domain" + index + ".example.com\")) return \"PROXY p" +
+                    index + ":8080\";\n";
+                break;
+        }
+    }
+    script += "    return \"DIRECT\";\n}";
+    return script;
+}
+} // namespace
+
+TEST(NetPacFunctionsTest, ShExpMatchTest)
+{
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"*.example.com\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"www.*\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"w?w.*.c?m\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"*example*\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"www.example.com\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"*\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"*.example.org\")"), "false");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"www.example.co\")"), "false");
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"*com*com\")"), "false");
+    EXPECT_EQ(Evaluate("shExpMatch(\"\", \"*\")"), "true");
+    EXPECT_EQ(Evaluate("shExpMatch(\"\", \"?\")"), "false");
+}
+
+TEST(NetPacFunctionsTest, ShExpMatchPathologicalTest)
+{
+    std::string pattern;
+    for (int32_t i = 0; i < PATHOLOGICAL_STAR_NUM; ++i) {
+        pattern += "a*";
+    }
+    pattern += "b";
+    std::string host(PATHOLOGICAL_STR_LEN, 'a');
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(Evaluate("shExpMatch(host, \"" + pattern + "\")", host), "false");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    EXPECT_LT(elapsed.count(), PATHOLOGICAL_LIMIT_MS);
+}
+
+TEST(NetPacFunctionsTest, IsInNetTest)
+{
+    EXPECT_EQ(Evaluate("isInNet(\"10.1.2.3\", \"10.0.0.0\", \"255.0.0.0\")"), "true");
+    EXPECT_EQ(Evaluate("isInNet(\"11.1.2.3\", \"10.0.0.0\", \"255.0.0.0\")"), "false");
+    EXPECT_EQ(Evaluate("isInNet(\"10.1.2.3\", \"10.0.0.0\", \"255.0.0.0\") && "
+        "isInNet(\"10.9.2.3\", \"10.0.0.0\", \"255.0.0.0\")"), "true");
+    EXPECT_EQ(Evaluate("isInNet(\"10.1.2.3\", \"bad\", \"255.0.0.0\")"), "false");
+    EXPECT_EQ(Evaluate("isInNet(\"bad\", \"10.0.0.0\", \"255.0.0.0\")"), "false");
+}
+
+TEST(NetPacFunctionsTest, IsInNetExTest)
+{
+    EXPECT_EQ(Evaluate("isInNetEx(\"192.168.1.7\", \"192.168.0.0/16\")"), "true");
+    EXPECT_EQ(Evaluate("isInNetEx(\"192.169.1.7\", \"192.168.0.0/16\")"), "false");
+    EXPECT_EQ(Evaluate("isInNetEx(\"1.2.3.4\", \"0.0.0.0/0\")"), "true");
+    EXPECT_EQ(Evaluate("isInNetEx(\"1.2.3.4\", \"1.2.3.4/33\")"), "false");
+    EXPECT_EQ(Evaluate("isInNetEx(\"fd00::1\", \"fd00::/8\")"), "true");
+    EXPECT_EQ(Evaluate("isInNetEx(\"2001:db8:8000::1\", \"2001:db8::/33\")"), "false");
+    EXPECT_EQ(Evaluate("isInNetEx(\"fd00::1\", \"fd00::/129\")"), "false");
+    EXPECT_EQ(Evaluate("isInNetEx(\"fd00::1\", \"10.0.0.0/8\")"), "false");
+    EXPECT_EQ(Evaluate("isInNetEx(\"10.0.0.1\", \"fd00::/8\")"), "false");
+    EXPECT_EQ(Evaluate("isInNetEx(\"10.0.0.1\", \"10.0.0.0\")"), "false");
+}
+
+TEST(NetPacFunctionsTest, DnsResolveTest)
+{
+    EXPECT_EQ(Evaluate("dnsResolve(\"127.0.0.1\")"), "127.0.0.1");
+    EXPECT_EQ(Evaluate("dnsResolve(host) == dnsResolve(host) && isResolvable(host) == isResolvable(host)"), "true");
+    EXPECT_EQ(Evaluate("isResolvable(\"127.0.0.1\")"), "true");
+}
+
+TEST(NetPacFunctionsTest, RuleScriptBenchmarkTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    ASSERT_TRUE(manager->InitPACScript(BuildRuleScript()));
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < BENCH_LOOKUPS; ++i) {
+        manager->ClearProxyCache();
+        std::string proxy;
+        EXPECT_EQ(manager->FindProxyForURL("http://localhost/", "localhost", proxy), PAC_OK);
+        EXPECT_EQ(proxy, "DIRECT");
+    }
+    double elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("%d rules: %.3f ms per FindProxyForURL\n", BENCH_RULE_NUM, elapsedMs / BENCH_LOOKUPS);
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "net_pac_manager.h"
+
+using namespace OHOS::NetManagerStandard;
+
+namespace {
+constexpr int32_t BENCH_HOST_NUM = 200;
+constexpr int32_t BENCH_ROUNDS = 10;
+constexpr int32_t BENCH_THREADS = 4;
+constexpr double MS_PER_SECOND = 1000.0;
+
+/* Counts the calls into the script, the counter only survives between lookups if the context is kept alive */
+const std::string COUNTER_SCRIPT =
+    "var calls = 0;\n"
+    "function FindProxyForURL(url, host) {\n"
+    "    calls++;\n"
+    "    return \"PROXY proxy.example.com:\" + calls;\n"
+    "}";
+
+/* Shapes of PAC files deployed in enterprise networks: bypass lists, per-site routing and subnet checks */
+const std::vector<std::string> ENTERPRISE_SCRIPTS = {
+    "var bypass = [\".corp.example.com\", \".intranet.example.com\", \".example.net\", \".example.org\",\n"
+    "    \".hr.example.com\", \".wiki.example.com\", \".git.example.com\", \".ci.example.com\"];\n"
+    "function FindProxyForURL(url, host) {\n"
+    "    if (isPlainHostName(host) || localHostOrDomainIs(host, \"localhost\")) {\n"
+    "        return \"DIRECT\";\n"
+    "    }\n"
+    "    for (var i = 0; i < bypass.length; i++) {\n"
+    "        if (dnsDomainIs(host, bypass[i])) {\n"
+    "            return \"DIRECT\";\n"
+    "        }\n"
+    "    }\n"
+    "    if (shExpMatch(host, \"*.cdn.example.com\") || shExpMatch(host, \"static*.example.com\")) {\n"
+    "        return \"PROXY cdn-proxy.example.com:3128\";\n"
+    "    }\n"
+    "    return \"PROXY proxy1.example.com:8080; PROXY proxy2.example.com:8080; DIRECT\";\n"
+    "}",
+    "function FindProxyForURL(url, host) {\n"
+    "    host = host.toLowerCase();\n"
+    "    if (shExpMatch(host, \"10.*\") || shExpMatch(host, \"192.168.*\") || shExpMatch(host, \"172.16.*\")) {\n"
+    "        return \"DIRECT\";\n"
+    "    }\n"
+    "    if (dnsDomainLevels(host) > 3) {\n"
+    "        return \"PROXY deep-proxy.example.com:8080\";\n"
+    "    }\n"
+    "    if (dnsDomainIs(host, \".video.example.com\") || dnsDomainIs(host, \".stream.example.com\")) {\n"
+    "        return \"PROXY media-proxy.example.com:8080\";\n"
+    "    }\n"
+    "    if (isInNet(host, \"127.0.0.0\", \"255.0.0.0\")) {\n"
+    "        return \"DIRECT\";\n"
+    "    }\n"
+    "    return \"PROXY proxy.example.com:8080\";\n"
+    "}",
+    "function FindProxyForURL(url, host) {\n"
+    "    if (shExpMatch(url, \"*/update/*\") || shExpMatch(url, \"*.pdf\")) {\n"
+    "        return \"PROXY update-proxy.example.com:8080\";\n"
+    "    }\n"
+    "    if (url.substring(0, 6) == \"https:\") {\n"
+    "        return \"PROXY tls-proxy.example.com:8443\";\n"
+    "    }\n"
+    "    if (dnsDomainIs(host, \".example.com\")) {\n"
+    "        return \"DIRECT\";\n"
+    "    }\n"
+    "    return \"PROXY proxy.example.com:8080\";\n"
+    "}",
+};
+
+std::vector<std::string> BuildBenchHosts()
+{
+    std::vector<std::string> hosts;
+    for (int32_t i = 0; i < BENCH_HOST_NUM; ++i) {
+        switch (i % 4) {
+            case 0:
+                hosts.push_back("app" + std::to_string(i) + ".corp.example.com");
+                break;
+            case 1:
+                hosts.push_back("static" + std::to_string(i) + ".cdn.example.com");
+                break;
+            case 2:
+                hosts.push_back("www.site" + std::to_string(i) + ".com");
+                break;
+            default:
+                hosts.push_back("10.0.0." + std::to_string(i % 250));
+                break;
+        }
+    }
+    return hosts;
+}
+
+std::string Lookup(const std::shared_ptr<NetPACManager> &manager, const std::string &url)
+{
+    std::string proxy;
+    EXPECT_EQ(manager->FindProxyForURL(url, "", proxy), PAC_OK);
+    return proxy;
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+} // namespace
+
+TEST(NetPacManagerCacheTest, ContextKeptAliveTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    ASSERT_TRUE(manager->InitPACScript(COUNTER_SCRIPT));
+    manager->ClearProxyCache();
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/"), "PROXY proxy.example.com:1");
+    manager->ClearProxyCache();
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/"), "PROXY proxy.example.com:2");
+}
+
+TEST(NetPacManagerCacheTest, CacheBySchemeAndHostTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    ASSERT_TRUE(manager->InitPACScript(COUNTER_SCRIPT));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/index.html"), "PROXY proxy.example.com:1");
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/other/path"), "PROXY proxy.example.com:1");
+    EXPECT_EQ(Lookup(manager, "https://a.example.com/"), "PROXY proxy.example.com:2");
+    EXPECT_EQ(Lookup(manager, "http://b.example.com/"), "PROXY proxy.example.com:3");
+}
+
+TEST(NetPacManagerCacheTest, UrlDependentScriptTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    std::string script =
+        "function FindProxyForURL(url, host) {\n"
+        "    return shExpMatch(url, \"*.pdf\") ? \"DIRECT\" : \"PROXY proxy.example.com:8080\";\n"
+        "}";
+    ASSERT_TRUE(manager->InitPACScript(script));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.pdf"), "DIRECT");
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.html"), "PROXY proxy.example.com:8080");
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.pdf"), "DIRECT");
+}
+
+TEST(NetPacManagerCacheTest, AmbiguousDeclarationTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    std::string script =
+        "// FindProxyForURL(u) is called with the full url first\n"
+        "function FindProxyForURL(url, host) {\n"
+        "    return shExpMatch(url, \"*.pdf\") ? \"DIRECT\" : \"PROXY proxy.example.com:8080\";\n"
+        "}";
+    ASSERT_TRUE(manager->InitPACScript(script));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.pdf"), "DIRECT");
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.html"), "PROXY proxy.example.com:8080");
+
+    script =
+        "var FindProxyForURL = function(u, h) {\n"
+        "    return shExpMatch(u, \"*.pdf\") ? \"DIRECT\" : \"PROXY proxy.example.com:8080\";\n"
+        "};";
+    ASSERT_TRUE(manager->InitPACScript(script));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.pdf"), "DIRECT");
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/doc.html"), "PROXY proxy.example.com:8080");
+}
+
+TEST(NetPacManagerCacheTest, TimeDependentScriptTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    std::string script =
+        "var calls = 0;\n"
+        "function FindProxyForURL(url, host) {\n"
+        "    calls++;\n"
+        "    return timeRange(0, 23) ? \"PROXY proxy.example.com:\" + calls : \"DIRECT\";\n"
+        "}";
+    ASSERT_TRUE(manager->InitPACScript(script));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/"), "PROXY proxy.example.com:1");
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/"), "PROXY proxy.example.com:2");
+}
+
+TEST(NetPacManagerCacheTest, ReloadClearsCacheTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    ASSERT_TRUE(manager->InitPACScript(COUNTER_SCRIPT));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/"), "PROXY proxy.example.com:1");
+    std::string script =
+        "function FindProxyForURL(url, host) {\n"
+        "    return \"DIRECT\";\n"
+        "}";
+    ASSERT_TRUE(manager->InitPACScript(script));
+    EXPECT_EQ(Lookup(manager, "http://a.example.com/"), "DIRECT");
+}
+
+TEST(NetPacManagerCacheTest, ScriptErrorNotCachedTest)
+{
+    auto manager = std::make_shared<NetPACManager>();
+    std::string script =
+        "function FindProxyForURL(url, host) {\n"
+        "    throw new Error(\"broken\");\n"
+        "}";
+    ASSERT_TRUE(manager->InitPACScript(script));
+    std::string proxy;
+    EXPECT_EQ(manager->FindProxyForURL("http://a.example.com/", "", proxy), PAC_SCRIPT_CALL_ERROR);
+    EXPECT_EQ(manager->FindProxyForURL("http://a.example.com/", "", proxy), PAC_SCRIPT_CALL_ERROR);
+    EXPECT_TRUE(proxy.empty());
+}
+
+TEST(NetPacManagerCacheTest, EnterpriseScriptThroughputTest)
+{
+    std::vector<std::string> hosts = BuildBenchHosts();
+    for (size_t index = 0; index < ENTERPRISE_SCRIPTS.size(); ++index) {
+        auto manager = std::make_shared<NetPACManager>();
+        ASSERT_TRUE(manager->InitPACScript(ENTERPRISE_SCRIPTS[index]));
+        std::vector<std::string> expected;
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t round = 0; round < BENCH_ROUNDS; ++round) {
+            for (const auto &host : hosts) {
+                manager->ClearProxyCache();
+                std::string proxy = Lookup(manager, "https://" + host + "/index.html");
+                if (round == 0) {
+                    expected.push_back(proxy);
+                }
+            }
+        }
+        double uncachedMs = ElapsedMs(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int32_t round = 0; round < BENCH_ROUNDS; ++round) {
+            for (size_t i = 0; i < hosts.size(); ++i) {
+                EXPECT_EQ(Lookup(manager, "https://" + hosts[i] + "/index.html"), expected[i]);
+            }
+        }
+        double cachedMs = ElapsedMs(start);
+
+        std::atomic<int32_t> mismatch = 0;
+        std::vector<std::thread> threads;
+        start = std::chrono::steady_clock::now();
+        for (int32_t t = 0; t < BENCH_THREADS; ++t) {
+            threads.emplace_back([&]() {
+                for (int32_t round = 0; round < BENCH_ROUNDS; ++round) {
+                    for (size_t i = 0; i < hosts.size(); ++i) {
+                        std::string proxy;
+                        manager->FindProxyForURL("https://" + hosts[i] + "/index.html", "", proxy);
+                        mismatch += proxy == expected[i] ? 0 : 1;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        double parallelMs = ElapsedMs(start);
+        EXPECT_EQ(mismatch.load(), 0);
+
+        double lookups = static_cast<double>(BENCH_ROUNDS) * hosts.size();
+        printf("script %zu: uncached %.0f lookups/s, cached %.0f lookups/s, %d threads cached %.0f lookups/s\n",
+            index, lookups * MS_PER_SECOND / uncachedMs, lookups * MS_PER_SECOND / cachedMs, BENCH_THREADS,
+            lookups * BENCH_THREADS * MS_PER_SECOND / parallelMs);
+    }
+}
@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define private public
+#include "net_pac_local_proxy_server.h"
+#undef private
+
+using namespace OHOS::NetManagerStandard;
+
+namespace {
+constexpr int PORT_START = 20000;
+constexpr int PORT_END = 60000;
+constexpr int PROXY_THREADS = 4;
+constexpr int BENCH_TUNNEL_NUM = 1000;
+constexpr size_t BENCH_TUNNEL_BYTES = 16 * 1024;
+constexpr size_t ECHO_BYTES = 4 * 1024 * 1024;
+constexpr size_t THROUGHPUT_BYTES = 256 * 1024 * 1024;
+constexpr size_t IO_CHUNK = 64 * 1024;
+constexpr size_t BACKPRESSURE_LIMIT = 64 * 1024 * 1024;
+constexpr int MAX_EXTRA_THREADS = 16;
+constexpr int POLL_TIMEOUT_MS = 5000;
+constexpr rlim_t BENCH_FD_LIMIT = 8192;
+constexpr int FDS_PER_TUNNEL = 8;
+constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+constexpr int UPSTREAM_QUIET_MS = 300;
+
+int ListenLoopback(uint16_t &port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        listen(fd, SOMAXCONN) != 0 || getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/* Upstream used by the tunnels: echoes every byte and closes once the peer has closed its side */
+class EchoServer {
+public:
+    EchoServer()
+    {
+        listenFd_ = ListenLoopback(port_);
+        running_ = listenFd_ >= 0;
+        if (running_) {
+            thread_ = std::thread(&EchoServer::Loop, this);
+        }
+    }
+
+    ~EchoServer()
+    {
+        running_ = false;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        for (const auto &[fd, outbox] : outboxes_) {
+            close(fd);
+        }
+        close(listenFd_);
+    }
+
+    uint16_t GetPort() const
+    {
+        return port_;
+    }
+
+private:
+    void Loop()
+    {
+        int epollFd = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd_;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd_, &event);
+        std::vector<epoll_event> events(BENCH_TUNNEL_NUM);
+        std::vector<char> buffer(IO_CHUNK);
+        while (running_) {
+            int count = epoll_wait(epollFd, events.data(), events.size(), 100);
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd_) {
+                    Accept(epollFd);
+                    continue;
+                }
+                if (!Serve(epollFd, fd, buffer)) {
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                    outboxes_.erase(fd);
+                    close(fd);
+                }
+            }
+        }
+        close(epollFd);
+    }
+
+    void Accept(int epollFd)
+    {
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        outboxes_[fd];
+    }
+
+    bool Serve(int epollFd, int fd, std::vector<char> &buffer)
+    {
+        Outbox &outbox = outboxes_[fd];
+        while (true) {
+            if (!Flush(fd, outbox.data)) {
+                return false;
+            }
+            if (outbox.isEof) {
+                return !outbox.data.empty();
+            }
+            if (!outbox.data.empty()) {
+                // the peer is not reading, stop reading until it drains
+                return true;
+            }
+            ssize_t len = recv(fd, buffer.data(), buffer.size(), 0);
+            if (len > 0) {
+                outbox.data.append(buffer.data(), static_cast<size_t>(len));
+            } else if (len == 0) {
+                outbox.isEof = true;
+            } else {
+                return errno == EAGAIN;
+            }
+        }
+    }
+
+    static bool Flush(int fd, std::string &data)
+    {
+        while (!data.empty()) {
+            ssize_t len = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (len < 0) {
+                return errno == EAGAIN;
+            }
+            data.erase(0, static_cast<size_t>(len));
+        }
+        return true;
+    }
+
+    struct Outbox {
+        std::string data;
+        bool isEof = false;
+    };
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_ = false;
+    std::thread thread_;
+    std::map<int, Outbox> outboxes_;
+};
+
+std::shared_ptr<ProxyServer> StartDirectProxy()
+{
+    int port = ProxyServer::FindAvailablePort(PORT_START, PORT_END);
+    auto proxy = std::make_shared<ProxyServer>(port, PROXY_THREADS);
+    proxy->SetFindPacProxyFunction([](auto url, auto host) { return "DIRECT"; });
+    if (!proxy->Start()) {
+        return nullptr;
+    }
+    return proxy;
+}
+
+/* Opens a CONNECT tunnel through the local proxy, returns the client side once the proxy accepted it */
+int OpenTunnel(int proxyPort, uint16_t targetPort)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(proxyPort));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    std::string target = "127.0.0.1:" + std::to_string(targetPort);
+    std::string request = "CONNECT " + target + " HTTP/1.1\r\nHost: " + target + "\r\n\r\n";
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        close(fd);
+        return -1;
+    }
+    std::string response;
+    char ch = 0;
+    while (response.find("\r\n\r\n") == std::string::npos && recv(fd, &ch, 1, 0) == 1) {
+        response.push_back(ch);
+    }
+    if (response.find(" 200 ") == std::string::npos) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool SendFully(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t len = send(fd, data, std::min(size, IO_CHUNK), MSG_NOSIGNAL);
+        if (len <= 0) {
+            return false;
+        }
+        data += len;
+        size -= static_cast<size_t>(len);
+    }
+    return true;
+}
+
+std::string RecvUntilClose(int fd)
+{
+    std::string data;
+    std::vector<char> buffer(IO_CHUNK);
+    ssize_t len = 0;
+    while ((len = recv(fd, buffer.data(), buffer.size(), 0)) > 0) {
+        data.append(buffer.data(), static_cast<size_t>(len));
+    }
+    return data;
+}
+
+std::string MakePayload(size_t size)
+{
+    std::string payload(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<char>((i * 131 + i / 4096) & 0xff);
+    }
+    return payload;
+}
+
+int CountThreads()
+{
+    int count = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return 0;
+    }
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+}
+
+int64_t ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* The reply to CONNECT goes out before the reactor picks the tunnel up */
+size_t WaitTunnelCount(const std::shared_ptr<ProxyServer> &proxy, size_t expected)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (proxy->tunnelReactor_.GetTunnelCount() != expected && ElapsedMs(start) < POLL_TIMEOUT_MS) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return proxy->tunnelReactor_.GetTunnelCount();
+}
+} // namespace
+
+TEST(ProxyTunnelTest, TunnelEchoTest)
+{
+    EchoServer echo;
+    auto proxy = StartDirectProxy();
+    ASSERT_NE(proxy, nullptr);
+    int fd = OpenTunnel(proxy->port_, echo.GetPort());
+    ASSERT_GE(fd, 0);
+    std::string payload = MakePayload(ECHO_BYTES);
+    std::thread writer([fd, &payload]() {
+        SendFully(fd, payload.data(), payload.size());
+        shutdown(fd, SHUT_WR);
+    });
+    std::string echoed = RecvUntilClose(fd);
+    writer.join();
+    close(fd);
+    EXPECT_EQ(echoed.size(), payload.size());
+    EXPECT_TRUE(echoed == payload);
+}
+
+TEST(ProxyTunnelTest, TunnelHalfCloseTest)
+{
+    EchoServer echo;
+    auto proxy = StartDirectProxy();
+    ASSERT_NE(proxy, nullptr);
+    int fd = OpenTunnel(proxy->port_, echo.GetPort());
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(SendFully(fd, "ping", strlen("ping")));
+    // the client closing its side still lets the reply through
+    shutdown(fd, SHUT_WR);
+    EXPECT_EQ(RecvUntilClose(fd), "ping");
+    close(fd);
+    EXPECT_EQ(WaitTunnelCount(proxy, 0), 0U);
+}
+
+TEST(ProxyTunnelTest, TunnelBackpressureTest)
+{
+    // the sink completes the handshake but never reads, so the tunnel has to push back
+    uint16_t sinkPort = 0;
+    int sinkFd = ListenLoopback(sinkPort);
+    ASSERT_GE(sinkFd, 0);
+    EchoServer echo;
+    auto proxy = StartDirectProxy();
+    ASSERT_NE(proxy, nullptr);
+    int stalledFd = OpenTunnel(proxy->port_, sinkPort);
+    ASSERT_GE(stalledFd, 0);
+    std::string chunk = MakePayload(IO_CHUNK);
+    size_t accepted = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (accepted < BACKPRESSURE_LIMIT && ElapsedMs(start) < POLL_TIMEOUT_MS) {
+        ssize_t len = send(stalledFd, chunk.data(), chunk.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (len > 0) {
+            accepted += static_cast<size_t>(len);
+            continue;
+        }
+        pollfd pfd = {stalledFd, POLLOUT, 0};
+        if (poll(&pfd, 1, 200) == 0) {
+            break;
+        }
+    }
+    EXPECT_LT(accepted, BACKPRESSURE_LIMIT);
+
+    // a stalled tunnel does not hold up the others
+    int fd = OpenTunnel(proxy->port_, echo.GetPort());
+    ASSERT_GE(fd, 0);
+    ASSERT_TRUE(SendFully(fd, "pong", strlen("pong")));
+    shutdown(fd, SHUT_WR);
+    EXPECT_EQ(RecvUntilClose(fd), "pong");
+    close(fd);
+    close(stalledFd);
+    close(sinkFd);
+}
+
+TEST(ProxyTunnelTest, HttpResponseOnlyTest)
+{
+    uint16_t upstreamPort = 0;
+    int upstreamFd = ListenLoopback(upstreamPort);
+    ASSERT_GE(upstreamFd, 0);
+    // the upstream answers one request, then reports what else reached it before it closes
+    std::string extra;
+    std::thread upstream([upstreamFd, &extra]() {
+        int fd = accept4(upstreamFd, nullptr, nullptr, SOCK_CLOEXEC);
+        std::string request;
+        char ch = 0;
+        while (request.find("\r\n\r\n") == std::string::npos && recv(fd, &ch, 1, 0) == 1) {
+            request.push_back(ch);
+        }
+        const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+        SendFully(fd, response, strlen(response));
+        pollfd pfd = {fd, POLLIN, 0};
+        char buffer[IO_CHUNK / 16] = {0};
+        ssize_t len = 0;
+        while (poll(&pfd, 1, UPSTREAM_QUIET_MS) > 0 && (len = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            extra.append(buffer, static_cast<size_t>(len));
+        }
+        close(fd);
+    });
+    auto proxy = StartDirectProxy();
+    ASSERT_NE(proxy, nullptr);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(proxy->port_));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+    std::string target = "127.0.0.1:" + std::to_string(upstreamPort);
+    std::string request = "GET http://" + target + "/ HTTP/1.1\r\nHost: " + target + "\r\n\r\n";
+    ASSERT_TRUE(SendFully(fd, request.data(), request.size()));
+    std::string response;
+    char ch = 0;
+    while (response.find("hello") == std::string::npos && recv(fd, &ch, 1, 0) == 1) {
+        response.push_back(ch);
+    }
+    EXPECT_NE(response.find(" 200 "), std::string::npos);
+    // a keep-alive request for another host must not be piped to the upstream of the first one
+    std::string next = "GET http://other.invalid/ HTTP/1.1\r\nHost: other.invalid\r\n\r\n";
+    EXPECT_TRUE(SendFully(fd, next.data(), next.size()));
+    RecvUntilClose(fd);
+    upstream.join();
+    close(fd);
+    close(upstreamFd);
+    EXPECT_EQ(extra, "");
+    EXPECT_EQ(WaitTunnelCount(proxy, 0), 0U);
+}
+
+TEST(ProxyTunnelTest, ReactorEpollFailTest)
+{
+    ProxyTunnelReactor reactor(std::chrono::seconds(POLL_TIMEOUT_MS / 1000));
+    ASSERT_TRUE(reactor.Start());
+    // epoll_wait fails on a descriptor that is no epoll instance
+    int nullFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    ASSERT_GE(nullFd, 0);
+    ASSERT_GE(dup2(nullFd, reactor.epollFd_), 0);
+    close(nullFd);
+    bool isAccepted = true;
+    auto start = std::chrono::steady_clock::now();
+    while (isAccepted && ElapsedMs(start) < POLL_TIMEOUT_MS) {
+        int pair[2] = {-1, -1};
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair), 0);
+        isAccepted = reactor.AddTunnel(pair[0], pair[1]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_FALSE(isAccepted);
+    EXPECT_EQ(reactor.GetTunnelCount(), 0U);
+    reactor.Stop();
+}
+
+TEST(ProxyTunnelTest, TunnelConcurrencyBenchmarkTest)
+{
+    rlimit limit = {};
+    getrlimit(RLIMIT_NOFILE, &limit);
+    if (limit.rlim_cur < BENCH_FD_LIMIT) {
+        limit.rlim_cur = std::min(BENCH_FD_LIMIT, limit.rlim_max);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    int tunnelNum = std::min(BENCH_TUNNEL_NUM, static_cast<int>(limit.rlim_cur / FDS_PER_TUNNEL));
+    EchoServer echo;
+    auto proxy = StartDirectProxy();
+    ASSERT_NE(proxy, nullptr);
+    int baseThreads = CountThreads();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<int> fds;
+    for (int i = 0; i < tunnelNum; ++i) {
+        int fd = OpenTunnel(proxy->port_, echo.GetPort());
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+    }
+    int64_t setupMs = ElapsedMs(start);
+    EXPECT_EQ(WaitTunnelCount(proxy, tunnelNum), static_cast<size_t>(tunnelNum));
+    // every tunnel is open at once, and none of them holds a thread
+    EXPECT_LE(CountThreads(), baseThreads + MAX_EXTRA_THREADS);
+
+    std::string payload = MakePayload(BENCH_TUNNEL_BYTES);
+    start = std::chrono::steady_clock::now();
+    for (int fd : fds) {
+        ASSERT_TRUE(SendFully(fd, payload.data(), payload.size()));
+    }
+    std::vector<size_t> received(fds.size(), 0);
+    size_t finished = 0;
+    std::vector<char> buffer(IO_CHUNK);
+    while (finished < fds.size() && ElapsedMs(start) < POLL_TIMEOUT_MS) {
+        std::vector<pollfd> pfds;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (received[i] < payload.size()) {
+                pfds.push_back({fds[i], POLLIN, static_cast<short>(i)});
+            }
+        }
+        if (poll(pfds.data(), pfds.size(), POLL_TIMEOUT_MS) <= 0) {
+            break;
+        }
+        for (size_t i = 0, j = 0; i < fds.size(); ++i) {
+            if (received[i] >= payload.size()) {
+                continue;
+            }
+            pollfd &pfd = pfds[j++];
+            if ((static_cast<unsigned short>(pfd.revents) & POLLIN) == 0) {
+                continue;
+            }
+            ssize_t len = recv(fds[i], buffer.data(), buffer.size(), MSG_DONTWAIT);
+            received[i] += len > 0 ? static_cast<size_t>(len) : 0;
+            finished += received[i] >= payload.size() ? 1 : 0;
+        }
+    }
+    int64_t echoMs = ElapsedMs(start);
+    EXPECT_EQ(finished, fds.size());
+    for (int fd : fds) {
+        close(fd);
+    }
+    double totalMb = static_cast<double>(BENCH_TUNNEL_BYTES) * fds.size() * 2 / BYTES_PER_MB;
+    printf("%d tunnels: setup %lld ms, echo %.1f MB in %lld ms\n", tunnelNum, static_cast<long long>(setupMs),
+           totalMb, static_cast<long long>(echoMs));
+}
+
+TEST(ProxyTunnelTest, TunnelThroughputBenchmarkTest)
+{
+    EchoServer echo;
+    auto proxy = StartDirectProxy();
+    ASSERT_NE(proxy, nullptr);
+    int fd = OpenTunnel(proxy->port_, echo.GetPort());
+    ASSERT_GE(fd, 0);
+    std::string chunk = MakePayload(IO_CHUNK);
+    auto start = std::chrono::steady_clock::now();
+    std::thread writer([fd, &chunk]() {
+        for (size_t sent = 0; sent < THROUGHPUT_BYTES; sent += chunk.size()) {
+            if (!SendFully(fd, chunk.data(), chunk.size())) {
+                break;
+            }
+        }
+        shutdown(fd, SHUT_WR);
+    });
+    size_t received = 0;
+    std::vector<char> buffer(IO_CHUNK);
+    ssize_t len = 0;
+    while ((len = recv(fd, buffer.data(), buffer.size(), 0)) > 0) {
+        received += static_cast<size_t>(len);
+    }
+    writer.join();
+    int64_t elapsedMs = std::max<int64_t>(ElapsedMs(start), 1);
+    close(fd);
+    EXPECT_EQ(received, THROUGHPUT_BYTES);
+    printf("tunnel throughput: %zu MB each way in %lld ms, %.1f MB/s\n",
+           THROUGHPUT_BYTES / static_cast<size_t>(BYTES_PER_MB), static_cast<long long>(elapsedMs),
+           static_cast<double>(THROUGHPUT_BYTES) / BYTES_PER_MB * 1000 / elapsedMs);
+}
@@ -13,11 +13,19 @@
 * limitations under the License.
 */
 
+#include <arpa/inet.h>
 #include <gtest/gtest.h>
+#include <net/if.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define private public
 #include "bandwidth_manager.h"
 #undef private
+#include "bpf_def.h"
+#include "bpf_mapper.h"
+#include "bpf_path.h"
+#include "common_netns_test_util.h"
 #include "iptables_type.h"
 #include "net_manager_constants.h"
 #include "netnative_log_wrapper.h"
@@ -31,8 +39,88 @@ namespace OHOS {
 namespace NetsysNative {
 using namespace testing::ext;
 using namespace NetManagerStandard;
+using namespace NetManagerStandard::NetnsTestUtil;
 using namespace nmd;
 std::shared_ptr<BandwidthManager> g_BandwidthManager = nullptr;
+namespace {
+constexpr const char *BW_EGRESS_PROG_PATH = "/sys/fs/bpf/netsys/progs/cgroup_skb_uid_egress";
+constexpr const char *BW_NETNS = "bwquota";
+constexpr const char *BW_IFACE = "bwv0";
+constexpr const char *BW_LOCAL_IPV4 = "198.18.2.1";
+constexpr const char *BW_PEER_IPV4 = "198.18.2.2";
+constexpr uint16_t BW_PEER_PORT = 9098;
+constexpr uint32_t BW_APP_UID = 20010199;
+constexpr int64_t BW_QUOTA_BYTES = 8192;
+constexpr int64_t BW_ALERT_BYTES = 2048;
+constexpr size_t BW_PAYLOAD_LEN = 512;
+// IPv4 and UDP headers, the cgroup skb programs count the whole IP packet
+constexpr size_t BW_PACKET_LEN = BW_PAYLOAD_LEN + 28;
+constexpr int32_t BW_MAX_PACKET_NUM = 64;
+constexpr int32_t BW_RECV_TIMEOUT_MS = 500;
+// More uids than bandwidth_uid_map holds in any configuration
+constexpr uint32_t BW_UID_MAP_OVERFLOW = 65536;
+const VethPeerConfig BW_VETH = {BW_NETNS, BW_IFACE, "bwv1", std::string(BW_LOCAL_IPV4) + "/24",
+                                std::string(BW_PEER_IPV4) + "/24"};
+
+bool IsBandwidthMapReady()
+{
+    return access(BANDWIDTH_UID_MAP_PATH, F_OK) == 0 && access(BANDWIDTH_LIMIT_MAP_PATH, F_OK) == 0 &&
+        access(BANDWIDTH_CONFIG_MAP_PATH, F_OK) == 0;
+}
+
+sockaddr_in MakePeerAddr()
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(BW_PEER_PORT);
+    inet_pton(AF_INET, BW_PEER_IPV4, &addr.sin_addr);
+    return addr;
+}
+
+// Returns 0 or the errno of sendto
+int32_t SendPacket(int32_t sock)
+{
+    sockaddr_in addr = MakePeerAddr();
+    char payload[BW_PAYLOAD_LEN] = {0};
+    ssize_t len = sendto(sock, payload, sizeof(payload), 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    return len < 0 ? errno : 0;
+}
+
+// Sends one datagram to the peer as uid from a child process, returns 0 or the errno of sendto
+int32_t SendAsUid(uint32_t uid)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (setuid(uid) != 0) {
+            _exit(EXIT_FAILURE);
+        }
+        int sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        _exit(SendPacket(sock));
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+int32_t DrainPeer(int32_t sock)
+{
+    char buf[BW_PAYLOAD_LEN] = {0};
+    int32_t count = 0;
+    while (recv(sock, buf, sizeof(buf), 0) > 0) {
+        ++count;
+    }
+    return count;
+}
+
+bool ReadLimit(uint32_t ifIndex, uint32_t type, bandwidth_limit_value &value)
+{
+    BpfMapper<bandwidth_limit_key, bandwidth_limit_value> limitMap(BANDWIDTH_LIMIT_MAP_PATH, BPF_ANY);
+    bandwidth_limit_key key = {ifIndex, type};
+    return limitMap.IsValid() && limitMap.Read(key, value) == 0;
+}
+} // namespace
 
 class BandwidthManagerTest : public testing::Test {
 public:
@@ -462,5 +550,255 @@ HWTEST_F(BandwidthManagerTest, RemoveDeniedList002, TestSize.Level1)
     int32_t ret = g_BandwidthManager->RemoveDeniedList(uid);
     EXPECT_EQ(ret, NETMANAGER_ERROR);
 }
+
+/**
+ * @tc.name: UpdateUidLists000
+ * @tc.desc: Test BandwidthManager UpdateUidLists moves uids between the lists.
+ * @tc.type: FUNC
+ */
+HWTEST_F(BandwidthManagerTest, UpdateUidLists000, TestSize.Level1)
+{
+    std::vector<uint32_t> uids = {910001, 910002, 910003};
+    int32_t ret = g_BandwidthManager->UpdateUidLists({uids[0], uids[1]}, {uids[2]}, {});
+    EXPECT_EQ(ret, NETMANAGER_SUCCESS);
+    EXPECT_EQ(g_BandwidthManager->deniedListUids_.count(uids[0]), 1);
+    EXPECT_EQ(g_BandwidthManager->deniedListUids_.count(uids[1]), 1);
+    EXPECT_EQ(g_BandwidthManager->allowedListUids_.count(uids[2]), 1);
+
+    ret = g_BandwidthManager->UpdateUidLists({uids[2]}, {uids[0]}, {uids[1]});
+    EXPECT_EQ(ret, NETMANAGER_SUCCESS);
+    EXPECT_EQ(g_BandwidthManager->allowedListUids_.count(uids[0]), 1);
+    EXPECT_EQ(g_BandwidthManager->deniedListUids_.count(uids[0]), 0);
+    EXPECT_EQ(g_BandwidthManager->deniedListUids_.count(uids[1]), 0);
+    EXPECT_EQ(g_BandwidthManager->deniedListUids_.count(uids[2]), 1);
+    EXPECT_EQ(g_BandwidthManager->allowedListUids_.count(uids[2]), 0);
+
+    ret = g_BandwidthManager->UpdateUidLists({}, {}, uids);
+    EXPECT_EQ(ret, NETMANAGER_SUCCESS);
+    for (uint32_t uid : uids) {
+        EXPECT_EQ(g_BandwidthManager->deniedListUids_.count(uid), 0);
+        EXPECT_EQ(g_BandwidthManager->allowedListUids_.count(uid), 0);
+    }
+    ret = g_BandwidthManager->UpdateUidLists({}, {}, uids);
+    EXPECT_EQ(ret, NETMANAGER_SUCCESS);
+}
+
+/**
+ * @tc.name: BandwidthMapTest
+ * @tc.desc: Test BandwidthManager keeps the lists, the quotas and the data saver in the bandwidth maps.
+ * @tc.type: FUNC
+ */
+HWTEST_F(BandwidthManagerTest, BandwidthMapTest, TestSize.Level1)
+{
+    if (getuid() != 0 || !IsBandwidthMapReady()) {
+        GTEST_SKIP() << "needs root and the bandwidth maps";
+    }
+    RunCmd("ip link del bwmap0");
+    ASSERT_TRUE(RunCmd("ip link add bwmap0 type veth peer name bwmap1"));
+    uint32_t ifIndex = if_nametoindex("bwmap0");
+    BandwidthManager manager;
+    const uint32_t uidA = 20010101;
+    const uint32_t uidB = 20010102;
+    EXPECT_EQ(manager.AddDeniedList(uidA), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.AddAllowedList(uidB), NETMANAGER_SUCCESS);
+    BpfMapper<bandwidth_uid_key, bandwidth_uid_value> uidMap(BANDWIDTH_UID_MAP_PATH, BPF_ANY);
+    ASSERT_TRUE(uidMap.IsValid());
+    bandwidth_uid_value bits = 0;
+    EXPECT_EQ(uidMap.Read(uidA, bits), 0);
+    EXPECT_EQ(bits, BANDWIDTH_UID_DENIED);
+
+    EXPECT_EQ(manager.UpdateUidLists({uidB}, {uidA}, {}), NETMANAGER_SUCCESS);
+    EXPECT_EQ(uidMap.Read(uidA, bits), 0);
+    EXPECT_EQ(bits, BANDWIDTH_UID_ALLOWED);
+    EXPECT_EQ(uidMap.Read(uidB, bits), 0);
+    EXPECT_EQ(bits, BANDWIDTH_UID_DENIED);
+    EXPECT_EQ(manager.UpdateUidLists({}, {}, {uidA, uidB}), NETMANAGER_SUCCESS);
+    EXPECT_TRUE(uidMap.GetAllKeys().empty());
+
+    EXPECT_EQ(manager.SetIfaceQuota("bwmap0", BW_QUOTA_BYTES), NETMANAGER_SUCCESS);
+    bandwidth_limit_value limit = {};
+    EXPECT_TRUE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_QUOTA, limit));
+    EXPECT_EQ(limit.limitBytes, static_cast<uint64_t>(BW_QUOTA_BYTES));
+    EXPECT_EQ(manager.SetCostlyAlert(BandwidthManager::OP_SET, "bwmap0", BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_TRUE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_ALERT, limit));
+    EXPECT_EQ(limit.limitBytes, static_cast<uint64_t>(BW_ALERT_BYTES));
+    EXPECT_EQ(manager.SetGlobalAlert(BandwidthManager::OP_SET, BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_TRUE(ReadLimit(BANDWIDTH_GLOBAL_IFINDEX, BANDWIDTH_LIMIT_ALERT, limit));
+
+    EXPECT_EQ(manager.EnableDataSaver(true), NETMANAGER_SUCCESS);
+    BpfMapper<bandwidth_config_key, bandwidth_config_value> configMap(BANDWIDTH_CONFIG_MAP_PATH, BPF_ANY);
+    bandwidth_config_value config = {};
+    EXPECT_EQ(configMap.Read(BANDWIDTH_CONFIG_KEY, config), 0);
+    EXPECT_EQ(config.dataSaverEnabled, 1);
+    EXPECT_EQ(manager.EnableDataSaver(false), NETMANAGER_SUCCESS);
+
+    EXPECT_EQ(manager.RemoveIfaceQuota("bwmap0"), NETMANAGER_SUCCESS);
+    EXPECT_FALSE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_QUOTA, limit));
+    EXPECT_EQ(manager.SetCostlyAlert(BandwidthManager::OP_UNSET, "bwmap0", BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.SetGlobalAlert(BandwidthManager::OP_UNSET, BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    BpfMapper<bandwidth_limit_key, bandwidth_limit_value> limitMap(BANDWIDTH_LIMIT_MAP_PATH, BPF_ANY);
+    EXPECT_TRUE(limitMap.GetAllKeys().empty());
+    RunCmd("ip link del bwmap0");
+}
+
+/**
+ * @tc.name: UpdateUidListsRollbackTest
+ * @tc.desc: Test a UpdateUidLists batch the uid map cannot hold fails and leaves the map and the lists as before.
+ * @tc.type: FUNC
+ */
+HWTEST_F(BandwidthManagerTest, UpdateUidListsRollbackTest, TestSize.Level1)
+{
+    if (getuid() != 0 || !IsBandwidthMapReady()) {
+        GTEST_SKIP() << "needs root and the bandwidth maps";
+    }
+    BandwidthManager manager;
+    const uint32_t uidA = 20010101;
+    EXPECT_EQ(manager.AddDeniedList(uidA), NETMANAGER_SUCCESS);
+    std::vector<uint32_t> uids;
+    for (uint32_t i = 1; i <= BW_UID_MAP_OVERFLOW; i++) {
+        uids.push_back(uidA + i);
+    }
+    EXPECT_EQ(manager.UpdateUidLists(uids, {uidA}, {}), NETMANAGER_ERROR);
+    BpfMapper<bandwidth_uid_key, bandwidth_uid_value> uidMap(BANDWIDTH_UID_MAP_PATH, BPF_ANY);
+    ASSERT_TRUE(uidMap.IsValid());
+    EXPECT_EQ(uidMap.GetAllKeys().size(), 1U);
+    bandwidth_uid_value bits = 0;
+    EXPECT_EQ(uidMap.Read(uidA, bits), 0);
+    EXPECT_EQ(bits, BANDWIDTH_UID_DENIED);
+    // The lists were set back as well, so removing uidA still changes it
+    EXPECT_EQ(manager.RemoveDeniedList(uidA), NETMANAGER_SUCCESS);
+    EXPECT_TRUE(uidMap.GetAllKeys().empty());
+}
+
+/**
+ * @tc.name: PendingQuotaTest
+ * @tc.desc: Test a quota and an alert set before their iface exists are written when it is added, follow it to
+ *           its new index when it is recreated and leave the map when it is removed.
+ * @tc.type: FUNC
+ */
+HWTEST_F(BandwidthManagerTest, PendingQuotaTest, TestSize.Level1)
+{
+    if (getuid() != 0 || !IsBandwidthMapReady()) {
+        GTEST_SKIP() << "needs root and the bandwidth maps";
+    }
+    RunCmd("ip link del bwpend0");
+    BandwidthManager manager;
+    EXPECT_EQ(manager.SetIfaceQuota("bwpend0", BW_QUOTA_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.SetCostlyAlert(BandwidthManager::OP_SET, "bwpend0", BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    BpfMapper<bandwidth_limit_key, bandwidth_limit_value> limitMap(BANDWIDTH_LIMIT_MAP_PATH, BPF_ANY);
+    ASSERT_TRUE(limitMap.IsValid());
+    EXPECT_TRUE(limitMap.GetAllKeys().empty());
+
+    ASSERT_TRUE(RunCmd("ip link add bwpend0 type veth peer name bwpend1"));
+    uint32_t ifIndex = if_nametoindex("bwpend0");
+    manager.OnInterfaceChanged("bwpend0", true);
+    bandwidth_limit_value limit = {};
+    EXPECT_TRUE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_QUOTA, limit));
+    EXPECT_EQ(limit.limitBytes, static_cast<uint64_t>(BW_QUOTA_BYTES));
+    EXPECT_TRUE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_ALERT, limit));
+    EXPECT_EQ(limit.limitBytes, static_cast<uint64_t>(BW_ALERT_BYTES));
+
+    RunCmd("ip link del bwpend0");
+    manager.OnInterfaceChanged("bwpend0", false);
+    EXPECT_TRUE(limitMap.GetAllKeys().empty());
+    ASSERT_TRUE(RunCmd("ip link add bwpend0 type veth peer name bwpend1"));
+    uint32_t newIndex = if_nametoindex("bwpend0");
+    manager.OnInterfaceChanged("bwpend0", true);
+    EXPECT_TRUE(ReadLimit(newIndex, BANDWIDTH_LIMIT_QUOTA, limit));
+    EXPECT_TRUE(ReadLimit(newIndex, BANDWIDTH_LIMIT_ALERT, limit));
+    EXPECT_EQ(limitMap.GetAllKeys().size(), 2u);
+
+    EXPECT_EQ(manager.RemoveIfaceQuota("bwpend0"), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.SetCostlyAlert(BandwidthManager::OP_UNSET, "bwpend0", BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_TRUE(limitMap.GetAllKeys().empty());
+    RunCmd("ip link del bwpend0");
+}
+
+/**
+ * @tc.name: QuotaVethTest
+ * @tc.desc: Test a quota on a veth to a peer namespace stops the traffic at the limit and an alert is
+ *           raised by the packet crossing it.
+ * @tc.type: FUNC
+ */
+HWTEST_F(BandwidthManagerTest, QuotaVethTest, TestSize.Level1)
+{
+    // Enforced by the cgroup skb programs netsys attaches to the root cgroup
+    if (getuid() != 0 || !IsBandwidthMapReady() || access(BW_EGRESS_PROG_PATH, F_OK) != 0) {
+        GTEST_SKIP() << "needs root, the bandwidth maps and the egress program";
+    }
+    if (!SetUpVethPeerNetns(BW_VETH)) {
+        TearDownVethPeerNetns(BW_VETH);
+        GTEST_SKIP() << "cannot set up the peer namespace";
+    }
+    int32_t receiver = OpenNetnsUdpSocket(BW_NETNS, BW_PEER_IPV4, BW_PEER_PORT, BW_RECV_TIMEOUT_MS);
+    ASSERT_GE(receiver, 0);
+    int32_t sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(sock, 0);
+    uint32_t ifIndex = if_nametoindex(BW_IFACE);
+    BandwidthManager manager;
+    EXPECT_EQ(manager.SetIfaceQuota(BW_IFACE, BW_QUOTA_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.SetCostlyAlert(BandwidthManager::OP_SET, BW_IFACE, BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+
+    // The alert is only reported, it never stops the traffic
+    bandwidth_limit_value alert = {};
+    int32_t sent = 0;
+    while (sent < BW_MAX_PACKET_NUM && SendPacket(sock) == 0) {
+        ++sent;
+        ASSERT_TRUE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_ALERT, alert));
+        EXPECT_EQ(alert.notified != 0, sent * BW_PACKET_LEN > BW_ALERT_BYTES) << sent;
+    }
+    EXPECT_EQ(sent, static_cast<int32_t>(BW_QUOTA_BYTES / BW_PACKET_LEN));
+    EXPECT_EQ(SendPacket(sock), EPERM);
+    EXPECT_EQ(DrainPeer(receiver), sent);
+    bandwidth_limit_value quota = {};
+    EXPECT_TRUE(ReadLimit(ifIndex, BANDWIDTH_LIMIT_QUOTA, quota));
+    EXPECT_NE(quota.notified, 0);
+
+    // A new quota starts counting again
+    EXPECT_EQ(manager.SetIfaceQuota(BW_IFACE, BW_QUOTA_BYTES), NETMANAGER_SUCCESS);
+    EXPECT_EQ(SendPacket(sock), 0);
+    EXPECT_EQ(manager.RemoveIfaceQuota(BW_IFACE), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.SetCostlyAlert(BandwidthManager::OP_UNSET, BW_IFACE, BW_ALERT_BYTES), NETMANAGER_SUCCESS);
+    close(sock);
+    close(receiver);
+    TearDownVethPeerNetns(BW_VETH);
+}
+
+/**
+ * @tc.name: DataSaverVethTest
+ * @tc.desc: Test the data saver and the lists on a costly veth to a peer namespace.
+ * @tc.type: FUNC
+ */
+HWTEST_F(BandwidthManagerTest, DataSaverVethTest, TestSize.Level1)
+{
+    if (getuid() != 0 || !IsBandwidthMapReady() || access(BW_EGRESS_PROG_PATH, F_OK) != 0) {
+        GTEST_SKIP() << "needs root, the bandwidth maps and the egress program";
+    }
+    if (!SetUpVethPeerNetns(BW_VETH)) {
+        TearDownVethPeerNetns(BW_VETH);
+        GTEST_SKIP() << "cannot set up the peer namespace";
+    }
+    int32_t receiver = OpenNetnsUdpSocket(BW_NETNS, BW_PEER_IPV4, BW_PEER_PORT, BW_RECV_TIMEOUT_MS);
+    ASSERT_GE(receiver, 0);
+    BandwidthManager manager;
+    EXPECT_EQ(manager.EnableDataSaver(true), NETMANAGER_SUCCESS);
+    // Not costly yet
+    EXPECT_EQ(SendAsUid(BW_APP_UID), 0);
+
+    EXPECT_EQ(manager.SetIfaceQuota(BW_IFACE, INT64_MAX), NETMANAGER_SUCCESS);
+    EXPECT_EQ(SendAsUid(BW_APP_UID), EPERM);
+    EXPECT_EQ(manager.AddAllowedList(BW_APP_UID), NETMANAGER_SUCCESS);
+    EXPECT_EQ(SendAsUid(BW_APP_UID), 0);
+    EXPECT_EQ(manager.EnableDataSaver(false), NETMANAGER_SUCCESS);
+    EXPECT_EQ(manager.UpdateUidLists({BW_APP_UID}, {}, {}), NETMANAGER_SUCCESS);
+    EXPECT_EQ(SendAsUid(BW_APP_UID), EPERM);
+    EXPECT_EQ(manager.RemoveDeniedList(BW_APP_UID), NETMANAGER_SUCCESS);
+    EXPECT_EQ(SendAsUid(BW_APP_UID), 0);
+    EXPECT_EQ(DrainPeer(receiver), 3);
+
+    EXPECT_EQ(manager.RemoveIfaceQuota(BW_IFACE), NETMANAGER_SUCCESS);
+    close(receiver);
+    TearDownVethPeerNetns(BW_VETH);
+}
 } // namespace NetsysNative
 } // namespace OHOS
\ No newline at end of file
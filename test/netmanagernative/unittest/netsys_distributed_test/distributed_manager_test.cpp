@@ -13,22 +13,74 @@
  * limitations under the License.
  */
 
+#include <chrono>
 #include <gtest/gtest.h>
+#include <ifaddrs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
 #ifdef GTEST_API_
 #define private public
 #define protected public
 #endif
 
+#include "common_netns_test_util.h"
 #include "net_manager_constants.h"
+#include "netmanager_base_common_utils.h"
 #include "netnative_log_wrapper.h"
 #include "distributed_manager.h"
+#include "rtnetlink_transaction.h"
+#include "securec.h"
 
 namespace OHOS {
 namespace NetManagerStandard {
 namespace {
 using namespace testing::ext;
+using namespace NetnsTestUtil;
 constexpr const char *DISTRIBUTED_TUN_CARD_NAME = "virnic";
+constexpr const char *IP_CMD_PATH = "/system/bin/ip";
+
+bool GetLinkFlags(const std::string &ifName, uint32_t &flags)
+{
+    int32_t sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ifreq ifr = {};
+    bool ret = sock >= 0 && strncpy_s(ifr.ifr_name, IFNAMSIZ, ifName.c_str(), ifName.length()) == 0 &&
+        ioctl(sock, SIOCGIFFLAGS, &ifr) == 0;
+    flags = static_cast<uint16_t>(ifr.ifr_flags);
+    if (sock >= 0) {
+        close(sock);
+    }
+    return ret;
+}
+
+bool IsLinkUp(const std::string &ifName)
+{
+    uint32_t flags = 0;
+    return GetLinkFlags(ifName, flags) && (flags & IFF_UP) != 0;
+}
+
+bool LinkExists(const std::string &ifName)
+{
+    uint32_t flags = 0;
+    return GetLinkFlags(ifName, flags);
+}
+
+bool HasAddress(const std::string &ifName, const std::string &addr)
+{
+    ifaddrs *addrs = nullptr;
+    if (getifaddrs(&addrs) != 0) {
+        return false;
+    }
+    bool found = false;
+    for (ifaddrs *it = addrs; it != nullptr && !found; it = it->ifa_next) {
+        char buf[INET_ADDRSTRLEN] = {0};
+        found = it->ifa_addr != nullptr && it->ifa_addr->sa_family == AF_INET && ifName == it->ifa_name &&
+            inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in *>(it->ifa_addr)->sin_addr, buf, sizeof(buf)) &&
+            addr == buf;
+    }
+    freeifaddrs(addrs);
+    return found;
+}
 } // namespace
 
 class DistributedManagerTest : public testing::Test {
@@ -71,5 +123,91 @@ HWTEST_F(DistributedManagerTest, ConfigVirnicAndVeth001, TestSize.Level1)
     result = DistributedManager::GetInstance().ConfigVirnicAndVeth(virNicAddr, virnicName, virnicVethName);
     EXPECT_EQ(result, NETMANAGER_SUCCESS);
 }
+
+HWTEST_F(DistributedManagerTest, ConfigVirnicAndVethNetnsTest001, TestSize.Level1)
+{
+    if (getuid() != 0) {
+        GTEST_SKIP() << "needs root";
+    }
+    bool isRun = RunInNewNetns([]() {
+        auto &manager = DistributedManager::GetInstance();
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ(manager.ConfigVirnicAndVeth("192.168.10.2", "virnic0", "virnic0-veth"), NETMANAGER_SUCCESS);
+        auto netlinkCost = std::chrono::steady_clock::now() - start;
+        EXPECT_TRUE(IsLinkUp("virnic0"));
+        EXPECT_TRUE(IsLinkUp("virnic0-veth"));
+        EXPECT_TRUE(HasAddress("virnic0", "192.168.10.2"));
+        EXPECT_TRUE(HasAddress("virnic0-veth", "192.168.10.1"));
+        EXPECT_EQ(manager.ConfigVirnicAndVeth("192.168.10.2", "virnic0", "virnic0-veth"), NETMANAGER_ERROR);
+        manager.DisableVirnic("virnic0");
+        EXPECT_FALSE(LinkExists("virnic0"));
+        EXPECT_FALSE(LinkExists("virnic0-veth"));
+
+        if (access(IP_CMD_PATH, X_OK) != 0) {
+            return;
+        }
+        // The same bring-up with the ip commands it used to take
+        std::string ip = IP_CMD_PATH;
+        start = std::chrono::steady_clock::now();
+        EXPECT_EQ(CommonUtils::ForkExec(ip + " link add virnic0 type veth peer name virnic0-veth"), NETMANAGER_SUCCESS);
+        EXPECT_EQ(CommonUtils::ForkExec(ip + " link set virnic0 up"), NETMANAGER_SUCCESS);
+        EXPECT_EQ(CommonUtils::ForkExec(ip + " link set virnic0-veth up"), NETMANAGER_SUCCESS);
+        EXPECT_EQ(CommonUtils::ForkExec(ip + " addr add 192.168.10.2/24 dev virnic0"), NETMANAGER_SUCCESS);
+        EXPECT_EQ(CommonUtils::ForkExec(ip + " addr add 192.168.10.1/24 dev virnic0-veth"), NETMANAGER_SUCCESS);
+        auto forkCost = std::chrono::steady_clock::now() - start;
+        EXPECT_TRUE(HasAddress("virnic0-veth", "192.168.10.1"));
+        EXPECT_LT(netlinkCost, forkCost);
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "cannot create a network namespace";
+    }
+}
+
+HWTEST_F(DistributedManagerTest, RtnetlinkTransactionRollbackTest001, TestSize.Level1)
+{
+    if (getuid() != 0) {
+        GTEST_SKIP() << "needs root";
+    }
+    bool isRun = RunInNewNetns([]() {
+        nmd::RtnetlinkTransaction transaction;
+        // The address added twice fails, the links created before it are deleted again
+        int32_t ret = transaction.AddVethPair("veth0", "veth1")
+                          .SetLinkUp("veth0", true)
+                          .AddAddress("veth0", "10.1.1.1", 24)
+                          .AddNeighbor("veth0", "10.1.1.2", "02:00:00:00:00:02")
+                          .AddAddress("veth0", "10.1.1.1", 24)
+                          .Commit();
+        EXPECT_EQ(ret, -EEXIST);
+        EXPECT_FALSE(LinkExists("veth0"));
+        EXPECT_FALSE(LinkExists("veth1"));
+
+        EXPECT_EQ(transaction.AddVethPair("veth0", "veth1").SetLinkUp("veth0", true).Commit(), 0);
+        EXPECT_TRUE(IsLinkUp("veth0"));
+        EXPECT_FALSE(IsLinkUp("veth1"));
+
+        // On links that stay, the address, neighbor and route applied before the failure are removed
+        auto configure = [&transaction](const std::string &failingNeighbor) {
+            return transaction.AddAddress("veth0", "10.1.1.1", 24)
+                .AddNeighbor("veth0", "10.1.1.2", "02:00:00:00:00:02")
+                .AddRoute("veth0", "10.2.0.0", 16, "10.1.1.2", 100)
+                .AddNeighbor("veth0", failingNeighbor, "02:00:00:00:00:03")
+                .Commit();
+        };
+        EXPECT_EQ(configure("10.1.1.2"), -EEXIST);
+        EXPECT_TRUE(LinkExists("veth0"));
+        EXPECT_FALSE(HasAddress("veth0", "10.1.1.1"));
+        EXPECT_EQ(configure("10.1.1.3"), 0);
+        EXPECT_TRUE(HasAddress("veth0", "10.1.1.1"));
+
+        EXPECT_EQ(transaction.AddAddress("veth0", "10.1.1.256", 24).SetLinkUp("veth1", true).Commit(), -EINVAL);
+        EXPECT_FALSE(IsLinkUp("veth1"));
+        EXPECT_EQ(transaction.AddRoute("veth2", "10.3.0.0", 16, "", 100).Commit(), -ENODEV);
+        EXPECT_EQ(transaction.DeleteLink("veth1").Commit(), 0);
+        EXPECT_FALSE(LinkExists("veth0"));
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "cannot create a network namespace";
+    }
+}
 } // namespace NetManagerStandard
 } // namespace OHOS
@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#ifdef GTEST_API_
+#define private public
+#endif
+#include "dns_cache_refresher.h"
+#include "dns_resolv_config.h"
+
+namespace OHOS {
+namespace nmd {
+namespace {
+using namespace testing::ext;
+constexpr uint32_t UPSTREAM_TTL_SEC = 300;
+constexpr uint32_t STALE_LIMIT_SEC = 3600;
+constexpr uint32_t RESOLVE_TIMEOUT_MS = 1000;
+constexpr uint64_t MS_PER_SEC = 1000;
+constexpr const char *LOOPBACK = "127.0.0.1";
+constexpr const char *FAIL_HOST = "fail.example.test";
+constexpr uint16_t DNS_FLAGS_ANSWER = 0x8180;
+constexpr uint16_t DNS_FLAGS_SERVFAIL = 0x8182;
+constexpr size_t DNS_HEADER_LEN = 12;
+constexpr size_t DNS_ANSWER_COUNT_OFFSET = 6;
+constexpr int POLL_INTERVAL_MS = 50;
+// The replayed trace: a Zipf popularity over the hosts, exponential gaps between queries
+constexpr uint32_t TRACE_HOST_NUM = 50;
+constexpr uint32_t TRACE_QUERY_NUM = 20000;
+constexpr double TRACE_ZIPF_EXPONENT = 1.0;
+constexpr double TRACE_MEAN_GAP_MS = 2000.0;
+constexpr uint32_t TRACE_SEED = 20250301;
+// Virtual round trip to the upstream server, different per host so the misses spread over the tail
+constexpr uint32_t UPSTREAM_RTT_BASE_MS = 20;
+constexpr uint32_t UPSTREAM_RTT_SPREAD_MS = 200;
+
+void AppendU16(std::vector<uint8_t> &packet, uint16_t value)
+{
+    packet.push_back(static_cast<uint8_t>(value >> 8));
+    packet.push_back(static_cast<uint8_t>(value));
+}
+
+/* A loopback server answering every A query with one address derived from the name */
+class FakeUpstream {
+public:
+    FakeUpstream()
+    {
+        sock_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (sock_ < 0 || bind(sock_, reinterpret_cast<sockaddr *>(&addr), len) != 0 ||
+            getsockname(sock_, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+            return;
+        }
+        port_ = ntohs(addr.sin_port);
+        worker_ = std::thread([this]() { Serve(); });
+    }
+
+    ~FakeUpstream()
+    {
+        stop_ = true;
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        if (sock_ >= 0) {
+            close(sock_);
+        }
+    }
+
+    uint16_t GetPort() const
+    {
+        return port_;
+    }
+
+    uint32_t GetQueryCount() const
+    {
+        return queryCount_;
+    }
+
+    static in_addr AddressOf(const std::string &hostName)
+    {
+        in_addr addr = {};
+        addr.s_addr = htonl(0x0a000000 | (static_cast<uint32_t>(std::hash<std::string> {}(hostName)) & 0xffffff));
+        return addr;
+    }
+
+private:
+    void Serve()
+    {
+        uint8_t query[512];
+        while (!stop_) {
+            pollfd fds = {sock_, POLLIN, 0};
+            if (poll(&fds, 1, POLL_INTERVAL_MS) <= 0) {
+                continue;
+            }
+            sockaddr_storage peer = {};
+            socklen_t peerLen = sizeof(peer);
+            ssize_t len = recvfrom(sock_, query, sizeof(query), 0, reinterpret_cast<sockaddr *>(&peer), &peerLen);
+            if (len <= static_cast<ssize_t>(DNS_HEADER_LEN)) {
+                continue;
+            }
+            ++queryCount_;
+            std::vector<uint8_t> answer = BuildAnswer(query, static_cast<size_t>(len));
+            sendto(sock_, answer.data(), answer.size(), 0, reinterpret_cast<sockaddr *>(&peer), peerLen);
+        }
+    }
+
+    static std::vector<uint8_t> BuildAnswer(const uint8_t *query, size_t len)
+    {
+        std::string name;
+        size_t offset = DNS_HEADER_LEN;
+        while (offset < len && query[offset] != 0) {
+            name += (name.empty() ? "" : ".") + std::string(reinterpret_cast<const char *>(query + offset + 1),
+                                                            query[offset]);
+            offset += query[offset] + 1;
+        }
+        size_t questionEnd = offset + 1 + sizeof(uint32_t);
+        uint16_t type = static_cast<uint16_t>((query[offset + 1] << 8) | query[offset + 2]);
+        std::vector<uint8_t> answer(query, query + std::min(questionEnd, len));
+        bool isFail = name == FAIL_HOST;
+        answer[2] = static_cast<uint8_t>((isFail ? DNS_FLAGS_SERVFAIL : DNS_FLAGS_ANSWER) >> 8);
+        answer[3] = static_cast<uint8_t>(isFail ? DNS_FLAGS_SERVFAIL : DNS_FLAGS_ANSWER);
+        if (isFail || type != DNS_TYPE_A) {
+            return answer;
+        }
+        answer[DNS_ANSWER_COUNT_OFFSET + 1] = 1;
+        AppendU16(answer, 0xc00c);
+        AppendU16(answer, DNS_TYPE_A);
+        AppendU16(answer, 1);
+        AppendU16(answer, 0);
+        AppendU16(answer, UPSTREAM_TTL_SEC);
+        AppendU16(answer, sizeof(in_addr));
+        in_addr addr = AddressOf(name);
+        auto bytes = reinterpret_cast<const uint8_t *>(&addr);
+        answer.insert(answer.end(), bytes, bytes + sizeof(addr));
+        return answer;
+    }
+
+    int32_t sock_ = -1;
+    uint16_t port_ = 0;
+    std::atomic_bool stop_ = false;
+    std::atomic_uint32_t queryCount_ = 0;
+    std::thread worker_;
+};
+
+struct ReplayResult {
+    double hitRate = 0;
+    uint32_t staleHits = 0;
+    uint32_t upstreamQueries = 0;
+    uint32_t p50Ms = 0;
+    uint32_t p99Ms = 0;
+    uint32_t maxMs = 0;
+};
+
+struct PendingFill {
+    uint64_t doneMs;
+    std::string hostName;
+    std::vector<AddrInfoWithTtl> records;
+};
+
+std::string TraceHost(uint32_t index)
+{
+    return "host" + std::to_string(index) + ".example.test";
+}
+
+uint32_t UpstreamRtt(const std::string &hostName)
+{
+    return UPSTREAM_RTT_BASE_MS + static_cast<uint32_t>(std::hash<std::string> {}(hostName) % UPSTREAM_RTT_SPREAD_MS);
+}
+
+std::vector<std::pair<uint64_t, uint32_t>> GenerateTrace()
+{
+    std::vector<double> weights;
+    for (uint32_t i = 1; i <= TRACE_HOST_NUM; ++i) {
+        weights.push_back(1.0 / std::pow(static_cast<double>(i), TRACE_ZIPF_EXPONENT));
+    }
+    std::mt19937 engine(TRACE_SEED);
+    std::discrete_distribution<uint32_t> pickHost(weights.begin(), weights.end());
+    std::exponential_distribution<double> gap(1.0 / TRACE_MEAN_GAP_MS);
+    std::vector<std::pair<uint64_t, uint32_t>> trace;
+    double nowMs = 0;
+    for (uint32_t i = 0; i < TRACE_QUERY_NUM; ++i) {
+        nowMs += gap(engine);
+        trace.emplace_back(static_cast<uint64_t>(nowMs), pickHost(engine));
+    }
+    return trace;
+}
+
+/*
+ * Replays the trace against one cache on a virtual clock. A hit costs nothing, a miss costs the
+ * round trip to the fake upstream, and refreshes complete one round trip after they start. The
+ * answers themselves come from the fake upstream over loopback.
+ */
+ReplayResult Replay(const std::vector<std::pair<uint64_t, uint32_t>> &trace, const DnsCacheRefreshPolicy &policy,
+                    FakeUpstream &upstream)
+{
+    DnsResolvConfig config;
+    config.SetCacheRefreshPolicy(policy);
+    DnsCacheRefresher refresher(upstream.GetPort());
+    std::vector<PendingFill> pending;
+    std::vector<uint32_t> latencies;
+    uint32_t hits = 0;
+    ReplayResult result;
+    uint32_t queriesBefore = upstream.GetQueryCount();
+    auto resolve = [&](const std::string &hostName, uint64_t doneMs) {
+        PendingFill fill = {doneMs, hostName, {}};
+        refresher.Resolve(0, {LOOPBACK}, hostName, false, RESOLVE_TIMEOUT_MS, fill.records);
+        pending.push_back(std::move(fill));
+    };
+    for (const auto &[nowMs, hostIndex] : trace) {
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->doneMs > nowMs) {
+                ++it;
+                continue;
+            }
+            config.UpdateCache(it->hostName, it->records, it->doneMs);
+            it = pending.erase(it);
+        }
+        std::string hostName = TraceHost(hostIndex);
+        bool needRefresh = false;
+        DnsCacheState state = DnsCacheState::MISS;
+        if (!config.GetCache().Get(hostName).empty()) {
+            state = config.CheckCacheState(hostName, nowMs, needRefresh);
+        }
+        if (state == DnsCacheState::MISS) {
+            config.GetCache().Delete(hostName);
+            latencies.push_back(UpstreamRtt(hostName));
+            resolve(hostName, nowMs + UpstreamRtt(hostName));
+            continue;
+        }
+        ++hits;
+        result.staleHits += state == DnsCacheState::STALE ? 1 : 0;
+        latencies.push_back(0);
+        if (needRefresh) {
+            resolve(hostName, nowMs + UpstreamRtt(hostName));
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    result.hitRate = static_cast<double>(hits) / trace.size();
+    result.upstreamQueries = upstream.GetQueryCount() - queriesBefore;
+    result.p50Ms = latencies[latencies.size() / 2];
+    result.p99Ms = latencies[latencies.size() * 99 / 100];
+    result.maxMs = latencies.back();
+    return result;
+}
+
+void PrintResult(const char *name, const ReplayResult &result)
+{
+    printf("%-24s hit %.2f%%, stale hits %u, upstream queries %u, p50 %u ms, p99 %u ms, max %u ms\n", name,
+           result.hitRate * 100, result.staleHits, result.upstreamQueries, result.p50Ms, result.p99Ms, result.maxMs);
+}
+} // namespace
+
+class DnsCacheRefresherTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void DnsCacheRefresherTest::SetUpTestCase() {}
+
+void DnsCacheRefresherTest::TearDownTestCase() {}
+
+void DnsCacheRefresherTest::SetUp() {}
+
+void DnsCacheRefresherTest::TearDown() {}
+
+HWTEST_F(DnsCacheRefresherTest, BuildQuery001, TestSize.Level1)
+{
+    std::vector<uint8_t> packet;
+    EXPECT_TRUE(DnsCacheRefresher::BuildQuery("www.example.com.", 0x1234, DNS_TYPE_A, packet));
+    std::vector<uint8_t> expected = {0x12, 0x34, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0, 3, 'w', 'w', 'w', 7, 'e', 'x',
+                                     'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0, 0, 1, 0, 1};
+    EXPECT_EQ(packet, expected);
+    EXPECT_FALSE(DnsCacheRefresher::BuildQuery("", 1, DNS_TYPE_A, packet));
+    EXPECT_FALSE(DnsCacheRefresher::BuildQuery("a..b", 1, DNS_TYPE_A, packet));
+    EXPECT_FALSE(DnsCacheRefresher::BuildQuery(std::string(64, 'a') + ".com", 1, DNS_TYPE_A, packet));
+}
+
+HWTEST_F(DnsCacheRefresherTest, ParseAnswer001, TestSize.Level1)
+{
+    // www.example.com CNAME cdn.example.com, cdn.example.com A 1.2.3.4, names compressed
+    std::vector<uint8_t> packet = {0x12, 0x34, 0x81, 0x80, 0, 1, 0, 2, 0, 0, 0, 0, 3, 'w', 'w', 'w', 7, 'e', 'x', 'a',
+                                   'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0, 0, 1, 0, 1, 0xc0, 0x0c, 0, 5, 0, 1, 0, 0,
+                                   0, 60, 0, 6, 3, 'c', 'd', 'n', 0xc0, 0x10, 0xc0, 0x2d, 0, 1, 0, 1, 0, 0, 0x0e, 0x10,
+                                   0, 4, 1, 2, 3, 4};
+    std::vector<AddrInfoWithTtl> records;
+    ASSERT_TRUE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, "WWW.example.com.", DNS_TYPE_A,
+                                               records));
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].ttl, 3600);
+    EXPECT_EQ(records[0].addrInfo.aiFamily, AF_INET);
+    EXPECT_EQ(records[0].addrInfo.aiSockType, SOCK_STREAM);
+    EXPECT_EQ(records[1].addrInfo.aiSockType, SOCK_DGRAM);
+    EXPECT_EQ(ntohl(records[0].addrInfo.aiAddr.sin.sin_addr.s_addr), 0x01020304);
+
+    records.clear();
+    const std::string host = "www.example.com";
+    EXPECT_FALSE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x4321, host, DNS_TYPE_A, records));
+    EXPECT_FALSE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size() - 1, 0x1234, host, DNS_TYPE_A, records));
+    packet[3] = 0x83;
+    EXPECT_FALSE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, host, DNS_TYPE_A, records));
+    EXPECT_TRUE(records.empty());
+}
+
+HWTEST_F(DnsCacheRefresherTest, ParseAnswer002, TestSize.Level1)
+{
+    // www.example.com CNAME cdn.example.com, then A records for cdn.example.com and the unrelated evil.com
+    std::vector<uint8_t> packet = {0x12, 0x34, 0x81, 0x80, 0, 1, 0, 3, 0, 0, 0, 0, 3, 'w', 'w', 'w', 7, 'e', 'x', 'a',
+                                   'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0, 0, 1, 0, 1, 0xc0, 0x0c, 0, 5, 0, 1, 0, 0,
+                                   0, 60, 0, 6, 3, 'c', 'd', 'n', 0xc0, 0x10, 0xc0, 0x2d, 0, 1, 0, 1, 0, 0, 0x0e, 0x10,
+                                   0, 4, 1, 2, 3, 4, 4, 'e', 'v', 'i', 'l', 0xc0, 0x18, 0, 1, 0, 1, 0, 0, 0x0e, 0x10,
+                                   0, 4, 6, 6, 6, 6};
+    std::vector<AddrInfoWithTtl> records;
+    ASSERT_TRUE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, "www.example.com", DNS_TYPE_A,
+                                               records));
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(ntohl(records[0].addrInfo.aiAddr.sin.sin_addr.s_addr), 0x01020304);
+
+    // The echoed question has to be the one that was asked
+    records.clear();
+    EXPECT_FALSE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, "www.example.org", DNS_TYPE_A,
+                                                records));
+    EXPECT_FALSE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, "www.example.com",
+                                                DNS_TYPE_AAAA, records));
+    EXPECT_TRUE(records.empty());
+
+    // Without the CNAME nothing is owned by the queried name
+    packet[36] = 16;
+    ASSERT_TRUE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, "www.example.com", DNS_TYPE_A,
+                                               records));
+    EXPECT_TRUE(records.empty());
+    // A compression pointer pointing forward could loop, the answer is malformed
+    packet[34] = 0x2d;
+    EXPECT_FALSE(DnsCacheRefresher::ParseAnswer(packet.data(), packet.size(), 0x1234, "www.example.com", DNS_TYPE_A,
+                                                records));
+}
+
+HWTEST_F(DnsCacheRefresherTest, ResolveFromFakeUpstream001, TestSize.Level1)
+{
+    FakeUpstream upstream;
+    ASSERT_NE(upstream.GetPort(), 0);
+    DnsCacheRefresher refresher(upstream.GetPort());
+    std::vector<AddrInfoWithTtl> records;
+    ASSERT_EQ(refresher.Resolve(0, {LOOPBACK}, "www.example.test", true, RESOLVE_TIMEOUT_MS, records), 0);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].ttl, UPSTREAM_TTL_SEC);
+    EXPECT_EQ(records[0].addrInfo.aiAddr.sin.sin_addr.s_addr, FakeUpstream::AddressOf("www.example.test").s_addr);
+    EXPECT_EQ(upstream.GetQueryCount(), 2);
+
+    EXPECT_NE(refresher.Resolve(0, {LOOPBACK}, FAIL_HOST, false, RESOLVE_TIMEOUT_MS, records), 0);
+    EXPECT_NE(refresher.Resolve(0, {"not an address"}, "www.example.test", false, RESOLVE_TIMEOUT_MS, records), 0);
+    // The first server refuses, the second answers
+    DnsCacheRefresher closedPort(upstream.GetPort() + 1);
+    EXPECT_NE(closedPort.Resolve(0, {LOOPBACK}, "www.example.test", false, RESOLVE_TIMEOUT_MS, records), 0);
+    EXPECT_EQ(refresher.Resolve(0, {"::1", LOOPBACK}, "www.example.test", false, RESOLVE_TIMEOUT_MS, records), 0);
+}
+
+HWTEST_F(DnsCacheRefresherTest, CacheStatePolicy001, TestSize.Level1)
+{
+    const std::string host = "www.example.test";
+    AddrInfoWithTtl record = {};
+    record.ttl = 60;
+    DnsResolvConfig config;
+    DnsResolvConfig otherNet;
+    bool needRefresh = false;
+
+    // Off by default, the records are fresh until the delayed queue removes them
+    config.UpdateCache(host, {record}, 0);
+    EXPECT_EQ(config.CheckCacheState(host, 61 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    EXPECT_FALSE(needRefresh);
+
+    config.SetCacheRefreshPolicy({true, 30, true});
+    otherNet.SetCacheRefreshPolicy({true, 30, true});
+    config.UpdateCache(host, {record}, 0);
+    otherNet.UpdateCache(host, {record}, 0);
+    EXPECT_EQ(config.CheckCacheState(host, 10 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    EXPECT_EQ(config.CheckCacheState(host, 20 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    // Hot, but not yet within the last tenth of the ttl
+    EXPECT_EQ(config.CheckCacheState(host, 50 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    EXPECT_FALSE(needRefresh);
+    EXPECT_EQ(config.CheckCacheState(host, 55 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    EXPECT_TRUE(needRefresh);
+    EXPECT_EQ(config.CheckCacheState(host, 56 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    EXPECT_FALSE(needRefresh);
+    // Hit counters are kept per network
+    EXPECT_EQ(otherNet.CheckCacheState(host, 55 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    EXPECT_FALSE(needRefresh);
+
+    // The prefetch failed, the expired records are served while another refresh runs
+    config.FinishRefresh(host);
+    EXPECT_EQ(config.CheckCacheState(host, 61 * MS_PER_SEC, needRefresh), DnsCacheState::STALE);
+    EXPECT_TRUE(needRefresh);
+    EXPECT_EQ(config.CheckCacheState(host, 62 * MS_PER_SEC, needRefresh), DnsCacheState::STALE);
+    EXPECT_FALSE(needRefresh);
+    EXPECT_EQ(config.CheckCacheState(host, 90 * MS_PER_SEC, needRefresh), DnsCacheState::MISS);
+
+    config.UpdateCache(host, {record}, 100 * MS_PER_SEC);
+    EXPECT_EQ(config.CheckCacheState(host, 159 * MS_PER_SEC, needRefresh), DnsCacheState::FRESH);
+    config.SetCacheRefreshPolicy({true, MAX_DNS_STALE_LIMIT_SEC + 1, false});
+    EXPECT_EQ(config.GetCacheRefreshPolicy().staleLimitSec, MAX_DNS_STALE_LIMIT_SEC);
+}
+
+HWTEST_F(DnsCacheRefresherTest, CacheStateBounded001, TestSize.Level1)
+{
+    AddrInfoWithTtl record = {};
+    record.ttl = 60;
+    DnsResolvConfig config;
+    config.SetCacheRefreshPolicy({true, 30, true});
+    for (size_t i = 0; i <= MAX_CACHE_STATE_SIZE; ++i) {
+        config.UpdateCache(TraceHost(i), {record}, i);
+    }
+    EXPECT_EQ(config.cacheState_.size(), MAX_CACHE_STATE_SIZE);
+    EXPECT_EQ(config.cacheState_.count(TraceHost(0)), 0);
+    config.ClearCacheState();
+    EXPECT_TRUE(config.cacheState_.empty());
+}
+
+HWTEST_F(DnsCacheRefresherTest, ReplayTrace001, TestSize.Level1)
+{
+    FakeUpstream upstream;
+    ASSERT_NE(upstream.GetPort(), 0);
+    auto trace = GenerateTrace();
+    // A zero stale window is plain ttl expiry, the behaviour without serve-stale
+    ReplayResult expiry = Replay(trace, {true, 0, false}, upstream);
+    ReplayResult stale = Replay(trace, {true, STALE_LIMIT_SEC, false}, upstream);
+    ReplayResult prefetch = Replay(trace, {true, STALE_LIMIT_SEC, true}, upstream);
+    PrintResult("ttl expiry", expiry);
+    PrintResult("serve-stale", stale);
+    PrintResult("serve-stale + prefetch", prefetch);
+
+    EXPECT_GT(stale.hitRate, expiry.hitRate);
+    EXPECT_LT(stale.p99Ms, expiry.p99Ms);
+    EXPECT_EQ(expiry.staleHits, 0);
+    EXPECT_GE(prefetch.hitRate, stale.hitRate);
+    EXPECT_LT(prefetch.staleHits, stale.staleHits);
+    EXPECT_LE(prefetch.p99Ms, stale.p99Ms);
+}
+} // namespace nmd
+} // namespace OHOS
@@ -28,6 +28,7 @@
 #include "net_conn_client.h"
 #include "common_notify_callback_test.h"
 #include "refbase.h"
+#include "securec.h"
 
 namespace OHOS {
 namespace nmd {
@@ -509,5 +510,52 @@ HWTEST_F(DnsQualityDiagTest, HandleEvent_ShouldReturnZero_WhenCalled_05, TestSiz
     EXPECT_EQ(dnsQualityDiag.HandleEvent(event), 0);
 }
 
+HWTEST_F(DnsQualityDiagTest, GetServerQuality_ShouldCountEveryQuery_WhenReportsExceedCap, TestSize.Level0)
+{
+    struct PostDnsQueryParam queryParam = {};
+    queryParam.netId = 101;
+    queryParam.processInfo.firstQueryEndDuration = 30;
+    ASSERT_EQ(strcpy_s(queryParam.processInfo.ipv4QueryInfo.serverAddr,
+        sizeof(queryParam.processInfo.ipv4QueryInfo.serverAddr), "8.8.8.8"), EOK);
+    for (uint32_t i = 0; i < MAX_RESULT_SIZE * 2; i++) {
+        dnsQualityDiag.ReportDnsQueryResult(queryParam, nullptr, 0);
+    }
+    queryParam.processInfo.isFromCache = 1;
+    dnsQualityDiag.ReportDnsQueryResult(queryParam, nullptr, 0);
+
+    DnsServerQualityInfo info;
+    ASSERT_EQ(dnsQualityDiag.GetServerQuality(101, "8.8.8.8", info), 0);
+    EXPECT_EQ(info.queryCount, MAX_RESULT_SIZE * 2);
+    EXPECT_EQ(info.failCount, 0);
+    EXPECT_EQ(info.latencyP50Ms, 30);
+    EXPECT_EQ(dnsQualityDiag.GetServerQuality(101, "8.8.4.4", info), -1);
+}
+
+HWTEST_F(DnsQualityDiagTest, GetServerQuality_ShouldTimeEachFamily_WhenServersDiffer, TestSize.Level0)
+{
+    struct PostDnsQueryParam queryParam = {};
+    queryParam.netId = 102;
+    // The AAAA answer came first, the A answer held the return to the app back
+    queryParam.processInfo.firstReturnType = 28;
+    queryParam.processInfo.firstQueryEndDuration = 20;
+    queryParam.processInfo.firstQueryEnd2AppDuration = 400;
+    ASSERT_EQ(strcpy_s(queryParam.processInfo.ipv4QueryInfo.serverAddr,
+        sizeof(queryParam.processInfo.ipv4QueryInfo.serverAddr), "8.8.8.8"), EOK);
+    ASSERT_EQ(strcpy_s(queryParam.processInfo.ipv6QueryInfo.serverAddr,
+        sizeof(queryParam.processInfo.ipv6QueryInfo.serverAddr), "2001:db8::1"), EOK);
+    dnsQualityDiag.ReportDnsQueryResult(queryParam, nullptr, 0);
+
+    DnsServerQualityInfo ipv4Info;
+    DnsServerQualityInfo ipv6Info;
+    ASSERT_EQ(dnsQualityDiag.GetServerQuality(102, "8.8.8.8", ipv4Info), 0);
+    ASSERT_EQ(dnsQualityDiag.GetServerQuality(102, "2001:db8::1", ipv6Info), 0);
+    EXPECT_EQ(ipv6Info.latencyP50Ms, 20);
+    EXPECT_GT(ipv4Info.latencyP50Ms, ipv6Info.latencyP50Ms);
+
+    dnsQualityDiag.RemoveNetwork(102);
+    EXPECT_EQ(dnsQualityDiag.GetServerQuality(102, "8.8.8.8", ipv4Info), -1);
+    EXPECT_EQ(dnsQualityDiag.GetServerQuality(102, "2001:db8::1", ipv6Info), -1);
+}
+
 }  // namespace nmd
 }  // namespace OHOS
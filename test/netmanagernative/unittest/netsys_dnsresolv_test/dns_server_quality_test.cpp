@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dns_server_quality.h"
+
+namespace OHOS {
+namespace nmd {
+namespace {
+using namespace testing::ext;
+constexpr uint32_t TEST_NET_ID = 100;
+constexpr uint32_t SAMPLE_NUM = 100000;
+constexpr uint32_t BENCH_REPORT_NUM = 1000000;
+constexpr uint32_t BENCH_SERVER_NUM = 8;
+constexpr uint32_t RANDOM_SEED = 20250101;
+// The sketch error plus rounding the representative latency to whole milliseconds
+constexpr double QUANTILE_TOLERANCE = DnsLatencySketch::RELATIVE_ACCURACY;
+constexpr double ROUNDING_TOLERANCE_MS = 0.5;
+const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+uint32_t ExactQuantile(std::vector<uint32_t> &sorted, double quantile)
+{
+    auto rank = static_cast<size_t>(quantile * static_cast<double>(sorted.size() - 1));
+    return sorted[rank];
+}
+
+/* Mostly fast answers with a long tail of retransmissions, the shape resolver latencies have */
+std::vector<uint32_t> GenerateLatencies()
+{
+    std::mt19937 engine(RANDOM_SEED);
+    std::lognormal_distribution<double> fast(3.0, 0.6);
+    std::uniform_real_distribution<double> tail(1000.0, 5000.0);
+    std::uniform_int_distribution<uint32_t> pick(0, 99);
+    std::vector<uint32_t> latencies;
+    latencies.reserve(SAMPLE_NUM);
+    for (uint32_t i = 0; i < SAMPLE_NUM; ++i) {
+        double latency = pick(engine) < 97 ? fast(engine) : tail(engine);
+        latencies.push_back(static_cast<uint32_t>(latency));
+    }
+    return latencies;
+}
+} // namespace
+
+class DnsServerQualityTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void DnsServerQualityTest::SetUpTestCase() {}
+
+void DnsServerQualityTest::TearDownTestCase() {}
+
+void DnsServerQualityTest::SetUp() {}
+
+void DnsServerQualityTest::TearDown() {}
+
+HWTEST_F(DnsServerQualityTest, SketchQuantileAccuracy001, TestSize.Level1)
+{
+    std::vector<uint32_t> latencies = GenerateLatencies();
+    DnsLatencySketch sketch;
+    for (uint32_t latency : latencies) {
+        sketch.Add(latency);
+    }
+    EXPECT_EQ(sketch.GetCount(), SAMPLE_NUM);
+    std::sort(latencies.begin(), latencies.end());
+    for (double quantile : QUANTILES) {
+        uint32_t exact = ExactQuantile(latencies, quantile);
+        uint32_t estimate = sketch.GetQuantile(quantile);
+        EXPECT_LE(std::abs(static_cast<double>(estimate) - exact), exact * QUANTILE_TOLERANCE + ROUNDING_TOLERANCE_MS)
+            << "quantile " << quantile << " exact " << exact << " estimate " << estimate;
+        printf("p%g: exact %u ms, sketch %u ms\n", quantile * 100, exact, estimate);
+    }
+}
+
+HWTEST_F(DnsServerQualityTest, SketchEdgeValues001, TestSize.Level1)
+{
+    DnsLatencySketch sketch;
+    EXPECT_EQ(sketch.GetQuantile(0.5), 0);
+    sketch.Add(0);
+    EXPECT_EQ(sketch.GetQuantile(1.0), 0);
+    sketch.Add(DNS_LATENCY_MAX_MS * 2);
+    EXPECT_NEAR(sketch.GetQuantile(1.0), DNS_LATENCY_MAX_MS, DNS_LATENCY_MAX_MS * QUANTILE_TOLERANCE);
+    sketch.Clear();
+    EXPECT_EQ(sketch.GetCount(), 0);
+    sketch.Add(1);
+    EXPECT_EQ(sketch.GetQuantile(0.5), 1);
+}
+
+HWTEST_F(DnsServerQualityTest, ServerCounters001, TestSize.Level1)
+{
+    DnsServerQuality quality;
+    const std::string server = "192.168.1.1";
+    quality.AddReport(TEST_NET_ID, server, 20, 0);
+    quality.AddReport(TEST_NET_ID, server, 40, 0);
+    quality.AddReport(TEST_NET_ID, server, 5000, 2);
+    quality.AddReport(TEST_NET_ID, server, 10, -1);
+    quality.AddReport(TEST_NET_ID, "", 10, 0);
+
+    DnsServerQualityInfo info;
+    ASSERT_TRUE(quality.GetServerQuality(TEST_NET_ID, server, info));
+    EXPECT_EQ(info.queryCount, 4);
+    EXPECT_EQ(info.failCount, 2);
+    EXPECT_EQ(info.rcodeCount[0], 2);
+    EXPECT_EQ(info.rcodeCount[2], 1);
+    EXPECT_EQ(info.rcodeCount[DNS_RCODE_COUNTER_NUM - 1], 1);
+    // Failed queries do not move the latency figures
+    EXPECT_LE(info.latencyP99Ms, 41);
+    EXPECT_GT(info.ewmaLatencyMs, 20);
+    EXPECT_LT(info.ewmaLatencyMs, 40);
+    EXPECT_LT(info.ewmaSuccessRate, 1.0);
+    EXPECT_GT(info.healthScore, 0.0);
+    EXPECT_FALSE(quality.GetServerQuality(TEST_NET_ID + 1, server, info));
+    EXPECT_FALSE(quality.GetServerQuality(TEST_NET_ID, "", info));
+}
+
+HWTEST_F(DnsServerQualityTest, HealthScoreRanksServers001, TestSize.Level1)
+{
+    DnsServerQuality quality;
+    for (int32_t i = 0; i < 100; ++i) {
+        quality.AddReport(TEST_NET_ID, "fast", 10, 0);
+        quality.AddReport(TEST_NET_ID, "slow", 300, 0);
+        quality.AddReport(TEST_NET_ID, "flaky", 10, i % 2 == 0 ? 0 : 2);
+    }
+    DnsServerQualityInfo fast;
+    DnsServerQualityInfo slow;
+    DnsServerQualityInfo flaky;
+    ASSERT_TRUE(quality.GetServerQuality(TEST_NET_ID, "fast", fast));
+    ASSERT_TRUE(quality.GetServerQuality(TEST_NET_ID, "slow", slow));
+    ASSERT_TRUE(quality.GetServerQuality(TEST_NET_ID, "flaky", flaky));
+    EXPECT_GT(fast.healthScore, slow.healthScore);
+    EXPECT_GT(fast.healthScore, flaky.healthScore);
+}
+
+HWTEST_F(DnsServerQualityTest, BoundedServers001, TestSize.Level1)
+{
+    DnsServerQuality quality;
+    for (size_t i = 0; i <= DnsServerQuality::MAX_SERVER_NUM; ++i) {
+        quality.AddReport(TEST_NET_ID, "10.0.0." + std::to_string(i), 10, 0);
+    }
+    DnsServerQualityInfo info;
+    EXPECT_FALSE(quality.GetServerQuality(TEST_NET_ID, "10.0.0.0", info));
+    EXPECT_TRUE(quality.GetServerQuality(TEST_NET_ID, "10.0.0.1", info));
+    EXPECT_TRUE(quality.GetServerQuality(TEST_NET_ID, "10.0.0." + std::to_string(DnsServerQuality::MAX_SERVER_NUM),
+        info));
+
+    quality.RemoveNetwork(TEST_NET_ID);
+    EXPECT_FALSE(quality.GetServerQuality(TEST_NET_ID, "10.0.0.1", info));
+}
+
+HWTEST_F(DnsServerQualityTest, AddReportBenchmark001, TestSize.Level1)
+{
+    std::vector<uint32_t> latencies = GenerateLatencies();
+    std::vector<std::string> servers;
+    for (uint32_t i = 0; i < BENCH_SERVER_NUM; ++i) {
+        servers.push_back("fd00::" + std::to_string(i + 1));
+    }
+    DnsServerQuality quality;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < BENCH_REPORT_NUM; ++i) {
+        quality.AddReport(TEST_NET_ID, servers[i % BENCH_SERVER_NUM], latencies[i % SAMPLE_NUM], i % 50 == 0 ? 2 : 0);
+    }
+    double elapsedNs =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    DnsServerQualityInfo info;
+    ASSERT_TRUE(quality.GetServerQuality(TEST_NET_ID, servers[0], info));
+    EXPECT_EQ(info.queryCount, BENCH_REPORT_NUM / BENCH_SERVER_NUM);
+    printf("%u reports over %u servers: %.1f ns per report, sketch %zu bytes per server\n", BENCH_REPORT_NUM,
+        BENCH_SERVER_NUM, elapsedNs / BENCH_REPORT_NUM, sizeof(DnsLatencySketch));
+}
+} // namespace nmd
+} // namespace OHOS
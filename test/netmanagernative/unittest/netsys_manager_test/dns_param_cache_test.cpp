@@ -1140,5 +1140,109 @@ HWTEST_F(DNSParamCacheTest, IsInIpv6UidBlackListTest003, TestSize.Level1)
     dnsParCache.DestroyNetworkCache(netId);
 }
 
+#ifdef FEATURE_NET_FIREWALL_ENABLE
+static NetFirewallDomainParam MakeDomainParam(bool isWildcard, const std::string &domain)
+{
+    NetFirewallDomainParam param;
+    param.isWildcard = isWildcard;
+    param.domain = domain;
+    return param;
+}
+
+HWTEST_F(DNSParamCacheTest, GetFirewallRuleActionTest001, TestSize.Level1)
+{
+    NETNATIVE_LOGI("GetFirewallRuleActionTest001 enter");
+    DnsParamCache dnsParCache;
+    int32_t appUid = 20000001;
+    int32_t otherUid = 20000002;
+    int32_t userId = dnsParCache.GetUserId(appUid);
+    auto appRule = sptr<NetFirewallDomainRule>::MakeSptr();
+    appRule->userId = userId;
+    appRule->appUid = appUid;
+    appRule->ruleAction = FirewallRuleAction::RULE_DENY;
+    appRule->domains.push_back(MakeDomainParam(false, "www.example.com"));
+    appRule->domains.push_back(MakeDomainParam(true, "ads.example.com"));
+    auto userRule = sptr<NetFirewallDomainRule>::MakeSptr();
+    userRule->userId = userId;
+    userRule->appUid = 0;
+    userRule->ruleAction = FirewallRuleAction::RULE_ALLOW;
+    userRule->domains.push_back(MakeDomainParam(true, "example.com"));
+    std::vector<sptr<NetFirewallBaseRule>> ruleList = {appRule};
+    EXPECT_EQ(dnsParCache.SetFirewallRules(NetFirewallRuleType::RULE_DOMAIN, ruleList, false), 0);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "www.example.com"), FirewallRuleAction::RULE_INVALID);
+    ruleList = {userRule};
+    EXPECT_EQ(dnsParCache.SetFirewallRules(NetFirewallRuleType::RULE_DOMAIN, ruleList, true), 0);
+
+    // Without a default action the user allows, then an allow rule wins over a deny rule
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "WWW.example.com"), FirewallRuleAction::RULE_ALLOW);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "a.ads.example.com"), FirewallRuleAction::RULE_ALLOW);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "example.com"), FirewallRuleAction::RULE_ALLOW);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "example.org"), FirewallRuleAction::RULE_INVALID);
+
+    // With a deny default a deny rule wins, a rule covers its name and the names below it either way
+    dnsParCache.SetFirewallDefaultAction(userId, FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "WWW.example.com"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "a.www.example.com"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "ads.example.com"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "a.ads.example.com"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "example.com"), FirewallRuleAction::RULE_ALLOW);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(otherUid, "www.example.com"), FirewallRuleAction::RULE_ALLOW);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "example.org"), FirewallRuleAction::RULE_INVALID);
+}
+
+HWTEST_F(DNSParamCacheTest, GetFirewallRuleActionTest002, TestSize.Level1)
+{
+    NETNATIVE_LOGI("GetFirewallRuleActionTest002 enter");
+    DnsParamCache dnsParCache;
+    int32_t appUid = 20000001;
+    auto rule = sptr<NetFirewallDomainRule>::MakeSptr();
+    rule->userId = dnsParCache.GetUserId(appUid);
+    rule->appUid = appUid;
+    rule->ruleAction = FirewallRuleAction::RULE_DENY;
+    // Keyed as GetDomainHashKey does: every '*' dropped, "*" and "example.org." match no query
+    rule->domains.push_back(MakeDomainParam(false, "example.net"));
+    rule->domains.push_back(MakeDomainParam(true, "api*.example.com"));
+    rule->domains.push_back(MakeDomainParam(true, "*"));
+    rule->domains.push_back(MakeDomainParam(false, "example.org."));
+    std::vector<sptr<NetFirewallBaseRule>> ruleList = {rule};
+    EXPECT_EQ(dnsParCache.SetFirewallRules(NetFirewallRuleType::RULE_DOMAIN, ruleList, true), 0);
+
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "example.net"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "a.example.net"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "anexample.net"), FirewallRuleAction::RULE_INVALID);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "api.example.com"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "v1.api.example.com"), FirewallRuleAction::RULE_DENY);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "api1.example.com"), FirewallRuleAction::RULE_INVALID);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "example.org"), FirewallRuleAction::RULE_INVALID);
+    EXPECT_EQ(dnsParCache.GetFirewallRuleAction(appUid, "www.harmony.com"), FirewallRuleAction::RULE_INVALID);
+}
+
+HWTEST_F(DNSParamCacheTest, GetDnsCacheFirewallTest001, TestSize.Level1)
+{
+    NETNATIVE_LOGI("GetDnsCacheFirewallTest001 enter");
+    DnsParamCache dnsParCache;
+    uint16_t netId = 1;
+    std::string hostName = "www.example.com";
+    dnsParCache.CreateCacheForNet(netId);
+    AddrInfo addrInfo = {};
+    dnsParCache.SetDnsCache(netId, hostName, addrInfo);
+    dnsParCache.SetCallingUid(1);
+    EXPECT_EQ(dnsParCache.GetDnsCache(netId, hostName).size(), 1);
+
+    auto rule = sptr<NetFirewallDomainRule>::MakeSptr();
+    rule->userId = dnsParCache.GetUserId(1);
+    rule->appUid = 1;
+    rule->ruleAction = FirewallRuleAction::RULE_DENY;
+    rule->domains.push_back(MakeDomainParam(false, hostName));
+    std::vector<sptr<NetFirewallBaseRule>> ruleList = {rule};
+    EXPECT_EQ(dnsParCache.SetFirewallRules(NetFirewallRuleType::RULE_DOMAIN, ruleList, true), 0);
+    dnsParCache.SetDnsCache(netId, hostName, addrInfo);
+    EXPECT_TRUE(dnsParCache.GetDnsCache(netId, hostName).empty());
+    dnsParCache.SetCallingUid(2);
+    EXPECT_EQ(dnsParCache.GetDnsCache(netId, hostName).size(), 1);
+    dnsParCache.DestroyNetworkCache(netId);
+}
+#endif
+
 } // namespace NetsysNative
 } // namespace OHOS
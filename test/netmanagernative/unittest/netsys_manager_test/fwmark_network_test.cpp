@@ -14,16 +14,26 @@
  */
 
 #include <arpa/inet.h>
+#include <chrono>
 #include <cstdio>
 #include <gtest/gtest.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <thread>
 
 #define private public
 #include "fwmark_client.h"
 #include "fwmark_network.cpp"
 #include "netsys_sock_client.h"
 #undef private
+#include "bpf_def.h"
+#include "bpf_mapper.h"
+#include "bpf_path.h"
+#include "common_netns_test_util.h"
+#include "fwmark.h"
 #include "net_manager_constants.h"
 #include "netnative_log_wrapper.h"
 #include "singleton.h"
@@ -39,6 +49,89 @@ static constexpr const int32_t ERROR_CODE_SOCKETFD_INVALID = -1;
 static constexpr const int32_t ERROR_CODE_CONNECT_FAILED = -2;
 static constexpr const int32_t ERROR_CODE_SENDMSG_FAILED = -3;
 static constexpr const int32_t ERROR_CODE_READ_FAILED = -4;
+constexpr int32_t CONNECT_BENCH_ROUNDS = 200;
+constexpr int32_t MARK_REMOVE_WAIT_MS = 1000;
+constexpr int32_t MARK_REMOVE_POLL_MS = 10;
+constexpr int32_t LISTEN_BACKLOG = 16;
+enum ChildResult { CHILD_OK = 0, CHILD_PROTECT_FAILED, CHILD_SOCKET_FAILED, CHILD_MARK_WRONG };
+
+bool IsKernelMarkReady()
+{
+    return getuid() == 0 && access(NetManagerStandard::PROCESS_SOCK_MARK_MAP_PATH, F_OK) == 0 &&
+           access(FWMARK_SERVER_PATH.sun_path, F_OK) == 0;
+}
+
+Fwmark GetSocketMark(int32_t fd)
+{
+    Fwmark fwmark;
+    socklen_t len = sizeof(fwmark.intValue);
+    if (getsockopt(fd, SOL_SOCKET, SO_MARK, &fwmark.intValue, &len) != 0) {
+        fwmark.intValue = 0;
+    }
+    return fwmark;
+}
+
+Fwmark CreateSocketMark(int32_t domain)
+{
+    int32_t fd = socket(domain, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    Fwmark fwmark = GetSocketMark(fd);
+    close(fd);
+    return fwmark;
+}
+
+bool HasProcessMark(pid_t pid)
+{
+    NetManagerStandard::BpfMapper<process_sock_mark_key, process_sock_mark_value> map(
+        NetManagerStandard::PROCESS_SOCK_MARK_MAP_PATH, BPF_ANY);
+    process_sock_mark_value value = {};
+    return map.IsValid() && map.Read(static_cast<process_sock_mark_key>(pid), value) == 0;
+}
+
+bool WaitProcessMarkRemoved(pid_t pid)
+{
+    for (int32_t waited = 0; waited < MARK_REMOVE_WAIT_MS; waited += MARK_REMOVE_POLL_MS) {
+        if (!HasProcessMark(pid)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(MARK_REMOVE_POLL_MS));
+    }
+    return false;
+}
+
+bool SetLoopbackUp()
+{
+    int32_t fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ifreq ifr = {};
+    if (strcpy_s(ifr.ifr_name, sizeof(ifr.ifr_name), "lo") != EOK || ioctl(fd, SIOCGIFFLAGS, &ifr) != 0) {
+        close(fd);
+        return false;
+    }
+    ifr.ifr_flags |= IFF_UP;
+    bool ret = ioctl(fd, SIOCSIFFLAGS, &ifr) == 0;
+    close(fd);
+    return ret;
+}
+
+// Microseconds for rounds of socket, mark and loopback TCP connect
+int64_t MeasureConnect(int32_t listenFd, const sockaddr_in &addr, bool markByFwmarkd)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < CONNECT_BENCH_ROUNDS; i++) {
+        int32_t fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (markByFwmarkd) {
+            FwmarkClient().BindSocket(fd, NETID_FIRST);
+        }
+        if (connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        close(accept(listenFd, nullptr, nullptr));
+        close(fd);
+    }
+    auto cost = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(cost).count();
+}
+
 class ManagerNative : public std::enable_shared_from_this<ManagerNative> {
     DECLARE_DELAYED_SINGLETON(ManagerNative);
 
@@ -328,5 +421,113 @@ HWTEST_F(UnitTestFwmarkClient, HookSocketTest001, TestSize.Level1)
     int32_t tcpSocket2 = socket(AF_INET6, SOCK_STREAM, IPPROTO_TCP);
     EXPECT_TRUE(tcpSocket1 != -1 && tcpSocket2 != -1);
 }
+
+/**
+ * @tc.name: ProcessMarkTest001
+ * @tc.desc: Test the kernel marks the sockets of a process that selected a network, in a namespace of its own.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UnitTestFwmarkClient, ProcessMarkTest001, TestSize.Level1)
+{
+    if (!IsKernelMarkReady()) {
+        GTEST_SKIP() << "needs root, the process mark map and fwmarkd";
+    }
+    bool isRun = NetManagerStandard::NetnsTestUtil::RunInNewNetns([this]() {
+        ASSERT_EQ(fwmarkClient->SelectProcessNetwork(NETID_FIRST), NetManagerStandard::NETMANAGER_SUCCESS);
+        EXPECT_TRUE(HasProcessMark(getpid()));
+        for (int32_t domain : {AF_INET, AF_INET6}) {
+            Fwmark fwmark = CreateSocketMark(domain);
+            EXPECT_EQ(fwmark.netId, NETID_FIRST);
+            EXPECT_TRUE(fwmark.explicitlySelected);
+            EXPECT_TRUE(fwmark.protectedFromVpn);
+        }
+
+        // A forked child is another process, its sockets are left to fwmarkd
+        pid_t child = fork();
+        if (child == 0) {
+            _exit(CreateSocketMark(AF_INET).intValue == 0 ? CHILD_OK : CHILD_MARK_WRONG);
+        }
+        int32_t status = -1;
+        ASSERT_EQ(waitpid(child, &status, 0), child);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == CHILD_OK);
+
+        // Only the network is dropped, a protection from VPN set before stays
+        ASSERT_EQ(fwmarkClient->SelectProcessNetwork(0), NetManagerStandard::NETMANAGER_SUCCESS);
+        Fwmark fwmark = CreateSocketMark(AF_INET);
+        EXPECT_EQ(fwmark.netId, 0);
+        EXPECT_FALSE(fwmark.explicitlySelected);
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "cannot create a network namespace";
+    }
+}
+
+/**
+ * @tc.name: ProcessMarkTest002
+ * @tc.desc: Test a process protected from VPN gets marked sockets and is dropped from the map once it exits.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UnitTestFwmarkClient, ProcessMarkTest002, TestSize.Level1)
+{
+    if (!IsKernelMarkReady()) {
+        GTEST_SKIP() << "needs root, the process mark map and fwmarkd";
+    }
+    pid_t child = fork();
+    if (child == 0) {
+        if (FwmarkClient().ProtectProcessFromVpn() != NetManagerStandard::NETMANAGER_SUCCESS) {
+            _exit(CHILD_PROTECT_FAILED);
+        }
+        int32_t fd = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            _exit(CHILD_SOCKET_FAILED);
+        }
+        Fwmark fwmark = GetSocketMark(fd);
+        _exit(fwmark.protectedFromVpn && !fwmark.explicitlySelected ? CHILD_OK : CHILD_MARK_WRONG);
+    }
+    int32_t status = -1;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), CHILD_OK);
+    EXPECT_TRUE(WaitProcessMarkRemoved(child));
+}
+
+/**
+ * @tc.name: ConnectLatencyTest001
+ * @tc.desc: Compare loopback connects marked through fwmarkd with connects marked by the kernel.
+ * @tc.type: PERF
+ */
+HWTEST_F(UnitTestFwmarkClient, ConnectLatencyTest001, TestSize.Level1)
+{
+    if (!IsKernelMarkReady()) {
+        GTEST_SKIP() << "needs root, the process mark map and fwmarkd";
+    }
+    int64_t fwmarkdUs = -1;
+    int64_t kernelUs = -1;
+    bool isRun = NetManagerStandard::NetnsTestUtil::RunInNewNetns([this, &fwmarkdUs, &kernelUs]() {
+        ASSERT_TRUE(SetLoopbackUp());
+        int32_t listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrLen = sizeof(addr);
+        ASSERT_EQ(bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+        ASSERT_EQ(listen(listenFd, LISTEN_BACKLOG), 0);
+        ASSERT_EQ(getsockname(listenFd, reinterpret_cast<sockaddr *>(&addr), &addrLen), 0);
+
+        fwmarkdUs = MeasureConnect(listenFd, addr, true);
+        ASSERT_EQ(fwmarkClient->SelectProcessNetwork(NETID_FIRST), NetManagerStandard::NETMANAGER_SUCCESS);
+        kernelUs = MeasureConnect(listenFd, addr, false);
+        EXPECT_EQ(fwmarkClient->SelectProcessNetwork(0), NetManagerStandard::NETMANAGER_SUCCESS);
+        close(listenFd);
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "cannot create a network namespace";
+    }
+    ASSERT_GT(fwmarkdUs, 0);
+    ASSERT_GT(kernelUs, 0);
+    RecordProperty("fwmarkdConnectUs", std::to_string(fwmarkdUs / CONNECT_BENCH_ROUNDS));
+    RecordProperty("kernelConnectUs", std::to_string(kernelUs / CONNECT_BENCH_ROUNDS));
+    EXPECT_LT(kernelUs, fwmarkdUs);
+}
 } // namespace NetsysNative
 } // namespace OHOS
@@ -14,19 +14,135 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <gtest/gtest.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <set>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
 #ifdef GTEST_API_
 #define private public
 #define protected public
 #endif
+#include "common_netns_test_util.h"
+#include "interface_inventory.h"
 #include "interface_manager.h"
 #include "netsys_controller.h"
 #include "net_manager_constants.h"
+#include "securec.h"
 namespace OHOS {
 namespace nmd {
 namespace {
 using namespace testing::ext;
 using namespace OHOS::NetManagerStandard;
+constexpr const char *IP_CMD = "/system/bin/ip";
+constexpr size_t EVENT_BUFFER_SIZE = 64 * 1024;
+constexpr int32_t SETTLE_ATTEMPTS = 40;
+constexpr int32_t SETTLE_INTERVAL_MS = 50;
+
+bool RunIp(const std::string &args)
+{
+    return NetnsTestUtil::RunCmd(std::string(IP_CMD) + " " + args);
+}
+
+int32_t OpenEventSocket()
+{
+    int32_t sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    sockaddr_nl addr = {.nl_family = AF_NETLINK, .nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR};
+    if (sock >= 0 && bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+std::set<std::string> ToSet(const std::vector<InventoryAddress> &addrs)
+{
+    std::set<std::string> result;
+    for (const auto &addr : addrs) {
+        result.insert(addr.addr + "/" + std::to_string(addr.prefixLen) + " " + std::to_string(addr.flags) + " " +
+                      addr.label);
+    }
+    return result;
+}
+
+bool SameTable(const InterfaceInventory::Table &lhs, const InterfaceInventory::Table &rhs)
+{
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (const auto &[index, iface] : lhs) {
+        auto it = rhs.find(index);
+        if (it == rhs.end() || it->second.name != iface.name || it->second.flags != iface.flags ||
+            it->second.mtu != iface.mtu || it->second.hwAddr != iface.hwAddr ||
+            ToSet(it->second.ipv4Addrs) != ToSet(iface.ipv4Addrs) ||
+            ToSet(it->second.ipv6Addrs) != ToSet(iface.ipv6Addrs)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Apply the events until the table is the one a new dump gives, the kernel reports some link state late
+bool SettleInventory(int32_t sock, InterfaceInventory &inventory)
+{
+    std::vector<char> buf(EVENT_BUFFER_SIZE);
+    for (int32_t i = 0; i < SETTLE_ATTEMPTS; i++) {
+        ssize_t len = 0;
+        while ((len = recv(sock, buf.data(), buf.size(), 0)) > 0) {
+            inventory.Update(buf.data(), static_cast<int32_t>(len));
+        }
+        InterfaceInventory dumped;
+        auto table = inventory.GetSnapshot();
+        if (table != nullptr && dumped.Start() == 0 && SameTable(*table, *dumped.GetSnapshot())) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_INTERVAL_MS));
+    }
+    return false;
+}
+
+int32_t GetKernelMtu(const std::string &ifName)
+{
+    int32_t sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ifreq ifr = {};
+    bool ret = sock >= 0 && strncpy_s(ifr.ifr_name, IFNAMSIZ, ifName.c_str(), ifName.length()) == 0 &&
+        ioctl(sock, SIOCGIFMTU, &ifr) == 0;
+    if (sock >= 0) {
+        close(sock);
+    }
+    return ret ? ifr.ifr_mtu : -1;
+}
+
+// InterfaceManager asks the kernel itself as long as the inventory of netsys is stopped
+void ExpectSameAsKernel(const InterfaceInventory::Table &table)
+{
+    std::set<std::string> kernelNames;
+    struct if_nameindex *names = if_nameindex();
+    ASSERT_NE(names, nullptr);
+    for (struct if_nameindex *it = names; it->if_index != 0; it++) {
+        kernelNames.insert(it->if_name);
+    }
+    if_freenameindex(names);
+    std::set<std::string> inventoryNames;
+    for (const auto &[index, iface] : table) {
+        inventoryNames.insert(iface.name);
+        EXPECT_EQ(iface.mtu, GetKernelMtu(iface.name)) << iface.name;
+        InterfaceConfigurationParcel cached;
+        InterfaceManager::FillIfaceConfig(&iface, iface.name, cached);
+        InterfaceConfigurationParcel queried = InterfaceManager::GetIfaceConfig(iface.name);
+        EXPECT_EQ(cached.ipv4Addr, queried.ipv4Addr) << iface.name;
+        if (!queried.ipv4Addr.empty()) {
+            EXPECT_EQ(cached.prefixLength, queried.prefixLength) << iface.name;
+        }
+        EXPECT_EQ(cached.flags, queried.flags) << iface.name;
+        EXPECT_EQ(cached.hwAddr, queried.hwAddr) << iface.name;
+    }
+    EXPECT_EQ(inventoryNames, kernelNames);
+}
 } // namespace
 
 class InterfaceManagerTest : public testing::Test {
@@ -635,5 +751,96 @@ HWTEST_F(InterfaceManagerTest, AddVlanIp001, TestSize.Level1)
     EXPECT_TRUE(ret == NETMANAGER_ERR_OPERATION_FAILED || ret == NETMANAGER_SUCCESS);
 }
 
+HWTEST_F(InterfaceManagerTest, InterfaceInventoryTest001, TestSize.Level1)
+{
+    InterfaceInventory inventory;
+    EXPECT_EQ(inventory.GetSnapshot(), nullptr);
+    struct {
+        nlmsghdr hdr;
+        ifinfomsg info;
+    } msg = {};
+    msg.hdr.nlmsg_len = sizeof(msg);
+    msg.hdr.nlmsg_type = RTM_NEWLINK;
+    msg.info.ifi_index = 1;
+    inventory.Update(reinterpret_cast<const char *>(&msg), sizeof(msg));
+    EXPECT_EQ(inventory.GetSnapshot(), nullptr);
+    inventory.Update(nullptr, 0);
+    inventory.Stop();
+    EXPECT_EQ(inventory.GetSnapshot(), nullptr);
+}
+
+HWTEST_F(InterfaceManagerTest, InterfaceInventoryNetnsTest001, TestSize.Level1)
+{
+    if (access(IP_CMD, X_OK) != 0) {
+        GTEST_SKIP() << "needs the ip command";
+    }
+    InterfaceInventory::GetInstance().Stop();
+    bool isRun = NetnsTestUtil::RunInNewNetns([]() {
+        int32_t sock = OpenEventSocket();
+        ASSERT_GE(sock, 0);
+        InterfaceInventory inventory;
+        ASSERT_EQ(inventory.Start(), 0);
+        const std::vector<std::vector<std::string>> steps = {
+            {"link set lo up", "link add inv0 type veth peer name inv1"},
+            {"link set inv0 mtu 1400", "link set inv0 address 02:00:00:00:49:01"},
+            {"addr add 10.49.0.1/24 dev inv0", "addr add 10.49.0.2/24 dev inv0",
+             "-6 addr add fd00:49::1/64 dev inv0 nodad"},
+            {"link set inv0 up", "link set inv1 up"},
+            {"addr del 10.49.0.1/24 dev inv0", "addr add 10.49.1.1/16 dev inv1"},
+            {"link set inv1 down", "link set inv1 name inv2"},
+            {"link del inv0"},
+        };
+        for (const auto &step : steps) {
+            for (const auto &args : step) {
+                ASSERT_TRUE(RunIp(args)) << args;
+            }
+            auto table = inventory.GetSnapshot();
+            EXPECT_TRUE(SettleInventory(sock, inventory)) << step.front();
+            EXPECT_NE(table, inventory.GetSnapshot());
+            ExpectSameAsKernel(*inventory.GetSnapshot());
+        }
+        auto table = inventory.GetSnapshot();
+        EXPECT_EQ(InterfaceInventory::Find(*table, "inv0"), nullptr);
+        EXPECT_EQ(InterfaceInventory::Find(*table, "inv2"), nullptr);
+        ASSERT_NE(InterfaceInventory::Find(*table, "lo"), nullptr);
+        close(sock);
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "needs CAP_SYS_ADMIN";
+    }
+}
+
+HWTEST_F(InterfaceManagerTest, InterfaceInventoryRefreshTest001, TestSize.Level1)
+{
+    if (access(IP_CMD, X_OK) != 0) {
+        GTEST_SKIP() << "needs the ip command";
+    }
+    InterfaceInventory::GetInstance().Stop();
+    bool isRun = NetnsTestUtil::RunInNewNetns([]() {
+        ASSERT_TRUE(RunIp("link add inv0 type veth peer name inv1"));
+        // Nobody feeds the events to the inventory here, what the getters see comes from the setters
+        ASSERT_EQ(InterfaceInventory::GetInstance().Start(), 0);
+        EXPECT_EQ(InterfaceManager::SetMtu("inv0", "1400"), 0);
+        EXPECT_EQ(InterfaceManager::GetMtu("inv0"), 1400);
+        EXPECT_EQ(InterfaceManager::AddAddress("inv0", "10.49.0.1", 24), 0);
+        EXPECT_EQ(InterfaceManager::GetIfaceConfig("inv0").ipv4Addr, "10.49.0.1");
+        EXPECT_EQ(InterfaceManager::SetIffUp("inv0"), 0);
+        auto flags = InterfaceManager::GetIfaceConfig("inv0").flags;
+        EXPECT_NE(std::find(flags.begin(), flags.end(), "up"), flags.end());
+        EXPECT_EQ(InterfaceManager::DelAddress("inv0", "10.49.0.1", 24), 0);
+        EXPECT_TRUE(InterfaceManager::GetIfaceConfig("inv0").ipv4Addr.empty());
+        ASSERT_TRUE(RunIp("link del inv0"));
+        auto names = InterfaceManager::GetInterfaceNames();
+        // Removed behind the back of InterfaceManager, only the events would tell
+        EXPECT_NE(std::find(names.begin(), names.end(), "inv0"), names.end());
+        EXPECT_EQ(InterfaceInventory::GetInstance().Refresh("inv0"), 0);
+        names = InterfaceManager::GetInterfaceNames();
+        EXPECT_EQ(std::find(names.begin(), names.end(), "inv0"), names.end());
+        InterfaceInventory::GetInstance().Stop();
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "needs CAP_SYS_ADMIN";
+    }
+}
 } // namespace nmd
 } // namespace OHOS
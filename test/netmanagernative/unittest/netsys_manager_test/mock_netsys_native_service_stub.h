@@ -307,6 +307,12 @@ public:
         return 0;
     }
 
+    int32_t BandwidthUpdateUidLists(const std::vector<uint32_t> &deniedUids, const std::vector<uint32_t> &allowedUids,
+                                    const std::vector<uint32_t> &removedUids) override
+    {
+        return 0;
+    }
+
     int32_t BandwidthEnableDataSaver(bool enable) override
     {
         return 0;
@@ -13,19 +13,69 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
+#include <functional>
 #include <gtest/gtest.h>
+#include <linux/if_tun.h>
+#include <linux/mptcp.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
 #ifdef GTEST_API_
 #define private public
 #define protected public
 #endif
+#include "common_netns_test_util.h"
 #include "mptcp_manager.h"
+#include "mptcp_pm_client.h"
 #include "net_manager_constants.h"
+#include "securec.h"
 
 namespace OHOS {
 namespace nmd {
 namespace {
 using namespace testing::ext;
 using namespace OHOS::NetManagerStandard;
+constexpr const char *MPTCP_ENABLED_PATH = "/proc/sys/net/mptcp/enabled";
+constexpr const char *TUN_DEVICE_PATH = "/dev/net/tun";
+
+bool CanUseMptcpNetns()
+{
+    return getuid() == 0 && access(MPTCP_ENABLED_PATH, F_OK) == 0 && access(TUN_DEVICE_PATH, F_OK) == 0;
+}
+
+// Runs the check in a network namespace of its own, where tun devices stand for wlan0 and rmnet0
+bool RunInMptcpNetns(const std::function<void()> &check)
+{
+    return NetnsTestUtil::RunInNewNetns([&check]() {
+        std::vector<int32_t> tunFds;
+        for (const char *ifName : {"wlan0", "rmnet0"}) {
+            int32_t fd = open(TUN_DEVICE_PATH, O_RDWR | O_CLOEXEC);
+            ASSERT_GE(fd, 0);
+            tunFds.push_back(fd);
+            ifreq ifr = {};
+            ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+            ASSERT_EQ(strncpy_s(ifr.ifr_name, IFNAMSIZ, ifName, strlen(ifName)), 0);
+            ASSERT_EQ(ioctl(fd, TUNSETIFF, &ifr), 0);
+        }
+        check();
+        for (int32_t fd : tunFds) {
+            close(fd);
+        }
+    });
+}
+
+MptcpPmRequest MakeAddRequest(uint8_t id, const std::string &ipAddr, const char *ifName)
+{
+    MptcpPmRequest request;
+    request.op = MptcpPmRequest::ADD_ENDPOINT;
+    request.endpoint.id = id;
+    request.endpoint.ipAddr = ipAddr;
+    request.endpoint.ifIndex = static_cast<int32_t>(if_nametoindex(ifName));
+    request.endpoint.flags = MPTCP_PM_ADDR_FLAG_SUBFLOW;
+    return request;
+}
 } // namespace
 
 class MptcpManagerTest : public testing::Test {
@@ -75,149 +125,6 @@ HWTEST_F(MptcpManagerTest, IsMonitoredInterfaceTest002, TestSize.Level1)
     EXPECT_FALSE(manager->IsMonitoredInterface("lo"));
 }
 
-HWTEST_F(MptcpManagerTest, BuildEndpointAddCommandTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string ipAddr = "192.168.1.100";
-    std::string ifName = "wlan0";
-    std::string command = manager->BuildEndpointAddCommand(ipAddr, ifName);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("/system/bin/ip") != std::string::npos);
-    EXPECT_TRUE(command.find("mptcp endpoint add") != std::string::npos);
-    EXPECT_TRUE(command.find(ipAddr) != std::string::npos);
-    EXPECT_TRUE(command.find("dev") != std::string::npos);
-    EXPECT_TRUE(command.find(ifName) != std::string::npos);
-    EXPECT_TRUE(command.find("subflow") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointAddCommandTest002, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string ipAddr = "2001:db8::1";
-    std::string ifName = "rmnet0";
-    std::string command = manager->BuildEndpointAddCommand(ipAddr, ifName);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find(ipAddr) != std::string::npos);
-    EXPECT_TRUE(command.find(ifName) != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointAddCommandTest003, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string command = manager->BuildEndpointAddCommand("10.0.0.1", "rmnet1");
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("10.0.0.1") != std::string::npos);
-    EXPECT_TRUE(command.find("rmnet1") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointDeleteCommandTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t endpointId = 1;
-    std::string command = manager->BuildEndpointDeleteCommand(endpointId);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("/system/bin/ip") != std::string::npos);
-    EXPECT_TRUE(command.find("mptcp endpoint delete id") != std::string::npos);
-    EXPECT_TRUE(command.find("1") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointDeleteCommandTest002, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t endpointId = -1;
-    std::string command = manager->BuildEndpointDeleteCommand(endpointId);
-    EXPECT_TRUE(command.empty());
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointDeleteCommandTest003, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t endpointId = 100;
-    std::string command = manager->BuildEndpointDeleteCommand(endpointId);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("100") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointDeleteCommandTest004, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t endpointId = 0;
-    std::string command = manager->BuildEndpointDeleteCommand(endpointId);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("0") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildEndpointShowCommandTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string command = manager->BuildEndpointShowCommand();
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("/system/bin/ip") != std::string::npos);
-    EXPECT_TRUE(command.find("mptcp endpoint show") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildLimitsSetCommandTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t subflows = 3;
-    int32_t addAddrAccepted = 7;
-    std::string command = manager->BuildLimitsSetCommand(subflows, addAddrAccepted);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("/system/bin/ip") != std::string::npos);
-    EXPECT_TRUE(command.find("mptcp limits set") != std::string::npos);
-    EXPECT_TRUE(command.find("subflows 3") != std::string::npos);
-    EXPECT_TRUE(command.find("add_addr_accepted 7") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildLimitsSetCommandTest002, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t subflows = 0;
-    int32_t addAddrAccepted = 0;
-    std::string command = manager->BuildLimitsSetCommand(subflows, addAddrAccepted);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("subflows 0") != std::string::npos);
-    EXPECT_TRUE(command.find("add_addr_accepted 0") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, BuildLimitsSetCommandTest003, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t subflows = 7;
-    int32_t addAddrAccepted = 7;
-    std::string command = manager->BuildLimitsSetCommand(subflows, addAddrAccepted);
-    EXPECT_FALSE(command.empty());
-    EXPECT_TRUE(command.find("subflows 7") != std::string::npos);
-    EXPECT_TRUE(command.find("add_addr_accepted 7") != std::string::npos);
-}
-
-HWTEST_F(MptcpManagerTest, ExecuteMptcpCommandTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string command = "";
-    auto ret = manager->ExecuteMptcpCommand(command);
-    EXPECT_EQ(ret, NETMANAGER_ERR_INVALID_PARAMETER);
-}
-
-HWTEST_F(MptcpManagerTest, ExecuteMptcpCommandWithResultTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string command = "";
-    std::string result;
-    auto ret = manager->ExecuteMptcpCommand(command, result);
-    EXPECT_EQ(ret, NETMANAGER_ERR_INVALID_PARAMETER);
-    EXPECT_TRUE(result.empty());
-}
-
-HWTEST_F(MptcpManagerTest, ExecuteMptcpCommandTest002, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    std::string command = "invalid_command_for_test";
-    std::string result;
-    auto ret = manager->ExecuteMptcpCommand(command, result);
-    EXPECT_EQ(ret, NETMANAGER_SUCCESS);
-}
-
 HWTEST_F(MptcpManagerTest, AddEndpointTest001, TestSize.Level1)
 {
     auto manager = std::make_shared<MptcpManager>();
@@ -738,41 +645,6 @@ HWTEST_F(MptcpManagerTest, UpdateMptcpLimitsNoChangeTest001, TestSize.Level1)
     EXPECT_EQ(manager->currentAddAddrAccepted_, prevAddAddr);
 }
 
-HWTEST_F(MptcpManagerTest, GetEndpointIdTest001, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t id = manager->GetEndpointId("192.168.1.100", "wlan0");
-    EXPECT_GE(id, -1);
-}
-
-HWTEST_F(MptcpManagerTest, GetEndpointIdTest002, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t id = manager->GetEndpointId("", "wlan0");
-    EXPECT_GE(id, -1);
-}
-
-HWTEST_F(MptcpManagerTest, GetEndpointIdTest003, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t id = manager->GetEndpointId("192.168.1.100", "");
-    EXPECT_GE(id, -1);
-}
-
-HWTEST_F(MptcpManagerTest, GetEndpointIdTest004, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t id = manager->GetEndpointId("10.0.0.1", "rmnet0");
-    EXPECT_GE(id, -1);
-}
-
-HWTEST_F(MptcpManagerTest, GetEndpointIdTest005, TestSize.Level1)
-{
-    auto manager = std::make_shared<MptcpManager>();
-    int32_t id = manager->GetEndpointId("2001:db8::1", "rmnet1");
-    EXPECT_GE(id, -1);
-}
-
 HWTEST_F(MptcpManagerTest, MutexTest001, TestSize.Level1)
 {
     auto manager = std::make_shared<MptcpManager>();
@@ -896,5 +768,100 @@ HWTEST_F(MptcpManagerTest, RemoveAllAddressesFromInterfaceTest001, TestSize.Leve
     EXPECT_TRUE(manager->ifaceToIpAddrs_.find("wlan0") == manager->ifaceToIpAddrs_.end());
 }
 
+HWTEST_F(MptcpManagerTest, NetnsBatchTest001, TestSize.Level1)
+{
+    if (!CanUseMptcpNetns()) {
+        GTEST_SKIP() << "needs root, MPTCP and tun";
+    }
+    bool isRun = RunInMptcpNetns([]() {
+        MptcpManager manager;
+        EXPECT_TRUE(manager.QueueAddressChange("192.168.1.100", "wlan0", true));
+        EXPECT_FALSE(manager.QueueAddressChange("2001:db8::1", "wlan0", true));
+        EXPECT_FALSE(manager.QueueAddressChange("10.0.0.1", "rmnet0", true));
+        EXPECT_FALSE(manager.QueueAddressChange("10.0.0.2", "eth0", true));
+        // Added and removed in the same batch, the kernel never sees it
+        EXPECT_FALSE(manager.QueueAddressChange("10.0.0.3", "rmnet0", true));
+        EXPECT_FALSE(manager.QueueAddressChange("10.0.0.3", "rmnet0", false));
+        manager.FlushAddressChanges();
+        EXPECT_EQ(manager.endpoints_.size(), 3u);
+
+        MptcpPmClient client;
+        std::vector<MptcpPmEndpoint> endpoints;
+        ASSERT_EQ(client.GetEndpoints(endpoints), 0);
+        ASSERT_EQ(endpoints.size(), 3u);
+        for (const auto &endpoint : endpoints) {
+            char ifName[IF_NAMESIZE] = {0};
+            ASSERT_NE(if_indextoname(static_cast<uint32_t>(endpoint.ifIndex), ifName), nullptr);
+            auto it = manager.endpoints_.find(endpoint.ipAddr + "_" + ifName);
+            ASSERT_NE(it, manager.endpoints_.end());
+            EXPECT_EQ(it->second.endpointId, endpoint.id);
+            EXPECT_EQ(endpoint.flags, static_cast<uint32_t>(MPTCP_PM_ADDR_FLAG_SUBFLOW));
+        }
+        uint32_t subflows = 0;
+        uint32_t addAddrAccepted = 0;
+        ASSERT_EQ(client.GetLimits(subflows, addAddrAccepted), 0);
+        EXPECT_EQ(subflows, 7u);
+        EXPECT_EQ(addAddrAccepted, 7u);
+
+        EXPECT_TRUE(manager.QueueAddressChange("10.0.0.1", "rmnet0", false));
+        manager.FlushAddressChanges();
+        ASSERT_EQ(client.GetEndpoints(endpoints), 0);
+        EXPECT_EQ(endpoints.size(), 2u);
+        ASSERT_EQ(client.GetLimits(subflows, addAddrAccepted), 0);
+        EXPECT_EQ(subflows, 0u);
+        EXPECT_EQ(addAddrAccepted, 0u);
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "cannot create a network namespace";
+    }
+}
+
+HWTEST_F(MptcpManagerTest, NetnsSyncTest001, TestSize.Level1)
+{
+    if (!CanUseMptcpNetns()) {
+        GTEST_SKIP() << "needs root, MPTCP and tun";
+    }
+    bool isRun = RunInMptcpNetns([]() {
+        MptcpPmClient client;
+        std::vector<MptcpPmRequest> requests = {MakeAddRequest(1, "10.0.0.9", "rmnet0"),
+                                                MakeAddRequest(2, "192.168.1.100", "wlan0")};
+        ASSERT_EQ(client.ApplyBatch(requests), 0);
+        ASSERT_EQ(requests[0].error, 0);
+        ASSERT_EQ(requests[1].error, 0);
+
+        // The endpoint of an address already in the kernel is taken over, ids in use are skipped
+        MptcpManager manager;
+        manager.OnInterfaceAddressUpdated("192.168.1.100", "wlan0");
+        EXPECT_EQ(manager.endpoints_["192.168.1.100_wlan0"].endpointId, 2);
+        manager.OnInterfaceAddressUpdated("10.0.0.1", "rmnet0");
+        EXPECT_EQ(manager.endpoints_["10.0.0.1_rmnet0"].endpointId, 3);
+
+        // Changes made behind the back of netsys are found out when the kernel refuses a request
+        requests = {MakeAddRequest(4, "10.0.0.7", "rmnet0")};
+        ASSERT_EQ(client.ApplyBatch(requests), 0);
+        manager.OnInterfaceAddressUpdated("10.0.0.2", "rmnet0");
+        EXPECT_EQ(manager.endpoints_["10.0.0.2_rmnet0"].endpointId, 5);
+        requests = {MakeAddRequest(6, "10.0.0.3", "rmnet0")};
+        ASSERT_EQ(client.ApplyBatch(requests), 0);
+        manager.OnInterfaceAddressUpdated("10.0.0.3", "rmnet0");
+        EXPECT_EQ(manager.endpoints_["10.0.0.3_rmnet0"].endpointId, 6);
+
+        MptcpPmRequest request;
+        request.op = MptcpPmRequest::DELETE_ENDPOINT;
+        request.endpoint.id = 3;
+        requests = {request};
+        ASSERT_EQ(client.ApplyBatch(requests), 0);
+        manager.OnInterfaceAddressRemoved("10.0.0.1", "rmnet0");
+        EXPECT_TRUE(manager.endpoints_.find("10.0.0.1_rmnet0") == manager.endpoints_.end());
+
+        std::vector<MptcpPmEndpoint> endpoints;
+        ASSERT_EQ(client.GetEndpoints(endpoints), 0);
+        EXPECT_EQ(endpoints.size(), 5u);
+    });
+    if (!isRun) {
+        GTEST_SKIP() << "cannot create a network namespace";
+    }
+}
+
 } // namespace nmd
 } // namespace OHOS
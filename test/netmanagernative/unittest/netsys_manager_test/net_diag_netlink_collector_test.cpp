@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef GTEST_API_
+#define private public
+#endif
+
+#include "common_netns_test_util.h"
+#include "net_diag_netlink_collector.h"
+#include "net_manager_constants.h"
+#include "netsys_net_diag_data.h"
+#include "rtnetlink_link.h"
+
+namespace OHOS {
+namespace NetsysNative {
+using namespace testing::ext;
+using namespace OHOS::nmd;
+using namespace OHOS::NetManagerStandard::NetnsTestUtil;
+
+namespace {
+constexpr const char *LOOPBACK_IFACE = "lo";
+constexpr const char *LOOPBACK_IPV4 = "127.0.0.1";
+constexpr const char *DIAG_NETNS = "diagnl";
+constexpr const char *DIAG_IFACE = "vd0";
+constexpr const char *DIAG_MAC = "02:00:00:00:10:01";
+constexpr uint32_t DIAG_MTU = 1400;
+constexpr uint32_t DIAG_TX_QUEUE_LEN = 500;
+constexpr int32_t SCALE_SOCKET_NUM = 512;
+constexpr int64_t SCALE_DUMP_LIMIT_MS = 500;
+
+uint32_t GetSocketInode(int fd)
+{
+    struct stat st = {};
+    return fstat(fd, &st) == 0 ? static_cast<uint32_t>(st.st_ino) : 0;
+}
+
+uint16_t GetLocalPort(int fd)
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    return ntohs(addr.sin_port);
+}
+
+int OpenLoopbackSocket(int type)
+{
+    int fd = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+constexpr uint64_t DIAG_RX_BYTES = 1000;
+constexpr size_t LINK_MSG_BUFFER_SIZE = 512;
+
+void AddLinkAttr(nlmsghdr *hdr, uint16_t type, const void *data, size_t len)
+{
+    auto attr = reinterpret_cast<rtattr *>(reinterpret_cast<char *>(hdr) + NLMSG_ALIGN(hdr->nlmsg_len));
+    attr->rta_type = type;
+    attr->rta_len = RTA_LENGTH(len);
+    memcpy(RTA_DATA(attr), data, len);
+    hdr->nlmsg_len = NLMSG_ALIGN(hdr->nlmsg_len) + RTA_ALIGN(attr->rta_len);
+}
+} // namespace
+
+class NetDiagNetlinkCollectorTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+
+    static inline bool isDiagNetnsReady_ = false;
+};
+
+void NetDiagNetlinkCollectorTest::SetUpTestCase()
+{
+    if (getuid() != 0) {
+        return;
+    }
+    isDiagNetnsReady_ = AddNetns(DIAG_NETNS) &&
+        RunCmd("ip -n diagnl link add vd0 type veth peer name vd1") &&
+        RunCmd(std::string("ip -n diagnl link set vd0 address ") + DIAG_MAC + " mtu " + std::to_string(DIAG_MTU) +
+               " txqueuelen " + std::to_string(DIAG_TX_QUEUE_LEN)) &&
+        RunCmd("ip -n diagnl addr add 10.210.1.1/24 brd 10.210.1.255 dev vd0") &&
+        RunCmd("ip -n diagnl -6 addr add fd00:210::1/64 dev vd0 nodad") &&
+        RunCmd("ip -n diagnl link set vd0 up") && RunCmd("ip -n diagnl link set vd1 up") &&
+        RunCmd("ip -n diagnl route add 10.210.9.0/24 via 10.210.1.2 metric 7") &&
+        RunCmd("ip -n diagnl route add default via 10.210.1.2") &&
+        RunCmd("ip -n diagnl route add 10.210.8.8/32 dev vd0");
+}
+
+void NetDiagNetlinkCollectorTest::TearDownTestCase()
+{
+    if (isDiagNetnsReady_) {
+        DelNetns(DIAG_NETNS);
+    }
+}
+
+void NetDiagNetlinkCollectorTest::SetUp() {}
+
+void NetDiagNetlinkCollectorTest::TearDown() {}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetInterfaceConfigTest001, TestSize.Level1)
+{
+    NetDiagNetlinkCollector collector;
+    std::list<NetDiagIfaceConfig> configs;
+    EXPECT_EQ(collector.GetInterfaceConfig(configs, LOOPBACK_IFACE), NetManagerStandard::NETMANAGER_SUCCESS);
+    ASSERT_EQ(configs.size(), 1U);
+    const NetDiagIfaceConfig &config = configs.front();
+    EXPECT_EQ(config.ifaceName_, LOOPBACK_IFACE);
+    EXPECT_EQ(config.linkEncap_, "Local Loopback");
+    EXPECT_TRUE(config.macAddr_.empty());
+    EXPECT_EQ(config.ipv4Addr_, LOOPBACK_IPV4);
+    EXPECT_EQ(config.ipv4Mask_, "255.0.0.0");
+    EXPECT_TRUE(config.isUp_);
+    EXPECT_GT(config.mtu_, 0U);
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetInterfaceConfigTest002, TestSize.Level1)
+{
+    if (!isDiagNetnsReady_) {
+        GTEST_SKIP() << "needs root and the diagnl namespace";
+    }
+    std::list<NetDiagIfaceConfig> configs;
+    int32_t ret = NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+    EXPECT_TRUE(RunInNetns(DIAG_NETNS, [&configs, &ret]() {
+        NetDiagNetlinkCollector collector;
+        ret = collector.GetInterfaceConfig(configs, "");
+    }));
+    EXPECT_EQ(ret, NetManagerStandard::NETMANAGER_SUCCESS);
+    auto iter = std::find_if(configs.begin(), configs.end(),
+                             [](const NetDiagIfaceConfig &config) { return config.ifaceName_ == DIAG_IFACE; });
+    ASSERT_NE(iter, configs.end());
+    EXPECT_EQ(configs.size(), 3U);
+    EXPECT_EQ(iter->linkEncap_, "Ethernet");
+    EXPECT_EQ(iter->macAddr_, DIAG_MAC);
+    EXPECT_EQ(iter->ipv4Addr_, "10.210.1.1");
+    EXPECT_EQ(iter->ipv4Bcast_, "10.210.1.255");
+    EXPECT_EQ(iter->ipv4Mask_, "255.255.255.0");
+    EXPECT_EQ(iter->mtu_, DIAG_MTU);
+    EXPECT_EQ(iter->txQueueLen_, DIAG_TX_QUEUE_LEN);
+    EXPECT_TRUE(iter->isUp_);
+    auto ipv6Iter = std::find(iter->ipv6Addrs_.begin(), iter->ipv6Addrs_.end(),
+                              std::make_pair(std::string("fd00:210::1/64"), std::string("Global")));
+    EXPECT_NE(ipv6Iter, iter->ipv6Addrs_.end());
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetInterfaceConfigTest003, TestSize.Level1)
+{
+    NetDiagNetlinkCollector collector;
+    std::list<NetDiagIfaceConfig> configs;
+    EXPECT_EQ(collector.GetInterfaceConfig(configs, "nonexistent0"), NetManagerStandard::NETMANAGER_SUCCESS);
+    EXPECT_TRUE(configs.empty());
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetRouteTableTest001, TestSize.Level1)
+{
+    if (!isDiagNetnsReady_) {
+        GTEST_SKIP() << "needs root and the diagnl namespace";
+    }
+    std::list<NetDiagRouteTable> routeTables;
+    int32_t ret = NetManagerStandard::NETMANAGER_ERR_INTERNAL;
+    EXPECT_TRUE(RunInNetns(DIAG_NETNS, [&routeTables, &ret]() {
+        NetDiagNetlinkCollector collector;
+        ret = collector.GetRouteTable(routeTables);
+    }));
+    EXPECT_EQ(ret, NetManagerStandard::NETMANAGER_SUCCESS);
+    ASSERT_EQ(routeTables.size(), 4U);
+    auto findRoute = [&routeTables](const std::string &destination) {
+        return std::find_if(routeTables.begin(), routeTables.end(),
+                            [&destination](const NetDiagRouteTable &route) { return route.destination_ == destination; });
+    };
+    auto defaultRoute = findRoute("default");
+    ASSERT_NE(defaultRoute, routeTables.end());
+    EXPECT_EQ(defaultRoute->gateway_, "10.210.1.2");
+    EXPECT_EQ(defaultRoute->mask_, "0.0.0.0");
+    EXPECT_EQ(defaultRoute->flags_, "UG");
+    EXPECT_EQ(defaultRoute->iface_, DIAG_IFACE);
+    auto gatewayRoute = findRoute("10.210.9.0");
+    ASSERT_NE(gatewayRoute, routeTables.end());
+    EXPECT_EQ(gatewayRoute->mask_, "255.255.255.0");
+    EXPECT_EQ(gatewayRoute->metric_, 7U);
+    auto linkRoute = findRoute("10.210.1.0");
+    ASSERT_NE(linkRoute, routeTables.end());
+    EXPECT_EQ(linkRoute->gateway_, "*");
+    EXPECT_EQ(linkRoute->flags_, "U");
+    auto hostRoute = findRoute("10.210.8.8");
+    ASSERT_NE(hostRoute, routeTables.end());
+    EXPECT_EQ(hostRoute->mask_, "255.255.255.255");
+    EXPECT_EQ(hostRoute->flags_, "UH");
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetSocketsInfoTcpTest001, TestSize.Level1)
+{
+    int fd = OpenLoopbackSocket(SOCK_STREAM);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(listen(fd, 1), 0);
+    std::string localAddr = std::string(LOOPBACK_IPV4) + ":" + std::to_string(GetLocalPort(fd));
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo socketsInfo;
+    EXPECT_EQ(collector.GetSocketsInfo(PROTOCOL_TYPE_TCP, socketsInfo), NetManagerStandard::NETMANAGER_SUCCESS);
+    auto &sockets = socketsInfo.netProtoSocketsInfo_;
+    auto iter = std::find_if(sockets.begin(), sockets.end(), [&localAddr](const NeyDiagNetProtoSocketInfo &info) {
+        return info.localAddr_ == localAddr;
+    });
+    ASSERT_NE(iter, sockets.end());
+    EXPECT_EQ(iter->protocol_, "tcp");
+    EXPECT_EQ(iter->state_, "LISTEN");
+    EXPECT_EQ(iter->foreignAddr_, "0.0.0.0:*");
+    EXPECT_EQ(iter->inode_, GetSocketInode(fd));
+    EXPECT_EQ(iter->programName_.find(std::to_string(getpid()) + "/"), 0U);
+    EXPECT_TRUE(socketsInfo.unixSocketsInfo_.empty());
+    close(fd);
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetSocketsInfoUdpTest001, TestSize.Level1)
+{
+    int fd = OpenLoopbackSocket(SOCK_DGRAM);
+    ASSERT_GE(fd, 0);
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo socketsInfo;
+    EXPECT_EQ(collector.GetSocketsInfo(PROTOCOL_TYPE_UDP, socketsInfo), NetManagerStandard::NETMANAGER_SUCCESS);
+    uint32_t inode = GetSocketInode(fd);
+    auto &sockets = socketsInfo.netProtoSocketsInfo_;
+    auto iter = std::find_if(sockets.begin(), sockets.end(),
+                             [inode](const NeyDiagNetProtoSocketInfo &info) { return info.inode_ == inode; });
+    ASSERT_NE(iter, sockets.end());
+    EXPECT_EQ(iter->protocol_, "udp");
+    EXPECT_EQ(iter->localAddr_, std::string(LOOPBACK_IPV4) + ":" + std::to_string(GetLocalPort(fd)));
+    EXPECT_TRUE(iter->state_.empty());
+    close(fd);
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetSocketsInfoUnixTest001, TestSize.Level1)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(fd, 0);
+    std::string name = "netdiag_collector_test_" + std::to_string(getpid());
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    // abstract address, the leading byte stays NUL
+    memcpy(addr.sun_path + 1, name.c_str(), name.size());
+    socklen_t len = offsetof(sockaddr_un, sun_path) + 1 + name.size();
+    ASSERT_EQ(bind(fd, reinterpret_cast<sockaddr *>(&addr), len), 0);
+    ASSERT_EQ(listen(fd, 1), 0);
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo socketsInfo;
+    EXPECT_EQ(collector.GetSocketsInfo(PROTOCOL_TYPE_UNIX, socketsInfo), NetManagerStandard::NETMANAGER_SUCCESS);
+    EXPECT_TRUE(socketsInfo.netProtoSocketsInfo_.empty());
+    auto &sockets = socketsInfo.unixSocketsInfo_;
+    auto iter = std::find_if(sockets.begin(), sockets.end(),
+                             [&name](const NetDiagUnixSocketInfo &info) { return info.path_ == "@" + name; });
+    ASSERT_NE(iter, sockets.end());
+    EXPECT_EQ(iter->protocol_, "unix");
+    EXPECT_EQ(iter->type_, "STREAM");
+    EXPECT_EQ(iter->state_, "LISTENING");
+    EXPECT_EQ(iter->flags_, "ACC");
+    EXPECT_EQ(iter->inode_, GetSocketInode(fd));
+    close(fd);
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetSocketsInfoAllTest001, TestSize.Level1)
+{
+    int tcpFd = OpenLoopbackSocket(SOCK_STREAM);
+    ASSERT_GE(tcpFd, 0);
+    ASSERT_EQ(listen(tcpFd, 1), 0);
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo socketsInfo;
+    EXPECT_EQ(collector.GetSocketsInfo(PROTOCOL_TYPE_ALL, socketsInfo), NetManagerStandard::NETMANAGER_SUCCESS);
+    uint32_t inode = GetSocketInode(tcpFd);
+    auto &sockets = socketsInfo.netProtoSocketsInfo_;
+    auto iter = std::find_if(sockets.begin(), sockets.end(),
+                             [inode](const NeyDiagNetProtoSocketInfo &info) { return info.inode_ == inode; });
+    ASSERT_NE(iter, sockets.end());
+    // netstat -a does not print the owning program
+    EXPECT_TRUE(iter->programName_.empty());
+    close(tcpFd);
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetSocketsInfoScaleTest001, TestSize.Level1)
+{
+    std::vector<int> fds;
+    for (int32_t i = 0; i < SCALE_SOCKET_NUM; ++i) {
+        int fd = OpenLoopbackSocket(SOCK_DGRAM);
+        if (fd < 0) {
+            break;
+        }
+        fds.push_back(fd);
+    }
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo socketsInfo;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(collector.GetSocketsInfo(PROTOCOL_TYPE_UDP, socketsInfo), NetManagerStandard::NETMANAGER_SUCCESS);
+    int64_t elapsedMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    int32_t foundNum = 0;
+    for (int fd : fds) {
+        uint32_t inode = GetSocketInode(fd);
+        auto &sockets = socketsInfo.netProtoSocketsInfo_;
+        foundNum += std::any_of(sockets.begin(), sockets.end(),
+                                [inode](const NeyDiagNetProtoSocketInfo &info) { return info.inode_ == inode; });
+        close(fd);
+    }
+    EXPECT_EQ(foundNum, static_cast<int32_t>(fds.size()));
+    EXPECT_LT(elapsedMs, SCALE_DUMP_LIMIT_MS);
+}
+
+HWTEST_F(NetDiagNetlinkCollectorTest, GetSocketsInfoInvalidTest001, TestSize.Level1)
+{
+    NetDiagNetlinkCollector collector;
+    NetDiagSocketsInfo socketsInfo;
+    EXPECT_EQ(collector.GetSocketsInfo(static_cast<NetDiagProtocolType>(0xff), socketsInfo),
+              NetManagerStandard::NETMANAGER_ERR_INTERNAL);
+}
+HWTEST_F(NetDiagNetlinkCollectorTest, ParseRtnetlinkLinkTest001, TestSize.Level1)
+{
+    alignas(nlmsghdr) char buffer[LINK_MSG_BUFFER_SIZE] = {0};
+    auto hdr = reinterpret_cast<nlmsghdr *>(buffer);
+    hdr->nlmsg_type = RTM_NEWLINK;
+    hdr->nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    auto info = reinterpret_cast<ifinfomsg *>(NLMSG_DATA(hdr));
+    info->ifi_index = 1;
+    info->ifi_flags = IFF_UP;
+    AddLinkAttr(hdr, IFLA_IFNAME, DIAG_IFACE, strlen(DIAG_IFACE) + 1);
+    AddLinkAttr(hdr, IFLA_MTU, &DIAG_MTU, sizeof(DIAG_MTU));
+    uint8_t mac[] = {0x02, 0x00, 0x00, 0x00, 0x10, 0x01};
+    AddLinkAttr(hdr, IFLA_ADDRESS, mac, sizeof(mac));
+    // An older kernel sends only the counters it knows of
+    rtnl_link_stats64 stats = {};
+    stats.rx_bytes = DIAG_RX_BYTES;
+    AddLinkAttr(hdr, IFLA_STATS64, &stats, offsetof(rtnl_link_stats64, tx_bytes));
+
+    RtnetlinkLink link;
+    ASSERT_TRUE(ParseRtnetlinkLink(hdr, link));
+    EXPECT_EQ(link.index, 1);
+    EXPECT_EQ(link.name, DIAG_IFACE);
+    EXPECT_EQ(link.mtu, static_cast<int32_t>(DIAG_MTU));
+    EXPECT_EQ(HwAddrToString(link.hwAddr), DIAG_MAC);
+    EXPECT_EQ(link.stats.rx_bytes, DIAG_RX_BYTES);
+    EXPECT_EQ(link.stats.tx_bytes, 0U);
+
+    hdr->nlmsg_type = RTM_NEWADDR;
+    EXPECT_FALSE(ParseRtnetlinkLink(hdr, link));
+    EXPECT_EQ(HwAddrToString({}), "00:00:00:00:00:00");
+}
+} // namespace NetsysNative
+} // namespace OHOS
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#ifdef GTEST_API_
+#define private public
+#endif
+
+#include "common_netns_test_util.h"
+#include "net_diag_ping_engine.h"
+#include "net_manager_constants.h"
+#include "netsys_net_diag_data.h"
+
+namespace OHOS {
+namespace NetsysNative {
+using namespace testing::ext;
+using namespace OHOS::nmd;
+using namespace OHOS::NetManagerStandard::NetnsTestUtil;
+
+namespace {
+constexpr const char *LOOPBACK_IPV4 = "127.0.0.1";
+constexpr const char *LOOPBACK_IPV6 = "::1";
+constexpr const char *SILENT_IPV4 = "198.18.0.2";
+constexpr const char *DGRAM_NETNS = "pingdgram";
+constexpr uint16_t PING_COUNT = 3;
+constexpr uint32_t PING_INTERVAL_MS = 100;
+constexpr uint16_t PING_DATASIZE = 256;
+constexpr uint16_t DEFAULT_ICMP_BYTES = 64;
+constexpr uint16_t DEFAULT_PAYLOAD_SIZE = 84;
+constexpr uint16_t PING_TIMEOUT_SEC = 1;
+constexpr int64_t TIMEOUT_LIMIT_MS = 2500;
+constexpr uint16_t ICMP_HEADER_LEN = 8;
+
+NetDiagPingOption MakeLoopbackOption(const std::string &destination)
+{
+    NetDiagPingOption pingOption;
+    pingOption.destination_ = destination;
+    pingOption.count_ = PING_COUNT;
+    pingOption.interval_ = PING_INTERVAL_MS;
+    return pingOption;
+}
+} // namespace
+
+class NetDiagPingEngineTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+
+    static inline bool isDgramNetnsReady_ = false;
+};
+
+void NetDiagPingEngineTest::SetUpTestCase()
+{
+    if (getuid() != 0) {
+        return;
+    }
+    // A namespace whose ping group range admits every gid, so the datagram socket path is taken.
+    // The peer of its veth link has no address and stands in for a silent host.
+    isDgramNetnsReady_ = AddNetns(DGRAM_NETNS) &&
+        RunCmd("ip netns exec pingdgram sysctl -qw net.ipv4.ping_group_range=\"0 2147483647\"") &&
+        RunCmd("ip -n pingdgram link add vp0 type veth peer name vp1") &&
+        RunCmd("ip -n pingdgram addr add 198.18.0.1/24 dev vp0") && RunCmd("ip -n pingdgram link set vp0 up") &&
+        RunCmd("ip -n pingdgram link set vp1 up");
+}
+
+void NetDiagPingEngineTest::TearDownTestCase()
+{
+    if (isDgramNetnsReady_) {
+        DelNetns(DGRAM_NETNS);
+    }
+}
+
+void NetDiagPingEngineTest::SetUp() {}
+
+void NetDiagPingEngineTest::TearDown() {}
+
+HWTEST_F(NetDiagPingEngineTest, PingLoopbackTest001, TestSize.Level1)
+{
+    NetDiagPingResult pingResult;
+    NetDiagPingEngine engine(MakeLoopbackOption(LOOPBACK_IPV4));
+    int32_t ret = engine.Run(pingResult);
+    if (ret == NetManagerStandard::NETMANAGER_ERR_INTERNAL) {
+        GTEST_SKIP() << "neither datagram nor raw ICMP sockets are permitted";
+    }
+    EXPECT_EQ(ret, NetManagerStandard::NETMANAGER_SUCCESS);
+    EXPECT_EQ(pingResult.host_, LOOPBACK_IPV4);
+    EXPECT_EQ(pingResult.ipAddr_, LOOPBACK_IPV4);
+    EXPECT_EQ(pingResult.dateSize_, 56);
+    EXPECT_EQ(pingResult.payloadSize_, DEFAULT_PAYLOAD_SIZE);
+    EXPECT_EQ(pingResult.transCount_, PING_COUNT);
+    EXPECT_EQ(pingResult.recvCount_, PING_COUNT);
+    ASSERT_EQ(pingResult.icmpRespList_.size(), PING_COUNT);
+    uint16_t expectSeq = 1;
+    for (const auto &icmpRespInfo : pingResult.icmpRespList_) {
+        EXPECT_EQ(icmpRespInfo.icmpSeq_, expectSeq++);
+        EXPECT_EQ(icmpRespInfo.from_, LOOPBACK_IPV4);
+        EXPECT_EQ(icmpRespInfo.bytes_, DEFAULT_ICMP_BYTES);
+        EXPECT_GT(icmpRespInfo.ttl_, 0);
+        EXPECT_LT(icmpRespInfo.costTime_, PING_INTERVAL_MS);
+    }
+}
+
+HWTEST_F(NetDiagPingEngineTest, PingLoopbackIpv6Test001, TestSize.Level1)
+{
+    NetDiagPingOption pingOption = MakeLoopbackOption(LOOPBACK_IPV6);
+    pingOption.forceType_ = FORCE_TYPE_IPV6;
+    pingOption.dataSize_ = PING_DATASIZE;
+    NetDiagPingResult pingResult;
+    NetDiagPingEngine engine(pingOption);
+    if (engine.Run(pingResult) != NetManagerStandard::NETMANAGER_SUCCESS || pingResult.ipAddr_.empty()) {
+        GTEST_SKIP() << "cannot ping the IPv6 loopback";
+    }
+    EXPECT_EQ(pingResult.ipAddr_, LOOPBACK_IPV6);
+    EXPECT_EQ(pingResult.transCount_, PING_COUNT);
+    EXPECT_EQ(pingResult.recvCount_, PING_COUNT);
+    for (const auto &icmpRespInfo : pingResult.icmpRespList_) {
+        EXPECT_EQ(icmpRespInfo.from_, LOOPBACK_IPV6);
+        EXPECT_EQ(icmpRespInfo.bytes_, PING_DATASIZE + ICMP_HEADER_LEN);
+    }
+}
+
+HWTEST_F(NetDiagPingEngineTest, PingDatagramSocketTest001, TestSize.Level1)
+{
+    if (!isDgramNetnsReady_) {
+        GTEST_SKIP() << "needs root and the pingdgram namespace";
+    }
+    NetDiagPingResult pingResult;
+    bool isRawSocket = true;
+    EXPECT_TRUE(RunInNetns(DGRAM_NETNS, [&pingResult, &isRawSocket]() {
+        NetDiagPingEngine engine(MakeLoopbackOption(LOOPBACK_IPV4));
+        engine.Run(pingResult);
+        isRawSocket = engine.isRawSocket_;
+    }));
+    EXPECT_FALSE(isRawSocket);
+    EXPECT_EQ(pingResult.transCount_, PING_COUNT);
+    EXPECT_EQ(pingResult.recvCount_, PING_COUNT);
+}
+
+HWTEST_F(NetDiagPingEngineTest, PingTimeoutTest001, TestSize.Level1)
+{
+    if (!isDgramNetnsReady_) {
+        GTEST_SKIP() << "needs root and the pingdgram namespace";
+    }
+    NetDiagPingOption pingOption;
+    pingOption.destination_ = SILENT_IPV4;
+    pingOption.count_ = 1;
+    pingOption.timeOut_ = PING_TIMEOUT_SEC;
+    NetDiagPingResult pingResult;
+    int64_t elapsedMs = 0;
+    EXPECT_TRUE(RunInNetns(DGRAM_NETNS, [&pingOption, &pingResult, &elapsedMs]() {
+        NetDiagPingEngine engine(pingOption);
+        auto start = std::chrono::steady_clock::now();
+        engine.Run(pingResult);
+        elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }));
+    EXPECT_EQ(pingResult.transCount_, 1);
+    EXPECT_EQ(pingResult.recvCount_, 0);
+    EXPECT_TRUE(pingResult.icmpRespList_.empty());
+    EXPECT_LT(elapsedMs, TIMEOUT_LIMIT_MS);
+}
+
+HWTEST_F(NetDiagPingEngineTest, PingUnresolvedTest001, TestSize.Level1)
+{
+    NetDiagPingOption pingOption;
+    pingOption.destination_ = "name.does.not.resolve.invalid";
+    NetDiagPingResult pingResult;
+    NetDiagPingEngine engine(pingOption);
+    EXPECT_EQ(engine.Run(pingResult), NetManagerStandard::NETMANAGER_SUCCESS);
+    EXPECT_TRUE(pingResult.host_.empty());
+    EXPECT_EQ(pingResult.transCount_, 0);
+}
+} // namespace NetsysNative
+} // namespace OHOS
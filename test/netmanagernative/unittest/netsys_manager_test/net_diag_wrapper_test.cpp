@@ -13,8 +13,11 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <functional>
 #include <gtest/gtest.h>
 #include <thread>
+#include <unistd.h>
 
 #ifdef GTEST_API_
 #define private public
@@ -23,6 +26,8 @@
 
 #include "common_net_diag_callback_test.h"
 #include "net_diag_callback_stub.h"
+#include "net_diag_netlink_collector.h"
+#include "net_diag_ping_engine.h"
 #include "net_diag_wrapper.h"
 #include "net_manager_constants.h"
 #include "netnative_log_wrapper.h"
@@ -53,6 +58,21 @@ const std::string TEST_STRING_VALUE = "test";
 const uint16_t TEST_UINT16_VALUE = 1;
 const uint32_t TEST_UINT32_VALUE = 2;
 const uint32_t PING_TIMEOUT_EXIT = 10;
+const std::string PING_BINARY_PATH = "/system/bin/ping";
+const uint16_t PING_COMPARE_COUNT = 3;
+const std::string NETSTAT_BINARY_PATH = "/system/bin/netstat";
+const std::string IFCONFIG_BINARY_PATH = "/system/bin/ifconfig";
+
+class PingResultCaptureCallback : public NetDiagCallbackStubTest {
+public:
+    int32_t OnNotifyPingResult(const NetsysNative::NetDiagPingResult &pingResult) override
+    {
+        pingResult_ = pingResult;
+        return NetManagerStandard::NETMANAGER_SUCCESS;
+    }
+
+    NetsysNative::NetDiagPingResult pingResult_;
+};
 
 class NetDiagWrapperTest : public testing::Test {
 public:
@@ -576,6 +596,83 @@ HWTEST_F(NetDiagWrapperTest, GeneratePingCommandTest001, TestSize.Level1)
     EXPECT_EQ(ret, NetManagerStandard::NETMANAGER_SUCCESS);
 }
 
+HWTEST_F(NetDiagWrapperTest, PingEngineCompareWithParserTest001, TestSize.Level1)
+{
+    NETNATIVE_LOGI("NetDiagWrapperTest  PingEngineCompareWithParserTest001 enter");
+    if (access(PING_BINARY_PATH.c_str(), X_OK) != 0) {
+        return;
+    }
+    auto netDiagWrapper = NetDiagWrapper::GetInstance();
+    NetDiagPingOption pingOption;
+    pingOption.destination_ = PING_DESTINATION_IP1;
+    pingOption.count_ = PING_COMPARE_COUNT;
+
+    NetDiagPingResult engineResult;
+    NetDiagPingEngine engine(pingOption);
+    if (engine.Run(engineResult) != NetManagerStandard::NETMANAGER_SUCCESS) {
+        return;
+    }
+
+    std::string command;
+    std::string result;
+    ASSERT_EQ(netDiagWrapper->GeneratePingCommand(pingOption, command), NetManagerStandard::NETMANAGER_SUCCESS);
+    ASSERT_EQ(netDiagWrapper->ExecuteCommandForResult(command, result), NetManagerStandard::NETMANAGER_SUCCESS);
+    sptr<PingResultCaptureCallback> callback = new PingResultCaptureCallback();
+    netDiagWrapper->ExtractPingResult(result, callback);
+    const NetDiagPingResult &parserResult = callback->pingResult_;
+
+    EXPECT_EQ(engineResult.host_, parserResult.host_);
+    EXPECT_EQ(engineResult.ipAddr_, parserResult.ipAddr_);
+    EXPECT_EQ(engineResult.dateSize_, parserResult.dateSize_);
+    EXPECT_EQ(engineResult.payloadSize_, parserResult.payloadSize_);
+    EXPECT_EQ(engineResult.transCount_, parserResult.transCount_);
+    EXPECT_EQ(engineResult.recvCount_, parserResult.recvCount_);
+    ASSERT_EQ(engineResult.icmpRespList_.size(), parserResult.icmpRespList_.size());
+    auto parserIt = parserResult.icmpRespList_.begin();
+    for (const auto &engineResp : engineResult.icmpRespList_) {
+        EXPECT_EQ(engineResp.bytes_, parserIt->bytes_);
+        EXPECT_EQ(engineResp.from_, parserIt->from_);
+        EXPECT_EQ(engineResp.ttl_, parserIt->ttl_);
+        ++parserIt;
+    }
+}
+
+HWTEST_F(NetDiagWrapperTest, NetlinkCollectorLatencyCompareTest001, TestSize.Level1)
+{
+    NETNATIVE_LOGI("NetDiagWrapperTest  NetlinkCollectorLatencyCompareTest001 enter");
+    if (access(NETSTAT_BINARY_PATH.c_str(), X_OK) != 0 || access(IFCONFIG_BINARY_PATH.c_str(), X_OK) != 0) {
+        return;
+    }
+    auto netDiagWrapper = NetDiagWrapper::GetInstance();
+    auto elapsedUs = [](const std::function<void()> &task) {
+        auto start = std::chrono::steady_clock::now();
+        task();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+            .count();
+    };
+
+    NetDiagSocketsInfo socketsInfo;
+    std::list<NetDiagIfaceConfig> configs;
+    auto netlinkUs = elapsedUs([&socketsInfo, &configs]() {
+        NetDiagNetlinkCollector collector;
+        EXPECT_EQ(collector.GetSocketsInfo(PROTOCOL_TYPE_ALL, socketsInfo), NetManagerStandard::NETMANAGER_SUCCESS);
+        EXPECT_EQ(collector.GetInterfaceConfig(configs, ""), NetManagerStandard::NETMANAGER_SUCCESS);
+    });
+    std::string netstatResult;
+    std::string ifconfigResult;
+    auto commandUs = elapsedUs([&netDiagWrapper, &netstatResult, &ifconfigResult]() {
+        netDiagWrapper->ExecuteCommandForResult(NETSTAT_BINARY_PATH + " -ae", netstatResult);
+        netDiagWrapper->ExecuteCommandForResult(IFCONFIG_BINARY_PATH + " -a", ifconfigResult);
+    });
+    NETNATIVE_LOGI("netlink collector %{public}lld us, netstat and ifconfig %{public}lld us",
+                   static_cast<long long>(netlinkUs), static_cast<long long>(commandUs));
+    for (const auto &config : configs) {
+        EXPECT_NE(ifconfigResult.find(config.ifaceName_), std::string::npos);
+    }
+    EXPECT_FALSE(socketsInfo.unixSocketsInfo_.empty());
+    EXPECT_LT(netlinkUs, commandUs);
+}
+
 HWTEST_F(NetDiagWrapperTest, ExtractPingResultTest001, TestSize.Level1)
 {
     NETNATIVE_LOGI("NetDiagWrapperTest  ExtractPingResultTest001 enter");
@@ -14,6 +14,7 @@
  */
 
 #include <gtest/gtest.h>
+#include <linux/pkt_sched.h>
 
 #include "netlink_msg.h"
 #include "netnative_log_wrapper.h"
@@ -117,6 +118,25 @@ HWTEST_F(NetlinkMsgTest, AddLinkTest001, TestSize.Level1)
     EXPECT_EQ(ret, -1);
 }
 
+HWTEST_F(NetlinkMsgTest, AddTrafficControlTest001, TestSize.Level1)
+{
+    NetlinkMsg netLinkMsg(NLM_F_CREATE, NETLINK_MAX_LEN, 0);
+    struct tcmsg tcm = {};
+    tcm.tcm_family = AF_UNSPEC;
+    tcm.tcm_ifindex = 1;
+    tcm.tcm_parent = TC_H_CLSACT;
+    netLinkMsg.AddTrafficControl(RTM_NEWQDISC, tcm);
+    char kind[] = "clsact";
+    EXPECT_EQ(netLinkMsg.AddAttr(TCA_KIND, kind, sizeof(kind)), 0);
+
+    struct nlmsghdr *msg = netLinkMsg.GetNetLinkMessage();
+    EXPECT_EQ(msg->nlmsg_type, RTM_NEWQDISC);
+    EXPECT_EQ(msg->nlmsg_len, NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct tcmsg))) + RTA_SPACE(sizeof(kind)));
+    auto added = reinterpret_cast<struct tcmsg *>(NLMSG_DATA(msg));
+    EXPECT_EQ(added->tcm_ifindex, 1);
+    EXPECT_EQ(added->tcm_parent, TC_H_CLSACT);
+}
+
 #ifdef FEATURE_NET_FIREWALL_ENABLE
 HWTEST_F(NetlinkMsgTest, InitNflogConfigTest001, TestSize.Level1)
 {
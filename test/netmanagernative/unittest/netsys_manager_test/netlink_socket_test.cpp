@@ -14,6 +14,8 @@
  */
 
 #include <gtest/gtest.h>
+#include <net/if.h>
+#include <sys/time.h>
 
 #ifdef GTEST_API_
 #define private public
@@ -291,5 +293,46 @@ HWTEST_F(NetlinkSocketTest, SendNetlinkMsgsToKernelTest002, TestSize.Level1)
     auto ret = SendNetlinkMsgsToKernel(msgs);
     EXPECT_EQ(ret, 28);
 }
+
+HWTEST_F(NetlinkSocketTest, SendNetlinkMsgsAndWaitAcksTest001, TestSize.Level1)
+{
+    int32_t sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    ASSERT_GE(sock, 0);
+    timeval timeout = {.tv_sec = 3};
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::vector<NetlinkMsg> msgs;
+    for (uint32_t ifIndex : {if_nametoindex("lo"), static_cast<uint32_t>(INT32_MAX)}) {
+        NetlinkMsg msg(0, NETLINK_MAX_LEN, 0);
+        ifinfomsg ifm = {};
+        ifm.ifi_family = AF_UNSPEC;
+        ifm.ifi_index = static_cast<int32_t>(ifIndex);
+        msg.AddLink(RTM_GETLINK, ifm);
+        msgs.push_back(std::move(msg));
+    }
+    uint32_t seq = 100;
+    std::vector<int32_t> errors;
+    std::vector<uint32_t> replySeqs;
+    int32_t ret = SendNetlinkMsgsAndWaitAcks(sock, seq, msgs, errors, [&replySeqs](const nlmsghdr *reply) {
+        replySeqs.push_back(reply->nlmsg_seq);
+    });
+    close(sock);
+    ASSERT_EQ(ret, 0);
+    EXPECT_EQ(seq, 102u);
+    ASSERT_EQ(errors.size(), msgs.size());
+    // The link of the first request is handed over before its ack, the second one names no link
+    EXPECT_EQ(errors[0], 0);
+    EXPECT_EQ(errors[1], -ENODEV);
+    EXPECT_EQ(replySeqs, std::vector<uint32_t>{101});
+}
+
+HWTEST_F(NetlinkSocketTest, SendNetlinkMsgsAndWaitAcksTest002, TestSize.Level1)
+{
+    std::vector<NetlinkMsg> msgs;
+    msgs.emplace_back(0, NETLINK_MAX_LEN, 0);
+    uint32_t seq = 0;
+    std::vector<int32_t> errors;
+    EXPECT_EQ(SendNetlinkMsgsAndWaitAcks(-1, seq, msgs, errors), -EBADF);
+    EXPECT_TRUE(errors.empty());
+}
 } // namespace nmd
 } // namespace OHOS
\ No newline at end of file
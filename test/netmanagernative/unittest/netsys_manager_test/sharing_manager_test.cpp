@@ -13,10 +13,17 @@
  * limitations under the License.
  */
 
+#include <arpa/inet.h>
 #include <cstdio>
+#include <fcntl.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
+#include "bpf_path.h"
+#include "common_netns_test_util.h"
 #include "net_manager_constants.h"
 #define private public
 #include "sharing_manager.h"
@@ -27,6 +34,85 @@ namespace NetsysNative {
 namespace {
 using namespace testing::ext;
 using namespace nmd;
+using namespace NetManagerStandard::NetnsTestUtil;
+constexpr const char *TETHER_DOWN_IFACE = "tdn0";
+constexpr const char *TETHER_UP_IFACE = "tup0";
+constexpr const char *TETHER_DOWN_NETNS = "tetherdn";
+constexpr const char *TETHER_UP_NETNS = "tetherup";
+constexpr const char *TETHER_DOWN_PEER_IPV4 = "198.18.5.2";
+constexpr const char *TETHER_UP_PEER_IPV4 = "198.18.6.2";
+constexpr const char *IPV4_FORWARD_PATH = "/proc/sys/net/ipv4/ip_forward";
+constexpr uint16_t TETHER_PEER_PORT = 9099;
+constexpr size_t TETHER_PAYLOAD_LEN = 512;
+// IPv4 and UDP headers, the counters count the IP packet without the link header
+constexpr int64_t TETHER_PACKET_LEN = TETHER_PAYLOAD_LEN + 28;
+constexpr int32_t TETHER_UPLINK_PACKET_NUM = 6;
+constexpr int32_t TETHER_DOWNLINK_PACKET_NUM = 4;
+constexpr int32_t TETHER_RECV_TIMEOUT_MS = 500;
+const VethPeerConfig TETHER_DOWN_VETH = {TETHER_DOWN_NETNS, TETHER_DOWN_IFACE, "tdn1", "198.18.5.1/24",
+                                         std::string(TETHER_DOWN_PEER_IPV4) + "/24"};
+const VethPeerConfig TETHER_UP_VETH = {TETHER_UP_NETNS, TETHER_UP_IFACE, "tup1", "198.18.6.1/24",
+                                       std::string(TETHER_UP_PEER_IPV4) + "/24"};
+
+bool WriteProc(const char *path, char value)
+{
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ret = write(fd, &value, sizeof(value)) == sizeof(value);
+    close(fd);
+    return ret;
+}
+
+char ReadProc(const char *path)
+{
+    char value = '0';
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        read(fd, &value, sizeof(value));
+        close(fd);
+    }
+    return value;
+}
+
+// A client namespace behind tdn0 and a server namespace behind tup0, the host forwards between them
+bool SetUpTetherNetns()
+{
+    return SetUpVethPeerNetns(TETHER_DOWN_VETH) && SetUpVethPeerNetns(TETHER_UP_VETH) &&
+        RunCmd("ip -n tetherdn route add default via 198.18.5.1") &&
+        RunCmd("ip -n tetherup route add default via 198.18.6.1");
+}
+
+void TearDownTetherNetns()
+{
+    TearDownVethPeerNetns(TETHER_DOWN_VETH);
+    TearDownVethPeerNetns(TETHER_UP_VETH);
+}
+
+sockaddr_in MakeAddr(const char *ip)
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TETHER_PEER_PORT);
+    inet_pton(AF_INET, ip, &addr.sin_addr);
+    return addr;
+}
+
+// Returns the number of datagrams the peer received
+int32_t SendToPeer(int32_t sock, int32_t peerSock, const char *peerIp, int32_t num)
+{
+    sockaddr_in addr = MakeAddr(peerIp);
+    char payload[TETHER_PAYLOAD_LEN] = {0};
+    for (int32_t i = 0; i < num; ++i) {
+        sendto(sock, payload, sizeof(payload), 0, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    }
+    int32_t received = 0;
+    while (recv(peerSock, payload, sizeof(payload), 0) > 0) {
+        ++received;
+    }
+    return received;
+}
 } // namespace
 
 class SharingManagerTest : public testing::Test {
@@ -268,12 +354,13 @@ HWTEST_F(SharingManagerTest, QueryCellularSharingTraffic001, TestSize.Level1)
     auto sharingManager = std::make_shared<SharingManager>();
     NetworkSharingTraffic traffic;
     std::string ifaceName = "";
-    std::string result = "Chain tetherctrl_counters (2 references) \n"
-        "pkts  bytes target     prot opt in     out     source               destination \n"
-        "        0        0 RETURN     all  --  wlan0  wlan1   0.0.0.0/0            0.0.0.0/0 \n"
-        "        0        0 RETURN     all  --  wlan1  wlan0   0.0.0.0/0            0.0.0.0/0 \n";
-    auto res = sharingManager->QueryCellularSharingTraffic(traffic, result, ifaceName);
+    std::vector<TetherTrafficCounter> counters = {{"wlan0", "wlan1", 100}, {"wlan1", "wlan0", 200}};
+    auto res = sharingManager->QueryCellularSharingTraffic(traffic, counters, ifaceName);
     EXPECT_EQ(res, 0);
+    EXPECT_EQ(ifaceName, "wlan0");
+    EXPECT_EQ(traffic.send, 100);
+    EXPECT_EQ(traffic.receive, 200);
+    EXPECT_EQ(traffic.all, 300);
 }
 
 HWTEST_F(SharingManagerTest, QueryCellularSharingTraffic002, TestSize.Level1)
@@ -281,12 +368,12 @@ HWTEST_F(SharingManagerTest, QueryCellularSharingTraffic002, TestSize.Level1)
     auto sharingManager = std::make_shared<SharingManager>();
     NetworkSharingTraffic traffic;
     std::string ifaceName = "";
-    std::string result = "Chain tetherctrl_counters (2 references) \n"
-        "pkts  bytes target     prot opt in     out     source               destination \n"
-        "        0        0 RETURN     all  --  rmnet0  wlan1   0.0.0.0/0            0.0.0.0/0 \n"
-        "        0        0 RETURN     all  --  wlan1  rmnet0   0.0.0.0/0            0.0.0.0/0 \n";
-    auto res = sharingManager->QueryCellularSharingTraffic(traffic, result, ifaceName);
+    std::vector<TetherTrafficCounter> counters = {{"rmnet0", "wlan1", 100}, {"wlan1", "rmnet0", 200}};
+    auto res = sharingManager->QueryCellularSharingTraffic(traffic, counters, ifaceName);
     EXPECT_EQ(res, 0);
+    EXPECT_EQ(ifaceName, "rmnet0");
+    EXPECT_EQ(traffic.send, 100);
+    EXPECT_EQ(traffic.receive, 200);
 }
 
 HWTEST_F(SharingManagerTest, QueryCellularSharingTraffic003, TestSize.Level1)
@@ -294,11 +381,8 @@ HWTEST_F(SharingManagerTest, QueryCellularSharingTraffic003, TestSize.Level1)
     auto sharingManager = std::make_shared<SharingManager>();
     NetworkSharingTraffic traffic;
     std::string ifaceName = "";
-    std::string result = "Chain tetherctrl_counters (2 references) \n"
-        "pkts  bytes target     prot opt in     out     source               destination \n"
-        "        0        0 RETURN     all  --  wifi0  wifi1   0.0.0.0/0            0.0.0.0/0 \n"
-        "        0        0 RETURN     all  --  wifi1  wifi0   0.0.0.0/0            0.0.0.0/0 \n";
-    auto res = sharingManager->QueryCellularSharingTraffic(traffic, result, ifaceName);
+    std::vector<TetherTrafficCounter> counters = {{"wifi0", "wifi1", 0}, {"wifi1", "wifi0", 0}};
+    auto res = sharingManager->QueryCellularSharingTraffic(traffic, counters, ifaceName);
     EXPECT_EQ(res, -1);
 }
 
@@ -307,11 +391,9 @@ HWTEST_F(SharingManagerTest, QueryCellularSharingTraffic004, TestSize.Level1)
     auto sharingManager = std::make_shared<SharingManager>();
     NetworkSharingTraffic traffic;
     std::string ifaceName = "";
-    std::string result = "Chain tetherctrl_counters (2 references) \n"
-        "pkts  bytes target     prot opt in     out     source               destination \n"
-        "        0        0 RETURN     all  --  wifi0   0.0.0.0/0            0.0.0.0/0 \n"
-        "        0        0 RETURN     all  --  wifi1   0.0.0.0/0            0.0.0.0/0 \n";
-    auto res = sharingManager->QueryCellularSharingTraffic(traffic, result, ifaceName);
+    // Only one direction of the forward is counted
+    std::vector<TetherTrafficCounter> counters = {{"rmnet0", "wlan1", 0}};
+    auto res = sharingManager->QueryCellularSharingTraffic(traffic, counters, ifaceName);
     EXPECT_EQ(res, -1);
 }
 
@@ -645,15 +727,63 @@ HWTEST_F(SharingManagerTest, GetNetworkCellularSharingTraffic001, TestSize.Level
 HWTEST_F(SharingManagerTest, GetTraffic001, TestSize.Level1)
 {
     auto sharingManager = std::make_shared<SharingManager>();
-    std::smatch matches;
+    TetherTrafficCounter counter;
     std::string ifaceName;
     NetworkSharingTraffic traffic;
     bool isFindTx = false;
     bool isFindRx = false;
-    // Test with empty matches
-    sharingManager->GetTraffic(matches, ifaceName, traffic, isFindTx, isFindRx);
-    // No crash expected
-    SUCCEED();
+    // Test with an empty counter
+    sharingManager->GetTraffic(counter, ifaceName, traffic, isFindTx, isFindRx);
+    EXPECT_FALSE(isFindTx);
+    EXPECT_FALSE(isFindRx);
+}
+
+HWTEST_F(SharingManagerTest, TetherCountersVethTest, TestSize.Level1)
+{
+    // Counted by the tc program netsys loads, on a forward between two veth pairs
+    if (getuid() != 0 || access(NetManagerStandard::TETHER_STATS_MAP_PATH, F_OK) != 0 ||
+        access(NetManagerStandard::TETHER_EGRESS_PROG_PATH, F_OK) != 0) {
+        GTEST_SKIP() << "needs root, the tether stats map and the egress program";
+    }
+    if (!SetUpTetherNetns()) {
+        TearDownTetherNetns();
+        GTEST_SKIP() << "cannot set up the tether namespaces";
+    }
+    char forward = ReadProc(IPV4_FORWARD_PATH);
+    ASSERT_TRUE(WriteProc(IPV4_FORWARD_PATH, '1'));
+    int32_t downSock = OpenNetnsUdpSocket(TETHER_DOWN_NETNS, TETHER_DOWN_PEER_IPV4, TETHER_PEER_PORT,
+                                          TETHER_RECV_TIMEOUT_MS);
+    int32_t upSock = OpenNetnsUdpSocket(TETHER_UP_NETNS, TETHER_UP_PEER_IPV4, TETHER_PEER_PORT, TETHER_RECV_TIMEOUT_MS);
+    ASSERT_GE(downSock, 0);
+    ASSERT_GE(upSock, 0);
+
+    auto sharingManager = std::make_shared<SharingManager>();
+    sharingManager->AddTetherCounters(TETHER_DOWN_IFACE, TETHER_UP_IFACE);
+    NetworkSharingTraffic traffic;
+    EXPECT_EQ(sharingManager->GetNetworkSharingTraffic(TETHER_DOWN_IFACE, TETHER_UP_IFACE, traffic),
+              NetManagerStandard::NETMANAGER_SUCCESS);
+    EXPECT_EQ(traffic.all, 0);
+
+    int32_t uplink = SendToPeer(downSock, upSock, TETHER_UP_PEER_IPV4, TETHER_UPLINK_PACKET_NUM);
+    int32_t downlink = SendToPeer(upSock, downSock, TETHER_DOWN_PEER_IPV4, TETHER_DOWNLINK_PACKET_NUM);
+    EXPECT_EQ(uplink, TETHER_UPLINK_PACKET_NUM);
+    EXPECT_EQ(downlink, TETHER_DOWNLINK_PACKET_NUM);
+    traffic = {};
+    EXPECT_EQ(sharingManager->GetNetworkSharingTraffic(TETHER_DOWN_IFACE, TETHER_UP_IFACE, traffic),
+              NetManagerStandard::NETMANAGER_SUCCESS);
+    EXPECT_EQ(traffic.send, uplink * TETHER_PACKET_LEN);
+    EXPECT_EQ(traffic.receive, downlink * TETHER_PACKET_LEN);
+    EXPECT_EQ(traffic.all, (uplink + downlink) * TETHER_PACKET_LEN);
+
+    // Not counted once the forward is removed
+    sharingManager->RemoveTetherCounters(TETHER_DOWN_IFACE, TETHER_UP_IFACE);
+    EXPECT_TRUE(sharingManager->tetherCounterPairs_.empty());
+    EXPECT_EQ(sharingManager->GetNetworkSharingTraffic(TETHER_DOWN_IFACE, TETHER_UP_IFACE, traffic),
+              NetManagerStandard::NETMANAGER_ERROR);
+    close(downSock);
+    close(upSock);
+    WriteProc(IPV4_FORWARD_PATH, forward);
+    TearDownTetherNetns();
 }
 } // namespace NetsysNative
 } // namespace OHOS
@@ -13,14 +13,154 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <linux/perf_event.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
 
+#ifdef GTEST_API_
+#define private public
+#endif
+
+#include "common_netns_test_util.h"
 #include "traffic_manager.h"
 
 namespace OHOS {
 namespace nmd {
 namespace {
 using namespace testing::ext;
+using namespace OHOS::NetManagerStandard::NetnsTestUtil;
+constexpr const char *TRAFFIC_NETNS = "trafficnl";
+constexpr const char *TRAFFIC_NETNS_SYS_CLASS_NET = "/sys/class/net/";
+constexpr const char *COUNTER_NAMES[] = {"rx_bytes", "rx_packets", "tx_bytes", "tx_packets"};
+const char *const SYSCALL_TRACEPOINT_IDS[] = {
+    "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+    "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+};
+constexpr int32_t DUMMY_IFACE_NUM = 50;
+constexpr int32_t SNAPSHOT_EXPIRE_MS = 200;
+constexpr const char *VETH_TX_IFACE = "tmv0";
+constexpr const char *VETH_RX_IFACE = "tmv1";
+constexpr const char *VETH_TX_ADDR = "10.199.0.1";
+constexpr const char *VETH_RX_ADDR = "10.199.0.2";
+constexpr uint16_t VETH_PORT = 9;
+constexpr int32_t VETH_PACKET_NUM = 100;
+constexpr size_t VETH_PAYLOAD_LEN = 512;
+
+/* Counts the syscalls of the calling thread, -1 when the kernel has no raw_syscalls tracepoint */
+int OpenSyscallCounter()
+{
+    for (const char *path : SYSCALL_TRACEPOINT_IDS) {
+        FILE *file = fopen(path, "r");
+        if (file == nullptr) {
+            continue;
+        }
+        unsigned long long id = 0;
+        bool isRead = fscanf(file, "%llu", &id) == 1;
+        fclose(file);
+        if (!isRead) {
+            continue;
+        }
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = id;
+        int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        if (fd >= 0) {
+            return fd;
+        }
+    }
+    return -1;
+}
+
+uint64_t ReadSyscallCounter(int fd)
+{
+    uint64_t count = 0;
+    if (fd < 0 || read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) {
+        return 0;
+    }
+    return count;
+}
+
+/* What GetInterfaceTraffic did before the dump: list /sys/class/net, read one file per counter, then ioctl */
+TrafficStatsParcel ReadSysfsTraffic(const std::string &ifName)
+{
+    TrafficStatsParcel parcel = {"", 0, 0, 0, 0, 0};
+    DIR *dir = opendir(TRAFFIC_NETNS_SYS_CLASS_NET);
+    if (dir == nullptr) {
+        return parcel;
+    }
+    bool isFound = false;
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        isFound = isFound || ifName == entry->d_name;
+    }
+    closedir(dir);
+    if (!isFound) {
+        return parcel;
+    }
+    long counters[sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0])] = {0};
+    for (size_t i = 0; i < sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]); ++i) {
+        std::string path = std::string(TRAFFIC_NETNS_SYS_CLASS_NET) + ifName + "/statistics/" + COUNTER_NAMES[i];
+        char realPath[PATH_MAX] = {0};
+        int fd = realpath(path.c_str(), realPath) == nullptr ? -1 : open(realPath, O_RDONLY);
+        if (fd < 0) {
+            continue;
+        }
+        char buf[100] = {0};
+        if (read(fd, buf, sizeof(buf) - 1) > 0) {
+            counters[i] = atol(buf);
+        }
+        close(fd);
+    }
+    parcel.iface = ifName;
+    parcel.ifIndex = if_nametoindex(ifName.c_str());
+    parcel.rxBytes = counters[0];
+    parcel.rxPackets = counters[1];
+    parcel.txBytes = counters[2];
+    parcel.txPackets = counters[3];
+    return parcel;
+}
+
+/* Send UDP datagrams from VETH_TX_ADDR to VETH_RX_ADDR, returns how many went out */
+int32_t SendVethTraffic()
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    inet_pton(AF_INET, VETH_TX_ADDR, &local.sin_addr);
+    sockaddr_in peer = {};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(VETH_PORT);
+    inet_pton(AF_INET, VETH_RX_ADDR, &peer.sin_addr);
+    int32_t sent = 0;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) == 0) {
+        char payload[VETH_PAYLOAD_LEN] = {0};
+        for (int32_t i = 0; i < VETH_PACKET_NUM; ++i) {
+            sent += sendto(fd, payload, sizeof(payload), 0, reinterpret_cast<sockaddr *>(&peer), sizeof(peer)) ==
+                static_cast<ssize_t>(sizeof(payload)) ? 1 : 0;
+        }
+    }
+    close(fd);
+    return sent;
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 } // namespace
 
 class TrafficManagerTest : public testing::Test {
@@ -29,11 +169,27 @@ public:
     static void TearDownTestCase();
     void SetUp();
     void TearDown();
+
+    static inline bool isTrafficNetnsReady_ = false;
 };
 
-void TrafficManagerTest::SetUpTestCase() {}
+void TrafficManagerTest::SetUpTestCase()
+{
+    if (getuid() != 0) {
+        return;
+    }
+    isTrafficNetnsReady_ = AddNetns(TRAFFIC_NETNS);
+    for (int32_t i = 0; i < DUMMY_IFACE_NUM && isTrafficNetnsReady_; ++i) {
+        isTrafficNetnsReady_ = RunCmd("ip -n trafficnl link add tm" + std::to_string(i) + " type dummy");
+    }
+}
 
-void TrafficManagerTest::TearDownTestCase() {}
+void TrafficManagerTest::TearDownTestCase()
+{
+    if (isTrafficNetnsReady_) {
+        DelNetns(TRAFFIC_NETNS);
+    }
+}
 
 void TrafficManagerTest::SetUp() {}
 
@@ -76,5 +232,103 @@ HWTEST_F(TrafficManagerTest, GetAllRxTraffic002, TestSize.Level1)
     long allRxBytes = TrafficManager::GetAllRxTraffic();
     EXPECT_GE(allRxBytes, 0);
 }
+
+HWTEST_F(TrafficManagerTest, GetTrafficSnapshot001, TestSize.Level1)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(SNAPSHOT_EXPIRE_MS));
+    auto snapshot = TrafficManager::GetTrafficSnapshot();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(TrafficManager::GetTrafficSnapshot(), snapshot);
+
+    long allRxBytes = 0;
+    long allTxBytes = 0;
+    for (const auto &stats : *snapshot) {
+        EXPECT_EQ(stats.ifIndex, if_nametoindex(stats.iface.c_str()));
+        if (stats.iface != "lo") {
+            allRxBytes += stats.rxBytes;
+            allTxBytes += stats.txBytes;
+        }
+    }
+    EXPECT_EQ(TrafficManager::GetAllRxTraffic(), allRxBytes);
+    EXPECT_EQ(TrafficManager::GetAllTxTraffic(), allTxBytes);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(SNAPSHOT_EXPIRE_MS));
+    EXPECT_NE(TrafficManager::GetTrafficSnapshot(), snapshot);
+}
+
+HWTEST_F(TrafficManagerTest, GetInterfaceTrafficNetns001, TestSize.Level1)
+{
+    if (!isTrafficNetnsReady_) {
+        GTEST_SKIP() << "needs root and the trafficnl namespace";
+    }
+    // A fresh snapshot of the default namespace, which must not answer the queries from the test namespace
+    TrafficManager::GetAllRxTraffic();
+    // With its own sysfs mount, so /sys/class/net lists the interfaces of the test namespace
+    EXPECT_TRUE(RunInNetns(TRAFFIC_NETNS, []() {
+        int counterFd = OpenSyscallCounter();
+        std::vector<TrafficStatsParcel> sysfsStats;
+        uint64_t syscalls = ReadSyscallCounter(counterFd);
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < DUMMY_IFACE_NUM; ++i) {
+            sysfsStats.push_back(ReadSysfsTraffic("tm" + std::to_string(i)));
+        }
+        double sysfsMs = ElapsedMs(start);
+        uint64_t sysfsSyscalls = ReadSyscallCounter(counterFd) - syscalls;
+
+        std::vector<TrafficStatsParcel> dumpStats;
+        syscalls = ReadSyscallCounter(counterFd);
+        start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < DUMMY_IFACE_NUM; ++i) {
+            dumpStats.push_back(TrafficManager::GetInterfaceTraffic("tm" + std::to_string(i)));
+        }
+        double dumpMs = ElapsedMs(start);
+        uint64_t dumpSyscalls = ReadSyscallCounter(counterFd) - syscalls;
+
+        for (int32_t i = 0; i < DUMMY_IFACE_NUM; ++i) {
+            EXPECT_EQ(dumpStats[i].iface, "tm" + std::to_string(i));
+            EXPECT_EQ(dumpStats[i].iface, sysfsStats[i].iface);
+            EXPECT_EQ(dumpStats[i].ifIndex, sysfsStats[i].ifIndex);
+            // The dummy interfaces stay down, nothing moves their counters between the two reads
+            EXPECT_EQ(dumpStats[i].rxBytes, sysfsStats[i].rxBytes);
+            EXPECT_EQ(dumpStats[i].txPackets, sysfsStats[i].txPackets);
+        }
+        if (counterFd >= 0) {
+            EXPECT_LT(dumpSyscalls, sysfsSyscalls);
+            close(counterFd);
+        }
+        printf("%d interfaces: sysfs %.3f ms %llu syscalls, dump %.3f ms %llu syscalls\n", DUMMY_IFACE_NUM, sysfsMs,
+               static_cast<unsigned long long>(sysfsSyscalls), dumpMs, static_cast<unsigned long long>(dumpSyscalls));
+    }, true));
+}
+
+HWTEST_F(TrafficManagerTest, GetInterfaceTrafficVeth001, TestSize.Level1)
+{
+    if (!isTrafficNetnsReady_) {
+        GTEST_SKIP() << "needs root and the trafficnl namespace";
+    }
+    std::string tx = VETH_TX_IFACE;
+    std::string rx = VETH_RX_IFACE;
+    // Only the sending end has an address, the datagrams go to the peer through the static neighbor entry
+    ASSERT_TRUE(RunCmd("ip -n trafficnl link add " + tx + " type veth peer name " + rx));
+    ASSERT_TRUE(RunCmd("ip -n trafficnl link set " + rx + " address 02:00:00:00:00:02 up") &&
+                RunCmd("ip -n trafficnl addr add " + std::string(VETH_TX_ADDR) + "/30 dev " + tx) &&
+                RunCmd("ip -n trafficnl link set " + tx + " up") &&
+                RunCmd("ip -n trafficnl neigh replace " + std::string(VETH_RX_ADDR) + " lladdr 02:00:00:00:00:02 dev " +
+                       tx + " nud permanent"));
+    EXPECT_TRUE(RunInNetns(TRAFFIC_NETNS, [&tx, &rx]() {
+        int32_t sent = SendVethTraffic();
+        ASSERT_EQ(sent, VETH_PACKET_NUM);
+        std::this_thread::sleep_for(std::chrono::milliseconds(SNAPSHOT_EXPIRE_MS));
+        TrafficStatsParcel txStats = TrafficManager::GetInterfaceTraffic(tx);
+        TrafficStatsParcel rxStats = TrafficManager::GetInterfaceTraffic(rx);
+        EXPECT_GE(txStats.txPackets, VETH_PACKET_NUM);
+        EXPECT_GE(txStats.txBytes, static_cast<long>(VETH_PACKET_NUM * VETH_PAYLOAD_LEN));
+        EXPECT_GE(rxStats.rxPackets, VETH_PACKET_NUM);
+        EXPECT_GE(rxStats.rxBytes, static_cast<long>(VETH_PACKET_NUM * VETH_PAYLOAD_LEN));
+        EXPECT_GE(TrafficManager::GetAllTxTraffic(), txStats.txBytes);
+        EXPECT_GE(TrafficManager::GetAllRxTraffic(), rxStats.rxBytes);
+    }, true));
+    RunCmd("ip -n trafficnl link del " + tx);
+}
 } // namespace nmd
 } // namespace OHOS
\ No newline at end of file
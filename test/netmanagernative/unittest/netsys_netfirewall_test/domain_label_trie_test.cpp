@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "domain_label_trie.h"
+
+using namespace std;
+using namespace testing::ext;
+using namespace OHOS::NetManagerStandard;
+
+namespace {
+constexpr int32_t BENCH_RULE_NUM = 50000;
+constexpr int32_t BENCH_UID_NUM = 100;
+constexpr int32_t BENCH_LOOKUP_NUM = 20000;
+constexpr int32_t BENCH_LINEAR_LOOKUP_NUM = 200;
+constexpr int32_t BENCH_WILDCARD_RATIO = 4;
+
+struct TestRule {
+    string domain;
+    bool isWildcard;
+    int32_t uid;
+};
+
+// Per-rule comparison, as a list of domain rules would be scanned without an index
+bool LinearMatch(const vector<TestRule> &rules, const string &hostName, int32_t uid)
+{
+    for (const auto &rule : rules) {
+        if (rule.uid != uid) {
+            continue;
+        }
+        if (!rule.isWildcard && hostName == rule.domain) {
+            return true;
+        }
+        if (rule.isWildcard && hostName.size() > rule.domain.size() + 1 &&
+            hostName.compare(hostName.size() - rule.domain.size(), rule.domain.size(), rule.domain) == 0 &&
+            hostName[hostName.size() - rule.domain.size() - 1] == '.') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TrieMatch(const DomainLabelTrie<vector<int32_t>> &trie, const string &hostName, int32_t uid)
+{
+    bool matched = false;
+    trie.Match(hostName, [&matched, uid](const vector<int32_t> &uids, bool) {
+        for (int32_t item : uids) {
+            matched = matched || item == uid;
+        }
+    });
+    return matched;
+}
+} // namespace
+
+class DomainLabelTrieTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+    static void TearDownTestCase();
+    void SetUp();
+    void TearDown();
+};
+
+void DomainLabelTrieTest::SetUpTestCase() {}
+
+void DomainLabelTrieTest::TearDownTestCase() {}
+
+void DomainLabelTrieTest::SetUp() {}
+
+void DomainLabelTrieTest::TearDown() {}
+
+HWTEST_F(DomainLabelTrieTest, ExactMatch001, TestSize.Level0)
+{
+    DomainLabelTrie<int> trie;
+    EXPECT_TRUE(trie.Empty());
+    *trie.Emplace("www.harmony.com", false) = 1;
+    EXPECT_EQ(trie.Size(), 1);
+
+    int hits = 0;
+    trie.Match("www.harmony.com", [&hits](int value, bool isWildcard) {
+        EXPECT_EQ(value, 1);
+        EXPECT_FALSE(isWildcard);
+        ++hits;
+    });
+    EXPECT_EQ(hits, 1);
+
+    for (const string name : {"harmony.com", "a.www.harmony.com", "ww.harmony.com", "www.harmony.co", ""}) {
+        trie.Match(name, [&hits](int, bool) { ++hits; });
+    }
+    EXPECT_EQ(hits, 1);
+}
+
+HWTEST_F(DomainLabelTrieTest, WildcardMatch001, TestSize.Level0)
+{
+    DomainLabelTrie<int> trie;
+    *trie.Emplace("*.harmony.com", false) = 1;
+    *trie.Emplace("openharmony.com", true) = 2;
+
+    vector<int> values;
+    auto collect = [&values](int value, bool isWildcard) {
+        EXPECT_TRUE(isWildcard);
+        values.push_back(value);
+    };
+    trie.Match("a.b.harmony.com", collect);
+    trie.Match("harmony.com", collect);
+    trie.Match("test.openharmony.com", collect);
+    trie.Match("testharmony.com", collect);
+    EXPECT_EQ(values, vector<int>({1, 2}));
+}
+
+HWTEST_F(DomainLabelTrieTest, MatchOrder001, TestSize.Level0)
+{
+    DomainLabelTrie<int> trie;
+    *trie.Emplace("*", false) = 1;
+    *trie.Emplace("com", true) = 2;
+    *trie.Emplace("harmony.com", false) = 3;
+    *trie.Emplace("harmony.com", true) = 4;
+    EXPECT_EQ(trie.Size(), 4);
+
+    vector<int> values;
+    trie.Match("harmony.com", [&values](int value, bool) { values.push_back(value); });
+    EXPECT_EQ(values, vector<int>({1, 2, 3}));
+
+    values.clear();
+    trie.Match("www.harmony.com", [&values](int value, bool) { values.push_back(value); });
+    EXPECT_EQ(values, vector<int>({1, 2, 4}));
+}
+
+HWTEST_F(DomainLabelTrieTest, CaseAndDot001, TestSize.Level0)
+{
+    DomainLabelTrie<int> trie;
+    *trie.Emplace("WWW.Harmony.COM.", false) = 1;
+    int *value = trie.Emplace("www.harmony.com", false);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, 1);
+    EXPECT_EQ(trie.Size(), 1);
+
+    int hits = 0;
+    trie.Match("www.HARMONY.com.", [&hits](int, bool) { ++hits; });
+    EXPECT_EQ(hits, 1);
+}
+
+HWTEST_F(DomainLabelTrieTest, InvalidDomain001, TestSize.Level0)
+{
+    DomainLabelTrie<int> trie;
+    EXPECT_EQ(trie.Emplace("", false), nullptr);
+    EXPECT_EQ(trie.Emplace(".", false), nullptr);
+    EXPECT_EQ(trie.Emplace("a..com", false), nullptr);
+    EXPECT_EQ(trie.Emplace(".com", true), nullptr);
+    EXPECT_EQ(trie.Size(), 0);
+
+    *trie.Emplace("com", false) = 1;
+    *trie.Emplace("a.com", false) = 2;
+    int hits = 0;
+    trie.Match("a..com", [&hits](int, bool) { ++hits; });
+    trie.Match(".com", [&hits](int, bool) { ++hits; });
+    EXPECT_EQ(hits, 0);
+}
+
+HWTEST_F(DomainLabelTrieTest, LookupBenchmark001, TestSize.Level0)
+{
+    mt19937 rng(BENCH_RULE_NUM);
+    vector<TestRule> rules;
+    DomainLabelTrie<vector<int32_t>> trie;
+    for (int32_t i = 0; i < BENCH_RULE_NUM; ++i) {
+        TestRule rule = {"site" + to_string(i) + ".example" + to_string(i % 97) + ".com",
+                         i % BENCH_WILDCARD_RATIO == 0, static_cast<int32_t>(rng() % BENCH_UID_NUM)};
+        trie.Emplace(rule.domain, rule.isWildcard)->push_back(rule.uid);
+        rules.push_back(rule);
+    }
+    EXPECT_EQ(trie.Size(), BENCH_RULE_NUM);
+
+    // A third exact names, a third names below a rule, a third unknown names
+    vector<pair<string, int32_t>> queries;
+    for (int32_t i = 0; i < BENCH_LOOKUP_NUM; ++i) {
+        const TestRule &rule = rules[rng() % rules.size()];
+        int32_t uid = rng() % 2 == 0 ? rule.uid : static_cast<int32_t>(rng() % BENCH_UID_NUM);
+        switch (i % 3) {
+            case 0:
+                queries.emplace_back(rule.domain, uid);
+                break;
+            case 1:
+                queries.emplace_back("cdn." + rule.domain, uid);
+                break;
+            default:
+                queries.emplace_back("miss" + to_string(i) + ".example.org", uid);
+                break;
+        }
+    }
+
+    int32_t trieHits = 0;
+    auto start = chrono::steady_clock::now();
+    for (const auto &query : queries) {
+        trieHits += TrieMatch(trie, query.first, query.second) ? 1 : 0;
+    }
+    double trieNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / queries.size();
+
+    int32_t linearHits = 0;
+    start = chrono::steady_clock::now();
+    for (int32_t i = 0; i < BENCH_LINEAR_LOOKUP_NUM; ++i) {
+        bool matched = LinearMatch(rules, queries[i].first, queries[i].second);
+        EXPECT_EQ(matched, TrieMatch(trie, queries[i].first, queries[i].second)) << queries[i].first;
+        linearHits += matched ? 1 : 0;
+    }
+    double linearNs =
+        chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / BENCH_LINEAR_LOOKUP_NUM;
+
+    printf("%d rules: trie %.0f ns/lookup (%d/%d hits), linear %.0f ns/lookup (%d/%d hits)\n", BENCH_RULE_NUM,
+           trieNs, trieHits, BENCH_LOOKUP_NUM, linearNs, linearHits, BENCH_LINEAR_LOOKUP_NUM);
+    EXPECT_GT(trieHits, 0);
+    EXPECT_LT(trieNs, linearNs);
+}
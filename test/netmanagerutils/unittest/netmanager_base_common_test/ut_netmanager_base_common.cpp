@@ -14,7 +14,11 @@
  */
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <fstream>
+#include <random>
+#include <regex>
+#include <set>
 #include <sys/stat.h>
 
 #include "netmanager_base_common_utils.h"
@@ -49,6 +53,115 @@ constexpr int32_t BIT_32 = 32;
 constexpr int32_t BIT_24 = 24;
 constexpr int32_t BIT_16 = 16;
 constexpr int32_t BIT_8 = 8;
+constexpr size_t DOMAIN_VALID_MIN_PARTS = 2;
+constexpr size_t DOMAIN_VALID_MAX_PARTS = 5;
+
+constexpr int32_t EXHAUSTIVE_MAX_LEN = 5;
+constexpr int32_t OCTET_MAX_DIGITS = 4;
+constexpr int32_t IPV4_OCTET_NUM = 4;
+constexpr int32_t FUZZ_ROUNDS = 20000;
+constexpr int32_t FUZZ_MAX_LEN = 48;
+constexpr int32_t DOMAIN_FUZZ_ROUNDS = 20000;
+constexpr int32_t DOMAIN_MAX_LABELS = 6;
+constexpr int32_t BENCH_ROUNDS = 2000;
+const std::string EXHAUSTIVE_ALPHABET = "019.:/a";
+const std::string FUZZ_ALPHABET = "0123456789abcdefABCDEF...:::// xX-g";
+
+/* The regex based implementations replaced by the hand written scanners, kept as the differential reference */
+const std::regex REFERENCE_IP_PATTERN{
+    "((2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)\\.){3}(2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)"};
+const std::regex REFERENCE_IP_MASK_PATTERN{
+    "((2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)\\.){3}(2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)/"
+    "(3[0-2]|[1-2]\\d|\\d)"};
+const std::regex REFERENCE_IPV6_PATTERN{"([\\da-fA-F]{0,4}:){2,7}([\\da-fA-F]{0,4})"};
+const std::regex REFERENCE_IPV6_MASK_PATTERN{
+    "([\\da-fA-F]{0,4}:){2,7}([\\da-fA-F]{0,4})/(1[0-2][0-8]|[1-9]\\d|[1-9])"};
+const std::vector<std::string> REFERENCE_TLDS{"com", "net", "org", "edu", "gov", "mil", "cn", "hk", "tw", "jp", "de",
+    "uk", "fr", "au", "ca", "br", "ru", "it", "es", "in", "online", "shop", "vip", "club", "xyz", "top", "icu",
+    "work", "website", "tech", "asia", "xin", "co", "mobi", "info"};
+const std::vector<std::string> DOMAIN_PARTS{"", "http://", "https://", "htt://", "www", "test", "a-b", "-", "x_y",
+    "COM", "com", "co", "uk", "info", "mobi", "1", "a.b", ".", "..", "*", " ", "com.com", "xn--p1ai"};
+
+std::string ReferenceMaskIpMiddle(const std::string &input, const std::string &delimiter)
+{
+    std::string maskedResult = input;
+    size_t start = maskedResult.find(delimiter);
+    size_t end = maskedResult.rfind(delimiter);
+    if (start == std::string::npos || end <= start + delimiter.size()) {
+        start = 0;
+        end = maskedResult.size();
+    }
+    for (size_t i = start; i < end; i++) {
+        if (maskedResult[i] != delimiter[0] && maskedResult[i] != '/') {
+            maskedResult[i] = '*';
+        }
+    }
+    return maskedResult;
+}
+
+std::string ReferenceToAnonymousIp(const std::string &input)
+{
+    if (std::regex_match(input, REFERENCE_IP_PATTERN) || std::regex_match(input, REFERENCE_IP_MASK_PATTERN)) {
+        return ReferenceMaskIpMiddle(input, ".");
+    }
+    if (std::regex_match(input, REFERENCE_IPV6_PATTERN) || std::regex_match(input, REFERENCE_IPV6_MASK_PATTERN)) {
+        return ReferenceMaskIpMiddle(input, ":");
+    }
+    return input;
+}
+
+std::string ReferenceAnonymousIpInStr(const std::string &input)
+{
+    std::string result = std::regex_replace(input, REFERENCE_IP_PATTERN, "X.X.X.X");
+    return std::regex_replace(result, REFERENCE_IPV6_PATTERN, "X:X:X:X");
+}
+
+bool ReferenceIsValidDomain(const std::string &domain)
+{
+    if (domain.empty()) {
+        return false;
+    }
+    std::string pattern = "^(https?://)?[a-zA-Z0-9-]+(\\.[a-zA-Z0-9-]+)*\\.(";
+    for (const auto &tld : REFERENCE_TLDS) {
+        pattern += tld + "|";
+    }
+    pattern = pattern.replace(pattern.size() - 1, 1, "") + ")$";
+    if (!std::regex_match(domain, std::regex(pattern))) {
+        return false;
+    }
+    std::vector<std::string> parts = CommonUtils::Split(domain, ".");
+    if (parts.size() < DOMAIN_VALID_MIN_PARTS || parts.size() > DOMAIN_VALID_MAX_PARTS) {
+        return false;
+    }
+    std::set<std::string> tldsList;
+    for (const auto &item : parts) {
+        if (std::find(REFERENCE_TLDS.begin(), REFERENCE_TLDS.end(), item) == REFERENCE_TLDS.end()) {
+            continue;
+        }
+        if (!tldsList.insert(item).second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ExpectSameAnonymization(const std::string &input)
+{
+    EXPECT_EQ(CommonUtils::ToAnonymousIp(input, true), ReferenceToAnonymousIp(input)) << input;
+    EXPECT_EQ(CommonUtils::AnonymousIpInStr(input), ReferenceAnonymousIpInStr(input)) << input;
+}
+
+std::vector<std::string> BuildLogCorpus()
+{
+    return {
+        "-t filter -A OUTPUT -s 192.168.43.1/24 -d 10.0.0.254 -o wlan0 -j ACCEPT",
+        "-t mangle -A PREROUTING -i rmnet0 -s 2001:db8:85a3::8a2e:370:7334/64 -j MARK --set-mark 0x10",
+        "route add table 1005 dst fe80::1ff:fe23:4567:890a/64 gateway :: dev wlan0",
+        "ip rule add from all fwmark 0x0/0xffff iif lo lookup 1003 priority 17000",
+        "netd: interface wlan0 address 172.16.254.1 prefix 16 flags 128 scope 0",
+        "no address in this line at all, just a plain log message with words only",
+    };
+}
 } // namespace
 class UtNetmanagerBaseCommon : public testing::Test {
 public:
@@ -1450,5 +1563,137 @@ HWTEST_F(UtNetmanagerBaseCommon, SerializeStringVector001, TestSize.Level0)
     std::string result = CommonUtils::SerializeStringVector(testStrVec);
     EXPECT_FALSE(result.empty());
 }
+
+/**
+ * @tc.name: AnonymousIpDiffTest001
+ * @tc.desc: Compare ToAnonymousIp and AnonymousIpInStr with the regex implementation on every short string.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetmanagerBaseCommon, AnonymousIpDiffTest001, TestSize.Level1)
+{
+    std::vector<std::string> current{""};
+    for (int32_t len = 0; len < EXHAUSTIVE_MAX_LEN; ++len) {
+        std::vector<std::string> next;
+        for (const auto &prefix : current) {
+            for (char ch : EXHAUSTIVE_ALPHABET) {
+                next.push_back(prefix + ch);
+                ExpectSameAnonymization(next.back());
+            }
+        }
+        current.swap(next);
+    }
+}
+
+/**
+ * @tc.name: AnonymousIpDiffTest002
+ * @tc.desc: Compare the IPv4 scanners with the regex implementation on every octet of up to four digits.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetmanagerBaseCommon, AnonymousIpDiffTest002, TestSize.Level1)
+{
+    std::vector<std::string> octets;
+    std::vector<std::string> current{""};
+    for (int32_t len = 0; len < OCTET_MAX_DIGITS; ++len) {
+        std::vector<std::string> next;
+        for (const auto &prefix : current) {
+            for (char ch = '0'; ch <= '9'; ++ch) {
+                next.push_back(prefix + ch);
+            }
+        }
+        octets.insert(octets.end(), next.begin(), next.end());
+        current.swap(next);
+    }
+    for (int32_t index = 0; index < IPV4_OCTET_NUM; ++index) {
+        for (const auto &octet : octets) {
+            std::string ip;
+            for (int32_t i = 0; i < IPV4_OCTET_NUM; ++i) {
+                ip += (i == 0 ? "" : ".") + (i == index ? octet : "1");
+            }
+            ExpectSameAnonymization(ip);
+            ExpectSameAnonymization(ip + "/" + octet);
+            ExpectSameAnonymization("src " + ip + " dst");
+        }
+    }
+    for (const auto &octet : octets) {
+        ExpectSameAnonymization("fe80::" + octet + "/" + octet);
+    }
+}
+
+/**
+ * @tc.name: AnonymousIpDiffTest003
+ * @tc.desc: Compare ToAnonymousIp and AnonymousIpInStr with the regex implementation on random strings.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetmanagerBaseCommon, AnonymousIpDiffTest003, TestSize.Level1)
+{
+    std::mt19937 rng(0);
+    for (int32_t round = 0; round < FUZZ_ROUNDS; ++round) {
+        std::string input(rng() % FUZZ_MAX_LEN, ' ');
+        for (auto &ch : input) {
+            ch = FUZZ_ALPHABET[rng() % FUZZ_ALPHABET.size()];
+        }
+        ExpectSameAnonymization(input);
+    }
+    for (const auto &line : BuildLogCorpus()) {
+        ExpectSameAnonymization(line);
+    }
+}
+
+/**
+ * @tc.name: IsValidDomainDiffTest001
+ * @tc.desc: Compare IsValidDomain with the regex implementation on random domains.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetmanagerBaseCommon, IsValidDomainDiffTest001, TestSize.Level1)
+{
+    std::mt19937 rng(0);
+    for (int32_t round = 0; round < DOMAIN_FUZZ_ROUNDS; ++round) {
+        std::string domain;
+        int32_t labels = static_cast<int32_t>(rng() % DOMAIN_MAX_LABELS) + 1;
+        for (int32_t i = 0; i < labels; ++i) {
+            if (i > 0 && rng() % 4 != 0) {
+                domain += ".";
+            }
+            domain += i + 1 == labels ? REFERENCE_TLDS[rng() % REFERENCE_TLDS.size()] :
+                DOMAIN_PARTS[rng() % DOMAIN_PARTS.size()];
+        }
+        EXPECT_EQ(CommonUtils::IsValidDomain(domain), ReferenceIsValidDomain(domain)) << domain;
+    }
+    for (const auto &part : DOMAIN_PARTS) {
+        EXPECT_EQ(CommonUtils::IsValidDomain(part), ReferenceIsValidDomain(part)) << part;
+        EXPECT_EQ(CommonUtils::IsValidDomain(part + ".com"), ReferenceIsValidDomain(part + ".com")) << part;
+    }
+}
+
+/**
+ * @tc.name: AnonymousIpBenchmarkTest001
+ * @tc.desc: Compare the cost of the scanners with the regex implementation on typical log lines.
+ * @tc.type: PERF
+ */
+HWTEST_F(UtNetmanagerBaseCommon, AnonymousIpBenchmarkTest001, TestSize.Level1)
+{
+    std::vector<std::string> corpus = BuildLogCorpus();
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        for (const auto &line : corpus) {
+            checksum += ReferenceAnonymousIpInStr(line).size();
+        }
+    }
+    double referenceUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        for (const auto &line : corpus) {
+            checksum -= CommonUtils::AnonymousIpInStr(line).size();
+        }
+    }
+    double scannerUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(checksum, 0);
+
+    double lines = static_cast<double>(BENCH_ROUNDS) * corpus.size();
+    std::cout << "AnonymousIpInStr regex " << referenceUs / lines << " us, scanner " << scannerUs / lines
+              << " us per line" << std::endl;
+}
 } // namespace NetManagerStandard
 } // namespace OHOS
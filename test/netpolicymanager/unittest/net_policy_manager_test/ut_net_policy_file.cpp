@@ -13,6 +13,9 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <random>
 #include <thread>
 #include <unistd.h>
@@ -31,6 +34,26 @@ namespace NetManagerStandard {
 namespace {
 constexpr uint32_t MAX_LIST_SIZE = 10;
 constexpr uint32_t SLEEP_SECOND_TIME = 5;
+constexpr uint32_t FLUSH_WAIT_SECOND_TIME = 1;
+constexpr uint32_t TEST_UID_BASE = 900000;
+constexpr uint32_t BENCH_UID_NUM = 3000;
+constexpr uint32_t BENCH_ROUNDS = 2;
+
+uint32_t GetTogglePolicy(uint32_t round)
+{
+    return round % 2 == 0 ? NET_POLICY_REJECT_METERED_BACKGROUND : NET_POLICY_ALLOW_METERED_BACKGROUND;
+}
+
+void ExpectIndexConsistent(const std::shared_ptr<NetPolicyFile> &file)
+{
+    const auto &uidPolicies = file->ReadUidPolicies();
+    ASSERT_EQ(file->uidPolicyIndex_.size(), uidPolicies.size());
+    for (size_t i = 0; i < uidPolicies.size(); ++i) {
+        auto iter = file->uidPolicyIndex_.find(CommonUtils::StrToUint(uidPolicies[i].uid));
+        ASSERT_NE(iter, file->uidPolicyIndex_.end());
+        EXPECT_EQ(iter->second, i);
+    }
+}
 } // namespace
 std::shared_ptr<NetPolicyFile> netPolicyFile_ = nullptr;
 
@@ -144,5 +167,154 @@ HWTEST_F(UtNetPolicyFile, GetHandler001, TestSize.Level1)
     ASSERT_NE(handler, nullptr);
     EXPECT_TRUE(handler->Write());
 }
+
+/**
+ * @tc.name: WritePolicyByUid001
+ * @tc.desc: Test NetPolicyFile WritePolicyByUid keeps the uid index in step with the policy list.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetPolicyFile, WritePolicyByUid001, TestSize.Level1)
+{
+    auto file = std::make_shared<NetPolicyFile>();
+    file->ClearPolicies();
+    file->WritePolicyByUid(TEST_UID_BASE, NET_POLICY_REJECT_METERED_BACKGROUND);
+    file->WritePolicyByUid(TEST_UID_BASE + 1, NET_POLICY_ALLOW_METERED_BACKGROUND);
+    file->WritePolicyByUid(TEST_UID_BASE + 2, NET_POLICY_REJECT_METERED_BACKGROUND);
+    EXPECT_EQ(file->journalEntries_, 3);
+    file->WritePolicyByUid(TEST_UID_BASE + 1, NET_POLICY_ALLOW_METERED_BACKGROUND);
+    file->WritePolicyByUid(TEST_UID_BASE + 3, NET_POLICY_NONE);
+    EXPECT_EQ(file->journalEntries_, 3);
+    ExpectIndexConsistent(file);
+
+    file->WritePolicyByUid(TEST_UID_BASE + 1, NET_POLICY_REJECT_METERED_BACKGROUND);
+    file->RemoveInexistentUid(TEST_UID_BASE);
+    ExpectIndexConsistent(file);
+    const auto &uidPolicies = file->ReadUidPolicies();
+    ASSERT_EQ(uidPolicies.size(), 2);
+    for (const auto &uidPolicy : uidPolicies) {
+        EXPECT_NE(uidPolicy.uid, std::to_string(TEST_UID_BASE));
+        EXPECT_EQ(uidPolicy.policy, std::to_string(NET_POLICY_REJECT_METERED_BACKGROUND));
+    }
+    file->RemoveInexistentUid(TEST_UID_BASE + 1);
+    file->RemoveInexistentUid(TEST_UID_BASE + 2);
+    EXPECT_TRUE(file->ReadUidPolicies().empty());
+    EXPECT_TRUE(file->uidPolicyIndex_.empty());
+}
+
+/**
+ * @tc.name: WritePolicyByUid002
+ * @tc.desc: Test the uid edits written to the journal are read back by a new NetPolicyFile.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetPolicyFile, WritePolicyByUid002, TestSize.Level1)
+{
+    // A policy file write left by an earlier test would outdate the journal entries of this one
+    sleep(SLEEP_SECOND_TIME);
+    auto file = std::make_shared<NetPolicyFile>();
+    file->WritePolicyByUid(TEST_UID_BASE, NET_POLICY_REJECT_METERED_BACKGROUND);
+    sleep(FLUSH_WAIT_SECOND_TIME);
+    EXPECT_FALSE(file->flushScheduled_);
+    EXPECT_TRUE(file->journalLines_.empty());
+
+    auto reloaded = std::make_shared<NetPolicyFile>();
+    auto iter = reloaded->uidPolicyIndex_.find(TEST_UID_BASE);
+    ASSERT_NE(iter, reloaded->uidPolicyIndex_.end());
+    EXPECT_EQ(reloaded->ReadUidPolicies()[iter->second].policy, std::to_string(NET_POLICY_REJECT_METERED_BACKGROUND));
+
+    file->RemoveInexistentUid(TEST_UID_BASE);
+    sleep(FLUSH_WAIT_SECOND_TIME);
+    reloaded = std::make_shared<NetPolicyFile>();
+    EXPECT_EQ(reloaded->uidPolicyIndex_.count(TEST_UID_BASE), 0);
+}
+
+/**
+ * @tc.name: WritePolicyByUid003
+ * @tc.desc: Test a long run of uid edits is compacted into one policy file write.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetPolicyFile, WritePolicyByUid003, TestSize.Level1)
+{
+    auto file = std::make_shared<NetPolicyFile>();
+    for (uint32_t i = 0; i < BENCH_UID_NUM; ++i) {
+        file->WritePolicyByUid(TEST_UID_BASE + i, NET_POLICY_REJECT_METERED_BACKGROUND);
+    }
+    EXPECT_TRUE(file->snapshotDirty_);
+    file->FlushDirty();
+    EXPECT_FALSE(file->snapshotDirty_);
+    EXPECT_EQ(file->journalEntries_, 0);
+    EXPECT_TRUE(file->journalLines_.empty());
+    for (uint32_t i = 0; i < BENCH_UID_NUM; ++i) {
+        file->RemoveInexistentUid(TEST_UID_BASE + i);
+    }
+    ExpectIndexConsistent(file);
+}
+
+/**
+ * @tc.name: ReplayJournal001
+ * @tc.desc: Test journal entries older than the policy file are dropped on replay and newer ones are kept.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetPolicyFile, ReplayJournal001, TestSize.Level1)
+{
+    auto file = std::make_shared<NetPolicyFile>();
+    file->ClearPolicies();
+    file->netPolicy_.journalGeneration = 2;
+    std::string json;
+    ASSERT_TRUE(file->Obj2Json(file->netPolicy_, json));
+    NetPolicy netPolicy;
+    ASSERT_TRUE(file->Json2Obj(json, netPolicy));
+    EXPECT_EQ(netPolicy.journalGeneration, 2);
+
+    {
+        std::ofstream journal(POLICY_JOURNAL_NAME, std::ios::trunc);
+        ASSERT_TRUE(journal.is_open());
+        journal << "1 " << TEST_UID_BASE << " " << NET_POLICY_REJECT_METERED_BACKGROUND << "\n"
+                << "2 " << TEST_UID_BASE + 1 << " " << NET_POLICY_REJECT_METERED_BACKGROUND << "\n"
+                << "3 " << TEST_UID_BASE + 2 << " " << NET_POLICY_REJECT_METERED_BACKGROUND << "\n";
+    }
+    file->ReplayJournal();
+    remove(POLICY_JOURNAL_NAME);
+    EXPECT_EQ(file->uidPolicyIndex_.count(TEST_UID_BASE), 0);
+    EXPECT_EQ(file->uidPolicyIndex_.count(TEST_UID_BASE + 1), 1);
+    EXPECT_EQ(file->uidPolicyIndex_.count(TEST_UID_BASE + 2), 1);
+    EXPECT_EQ(file->journalEntries_, 2);
+    EXPECT_EQ(file->netPolicy_.journalGeneration, 3);
+    file->ClearPolicies();
+}
+
+/**
+ * @tc.name: WritePolicyByUidBenchmark001
+ * @tc.desc: Compare 3000 apps toggling background policy with serializing the policy on every change.
+ * @tc.type: PERF
+ */
+HWTEST_F(UtNetPolicyFile, WritePolicyByUidBenchmark001, TestSize.Level1)
+{
+    auto file = std::make_shared<NetPolicyFile>();
+    std::string json;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        for (uint32_t i = 0; i < BENCH_UID_NUM; ++i) {
+            file->UpdateUidPolicy(TEST_UID_BASE + i, GetTogglePolicy(round));
+            file->Obj2Json(file->netPolicy_, json);
+        }
+    }
+    double serializeEachMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round) {
+        for (uint32_t i = 0; i < BENCH_UID_NUM; ++i) {
+            file->WritePolicyByUid(TEST_UID_BASE + i, GetTogglePolicy(round + 1));
+        }
+    }
+    double writeBehindMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (uint32_t i = 0; i < BENCH_UID_NUM; ++i) {
+        file->RemoveInexistentUid(TEST_UID_BASE + i);
+    }
+    ExpectIndexConsistent(file);
+    std::cout << BENCH_UID_NUM << " uids x " << BENCH_ROUNDS << " toggles: serialize each change " << serializeEachMs
+              << " ms, write-behind " << writeBehindMs << " ms" << std::endl;
+}
 } // namespace NetManagerStandard
 } // namespace OHOS
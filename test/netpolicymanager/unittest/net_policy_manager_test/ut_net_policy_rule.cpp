@@ -13,6 +13,8 @@
  * limitations under the License.
  */
 
+#include <chrono>
+#include <iostream>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -36,6 +38,11 @@ constexpr int32_t WAIT_TIME_THIRTY_SECOND_LONG = 30;
 constexpr int32_t INVALID_VALUE = 100;
 constexpr uint32_t TEST_UID1 = 200;
 constexpr uint32_t TEST_UID2 = 13000;
+constexpr uint32_t BENCH_UID_BASE = 900000;
+constexpr uint32_t BENCH_APP_NUM = 2000;
+constexpr uint32_t BENCH_IDLE_ALLOWED_STEP = 9;
+// More than netsys takes in one BandwidthUpdateUidLists request
+constexpr uint32_t BATCH_UID_NUM = 16384 + 100;
 std::shared_ptr<NetPolicyRule> g_netPolicyRule = nullptr;
 std::shared_ptr<NetPolicyFirewall> g_netPolicyFirewallR = nullptr;
 } // namespace
@@ -74,6 +81,31 @@ sptr<NetPolicyCallbackTest> UtNetPolicyRule::GetINetPolicyCallbackSample() const
     return callbackR;
 }
 
+namespace {
+void AddBenchApps(NetPolicyRule &netPolicyRule)
+{
+    const std::vector<uint32_t> policies = {NET_POLICY_NONE, NET_POLICY_ALLOW_METERED_BACKGROUND,
+                                            NET_POLICY_REJECT_METERED_BACKGROUND};
+    for (uint32_t i = 0; i < BENCH_APP_NUM; ++i) {
+        netPolicyRule.uidPolicyRules_[BENCH_UID_BASE + i] = {.policy_ = policies[i % policies.size()]};
+    }
+    for (uint32_t i = 0; i < BENCH_APP_NUM; i += BENCH_IDLE_ALLOWED_STEP) {
+        netPolicyRule.deviceIdleAllowedList_.insert(BENCH_UID_BASE + i);
+    }
+}
+
+void RemoveBenchApps(NetPolicyRule &netPolicyRule)
+{
+    std::vector<uint32_t> uids;
+    for (const auto &[uid, policyRule] : netPolicyRule.uidPolicyRules_) {
+        uids.push_back(uid);
+        netPolicyRule.GetFileInst()->RemoveInexistentUid(uid);
+    }
+    netPolicyRule.GetNetsysInst()->BandwidthUpdateUidLists({}, {}, uids);
+    netPolicyRule.uidPolicyRules_.clear();
+}
+} // namespace
+
 /**
  * @tc.name: NetPolicyRule001
  * @tc.desc: Test NetPolicyRule TransPolicyToRule.
@@ -383,6 +415,97 @@ HWTEST_F(UtNetPolicyRule, ProcessCtrlAddAllowedList001, TestSize.Level1)
     EXPECT_EQ(netpolicyrule.powerSaveMode_, true);
 }
 
+/**
+ * @tc.name: CollectNetsysCtrl001
+ * @tc.desc: Test NetPolicyRule CollectNetsysCtrl sorts the uids the way NetsysCtrl applies them.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetPolicyRule, CollectNetsysCtrl001, TestSize.Level1)
+{
+    NetPolicyRule netpolicyrule;
+    NetsysCtrlBatch batch;
+    netpolicyrule.CollectNetsysCtrl(1, POLICY_TRANS_CTRL_NONE, batch);
+    netpolicyrule.CollectNetsysCtrl(2, POLICY_TRANS_CTRL_REMOVE_ALL, batch);
+    netpolicyrule.CollectNetsysCtrl(3, POLICY_TRANS_CTRL_ADD_DENIEDLIST, batch);
+    netpolicyrule.CollectNetsysCtrl(4, POLICY_TRANS_CTRL_ADD_ALLOWEDLIST, batch);
+    netpolicyrule.CollectNetsysCtrl(5, INVALID_VALUE, batch);
+    EXPECT_TRUE(batch.powerSaveDeniedUids.empty());
+    EXPECT_TRUE(batch.powerSaveAllowedUids.empty());
+    EXPECT_EQ(batch.removedUids, std::vector<uint32_t>{2});
+    EXPECT_EQ(batch.deniedUids, std::vector<uint32_t>{3});
+    EXPECT_EQ(batch.allowedUids, std::vector<uint32_t>{4});
+
+    netpolicyrule.powerSaveMode_ = true;
+    netpolicyrule.CollectNetsysCtrl(1, POLICY_TRANS_CTRL_NONE, batch);
+    netpolicyrule.CollectNetsysCtrl(4, POLICY_TRANS_CTRL_ADD_ALLOWEDLIST, batch);
+    EXPECT_EQ(batch.powerSaveDeniedUids, std::vector<uint32_t>{1});
+    EXPECT_EQ(batch.powerSaveAllowedUids, std::vector<uint32_t>{4});
+}
+
+/**
+ * @tc.name: ApplyNetsysCtrlBatch001
+ * @tc.desc: Test NetPolicyRule ApplyNetsysCtrlBatch splits a batch larger than one netsys request and records the
+ *           netsys control of the uids netsys took.
+ * @tc.type: FUNC
+ */
+HWTEST_F(UtNetPolicyRule, ApplyNetsysCtrlBatch001, TestSize.Level1)
+{
+    NetPolicyRule netpolicyrule;
+    NetsysCtrlBatch batch;
+    for (uint32_t i = 0; i < BATCH_UID_NUM; ++i) {
+        uint32_t uid = BENCH_UID_BASE + i;
+        netpolicyrule.uidPolicyRules_[uid] = {};
+        netpolicyrule.CollectNetsysCtrl(uid, POLICY_TRANS_CTRL_REMOVE_ALL, batch);
+        batch.changedNetsys.emplace_back(uid, POLICY_TRANS_CTRL_REMOVE_ALL);
+    }
+    netpolicyrule.ApplyNetsysCtrlBatch(batch);
+    uint32_t applied = 0;
+    for (const auto &[uid, policyRule] : netpolicyrule.uidPolicyRules_) {
+        applied += (policyRule.netsys_ == POLICY_TRANS_CTRL_REMOVE_ALL) ? 1 : 0;
+    }
+    EXPECT_EQ(applied, BATCH_UID_NUM);
+}
+
+/**
+ * @tc.name: TransPolicyToRuleBenchmark001
+ * @tc.desc: Enter device idle with 2000 apps, once uid by uid and once as one bulk update.
+ * @tc.type: PERF
+ */
+HWTEST_F(UtNetPolicyRule, TransPolicyToRuleBenchmark001, TestSize.Level1)
+{
+    NetPolicyRule perUid;
+    NetPolicyRule bulk;
+    AddBenchApps(perUid);
+    AddBenchApps(bulk);
+    perUid.deviceIdleMode_ = true;
+    bulk.deviceIdleMode_ = true;
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &[uid, policyRule] : perUid.uidPolicyRules_) {
+        perUid.TransConditionToRuleAndNetsys(uid, policyRule);
+    }
+    auto perUidMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    RemoveBenchApps(perUid);
+
+    start = std::chrono::steady_clock::now();
+    bulk.TransPolicyToRule();
+    auto bulkMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << BENCH_APP_NUM << " apps entering device idle: per uid " << perUidMs << " ms, bulk " << bulkMs
+              << " ms" << std::endl;
+
+    AddBenchApps(perUid);
+    perUid.deviceIdleMode_ = true;
+    for (auto &[uid, policyRule] : perUid.uidPolicyRules_) {
+        uint32_t netsys = 0;
+        uint32_t rule = perUid.TransConditionToRule(uid, policyRule, netsys);
+        const auto &bulkRule = bulk.uidPolicyRules_[uid];
+        EXPECT_EQ(bulkRule.rule_, rule);
+        EXPECT_EQ(bulkRule.netsys_, netsys);
+    }
+    perUid.uidPolicyRules_.clear();
+    RemoveBenchApps(bulk);
+}
+
 /**
  * @tc.name: GetUidsByPolicy001
  * @tc.desc: Test NetPolicyRule GetUidsByPolicy.
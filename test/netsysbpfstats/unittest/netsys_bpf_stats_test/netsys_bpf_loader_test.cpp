@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <elf.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bpf_def.h"
+#include "bpf_loader.h"
+#include "bpf_mapper.h"
+
+namespace OHOS {
+namespace NetManagerStandard {
+using namespace testing::ext;
+
+namespace {
+constexpr const char *SAMPLE_ELF_NAME = "netsys_loader_test.o";
+constexpr const char *SAMPLE_MAP_NAME = "loader_test_map";
+constexpr const char *SAMPLE_MAP_PATH = "/sys/fs/bpf/netsys/maps/loader_test_map";
+constexpr const char *SAMPLE_PROG_SECTION = "schedcls/loader_test_";
+constexpr const char *SAMPLE_PROG_PATH = "/sys/fs/bpf/netsys/progs/schedcls_loader_test_0";
+constexpr const char *SAMPLE_HASH_PATH = "/sys/fs/bpf/netsys/netsys_loader_test_o_hash";
+constexpr uint32_t SAMPLE_PROG_NUM = 8;
+constexpr uint32_t SAMPLE_PROG_INSN_NUM = 2000;
+constexpr uint32_t SAMPLE_MAP_ENTRIES = 16;
+constexpr uint32_t SAMPLE_VALUE_SIZE = sizeof(uint64_t);
+constexpr uint32_t CHANGED_VALUE_SIZE = 2 * sizeof(uint64_t);
+constexpr uint32_t ELF_ALIGN = 8;
+constexpr uint32_t MAP_RELOC_TYPE = 1;
+constexpr uint32_t TEST_KEY = 1;
+constexpr uint64_t TEST_VALUE = 0x1234;
+
+struct SampleSection {
+    std::string name;
+    Elf64_Word type;
+    Elf64_Xword flags;
+    std::vector<uint8_t> data;
+    Elf64_Word link = 0;
+    Elf64_Word info = 0;
+    Elf64_Xword entSize = 0;
+};
+
+template <typename T> void AppendBytes(std::vector<uint8_t> &out, const T &value)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+uint32_t AddString(std::vector<uint8_t> &table, const std::string &str)
+{
+    auto offset = static_cast<uint32_t>(table.size());
+    table.insert(table.end(), str.begin(), str.end());
+    table.push_back(0);
+    return offset;
+}
+
+bpf_insn MakeInsn(uint8_t code, uint8_t dst, int32_t imm)
+{
+    bpf_insn insn = {};
+    insn.code = code;
+    insn.dst_reg = dst;
+    insn.imm = imm;
+    return insn;
+}
+
+// r1 = loader_test_map; r0 = 0; r0 += seed, insnNum times; exit. Long enough for the verifier to take its time
+std::vector<uint8_t> MakeProgram(int32_t seed)
+{
+    std::vector<uint8_t> data;
+    AppendBytes(data, MakeInsn(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, 0));
+    AppendBytes(data, MakeInsn(0, 0, 0));
+    AppendBytes(data, MakeInsn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0));
+    for (uint32_t i = 0; i < SAMPLE_PROG_INSN_NUM; i++) {
+        AppendBytes(data, MakeInsn(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_0, seed));
+    }
+    AppendBytes(data, MakeInsn(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0));
+    AppendBytes(data, MakeInsn(BPF_JMP | BPF_EXIT, 0, 0));
+    return data;
+}
+
+std::vector<SampleSection> MakeSections(uint32_t valueSize, int32_t seed)
+{
+    enum { STRTAB_INDEX = 2, SYMTAB_INDEX = 3, MAPS_INDEX = 4, FIRST_PROG_INDEX = 6 };
+    std::vector<SampleSection> sections;
+    sections.push_back({"", SHT_NULL, 0, {}});
+    sections.push_back({".shstrtab", SHT_STRTAB, 0, {}});
+
+    std::vector<uint8_t> strtab = {0};
+    std::vector<uint8_t> symtab;
+    AppendBytes(symtab, Elf64_Sym{});
+    Elf64_Sym mapSym = {};
+    mapSym.st_name = AddString(strtab, SAMPLE_MAP_NAME);
+    mapSym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_OBJECT);
+    mapSym.st_shndx = MAPS_INDEX;
+    mapSym.st_size = sizeof(bpf_map_def);
+    AppendBytes(symtab, mapSym);
+    sections.push_back({".strtab", SHT_STRTAB, 0, strtab});
+    sections.push_back({".symtab", SHT_SYMTAB, 0, symtab, STRTAB_INDEX, 1, sizeof(Elf64_Sym)});
+
+    bpf_map_def def = {};
+    def.type = BPF_MAP_TYPE_HASH;
+    def.key_size = sizeof(uint32_t);
+    def.value_size = valueSize;
+    def.max_entries = SAMPLE_MAP_ENTRIES;
+    std::vector<uint8_t> maps;
+    AppendBytes(maps, def);
+    sections.push_back({"maps", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, maps});
+    const char license[] = "GPL";
+    sections.push_back({"license", SHT_PROGBITS, SHF_ALLOC, std::vector<uint8_t>(license, license + sizeof(license))});
+
+    for (uint32_t i = 0; i < SAMPLE_PROG_NUM; i++) {
+        sections.push_back({SAMPLE_PROG_SECTION + std::to_string(i), SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR,
+                            MakeProgram(seed)});
+    }
+    for (uint32_t i = 0; i < SAMPLE_PROG_NUM; i++) {
+        std::vector<uint8_t> rel;
+        Elf64_Rel entry = {0, ELF64_R_INFO(1, MAP_RELOC_TYPE)};
+        AppendBytes(rel, entry);
+        sections.push_back({std::string(".rel") + SAMPLE_PROG_SECTION + std::to_string(i), SHT_REL, 0, rel, SYMTAB_INDEX,
+                            FIRST_PROG_INDEX + i, sizeof(Elf64_Rel)});
+    }
+    return sections;
+}
+
+void Align(std::vector<uint8_t> &out)
+{
+    out.resize((out.size() + ELF_ALIGN - 1) / ELF_ALIGN * ELF_ALIGN, 0);
+}
+
+// A relocatable eBPF object laid out the way clang emits netsys.o: maps, license, program and relocation sections
+bool WriteSampleElf(const std::string &path, uint32_t valueSize, int32_t seed)
+{
+    auto sections = MakeSections(valueSize, seed);
+    std::vector<uint8_t> shstrtab = {0};
+    std::vector<Elf64_Shdr> headers(sections.size());
+    for (size_t i = 1; i < sections.size(); i++) {
+        headers[i].sh_name = AddString(shstrtab, sections[i].name);
+    }
+    sections[1].data = shstrtab;
+
+    std::vector<uint8_t> file(sizeof(Elf64_Ehdr), 0);
+    for (size_t i = 1; i < sections.size(); i++) {
+        Align(file);
+        headers[i].sh_type = sections[i].type;
+        headers[i].sh_flags = sections[i].flags;
+        headers[i].sh_offset = file.size();
+        headers[i].sh_size = sections[i].data.size();
+        headers[i].sh_link = sections[i].link;
+        headers[i].sh_info = sections[i].info;
+        headers[i].sh_addralign = ELF_ALIGN;
+        headers[i].sh_entsize = sections[i].entSize;
+        file.insert(file.end(), sections[i].data.begin(), sections[i].data.end());
+    }
+    Align(file);
+    Elf64_Ehdr ehdr = {};
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_REL;
+    ehdr.e_machine = EM_BPF;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_shoff = file.size();
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = static_cast<Elf64_Half>(sections.size());
+    ehdr.e_shstrndx = 1;
+    memcpy(file.data(), &ehdr, sizeof(ehdr));
+    for (const auto &header : headers) {
+        AppendBytes(file, header);
+    }
+
+    std::ofstream ofs(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+    return ofs.good();
+}
+
+int32_t BpfSyscall(int32_t cmd, bpf_attr &attr)
+{
+    return static_cast<int32_t>(syscall(__NR_bpf, cmd, &attr, sizeof(attr)));
+}
+
+template <typename Info> bool GetPinnedInfo(const char *path, Info &info)
+{
+    bpf_attr attr = {};
+    attr.pathname = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(path));
+    int32_t fd = BpfSyscall(BPF_OBJ_GET, attr);
+    if (fd < 0) {
+        return false;
+    }
+    attr = {};
+    attr.info.bpf_fd = static_cast<uint32_t>(fd);
+    attr.info.info_len = sizeof(info);
+    attr.info.info = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&info));
+    bool ret = BpfSyscall(BPF_OBJ_GET_INFO_BY_FD, attr) == 0;
+    close(fd);
+    return ret;
+}
+
+uint32_t GetPinnedProgId()
+{
+    bpf_prog_info info = {};
+    return GetPinnedInfo(SAMPLE_PROG_PATH, info) ? info.id : 0;
+}
+
+// The hash is recorded as the target of a symlink, which is dangling on purpose
+bool IsHashRecorded()
+{
+    struct stat st = {};
+    return lstat(SAMPLE_HASH_PATH, &st) == 0 && S_ISLNK(st.st_mode);
+}
+
+int64_t TimeLoadUs(const std::string &path, ElfLoadError &ret)
+{
+    auto start = std::chrono::steady_clock::now();
+    ret = LoadElf(path);
+    auto cost = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(cost).count();
+}
+} // namespace
+
+class NetsysBpfLoaderTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+
+    static void TearDownTestCase();
+
+    void SetUp();
+
+    void TearDown();
+
+protected:
+    bool IsBpfSupported() const
+    {
+        return getuid() == 0 && access("/sys/fs/bpf", F_OK) == 0;
+    }
+
+    std::string elfPath_;
+};
+
+void NetsysBpfLoaderTest::SetUpTestCase() {}
+
+void NetsysBpfLoaderTest::TearDownTestCase() {}
+
+void NetsysBpfLoaderTest::SetUp()
+{
+    elfPath_ = (std::filesystem::temp_directory_path() / SAMPLE_ELF_NAME).string();
+    if (IsBpfSupported() && WriteSampleElf(elfPath_, SAMPLE_VALUE_SIZE, 1)) {
+        UnloadElf(elfPath_);
+    }
+}
+
+void NetsysBpfLoaderTest::TearDown()
+{
+    if (IsBpfSupported()) {
+        UnloadElf(elfPath_);
+    }
+    unlink(elfPath_.c_str());
+}
+
+HWTEST_F(NetsysBpfLoaderTest, ColdAndWarmStartTest001, TestSize.Level1)
+{
+    if (!IsBpfSupported()) {
+        GTEST_SKIP() << "needs root and the bpf fs";
+    }
+    ElfLoadError ret = ELF_LOAD_ERR_NONE;
+    int64_t coldUs = TimeLoadUs(elfPath_, ret);
+    ASSERT_EQ(ret, ELF_LOAD_ERR_NONE);
+    uint32_t coldProgId = GetPinnedProgId();
+    EXPECT_NE(coldProgId, 0);
+    EXPECT_TRUE(IsHashRecorded());
+    BpfMapper<uint32_t, uint64_t> map(SAMPLE_MAP_PATH, BPF_ANY);
+    ASSERT_TRUE(map.IsValid());
+    EXPECT_EQ(map.Write(TEST_KEY, TEST_VALUE, BPF_ANY), 0);
+
+    // A daemon restart with the same object reuses what is pinned
+    int64_t warmUs = TimeLoadUs(elfPath_, ret);
+    ASSERT_EQ(ret, ELF_LOAD_ERR_NONE);
+    EXPECT_EQ(GetPinnedProgId(), coldProgId);
+    uint64_t value = 0;
+    EXPECT_EQ(map.Read(TEST_KEY, value), 0);
+    EXPECT_EQ(value, TEST_VALUE);
+
+    // The timings are reported only, they depend too much on the host to be asserted on
+    RecordProperty("coldStartUs", std::to_string(coldUs));
+    RecordProperty("warmStartUs", std::to_string(warmUs));
+}
+
+HWTEST_F(NetsysBpfLoaderTest, ChangedObjectTest001, TestSize.Level1)
+{
+    if (!IsBpfSupported()) {
+        GTEST_SKIP() << "needs root and the bpf fs";
+    }
+    ASSERT_EQ(LoadElf(elfPath_), ELF_LOAD_ERR_NONE);
+    uint32_t oldProgId = GetPinnedProgId();
+    BpfMapper<uint32_t, uint64_t> map(SAMPLE_MAP_PATH, BPF_ANY);
+    ASSERT_TRUE(map.IsValid());
+    EXPECT_EQ(map.Write(TEST_KEY, TEST_VALUE, BPF_ANY), 0);
+
+    // Changed programs are loaded again, the map keeps its entries
+    ASSERT_TRUE(WriteSampleElf(elfPath_, SAMPLE_VALUE_SIZE, 2));
+    ASSERT_EQ(LoadElf(elfPath_), ELF_LOAD_ERR_NONE);
+    EXPECT_NE(GetPinnedProgId(), oldProgId);
+    uint64_t value = 0;
+    EXPECT_EQ(map.Read(TEST_KEY, value), 0);
+    EXPECT_EQ(value, TEST_VALUE);
+
+    // A map whose layout changed is created again
+    ASSERT_TRUE(WriteSampleElf(elfPath_, CHANGED_VALUE_SIZE, 2));
+    ASSERT_EQ(LoadElf(elfPath_), ELF_LOAD_ERR_NONE);
+    bpf_map_info info = {};
+    ASSERT_TRUE(GetPinnedInfo(SAMPLE_MAP_PATH, info));
+    EXPECT_EQ(info.value_size, CHANGED_VALUE_SIZE);
+
+    EXPECT_EQ(UnloadElf(elfPath_), ELF_LOAD_ERR_NONE);
+    EXPECT_FALSE(IsHashRecorded());
+    EXPECT_NE(access(SAMPLE_PROG_PATH, F_OK), 0);
+    EXPECT_NE(access(SAMPLE_MAP_PATH, F_OK), 0);
+}
+} // namespace NetManagerStandard
+} // namespace OHOS
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <linux/bpf.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#ifdef GTEST_API_
+#define private public
+#define protected public
+#endif
+
+#include "bpf_ring_buffer_consumer.h"
+#include "net_manager_constants.h"
+
+namespace OHOS {
+namespace NetManagerStandard {
+using namespace testing::ext;
+
+namespace {
+constexpr const char *TEST_RING_BUFFER_PATH = "/sys/fs/bpf/netsys_consumer_test_ringbuf";
+constexpr const char *TEST_RING_BUFFER_NAME = "stressTest";
+constexpr uint32_t TEST_RING_BUFFER_SIZE = 64 * 1024;
+constexpr size_t TEST_QUEUE_CAPACITY = 512;
+constexpr uint32_t PRODUCE_ROUNDS = 100;
+constexpr uint32_t RECORDS_PER_ROUND = 500;
+constexpr int32_t PRODUCE_INTERVAL_US = 500;
+// More than the ring holds, so both the ring and the handler queue overflow
+constexpr uint32_t BURST_RECORDS = 8000;
+constexpr uint32_t TEST_PACKET_SIZE = 64;
+constexpr int32_t DRAIN_TIMEOUT_MS = 5000;
+constexpr int32_t DRAIN_POLL_MS = 10;
+constexpr int32_t SLOW_HANDLER_US = 200;
+constexpr char BPF_LICENSE[] = "GPL";
+
+int32_t BpfSyscall(int32_t cmd, bpf_attr &attr)
+{
+    return static_cast<int32_t>(syscall(__NR_bpf, cmd, &attr, sizeof(attr)));
+}
+
+int32_t CreateMap(uint32_t type, uint32_t keySize, uint32_t valueSize, uint32_t maxEntries)
+{
+    bpf_attr attr = {};
+    attr.map_type = type;
+    attr.key_size = keySize;
+    attr.value_size = valueSize;
+    attr.max_entries = maxEntries;
+    return BpfSyscall(BPF_MAP_CREATE, attr);
+}
+
+bpf_insn MakeInsn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+{
+    bpf_insn insn = {};
+    insn.code = code;
+    insn.dst_reg = dst;
+    insn.src_reg = src;
+    insn.off = off;
+    insn.imm = imm;
+    return insn;
+}
+
+/*
+ * Socket filter that writes bpf_ktime_get_ns() to the ring and counts the records the ring had no room for:
+ *     *(u64 *)(r10 - 8) = bpf_ktime_get_ns();
+ *     if (bpf_ringbuf_output(ringbuf, r10 - 8, 8, 0) != 0) {
+ *         *(u32 *)(r10 - 12) = 0;
+ *         r0 = bpf_map_lookup_elem(drops, r10 - 12);
+ *         if (r0 != 0) lock *(u64 *)(r0 + 0) += 1;
+ *     }
+ *     return 0;
+ */
+int32_t LoadProducer(int32_t ringFd, int32_t dropFd)
+{
+    const uint8_t r0 = 0;
+    const uint8_t r1 = 1;
+    const uint8_t r2 = 2;
+    const uint8_t r3 = 3;
+    const uint8_t r4 = 4;
+    const uint8_t r10 = 10;
+    std::vector<bpf_insn> insns = {
+        MakeInsn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_ktime_get_ns),
+        MakeInsn(BPF_STX | BPF_MEM | BPF_DW, r10, r0, -8, 0),
+        MakeInsn(BPF_LD | BPF_DW | BPF_IMM, r1, BPF_PSEUDO_MAP_FD, 0, ringFd),
+        MakeInsn(0, 0, 0, 0, 0),
+        MakeInsn(BPF_ALU64 | BPF_MOV | BPF_X, r2, r10, 0, 0),
+        MakeInsn(BPF_ALU64 | BPF_ADD | BPF_K, r2, 0, 0, -8),
+        MakeInsn(BPF_ALU64 | BPF_MOV | BPF_K, r3, 0, 0, sizeof(uint64_t)),
+        MakeInsn(BPF_ALU64 | BPF_MOV | BPF_K, r4, 0, 0, 0),
+        MakeInsn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_ringbuf_output),
+        MakeInsn(BPF_JMP | BPF_JEQ | BPF_K, r0, 0, 9, 0),
+        MakeInsn(BPF_ST | BPF_MEM | BPF_W, r10, 0, -12, 0),
+        MakeInsn(BPF_LD | BPF_DW | BPF_IMM, r1, BPF_PSEUDO_MAP_FD, 0, dropFd),
+        MakeInsn(0, 0, 0, 0, 0),
+        MakeInsn(BPF_ALU64 | BPF_MOV | BPF_X, r2, r10, 0, 0),
+        MakeInsn(BPF_ALU64 | BPF_ADD | BPF_K, r2, 0, 0, -12),
+        MakeInsn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem),
+        MakeInsn(BPF_JMP | BPF_JEQ | BPF_K, r0, 0, 2, 0),
+        MakeInsn(BPF_ALU64 | BPF_MOV | BPF_K, r1, 0, 0, 1),
+        MakeInsn(BPF_STX | BPF_XADD | BPF_DW, r0, r1, 0, 0),
+        MakeInsn(BPF_ALU64 | BPF_MOV | BPF_K, r0, 0, 0, 0),
+        MakeInsn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+    };
+    bpf_attr attr = {};
+    attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+    attr.insns = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(insns.data()));
+    attr.insn_cnt = static_cast<uint32_t>(insns.size());
+    attr.license = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(BPF_LICENSE));
+    return BpfSyscall(BPF_PROG_LOAD, attr);
+}
+
+bool RunProducer(int32_t progFd, uint32_t repeat)
+{
+    std::vector<uint8_t> packet(TEST_PACKET_SIZE, 0);
+    bpf_attr attr = {};
+    attr.test.prog_fd = static_cast<uint32_t>(progFd);
+    attr.test.data_in = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(packet.data()));
+    attr.test.data_size_in = static_cast<uint32_t>(packet.size());
+    attr.test.repeat = repeat;
+    return BpfSyscall(BPF_PROG_TEST_RUN, attr) == 0;
+}
+
+uint64_t ReadDrops(int32_t dropFd)
+{
+    uint32_t key = 0;
+    uint64_t value = 0;
+    bpf_attr attr = {};
+    attr.map_fd = static_cast<uint32_t>(dropFd);
+    attr.key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&key));
+    attr.value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&value));
+    return BpfSyscall(BPF_MAP_LOOKUP_ELEM, attr) == 0 ? value : 0;
+}
+
+bool PinObject(int32_t fd, const char *path)
+{
+    unlink(path);
+    bpf_attr attr = {};
+    attr.bpf_fd = static_cast<uint32_t>(fd);
+    attr.pathname = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(path));
+    return BpfSyscall(BPF_OBJ_PIN, attr) == 0;
+}
+} // namespace
+
+class NetsysBpfRingBufferConsumerTest : public testing::Test {
+public:
+    static void SetUpTestCase();
+
+    static void TearDownTestCase();
+
+    void SetUp();
+
+    void TearDown();
+
+protected:
+    int32_t ringFd_ = -1;
+    int32_t dropFd_ = -1;
+    int32_t progFd_ = -1;
+};
+
+void NetsysBpfRingBufferConsumerTest::SetUpTestCase() {}
+
+void NetsysBpfRingBufferConsumerTest::TearDownTestCase() {}
+
+void NetsysBpfRingBufferConsumerTest::SetUp()
+{
+    ringFd_ = CreateMap(BPF_MAP_TYPE_RINGBUF, 0, 0, TEST_RING_BUFFER_SIZE);
+    dropFd_ = CreateMap(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), sizeof(uint64_t), 1);
+    if (ringFd_ >= 0 && dropFd_ >= 0 && PinObject(ringFd_, TEST_RING_BUFFER_PATH)) {
+        progFd_ = LoadProducer(ringFd_, dropFd_);
+    }
+}
+
+void NetsysBpfRingBufferConsumerTest::TearDown()
+{
+    unlink(TEST_RING_BUFFER_PATH);
+    for (int32_t fd : {ringFd_, dropFd_, progFd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+HWTEST_F(NetsysBpfRingBufferConsumerTest, AddRingBufferTest001, TestSize.Level1)
+{
+    NetsysBpfRingBufferConsumer consumer;
+    auto handler = [](const std::vector<RingBufferRecord> &batch) {};
+    EXPECT_EQ(consumer.AddRingBuffer("missing", "/sys/fs/bpf/netsys_consumer_test_missing", handler, 1),
+              NETMANAGER_ERROR);
+    EXPECT_EQ(consumer.Start(), NETMANAGER_ERROR);
+    RingBufferStats stats;
+    EXPECT_FALSE(consumer.GetStats("missing", stats));
+    if (progFd_ < 0) {
+        return;
+    }
+    EXPECT_EQ(consumer.AddRingBuffer(TEST_RING_BUFFER_NAME, TEST_RING_BUFFER_PATH, handler, 1), NETMANAGER_SUCCESS);
+    EXPECT_EQ(consumer.AddRingBuffer(TEST_RING_BUFFER_NAME, TEST_RING_BUFFER_PATH, handler, 1), NETMANAGER_SUCCESS);
+    EXPECT_EQ(consumer.sources_.size(), 1);
+    EXPECT_TRUE(consumer.GetStats(TEST_RING_BUFFER_NAME, stats));
+    std::string info;
+    consumer.GetDumpInfo(info);
+    EXPECT_NE(info.find(TEST_RING_BUFFER_NAME), std::string::npos);
+}
+
+HWTEST_F(NetsysBpfRingBufferConsumerTest, StressTest001, TestSize.Level1)
+{
+    if (progFd_ < 0) {
+        return;
+    }
+    NetsysBpfRingBufferConsumer consumer;
+    std::atomic<uint64_t> handled = 0;
+    std::atomic<uint64_t> outOfOrder = 0;
+    uint64_t lastTimestamp = 0;
+    // Slow on purpose so that records pile up behind it and the queue overflows
+    auto handler = [&](const std::vector<RingBufferRecord> &batch) {
+        for (const auto &record : batch) {
+            uint64_t timestamp = 0;
+            ASSERT_EQ(record.size(), sizeof(timestamp));
+            memcpy(&timestamp, record.data(), sizeof(timestamp));
+            outOfOrder += timestamp < lastTimestamp ? 1 : 0;
+            lastTimestamp = timestamp;
+        }
+        handled += batch.size();
+        std::this_thread::sleep_for(std::chrono::microseconds(SLOW_HANDLER_US));
+    };
+    ASSERT_EQ(consumer.AddRingBuffer(TEST_RING_BUFFER_NAME, TEST_RING_BUFFER_PATH, handler, TEST_QUEUE_CAPACITY),
+              NETMANAGER_SUCCESS);
+    ASSERT_EQ(consumer.Start(), NETMANAGER_SUCCESS);
+    for (uint32_t i = 0; i < PRODUCE_ROUNDS; i++) {
+        ASSERT_TRUE(RunProducer(progFd_, RECORDS_PER_ROUND));
+        std::this_thread::sleep_for(std::chrono::microseconds(PRODUCE_INTERVAL_US));
+    }
+    ASSERT_TRUE(RunProducer(progFd_, BURST_RECORDS));
+    uint64_t produced = static_cast<uint64_t>(PRODUCE_ROUNDS) * RECORDS_PER_ROUND + BURST_RECORDS;
+    uint64_t kernelDrops = ReadDrops(dropFd_);
+
+    RingBufferStats stats;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DRAIN_TIMEOUT_MS);
+    while (std::chrono::steady_clock::now() < deadline) {
+        ASSERT_TRUE(consumer.GetStats(TEST_RING_BUFFER_NAME, stats));
+        if (stats.received + kernelDrops == produced && stats.dispatched + stats.dropped == stats.received) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_POLL_MS));
+    }
+    consumer.Stop();
+
+    EXPECT_EQ(stats.received + kernelDrops, produced);
+    EXPECT_EQ(stats.dispatched + stats.dropped, stats.received);
+    EXPECT_EQ(stats.pending, 0);
+    EXPECT_EQ(handled.load(), stats.dispatched);
+    EXPECT_EQ(outOfOrder.load(), 0);
+    EXPECT_GT(stats.dispatched, 0);
+    EXPECT_LT(stats.batches, stats.dispatched);
+    EXPECT_GE(stats.maxLagUs, stats.lastLagUs);
+}
+
+HWTEST_F(NetsysBpfRingBufferConsumerTest, RemoveRingBufferTest001, TestSize.Level1)
+{
+    if (progFd_ < 0) {
+        return;
+    }
+    NetsysBpfRingBufferConsumer consumer;
+    std::atomic<uint64_t> handled = 0;
+    auto handler = [&handled](const std::vector<RingBufferRecord> &batch) { handled += batch.size(); };
+    ASSERT_EQ(consumer.AddRingBuffer(TEST_RING_BUFFER_NAME, TEST_RING_BUFFER_PATH, handler, TEST_QUEUE_CAPACITY),
+              NETMANAGER_SUCCESS);
+    ASSERT_EQ(consumer.Start(), NETMANAGER_SUCCESS);
+    consumer.RemoveRingBuffer(TEST_RING_BUFFER_NAME);
+    EXPECT_EQ(consumer.ringBuffer_, nullptr);
+    ASSERT_TRUE(RunProducer(progFd_, RECORDS_PER_ROUND));
+    std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_POLL_MS * DRAIN_POLL_MS));
+
+    RingBufferStats stats;
+    EXPECT_FALSE(consumer.GetStats(TEST_RING_BUFFER_NAME, stats));
+    EXPECT_EQ(handled.load(), 0);
+
+    // What the ring got while it was removed is read once it is added again
+    ASSERT_EQ(consumer.AddRingBuffer(TEST_RING_BUFFER_NAME, TEST_RING_BUFFER_PATH, handler, TEST_QUEUE_CAPACITY),
+              NETMANAGER_SUCCESS);
+    ASSERT_EQ(consumer.Start(), NETMANAGER_SUCCESS);
+    ASSERT_TRUE(RunProducer(progFd_, 1));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DRAIN_TIMEOUT_MS);
+    while (handled.load() < RECORDS_PER_ROUND + 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_POLL_MS));
+    }
+    consumer.Stop();
+    EXPECT_EQ(handled.load(), RECORDS_PER_ROUND + 1 - ReadDrops(dropFd_));
+}
+} // namespace NetManagerStandard
+} // namespace OHOS
@@ -113,12 +113,54 @@ HWTEST_F(NetsysBpfRingBufferTest, HandleNetStatsEventCallbackTest001, TestSize.L
     EXPECT_EQ(bpfringbuffer->HandleNetStatsEventCallback(ctx, data, dataSize), 1);
 }
 
-HWTEST_F(NetsysBpfRingBufferTest, ListenNetStatsRingBufferThreadTest001, TestSize.Level1)
+HWTEST_F(NetsysBpfRingBufferTest, HandleBandwidthLimitEventTest001, TestSize.Level1)
 {
-    std::unique_ptr<NetsysBpfRingBuffer> bpfringbuffer = std::make_unique<NetsysBpfRingBuffer>();
-    bpfringbuffer->existNetStatsThread_ = false;
-    bpfringbuffer->ListenNetStatsRingBufferThread();
-    EXPECT_NE(bpfringbuffer, nullptr);
+    std::vector<std::pair<std::string, std::string>> limits;
+    NetsysBpfRingBuffer::SetBandwidthLimitHandler([&limits](const std::string &limitName, const std::string &iface) {
+        limits.emplace_back(limitName, iface);
+    });
+    uint32_t loIndex = if_nametoindex("lo");
+    bandwidth_limit_event event = {{loIndex, BANDWIDTH_LIMIT_QUOTA}, loIndex};
+    EXPECT_EQ(NetsysBpfRingBuffer::HandleNetStatsEventCallback(nullptr, &event, sizeof(event)), 0);
+    event.limit = {BANDWIDTH_GLOBAL_IFINDEX, BANDWIDTH_LIMIT_ALERT};
+    EXPECT_EQ(NetsysBpfRingBuffer::HandleNetStatsEventCallback(nullptr, &event, sizeof(event)), 0);
+    event.limit = {loIndex, BANDWIDTH_LIMIT_ALERT};
+    EXPECT_EQ(NetsysBpfRingBuffer::HandleNetStatsEventCallback(nullptr, &event, sizeof(event)), 0);
+    event.ifIndex = UINT32_MAX;
+    EXPECT_EQ(NetsysBpfRingBuffer::HandleNetStatsEventCallback(nullptr, &event, sizeof(event)), 0);
+    NetsysBpfRingBuffer::SetBandwidthLimitHandler(nullptr);
+
+    std::vector<std::pair<std::string, std::string>> expected = {
+        {"lo", "lo"}, {"globalAlert", "lo"}, {"loAlert", "lo"}};
+    EXPECT_EQ(limits, expected);
+}
+
+HWTEST_F(NetsysBpfRingBufferTest, HandleNetStatsEventsTest001, TestSize.Level1)
+{
+    std::vector<std::pair<std::string, std::string>> limits;
+    NetsysBpfRingBuffer::SetBandwidthLimitHandler([&limits](const std::string &limitName, const std::string &iface) {
+        limits.emplace_back(limitName, iface);
+    });
+    uint32_t loIndex = if_nametoindex("lo");
+    bandwidth_limit_event event = {{loIndex, BANDWIDTH_LIMIT_QUOTA}, loIndex};
+    auto eventBytes = reinterpret_cast<const uint8_t *>(&event);
+    std::vector<RingBufferRecord> batch = {{1}, {1}, RingBufferRecord(eventBytes, eventBytes + sizeof(event)), {}};
+    NetsysBpfRingBuffer::HandleNetStatsEvents(batch);
+    NetsysBpfRingBuffer::SetBandwidthLimitHandler(nullptr);
+
+    std::vector<std::pair<std::string, std::string>> expected = {{"lo", "lo"}};
+    EXPECT_EQ(limits, expected);
+}
+
+HWTEST_F(NetsysBpfRingBufferTest, ListenNetworkStatsEventTest001, TestSize.Level1)
+{
+    NetsysBpfRingBuffer::ListenNetworkStatsEvent();
+    NetsysBpfRingBuffer::ExistNetstatsRingBufferPoll();
+    RingBufferStats stats;
+    if (NetsysBpfRingBufferConsumer::GetInstance().GetStats("netStats", stats)) {
+        EXPECT_EQ(stats.pending, 0);
+    }
+    NetsysBpfRingBufferConsumer::GetInstance().Stop();
 }
 } // namespace NetManagerStandard
 } // namespace OHOS
\ No newline at end of file
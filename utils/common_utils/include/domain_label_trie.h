@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2025 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NETMANAGER_BASE_DOMAIN_LABEL_TRIE_H
+#define NETMANAGER_BASE_DOMAIN_LABEL_TRIE_H
+
+#include <cctype>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS::NetManagerStandard {
+/**
+ * @brief Domain rules keyed by label, from the top level domain down
+ *
+ * Every node is one label, so a lookup costs one hash probe per label of the queried
+ * name whatever the number of rules. A node holds an exact value, for the name itself,
+ * and a wildcard value, for every name below it. Labels are compared case-insensitively
+ * and may hold any byte but the dot.
+ *
+ * @tparam T value type of a rule slot
+ */
+template <class T> class DomainLabelTrie {
+public:
+    DomainLabelTrie() : nodes_(1) {}
+
+    /**
+     * @brief Get the value of a rule slot, created empty on first use
+     *
+     * @param domain "example.com", "*.example.com", or "*" for every name
+     * @param isWildcard the rule covers the names below domain rather than domain itself,
+     *        implied by a leading "*."
+     * @return the slot, or nullptr if domain is not a valid name
+     */
+    T *Emplace(const std::string &domain, bool isWildcard)
+    {
+        std::string name = domain;
+        if (name == "*") {
+            name.clear();
+            isWildcard = true;
+        } else if (name.size() > WILDCARD_PREFIX_LEN && name.compare(0, WILDCARD_PREFIX_LEN, "*.") == 0) {
+            name.erase(0, WILDCARD_PREFIX_LEN);
+            isWildcard = true;
+        }
+        if (!name.empty() && name.back() == '.') {
+            name.pop_back();
+        }
+        if (name.empty() && !isWildcard) {
+            return nullptr;
+        }
+        uint32_t index = 0;
+        std::string label;
+        size_t end = name.size();
+        while (!name.empty()) {
+            size_t dot = end == 0 ? std::string::npos : name.rfind('.', end - 1);
+            size_t start = dot == std::string::npos ? 0 : dot + 1;
+            if (start == end) {
+                return nullptr;
+            }
+            ToLowerLabel(name, start, end, label);
+            auto child = nodes_[index].children.find(label);
+            if (child == nodes_[index].children.end()) {
+                nodes_[index].children.emplace(label, static_cast<uint32_t>(nodes_.size()));
+                index = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+            } else {
+                index = child->second;
+            }
+            if (dot == std::string::npos) {
+                break;
+            }
+            end = dot;
+        }
+        std::optional<T> &slot = isWildcard ? nodes_[index].wildcard : nodes_[index].exact;
+        if (!slot.has_value()) {
+            slot.emplace();
+            ++size_;
+        }
+        return &slot.value();
+    }
+
+    /**
+     * @brief Visit the rules covering hostName
+     *
+     * @param hostName queried name, a trailing dot is ignored
+     * @param visit called as visit(const T &value, bool isWildcard) for every wildcard slot above
+     *        hostName, then for the exact slot of hostName
+     */
+    template <class Visitor> void Match(const std::string &hostName, Visitor &&visit) const
+    {
+        size_t end = hostName.size();
+        if (end > 0 && hostName[end - 1] == '.') {
+            --end;
+        }
+        if (end == 0) {
+            return;
+        }
+        uint32_t index = 0;
+        std::string label;
+        while (true) {
+            const Node &node = nodes_[index];
+            if (node.wildcard.has_value()) {
+                visit(node.wildcard.value(), true);
+            }
+            size_t dot = end == 0 ? std::string::npos : hostName.rfind('.', end - 1);
+            size_t start = dot == std::string::npos ? 0 : dot + 1;
+            if (start == end) {
+                return;
+            }
+            ToLowerLabel(hostName, start, end, label);
+            auto child = node.children.find(label);
+            if (child == node.children.end()) {
+                return;
+            }
+            index = child->second;
+            if (dot == std::string::npos) {
+                break;
+            }
+            end = dot;
+        }
+        if (nodes_[index].exact.has_value()) {
+            visit(nodes_[index].exact.value(), false);
+        }
+    }
+
+    /**
+     * @brief Number of rule slots in use
+     */
+    size_t Size() const
+    {
+        return size_;
+    }
+
+    bool Empty() const
+    {
+        return size_ == 0;
+    }
+
+private:
+    static constexpr size_t WILDCARD_PREFIX_LEN = 2;
+
+    struct Node {
+        std::optional<T> exact;
+        std::optional<T> wildcard;
+        std::unordered_map<std::string, uint32_t> children;
+    };
+
+    static void ToLowerLabel(const std::string &name, size_t start, size_t end, std::string &label)
+    {
+        label.assign(name, start, end - start);
+        for (char &c : label) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+    }
+
+    // Children refer to nodes by index, so growing the vector never invalidates the links
+    std::vector<Node> nodes_;
+    size_t size_ = 0;
+};
+} // namespace OHOS::NetManagerStandard
+#endif // NETMANAGER_BASE_DOMAIN_LABEL_TRIE_H
@@ -20,8 +20,8 @@
 #include <charconv>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <netinet/in.h>
-#include <regex>
 #include <signal.h>
 #include <sstream>
 #include <set>
@@ -32,7 +32,6 @@
 #include <type_traits>
 #include <unistd.h>
 #include <vector>
-#include <numeric>
 #include <fstream>
 #include <random>
 #include <arpa/inet.h>
@@ -78,22 +77,22 @@ constexpr const char *IPADDR_DELIMITER = ".";
 constexpr const char *IP6ADDR_DELIMITER = ":";
 constexpr const char *CMD_SEP = " ";
 constexpr const char *DOMAIN_DELIMITER = ".";
-constexpr const char *TLDS_SPLIT_SYMBOL = "|";
-constexpr const char *HOST_DOMAIN_PATTERN_HEADER = "^(https?://)?[a-zA-Z0-9-]+(\\.[a-zA-Z0-9-]+)*\\.(";
-constexpr const char *HOST_DOMAIN_PATTERN_TAIL = ")$";
+constexpr const char *HOST_DOMAIN_SCHEMES[] = {"https://", "http://"};
 constexpr const char *DEFAULT_IPV4_ANY_INIT_ADDR = "0.0.0.0";
 constexpr const char *DEFAULT_IPV6_ANY_INIT_ADDR = "::";
 const std::string DISPLAY_TRAFFIC_ANCO_LIST = "const.netmanager.display_traffic_anco_list";
-const std::regex IP_PATTERN{
-    "((2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)\\.){3}(2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)"};
-
-const std::regex IP_MASK_PATTERN{
-    "((2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)\\.){3}(2([0-4]\\d|5[0-5])|1\\d\\d|[1-9]\\d|\\d)/"
-    "(3[0-2]|[1-2]\\d|\\d)"};
-
-const std::regex IPV6_PATTERN{"([\\da-fA-F]{0,4}:){2,7}([\\da-fA-F]{0,4})"};
-
-const std::regex IPV6_MASK_PATTERN{"([\\da-fA-F]{0,4}:){2,7}([\\da-fA-F]{0,4})/(1[0-2][0-8]|[1-9]\\d|[1-9])"};
+constexpr size_t IPV4_OCTET_MAX_DIGITS = 3;
+constexpr size_t IPV4_MASK_MAX_DIGITS = 2;
+constexpr size_t IPV6_GROUP_MAX_DIGITS = 4;
+constexpr size_t IPV6_PREFIX_MAX_DIGITS = 3;
+constexpr int32_t IPV6_MIN_COLON_NUM = 2;
+constexpr int32_t IPV6_MAX_COLON_NUM = 7;
+constexpr int32_t DECIMAL_BASE = 10;
+constexpr char IPV4_DELIMITER_CHAR = '.';
+constexpr char IPV6_DELIMITER_CHAR = ':';
+constexpr char PREFIX_DELIMITER_CHAR = '/';
+constexpr const char *IPV4_ANONYMOUS_TEXT = "X.X.X.X";
+constexpr const char *IPV6_ANONYMOUS_TEXT = "X:X:X:X";
 
 std::vector<std::string> HOST_DOMAIN_TLDS{"com",  "net",     "org",    "edu",  "gov", "mil",  "cn",   "hk",  "tw",
                                           "jp",   "de",      "uk",     "fr",   "au",  "ca",   "br",   "ru",  "it",
@@ -104,7 +103,6 @@ constexpr const char *SIM_APP_BUNDLENAMES = "com.droi.iapps,com.droi.tong";
 constexpr const char *INSTALL_SOURCE_FROM_SIM = "com.zhuoyi.appstore.lite";
 constexpr const char *SIM2_BUNDLENAMES = "com.easy.abroadHarmony.temp,com.easy.hmos.abroad";
 constexpr const char *INSTALL_SOURCE_FROM_SIM2 = "com.easy.abroad";
-std::mutex g_commonUtilsMutex;
 
 // IPv6 related constants to avoid magic numbers
 constexpr uint8_t IPV6_LOOPBACK_BYTES[BYTE_16] = {
@@ -450,16 +448,155 @@ std::string MaskIpv6(std::string &maskedResult, bool maskMiddle)
     return maskedResult;
 }
 
+static inline bool IsDecDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+static inline bool IsHexDigit(char ch)
+{
+    return IsDecDigit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+static size_t DecRunLength(const std::string &str, size_t pos, size_t limit)
+{
+    size_t len = 0;
+    while (len < limit && pos + len < str.size() && IsDecDigit(str[pos + len])) {
+        ++len;
+    }
+    return len;
+}
+
+static size_t HexRunLength(const std::string &str, size_t pos, size_t limit)
+{
+    size_t len = 0;
+    while (len < limit && pos + len < str.size() && IsHexDigit(str[pos + len])) {
+        ++len;
+    }
+    return len;
+}
+
+// Decimal number in [0, maxValue] without leading zero, digits must already be checked
+static bool IsDecNumber(const char *str, size_t len, int32_t maxValue)
+{
+    if (len == 0 || (len > 1 && str[0] == '0')) {
+        return false;
+    }
+    int32_t value = 0;
+    for (size_t i = 0; i < len; ++i) {
+        value = value * DECIMAL_BASE + (str[i] - '0');
+    }
+    return value <= maxValue;
+}
+
+/*
+ * Length of the IPv4 literal starting at pos, 0 if there is none. Four dotted octets in [0, 255] without leading
+ * zero; like the former regex search the last octet takes the longest valid prefix of the digits that follow.
+ */
+static size_t MatchIpv4At(const std::string &str, size_t pos)
+{
+    size_t cur = pos;
+    for (uint32_t dot = 0; dot < IPV4_DOT_NUM; ++dot) {
+        size_t len = DecRunLength(str, cur, IPV4_OCTET_MAX_DIGITS + 1);
+        if (cur + len >= str.size() || str[cur + len] != IPV4_DELIMITER_CHAR ||
+            len > IPV4_OCTET_MAX_DIGITS || !IsDecNumber(str.data() + cur, len, MAX_BYTE)) {
+            return 0;
+        }
+        cur += len + 1;
+    }
+    for (size_t len = DecRunLength(str, cur, IPV4_OCTET_MAX_DIGITS); len > 0; --len) {
+        if (IsDecNumber(str.data() + cur, len, MAX_BYTE)) {
+            return cur + len - pos;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Length of the IPv6 literal starting at pos, 0 if there is none. Two to seven groups of up to four hex digits
+ * each followed by ':', then up to four more hex digits. Groups may be empty, so "::" alone is accepted.
+ */
+static size_t MatchIpv6At(const std::string &str, size_t pos)
+{
+    size_t cur = pos;
+    int32_t colons = 0;
+    while (colons < IPV6_MAX_COLON_NUM) {
+        size_t len = HexRunLength(str, cur, IPV6_GROUP_MAX_DIGITS + 1);
+        if (len > IPV6_GROUP_MAX_DIGITS || cur + len >= str.size() || str[cur + len] != IPV6_DELIMITER_CHAR) {
+            break;
+        }
+        cur += len + 1;
+        ++colons;
+    }
+    if (colons < IPV6_MIN_COLON_NUM) {
+        return 0;
+    }
+    return cur + HexRunLength(str, cur, IPV6_GROUP_MAX_DIGITS) - pos;
+}
+
+// The mask length of an IPv4 address: one digit, or two digits from 10 to 32
+static bool IsIpv4MaskLengthText(const char *str, size_t len)
+{
+    if (len == 0 || len > IPV4_MASK_MAX_DIGITS || !std::all_of(str, str + len, IsDecDigit)) {
+        return false;
+    }
+    return len == 1 || IsDecNumber(str, len, NET_MASK_MAX_LENGTH);
+}
+
+// The prefix length of an IPv6 address: 1 to 99, or three digits matching 1[0-2][0-8]
+static bool IsIpv6PrefixLengthText(const char *str, size_t len)
+{
+    if (len == 0 || len > IPV6_PREFIX_MAX_DIGITS || !std::all_of(str, str + len, IsDecDigit) || str[0] == '0') {
+        return false;
+    }
+    return len < IPV6_PREFIX_MAX_DIGITS || (str[0] == '1' && str[1] <= '2' && str[2] <= '8');
+}
+
+static bool IsIpLiteral(const std::string &str, bool isIpv6)
+{
+    size_t prefixPos = str.find(PREFIX_DELIMITER_CHAR);
+    size_t addrLen = prefixPos == std::string::npos ? str.size() : prefixPos;
+    size_t matchLen = isIpv6 ? MatchIpv6At(str, 0) : MatchIpv4At(str, 0);
+    if (matchLen == 0 || matchLen != addrLen) {
+        return false;
+    }
+    if (prefixPos == std::string::npos) {
+        return true;
+    }
+    const char *prefix = str.data() + prefixPos + 1;
+    size_t prefixLen = str.size() - prefixPos - 1;
+    return isIpv6 ? IsIpv6PrefixLengthText(prefix, prefixLen) : IsIpv4MaskLengthText(prefix, prefixLen);
+}
+
+static std::string ReplaceIpLiterals(const std::string &input, bool isIpv6)
+{
+    if (input.find(isIpv6 ? IPV6_DELIMITER_CHAR : IPV4_DELIMITER_CHAR) == std::string::npos) {
+        return input;
+    }
+    std::string result;
+    result.reserve(input.size());
+    size_t pos = 0;
+    while (pos < input.size()) {
+        size_t len = isIpv6 ? MatchIpv6At(input, pos) : MatchIpv4At(input, pos);
+        if (len == 0) {
+            result.push_back(input[pos++]);
+            continue;
+        }
+        result.append(isIpv6 ? IPV6_ANONYMOUS_TEXT : IPV4_ANONYMOUS_TEXT);
+        pos += len;
+    }
+    return result;
+}
+
 std::string ToAnonymousIp(const std::string &input, bool maskMiddle)
 {
-    std::lock_guard<std::mutex> lock(g_commonUtilsMutex);
     std::string maskedResult{input};
     // Mask ipv4 address.
-    if (std::regex_match(maskedResult, IP_PATTERN) || std::regex_match(maskedResult, IP_MASK_PATTERN)) {
+    if (IsIpLiteral(maskedResult, false)) {
         return MaskIpv4(maskedResult, maskMiddle);
     }
     // Mask ipv6 address.
-    if (std::regex_match(maskedResult, IPV6_PATTERN) || std::regex_match(maskedResult, IPV6_MASK_PATTERN)) {
+    if (IsIpLiteral(maskedResult, true)) {
         return MaskIpv6(maskedResult, maskMiddle);
     }
     return input;
@@ -467,12 +604,8 @@ std::string ToAnonymousIp(const std::string &input, bool maskMiddle)
 
 std::string AnonymousIpInStr(const std::string &input)
 {
-    std::string result;
-    // Mask ipv4 address.
-    result = std::regex_replace(input, IP_PATTERN, "X.X.X.X");
-    // Mask ipv6 address.
-    result = std::regex_replace(result, IPV6_PATTERN, "X:X:X:X");
-    return result;
+    // Mask ipv4 address, then ipv6 address in the result.
+    return ReplaceIpLiterals(ReplaceIpLiterals(input, false), true);
 }
 
 std::string AnonymizeIptablesCommand(const std::string &command)
@@ -758,19 +891,59 @@ int32_t ForkExec(const std::string &command, std::string *out)
     }
 }
 
+static inline bool IsDomainLabelChar(char ch)
+{
+    return IsDecDigit(ch) || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '-';
+}
+
+/*
+ * An optional http or https scheme followed by at least two non-empty labels of letters, digits and '-', the last
+ * label being one of HOST_DOMAIN_TLDS.
+ */
+static bool IsHostDomainText(const std::string &domain)
+{
+    size_t pos = 0;
+    for (const char *scheme : HOST_DOMAIN_SCHEMES) {
+        size_t len = strlen(scheme);
+        if (domain.compare(0, len, scheme) == 0) {
+            pos = len;
+            break;
+        }
+    }
+    size_t lastDot = domain.rfind(IPV4_DELIMITER_CHAR);
+    if (lastDot == std::string::npos || lastDot < pos) {
+        return false;
+    }
+    size_t labelLen = 0;
+    for (size_t i = pos; i < lastDot; ++i) {
+        if (domain[i] == IPV4_DELIMITER_CHAR) {
+            if (labelLen == 0) {
+                return false;
+            }
+            labelLen = 0;
+        } else if (IsDomainLabelChar(domain[i])) {
+            ++labelLen;
+        } else {
+            return false;
+        }
+    }
+    if (labelLen == 0) {
+        return false;
+    }
+    const char *tld = domain.data() + lastDot + 1;
+    size_t tldLen = domain.size() - lastDot - 1;
+    return std::any_of(HOST_DOMAIN_TLDS.begin(), HOST_DOMAIN_TLDS.end(),
+        [tld, tldLen](const std::string &item) { return item.compare(0, std::string::npos, tld, tldLen) == 0; });
+}
+
 bool IsValidDomain(const std::string &domain)
 {
     if (domain.empty()) {
         return false;
     }
 
-    std::string pattern = HOST_DOMAIN_PATTERN_HEADER;
-    pattern = std::accumulate(HOST_DOMAIN_TLDS.begin(), HOST_DOMAIN_TLDS.end(), pattern,
-        [](const std::string &pattern, const std::string &tlds) { return pattern + tlds + TLDS_SPLIT_SYMBOL; });
-    pattern = pattern.replace(pattern.size() - 1, 1, "") + HOST_DOMAIN_PATTERN_TAIL;
-    std::regex reg(pattern);
-    if (!std::regex_match(domain, reg)) {
-        NETMGR_LOG_E("Domain regex match failed.");
+    if (!IsHostDomainText(domain)) {
+        NETMGR_LOG_E("Domain format match failed.");
         return false;
     }
 
@@ -836,12 +1009,18 @@ std::string Trim(const std::string &str)
     return str.substr(start, end - start + 1);
 }
 
+static bool IsUrlPatternChar(char ch)
+{
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '-' ||
+        ch == '_' || ch == '.' || ch == '*';
+}
+
 bool IsUrlRegexValid(const std::string &regex)
 {
     if (Trim(regex).empty()) {
         return false;
     }
-    return regex_match(regex, std::regex("^[a-zA-Z0-9\\-_\\.*]+$"));
+    return std::all_of(regex.begin(), regex.end(), IsUrlPatternChar);
 }
 
 std::string InsertCharBefore(const std::string &input, const char from, const char preChar, const char nextChar)
@@ -863,6 +1042,39 @@ std::string ReplaceCharacters(const std::string &input)
     return output;
 }
 
+/*
+ * Same result as matching the regex built by ReplaceCharacters: '*' matches any run of characters and everything
+ * else matches itself. The text between the first and the last '*' is matched piecewise at the leftmost position.
+ */
+static bool MatchUrlWildcard(const std::string &str, const std::string &pattern)
+{
+    size_t first = pattern.find('*');
+    if (first == std::string::npos) {
+        return str == pattern;
+    }
+    size_t last = pattern.rfind('*');
+    size_t tailLen = pattern.size() - last - 1;
+    if (first + tailLen > str.size() || str.compare(0, first, pattern, 0, first) != 0 ||
+        str.compare(str.size() - tailLen, tailLen, pattern, last + 1, tailLen) != 0) {
+        return false;
+    }
+    size_t pos = first;
+    size_t limit = str.size() - tailLen;
+    for (size_t begin = first + 1; begin <= last;) {
+        size_t end = pattern.find('*', begin);
+        size_t len = end - begin;
+        if (len > 0) {
+            size_t found = str.find(pattern.c_str() + begin, pos, len);
+            if (found == std::string::npos || found + len > limit) {
+                return false;
+            }
+            pos = found + len;
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
 bool UrlRegexParse(const std::string &str, const std::string &patternStr)
 {
     if (patternStr.empty()) {
@@ -874,8 +1086,7 @@ bool UrlRegexParse(const std::string &str, const std::string &patternStr)
     if (!IsUrlRegexValid(patternStr)) {
         return patternStr == str;
     }
-    std::regex pattern(ReplaceCharacters(patternStr));
-    return !patternStr.empty() && std::regex_match(str, pattern);
+    return MatchUrlWildcard(str, patternStr);
 }
 
 uint64_t GenRandomNumber()